@@ -0,0 +1,356 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "agent/clone_downloader.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <set>
+#include <thread>
+
+#include "common/config.h"
+#include "olap/utils.h"
+#include "util/file_utils.h"
+#include "util/rate_limiter.h"
+
+using std::string;
+using std::vector;
+
+namespace palo {
+
+const uint32_t CLONE_DOWNLOAD_MAX_RETRY = 3;
+const string HEADER_SUFFIX = ".hdr";
+const string CHUNKS_SUFFIX = ".chunks";
+
+static bool ends_with(const string& str, const string& suffix) {
+    return str.size() > suffix.size()
+        && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// limits all clones
+static RateLimiter* global_rate_limiter() {
+    static RateLimiter rate_limiter(config::clone_max_download_speed_kbps * 1024L);
+    return &rate_limiter;
+}
+
+// limits the clones into 'disk'
+static RateLimiter* disk_rate_limiter(const string& disk) {
+    static std::mutex lock;
+    static std::map<string, std::unique_ptr<RateLimiter>> rate_limiters;
+    std::lock_guard<std::mutex> l(lock);
+    std::unique_ptr<RateLimiter>& rate_limiter = rate_limiters[disk];
+    if (rate_limiter == nullptr) {
+        rate_limiter.reset(new RateLimiter(config::clone_disk_max_download_speed_kbps * 1024L));
+    }
+    return rate_limiter.get();
+}
+
+CloneDownloader::CloneDownloader(
+        const string& remote_dir_url, const string& local_dir, const string& disk) :
+#ifdef BE_TEST
+        _file_downloader_ptr(NULL),
+#endif
+        _remote_dir_url(remote_dir_url),
+        _local_dir(local_dir),
+        _next_chunk(0),
+        _failed(false),
+        _downloaded_bytes(0),
+        _reused_bytes(0) {
+    for (RateLimiter* rate_limiter : { global_rate_limiter(), disk_rate_limiter(disk) }) {
+        if (rate_limiter->rate() > 0) {
+            _rate_limiters.push_back(rate_limiter);
+        }
+    }
+
+    // all downloads of all clone workers may share a limiter
+    int64_t num_downloads = std::max(config::clone_worker_count, 1)
+            * std::max(config::clone_download_thread_num, 1);
+    int64_t low_speed_limit_kbps = config::download_low_speed_limit_kbps;
+    for (RateLimiter* rate_limiter : _rate_limiters) {
+        low_speed_limit_kbps = std::min(low_speed_limit_kbps,
+                                        rate_limiter->rate() / 1024 / num_downloads);
+    }
+    _low_speed_limit_kbps = std::max(low_speed_limit_kbps, 1L);
+}
+
+CloneDownloader::~CloneDownloader() {
+}
+
+AgentStatus CloneDownloader::download(const vector<string>& file_names) {
+    // files of another snapshot, left by a failed clone
+    std::set<string> names(file_names.begin(), file_names.end());
+    vector<string> local_files;
+    if (FileUtils::scan_dir(_local_dir, &local_files).ok()) {
+        for (const string& local_file : local_files) {
+            string name = local_file;
+            if (ends_with(name, CHUNKS_SUFFIX)) {
+                name.resize(name.size() - CHUNKS_SUFFIX.size());
+            }
+            if (names.count(name) == 0) {
+                remove(_local_path(local_file).c_str());
+            }
+        }
+    }
+
+    vector<string> data_files;
+    vector<string> header_files;
+    for (const string& file_name : file_names) {
+        if (ends_with(file_name, HEADER_SUFFIX)) {
+            header_files.push_back(file_name);
+        } else {
+            data_files.push_back(file_name);
+        }
+    }
+
+    AgentStatus status = _download_files(data_files);
+    if (status == PALO_SUCCESS) {
+        status = _download_files(header_files);
+    }
+    return status;
+}
+
+AgentStatus CloneDownloader::_download_files(const vector<string>& file_names) {
+    _files.clear();
+    _chunks.clear();
+    for (const string& file_name : file_names) {
+        std::unique_ptr<RemoteFile> file(new RemoteFile());
+        file->name = file_name;
+        AgentStatus status = _get_length(file.get());
+        if (status != PALO_SUCCESS) {
+            return status;
+        }
+        _files.push_back(std::move(file));
+    }
+    for (auto& file : _files) {
+        _plan_chunks(file.get());
+    }
+
+    _next_chunk = 0;
+    _failed = false;
+    size_t num_threads = std::min(
+            static_cast<size_t>(std::max(config::clone_download_thread_num, 1)),
+            _chunks.size());
+    vector<std::thread> threads;
+    for (size_t i = 1; i < num_threads; ++i) {
+        threads.emplace_back(&CloneDownloader::_run_chunks, this);
+    }
+    _run_chunks();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    return _failed ? PALO_ERROR : PALO_SUCCESS;
+}
+
+AgentStatus CloneDownloader::_get_length(RemoteFile* file) {
+    FileDownloader::FileDownloaderParam param;
+    _fill_param(file->name, 0, &param);
+    param.curl_opt_timeout = GET_LENGTH_TIMEOUT;
+
+    AgentStatus status = PALO_SUCCESS;
+    for (uint32_t retry = 0; retry < CLONE_DOWNLOAD_MAX_RETRY; ++retry) {
+#ifndef BE_TEST
+        if (retry > 0) {
+            sleep(retry);
+        }
+        FileDownloader file_downloader(param);
+        status = file_downloader.get_length(&file->size);
+        file->accept_ranges = file_downloader.accept_ranges();
+#else
+        status = _file_downloader_ptr->get_length(&file->size);
+        file->accept_ranges = _file_downloader_ptr->accept_ranges();
+#endif
+        if (status == PALO_SUCCESS) {
+            return status;
+        }
+        OLAP_LOG_WARNING("clone copy get file length failed. src_file_path: %s",
+                         param.remote_file_path.c_str());
+    }
+    OLAP_LOG_WARNING("clone copy get file length failed over max time. src_file_path: %s",
+                     param.remote_file_path.c_str());
+    return status;
+}
+
+void CloneDownloader::_plan_chunks(RemoteFile* file) {
+    uint64_t chunk_size = std::max(config::clone_download_chunk_mbytes, 1) * 1024L * 1024L;
+    file->chunked = file->accept_ranges && file->size > chunk_size;
+    uint32_t num_chunks = file->chunked ? (file->size + chunk_size - 1) / chunk_size : 1;
+    const string local_path = _local_path(file->name);
+    const string chunks_path = _chunks_path(file->name);
+
+    // chunks the local file may hold: all of a file of the remote size without a list
+    // of chunks done, which a failed clone may have completed, or the listed ones
+    std::set<uint32_t> local_chunks;
+    struct stat st;
+    if (stat(local_path.c_str(), &st) == 0) {
+        std::ifstream chunks_file(chunks_path);
+        if (!chunks_file.is_open()) {
+            if (static_cast<uint64_t>(st.st_size) == file->size) {
+                for (uint32_t i = 0; i < num_chunks; ++i) {
+                    local_chunks.insert(i);
+                }
+            }
+        } else if (file->chunked) {
+            // the list starts with the chunk size it was made with
+            uint64_t listed_chunk_size = 0;
+            uint32_t index = 0;
+            if (chunks_file >> listed_chunk_size && listed_chunk_size == chunk_size) {
+                while (chunks_file >> index) {
+                    if (index < num_chunks) {
+                        local_chunks.insert(index);
+                    }
+                }
+            }
+        }
+    }
+
+    // the local chunks are listed again once verified
+    if (file->chunked) {
+        std::ofstream chunks_file(chunks_path, std::ios::trunc);
+        chunks_file << chunk_size << "\n";
+    } else {
+        remove(chunks_path.c_str());
+    }
+
+    file->chunks_left = num_chunks;
+    for (uint32_t i = 0; i < num_chunks; ++i) {
+        Chunk chunk;
+        chunk.file = file;
+        chunk.index = i;
+        chunk.offset = i * chunk_size;
+        chunk.length = file->chunked ? std::min(chunk_size, file->size - chunk.offset)
+                : file->size;
+        chunk.verify = local_chunks.count(i) > 0;
+        _chunks.push_back(chunk);
+    }
+}
+
+bool CloneDownloader::_verify(const RemoteFile& file, uint64_t offset, uint64_t length) {
+    string local_md5sum;
+    if (!FileUtils::md5sum(_local_path(file.name), offset, length, &local_md5sum).ok()) {
+        return false;
+    }
+
+    FileDownloader::FileDownloaderParam param;
+    _fill_param(file.name, length, &param);
+    string remote_md5sum;
+#ifndef BE_TEST
+    FileDownloader file_downloader(param);
+    AgentStatus status = file_downloader.get_md5sum(offset, length, &remote_md5sum);
+#else
+    AgentStatus status = _file_downloader_ptr->get_md5sum(offset, length, &remote_md5sum);
+#endif
+    return status == PALO_SUCCESS && local_md5sum == remote_md5sum;
+}
+
+void CloneDownloader::_run_chunks() {
+    while (!_failed) {
+        size_t i = _next_chunk++;
+        if (i >= _chunks.size()) {
+            break;
+        }
+        const Chunk& chunk = _chunks[i];
+        if (_download_chunk(chunk) != PALO_SUCCESS) {
+            _failed = true;
+            break;
+        }
+        _finish_chunk(chunk);
+    }
+}
+
+AgentStatus CloneDownloader::_download_chunk(const Chunk& chunk) {
+    const RemoteFile& file = *chunk.file;
+    if (chunk.verify && _verify(file, chunk.offset, chunk.length)) {
+        _reused_bytes += chunk.length;
+        return PALO_SUCCESS;
+    }
+
+    FileDownloader::FileDownloaderParam param;
+    _fill_param(file.name, chunk.length, &param);
+    AgentStatus status = PALO_SUCCESS;
+    for (uint32_t retry = 0; retry < CLONE_DOWNLOAD_MAX_RETRY && !_failed; ++retry) {
+#ifndef BE_TEST
+        if (retry > 0) {
+            sleep(retry);
+        }
+        FileDownloader file_downloader(param);
+        FileDownloader* file_downloader_ptr = &file_downloader;
+#else
+        FileDownloader* file_downloader_ptr = _file_downloader_ptr;
+#endif
+        if (file.chunked) {
+            status = file_downloader_ptr->download_range(chunk.offset, chunk.length);
+        } else {
+            status = file_downloader_ptr->download_file();
+            // Check file length
+            struct stat st;
+            if (status == PALO_SUCCESS && (stat(param.local_file_path.c_str(), &st) != 0
+                    || static_cast<uint64_t>(st.st_size) != file.size)) {
+                OLAP_LOG_WARNING("download file length error. src_file_path: %s, "
+                                 "remote file size: %lu",
+                                 param.remote_file_path.c_str(), file.size);
+                status = PALO_FILE_DOWNLOAD_FAILED;
+            }
+        }
+        if (status == PALO_SUCCESS) {
+            _downloaded_bytes += chunk.length;
+            return status;
+        }
+        OLAP_LOG_WARNING("download file failed. src_file_path: %s, offset: %lu, length: %lu",
+                         param.remote_file_path.c_str(), chunk.offset, chunk.length);
+    }
+    OLAP_LOG_WARNING("download file failed over max retry. src_file_path: %s",
+                     param.remote_file_path.c_str());
+    return PALO_ERROR;
+}
+
+void CloneDownloader::_finish_chunk(const Chunk& chunk) {
+    RemoteFile* file = chunk.file;
+    if (file->chunked) {
+        std::lock_guard<std::mutex> l(file->chunks_lock);
+        std::ofstream chunks_file(_chunks_path(file->name), std::ios::app);
+        chunks_file << chunk.index << "\n";
+    }
+    if (--file->chunks_left == 0) {
+        _complete_file(*file);
+    }
+}
+
+void CloneDownloader::_complete_file(const RemoteFile& file) {
+    const string local_path = _local_path(file.name);
+    if (file.chunked) {
+        // a stale local file may have been longer
+        truncate(local_path.c_str(), file.size);
+        remove(_chunks_path(file.name).c_str());
+    }
+    chmod(local_path.c_str(), S_IRUSR | S_IWUSR);
+}
+
+void CloneDownloader::_fill_param(const string& file_name, uint64_t length,
+                                  FileDownloader::FileDownloaderParam* param) {
+    param->remote_file_path = _remote_dir_url + file_name;
+    param->local_file_path = _local_path(file_name);
+    param->low_speed_limit_kbps = _low_speed_limit_kbps;
+    param->rate_limiters = _rate_limiters;
+    param->curl_opt_timeout = std::max(length / _low_speed_limit_kbps / 1024,
+                                       static_cast<uint64_t>(config::download_low_speed_time));
+}
+
+}  // namespace palo
@@ -0,0 +1,152 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#ifndef BDG_PALO_BE_SRC_AGENT_CLONE_DOWNLOADER_H
+#define BDG_PALO_BE_SRC_AGENT_CLONE_DOWNLOADER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "agent/file_downloader.h"
+#include "agent/status.h"
+
+namespace palo {
+
+class RateLimiter;
+
+// Downloads the files of a tablet snapshot from a remote backend into a local dir.
+//
+// Files are split into chunks of config::clone_download_chunk_mbytes, which
+// config::clone_download_thread_num threads download concurrently as byte ranges,
+// so one large file does not bound the speed of a clone. A server without range
+// support gets whole files. The downloaded bytes pass the limiter of all clones,
+// config::clone_max_download_speed_kbps, and the one of the local disk,
+// config::clone_disk_max_download_speed_kbps.
+//
+// Downloads resume from what a failed clone left in the local dir. The chunks done of
+// a file are listed in '<file>.chunks' until the file is complete, and a complete file
+// has no such list. Before being reused, a complete file or a chunk done is compared
+// with the remote one by md5sum, and everything else is downloaded again. As the files
+// of a tablet are named by the versions they hold, only the versions missing locally
+// are transferred.
+//
+// The headers(.hdr) are downloaded after all other files, so a dir with a header has
+// all the files of the tablet.
+class CloneDownloader {
+public:
+    // 'remote_dir_url' is the url of the remote dir, to which a file name is appended
+    // to get the url of the file. 'disk' is the root path of 'local_dir'.
+    CloneDownloader(const std::string& remote_dir_url, const std::string& local_dir,
+                    const std::string& disk);
+
+    ~CloneDownloader();
+
+    // Downloads the remote files 'file_names' into the local dir, and removes the
+    // files of the local dir not among them.
+    AgentStatus download(const std::vector<std::string>& file_names);
+
+    // bytes downloaded by download()
+    int64_t downloaded_bytes() const { return _downloaded_bytes; }
+
+    // bytes download() found in the local dir and reused
+    int64_t reused_bytes() const { return _reused_bytes; }
+
+#ifdef BE_TEST
+    FileDownloader* _file_downloader_ptr;
+#endif
+
+private:
+    struct RemoteFile {
+        RemoteFile() : size(0), accept_ranges(false), chunked(false), chunks_left(0) {}
+
+        std::string name;
+        uint64_t size;
+        bool accept_ranges;
+        // downloaded as ranges, or else as a whole
+        bool chunked;
+        // chunks to download before the file is complete
+        std::atomic<uint32_t> chunks_left;
+        // guards the list of chunks done
+        std::mutex chunks_lock;
+    };
+
+    struct Chunk {
+        RemoteFile* file;
+        uint32_t index;
+        uint64_t offset;
+        uint64_t length;
+        // the local file may hold the chunk already
+        bool verify;
+    };
+
+    // Downloads the remote files 'file_names' concurrently.
+    AgentStatus _download_files(const std::vector<std::string>& file_names);
+
+    // Gets the size of a remote file and its range support.
+    AgentStatus _get_length(RemoteFile* file);
+
+    // Splits 'file' into chunks, appended to _chunks.
+    void _plan_chunks(RemoteFile* file);
+
+    // Whether the local bytes in [offset, offset + length) of 'file' equal the remote ones.
+    bool _verify(const RemoteFile& file, uint64_t offset, uint64_t length);
+
+    // Takes chunks off _chunks until they run out or a chunk fails.
+    void _run_chunks();
+
+    AgentStatus _download_chunk(const Chunk& chunk);
+
+    // Records that 'chunk' is done, and completes its file after its last chunk.
+    void _finish_chunk(const Chunk& chunk);
+
+    void _complete_file(const RemoteFile& file);
+
+    void _fill_param(const std::string& file_name, uint64_t length,
+                     FileDownloader::FileDownloaderParam* param);
+
+    std::string _local_path(const std::string& file_name) const {
+        return _local_dir + "/" + file_name;
+    }
+
+    std::string _chunks_path(const std::string& file_name) const {
+        return _local_path(file_name) + ".chunks";
+    }
+
+    const std::string _remote_dir_url;
+    const std::string _local_dir;
+    std::vector<RateLimiter*> _rate_limiters;
+    // the limiters slow each download down to their share of their rate
+    uint32_t _low_speed_limit_kbps;
+
+    std::vector<std::unique_ptr<RemoteFile>> _files;
+    std::vector<Chunk> _chunks;
+    // index of the next chunk to download
+    std::atomic<size_t> _next_chunk;
+    std::atomic<bool> _failed;
+
+    std::atomic<int64_t> _downloaded_bytes;
+    std::atomic<int64_t> _reused_bytes;
+
+    DISALLOW_COPY_AND_ASSIGN(CloneDownloader);
+};
+
+}  // namespace palo
+
+#endif  // BDG_PALO_BE_SRC_AGENT_CLONE_DOWNLOADER_H
@@ -19,9 +19,12 @@
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include "boost/algorithm/string/predicate.hpp"
+#include "boost/algorithm/string/trim.hpp"
 #include "olap/olap_define.h"
 #include "olap/file_helper.h"
 #include "olap/utils.h"
+#include "util/rate_limiter.h"
 
 using std::ofstream;
 using std::ostream;
@@ -31,27 +34,44 @@ using std::stringstream;
 namespace palo {
 
 FileDownloader::FileDownloader(const FileDownloaderParam& param) :
-        _downloader_param(param) {
+        _downloader_param(param),
+        _accept_ranges(false) {
 }
 
 size_t FileDownloader::_write_file_callback(
         void* buffer, size_t size, size_t nmemb, void* param) {
-    OLAPStatus status = OLAP_SUCCESS;
     size_t len = size * nmemb;
 
     if (param == NULL) {
-        status = OLAP_ERR_OTHER_ERROR;
-        OLAP_LOG_WARNING("File downloader output file handler is NULL pointer.");
+        OLAP_LOG_WARNING("File downloader output file writer is NULL pointer.");
         return -1;
     }
 
-    if (status == OLAP_SUCCESS) {
-        status = static_cast<FileHandler*>(param)->write(buffer, len);
-        if (status != OLAP_SUCCESS) {
-            OLAP_LOG_WARNING("File downloader callback write failed.");
-        }
+    FileWriter* writer = static_cast<FileWriter*>(param);
+    if (writer->offset + len > writer->end) {
+        OLAP_LOG_WARNING("File downloader received more bytes than requested.");
+        return 0;
+    }
+    for (RateLimiter* rate_limiter : *writer->rate_limiters) {
+        rate_limiter->acquire(len);
+    }
+    if (writer->file_handler->pwrite(buffer, len, writer->offset) != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("File downloader callback write failed.");
+        return 0;
     }
+    writer->offset += len;
+
+    return len;
+}
 
+size_t FileDownloader::_header_callback(
+        char* buffer, size_t size, size_t nmemb, void* param) {
+    size_t len = size * nmemb;
+    std::string header(buffer, len);
+    boost::algorithm::trim(header);
+    if (boost::algorithm::iequals(header, "Accept-Ranges: bytes")) {
+        static_cast<FileDownloader*>(param)->_accept_ranges = true;
+    }
     return len;
 }
 
@@ -75,7 +95,7 @@ size_t FileDownloader::_write_stream_callback(
 
 AgentStatus FileDownloader::_install_opt(
         OutputType output_type, CURL* curl, char* errbuf,
-        stringstream* output_stream, FileHandler* file_handler) {
+        stringstream* output_stream, FileWriter* file_writer) {
     AgentStatus status = PALO_SUCCESS;
     CURLcode curl_ret = CURLE_OK;
 
@@ -121,9 +141,10 @@ AgentStatus FileDownloader::_install_opt(
 
     // Set low speed limit and low speed time
     if (status == PALO_SUCCESS) {
+        uint32_t low_speed_limit_kbps = _downloader_param.low_speed_limit_kbps > 0
+                ? _downloader_param.low_speed_limit_kbps : config::download_low_speed_limit_kbps;
         curl_ret = curl_easy_setopt(
-                curl, CURLOPT_LOW_SPEED_LIMIT,
-                config::download_low_speed_limit_kbps * 1024);
+                curl, CURLOPT_LOW_SPEED_LIMIT, static_cast<long>(low_speed_limit_kbps) * 1024);
 
         if (curl_ret != CURLE_OK) {
             status = PALO_FILE_DOWNLOAD_INSTALL_OPT_FAILED;
@@ -238,7 +259,7 @@ AgentStatus FileDownloader::_install_opt(
             // Set callback function args
             if (status == PALO_SUCCESS) {
                 curl_ret = curl_easy_setopt(curl, CURLOPT_WRITEDATA,
-                                            static_cast<void*>(file_handler));
+                                            static_cast<void*>(file_writer));
 
                 if (curl_ret != CURLE_OK) {
                     status = PALO_FILE_DOWNLOAD_INSTALL_OPT_FAILED;
@@ -308,6 +329,13 @@ AgentStatus FileDownloader::get_length(uint64_t* length) {
         }
     }
 
+    // Look for the range support in the headers
+    _accept_ranges = false;
+    if (status == PALO_SUCCESS) {
+        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, &FileDownloader::_header_callback);
+        curl_easy_setopt(curl, CURLOPT_HEADERDATA, static_cast<void*>(this));
+    }
+
     // Get result
     if (status == PALO_SUCCESS) {
         curl_ret = curl_easy_perform(curl);
@@ -332,6 +360,24 @@ AgentStatus FileDownloader::get_length(uint64_t* length) {
 }
 
 AgentStatus FileDownloader::download_file() {
+    uint64_t written = 0;
+    return _download(false, 0, UINT64_MAX, O_CREAT | O_TRUNC | O_WRONLY, &written);
+}
+
+AgentStatus FileDownloader::download_range(uint64_t offset, uint64_t length) {
+    uint64_t written = 0;
+    AgentStatus status = _download(true, offset, offset + length, O_CREAT | O_WRONLY, &written);
+    if (status == PALO_SUCCESS && written != length) {
+        OLAP_LOG_WARNING("download range got less bytes than requested."
+                         "[path=%s offset=%lu length=%lu written=%lu]",
+                         _downloader_param.remote_file_path.c_str(), offset, length, written);
+        status = PALO_FILE_DOWNLOAD_FAILED;
+    }
+    return status;
+}
+
+AgentStatus FileDownloader::_download(
+        bool range, uint64_t offset, uint64_t end, int open_flags, uint64_t* written) {
     AgentStatus status = PALO_SUCCESS;
     CURL* curl = NULL;
     CURLcode curl_ret = CURLE_OK;
@@ -347,8 +393,7 @@ AgentStatus FileDownloader::download_file() {
     // Prepare some infomation
     if (status == PALO_SUCCESS) {
         olap_status = file_handler->open_with_mode(
-                _downloader_param.local_file_path,
-                O_CREAT | O_TRUNC | O_WRONLY, S_IRUSR | S_IWUSR);
+                _downloader_param.local_file_path, open_flags, S_IRUSR | S_IWUSR);
 
         if (olap_status != OLAP_SUCCESS) {
             status = PALO_FILE_DOWNLOAD_INVALID_PARAM;
@@ -357,15 +402,35 @@ AgentStatus FileDownloader::download_file() {
         }
     }
 
+    FileWriter file_writer;
+    file_writer.file_handler = file_handler;
+    file_writer.offset = offset;
+    file_writer.end = end;
+    file_writer.rate_limiters = &_downloader_param.rate_limiters;
+
     char errbuf[CURL_ERROR_SIZE];
     if (status == PALO_SUCCESS) {
-        status = _install_opt(OutputType::FILE, curl, errbuf, NULL, file_handler);
+        status = _install_opt(OutputType::FILE, curl, errbuf, NULL, &file_writer);
 
         if (PALO_SUCCESS != status) {
             OLAP_LOG_WARNING("install curl opt failed.");
         }
     }
 
+    std::string range_str;
+    if (status == PALO_SUCCESS && range) {
+        stringstream range_stream;
+        range_stream << offset << "-" << end - 1;
+        range_str = range_stream.str();
+        curl_ret = curl_easy_setopt(curl, CURLOPT_RANGE, range_str.c_str());
+
+        if (curl_ret != CURLE_OK) {
+            status = PALO_FILE_DOWNLOAD_INSTALL_OPT_FAILED;
+            OLAP_LOG_WARNING("curl setopt RANGE failed.[error=%s]",
+                             curl_easy_strerror(curl_ret));
+        }
+    }
+
     if (status == PALO_SUCCESS) {
         curl_ret = curl_easy_perform(curl);
 
@@ -378,6 +443,19 @@ AgentStatus FileDownloader::download_file() {
         }
     }
 
+    // A server ignoring the range would send the whole file
+    if (status == PALO_SUCCESS && range) {
+        long response_code = 0;
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
+        if (response_code != 206) {
+            status = PALO_FILE_DOWNLOAD_FAILED;
+            OLAP_LOG_WARNING("download range is not served.[path=%s range=%s code=%ld]",
+                             _downloader_param.remote_file_path.c_str(),
+                             range_str.c_str(), response_code);
+        }
+    }
+    *written = file_writer.offset - offset;
+
     if (file_handler != NULL) {
         file_handler->close();
         delete file_handler;
@@ -391,6 +469,74 @@ AgentStatus FileDownloader::download_file() {
     return status;
 }
 
+AgentStatus FileDownloader::get_md5sum(uint64_t offset, uint64_t length, string* md5sum) {
+    AgentStatus status = PALO_SUCCESS;
+    CURL* curl = NULL;
+    CURLcode curl_ret = CURLE_OK;
+    curl = curl_easy_init();
+
+    if (curl == NULL) {
+        status = PALO_FILE_DOWNLOAD_CURL_INIT_FAILED;
+        OLAP_LOG_WARNING("internal error to get NULL curl");
+    }
+
+    stringstream output_string_stream;
+    char errbuf[CURL_ERROR_SIZE];
+    if (status == PALO_SUCCESS) {
+        status = _install_opt(OutputType::STREAM, curl, errbuf, &output_string_stream, NULL);
+
+        if (PALO_SUCCESS != status) {
+            OLAP_LOG_WARNING("install curl opt failed.");
+        }
+    }
+
+    stringstream url_stream;
+    url_stream << _downloader_param.remote_file_path
+        << "&checksum=md5&offset=" << offset << "&length=" << length;
+    string url = url_stream.str();
+    if (status == PALO_SUCCESS) {
+        curl_ret = curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+        // A server not computing checksums would send the file
+        if (curl_ret == CURLE_OK) {
+            curl_ret = curl_easy_setopt(curl, CURLOPT_MAXFILESIZE, 1024L);
+        }
+
+        if (curl_ret != CURLE_OK) {
+            status = PALO_FILE_DOWNLOAD_INSTALL_OPT_FAILED;
+            OLAP_LOG_WARNING("curl setopt failed.[error=%s]", curl_easy_strerror(curl_ret));
+        }
+    }
+
+    if (status == PALO_SUCCESS) {
+        curl_ret = curl_easy_perform(curl);
+
+        if (curl_ret != CURLE_OK) {
+            status = PALO_FILE_DOWNLOAD_GET_CHECKSUM_FAILED;
+            OLAP_LOG_WARNING("curl get checksum failed.[path=%s]", url.c_str());
+            _get_err_info(errbuf, curl_ret);
+        }
+    }
+
+    if (status == PALO_SUCCESS) {
+        long response_code = 0;
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
+        *md5sum = output_string_stream.str();
+        bool is_md5sum = response_code == 200 && md5sum->size() == 32
+                && md5sum->find_first_not_of("0123456789abcdef") == string::npos;
+        if (!is_md5sum) {
+            status = PALO_FILE_DOWNLOAD_GET_CHECKSUM_FAILED;
+            OLAP_LOG_WARNING("get checksum got no md5sum.[path=%s code=%ld]",
+                             url.c_str(), response_code);
+        }
+    }
+
+    if (curl != NULL) {
+        curl_easy_cleanup(curl);
+    }
+
+    return status;
+}
+
 AgentStatus FileDownloader::list_file_dir(string* file_list_string) {
     AgentStatus status = PALO_SUCCESS;
     CURL* curl = NULL;
@@ -21,6 +21,7 @@
 #include <cstdint>
 #include <sstream>
 #include <string>
+#include <vector>
 #include "curl/curl.h"
 #include "agent/status.h"
 #include "olap/olap_define.h"
@@ -28,6 +29,8 @@
 
 namespace palo {
 
+class RateLimiter;
+
 const uint32_t GET_LENGTH_TIMEOUT = 10;
 const uint32_t CURL_OPT_CONNECTTIMEOUT = 120;
 // down load file
@@ -40,11 +43,17 @@ public:
     };
 
     struct FileDownloaderParam {
+        FileDownloaderParam() : curl_opt_timeout(0), low_speed_limit_kbps(0) {}
+
         std::string username;
         std::string password;
         std::string remote_file_path;
         std::string local_file_path;
         uint32_t curl_opt_timeout;
+        // 0 means config::download_low_speed_limit_kbps
+        uint32_t low_speed_limit_kbps;
+        // the downloaded bytes pass all of them
+        std::vector<RateLimiter*> rate_limiters;
     };
 
     explicit FileDownloader(const FileDownloaderParam& param);
@@ -53,6 +62,15 @@ public:
     // Download file from remote server
     virtual AgentStatus download_file();
 
+    // Download the 'length' bytes of the remote file starting at 'offset' into the
+    // same range of the local file, which is created if missing but not truncated.
+    // Needs a server serving ranges, see accept_ranges().
+    virtual AgentStatus download_range(uint64_t offset, uint64_t length);
+
+    // Get the md5sum of the 'length' bytes of the remote file starting at 'offset',
+    // as lowercase hex.
+    virtual AgentStatus get_md5sum(uint64_t offset, uint64_t length, std::string* md5sum);
+
     // List remote dir file
     virtual AgentStatus list_file_dir(std::string* file_list_string);
     
@@ -61,19 +79,40 @@ public:
     // Output parameters:
     // * length: The pointer of size of remote file 
     virtual AgentStatus get_length(uint64_t* length);
+
+    // Whether the server announced range support in the last get_length().
+    bool accept_ranges() const { return _accept_ranges; }
 private:
+    // where the downloaded bytes of a file go
+    struct FileWriter {
+        FileHandler* file_handler;
+        // file offset of the next byte
+        uint64_t offset;
+        // no byte may be written at or after it
+        uint64_t end;
+        const std::vector<RateLimiter*>* rate_limiters;
+    };
+
     static size_t _write_file_callback(
             void* buffer, size_t size, size_t nmemb, void* downloader);    
     static size_t _write_stream_callback(
             void* buffer, size_t size, size_t nmemb, void* downloader);    
+    static size_t _header_callback(
+            char* buffer, size_t size, size_t nmemb, void* downloader);
 
     AgentStatus _install_opt(
             OutputType output_type, CURL* curl, char* errbuf,
-            std::stringstream* output_stream, FileHandler* file_handler);
+            std::stringstream* output_stream, FileWriter* file_writer);
+
+    // Downloads the body into [offset, end) of the local file, with a range
+    // request if 'range' is set. Returns the number of bytes written in 'written'.
+    AgentStatus _download(
+            bool range, uint64_t offset, uint64_t end, int open_flags, uint64_t* written);
 
     void _get_err_info(char * errbuf, CURLcode res);
     
     const FileDownloaderParam& _downloader_param;
+    bool _accept_ranges;
     
     DISALLOW_COPY_AND_ASSIGN(FileDownloader);
 };  // class FileDownloader
@@ -29,6 +29,7 @@ enum AgentStatus {
     PALO_FILE_DOWNLOAD_GET_LENGTH_FAILED = -205,
     PALO_FILE_DOWNLOAD_NOT_EXIST = -206,
     PALO_FILE_DOWNLOAD_LIST_DIR_FAIL = -207,
+    PALO_FILE_DOWNLOAD_GET_CHECKSUM_FAILED = -208,
     PALO_CREATE_TABLE_EXIST = -301,
     PALO_CREATE_TABLE_DIFF_SCHEMA_EXIST = -302,
     PALO_CREATE_TABLE_NOT_EXIST = -303,
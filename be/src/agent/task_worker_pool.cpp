@@ -40,6 +40,7 @@
 #include "common/status.h"
 #include "util/file_utils.h"
 #include "agent/cgroups_mgr.h"
+#include "agent/clone_downloader.h"
 #include "service/backend_options.h"
 #include "runtime/exec_env.h"
 #include "runtime/snapshot_loader.h"
@@ -851,9 +852,10 @@ void* TaskWorkerPool::_clone_worker_thread_callback(void* arg_this) {
             status = PALO_CREATE_TABLE_EXIST;
         }
 
-        // Get local disk from olap
+        // Get local disk from olap, unless a failed clone of the tablet left files to resume
         string local_shard_root_path;
-        if (status == PALO_SUCCESS) {
+        if (status == PALO_SUCCESS
+                && !worker_pool_this->_take_clone_partial_dir(clone_req, &local_shard_root_path)) {
             OLAPStatus olap_status = worker_pool_this->_command_executor->obtain_shard_path(
                     clone_req.storage_medium, &local_shard_root_path);
             if (olap_status != OLAP_SUCCESS) {
@@ -903,19 +905,25 @@ void* TaskWorkerPool::_clone_worker_thread_callback(void* arg_this) {
                                    << "/" << clone_req.tablet_id
                                    << "/" << clone_req.schema_hash;
             string local_data_path = local_data_path_stream.str();
-            OLAP_LOG_INFO("clone failed. want to delete local dir: %s, signature: %ld",
-                          local_data_path.c_str(), agent_task_req.signature);
-            try {
-                boost::filesystem::path local_path(local_data_path);
-                if (boost::filesystem::exists(local_path)) {
-                    boost::filesystem::remove_all(local_path);
+            if (config::clone_resume_timeout_seconds > 0 && !local_shard_root_path.empty()) {
+                OLAP_LOG_INFO("clone failed. keep local dir for resuming: %s, signature: %ld",
+                              local_data_path.c_str(), agent_task_req.signature);
+                worker_pool_this->_keep_clone_partial_dir(clone_req, local_shard_root_path);
+            } else {
+                OLAP_LOG_INFO("clone failed. want to delete local dir: %s, signature: %ld",
+                              local_data_path.c_str(), agent_task_req.signature);
+                try {
+                    boost::filesystem::path local_path(local_data_path);
+                    if (boost::filesystem::exists(local_path)) {
+                        boost::filesystem::remove_all(local_path);
+                    }
+                } catch (boost::filesystem::filesystem_error e) {
+                    // Ignore the error, OLAP will delete it
+                    OLAP_LOG_WARNING("clone delete useless dir failed. "
+                                     "error: %s, local dir: %s, signature: %ld",
+                                     e.what(), local_data_path.c_str(),
+                                     agent_task_req.signature);
                 }
-            } catch (boost::filesystem::filesystem_error e) {
-                // Ignore the error, OLAP will delete it
-                OLAP_LOG_WARNING("clone delete useless dir failed. "
-                                 "error: %s, local dir: %s, signature: %ld",
-                                 e.what(), local_data_path.c_str(),
-                                 agent_task_req.signature);
             }
         }
 #endif
@@ -1090,13 +1098,12 @@ AgentStatus TaskWorkerPool::_clone_copy(
         string local_file_full_path = local_file_full_path_stream.str();
 
 #ifndef BE_TEST
-        // Check local path exist, if exist, remove it, then create the dir
+        // Create the dir, the files a failed clone left in it are resumed from
         if (status == PALO_SUCCESS) {
             boost::filesystem::path local_file_full_dir(local_file_full_path);
-            if (boost::filesystem::exists(local_file_full_dir)) {
-                boost::filesystem::remove_all(local_file_full_dir);
+            if (!boost::filesystem::exists(local_file_full_dir)) {
+                boost::filesystem::create_directories(local_file_full_dir);
             }
-            boost::filesystem::create_directories(local_file_full_dir);
         }
 #endif
 
@@ -1186,131 +1193,33 @@ AgentStatus TaskWorkerPool::_clone_copy(
         }
 
         // Get copy from remote
-        for (auto file_name : file_name_list) {
-            download_retry_time = 0;
-            downloader_param.remote_file_path = http_host + HTTP_REQUEST_PREFIX
-                + HTTP_REQUEST_TOKEN_PARAM + token
-                + HTTP_REQUEST_FILE_PARAM + src_file_full_path + file_name;
-            downloader_param.local_file_path = local_file_full_path + file_name;
-
-            // Get file length
-            uint64_t file_size = 0;
-            uint64_t estimate_time_out = 0;
-
-            downloader_param.curl_opt_timeout = GET_LENGTH_TIMEOUT;
-#ifndef BE_TEST
-            file_downloader_ptr = new FileDownloader(downloader_param);
-            if (file_downloader_ptr == NULL) {
-                OLAP_LOG_WARNING("clone copy create file downloader failed. try next backend");
-                status = PALO_ERROR;
-                break;
-            }
-#endif
-            while (download_retry_time < DOWNLOAD_FILE_MAX_RETRY) {
-#ifndef BE_TEST
-                download_status = file_downloader_ptr->get_length(&file_size);
-#else
-                download_status = _file_downloader_ptr->get_length(&file_size);
-#endif
-                if (download_status != PALO_SUCCESS) {
-                    OLAP_LOG_WARNING("clone copy get file length failed. backend_ip: %s, "
-                                     "src_file_path: %s, signature: %ld",
-                                     src_host->host.c_str(),
-                                     downloader_param.remote_file_path.c_str(),
-                                     signature);
-                    ++download_retry_time;
-#ifndef BE_TEST
-                    sleep(download_retry_time);
-#endif
-                } else {
-                    break;
-                }
-            }
-
-#ifndef BE_TEST
-            if (file_downloader_ptr != NULL) {
-                delete file_downloader_ptr;
-                file_downloader_ptr = NULL;
-            }
-#endif
-            if (download_status != PALO_SUCCESS) {
-                OLAP_LOG_WARNING("clone copy get file length failed over max time. "
-                                 "backend_ip: %s, src_file_path: %s, signature: %ld",
-                                 src_host->host.c_str(),
-                                 downloader_param.remote_file_path.c_str(),
-                                 signature);
-                status = PALO_ERROR;
-                break;
-            }
-
-            estimate_time_out = file_size / config::download_low_speed_limit_kbps / 1024;
-            if (estimate_time_out < config::download_low_speed_time) {
-                estimate_time_out = config::download_low_speed_time;
-            }
-
-            // Download the file
-            download_retry_time = 0;
-            downloader_param.curl_opt_timeout = estimate_time_out;
-#ifndef BE_TEST
-            file_downloader_ptr = new FileDownloader(downloader_param);
-            if (file_downloader_ptr == NULL) {
-                OLAP_LOG_WARNING("clone copy create file downloader failed. try next backend");
-                status = PALO_ERROR;
-                break;
-            }
-#endif
-            while (download_retry_time < DOWNLOAD_FILE_MAX_RETRY) {
-#ifndef BE_TEST
-                download_status = file_downloader_ptr->download_file();
-#else
-                download_status = _file_downloader_ptr->download_file();
-#endif
-                if (download_status != PALO_SUCCESS) {
-                    OLAP_LOG_WARNING("download file failed. backend_ip: %s, "
-                                     "src_file_path: %s, signature: %ld",
-                                     src_host->host.c_str(),
-                                     downloader_param.remote_file_path.c_str(),
-                                     signature);
-                } else {
-                    // Check file length
-                    boost::filesystem::path local_file_path(downloader_param.local_file_path);
-                    uint64_t local_file_size = boost::filesystem::file_size(local_file_path);
-                    if (local_file_size != file_size) {
-                        OLAP_LOG_WARNING("download file length error. backend_ip: %s, "
-                                         "src_file_path: %s, signature: %ld,"
-                                         "remote file size: %d, local file size: %d",
-                                         src_host->host.c_str(),
-                                         downloader_param.remote_file_path.c_str(),
-                                         signature, file_size, local_file_size);
-                        download_status = PALO_FILE_DOWNLOAD_FAILED;
-                    } else {
-                        chmod(downloader_param.local_file_path.c_str(), S_IRUSR | S_IWUSR);
-                        break;
-                    }
-                }
-                ++download_retry_time;
-#ifndef BE_TEST
-                sleep(download_retry_time);
-#endif
-            } // Try to download a file from remote backend
-
-#ifndef BE_TEST
-            if (file_downloader_ptr != NULL) {
-                delete file_downloader_ptr;
-                file_downloader_ptr = NULL;
-            }
+        if (status == PALO_SUCCESS) {
+            // the shard path is 'root_path/data/shard'
+            string disk = boost::filesystem::path(local_data_path).parent_path()
+                    .parent_path().string();
+            CloneDownloader clone_downloader(
+                    http_host + HTTP_REQUEST_PREFIX + HTTP_REQUEST_TOKEN_PARAM + token
+                        + HTTP_REQUEST_FILE_PARAM + src_file_full_path,
+                    local_file_full_path, disk);
+#ifdef BE_TEST
+            clone_downloader._file_downloader_ptr = _file_downloader_ptr;
 #endif
-
+            download_status = clone_downloader.download(file_name_list);
             if (download_status != PALO_SUCCESS) {
-                OLAP_LOG_WARNING("download file failed over max retry. backend_ip: %s, "
+                OLAP_LOG_WARNING("clone copy download files failed. backend_ip: %s, "
                                  "src_file_path: %s, signature: %ld",
-                                 src_host->host.c_str(),
-                                 downloader_param.remote_file_path.c_str(),
+                                 src_host->host.c_str(), src_file_full_path.c_str(),
                                  signature);
                 status = PALO_ERROR;
-                break;
+            } else {
+                OLAP_LOG_INFO("clone copy download files success. backend_ip: %s, "
+                              "src_file_path: %s, downloaded_bytes: %ld, reused_bytes: %ld, "
+                              "signature: %ld",
+                              src_host->host.c_str(), src_file_full_path.c_str(),
+                              clone_downloader.downloaded_bytes(),
+                              clone_downloader.reused_bytes(), signature);
             }
-        } // Clone files from remote backend
+        }
 
         // Release snapshot, if failed, ignore it. OLAP engine will drop useless snapshot
         TAgentResult release_snapshot_result;
@@ -1335,6 +1244,81 @@ AgentStatus TaskWorkerPool::_clone_copy(
     return status;
 }
 
+// Whether 'dir' is the dir of a loaded tablet, or holds a header not imported yet.
+static bool is_tablet_dir(CommandExecutor* command_executor,
+                          TTabletId tablet_id, TSchemaHash schema_hash, const string& dir) {
+    SmartOLAPTable tablet = command_executor->get_table(tablet_id, schema_hash);
+    if (tablet.get() != NULL
+            && boost::filesystem::path(tablet->header_file_name()).parent_path()
+                == boost::filesystem::path(dir)) {
+        return true;
+    }
+
+    vector<string> files;
+    if (!FileUtils::scan_dir(dir, &files).ok()) {
+        return false;
+    }
+    for (const string& file : files) {
+        if (file.size() > 4 && file.substr(file.size() - 4, 4) == ".hdr") {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TaskWorkerPool::_take_clone_partial_dir(const TCloneReq& clone_req, string* shard_path) {
+    time_t now = time(NULL);
+    AutoMutexLock auto_lock(&_clone_partial_dirs_lock);
+    bool taken = false;
+    for (auto it = _clone_partial_dirs.begin(); it != _clone_partial_dirs.end();) {
+        bool same_tablet = it->first.first == clone_req.tablet_id
+                && it->first.second == clone_req.schema_hash;
+        if (!same_tablet && it->second.expire_time > now) {
+            ++it;
+            continue;
+        }
+        stringstream dir_stream;
+        dir_stream << it->second.shard_path
+                   << "/" << it->first.first << "/" << it->first.second;
+        string dir = dir_stream.str();
+        if (same_tablet && it->second.storage_medium == clone_req.storage_medium
+                && boost::filesystem::exists(dir)) {
+            *shard_path = it->second.shard_path;
+            taken = true;
+        } else if (!is_tablet_dir(_command_executor, it->first.first, it->first.second, dir)) {
+            // the dir may belong to a tablet created since
+            OLAP_LOG_INFO("remove files of failed clone: %s", dir.c_str());
+            FileUtils::remove_all(dir);
+        }
+        it = _clone_partial_dirs.erase(it);
+    }
+    return taken;
+}
+
+void TaskWorkerPool::_keep_clone_partial_dir(const TCloneReq& clone_req,
+                                             const string& shard_path) {
+    stringstream dir_stream;
+    dir_stream << shard_path << "/" << clone_req.tablet_id << "/" << clone_req.schema_hash;
+    string dir = dir_stream.str();
+
+    // without headers the engine never loads the dir as a tablet
+    vector<string> files;
+    if (FileUtils::scan_dir(dir, &files).ok()) {
+        for (const string& file : files) {
+            if (file.size() > 4 && file.substr(file.size() - 4, 4) == ".hdr") {
+                remove((dir + "/" + file).c_str());
+            }
+        }
+    }
+
+    ClonePartialDir partial_dir;
+    partial_dir.shard_path = shard_path;
+    partial_dir.storage_medium = clone_req.storage_medium;
+    partial_dir.expire_time = time(NULL) + config::clone_resume_timeout_seconds;
+    AutoMutexLock auto_lock(&_clone_partial_dirs_lock);
+    _clone_partial_dirs[std::make_pair(clone_req.tablet_id, clone_req.schema_hash)] = partial_dir;
+}
+
 void* TaskWorkerPool::_storage_medium_migrate_worker_thread_callback(void* arg_this) {
     TaskWorkerPool* worker_pool_this = (TaskWorkerPool*)arg_this;
 
@@ -21,6 +21,7 @@
 #include <boost/thread/condition_variable.hpp>
 #include <boost/thread/mutex.hpp>
 #include <deque>
+#include <map>
 #include <utility>
 #include <vector>
 #include "agent/pusher.h"
@@ -112,6 +113,14 @@ private:
             std::string* src_file_path,
             std::vector<std::string>* error_msgs);
 
+    // Takes the shard path in which a failed clone of the tablet left its files, if any,
+    // and removes the files of the failed clones kept for too long.
+    bool _take_clone_partial_dir(const TCloneReq& clone_req, std::string* shard_path);
+
+    // Keeps the files a failed clone left in 'shard_path', for a retry of the clone to
+    // resume from, until config::clone_resume_timeout_seconds passed.
+    void _keep_clone_partial_dir(const TCloneReq& clone_req, const std::string& shard_path);
+
     void _alter_table(
             const TAlterTabletReq& create_rollup_request,
             int64_t signature,
@@ -150,6 +159,16 @@ private:
     Pusher * _pusher;
 #endif
 
+    // the files kept of failed clones
+    struct ClonePartialDir {
+        std::string shard_path;
+        TStorageMedium::type storage_medium;
+        // when the files are removed, in seconds since the epoch
+        time_t expire_time;
+    };
+    MutexLock _clone_partial_dirs_lock;
+    std::map<std::pair<TTabletId, TSchemaHash>, ClonePartialDir> _clone_partial_dirs;
+
     std::deque<TAgentTaskRequest> _tasks;
     MutexLock _worker_thread_lock;
     Condition _worker_thread_condition_lock;
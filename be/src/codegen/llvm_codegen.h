@@ -23,6 +23,7 @@
 
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 #include <boost/scoped_ptr.hpp>
 #include <boost/thread/mutex.hpp>
@@ -69,7 +70,9 @@ class IRBuilderDefaultInserter;
 
 namespace palo {
 
+class SlotDescriptor;
 class SubExprElimination;
+class TupleDescriptor;
 
 // LLVM code generator.  This is the top level object to generate jitted code.
 //
@@ -269,6 +272,30 @@ public:
         return it->second;
     }
 
+    // Code generated for tuple and slot descriptors is cached in the module rather than
+    // in the descriptors: the descriptor table is shared by all fragment instances of a
+    // query on a backend, while each instance has its own module.
+    llvm::StructType* get_tuple_struct(const TupleDescriptor* desc) {
+        std::map<const TupleDescriptor*, llvm::StructType*>::iterator it =
+            _tuple_structs.find(desc);
+        return it == _tuple_structs.end() ? NULL : it->second;
+    }
+
+    void set_tuple_struct(const TupleDescriptor* desc, llvm::StructType* tuple_struct) {
+        _tuple_structs[desc] = tuple_struct;
+    }
+
+    // Returns the function 'name' cached for 'desc' by set_slot_fn() or NULL.
+    llvm::Function* get_slot_fn(const SlotDescriptor* desc, const std::string& name) {
+        std::map<std::pair<const SlotDescriptor*, std::string>, llvm::Function*>::iterator it =
+            _slot_fns.find(std::make_pair(desc, name));
+        return it == _slot_fns.end() ? NULL : it->second;
+    }
+
+    void set_slot_fn(const SlotDescriptor* desc, const std::string& name, llvm::Function* fn) {
+        _slot_fns[std::make_pair(desc, name)] = fn;
+    }
+
     /// Optimize and compile the module. This should be called after all functions to JIT
     /// have been added to the module via AddFunctionToJit(). If optimizations_enabled_ is
     /// false, the module will not be optimized before compilation.
@@ -603,6 +630,12 @@ private:
     // A set of all the functions in '_registered_exprs_map' for quick lookup.
     std::set<llvm::Function*> _registered_exprs;
 
+    // Struct types generated for tuple descriptors
+    std::map<const TupleDescriptor*, llvm::StructType*> _tuple_structs;
+
+    // Null indicator functions generated for slot descriptors, by descriptor and name
+    std::map<std::pair<const SlotDescriptor*, std::string>, llvm::Function*> _slot_fns;
+
     // A cache of loaded llvm intrinsics
     std::map<llvm::Intrinsic::ID, llvm::Function*> _llvm_intrinsics;
 
@@ -103,6 +103,19 @@ namespace config {
     CONF_Int32(download_low_speed_limit_kbps, "50");
     // download low speed time(seconds)
     CONF_Int32(download_low_speed_time, "300");
+    // the count of concurrent downloads of one clone task
+    CONF_Int32(clone_download_thread_num, "4");
+    // files larger than this are cloned as concurrent ranges of this size(MB)
+    CONF_Int32(clone_download_chunk_mbytes, "64");
+    // threads computing the checksums requested from each download handler, off the
+    // http threads
+    CONF_Int32(download_checksum_thread_num, "2");
+    // the max download speed of all clones of a backend(KB/s), 0 means no limit
+    CONF_Int32(clone_max_download_speed_kbps, "0");
+    // the max download speed of the clones into one disk(KB/s), 0 means no limit
+    CONF_Int32(clone_disk_max_download_speed_kbps, "0");
+    // seconds a failed clone keeps its downloaded files for a retry to resume from
+    CONF_Int32(clone_resume_timeout_seconds, "3600");
     // curl verbose mode
     CONF_Int64(curl_verbose_mode, "1");
     // seconds to sleep for each time check table status
@@ -153,16 +166,32 @@ namespace config {
     CONF_Int32(num_threads_per_core, "3");
     // if true, compresses tuple data in Serialize
     CONF_Bool(compress_rowbatches, "true");
+    // max number of distinct string values per row batch that are written only
+    // once in Serialize, later occurrences refer to the first copy. 0 disables it.
+    CONF_Int32(rowbatch_string_dict_max_entries, "256");
     // serialize and deserialize each returned row batch
     CONF_Bool(serialize_batch, "false");
     // interval between profile reports; in seconds
     CONF_Int32(status_report_interval, "5");
+    // number of threads sending the periodic status reports of fragment instances
+    CONF_Int32(status_report_thread_num, "4");
+    // a status report rpc slower than this delays the next reports to its coordinator
+    CONF_Int32(status_report_slow_rpc_ms, "1000");
+    // max delay added to the status report interval of a slow coordinator; in seconds
+    CONF_Int32(status_report_max_backoff_seconds, "60");
     // Local directory to copy UDF libraries from HDFS into
     CONF_String(local_library_dir, "${UDF_RUNTIME_DIR}");
     // number of olap scanner thread pool size
     CONF_Int32(palo_scanner_thread_pool_thread_num, "48");
     // number of olap scanner thread pool size
     CONF_Int32(palo_scanner_thread_pool_queue_size, "102400");
+    // number of queues of olap scanner thread pool, each queue is served first by its
+    // own group of threads, which steal from the other queues when it is empty.
+    // 0 means one queue per cpu core, 1 means a single queue shared by all threads.
+    CONF_Int32(palo_scanner_thread_pool_queue_num, "0");
+    // number of threads a broker scan node scans its ranges with, each takes
+    // the next range not scanned yet
+    CONF_Int32(broker_scanner_thread_num, "4");
     // number of etl thread pool size
     CONF_Int32(etl_thread_pool_size, "8");
     // number of etl thread pool size
@@ -175,8 +204,14 @@ namespace config {
     CONF_Int32(palo_scan_range_row_count, "524288");
     // size of scanner queue between scanner thread and compute thread
     CONF_Int32(palo_scanner_queue_size, "1024");
+    // max bytes of row batches buffered between scanner threads and compute thread
+    // of one olap scan node, no more scanner is scheduled above it
+    CONF_Int64(palo_scanner_queue_max_bytes, "209715200");
     // single read execute fragment row size
     CONF_Int32(palo_scanner_row_num, "16384");
+    // max time(ms) a scanner keeps a scanner thread before yielding it to other
+    // scanners, so that scanners blocked on slow reads do not hold threads too long
+    CONF_Int32(palo_scanner_max_run_time_ms, "500");
     // number of max scan keys
     CONF_Int32(palo_max_scan_key_num, "1024");
     // return_row / total_row
@@ -189,6 +224,11 @@ namespace config {
     CONF_Int32(sorter_block_size, "8388608");
     // push_write_mbytes_per_sec
     CONF_Int32(push_write_mbytes_per_sec, "10");
+    // push写入时，解析、编码压缩和写文件分别由不同线程流水执行，此为等待编码的row block数，
+    // 0表示不使用流水线
+    CONF_Int32(push_write_pipeline_depth, "2");
+    // 所有push共用的列编码线程数，同一个row block的各列并行编码压缩
+    CONF_Int32(column_encode_thread_num, "8");
 
     CONF_Int64(column_dictionary_key_ration_threshold, "0");
     CONF_Int64(column_dictionary_key_size_threshold, "0");
@@ -221,6 +261,12 @@ namespace config {
     //file descriptors cache, by default, cache 30720 descriptors
     CONF_Int32(file_descriptor_cache_capacity, "30720");
     CONF_Int64(index_stream_cache_capacity, "10737418240");
+    // 短key索引项在首次查找时才加载, 放在此容量(字节)的LRU cache中, 长时间未查询的索引会被淘汰
+    CONF_Int64(index_entry_cache_capacity, "4294967296");
+    // 对不含CHAR/VARCHAR短key的索引, 用mmap的页作为索引项, 内存紧张时可由操作系统回收
+    CONF_Bool(index_entry_cache_use_mmap, "false");
+    // 短key均为定长类型时, 为索引项另建memcmp可比较的两层前缀索引, 加速短key查找
+    CONF_Bool(enable_short_key_index, "true");
     CONF_Int64(max_packed_row_block_size, "20971520");
 
     // be policy
@@ -232,6 +278,11 @@ namespace config {
     CONF_Double(base_cumulative_delta_ratio, "0.3");
     CONF_Int64(base_compaction_interval_seconds_since_last_operation, "604800");
     CONF_Int32(base_compaction_write_mbytes_per_sec, "5");
+    // 单个磁盘上所有base compaction共用的merge线程数。一个base compaction按base版本的
+    // 短key索引把key空间切成多个区间，每个区间占用一个slot并行merge
+    CONF_Int32(base_compaction_slots_per_disk, "1");
+    // 按key区间切分时，每个区间至少包含的行数
+    CONF_Int64(base_compaction_min_rows_per_range, "10000000");
 
     // cumulative compaction policy: max delta file's size unit:B
     CONF_Int32(cumulative_compaction_check_interval_seconds, "10");
@@ -240,6 +291,15 @@ namespace config {
     CONF_Int64(cumulative_compaction_budgeted_bytes, "104857600");
     CONF_Int32(cumulative_compaction_write_mbytes_per_sec, "100");
 
+    // compaction scheduler: 大于0时，由CompactionScheduler的这些线程统一执行base和
+    // cumulative compaction，按tablet的读放大代价排序，不再使用上面两种compaction各自的线程
+    // 默认为0，即仍使用上面两种compaction各自的线程
+    CONF_Int32(compaction_worker_num, "0");
+    CONF_Int32(compaction_schedule_interval_seconds, "10");
+    // 单个磁盘上同时执行的compaction所合并的数据量之和的上限，单位MB。
+    // 磁盘空闲时，超过上限的compaction也可以执行
+    CONF_Int64(compaction_disk_budget_mbytes, "2048");
+
     CONF_Int32(delete_delta_expire_time, "1440");
     // Port to start debug webserver on
     CONF_Int32(webserver_port, "8040");
@@ -256,6 +316,13 @@ namespace config {
     CONF_Int64(load_data_reserve_hours, "24");
     CONF_Int64(mini_load_max_mb, "2048");
 
+    // Used for stream load
+    // memtables of all running stream loads, reading bodies waits above it
+    CONF_Int64(stream_load_mem_limit_mb, "2048");
+    CONF_Int32(stream_load_mem_wait_seconds, "60");
+    // threads writing the deltas of stream loads, off the http threads
+    CONF_Int32(stream_load_push_thread_num, "4");
+
     // Fragment thread pool
     CONF_Int32(fragment_pool_thread_num, "64");
     CONF_Int32(fragment_pool_queue_size, "1024");
@@ -284,6 +351,16 @@ namespace config {
 
     CONF_Bool(disable_mem_pools, "false");
 
+    // Bytes of freed MemPool chunks that ChunkAllocator keeps for reuse. Chunks beyond
+    // it go back to the system. The kept chunks count against mem_limit and are freed
+    // when it is reached.
+    CONF_Int64(chunk_reserved_bytes_limit, "268435456");
+
+    // Bytes a thread in a ScopedMemTrackerCache keeps consumed ahead on each MemTracker
+    // it uses, so that it does not update the shared trackers on every allocation.
+    // 0 disables the batching.
+    CONF_Int64(mem_tracker_consume_batch_bytes, "1048576");
+
     // The probing algorithm of partitioned hash table.
     // Enable quadratic probing hash table
     CONF_Bool(enable_quadratic_probing, "false");
@@ -295,6 +372,10 @@ namespace config {
     CONF_Bool(enable_partitioned_hash_join, "false")
     CONF_Bool(enable_partitioned_aggregation, "false")
     CONF_Bool(enable_new_partitioned_aggregation, "true")
+    // Number of threads that aggregate the input of one aggregation node with grouping.
+    // Greater than 1 runs the hash aggregations AggregationNode can run in parallel mode
+    // on AggregationNode; the others keep their usual node.
+    CONF_Int32(aggregation_worker_num, "1")
     
     // for kudu
     // "The maximum size of the row batch queue, for Kudu scanners."
@@ -50,6 +50,8 @@
 #include "exprs/utility_functions.h"
 #include "exprs/json_functions.h"
 #include "exprs/hll_hash_function.h"
+#include "exprs/bitmap_function.h"
+#include "exprs/quantile_function.h"
 #include "olap/olap_rootpath.h"
 
 namespace palo {
@@ -161,6 +163,8 @@ void init_daemon(int argc, char** argv) {
     CompoundPredicate::init();
     JsonFunctions::init();
     HllHashFunctions::init();
+    BitmapFunctions::init();
+    QuantileFunctions::init();
 
     pthread_t tc_malloc_pid;
     pthread_create(&tc_malloc_pid, NULL, tcmalloc_gc_thread, NULL);
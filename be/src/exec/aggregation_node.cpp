@@ -26,9 +26,11 @@
 #include <thrift/protocol/TDebugProtocol.h>
 #include <x86intrin.h>
 #include <gperftools/profiler.h>
+#include <boost/thread/thread.hpp>
 
 #include "codegen/codegen_anyval.h"
 #include "codegen/llvm_codegen.h"
+#include "common/config.h"
 #include "exec/hash_table.hpp"
 #include "exprs/agg_fn_evaluator.h"
 #include "exprs/expr.h"
@@ -57,6 +59,28 @@ namespace palo {
 
 const char* AggregationNode::_s_llvm_class_name = "class.palo::AggregationNode";
 
+// The minimum reduction (input rows divided by the groups they need) for the hash table
+// of a streaming preaggregation to keep growing once it is that big. The sizes roughly
+// are where the table leaves a cache level; every lookup gets slower past them, which
+// only pays off if the rows really collapse into fewer groups.
+// Same policy as NewPartitionedAggregationNode.
+struct StreamingMinReductionEntry {
+    int64_t min_hash_table_bytes;
+    double min_reduction;
+};
+
+static const StreamingMinReductionEntry STREAMING_MIN_REDUCTION[] = {
+    // grow up to the L2 cache always
+    {0, 0.0},
+    // grow into the L3 cache if there is some reduction
+    {256 * 1024, 1.1},
+    // grow into main memory if the reduction is significant
+    {2 * 1024 * 1024, 2.0},
+};
+
+static const int STREAMING_MIN_REDUCTION_SIZE =
+    sizeof(STREAMING_MIN_REDUCTION) / sizeof(STREAMING_MIN_REDUCTION[0]);
+
 // TODO: pass in maximum size; enforce by setting limit in mempool
 // TODO: have a Status ExecNode::init(const TPlanNode&) member function
 // that does initialization outside of c'tor, so we can indicate errors
@@ -70,12 +94,20 @@ AggregationNode::AggregationNode(
             _singleton_output_tuple(NULL),
             //_tuple_pool(new MemPool()),
             //
+            _is_streaming_preagg(false),
+            _child_eos(false),
+            _streaming_reduction(1.0),
+            _output_partition(0),
             _codegen_process_row_batch_fn(NULL),
             _process_row_batch_fn(NULL),
             _needs_finalize(tnode.agg_node.need_finalize),
             _build_timer(NULL),
             _get_results_timer(NULL),
-            _hash_table_buckets_counter(NULL) {
+            _hash_table_buckets_counter(NULL),
+            _streaming_timer(NULL),
+            _passthrough_rows_counter(NULL),
+            _streaming_reduction_counter(NULL),
+            _merge_timer(NULL) {
 }
 
 AggregationNode::~AggregationNode() {
@@ -93,9 +125,52 @@ Status AggregationNode::init(const TPlanNode& tnode, RuntimeState* state) {
             _pool, tnode.agg_node.aggregate_functions[i], &evaluator);
         _aggregate_evaluators.push_back(evaluator);
     }
+    // only a first phase aggregation with grouping can pass rows through, its output
+    // is merged by the next phase anyway
+    _is_streaming_preagg = tnode.agg_node.__isset.use_streaming_preaggregation
+        && tnode.agg_node.use_streaming_preaggregation
+        && !_needs_finalize && !_probe_expr_ctxs.empty();
+
+    if (can_aggregate_parallel(tnode)) {
+        for (int i = 0; i < config::aggregation_worker_num; ++i) {
+            AggregationWorker* worker = _pool->add(new AggregationWorker());
+            for (int j = 0; j < tnode.agg_node.aggregate_functions.size(); ++j) {
+                AggFnEvaluator* evaluator = NULL;
+                RETURN_IF_ERROR(AggFnEvaluator::create(
+                    _pool, tnode.agg_node.aggregate_functions[j], &evaluator));
+                worker->evaluators.push_back(evaluator);
+            }
+            _workers.push_back(worker);
+        }
+    }
     return Status::OK;
 }
 
+bool AggregationNode::can_aggregate_parallel(const TPlanNode& tnode) {
+    const TAggregationNode& agg_node = tnode.agg_node;
+    if (config::aggregation_worker_num <= 1 || agg_node.grouping_exprs.empty()) {
+        return false;
+    }
+    // a streaming preaggregation passes rows through instead
+    if (agg_node.__isset.use_streaming_preaggregation
+            && agg_node.use_streaming_preaggregation && !agg_node.need_finalize) {
+        return false;
+    }
+    // a limit without aggregates stops at the first groups
+    if (tnode.limit != -1 && agg_node.aggregate_functions.empty()) {
+        return false;
+    }
+    // distinct aggregates keep their values outside of the tuples, so they cannot
+    // be merged across workers
+    for (const TExpr& fn : agg_node.aggregate_functions) {
+        const std::string& name = fn.nodes[0].fn.name.function_name;
+        if (name == "count_distinct" || name == "sum_distinct") {
+            return false;
+        }
+    }
+    return true;
+}
+
 Status AggregationNode::prepare(RuntimeState* state) {
     RETURN_IF_ERROR(ExecNode::prepare(state));
     _build_timer = ADD_TIMER(runtime_profile(), "BuildTime");
@@ -104,6 +179,18 @@ Status AggregationNode::prepare(RuntimeState* state) {
         ADD_COUNTER(runtime_profile(), "BuildBuckets", TUnit::UNIT);
     _hash_table_load_factor_counter =
         ADD_COUNTER(runtime_profile(), "LoadFactor", TUnit::DOUBLE_VALUE);
+    if (_is_streaming_preagg) {
+        runtime_profile()->append_exec_option("Streaming Preaggregation");
+        _streaming_timer = ADD_TIMER(runtime_profile(), "StreamingTime");
+        _passthrough_rows_counter =
+            ADD_COUNTER(runtime_profile(), "RowsPassedThrough", TUnit::UNIT);
+        _streaming_reduction_counter =
+            ADD_COUNTER(runtime_profile(), "StreamingReduction", TUnit::DOUBLE_VALUE);
+    }
+    if (!_workers.empty()) {
+        runtime_profile()->append_exec_option("Parallel Aggregation");
+        _merge_timer = ADD_TIMER(runtime_profile(), "MergeTime");
+    }
 
     SCOPED_TIMER(_runtime_profile->total_time_counter());
 
@@ -150,6 +237,20 @@ Status AggregationNode::prepare(RuntimeState* state) {
         state->obj_pool()->add(_agg_fn_ctxs[i]);
     }
 
+    for (AggregationWorker* worker : _workers) {
+        worker->tuple_pool.reset(new MemPool(mem_tracker()));
+        worker->fn_ctxs.resize(worker->evaluators.size());
+        int slot_idx = _probe_expr_ctxs.size();
+        for (int i = 0; i < worker->evaluators.size(); ++i, ++slot_idx) {
+            RETURN_IF_ERROR(worker->evaluators[i]->prepare(
+                    state, child(0)->row_desc(), worker->tuple_pool.get(),
+                    _intermediate_tuple_desc->slots()[slot_idx],
+                    _output_tuple_desc->slots()[slot_idx], mem_tracker(),
+                    &worker->fn_ctxs[i]));
+            state->obj_pool()->add(worker->fn_ctxs[i]);
+        }
+    }
+
     // TODO: how many buckets?
     _hash_tbl.reset(new HashTable(
             _build_expr_ctxs, _probe_expr_ctxs, 1, true, id(), mem_tracker(), 1024));
@@ -160,7 +261,8 @@ Status AggregationNode::prepare(RuntimeState* state) {
         _singleton_output_tuple = construct_intermediate_tuple();
     }
 
-    if (state->codegen_level() > 0) {
+    // the streaming and parallel paths are not codegen'd
+    if (state->codegen_level() > 0 && !_is_streaming_preagg && _workers.empty()) {
         LlvmCodeGen* codegen = NULL;
         RETURN_IF_ERROR(state->get_codegen(&codegen));
         Function* update_tuple_fn = codegen_update_tuple(state);
@@ -189,8 +291,20 @@ Status AggregationNode::open(RuntimeState* state) {
     for (int i = 0; i < _aggregate_evaluators.size(); ++i) {
         RETURN_IF_ERROR(_aggregate_evaluators[i]->open(state, _agg_fn_ctxs[i]));
     }
+    for (AggregationWorker* worker : _workers) {
+        for (int i = 0; i < worker->evaluators.size(); ++i) {
+            RETURN_IF_ERROR(worker->evaluators[i]->open(state, worker->fn_ctxs[i]));
+        }
+    }
 
     RETURN_IF_ERROR(_children[0]->open(state));
+    if (_is_streaming_preagg) {
+        // the child is consumed in get_next()
+        return Status::OK;
+    }
+    if (!_workers.empty()) {
+        return aggregate_parallel(state);
+    }
 
     RowBatch batch(_children[0]->row_desc(), state->batch_size(), mem_tracker());
     int64_t num_input_rows = 0;
@@ -274,6 +388,17 @@ Status AggregationNode::get_next(RuntimeState* state, RowBatch* row_batch, bool*
         return Status::OK;
     }
 
+    if (_is_streaming_preagg && !_child_eos) {
+        RETURN_IF_ERROR(get_next_streaming(state, row_batch));
+        if (!_child_eos || reached_limit()) {
+            *eos = reached_limit();
+            COUNTER_SET(_rows_returned_counter, _num_rows_returned);
+            return Status::OK;
+        }
+        // the child is exhausted: output the hash table from now on
+        _output_iterator = _hash_tbl->begin();
+    }
+
     ExprContext** ctxs = &_conjunct_ctxs[0];
     int num_ctxs = _conjunct_ctxs.size();
 
@@ -304,6 +429,7 @@ Status AggregationNode::get_next(RuntimeState* state, RowBatch* row_batch, bool*
         }
 
         _output_iterator.next<false>();
+        next_output_partition();
     }
 
     *eos = _output_iterator.at_end() || reached_limit();
@@ -328,18 +454,28 @@ Status AggregationNode::close(RuntimeState* state) {
     // them in order to free any memory allocated by UDAs. Finalize() requires a dst tuple
     // but we don't actually need the result, so allocate a single dummy tuple to avoid
     // accumulating memory.
+    if (_is_streaming_preagg && !_child_eos && _hash_tbl.get() != NULL) {
+        // closed before the table was output
+        _output_iterator = _hash_tbl->begin();
+    }
     Tuple* dummy_dst = NULL;
     if (_needs_finalize && _output_tuple_desc != NULL) {
         dummy_dst = Tuple::create(_output_tuple_desc->byte_size(), _tuple_pool.get());
     }
     while (!_output_iterator.at_end()) {
         Tuple* tuple = _output_iterator.get_row()->get_tuple(0);
+        // the merged partitions were aggregated with the contexts of their workers
+        const std::vector<AggFnEvaluator*>& evaluators = _workers.empty()
+            ? _aggregate_evaluators : _workers[_output_partition]->evaluators;
+        const std::vector<palo_udf::FunctionContext*>& fn_ctxs = _workers.empty()
+            ? _agg_fn_ctxs : _workers[_output_partition]->fn_ctxs;
         if (_needs_finalize) {
-            AggFnEvaluator::finalize(_aggregate_evaluators, _agg_fn_ctxs, tuple, dummy_dst);
+            AggFnEvaluator::finalize(evaluators, fn_ctxs, tuple, dummy_dst);
         } else {
-            AggFnEvaluator::serialize(_aggregate_evaluators, _agg_fn_ctxs, tuple);
+            AggFnEvaluator::serialize(evaluators, fn_ctxs, tuple);
         }
         _output_iterator.next<false>();
+        next_output_partition();
     }
 
     for (int i = 0; i < _aggregate_evaluators.size(); ++i) {
@@ -349,6 +485,30 @@ Status AggregationNode::close(RuntimeState* state) {
         }
     }
 
+    for (AggregationWorker* worker : _workers) {
+        for (int i = 0; i < worker->evaluators.size(); ++i) {
+            worker->evaluators[i]->close(state);
+            if (i < worker->fn_ctxs.size() && worker->fn_ctxs[i] != NULL
+                    && worker->fn_ctxs[i]->impl() != NULL) {
+                worker->fn_ctxs[i]->impl()->close();
+            }
+        }
+        for (HashTable* hash_tbl : worker->partitions) {
+            hash_tbl->close();
+            delete hash_tbl;
+        }
+        worker->partitions.clear();
+        if (worker->merged_tbl.get() != NULL) {
+            worker->merged_tbl->close();
+            worker->merged_tbl.reset();
+        }
+        if (worker->tuple_pool.get() != NULL) {
+            worker->tuple_pool->free_all();
+        }
+        Expr::close(worker->probe_expr_ctxs, state);
+        Expr::close(worker->build_expr_ctxs, state);
+    }
+
     if (_tuple_pool.get() != NULL) {
         _tuple_pool->free_all();
     }
@@ -362,29 +522,216 @@ Status AggregationNode::close(RuntimeState* state) {
     return ExecNode::close(state);
 }
 
-Tuple* AggregationNode::construct_intermediate_tuple() {
-    Tuple* agg_tuple = Tuple::create(_intermediate_tuple_desc->byte_size(), _tuple_pool.get());
+Status AggregationNode::get_next_streaming(RuntimeState* state, RowBatch* row_batch) {
+    DCHECK(_is_streaming_preagg);
+    if (_child_batch.get() == NULL) {
+        _child_batch.reset(
+            new RowBatch(child(0)->row_desc(), state->batch_size(), mem_tracker()));
+    }
+    // every child row gives at most one output row, so a whole child batch fits
+    // in 'row_batch' as long as it is empty
+    while (row_batch->num_rows() == 0 && !_child_eos) {
+        RETURN_IF_CANCELLED(state);
+        RETURN_IF_ERROR(state->check_query_state());
+        RETURN_IF_ERROR(child(0)->get_next(state, _child_batch.get(), &_child_eos));
+        {
+            SCOPED_TIMER(_streaming_timer);
+            process_row_batch_streaming(_child_batch.get(), row_batch);
+        }
+        _child_batch->reset();
+
+        COUNTER_SET(_hash_table_buckets_counter, _hash_tbl->num_buckets());
+        COUNTER_SET(memory_used_counter(),
+                    _tuple_pool->peak_allocated_bytes() + _hash_tbl->byte_size());
+        COUNTER_SET(_hash_table_load_factor_counter, _hash_tbl->load_factor());
+        COUNTER_SET(_streaming_reduction_counter, _streaming_reduction);
+        RETURN_IF_ERROR(state->check_query_state());
+    }
+    if (_child_eos) {
+        _child_batch.reset();
+    }
+    if (limit() != -1 && _num_rows_returned + row_batch->num_rows() > limit()) {
+        row_batch->set_num_rows(limit() - _num_rows_returned);
+    }
+    _num_rows_returned += row_batch->num_rows();
+    COUNTER_UPDATE(_passthrough_rows_counter, row_batch->num_rows());
+    return Status::OK;
+}
+
+bool AggregationNode::should_expand_hash_table() const {
+    int64_t hash_table_bytes = _hash_tbl->byte_size();
+    int level = 0;
+    while (level + 1 < STREAMING_MIN_REDUCTION_SIZE
+            && hash_table_bytes >= STREAMING_MIN_REDUCTION[level + 1].min_hash_table_bytes) {
+        ++level;
+    }
+    return _streaming_reduction > STREAMING_MIN_REDUCTION[level].min_reduction;
+}
+
+Status AggregationNode::aggregate_parallel(RuntimeState* state) {
+    int num_partitions = _workers.size();
+    for (AggregationWorker* worker : _workers) {
+        RETURN_IF_ERROR(Expr::clone_if_not_exists(
+                _probe_expr_ctxs, state, &worker->probe_expr_ctxs));
+        RETURN_IF_ERROR(Expr::clone_if_not_exists(
+                _build_expr_ctxs, state, &worker->build_expr_ctxs));
+        for (int i = 0; i < num_partitions; ++i) {
+            worker->partitions.push_back(new HashTable(
+                    worker->build_expr_ctxs, worker->probe_expr_ctxs, 1, true, id(),
+                    mem_tracker(), 1024));
+        }
+    }
+
+    // a few batches per worker keep them busy while the child produces the next ones
+    BlockingQueue<RowBatch*> queue(2 * _workers.size());
+    boost::thread_group threads;
+    for (AggregationWorker* worker : _workers) {
+        threads.add_thread(new boost::thread(
+                &AggregationNode::aggregate_worker, this, state, worker, &queue));
+    }
+
+    Status status;
+    int64_t num_input_rows = 0;
+    bool eos = false;
+    RowBatch input_batch(child(0)->row_desc(), state->batch_size(), mem_tracker());
+    while (!eos) {
+        if (state->is_cancelled()) {
+            status = Status::CANCELLED;
+            break;
+        }
+        status = state->check_query_state();
+        if (!status.ok()) {
+            break;
+        }
+        status = child(0)->get_next(state, &input_batch, &eos);
+        if (!status.ok()) {
+            break;
+        }
+        if (input_batch.num_rows() > 0) {
+            // The rows may point to memory the child still owns and reuses in its next
+            // get_next(), so the workers get a copy that owns all its data.
+            RowBatch* batch = new RowBatch(
+                child(0)->row_desc(), input_batch.num_rows(), mem_tracker());
+            input_batch.deep_copy_to(batch);
+            num_input_rows += batch->num_rows();
+            queue.blocking_put(batch);
+        }
+        input_batch.reset();
+    }
+    // the workers drain the queue before they stop
+    queue.shutdown();
+    threads.join_all();
+    RETURN_IF_ERROR(status);
+    RETURN_IF_CANCELLED(state);
+    RETURN_IF_ERROR(state->check_query_state());
+
+    {
+        SCOPED_TIMER(_merge_timer);
+        boost::thread_group merge_threads;
+        for (int i = 0; i < num_partitions; ++i) {
+            merge_threads.add_thread(new boost::thread(
+                    &AggregationNode::merge_partition, this, i));
+        }
+        merge_threads.join_all();
+    }
+    int64_t num_agg_rows = 0;
+    for (AggregationWorker* worker : _workers) {
+        for (HashTable* hash_tbl : worker->partitions) {
+            hash_tbl->close();
+            delete hash_tbl;
+        }
+        worker->partitions.clear();
+        num_agg_rows += worker->merged_tbl->size();
+    }
+    RETURN_IF_ERROR(state->check_query_state());
+
+    VLOG_ROW << "id=" << id() << " aggregated " << num_input_rows << " input rows into "
+              << num_agg_rows << " output rows with " << _workers.size() << " workers";
+    _output_partition = 0;
+    _output_iterator = _workers[0]->merged_tbl->begin();
+    next_output_partition();
+    return Status::OK;
+}
+
+void AggregationNode::aggregate_worker(
+        RuntimeState* state, AggregationWorker* worker, BlockingQueue<RowBatch*>* queue) {
+    RowBatch* batch = NULL;
+    while (queue->blocking_get(&batch)) {
+        if (!state->is_cancelled()) {
+            process_row_batch_partitioned(worker, batch);
+        }
+        delete batch;
+    }
+    // Merge() takes the intermediate values, and the workers merging these partitions
+    // must not touch the function contexts of this one.
+    for (HashTable* hash_tbl : worker->partitions) {
+        for (HashTable::Iterator it = hash_tbl->begin(); !it.at_end(); it.next<false>()) {
+            AggFnEvaluator::serialize(
+                worker->evaluators, worker->fn_ctxs, it.get_row()->get_tuple(0));
+        }
+    }
+}
+
+void AggregationNode::merge_partition(int partition) {
+    AggregationWorker* worker = _workers[partition];
+    // the partitions are looked up with the grouping slots of their tuples
+    worker->merged_tbl.reset(new HashTable(
+            worker->build_expr_ctxs, worker->build_expr_ctxs, 1, true, id(),
+            mem_tracker(), 1024));
+    HashTable* merged_tbl = worker->merged_tbl.get();
+    for (AggregationWorker* src_worker : _workers) {
+        HashTable* src_tbl = src_worker->partitions[partition];
+        for (HashTable::Iterator it = src_tbl->begin(); !it.at_end(); it.next<false>()) {
+            Tuple* src_tuple = it.get_row()->get_tuple(0);
+            Tuple* agg_tuple = NULL;
+            HashTable::Iterator dst_it = merged_tbl->find(it.get_row());
+            if (dst_it.at_end()) {
+                agg_tuple = construct_intermediate_tuple(
+                    merged_tbl, worker->evaluators, worker->fn_ctxs,
+                    worker->tuple_pool.get());
+                merged_tbl->insert(reinterpret_cast<TupleRow*>(&agg_tuple));
+            } else {
+                agg_tuple = dst_it.get_row()->get_tuple(0);
+            }
+            for (int i = 0; i < worker->evaluators.size(); ++i) {
+                worker->evaluators[i]->merge(worker->fn_ctxs[i], src_tuple, agg_tuple);
+            }
+        }
+    }
+}
+
+void AggregationNode::next_output_partition() {
+    while (_output_iterator.at_end() && _output_partition + 1 < _workers.size()) {
+        ++_output_partition;
+        _output_iterator = _workers[_output_partition]->merged_tbl->begin();
+    }
+}
+
+Tuple* AggregationNode::construct_intermediate_tuple(
+        HashTable* hash_tbl, const std::vector<AggFnEvaluator*>& evaluators,
+        const std::vector<palo_udf::FunctionContext*>& fn_ctxs, MemPool* pool) {
+    Tuple* agg_tuple = Tuple::create(_intermediate_tuple_desc->byte_size(), pool);
     vector<SlotDescriptor*>::const_iterator slot_desc = _intermediate_tuple_desc->slots().begin();
 
     // copy grouping values
     for (int i = 0; i < _probe_expr_ctxs.size(); ++i, ++slot_desc) {
-        if (_hash_tbl->last_expr_value_null(i)) {
+        if (hash_tbl->last_expr_value_null(i)) {
             agg_tuple->set_null((*slot_desc)->null_indicator_offset());
         } else {
-            void* src = _hash_tbl->last_expr_value(i);
+            void* src = hash_tbl->last_expr_value(i);
             void* dst = agg_tuple->get_slot((*slot_desc)->tuple_offset());
-            RawValue::write(src, dst, (*slot_desc)->type(), _tuple_pool.get());
+            RawValue::write(src, dst, (*slot_desc)->type(), pool);
         }
     }
 
     // Initialize aggregate output.
-    for (int i = 0; i < _aggregate_evaluators.size(); ++i, ++slot_desc) {
+    for (int i = 0; i < evaluators.size(); ++i, ++slot_desc) {
         while (!(*slot_desc)->is_materialized()) {
             ++slot_desc;
         }
 
-        AggFnEvaluator* evaluator = _aggregate_evaluators[i];
-        evaluator->init(_agg_fn_ctxs[i], agg_tuple);
+        AggFnEvaluator* evaluator = evaluators[i];
+        evaluator->init(fn_ctxs[i], agg_tuple);
 
         // Codegen specific path.
         // To minimize branching on the UpdateAggTuple path, initialize the result value
@@ -440,6 +787,17 @@ void AggregationNode::update_tuple(Tuple* tuple, TupleRow* row) {
 }
 
 Tuple* AggregationNode::finalize_tuple(Tuple* tuple, MemPool* pool) {
+    if (_workers.empty()) {
+        return finalize_tuple(_aggregate_evaluators, _agg_fn_ctxs, tuple, pool);
+    }
+    // the merged partitions were aggregated with the contexts of their workers
+    AggregationWorker* worker = _workers[_output_partition];
+    return finalize_tuple(worker->evaluators, worker->fn_ctxs, tuple, pool);
+}
+
+Tuple* AggregationNode::finalize_tuple(
+        const std::vector<AggFnEvaluator*>& evaluators,
+        const std::vector<palo_udf::FunctionContext*>& fn_ctxs, Tuple* tuple, MemPool* pool) {
     DCHECK(tuple != NULL);
 
     Tuple* dst = tuple;
@@ -447,9 +805,9 @@ Tuple* AggregationNode::finalize_tuple(Tuple* tuple, MemPool* pool) {
         dst = Tuple::create(_output_tuple_desc->byte_size(), pool);
     }
     if (_needs_finalize) {
-        AggFnEvaluator::finalize(_aggregate_evaluators, _agg_fn_ctxs, tuple, dst);
+        AggFnEvaluator::finalize(evaluators, fn_ctxs, tuple, dst);
     } else {
-        AggFnEvaluator::serialize(_aggregate_evaluators, _agg_fn_ctxs, tuple);
+        AggFnEvaluator::serialize(evaluators, fn_ctxs, tuple);
     }
     // Copy grouping values from tuple to dst.
     // TODO: Codegen this.
@@ -30,6 +30,7 @@
 #include "runtime/free_list.hpp"
 #include "runtime/mem_pool.h"
 #include "runtime/string_value.h"
+#include "util/blocking_queue.hpp"
 
 namespace llvm {
 class Function;
@@ -51,6 +52,20 @@ class SlotDescriptor;
 // contain slots for all grouping and aggregation exprs (the grouping
 // slots precede the aggregation expr slots in the output tuple descriptor).
 //
+// A first phase aggregation planned with use_streaming_preaggregation streams its
+// output instead: rows whose group is not in the hash table are passed through as
+// single row groups, rather than growing the table, once the table has outgrown a
+// cache level and the reduction measured on the recent batches does not pay for it.
+// The table is output once the child is exhausted.
+//
+// With config::aggregation_worker_num > 1, an aggregation with grouping and without
+// distinct aggregates runs in parallel: the fragment thread only reads the child and
+// hands its batches to the aggregation workers. Each worker aggregates them into its
+// own hash tables, one per partition of the groups, with its own copies of the
+// evaluators and exprs. Once the child is exhausted, worker i merges partition i of
+// all workers, so no partition is touched by two threads, and the merged partitions
+// are output one after the other.
+//
 // For string aggregation, we need to append additional data to the tuple object
 // to reduce the number of string allocations (since we cannot know the length of
 // the output string beforehand).  For each string slot in the output tuple, a int32
@@ -72,8 +87,25 @@ public:
     virtual void push_down_predicate(
         RuntimeState *state, std::list<ExprContext*> *expr_ctxs);
 
+    // Whether the aggregation of 'tnode' runs in parallel mode, see above.
+    static bool can_aggregate_parallel(const TPlanNode& tnode);
+
     static const char* _s_llvm_class_name;
 private:
+    // State of one worker of a parallel aggregation. Evaluators, function contexts and
+    // expr contexts are not thread safe, so every worker has its own.
+    struct AggregationWorker {
+        std::vector<AggFnEvaluator*> evaluators;
+        std::vector<palo_udf::FunctionContext*> fn_ctxs;
+        std::vector<ExprContext*> probe_expr_ctxs;
+        std::vector<ExprContext*> build_expr_ctxs;
+        boost::scoped_ptr<MemPool> tuple_pool;
+        // groups aggregated by this worker, by partition
+        std::vector<HashTable*> partitions;
+        // groups of the partition owned by this worker, merged from all workers
+        boost::scoped_ptr<HashTable> merged_tbl;
+    };
+
     boost::scoped_ptr<HashTable> _hash_tbl;
     HashTable::Iterator _output_iterator;
 
@@ -101,6 +133,19 @@ private:
     Tuple* _singleton_output_tuple;  // result of aggregation w/o GROUP BY
     boost::scoped_ptr<MemPool> _tuple_pool;
 
+    // true if this is a streaming preaggregation, see the class comment
+    bool _is_streaming_preagg;
+    // batch of child rows of a streaming preaggregation
+    boost::scoped_ptr<RowBatch> _child_batch;
+    bool _child_eos;
+    // input rows divided by the groups they needed, measured on the last child batch
+    double _streaming_reduction;
+
+    // workers of a parallel aggregation, empty otherwise; worker i owns partition i
+    std::vector<AggregationWorker*> _workers;
+    // partition of _output_iterator in a parallel aggregation
+    int _output_partition;
+
     /// IR for process row batch.  NULL if codegen is disabled.
     llvm::Function* _codegen_process_row_batch_fn;
 
@@ -122,11 +167,28 @@ private:
     RuntimeProfile::Counter* _hash_table_buckets_counter;
     // Load factor in hash table
     RuntimeProfile::Counter* _hash_table_load_factor_counter;
+    // Time spent aggregating or passing through child rows in a streaming preaggregation
+    RuntimeProfile::Counter* _streaming_timer;
+    // Rows passed through without being aggregated
+    RuntimeProfile::Counter* _passthrough_rows_counter;
+    RuntimeProfile::Counter* _streaming_reduction_counter;
+    // Time spent merging the partitions of a parallel aggregation
+    RuntimeProfile::Counter* _merge_timer;
 
     // Constructs a new aggregation output tuple (allocated from _tuple_pool),
     // initialized to grouping values computed over '_current_row'.
     // Aggregation expr slots are set to their initial values.
-    Tuple* construct_intermediate_tuple();
+    Tuple* construct_intermediate_tuple() {
+        return construct_intermediate_tuple(_tuple_pool.get());
+    }
+    Tuple* construct_intermediate_tuple(MemPool* pool) {
+        return construct_intermediate_tuple(
+            _hash_tbl.get(), _aggregate_evaluators, _agg_fn_ctxs, pool);
+    }
+    // Same, with the grouping values last evaluated by 'hash_tbl'.
+    Tuple* construct_intermediate_tuple(
+        HashTable* hash_tbl, const std::vector<AggFnEvaluator*>& evaluators,
+        const std::vector<palo_udf::FunctionContext*>& fn_ctxs, MemPool* pool);
 
     // Updates the aggregation output tuple 'tuple' with aggregation values
     // computed over 'row'.
@@ -135,11 +197,45 @@ private:
     // Called when all rows have been aggregated for the aggregation tuple to compute final
     // aggregate values
     Tuple* finalize_tuple(Tuple* tuple, MemPool* pool);
+    Tuple* finalize_tuple(
+        const std::vector<AggFnEvaluator*>& evaluators,
+        const std::vector<palo_udf::FunctionContext*>& fn_ctxs, Tuple* tuple, MemPool* pool);
 
     // Do the aggregation for all tuple rows in the batch
     void process_row_batch_no_grouping(RowBatch* batch, MemPool* pool);
     void process_row_batch_with_grouping(RowBatch* batch, MemPool* pool);
 
+    // Aggregates 'batch' into the hash table, or passes its rows through to 'out_batch'
+    // when their group is new and the table should not grow.
+    void process_row_batch_streaming(RowBatch* batch, RowBatch* out_batch);
+
+    // Reads child batches until some rows are passed through to 'row_batch' or the
+    // child is exhausted.
+    Status get_next_streaming(RuntimeState* state, RowBatch* row_batch);
+
+    // Returns true if the hash table may grow to aggregate the next batch, given its
+    // current size and _streaming_reduction.
+    bool should_expand_hash_table() const;
+
+    // Aggregates the child with _workers and merges their partitions.
+    Status aggregate_parallel(RuntimeState* state);
+
+    // Thread of a worker: aggregates the batches of 'queue' until it is shut down, then
+    // serializes the groups so that other workers can merge them.
+    void aggregate_worker(
+        RuntimeState* state, AggregationWorker* worker, BlockingQueue<RowBatch*>* queue);
+
+    // Aggregates 'batch' into the partitions of 'worker'.
+    void process_row_batch_partitioned(AggregationWorker* worker, RowBatch* batch);
+
+    // Thread merging partition 'partition' of all workers into the merged_tbl of the
+    // worker owning it.
+    void merge_partition(int partition);
+
+    // Moves _output_iterator to the next non empty merged partition, if _output_iterator
+    // is at its end and there is one.
+    void next_output_partition();
+
     /// Codegen the process row batch loop.  The loop has already been compiled to
     /// IR and loaded into the codegen object.  UpdateAggTuple has also been
     /// codegen'd to IR.  This function will modify the loop subsituting the
@@ -20,9 +20,15 @@
 
 #include "exec/aggregation_node.h"
 
+#include <algorithm>
+
 #include "exec/hash_table.hpp"
+#include "exprs/agg_fn_evaluator.h"
+#include "exprs/expr_context.h"
+#include "runtime/raw_value.h"
 #include "runtime/row_batch.h"
 #include "runtime/runtime_state.h"
+#include "runtime/string_value.h"
 #include "runtime/tuple.h"
 #include "runtime/tuple_row.h"
 
@@ -51,5 +57,92 @@ void AggregationNode::process_row_batch_with_grouping(RowBatch* batch, MemPool*
     }
 }
 
+void AggregationNode::process_row_batch_partitioned(
+        AggregationWorker* worker, RowBatch* batch) {
+    int num_partitions = worker->partitions.size();
+    for (int i = 0; i < batch->num_rows(); ++i) {
+        TupleRow* row = batch->get_row(i);
+        // FNV rather than the hash of the tables, whose low bits pick their buckets
+        uint32_t hash = HashUtil::FNV_SEED;
+        for (int j = 0; j < worker->probe_expr_ctxs.size(); ++j) {
+            ExprContext* ctx = worker->probe_expr_ctxs[j];
+            hash = RawValue::get_hash_value_fvn(ctx->get_value(row), ctx->root()->type(), hash);
+        }
+        HashTable* hash_tbl = worker->partitions[hash % num_partitions];
+
+        Tuple* agg_tuple = NULL;
+        HashTable::Iterator it = hash_tbl->find(row);
+        if (it.at_end()) {
+            agg_tuple = construct_intermediate_tuple(
+                hash_tbl, worker->evaluators, worker->fn_ctxs, worker->tuple_pool.get());
+            hash_tbl->insert(reinterpret_cast<TupleRow*>(&agg_tuple));
+        } else {
+            agg_tuple = it.get_row()->get_tuple(0);
+        }
+        AggFnEvaluator::add(worker->evaluators, worker->fn_ctxs, row, agg_tuple);
+    }
+}
+
+void AggregationNode::process_row_batch_streaming(RowBatch* batch, RowBatch* out_batch) {
+    // once the table stops growing, it keeps aggregating the groups it already has
+    // until it would have to resize
+    bool expand = should_expand_hash_table();
+    int64_t num_groups_before = _hash_tbl->size();
+    int64_t num_passthrough_rows = 0;
+    ExprContext** ctxs = &_conjunct_ctxs[0];
+    int num_ctxs = _conjunct_ctxs.size();
+    const std::vector<SlotDescriptor*>& string_slots = _intermediate_tuple_desc->string_slots();
+    MemPool* out_pool = out_batch->tuple_data_pool();
+
+    for (int i = 0; i < batch->num_rows(); ++i) {
+        TupleRow* row = batch->get_row(i);
+        HashTable::Iterator it = _hash_tbl->find(row);
+        if (!it.at_end()) {
+            update_tuple(it.get_row()->get_tuple(0), row);
+            continue;
+        }
+        if (expand || !_hash_tbl->insert_will_resize()) {
+            Tuple* agg_tuple = construct_intermediate_tuple();
+            _hash_tbl->insert(reinterpret_cast<TupleRow*>(&agg_tuple));
+            update_tuple(agg_tuple, row);
+            continue;
+        }
+        // output the row as a group of its own, serialized like the groups of the table
+        ++num_passthrough_rows;
+        Tuple* agg_tuple = construct_intermediate_tuple(out_pool);
+        update_tuple(agg_tuple, row);
+        AggFnEvaluator::serialize(_aggregate_evaluators, _agg_fn_ctxs, agg_tuple);
+        // serialized strings are allocations of the function contexts, which are freed
+        // below, move them to the batch
+        for (const SlotDescriptor* slot_desc : string_slots) {
+            if (agg_tuple->is_null(slot_desc->null_indicator_offset())) {
+                continue;
+            }
+            StringValue* value = agg_tuple->get_string_slot(slot_desc->tuple_offset());
+            char* copy = reinterpret_cast<char*>(out_pool->allocate(value->len));
+            memcpy(copy, value->ptr, value->len);
+            value->ptr = copy;
+        }
+        int row_idx = out_batch->add_row();
+        TupleRow* out_row = out_batch->get_row(row_idx);
+        out_row->set_tuple(0, agg_tuple);
+        if (ExecNode::eval_conjuncts(ctxs, num_ctxs, out_row)) {
+            out_batch->commit_last_row();
+        }
+    }
+
+    // the passed through rows no longer need what the function contexts allocated for
+    // them, free it with each batch instead of when the node is closed
+    if (num_passthrough_rows > 0) {
+        ExprContext::free_local_allocations(_agg_fn_ctxs);
+    }
+
+    if (batch->num_rows() > 0) {
+        int64_t num_groups = _hash_tbl->size() - num_groups_before + num_passthrough_rows;
+        _streaming_reduction =
+            static_cast<double>(batch->num_rows()) / std::max<int64_t>(num_groups, 1);
+    }
+}
+
 }
 
@@ -15,9 +15,11 @@
 
 #include "exec/broker_scan_node.h"
 
+#include <algorithm>
 #include <chrono>
 #include <sstream>
 
+#include "common/config.h"
 #include "common/object_pool.h"
 #include "runtime/runtime_state.h"
 #include "runtime/row_batch.h"
@@ -35,6 +37,7 @@ BrokerScanNode::BrokerScanNode(
             _tuple_id(tnode.broker_scan_node.tuple_id),
             _runtime_state(nullptr),
             _tuple_desc(nullptr),
+            _next_range_idx(0),
             _num_running_scanners(0),
             _scan_finished(false),
             _max_buffered_batches(1024),
@@ -127,11 +130,16 @@ Status BrokerScanNode::open(RuntimeState* state) {
 }
 
 Status BrokerScanNode::start_scanners() {
+    // at least one worker, which reports the stats even if there is no range
+    int num_scanners = std::max(1, std::min<int>(config::broker_scanner_thread_num,
+                                                 _scan_ranges.size()));
     {
         std::unique_lock<std::mutex> l(_batch_queue_lock);
-        _num_running_scanners = 1;
+        _num_running_scanners = num_scanners;
+    }
+    for (int i = 0; i < num_scanners; ++i) {
+        _scanner_threads.emplace_back(&BrokerScanNode::scanner_worker, this);
     }
-    _scanner_threads.emplace_back(&BrokerScanNode::scanner_worker, this, 0, _scan_ranges.size());
     return Status::OK;
 }
 
@@ -379,7 +387,7 @@ Status BrokerScanNode::scanner_scan(
     return Status::OK;
 }
 
-void BrokerScanNode::scanner_worker(int start_idx, int length) {
+void BrokerScanNode::scanner_worker() {
     // Clone expr context
     std::vector<ExprContext*> scanner_expr_ctxs;
     auto status = Expr::clone_if_not_exists(_conjunct_ctxs, _runtime_state, &scanner_expr_ctxs);
@@ -395,12 +403,15 @@ void BrokerScanNode::scanner_worker(int start_idx, int length) {
         }
     }
     BrokerScanCounter counter;
-    for (int i = 0; i < length && status.ok(); ++i) {
-        const TBrokerScanRange& scan_range = 
-            _scan_ranges[start_idx + i].scan_range.broker_scan_range;
+    while (status.ok() && !_scan_finished.load()) {
+        int idx = _next_range_idx.fetch_add(1);
+        if (idx >= _scan_ranges.size()) {
+            break;
+        }
+        const TBrokerScanRange& scan_range = _scan_ranges[idx].scan_range.broker_scan_range;
         status = scanner_scan(scan_range, scanner_expr_ctxs, partition_expr_ctxs, &counter);
         if (!status.ok()) {
-            LOG(WARNING) << "Scanner[" << start_idx + i << "] prcess failed. status="
+            LOG(WARNING) << "Scanner[" << idx << "] prcess failed. status="
                 << status.get_error_msg();
         }
     }
@@ -83,8 +83,9 @@ private:
     // Create scanners to do scan job
     Status start_scanners();
 
-    // One scanner worker, This scanner will hanle 'length' ranges start from start_idx
-    void scanner_worker(int start_idx, int length);
+    // One scanner worker, This scanner will handle the ranges it takes from
+    // _next_range_idx until no range is left
+    void scanner_worker();
 
     // Scan one range
     Status scanner_scan(const TBrokerScanRange& scan_range,
@@ -101,6 +102,8 @@ private:
     TupleDescriptor* _tuple_desc;
     std::map<std::string, SlotDescriptor*> _slots_map;
     std::vector<TScanRangeParams> _scan_ranges;
+    // index of the next range a scanner worker takes
+    std::atomic<int> _next_range_idx;
 
     std::mutex _batch_queue_lock;
     std::condition_variable _queue_reader_cond;
@@ -335,6 +335,7 @@ Status BrokerScanner::open_line_reader() {
                 _profile,
                 _cur_file_reader, _cur_decompressor,
                 size, _line_delimiter);
+        _cur_line_reader->set_field_delimiter(_value_separator);
         break;
     default: {
         std::stringstream ss;
@@ -370,14 +371,12 @@ void BrokerScanner::split_line(
         const Slice& line, std::vector<Slice>* values) {
     // line-begin char and line-end char are considered to be 'delimeter'
     const uint8_t* value = line.data();
-    const uint8_t* ptr = line.data();
-    for (size_t i = 0; i < line.size(); ++i, ++ptr) {
-        if (*ptr == _value_separator) {
-            values->emplace_back(value, ptr - value);
-            value = ptr + 1;
-        }
+    for (size_t pos : _cur_line_reader->field_positions()) {
+        const uint8_t* ptr = line.data() + pos;
+        values->emplace_back(value, ptr - value);
+        value = ptr + 1;
     }
-    values->emplace_back(value, ptr - value);
+    values->emplace_back(value, line.data() + line.size() - value);
 }
 
 void BrokerScanner::fill_fix_length_string(
@@ -540,6 +539,7 @@ bool BrokerScanner::convert_one_row(
 bool BrokerScanner::line_to_src_tuple(const Slice& line) {
     std::vector<Slice> values;
     {
+        values.reserve(_src_slot_descs.size());
         split_line(line, &values);
     }
 
@@ -34,7 +34,7 @@ class SlotDescriptor;
 class Slice;
 class TextConverter;
 class FileReader;
-class LineReader;
+class PlainTextLineReader;
 class Decompressor;
 class RuntimeState;
 class ExprContext;
@@ -80,7 +80,8 @@ private:
     // Read next buffer from reader
     Status open_next_reader();
 
-    // Split one text line to values
+    // Split one text line to values, at the field delimiters the line reader
+    // found while reading the line
     void split_line(
         const Slice& line, std::vector<Slice>* values);
 
@@ -123,7 +124,7 @@ private:
 
     // Reader
     FileReader* _cur_file_reader;
-    LineReader* _cur_line_reader;
+    PlainTextLineReader* _cur_line_reader;
     Decompressor* _cur_decompressor;
     int _next_range;
     bool _cur_line_reader_eof;
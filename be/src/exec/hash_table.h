@@ -132,6 +132,11 @@ public:
     // Returns HashTable::end() if there is no match.
     Iterator IR_ALWAYS_INLINE find(TupleRow* probe_row);
 
+    // Returns true if the next insert() grows the buckets.
+    bool insert_will_resize() const {
+        return _num_filled_buckets > _num_buckets_till_resize;
+    }
+
     // Returns number of elements in the hash table
     int64_t size() {
         return _num_nodes;
@@ -15,6 +15,7 @@
 
 #include "exec/olap_scan_node.h"
 
+#include <unistd.h>
 #include <algorithm>
 #include <boost/foreach.hpp>
 #include <sstream>
@@ -29,6 +30,7 @@
 #include "exprs/in_predicate.h"
 #include "gen_cpp/PlanNodes_types.h"
 #include "runtime/exec_env.h"
+#include "runtime/mem_tracker.h"
 #include "runtime/runtime_state.h"
 #include "runtime/row_batch.h"
 #include "runtime/string_value.h"
@@ -36,6 +38,8 @@
 #include "util/runtime_profile.h"
 #include "util/thread_pool.hpp"
 #include "util/debug_util.h"
+#include "util/stopwatch.hpp"
+#include "util/uid_util.h"
 #include "agent/cgroups_mgr.h"
 #include "common/resource_tls.h"
 #include "olap/olap_reader.h"
@@ -55,6 +59,10 @@ OlapScanNode::OlapScanNode(ObjectPool* pool, const TPlanNode& tnode, const Descr
         _tuple_idx(0),
         _eos(false),
         _scanner_pool(new ObjectPool()),
+        _materialized_row_batches(
+            new BoundedMpscQueue<RowBatch*>(config::palo_scanner_queue_size)),
+        _get_next_waiting(false),
+        _transfer_waiting(false),
         _max_materialized_row_batches(config::palo_scanner_queue_size),
         _start(false),
         _scanner_done(false),
@@ -63,6 +71,7 @@ OlapScanNode::OlapScanNode(ObjectPool* pool, const TPlanNode& tnode, const Descr
         _status(Status::OK),
         _resource_info(nullptr),
         _buffered_bytes(0),
+        _max_buffered_bytes(config::palo_scanner_queue_max_bytes),
         _running_thread(0),
         _eval_conjuncts_fn(nullptr) {
 }
@@ -134,6 +143,9 @@ void OlapScanNode::_init_counter(RuntimeState* state) {
     _index_load_timer = ADD_TIMER(_runtime_profile, "IndexLoadTime");
 
     _scan_timer = ADD_TIMER(_runtime_profile, "ScanTime");
+
+    _scanner_cpu_timer = ADD_TIMER(_runtime_profile, "ScannerCpuTime");
+    _scanner_sched_counter = ADD_COUNTER(_runtime_profile, "ScannerSchedCount", TUnit::UNIT);
 }
 
 Status OlapScanNode::prepare(RuntimeState* state) {
@@ -237,28 +249,34 @@ Status OlapScanNode::get_next(RuntimeState* state, RowBatch* row_batch, bool* eo
 
     // wait for batch from queue
     RowBatch* materialized_batch = NULL;
-    {
+    while (!_materialized_row_batches->try_pop(&materialized_batch)) {
         boost::unique_lock<boost::mutex> l(_row_batches_lock);
-
-        while (_materialized_row_batches.empty() && !_transfer_done) {
-            if (state->is_cancelled()) {
-                _transfer_done = true;
+        if (_transfer_done) {
+            // scanners push all their batches before the transfer thread finishes,
+            // so this is the last chance to get one
+            if (!_materialized_row_batches->try_pop(&materialized_batch)) {
+                materialized_batch = NULL;
             }
-
-            _row_batch_added_cv.timed_wait(l, _wait_duration);
+            break;
+        }
+        if (state->is_cancelled()) {
+            _transfer_done = true;
+            continue;
         }
 
-        if (!_materialized_row_batches.empty()) {
-            materialized_batch = dynamic_cast<RowBatch*>(_materialized_row_batches.front());
-            DCHECK(materialized_batch != NULL);
-            _materialized_row_batches.pop_front();
+        // Tell scanners to wake us up, then check the queue again, a batch may have
+        // been pushed before they could see the flag.
+        _get_next_waiting = true;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (_materialized_row_batches->empty()) {
+            _row_batch_added_cv.timed_wait(l, _wait_duration);
         }
+        _get_next_waiting = false;
     }
 
     // return batch
     if (NULL != materialized_batch) {
-        // notify scanner
-        _row_batch_consumed_cv.notify_one();
+        int64_t batch_bytes = materialized_batch->tuple_data_pool()->total_reserved_bytes();
         // get scanner's batch memory
         row_batch->acquire_state(materialized_batch);
         _num_rows_returned += row_batch->num_rows();
@@ -271,12 +289,8 @@ Status OlapScanNode::get_next(RuntimeState* state, RowBatch* row_batch, bool* eo
             _num_rows_returned -= num_rows_over;
             COUNTER_SET(_rows_returned_counter, _num_rows_returned);
 
-            {
-                boost::unique_lock<boost::mutex> l(_row_batches_lock);
-                _transfer_done = true;
-            }
+            _transfer_done = true;
 
-            _row_batch_consumed_cv.notify_all();
             *eos = true;
             LOG(INFO) << "OlapScanNode ReachedLimit.";
         } else {
@@ -290,8 +304,14 @@ Status OlapScanNode::get_next(RuntimeState* state, RowBatch* row_batch, bool* eo
                     << print_tuple(row->get_tuple(0), *_tuple_desc);
             }
         }
-        __sync_fetch_and_sub(&_buffered_bytes,
-                             row_batch->tuple_data_pool()->total_reserved_bytes());
+        __sync_fetch_and_sub(&_buffered_bytes, batch_bytes);
+        // transfer thread may wait for buffered bytes to drop, or for room in the
+        // queue, to schedule scanners
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (_transfer_waiting) {
+            boost::lock_guard<boost::mutex> l(_scan_batches_lock);
+            _scan_batch_added_cv.notify_one();
+        }
 
         delete materialized_batch;
         return Status::OK;
@@ -315,26 +335,23 @@ Status OlapScanNode::close(RuntimeState* state) {
         _transfer_done = true;
     }
     // notify all scanner thread
-    _row_batch_consumed_cv.notify_all();
     _row_batch_added_cv.notify_all();
-    _scan_batch_added_cv.notify_all();
+    {
+        // under the lock, so that the transfer thread either sees _transfer_done
+        // or is already waiting
+        boost::lock_guard<boost::mutex> l(_scan_batches_lock);
+        _scan_batch_added_cv.notify_all();
+    }
 
     // join transfer thread
     _transfer_thread.join_all();
 
-    // clear some row batch in queue
-    for (auto row_batch : _materialized_row_batches) {
-        delete row_batch;
-    }
-
-    _materialized_row_batches.clear();
-
-    for (auto row_batch : _scan_row_batches) {
+    // clear some row batch in queue, all scanners are finished now
+    RowBatch* row_batch = NULL;
+    while (_materialized_row_batches->try_pop(&row_batch)) {
         delete row_batch;
     }
 
-    _scan_row_batches.clear();
-
     // OlapScanNode terminate by exception
     // so that initiative close the Scanner
     for (auto scanner : _all_olap_scanners) {
@@ -1015,59 +1032,103 @@ void OlapScanNode::transfer_thread(RuntimeState* state) {
      * 4. 定期提高队列内残留任务的优先级，避免大查询完全饿死
      *********************************/
     PriorityThreadPool* thread_pool = state->exec_env()->thread_pool();
+    // All scanners of one query share a queue of the thread pool, so that a query
+    // with many scanners does not fill the queues other queries are served from.
+    int queue_id = hash_value(state->query_id());
     _total_assign_num = 0;
     _nice = 18 + std::max(0, 2 - (int)_olap_scanners.size() / 5);
     std::list<OlapScanner*> olap_scanners;
 
     int64_t mem_limit = 512 * 1024 * 1024;
-    // TODO(zc): use memory limit
-    int64_t mem_consume = __sync_fetch_and_add(&_buffered_bytes, 0);
     if (state->fragment_mem_tracker() != nullptr) {
         mem_limit = state->fragment_mem_tracker()->limit();
-        mem_consume = state->fragment_mem_tracker()->consumption();
     }
     int max_thread = _max_materialized_row_batches;
     if (config::palo_scanner_row_num > state->batch_size()) {
         max_thread /= config::palo_scanner_row_num / state->batch_size();
     }
-    // read from scanner
+
+    // How many scanners can be scheduled now. Must hold _scan_batches_lock.
+    // Batches may be small, so the queue can fill up well below the byte budget:
+    // every running scanner keeps a free slot of the queue for its next batch.
+    auto scanner_slot_num = [&] () -> size_t {
+        int64_t buffered_bytes = __sync_fetch_and_add(&_buffered_bytes, 0);
+        int64_t mem_consume = buffered_bytes;
+        if (state->fragment_mem_tracker() != nullptr) {
+            mem_consume = state->fragment_mem_tracker()->consumption();
+        }
+        int64_t free_queue_slots = (int64_t)_materialized_row_batches->capacity()
+                - (int64_t)_materialized_row_batches->size() - _running_thread;
+        size_t thread_slot_num = 0;
+        if (buffered_bytes < _max_buffered_bytes && mem_consume < (mem_limit * 6) / 10
+                && free_queue_slots > 0) {
+            thread_slot_num = std::max<int64_t>(
+                    0, std::min<int64_t>(max_thread - _running_thread, free_queue_slots));
+        } else if (_running_thread == 0 && _materialized_row_batches->empty()) {
+            // Memory already exceed, but no scanner is running and nothing is left
+            // in queue to be released, schedule one scanner to make progress
+            thread_slot_num = 1;
+        }
+        return std::min(thread_slot_num, _olap_scanners.size());
+    };
+
+    // schedule scanners until all of them are done
     while (LIKELY(status.ok())) {
-        int assigned_thread_num = 0;
-        // copy to local
         {
             boost::unique_lock<boost::mutex> l(_scan_batches_lock);
-            assigned_thread_num = _running_thread;
-            // int64_t buf_bytes = __sync_fetch_and_add(&_buffered_bytes, 0);
-            // How many thread can apply to this query
-            size_t thread_slot_num = 0;
-            mem_consume = __sync_fetch_and_add(&_buffered_bytes, 0);
-            if (state->fragment_mem_tracker() != nullptr) {
-                mem_consume = state->fragment_mem_tracker()->consumption();
+
+            // scanner_row_num = 16k
+            // 16k * 10 * 12 * 8 = 15M(>2s)  --> nice=10
+            // 16k * 20 * 22 * 8 = 55M(>6s)  --> nice=0
+            while (_nice > 0
+                       && _total_assign_num > (22 - _nice) * (20 - _nice) * 6) {
+                --_nice;
             }
-            if (mem_consume < (mem_limit * 6) / 10) {
-                thread_slot_num = max_thread - assigned_thread_num;
-            } else {
-                // Memory already exceed
-                if (_scan_row_batches.empty()) {
-                    // NOTE(zc): here need to lock row_batches_lock_
-                    //  be worried about dead lock, so don't check here
-                    // if (materialized_row_batches_.empty()) {
-                    //     LOG(FATAL) << "Scan_row_batches_ and materialized_row_batches_"
-                    //         " are empty when memory exceed";
-                    // }
-                    // Just for notify if scan_row_batches_ is empty and no running thread
-                    if (assigned_thread_num == 0) {
-                        thread_slot_num = 1;
-                        // NOTE: if olap_scanners_ is empty, scanner_done_ should be true
+
+            // wait until a scanner gives its thread back, or get_next releases
+            // buffered bytes, so that more scanners can be scheduled
+            size_t thread_slot_num = 0;
+            while (!_scanner_done) {
+                if (UNLIKELY(_transfer_done)) {
+                    // Nothing reads the batches any more: close the scanners which
+                    // are not running whatever the budget, and wait for the running
+                    // ones to give their threads back.
+                    while (!_olap_scanners.empty()) {
+                        OlapScanner* scanner = _olap_scanners.front();
+                        _olap_scanners.pop_front();
+                        scanner->close(_runtime_state);
+                        _progress.update(1);
+                        if (_progress.done()) {
+                            _scanner_done = true;
+                        }
                     }
+                    if (!_scanner_done) {
+                        _scan_batch_added_cv.wait(l);
+                    }
+                    continue;
                 }
+                thread_slot_num = scanner_slot_num();
+                if (thread_slot_num > 0) {
+                    break;
+                }
+                // Tell get_next to wake us up, then check again, it may have
+                // released bytes before it could see the flag.
+                _transfer_waiting = true;
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                thread_slot_num = scanner_slot_num();
+                if (thread_slot_num == 0) {
+                    _scan_batch_added_cv.wait(l);
+                }
+                _transfer_waiting = false;
             }
-            thread_slot_num = std::min(thread_slot_num, _olap_scanners.size());
+            if (_scanner_done) {
+                break;
+            }
+
             for (int i = 0; i < thread_slot_num; ++i) {
                 olap_scanners.push_back(_olap_scanners.front());
                 _olap_scanners.pop_front();
                 _running_thread++;
-                assigned_thread_num++;
             }
         }
 
@@ -1076,6 +1137,7 @@ void OlapScanNode::transfer_thread(RuntimeState* state) {
             PriorityThreadPool::Task task;
             task.work_function = boost::bind(&OlapScanNode::scanner_thread, this, *iter);
             task.priority = _nice;
+            task.queue_id = queue_id;
             if (thread_pool->offer(task)) {
                 olap_scanners.erase(iter++);
             } else {
@@ -1083,48 +1145,6 @@ void OlapScanNode::transfer_thread(RuntimeState* state) {
             }
             ++_total_assign_num;
         }
-
-        RowBatchInterface* scan_batch = NULL;
-        {
-            // 1 scanner idle task not empty, assign new sanner task
-            boost::unique_lock<boost::mutex> l(_scan_batches_lock);
-
-            // scanner_row_num = 16k
-            // 16k * 10 * 12 * 8 = 15M(>2s)  --> nice=10
-            // 16k * 20 * 22 * 8 = 55M(>6s)  --> nice=0
-            while (_nice > 0
-                       && _total_assign_num > (22 - _nice) * (20 - _nice) * 6) {
-                --_nice;
-            }
-
-            // 2 wait when all scanner are running & no result in queue
-            while (UNLIKELY(_running_thread == assigned_thread_num
-                            && _scan_row_batches.empty()
-                            && !_scanner_done)) {
-                _scan_batch_added_cv.wait(l);
-            }
-
-            // 3 transfer result row batch when queue is not empty
-            if (LIKELY(!_scan_row_batches.empty())) {
-                scan_batch = _scan_row_batches.front();
-                _scan_row_batches.pop_front();
-
-                // delete scan_batch if transfer thread should be stoped
-                // because scan_batch wouldn't be useful anymore
-                if (UNLIKELY(_transfer_done)) {
-                    delete scan_batch;
-                    scan_batch = NULL;
-                }
-            } else {
-                if (_scanner_done) {
-                    break;
-                }
-            }
-        }
-
-        if (NULL != scan_batch) {
-            add_one_batch(scan_batch);
-        }
     }
 
     VLOG(1) << "TransferThread finish.";
@@ -1134,6 +1154,8 @@ void OlapScanNode::transfer_thread(RuntimeState* state) {
 }
 
 void OlapScanNode::scanner_thread(OlapScanner* scanner) {
+    ThreadCpuStopWatch cpu_watch;
+    cpu_watch.start();
     Status status = Status::OK;
     bool eos = false;
     RuntimeState* state = scanner->runtime_state();
@@ -1153,17 +1175,35 @@ void OlapScanNode::scanner_thread(OlapScanner* scanner) {
         CgroupsMgr::apply_cgroup(_resource_info->user, _resource_info->group);
     }
 
-    std::vector<RowBatch*> row_batchs;
-
     // Because we use thread pool to scan data from storage. One scanner can't
     // use this thread too long, this can starve other query's scanner. So, we
     // need yield this thread when we do enough work. However, OlapStorage read
     // data in pre-aggregate mode, then we can't use storage returned data to
     // judge if we need to yield. So we record all raw data read in this round
-    // scan, if this exceed threshold, we yield this thread.
+    // scan, if this exceed threshold, we yield this thread. We also yield this
+    // thread when this round has run too long, e.g. because reads are slow.
     int64_t raw_rows_read = scanner->raw_rows_read();
     int64_t raw_rows_threshold = raw_rows_read + config::palo_scanner_row_num;
-    while (!eos && raw_rows_read < raw_rows_threshold) {
+    uint64_t max_run_time_ns = config::palo_scanner_max_run_time_ms * 1000L * 1000L;
+    MonotonicStopWatch run_watch;
+    run_watch.start();
+    // the scanners of a query share its mem trackers, so batch the consumption of
+    // this round instead of updating the trackers on every allocation
+    ScopedMemTrackerCache mem_tracker_cache;
+    // A scanner never waits for room in the queue, which would hold a thread of the
+    // shared pool: it keeps the batch and gives its thread back instead.
+    bool queue_full = false;
+    bool pending_eos = false;
+    RowBatch* pending_batch = scanner->release_pending_batch(&pending_eos);
+    if (pending_batch != NULL) {
+        eos = pending_eos;
+        if (!add_one_batch(pending_batch)) {
+            scanner->set_pending_batch(pending_batch, pending_eos);
+            queue_full = true;
+        }
+    }
+    while (!eos && !queue_full && raw_rows_read < raw_rows_threshold
+           && run_watch.elapsed_time() < max_run_time_ns) {
         if (UNLIKELY(_transfer_done)) {
             eos = true;
             status = Status::CANCELLED;
@@ -1185,14 +1225,20 @@ void OlapScanNode::scanner_thread(OlapScanner* scanner) {
             delete row_batch;
             row_batch = NULL;
         } else {
-            row_batchs.push_back(row_batch);
             __sync_fetch_and_add(&_buffered_bytes,
                                  row_batch->tuple_data_pool()->total_reserved_bytes());
+            // hand the batch to get_next right away
+            if (!add_one_batch(row_batch)) {
+                scanner->set_pending_batch(row_batch, eos);
+                queue_full = true;
+            }
         }
         raw_rows_read = scanner->raw_rows_read();
     }
+    mem_tracker_cache.flush();
+    COUNTER_UPDATE(_scanner_cpu_timer, cpu_watch.elapsed_time());
+    COUNTER_UPDATE(_scanner_sched_counter, 1);
 
-    boost::unique_lock<boost::mutex> l(_scan_batches_lock);
     // if we failed, check status.
     if (UNLIKELY(!status.ok())) {
         _transfer_done = true;
@@ -1209,16 +1255,13 @@ void OlapScanNode::scanner_thread(OlapScanner* scanner) {
     }
     if (UNLIKELY(!global_status_ok)) {
         eos = true;
-        for (auto rb : row_batchs) {
-            delete rb;
-        }
-    } else {
-        for (auto rb : row_batchs) {
-            _scan_row_batches.push_back(rb);
-        }
+        // the batch kept is dropped by close()
+        queue_full = false;
     }
+
+    boost::unique_lock<boost::mutex> l(_scan_batches_lock);
     // Scanner thread completed. Take a look and update the status
-    if (UNLIKELY(eos)) {
+    if (UNLIKELY(eos && !queue_full)) {
         _progress.update(1);
         if (_progress.done()) {
             // this is the right out
@@ -1232,22 +1275,20 @@ void OlapScanNode::scanner_thread(OlapScanner* scanner) {
     _scan_batch_added_cv.notify_one();
 }
 
-Status OlapScanNode::add_one_batch(RowBatchInterface* row_batch) {
-    {
-        boost::unique_lock<boost::mutex> l(_row_batches_lock);
-
-        while (UNLIKELY(_materialized_row_batches.size()
-                        >= _max_materialized_row_batches
-                        && !_transfer_done)) {
-            _row_batch_consumed_cv.wait(l);
-        }
+bool OlapScanNode::add_one_batch(RowBatch* row_batch) {
+    if (UNLIKELY(!_materialized_row_batches->try_push(row_batch))) {
+        // Queue is full, which only happens when get_next is much slower than
+        // scanners and batches are small.
+        return false;
+    }
 
-        VLOG(2) << "Push row_batch to materialized_row_batches";
-        _materialized_row_batches.push_back(row_batch);
+    // wake up get_next if it is waiting for batches
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_get_next_waiting) {
+        boost::lock_guard<boost::mutex> l(_row_batches_lock);
+        _row_batch_added_cv.notify_one();
     }
-    // remove one batch, notify main thread
-    _row_batch_added_cv.notify_one();
-    return Status::OK;
+    return true;
 }
 
 void OlapScanNode::debug_string(
@@ -23,6 +23,7 @@
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/recursive_mutex.hpp>
 #include <boost/thread/thread.hpp>
+#include <atomic>
 #include <queue>
 
 #include "exec/olap_common.h"
@@ -32,6 +33,7 @@
 #include "runtime/descriptors.h"
 #include "runtime/row_batch_interface.hpp"
 #include "runtime/vectorized_row_batch.h"
+#include "util/bounded_mpsc_queue.hpp"
 #include "util/progress_updater.h"
 #include "util/debug_util.h"
 
@@ -155,7 +157,8 @@ protected:
     //void vectorized_scanner_thread(OlapScanner* scanner);
     void scanner_thread(OlapScanner* scanner);
 
-    Status add_one_batch(RowBatchInterface* row_batch);
+    // Queues a batch for get_next, returns false if the queue is full.
+    bool add_one_batch(RowBatch* row_batch);
 
     // Write debug string of this into out.
     virtual void debug_string(int indentation_level, std::stringstream* out) const;
@@ -206,24 +209,31 @@ private:
     // Keeps track of total splits and the number finished.
     ProgressUpdater _progress;
 
-    // Lock and condition variables protecting _materialized_row_batches.  Row batches are
-    // produced asynchronously by the scanner threads and consumed by the main thread in
-    // GetNext.  Row batches must be processed by the main thread in the order they are
-    // queued to avoid freeing attached resources prematurely (row batches will never depend
-    // on resources attached to earlier batches in the queue).
+    // Row batches produced by the scanner threads, consumed by the main thread in
+    // get_next. Scanner threads push their batches straight into this lock-free queue,
+    // the transfer thread only schedules scanners. Row batches must be processed by
+    // the main thread in the order they are queued to avoid freeing attached resources
+    // prematurely (row batches will never depend on resources attached to earlier
+    // batches in the queue).
+    boost::scoped_ptr<BoundedMpscQueue<RowBatch*> > _materialized_row_batches;
+    // _row_batches_lock and _row_batch_added_cv are only used by get_next to sleep
+    // while the queue is empty. Scanner threads take the lock to wake it up only if
+    // _get_next_waiting is set. Scanners never wait while the queue is full, they
+    // give their thread back and are scheduled again once get_next made room.
     // This lock cannot be taken together with any other locks except _lock.
     boost::mutex _row_batches_lock;
     boost::condition_variable _row_batch_added_cv;
-    boost::condition_variable _row_batch_consumed_cv;
-
-    std::list<RowBatchInterface*> _materialized_row_batches;
+    std::atomic<bool> _get_next_waiting;
 
+    // Protects the scanner scheduling state: _olap_scanners, _running_thread and
+    // _scanner_done. _scan_batch_added_cv wakes up the transfer thread when a scanner
+    // gives its thread back, or, if _transfer_waiting is set, when get_next consumed
+    // a batch and released buffered bytes.
     boost::mutex _scan_batches_lock;
     boost::condition_variable _scan_batch_added_cv;
+    std::atomic<bool> _transfer_waiting;
     int32_t _scanner_task_finish_count;
 
-    std::list<RowBatchInterface*> _scan_row_batches;
-
     std::list<OlapScanner*> _all_olap_scanners;
     std::list<OlapScanner*> _olap_scanners;
 
@@ -247,7 +257,10 @@ private:
 
     TResourceInfo* _resource_info;
 
+    // bytes of row batches produced by scanners but not yet returned by get_next,
+    // no new scanner is scheduled while this exceeds _max_buffered_bytes
     int64_t _buffered_bytes;
+    int64_t _max_buffered_bytes;
     int64_t _running_thread;
     EvalConjunctsFn _eval_conjuncts_fn;
 
@@ -269,6 +282,11 @@ private:
     RuntimeProfile::Counter* _block_fetch_timer = nullptr;
 
     RuntimeProfile::Counter* _index_load_timer = nullptr;
+
+    // CPU time consumed by all scanners of this node, and how many times they were
+    // scheduled on the scanner thread pool
+    RuntimeProfile::Counter* _scanner_cpu_timer = nullptr;
+    RuntimeProfile::Counter* _scanner_sched_counter = nullptr;
 };
 
 } // namespace palo
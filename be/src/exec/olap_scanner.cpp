@@ -84,6 +84,7 @@ Status OlapScanner::_prepare(
                              tablet_id, schema_hash);
             return Status("table does not exists");
         }
+        _olap_table->record_scan();
         {
             AutoRWLock auto_lock(_olap_table->get_header_lock_ptr(), true);
             const FileVersionMessage* message = _olap_table->latest_version();
@@ -451,6 +452,9 @@ Status OlapScanner::close(RuntimeState* state) {
     }
     update_counter();
     _reader.reset();
+    // the query is done, nothing reads the batch any more
+    delete _pending_batch;
+    _pending_batch = nullptr;
     Expr::close(_conjunct_ctxs, state);
     _is_closed = true;
     return Status::OK;
@@ -77,6 +77,19 @@ public:
 
     int64_t raw_rows_read() const { return _reader->stats().raw_rows_read; }
 
+    // The batch read last but not queued yet because the queue of the scan node was
+    // full, queued first when the scanner runs again. 'eos' if it is the last one.
+    void set_pending_batch(RowBatch* batch, bool eos) {
+        _pending_batch = batch;
+        _pending_eos = eos;
+    }
+    RowBatch* release_pending_batch(bool* eos) {
+        RowBatch* batch = _pending_batch;
+        _pending_batch = nullptr;
+        *eos = _pending_eos;
+        return batch;
+    }
+
     void update_counter();
 private:
     Status _prepare(
@@ -135,6 +148,9 @@ private:
     // number rows filtered by pushed condition
     int64_t _num_rows_pushed_cond_filtered = 0;
 
+    RowBatch* _pending_batch = nullptr;
+    bool _pending_eos = false;
+
     bool _is_closed = false;
 };
 
@@ -23,6 +23,7 @@
 #include "common/status.h"
 #include "exec/file_reader.h"
 #include "exec/decompressor.h"
+#include "util/delimiter_scanner.h"
 
 // INPUT_CHUNK must
 //  larger than 15B for correct lz4 file decompressing
@@ -46,6 +47,7 @@ PlainTextLineReader::PlainTextLineReader(
             _min_length(length),
             _total_read_bytes(0),
             _line_delimiter(line_delimiter),
+            _field_delimiter(line_delimiter),
             _input_buf(new uint8_t[INPUT_CHUNK]),
             _input_buf_size(INPUT_CHUNK),
             _input_buf_pos(0),
@@ -54,6 +56,8 @@ PlainTextLineReader::PlainTextLineReader(
             _output_buf_size(OUTPUT_CHUNK),
             _output_buf_pos(0),
             _output_buf_limit(0),
+            _delimiter_idx(0),
+            _indexed_limit(0),
             _file_eof(false),
             _eof(false),
             _stream_end(false),
@@ -97,8 +101,38 @@ inline bool PlainTextLineReader::update_eof() {
 
 uint8_t* PlainTextLineReader::update_field_pos_and_find_line_delimiter(
         const uint8_t* start, size_t len) {
-    // TODO: meanwhile find and save field pos
-    return (uint8_t*) memmem(start, len, &_line_delimiter, 1);
+    // index all delimiters of the data not indexed yet in one pass
+    size_t end = start + len - _output_buf;
+    if (end > _indexed_limit) {
+        if (_delimiter_idx == _delimiter_pos.size()) {
+            _delimiter_pos.clear();
+            _delimiter_idx = 0;
+        }
+        DelimiterScanner::find_all(_output_buf,
+                                   std::max<size_t>(_indexed_limit, start - _output_buf),
+                                   end, _field_delimiter, _line_delimiter, &_delimiter_pos);
+        _indexed_limit = end;
+    }
+
+    while (_delimiter_idx < _delimiter_pos.size()) {
+        size_t pos = _delimiter_pos[_delimiter_idx];
+        if (pos >= end) {
+            break;
+        }
+        ++_delimiter_idx;
+        if (_output_buf[pos] == _line_delimiter) {
+            return _output_buf + pos;
+        }
+        _field_positions.push_back(pos - _output_buf_pos);
+    }
+    return nullptr;
+}
+
+void PlainTextLineReader::shift_delimiter_pos(size_t shift) {
+    for (size_t i = _delimiter_idx; i < _delimiter_pos.size(); ++i) {
+        _delimiter_pos[i] -= shift;
+    }
+    _indexed_limit -= shift;
 }
 
 // extend input buf if necessary only when _more_input_bytes > 0
@@ -160,6 +194,7 @@ void PlainTextLineReader::extend_output_buf() {
         if (capacity >= target) {
             // move the read remainings to the begining of the current output buf,
             memmove(_output_buf, _output_buf + _output_buf_pos, output_buf_read_remaining());
+            shift_delimiter_pos(_output_buf_pos);
             _output_buf_limit -= _output_buf_pos;
             _output_buf_pos = 0;
             break;
@@ -175,6 +210,7 @@ void PlainTextLineReader::extend_output_buf() {
         delete[] _output_buf;
 
         _output_buf = new_output_buf;
+        shift_delimiter_pos(_output_buf_pos);
         _output_buf_limit -= _output_buf_pos;
         _output_buf_pos = 0;
     } while (false);
@@ -186,6 +222,7 @@ void PlainTextLineReader::extend_output_buf() {
 }
 
 Status PlainTextLineReader::read_line(const uint8_t** ptr, size_t* size, bool* eof) {
+    _field_positions.clear();
     if (_eof || update_eof()) {
         *size = 0;
         *eof = true;
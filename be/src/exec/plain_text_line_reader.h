@@ -20,6 +20,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include "exec/line_reader.h"
 #include "util/runtime_profile.h"
 
@@ -41,6 +43,18 @@ public:
 
     virtual void close() override;
 
+    // Also find the field delimiters of each line while looking for its end,
+    // in the same pass over the data.
+    void set_field_delimiter(uint8_t field_delimiter) {
+        _field_delimiter = field_delimiter;
+    }
+
+    // Offsets in the line last returned by read_line() of its field delimiters,
+    // if a field delimiter is set.
+    const std::vector<size_t>& field_positions() const {
+        return _field_positions;
+    }
+
 private:
     bool update_eof();
 
@@ -58,10 +72,12 @@ private:
 
     // find line delimiter from 'start' to 'start' + len,
     // return line delimiter pos if found, otherwise return nullptr.
-    // TODO:
-    //  save to positions of field separator
+    // the field delimiters before it are saved to _field_positions.
     uint8_t* update_field_pos_and_find_line_delimiter(const uint8_t* start, size_t len);
 
+    // the data in output buf is moved 'shift' bytes to the front
+    void shift_delimiter_pos(size_t shift);
+
     void extend_input_buf();
     void extend_output_buf();
 
@@ -72,6 +88,8 @@ private:
     size_t _min_length;
     size_t _total_read_bytes;
     uint8_t _line_delimiter;
+    // same as _line_delimiter if field delimiters are not wanted
+    uint8_t _field_delimiter;
 
     // save the data read from file reader
     uint8_t* _input_buf;
@@ -85,6 +103,14 @@ private:
     size_t _output_buf_pos;
     size_t _output_buf_limit;
 
+    // offsets in output buf of the delimiters in [_output_buf_pos, _indexed_limit),
+    // the ones before _delimiter_idx have been consumed.
+    std::vector<size_t> _delimiter_pos;
+    size_t _delimiter_idx;
+    size_t _indexed_limit;
+    // offsets in current line of its field delimiters
+    std::vector<size_t> _field_positions;
+
     bool _file_eof;
     bool _eof;
     bool _stream_end;
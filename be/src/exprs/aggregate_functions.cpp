@@ -28,8 +28,11 @@
 #include "runtime/string_value.h"
 #include "runtime/datetime_value.h"
 #include "exprs/anyval_util.h"
+#include "exprs/flat_hash_set.h"
 #include "exprs/hybird_set.h"
 #include "util/debug_util.h"
+#include "util/roaring_bitmap.h"
+#include "util/tdigest.h"
 
 // TODO: this file should be cross compiled and then all of the builtin
 // aggregate functions will have a codegen enabled path. Then we can remove
@@ -56,6 +59,16 @@ static const StringVal DEFAULT_STRING_CONCAT_DELIM((uint8_t*)", ", 2);
 // much when between [6,12]
 const int HLL_PRECISION = 14;
 const int HLL_SETS_BYTES_NUM = 16384;
+
+// 2^-value for every possible value of a hll register
+struct HllInversePowerTable {
+    HllInversePowerTable() {
+        for (int i = 0; i < 256; ++i) {
+            values[i] = ldexp(1.0, -i);
+        }
+    }
+    double values[256];
+};
     
 void AggregateFunctions::init_null(FunctionContext*, AnyVal* dst) {
     dst->is_null = true;
@@ -927,9 +940,7 @@ void AggregateFunctions::hll_merge(FunctionContext* ctx, const StringVal& src,
     DCHECK_EQ(dst->len, std::pow(2, HLL_PRECISION));
     DCHECK_EQ(src.len, std::pow(2, HLL_PRECISION));
 
-    for (int i = 0; i < src.len; ++i) {
-        dst->ptr[i] = std::max(dst->ptr[i], src.ptr[i]);
-    }
+    HllSetHelper::merge_registers(dst->ptr, src.ptr, src.len);
 }
 
 StringVal AggregateFunctions::hll_finalize(FunctionContext* ctx, const StringVal& src) {
@@ -953,32 +964,8 @@ void AggregateFunctions::hll_union_agg_init(FunctionContext* ctx, StringVal* dst
 }
 
 void AggregateFunctions::hll_union_parse_and_cal(HllSetResolver& resolver, StringVal* dst) {
-    
-    if (resolver.get_hll_data_type() == HLL_DATA_EMPTY) {    
-        return;
-    }    
-    if (resolver.get_hll_data_type() == HLL_DATA_EXPLICIT) {
-        for (int i = 0; i < resolver.get_expliclit_count(); i++) {
-            uint64_t hash_value = resolver.get_expliclit_value(i);
-            int idx = hash_value % dst->len;
-            uint8_t first_one_bit = __builtin_ctzl(hash_value >> HLL_PRECISION) + 1; 
-            dst->ptr[idx] = std::max(dst->ptr[idx], first_one_bit);
-        }    
-    } else if (resolver.get_hll_data_type() == HLL_DATA_SPRASE) {
-        std::map<HllSetResolver::SparseIndexType, HllSetResolver::SparseValueType>& 
-                                            sparse_map = resolver.get_sparse_map();
-        for (std::map<HllSetResolver::SparseIndexType, 
-             HllSetResolver::SparseValueType>::iterator iter = sparse_map.begin(); 
-                                    iter != sparse_map.end(); iter++) {
-            dst->ptr[iter->first] = std::max(dst->ptr[iter->first], (uint8_t)iter->second);
-        }  
-    } else if (resolver.get_hll_data_type() == HLL_DATA_FULL) {
-        char* full_value = resolver.get_full_value();
-        for (int i = 0; i < HLL_SETS_BYTES_NUM; i++) {
-            dst->ptr[i] = std::max(dst->ptr[i], (uint8_t)full_value[i]);
-        }
-    }
-    return ;
+    // merges straight from the stored set into the registers of the state
+    resolver.fill_registers((char*)dst->ptr, dst->len);
 }
 
 void AggregateFunctions::hll_union_agg_update(FunctionContext* ctx, 
@@ -1002,10 +989,8 @@ void AggregateFunctions::hll_union_agg_merge(FunctionContext* ctx, const StringV
     DCHECK(!src.is_null);
     DCHECK_EQ(dst->len, HLL_SETS_BYTES_NUM);
     DCHECK_EQ(src.len, HLL_SETS_BYTES_NUM);
-     
-    for (int i = 0; i < src.len; ++i) {
-        dst->ptr[i] = std::max(dst->ptr[i], src.ptr[i]);
-    }
+
+    HllSetHelper::merge_registers(dst->ptr, src.ptr, src.len);
 }
 
 palo_udf::StringVal AggregateFunctions::hll_union_agg_finalize(palo_udf::FunctionContext* ctx, 
@@ -1037,18 +1022,32 @@ int64_t AggregateFunctions::hll_algorithm(const palo_udf::StringVal& src) {
         alpha = 0.7213f / (1 + 1.079f / num_streams);
     }
     
-    float harmonic_mean = 0;
-    int num_zero_registers = 0;
-    
-    for (int i = 0; i < src.len; ++i) {
-        harmonic_mean += powf(2.0f, -src.ptr[i]);
-        
-        if (src.ptr[i] == 0) {
-            ++num_zero_registers;
-        }
-    }
-    
-    harmonic_mean = 1.0f / harmonic_mean;
+    // Count the registers per value, in 4 histograms so that runs of equal values do
+    // not serialize on one counter, then sum 2^-value over the 256 possible values.
+    static const HllInversePowerTable inverse_powers;
+    int32_t histograms[4][256];
+    memset(histograms, 0, sizeof(histograms));
+    int i = 0;
+    for (; i + 4 <= src.len; i += 4) {
+        ++histograms[0][src.ptr[i]];
+        ++histograms[1][src.ptr[i + 1]];
+        ++histograms[2][src.ptr[i + 2]];
+        ++histograms[3][src.ptr[i + 3]];
+    }
+    for (; i < src.len; ++i) {
+        ++histograms[0][src.ptr[i]];
+    }
+
+    double harmonic_mean = 0;
+    for (int value = 0; value < 256; ++value) {
+        int32_t count = histograms[0][value] + histograms[1][value]
+                + histograms[2][value] + histograms[3][value];
+        harmonic_mean += count * inverse_powers.values[value];
+    }
+    int num_zero_registers = histograms[0][0] + histograms[1][0]
+            + histograms[2][0] + histograms[3][0];
+
+    harmonic_mean = 1.0 / harmonic_mean;
     double estimate = alpha * num_streams * num_streams * harmonic_mean;
     double tmp = 0.f;
     // according to HerperLogLog current correction, if E is cardinal
@@ -1072,17 +1071,162 @@ int64_t AggregateFunctions::hll_algorithm(const palo_udf::StringVal& src) {
     return (int64_t)(estimate + 0.5);
 }
 
-// TODO chenhao , reduce memory copy
+void AggregateFunctions::bitmap_union_init(FunctionContext* ctx, StringVal* dst) {
+    dst->is_null = false;
+    dst->len = sizeof(RoaringBitmap);
+    dst->ptr = ctx->allocate(sizeof(RoaringBitmap));
+    new (dst->ptr) RoaringBitmap();
+}
+
+void AggregateFunctions::bitmap_union_update(FunctionContext* ctx, const StringVal& src,
+                                             StringVal* dst) {
+    if (src.is_null) {
+        return;
+    }
+    DCHECK(!dst->is_null);
+    RoaringBitmap* bitmap = reinterpret_cast<RoaringBitmap*>(dst->ptr);
+    if (!bitmap->merge(reinterpret_cast<const char*>(src.ptr), src.len)) {
+        ctx->set_error("bitmap_union(): invalid bitmap value");
+    }
+}
+
+void AggregateFunctions::bitmap_union_merge(FunctionContext* ctx, const StringVal& src,
+                                            StringVal* dst) {
+    // the intermediate value is serialized like the values of a bitmap column
+    bitmap_union_update(ctx, src, dst);
+}
+
+StringVal AggregateFunctions::bitmap_union_serialize(FunctionContext* ctx,
+                                                     const StringVal& src) {
+    DCHECK(!src.is_null);
+    RoaringBitmap* bitmap = reinterpret_cast<RoaringBitmap*>(src.ptr);
+    StringVal result(ctx, bitmap->serialized_size());
+    bitmap->serialize(reinterpret_cast<char*>(result.ptr));
+    bitmap->~RoaringBitmap();
+    ctx->free(src.ptr);
+    return result;
+}
+
+BigIntVal AggregateFunctions::bitmap_union_count_finalize(FunctionContext* ctx,
+                                                          const StringVal& src) {
+    DCHECK(!src.is_null);
+    RoaringBitmap* bitmap = reinterpret_cast<RoaringBitmap*>(src.ptr);
+    BigIntVal result(bitmap->cardinality());
+    bitmap->~RoaringBitmap();
+    ctx->free(src.ptr);
+    return result;
+}
+
+struct PercentileApproxState {
+    PercentileApproxState() : quantile(-1) { }
+
+    // set by the first row, -1 until then
+    double quantile;
+    TDigest digest;
+};
+
+static bool set_percentile_quantile(FunctionContext* ctx, const DoubleVal& quantile,
+                                    PercentileApproxState* state) {
+    if (quantile.is_null || !(quantile.val >= 0 && quantile.val <= 1)) {
+        ctx->set_error("percentile_approx(): the quantile must be between 0 and 1");
+        return false;
+    }
+    state->quantile = quantile.val;
+    return true;
+}
+
+void AggregateFunctions::percentile_approx_init(FunctionContext* ctx, StringVal* dst) {
+    dst->is_null = false;
+    dst->len = sizeof(PercentileApproxState);
+    dst->ptr = ctx->allocate(sizeof(PercentileApproxState));
+    new (dst->ptr) PercentileApproxState();
+}
+
+void AggregateFunctions::percentile_approx_update(FunctionContext* ctx, const DoubleVal& src,
+                                                  const DoubleVal& quantile, StringVal* dst) {
+    if (src.is_null) {
+        return;
+    }
+    DCHECK(!dst->is_null);
+    PercentileApproxState* state = reinterpret_cast<PercentileApproxState*>(dst->ptr);
+    if (state->quantile < 0 && !set_percentile_quantile(ctx, quantile, state)) {
+        return;
+    }
+    state->digest.add(src.val);
+}
+
+void AggregateFunctions::percentile_union_update(FunctionContext* ctx, const StringVal& src,
+                                                 const DoubleVal& quantile, StringVal* dst) {
+    if (src.is_null) {
+        return;
+    }
+    DCHECK(!dst->is_null);
+    PercentileApproxState* state = reinterpret_cast<PercentileApproxState*>(dst->ptr);
+    if (state->quantile < 0 && !set_percentile_quantile(ctx, quantile, state)) {
+        return;
+    }
+    if (!state->digest.merge(reinterpret_cast<const char*>(src.ptr), src.len)) {
+        ctx->set_error("percentile_union(): invalid quantile state value");
+    }
+}
+
+void AggregateFunctions::percentile_approx_merge(FunctionContext* ctx, const StringVal& src,
+                                                 StringVal* dst) {
+    DCHECK(!dst->is_null);
+    DCHECK(!src.is_null);
+    DCHECK_GE(src.len, sizeof(double));
+    PercentileApproxState* state = reinterpret_cast<PercentileApproxState*>(dst->ptr);
+    double quantile = 0;
+    memcpy(&quantile, src.ptr, sizeof(double));
+    // the serialized state of a group without rows has no quantile
+    if (quantile >= 0) {
+        state->quantile = quantile;
+    }
+    if (!state->digest.merge(reinterpret_cast<const char*>(src.ptr) + sizeof(double),
+                             src.len - sizeof(double))) {
+        ctx->set_error("percentile_approx(): invalid intermediate value");
+    }
+}
+
+StringVal AggregateFunctions::percentile_approx_serialize(FunctionContext* ctx,
+                                                          const StringVal& src) {
+    DCHECK(!src.is_null);
+    PercentileApproxState* state = reinterpret_cast<PercentileApproxState*>(src.ptr);
+    StringVal result(ctx, sizeof(double) + state->digest.serialized_size());
+    memcpy(result.ptr, &state->quantile, sizeof(double));
+    state->digest.serialize(reinterpret_cast<char*>(result.ptr) + sizeof(double));
+    state->~PercentileApproxState();
+    ctx->free(src.ptr);
+    return result;
+}
+
+DoubleVal AggregateFunctions::percentile_approx_finalize(FunctionContext* ctx,
+                                                         const StringVal& src) {
+    DCHECK(!src.is_null);
+    PercentileApproxState* state = reinterpret_cast<PercentileApproxState*>(src.ptr);
+    DoubleVal result = DoubleVal::null();
+    if (!state->digest.empty()) {
+        result = DoubleVal(state->digest.quantile(state->quantile));
+    }
+    state->~PercentileApproxState();
+    ctx->free(src.ptr);
+    return result;
+}
+
 // multi distinct state for numertic
 // serialize order type:value:value:value ...
+// The values are kept in a FlatHashSet, whose memory comes from the FunctionContext,
+// the state itself is allocated from the FunctionContext as well.
 template <typename T>
 class MultiDistinctNumericState {
 public:
+    typedef decltype(((T*)0)->val) ValueType;
 
-    static void create(StringVal* dst) {
+    static void create(FunctionContext* ctx, StringVal* dst) {
         dst->is_null = false;
         const int state_size = sizeof(MultiDistinctNumericState<T>);
-        MultiDistinctNumericState<T>* state = new MultiDistinctNumericState<T>();
+        MultiDistinctNumericState<T>* state =
+            new (ctx->allocate(state_size)) MultiDistinctNumericState<T>();
         if (std::is_same<T, TinyIntVal>::value) {
             state->_type = FunctionContext::TYPE_TINYINT;
         } else if (std::is_same<T, SmallIntVal>::value) {
@@ -1104,53 +1248,54 @@ public:
         dst->ptr = (uint8_t*)state;
     }
 
-    static void destory(const StringVal& dst) {
-        delete (MultiDistinctNumericState<T>*)dst.ptr;
+    static void destory(FunctionContext* ctx, const StringVal& dst) {
+        MultiDistinctNumericState<T>* state = (MultiDistinctNumericState<T>*)dst.ptr;
+        state->_set.release(ctx);
+        ctx->free(dst.ptr);
     }
 
-    void update(T& t) {
-        _set.insert(t);
+    void update(FunctionContext* ctx, T& t) {
+        ValueType value = t.val;
+        // the set compares values bit by bit, -0.0 and 0.0 must be the same value
+        if (value == 0) {
+            value = 0;
+        }
+        _set.insert(ctx, value);
     }
 
     // type:one byte  value:sizeof(T)
     StringVal serialize(FunctionContext* ctx) {
-        size_t type_size = sizeof(((T*)0)->val);
-        const size_t serialized_set_length = sizeof(uint8_t) + type_size * _set.size();
+        const size_t serialized_set_length = sizeof(uint8_t) + sizeof(ValueType) * _set.size();
         StringVal result(ctx, serialized_set_length);
         uint8_t* type_writer = result.ptr;
         // type
         *type_writer = (uint8_t)_type;
         type_writer++;
         // value
-        for (auto& value : _set) {
-            memcpy(type_writer, &value.val, type_size);
-            type_writer += type_size;
-        }
+        _set.copy_to(type_writer);
         return result;
     }
 
-    void unserialize(StringVal& src) {
-        size_t type_size = sizeof(((T*)0)->val);
+    // Adds the values of a state serialized by serialize() to this state, reading
+    // them directly from 'src'.
+    void merge(FunctionContext* ctx, const StringVal& src) {
         const uint8_t* type_reader = src.ptr;
         const uint8_t* end = src.ptr + src.len;
         // type
-        _type = (FunctionContext::Type)*type_reader;
+        DCHECK_EQ((FunctionContext::Type)*type_reader, _type);
         type_reader++;
+        // the merged set holds at least as many values as the bigger input, grow
+        // the table once instead of doubling it step by step
+        _set.reserve(ctx, std::max<int64_t>(_set.size(), (end - type_reader) / sizeof(ValueType)));
         // value
         while (type_reader < end) {
-            T value;
-            value.is_null = false;
-            memcpy(&value.val, type_reader, type_size);
-            _set.insert(value);
-            type_reader += type_size;
+            ValueType value;
+            memcpy(&value, type_reader, sizeof(ValueType));
+            _set.insert(ctx, value);
+            type_reader += sizeof(ValueType);
         }
     }
 
-    // merge set
-    void merge(MultiDistinctNumericState& state) {
-        _set.insert(state._set.begin(), state._set.end());
-    }
-
     // count
     BigIntVal count_finalize() {
         return BigIntVal(_set.size());
@@ -1159,27 +1304,21 @@ public:
     // sum for double, decimal
     DoubleVal sum_finalize_double() {
         double sum = 0;
-        for (auto& value : _set) {
-            sum += value.val;
-        }
+        _set.for_each([&sum](const ValueType& value) { sum += value; });
         return DoubleVal(sum);
     }
 
     // sum for largeint 
     LargeIntVal sum_finalize_largeint() {
         __int128 sum = 0;
-        for (auto& value : _set) {
-            sum += value.val;
-        }
+        _set.for_each([&sum](const ValueType& value) { sum += value; });
         return LargeIntVal(sum);
     }
 
     // sum for tinyint, smallint, int, bigint
     BigIntVal sum_finalize_bigint() {
         int64_t sum = 0;
-        for (auto& value : _set) {
-            sum += value.val;
-        }
+        _set.for_each([&sum](const ValueType& value) { sum += value; });
         return BigIntVal(sum);
     }
 
@@ -1189,18 +1328,7 @@ public:
 
 private:
 
-    class NumericHashHelper {   
-    public:
-        size_t operator()(const T& obj) const {
-            size_t result = AnyValUtil::hash64_murmur(obj, HashUtil::MURMUR_SEED);   
-            return result;
-        }
-    };
-
-    std::unordered_set<T, NumericHashHelper> _set;
-    // Because Anyval does not provide the hash function, in order 
-    // to adopt the type different from the template, the pointer is used
-    // HybirdSetBase* _set;
+    FlatHashSet<ValueType> _set;
     // _type is serialized into buffer by one byte
     FunctionContext::Type _type;
 };
@@ -1406,69 +1534,60 @@ private:
 class MultiDistinctCountDateState {
 public:
     
-    static void create(StringVal* dst) {
+    static void create(FunctionContext* ctx, StringVal* dst) {
         dst->is_null = false;
         const int state_size = sizeof(MultiDistinctCountDateState);
-        MultiDistinctCountDateState* state = new MultiDistinctCountDateState();
+        MultiDistinctCountDateState* state =
+            new (ctx->allocate(state_size)) MultiDistinctCountDateState();
         state->_type = FunctionContext::TYPE_DATETIME;
         dst->len = state_size;
         dst->ptr = (uint8_t*)state;
     }
     
-    static void destory(const StringVal& dst) {
-        delete (MultiDistinctCountDateState*)dst.ptr;
+    static void destory(FunctionContext* ctx, const StringVal& dst) {
+        MultiDistinctCountDateState* state = (MultiDistinctCountDateState*)dst.ptr;
+        state->_set.release(ctx);
+        ctx->free(dst.ptr);
     }
     
-    void update(DateTimeVal& t) {
-        _set.insert(t);
+    void update(FunctionContext* ctx, DateTimeVal& t) {
+        PackedDateTime value;
+        value.packed_time = t.packed_time;
+        value.type = t.type;
+        _set.insert(ctx, value);
     }
     
-    // type:one byte  value:sizeof(T)
+    // type:one byte  value:sizeof(PackedDateTime)
     StringVal serialize(FunctionContext* ctx) {
-        const int serialized_set_length = sizeof(uint8_t) + 
-                   (DATETIME_PACKED_TIME_BYTE_SIZE + DATETIME_TYPE_BYTE_SIZE) * _set.size();
+        const int serialized_set_length = sizeof(uint8_t) + sizeof(PackedDateTime) * _set.size();
         StringVal result(ctx, serialized_set_length);
         uint8_t* writer = result.ptr;
         // type
         *writer = (uint8_t)_type;
         writer++;
         // value
-        for (auto& value : _set) {
-            int64_t* packed_time_writer = (int64_t*)writer;
-            *packed_time_writer = value.packed_time;
-            writer += DATETIME_PACKED_TIME_BYTE_SIZE;
-            int* type_writer = (int*)writer;
-            *type_writer = value.type;
-            writer += DATETIME_TYPE_BYTE_SIZE;
-        }
+        _set.copy_to(writer);
         return result;
     }
     
-    void unserialize(StringVal& src) {
+    // Adds the values of a state serialized by serialize() to this state, reading
+    // them directly from 'src'.
+    void merge(FunctionContext* ctx, const StringVal& src) {
         const uint8_t* reader = src.ptr;
+        const uint8_t* end = src.ptr + src.len;
         // type
-        _type = (FunctionContext::Type)*reader;
+        DCHECK_EQ((FunctionContext::Type)*reader, _type);
         reader++;
-        const uint8_t* end = src.ptr + src.len;
+        _set.reserve(ctx, std::max<int64_t>(_set.size(), (end - reader) / sizeof(PackedDateTime)));
         // value
         while (reader < end) {
-            DateTimeVal value;
-            value.is_null = false;
-            int64_t* packed_time_reader = (int64_t*)reader;
-            value.packed_time = *packed_time_reader;
-            reader += DATETIME_PACKED_TIME_BYTE_SIZE;
-            int* type_reader = (int*)reader;
-            value.type = *type_reader;
-            reader += DATETIME_TYPE_BYTE_SIZE;
-            _set.insert(value);
+            PackedDateTime value;
+            memcpy(&value, reader, sizeof(PackedDateTime));
+            _set.insert(ctx, value);
+            reader += sizeof(PackedDateTime);
         }
     }
     
-    // merge set
-    void merge(MultiDistinctCountDateState& state) {
-        _set.insert(state._set.begin(), state._set.end());
-    }
-    
     // count
     BigIntVal count_finalize() {
         return BigIntVal(_set.size());
@@ -1479,25 +1598,20 @@ public:
     }
  
 private:
-   
-    class DateTimeHashHelper {    
-    public:
-        size_t operator()(const DateTimeVal& obj) const {
-            size_t result = AnyValUtil::hash64_murmur(obj, HashUtil::MURMUR_SEED);   
-            return result;
-        }
-    }; 
- 
-    const int DATETIME_PACKED_TIME_BYTE_SIZE = 8;
-    const int DATETIME_TYPE_BYTE_SIZE = 4;
 
-    std::unordered_set<DateTimeVal, DateTimeHashHelper> _set;
+    // packed_time and type of a DateTimeVal, laid out as in the serialized state
+    struct PackedDateTime {
+        int64_t packed_time;
+        int32_t type;
+    } __attribute__((packed));
+
+    FlatHashSet<PackedDateTime> _set;
     FunctionContext::Type _type;
 };
     
 template <typename T>
 void AggregateFunctions::count_or_sum_distinct_numeric_init(FunctionContext* ctx, StringVal* dst) {
-    MultiDistinctNumericState<T>::create(dst);
+    MultiDistinctNumericState<T>::create(ctx, dst);
 }
     
 void AggregateFunctions::count_distinct_string_init(FunctionContext* ctx, StringVal* dst) {
@@ -1509,7 +1623,7 @@ void AggregateFunctions::count_or_sum_distinct_decimal_init(FunctionContext* ctx
 }
     
 void AggregateFunctions::count_distinct_date_init(FunctionContext* ctx, StringVal* dst) {
-    MultiDistinctCountDateState::create(dst);
+    MultiDistinctCountDateState::create(ctx, dst);
 }
 
 template <typename T>
@@ -1518,7 +1632,7 @@ void AggregateFunctions::count_or_sum_distinct_numeric_update(FunctionContext* c
     DCHECK(!dst->is_null);
     if (src.is_null) return;
     MultiDistinctNumericState<T>* state = reinterpret_cast<MultiDistinctNumericState<T>*>(dst->ptr);
-    state->update(src);
+    state->update(ctx, src);
 }
     
 void AggregateFunctions::count_distinct_string_update(FunctionContext* ctx, StringVal& src,
@@ -1543,7 +1657,7 @@ void AggregateFunctions::count_distinct_date_update(FunctionContext* ctx, DateTi
     DCHECK(!dst->is_null);
     if (src.is_null) return;
     MultiDistinctCountDateState* state = reinterpret_cast<MultiDistinctCountDateState*>(dst->ptr);
-    state->update(src);
+    state->update(ctx, src);
 }
 
 template <typename T>
@@ -1552,14 +1666,7 @@ void AggregateFunctions::count_or_sum_distinct_numeric_merge(FunctionContext* ct
    DCHECK(!dst->is_null);
    DCHECK(!src.is_null);
    MultiDistinctNumericState<T>* dst_state = reinterpret_cast<MultiDistinctNumericState<T>*>(dst->ptr);
-   // unserialize src
-   StringVal src_state_val;
-   MultiDistinctNumericState<T>::create(&src_state_val); 
-   MultiDistinctNumericState<T>* src_state = reinterpret_cast<MultiDistinctNumericState<T>*>(src_state_val.ptr);
-   src_state->unserialize(src);
-   DCHECK(dst_state->set_type() == src_state->set_type());
-   dst_state->merge(*src_state);
-   MultiDistinctNumericState<T>::destory(src_state_val);
+   dst_state->merge(ctx, src);
 }
     
 void AggregateFunctions::count_distinct_string_merge(FunctionContext* ctx, StringVal& src,
@@ -1598,14 +1705,7 @@ void AggregateFunctions::count_distinct_date_merge(FunctionContext* ctx, StringV
     DCHECK(!dst->is_null);
     DCHECK(!src.is_null);
     MultiDistinctCountDateState* dst_state = reinterpret_cast<MultiDistinctCountDateState*>(dst->ptr);
-    // unserialize src
-    StringVal src_state_val;
-    MultiDistinctCountDateState::create(&src_state_val);
-    MultiDistinctCountDateState* src_state = reinterpret_cast<MultiDistinctCountDateState*>(src_state_val.ptr);
-    src_state->unserialize(src);
-    DCHECK(dst_state->set_type() == src_state->set_type());
-    dst_state->merge(*src_state);
-    MultiDistinctCountDateState::destory(src_state_val);
+    dst_state->merge(ctx, src);
 }
     
 template <typename T>
@@ -1614,7 +1714,7 @@ StringVal AggregateFunctions::count_or_sum_distinct_numeric_serialize(FunctionCo
     MultiDistinctNumericState<T>* state = reinterpret_cast<MultiDistinctNumericState<T>*>(state_sv.ptr);
     StringVal result = state->serialize(ctx);
     // release original object
-    MultiDistinctNumericState<T>::destory(state_sv);
+    MultiDistinctNumericState<T>::destory(ctx, state_sv);
     return result;
 }
     
@@ -1641,7 +1741,7 @@ StringVal AggregateFunctions::count_distinct_date_serialize(FunctionContext* ctx
     MultiDistinctCountDateState* state = reinterpret_cast<MultiDistinctCountDateState*>(state_sv.ptr);
     StringVal result = state->serialize(ctx);
     // release original object
-    MultiDistinctCountDateState::destory(state_sv);
+    MultiDistinctCountDateState::destory(ctx, state_sv);
     return result;
 }
     
@@ -1650,7 +1750,7 @@ BigIntVal AggregateFunctions::count_or_sum_distinct_numeric_finalize(FunctionCon
     DCHECK(!state_sv.is_null);
     MultiDistinctNumericState<T>* state = reinterpret_cast<MultiDistinctNumericState<T>*>(state_sv.ptr);
     BigIntVal result = state->count_finalize();
-    MultiDistinctNumericState<T>::destory(state_sv);
+    MultiDistinctNumericState<T>::destory(ctx, state_sv);
     return result;
 }
     
@@ -1667,7 +1767,7 @@ DoubleVal AggregateFunctions::sum_distinct_double_finalize(FunctionContext* ctx,
     DCHECK(!state_sv.is_null);
     MultiDistinctNumericState<T>* state = reinterpret_cast<MultiDistinctNumericState<T>*>(state_sv.ptr);
     DoubleVal result = state->sum_finalize_double();
-    MultiDistinctNumericState<T>::destory(state_sv);
+    MultiDistinctNumericState<T>::destory(ctx, state_sv);
     return result;
 }
 
@@ -1676,7 +1776,7 @@ LargeIntVal AggregateFunctions::sum_distinct_largeint_finalize(FunctionContext*
     DCHECK(!state_sv.is_null);
     MultiDistinctNumericState<T>* state = reinterpret_cast<MultiDistinctNumericState<T>*>(state_sv.ptr);
     LargeIntVal result = state->sum_finalize_largeint();
-    MultiDistinctNumericState<T>::destory(state_sv);
+    MultiDistinctNumericState<T>::destory(ctx, state_sv);
     return result;
 }
 
@@ -1685,7 +1785,7 @@ BigIntVal AggregateFunctions::sum_distinct_bigint_finalize(FunctionContext* ctx,
     DCHECK(!state_sv.is_null);
     MultiDistinctNumericState<T>* state = reinterpret_cast<MultiDistinctNumericState<T>*>(state_sv.ptr);
     BigIntVal result = state->sum_finalize_bigint();
-    MultiDistinctNumericState<T>::destory(state_sv);
+    MultiDistinctNumericState<T>::destory(ctx, state_sv);
     return result;
 }
 
@@ -1709,7 +1809,7 @@ BigIntVal AggregateFunctions::count_distinct_date_finalize(FunctionContext* ctx,
     DCHECK(!state_sv.is_null);
     MultiDistinctCountDateState* state = reinterpret_cast<MultiDistinctCountDateState*>(state_sv.ptr);
     BigIntVal result = state->count_finalize();
-    MultiDistinctCountDateState::destory(state_sv);
+    MultiDistinctCountDateState::destory(ctx, state_sv);
     return result;
 }
     
@@ -325,6 +325,40 @@ dst);
     // calculate result
     static int64_t hll_algorithm(const palo_udf::StringVal& src);
     static void hll_union_parse_and_cal(HllSetResolver& resolver, StringVal* dst);
+
+    // BITMAP_UNION and BITMAP_UNION_COUNT of serialized RoaringBitmap values, e.g. the
+    // values of a BITMAP_UNION column. The intermediate value points to a RoaringBitmap
+    // until it is serialized, which gives a serialized RoaringBitmap again.
+    static void bitmap_union_init(palo_udf::FunctionContext*, palo_udf::StringVal* dst);
+    static void bitmap_union_update(palo_udf::FunctionContext*, const palo_udf::StringVal& src,
+                                    palo_udf::StringVal* dst);
+    static void bitmap_union_merge(palo_udf::FunctionContext*, const palo_udf::StringVal& src,
+                                   palo_udf::StringVal* dst);
+    static palo_udf::StringVal bitmap_union_serialize(palo_udf::FunctionContext*,
+                                                      const palo_udf::StringVal& src);
+    static palo_udf::BigIntVal bitmap_union_count_finalize(palo_udf::FunctionContext*,
+                                                           const palo_udf::StringVal& src);
+
+    // PERCENTILE_APPROX(value, quantile) of doubles and PERCENTILE_UNION(digest, quantile)
+    // of serialized TDigest values, e.g. the values of a QUANTILE_UNION column.
+    // The intermediate value points to a PercentileApproxState until it is serialized,
+    // which gives the quantile followed by the serialized TDigest.
+    static void percentile_approx_init(palo_udf::FunctionContext*, palo_udf::StringVal* dst);
+    static void percentile_approx_update(palo_udf::FunctionContext*,
+                                         const palo_udf::DoubleVal& src,
+                                         const palo_udf::DoubleVal& quantile,
+                                         palo_udf::StringVal* dst);
+    static void percentile_union_update(palo_udf::FunctionContext*,
+                                        const palo_udf::StringVal& src,
+                                        const palo_udf::DoubleVal& quantile,
+                                        palo_udf::StringVal* dst);
+    static void percentile_approx_merge(palo_udf::FunctionContext*,
+                                        const palo_udf::StringVal& src,
+                                        palo_udf::StringVal* dst);
+    static palo_udf::StringVal percentile_approx_serialize(palo_udf::FunctionContext*,
+                                                           const palo_udf::StringVal& src);
+    static palo_udf::DoubleVal percentile_approx_finalize(palo_udf::FunctionContext*,
+                                                          const palo_udf::StringVal& src);
 };
 
 }
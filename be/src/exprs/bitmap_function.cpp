@@ -0,0 +1,59 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "exprs/bitmap_function.h"
+
+#include "util/roaring_bitmap.h"
+#include "util/string_parser.hpp"
+
+namespace palo {
+
+using palo_udf::BigIntVal;
+using palo_udf::StringVal;
+
+void BitmapFunctions::init() {
+}
+
+StringVal BitmapFunctions::to_bitmap(palo_udf::FunctionContext* ctx, const StringVal& src) {
+    if (src.is_null) {
+        return StringVal::null();
+    }
+    StringParser::ParseResult parse_result = StringParser::PARSE_SUCCESS;
+    int64_t id = StringParser::string_to_int<int64_t>(
+            reinterpret_cast<const char*>(src.ptr), src.len, &parse_result);
+    if (parse_result != StringParser::PARSE_SUCCESS || id < 0 || id > UINT32_MAX) {
+        ctx->set_error("to_bitmap(): the argument must be an unsigned 32 bit integer");
+        return StringVal::null();
+    }
+    RoaringBitmap bitmap;
+    bitmap.add(id);
+    StringVal result(ctx, bitmap.serialized_size());
+    bitmap.serialize(reinterpret_cast<char*>(result.ptr));
+    return result;
+}
+
+BigIntVal BitmapFunctions::bitmap_count(palo_udf::FunctionContext* ctx, const StringVal& src) {
+    if (src.is_null) {
+        return BigIntVal::null();
+    }
+    RoaringBitmap bitmap;
+    if (!bitmap.deserialize(reinterpret_cast<const char*>(src.ptr), src.len)) {
+        ctx->set_error("bitmap_count(): invalid bitmap value");
+        return BigIntVal::null();
+    }
+    return BigIntVal(bitmap.cardinality());
+}
+
+}
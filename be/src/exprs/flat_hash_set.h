@@ -0,0 +1,273 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_QUERY_EXPRS_FLAT_HASH_SET_H
+#define BDG_PALO_BE_SRC_QUERY_EXPRS_FLAT_HASH_SET_H
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+
+#include "common/logging.h"
+#include "udf/udf.h"
+#include "util/bit_util.h"
+
+namespace palo {
+
+// Open addressing hash set of fixed width values, used by the states of the
+// multi distinct aggregate functions. A value takes sizeof(K) bytes in the table
+// and nothing else: values are compared bit by bit, and the all zero value is
+// kept out of the table in a flag so that an all zero slot can mark an empty one.
+// Collisions are resolved by linear probing, the table doubles once it is 3/4 full.
+//
+// Sets with no more than INLINE_CAPACITY values keep them inline and do not
+// allocate at all. Bigger tables are allocated from the FunctionContext passed in,
+// so they are accounted in the MemTracker of the aggregation. Such allocations are
+// only 8 byte aligned, values are therefore always moved in and out with memcpy.
+//
+// A table that would exceed INT32_MAX bytes, or that cannot be allocated, sets an
+// error on the FunctionContext, which fails the query; the value being inserted is
+// dropped and the set keeps its current table.
+//
+// The set does not free its table on destruction: release() must be called with
+// the same FunctionContext. Not thread safe.
+template <typename K>
+class FlatHashSet {
+public:
+    static const int INLINE_BYTES = 32;
+    static const int INLINE_CAPACITY =
+        INLINE_BYTES / sizeof(K) > 0 ? INLINE_BYTES / sizeof(K) : 1;
+
+    FlatHashSet() : _has_zero(false), _size(0), _capacity(0) {
+    }
+
+    // Adds 'key' to the set if it is not in it yet.
+    void insert(FunctionContext* ctx, const K& key) {
+        if (_is_zero(key)) {
+            _has_zero = true;
+            return;
+        }
+        if (_capacity == 0) {
+            K* values = _inline_values();
+            for (int64_t i = 0; i < _size; ++i) {
+                if (_equals(&values[i], key)) {
+                    return;
+                }
+            }
+            if (_size < INLINE_CAPACITY) {
+                memcpy(&values[_size], &key, sizeof(K));
+                ++_size;
+                return;
+            }
+            if (!_rehash(ctx, MIN_CAPACITY)) {
+                return;
+            }
+        } else if ((_size + 1) * 4 > _capacity * 3) {
+            if (!_rehash(ctx, _capacity * 2)) {
+                return;
+            }
+        }
+        if (_insert_into(_slots, _capacity, key)) {
+            ++_size;
+        }
+    }
+
+    // Grows the table, if needed, so that 'num_values' values fit without any
+    // further rehash.
+    void reserve(FunctionContext* ctx, int64_t num_values) {
+        if (num_values <= INLINE_CAPACITY || num_values * 4 <= _capacity * 3) {
+            return;
+        }
+        int64_t capacity = BitUtil::next_power_of_two(num_values * 4 / 3 + 1);
+        _rehash(ctx, std::max<int64_t>(capacity, MIN_CAPACITY));
+    }
+
+    bool contains(const K& key) const {
+        if (_is_zero(key)) {
+            return _has_zero;
+        }
+        if (_capacity == 0) {
+            const K* values = _inline_values();
+            for (int64_t i = 0; i < _size; ++i) {
+                if (_equals(&values[i], key)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+        for (uint64_t i = _hash(key) & (_capacity - 1); ; i = (i + 1) & (_capacity - 1)) {
+            if (_is_zero(_slots[i])) {
+                return false;
+            }
+            if (_equals(&_slots[i], key)) {
+                return true;
+            }
+        }
+    }
+
+    // Calls 'fn' with every value of the set, in no particular order.
+    template <typename Fn>
+    void for_each(Fn fn) const {
+        K value;
+        if (_has_zero) {
+            memset(&value, 0, sizeof(K));
+            fn(value);
+        }
+        if (_capacity == 0) {
+            for (int64_t i = 0; i < _size; ++i) {
+                memcpy(&value, &_inline_values()[i], sizeof(K));
+                fn(value);
+            }
+            return;
+        }
+        for (int64_t i = 0; i < _capacity; ++i) {
+            if (!_is_zero(_slots[i])) {
+                memcpy(&value, &_slots[i], sizeof(K));
+                fn(value);
+            }
+        }
+    }
+
+    // Copies the raw bytes of all values to 'dst', which must have room for
+    // size() * sizeof(K) bytes. Returns the end of the written data.
+    uint8_t* copy_to(uint8_t* dst) const {
+        for_each([&dst](const K& value) {
+            memcpy(dst, &value, sizeof(K));
+            dst += sizeof(K);
+        });
+        return dst;
+    }
+
+    int64_t size() const {
+        return _size + _has_zero;
+    }
+
+    // Frees the table. The set is empty afterwards.
+    void release(FunctionContext* ctx) {
+        if (_capacity != 0) {
+            ctx->free(reinterpret_cast<uint8_t*>(_slots));
+        }
+        _has_zero = false;
+        _size = 0;
+        _capacity = 0;
+    }
+
+private:
+    static const int64_t MIN_CAPACITY = 64;
+
+    static bool _is_zero(const K& key) {
+        const K zero = K();
+        return memcmp(&key, &zero, sizeof(K)) == 0;
+    }
+
+    static bool _equals(const K* slot, const K& key) {
+        return memcmp(slot, &key, sizeof(K)) == 0;
+    }
+
+    static uint64_t _hash(const K& key) {
+        uint64_t words[(sizeof(K) + 7) / 8] = { 0 };
+        memcpy(words, &key, sizeof(K));
+        uint64_t hash = 0;
+        for (int i = 0; i < sizeof(words) / sizeof(words[0]); ++i) {
+            // finalizer of MurmurHash3, good enough to spread integers over the table
+            hash ^= words[i];
+            hash ^= hash >> 33;
+            hash *= 0xff51afd7ed558ccdULL;
+            hash ^= hash >> 33;
+            hash *= 0xc4ceb9fe1a85ec53ULL;
+            hash ^= hash >> 33;
+        }
+        return hash;
+    }
+
+    // Returns true if 'key' was not in 'slots' before.
+    static bool _insert_into(K* slots, int64_t capacity, const K& key) {
+        for (uint64_t i = _hash(key) & (capacity - 1); ; i = (i + 1) & (capacity - 1)) {
+            if (_is_zero(slots[i])) {
+                memcpy(&slots[i], &key, sizeof(K));
+                return true;
+            }
+            if (_equals(&slots[i], key)) {
+                return false;
+            }
+        }
+    }
+
+    // Moves all values into a new table of 'capacity' slots. Returns false, with an
+    // error set on 'ctx' and the current table left as is, if the new table is too
+    // big or cannot be allocated.
+    bool _rehash(FunctionContext* ctx, int64_t capacity) {
+        DCHECK_EQ(capacity & (capacity - 1), 0);
+        // FunctionContext::allocate() takes an int
+        if (capacity > INT32_MAX / static_cast<int64_t>(sizeof(K))) {
+            ctx->set_error("FlatHashSet: too many distinct values, the table exceeds 2GB");
+            return false;
+        }
+        K* slots = reinterpret_cast<K*>(ctx->allocate(capacity * sizeof(K)));
+        if (slots == NULL) {
+            ctx->set_error("FlatHashSet: failed to allocate the table");
+            return false;
+        }
+        memset(slots, 0, capacity * sizeof(K));
+        if (_capacity == 0) {
+            const K* values = _inline_values();
+            for (int64_t i = 0; i < _size; ++i) {
+                K value;
+                memcpy(&value, &values[i], sizeof(K));
+                _insert_into(slots, capacity, value);
+            }
+        } else {
+            for (int64_t i = 0; i < _capacity; ++i) {
+                if (!_is_zero(_slots[i])) {
+                    K value;
+                    memcpy(&value, &_slots[i], sizeof(K));
+                    _insert_into(slots, capacity, value);
+                }
+            }
+            ctx->free(reinterpret_cast<uint8_t*>(_slots));
+        }
+        _slots = slots;
+        _capacity = capacity;
+        return true;
+    }
+
+    K* _inline_values() {
+        return reinterpret_cast<K*>(_inline);
+    }
+
+    const K* _inline_values() const {
+        return reinterpret_cast<const K*>(_inline);
+    }
+
+    bool _has_zero;
+    // number of values, not counting the zero value
+    int64_t _size;
+    // number of slots of the table, 0 while the values are kept inline
+    int64_t _capacity;
+    union {
+        uint8_t _inline[INLINE_CAPACITY * sizeof(K)];
+        K* _slots;
+    };
+};
+
+template <typename K>
+const int FlatHashSet<K>::INLINE_CAPACITY;
+
+template <typename K>
+const int64_t FlatHashSet<K>::MIN_CAPACITY;
+
+}
+
+#endif
@@ -0,0 +1,40 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "exprs/quantile_function.h"
+
+#include "util/tdigest.h"
+
+namespace palo {
+
+using palo_udf::DoubleVal;
+using palo_udf::StringVal;
+
+void QuantileFunctions::init() {
+}
+
+StringVal QuantileFunctions::to_quantile_state(palo_udf::FunctionContext* ctx,
+                                               const DoubleVal& src) {
+    if (src.is_null) {
+        return StringVal::null();
+    }
+    TDigest digest;
+    digest.add(src.val);
+    StringVal result(ctx, digest.serialized_size());
+    digest.serialize(reinterpret_cast<char*>(result.ptr));
+    return result;
+}
+
+}
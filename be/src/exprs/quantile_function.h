@@ -0,0 +1,37 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_QUERY_EXPRS_QUANTILE_FUNCTION_H
+#define BDG_PALO_BE_SRC_QUERY_EXPRS_QUANTILE_FUNCTION_H
+
+#include "udf/udf.h"
+
+namespace palo {
+
+// Scalar functions on serialized TDigest values, which are stored in VARCHAR
+// columns with the QUANTILE_UNION aggregation type.
+// See AggregateFunctions::percentile_* for the aggregate functions.
+class QuantileFunctions {
+public:
+    static void init();
+
+    // Returns a digest holding the single value 'src', to load a QUANTILE_UNION column.
+    static palo_udf::StringVal to_quantile_state(palo_udf::FunctionContext* ctx,
+                                                 const palo_udf::DoubleVal& src);
+};
+
+}
+
+#endif
@@ -232,13 +232,14 @@ static bool parse_auth(const std::string& auth, std::string* user,
 }
 
 Status MiniLoadAction::check_auth(
+        ExecEnv* exec_env,
         const HttpRequest* http_req,
         const TLoadCheckRequest& check_load_req) {
     // put here to log master information
-    const TNetworkAddress& master_address = _exec_env->master_info()->network_address;
+    const TNetworkAddress& master_address = exec_env->master_info()->network_address;
     Status status;
     FrontendServiceConnection client(
-            _exec_env->frontend_client_cache(), master_address, 500, &status);
+            exec_env->frontend_client_cache(), master_address, 500, &status);
     if (!status.ok()) {
         std::stringstream ss;
         ss << "Connect master failed, with address("
@@ -335,7 +336,7 @@ Status MiniLoadAction::_on_header(HttpRequest* req) {
     RETURN_IF_ERROR(generate_check_load_req(req, &ctx->load_check_req));
 
     // Check auth
-    RETURN_IF_ERROR(check_auth(req, ctx->load_check_req));
+    RETURN_IF_ERROR(check_auth(_exec_env, req, ctx->load_check_req));
 
     // Receive data first, keep things easy.
     RETURN_IF_ERROR(data_saved_dir(ctx->load_handle, req->param(TABLE_KEY),
@@ -61,6 +61,19 @@ public:
     void free_handler_ctx(void* ctx) override;
     
     void erase_handle(const LoadHandle& handle);
+
+    // Builds the request checking the Basic authorization of 'http_req' for the
+    // load of its db, table and label parameters. Also used by StreamLoadAction.
+    static Status generate_check_load_req(
+            const HttpRequest* http_req,
+            TLoadCheckRequest* load_check_req);
+
+    // Checks 'load_check_req' with the master FE.
+    static Status check_auth(
+            ExecEnv* exec_env,
+            const HttpRequest* http_req,
+            const TLoadCheckRequest& load_check_req);
+
 private:
     Status _load(
             HttpRequest* req, 
@@ -74,14 +87,6 @@ private:
 
     Status _on_header(HttpRequest* http_req);
 
-    Status generate_check_load_req(
-            const HttpRequest* http_req,
-            TLoadCheckRequest* load_check_req);
-
-    Status check_auth(
-            const HttpRequest* http_req,
-            const TLoadCheckRequest& load_check_req);
-
     ExecEnv* _exec_env;
 
     std::mutex _lock;
@@ -0,0 +1,514 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "http/action/stream_load.h"
+
+#include <string.h>
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
+#include <event2/buffer.h>
+#include <event2/bufferevent.h>
+#include <event2/event.h>
+#include <event2/http.h>
+
+#include "common/config.h"
+#include "http/action/mini_load.h"
+#include "http/http_channel.h"
+#include "http/http_headers.h"
+#include "http/http_request.h"
+#include "http/http_status.h"
+#include "olap/memtable.h"
+#include "olap/olap_engine.h"
+#include "olap/push_handler.h"
+#include "olap/row_cursor.h"
+#include "util/thread_pool.hpp"
+#include "gen_cpp/AgentService_types.h"
+
+namespace palo {
+
+static void on_resume_event(evutil_socket_t fd, short what, void* arg);
+static void on_pushed_event(evutil_socket_t fd, short what, void* arg);
+
+// context of one stream load, lives from the header to the reply, or until its
+// delta is written if the request is freed before
+struct StreamLoadCtx {
+    StreamLoadCtx(StreamLoadAction* handler_, HttpRequest* http_req_) :
+            handler(handler_), http_req(http_req_) {
+        struct event_base* base = evhttp_connection_get_base(
+                evhttp_request_get_connection(http_req->get_evhttp_request()));
+        resume_event = event_new(base, -1, 0, on_resume_event, this);
+        pushed_event = event_new(base, -1, 0, on_pushed_event, this);
+    }
+    ~StreamLoadCtx() {
+        handler->release_memory(this);
+        event_free(resume_event);
+        event_free(pushed_event);
+    }
+
+    StreamLoadAction* handler;
+    // reset when the request is freed while the delta is written
+    HttpRequest* http_req;
+
+    // activated by release_memory() to resume reading the body, or by its
+    // timeout when paused for too long
+    struct event* resume_event;
+    // activated by the push thread when the delta is written
+    struct event* pushed_event;
+    // guarded by the lock of the handler
+    bool paused = false;
+    // whether the push thread owns the context, only used on the http thread
+    bool pushing = false;
+    OLAPStatus push_status = OLAP_SUCCESS;
+
+    SmartOLAPTable table;
+    TPushReq push_req;
+    char column_separator = '\t';
+    double max_filter_ratio = 0;
+
+    std::unique_ptr<MemTable> mem_table;
+    // reused for every line
+    RowCursor row;
+    // the beginning of a line whose end has not arrived yet
+    std::string partial_line;
+
+    int64_t num_loaded_rows = 0;
+    int64_t num_filtered_rows = 0;
+    // reason of the first filtered row
+    std::string first_filtered_reason;
+
+    // bytes of mem_table accounted in the budget of the handler
+    int64_t mem_reserved = 0;
+};
+
+const std::string DB_KEY = "db";
+const std::string TABLE_KEY = "table";
+const std::string LABEL_KEY = "label";
+const std::string TABLET_ID_KEY = "tablet_id";
+const std::string SCHEMA_HASH_KEY = "schema_hash";
+const std::string VERSION_KEY = "version";
+const std::string VERSION_HASH_KEY = "version_hash";
+const std::string COLUMN_SEPARATOR_KEY = "column_separator";
+const std::string MAX_FILTER_RATIO_KEY = "max_filter_ratio";
+const std::string NULL_VALUE = "\\N";
+
+static void on_resume_event(evutil_socket_t fd, short what, void* arg) {
+    StreamLoadCtx* ctx = (StreamLoadCtx*)arg;
+    ctx->handler->on_resume(ctx, what & EV_TIMEOUT);
+}
+
+static void on_pushed_event(evutil_socket_t fd, short what, void* arg) {
+    StreamLoadCtx* ctx = (StreamLoadCtx*)arg;
+    ctx->handler->on_pushed(ctx);
+}
+
+static struct bufferevent* get_bufferevent(HttpRequest* req) {
+    return evhttp_connection_get_bufferevent(
+            evhttp_request_get_connection(req->get_evhttp_request()));
+}
+
+StreamLoadAction::StreamLoadAction(ExecEnv* exec_env) :
+        _exec_env(exec_env),
+        _push_pool(new ThreadPool(config::stream_load_push_thread_num, 1024)),
+        _mem_usage(0) {
+}
+
+StreamLoadAction::~StreamLoadAction() {
+}
+
+int StreamLoadAction::on_header(HttpRequest* req) {
+    // check authorization first, make client know what happend
+    if (req->header(HttpHeaders::AUTHORIZATION).empty()) {
+        HttpChannel::send_basic_challenge(req, "stream_load");
+        return -1;
+    }
+    std::unique_ptr<StreamLoadCtx> ctx(new StreamLoadCtx(this, req));
+    auto st = _on_header(req, ctx.get());
+    if (!st.ok()) {
+        HttpChannel::send_reply(req, HttpStatus::BAD_REQUEST, st.get_error_msg());
+        return -1;
+    }
+    req->set_handler_ctx(ctx.release());
+    return 0;
+}
+
+Status StreamLoadAction::_on_header(HttpRequest* req, StreamLoadCtx* ctx) {
+    for (const std::string& key : { DB_KEY, TABLE_KEY, LABEL_KEY, TABLET_ID_KEY,
+                                     SCHEMA_HASH_KEY, VERSION_KEY, VERSION_HASH_KEY }) {
+        if (req->param(key).empty()) {
+            return Status("parameter " + key + " not specified in url.");
+        }
+    }
+    // the user must be allowed to load into the table, as for a mini load
+    TLoadCheckRequest load_check_req;
+    RETURN_IF_ERROR(MiniLoadAction::generate_check_load_req(req, &load_check_req));
+    RETURN_IF_ERROR(MiniLoadAction::check_auth(_exec_env, req, load_check_req));
+    TPushReq& push_req = ctx->push_req;
+    try {
+        push_req.tablet_id = boost::lexical_cast<int64_t>(req->param(TABLET_ID_KEY));
+        push_req.schema_hash = boost::lexical_cast<int32_t>(req->param(SCHEMA_HASH_KEY));
+        push_req.version = boost::lexical_cast<int64_t>(req->param(VERSION_KEY));
+        push_req.version_hash = boost::lexical_cast<int64_t>(req->param(VERSION_HASH_KEY));
+        if (!req->param(MAX_FILTER_RATIO_KEY).empty()) {
+            ctx->max_filter_ratio = boost::lexical_cast<double>(
+                    req->param(MAX_FILTER_RATIO_KEY));
+        }
+    } catch (boost::bad_lexical_cast& e) {
+        return Status(std::string("param format is invalid: ") + e.what());
+    }
+    push_req.timeout = config::stream_load_mem_wait_seconds;
+    push_req.push_type = TPushType::LOAD;
+
+    const std::string& column_separator = req->param(COLUMN_SEPARATOR_KEY);
+    if (column_separator.size() > 1) {
+        return Status("column separator must be one character.");
+    } else if (column_separator.size() == 1) {
+        ctx->column_separator = column_separator[0];
+    }
+
+    ctx->table = OLAPEngine::get_instance()->get_table(push_req.tablet_id, push_req.schema_hash);
+    if (ctx->table.get() == nullptr) {
+        std::stringstream ss;
+        ss << "tablet not found, tablet_id=" << push_req.tablet_id
+            << ", schema_hash=" << push_req.schema_hash;
+        return Status(ss.str());
+    }
+    const std::vector<FieldInfo>& tablet_schema = ctx->table->tablet_schema();
+    for (const FieldInfo& field_info : tablet_schema) {
+        // these columns hold serialized structures which text can not describe
+        if (field_info.type == OLAP_FIELD_TYPE_HLL
+                || field_info.aggregation == OLAP_FIELD_AGGREGATION_BITMAP_UNION
+                || field_info.aggregation == OLAP_FIELD_AGGREGATION_QUANTILE_UNION) {
+            return Status("column " + field_info.name + " can not be loaded from text.");
+        }
+    }
+
+    ctx->mem_table.reset(new MemTable(ctx->table));
+    if (ctx->mem_table->init() != OLAP_SUCCESS
+            || ctx->row.init(tablet_schema) != OLAP_SUCCESS
+            || ctx->row.allocate_memory_for_string_type(tablet_schema) != OLAP_SUCCESS) {
+        return Status("init memtable failed.");
+    }
+
+    LOG(INFO) << "begin stream load, tablet=" << ctx->table->full_name()
+        << ", version=" << push_req.version;
+    return Status::OK;
+}
+
+void StreamLoadAction::on_chunk_data(HttpRequest* http_req) {
+    StreamLoadCtx* ctx = (StreamLoadCtx*)http_req->handler_ctx();
+    if (ctx == nullptr) {
+        return;
+    }
+
+    // read the chunk where libevent keeps it, without copying it out, libevent
+    // drops it after this call
+    Status st;
+    struct evbuffer* evbuf = evhttp_request_get_input_buffer(
+            http_req->get_evhttp_request());
+    int num_vecs = evbuffer_peek(evbuf, -1, nullptr, nullptr, 0);
+    std::vector<evbuffer_iovec> vecs(num_vecs);
+    evbuffer_peek(evbuf, -1, nullptr, vecs.data(), num_vecs);
+    for (int i = 0; i < num_vecs && st.ok(); ++i) {
+        st = _process_data(ctx, (const char*)vecs[i].iov_base, vecs[i].iov_len);
+    }
+    evbuffer_drain(evbuf, evbuffer_get_length(evbuf));
+    if (st.ok()) {
+        st = _update_memory(ctx);
+    }
+
+    if (!st.ok()) {
+        _cancel(http_req, ctx, st.get_error_msg());
+    }
+}
+
+void StreamLoadAction::_cancel(HttpRequest* req, StreamLoadCtx* ctx, const std::string& msg) {
+    LOG(WARNING) << "stream load failed, tablet=" << ctx->table->full_name()
+        << ", error=" << msg;
+    HttpChannel::send_reply(req, HttpStatus::SERVICE_UNAVAILABLE, msg);
+    delete ctx;
+    req->set_handler_ctx(nullptr);
+}
+
+Status StreamLoadAction::_process_data(StreamLoadCtx* ctx, const char* data, size_t len) {
+    const char* end = data + len;
+    while (data < end) {
+        const char* line_end = (const char*)memchr(data, '\n', end - data);
+        if (line_end == nullptr) {
+            ctx->partial_line.append(data, end - data);
+            break;
+        }
+        if (ctx->partial_line.empty()) {
+            RETURN_IF_ERROR(_process_line(ctx, data, line_end - data));
+        } else {
+            ctx->partial_line.append(data, line_end - data);
+            RETURN_IF_ERROR(_process_line(
+                    ctx, ctx->partial_line.data(), ctx->partial_line.size()));
+            ctx->partial_line.clear();
+        }
+        data = line_end + 1;
+    }
+    return Status::OK;
+}
+
+Status StreamLoadAction::_process_line(StreamLoadCtx* ctx, const char* line, size_t len) {
+    if (len == 0) {
+        return Status::OK;
+    }
+    const std::vector<FieldInfo>& tablet_schema = ctx->table->tablet_schema();
+    RowCursor& row = ctx->row;
+
+    std::string reason;
+    size_t cid = 0;
+    const char* value = line;
+    const char* end = line + len;
+    while (reason.empty()) {
+        const char* value_end = (const char*)memchr(value, ctx->column_separator, end - value);
+        if (value_end == nullptr) {
+            value_end = end;
+        }
+        if (cid >= tablet_schema.size()) {
+            reason = "actual column number is more than schema column number.";
+            break;
+        }
+
+        const FieldInfo& field_info = tablet_schema[cid];
+        std::string value_str(value, value_end - value);
+        if (value_str == NULL_VALUE) {
+            if (field_info.is_allow_null) {
+                row.set_null(cid);
+            } else {
+                reason = "column " + field_info.name + " is not nullable.";
+            }
+        } else {
+            size_t max_length = field_info.length;
+            if (field_info.type == OLAP_FIELD_TYPE_VARCHAR) {
+                max_length -= OLAP_STRING_MAX_BYTES;
+            } else if (field_info.type == OLAP_FIELD_TYPE_CHAR) {
+                // chars are padded with zeros
+                StringSlice* slice = (StringSlice*)row.get_field_content_ptr(cid);
+                memset(slice->data, 0, field_info.length);
+            }
+            if ((field_info.type == OLAP_FIELD_TYPE_VARCHAR
+                    || field_info.type == OLAP_FIELD_TYPE_CHAR)
+                    && value_str.size() > max_length) {
+                reason = "value of column " + field_info.name + " is too long.";
+            } else if (row.from_string(cid, value_str) != OLAP_SUCCESS) {
+                reason = "invalid value of column " + field_info.name + ".";
+            } else {
+                row.set_not_null(cid);
+            }
+        }
+
+        ++cid;
+        if (value_end == end) {
+            if (reason.empty() && cid < tablet_schema.size()) {
+                reason = "actual column number is less than schema column number.";
+            }
+            break;
+        }
+        value = value_end + 1;
+    }
+
+    if (!reason.empty()) {
+        if (ctx->first_filtered_reason.empty()) {
+            ctx->first_filtered_reason = reason + " line: [" + std::string(line, len) + "]";
+        }
+        ++ctx->num_filtered_rows;
+        return Status::OK;
+    }
+
+    if (ctx->mem_table->insert(row) != OLAP_SUCCESS) {
+        return Status("insert into memtable failed.");
+    }
+    ++ctx->num_loaded_rows;
+    return Status::OK;
+}
+
+Status StreamLoadAction::_update_memory(StreamLoadCtx* ctx) {
+    int64_t limit = config::stream_load_mem_limit_mb * 1024 * 1024;
+    int64_t usage = ctx->mem_table->memory_usage();
+    {
+        std::lock_guard<std::mutex> l(_lock);
+        _mem_usage += usage - ctx->mem_reserved;
+        ctx->mem_reserved = usage;
+        if (ctx->mem_reserved > limit) {
+            return Status("rows of the load exceed the memory limit of stream load, "
+                          "please split the load.");
+        }
+        if (_mem_usage <= limit) {
+            return Status::OK;
+        }
+        ctx->paused = true;
+        _paused_loads.push_back(ctx);
+    }
+    // Stop reading the body until release_memory() activates resume_event. If it
+    // already did, the event runs after this callback returns, so reading is
+    // enabled again.
+    bufferevent_disable(get_bufferevent(ctx->http_req), EV_READ);
+    struct timeval timeout = { config::stream_load_mem_wait_seconds, 0 };
+    event_add(ctx->resume_event, &timeout);
+    return Status::OK;
+}
+
+void StreamLoadAction::release_memory(StreamLoadCtx* ctx) {
+    int64_t limit = config::stream_load_mem_limit_mb * 1024 * 1024;
+    std::lock_guard<std::mutex> l(_lock);
+    _mem_usage -= ctx->mem_reserved;
+    ctx->mem_reserved = 0;
+    if (ctx->paused) {
+        // the load is freed, nothing to resume
+        ctx->paused = false;
+        _paused_loads.remove(ctx);
+    }
+    while (_mem_usage <= limit && !_paused_loads.empty()) {
+        StreamLoadCtx* paused = _paused_loads.front();
+        _paused_loads.pop_front();
+        paused->paused = false;
+        // the event loop of the load may run in another thread
+        event_active(paused->resume_event, 0, 0);
+    }
+}
+
+void StreamLoadAction::on_resume(StreamLoadCtx* ctx, bool timeout) {
+    if (timeout) {
+        std::unique_lock<std::mutex> l(_lock);
+        // otherwise release_memory() resumed it at the same time
+        if (ctx->paused) {
+            ctx->paused = false;
+            _paused_loads.remove(ctx);
+            l.unlock();
+            bufferevent_enable(get_bufferevent(ctx->http_req), EV_READ);
+            _cancel(ctx->http_req, ctx, "wait for memory of stream load timeout.");
+            return;
+        }
+    }
+    // resumed before its timeout
+    event_del(ctx->resume_event);
+    struct bufferevent* bev = get_bufferevent(ctx->http_req);
+    bufferevent_enable(bev, EV_READ);
+    // the rest of the body may already be buffered, with nothing left to read
+    // on the socket
+    bufferevent_trigger(bev, EV_READ, 0);
+}
+
+void StreamLoadAction::free_handler_ctx(void* param) {
+    StreamLoadCtx* ctx = (StreamLoadCtx*)param;
+    if (ctx->pushing) {
+        // the request is gone, on_pushed() frees the context
+        ctx->http_req = nullptr;
+        return;
+    }
+    delete ctx;
+}
+
+void StreamLoadAction::handle(HttpRequest *http_req) {
+    StreamLoadCtx* ctx = (StreamLoadCtx*)http_req->handler_ctx();
+    if (ctx == nullptr) {
+        // error happened in on_chunk_data, and reply is sent
+        return;
+    }
+
+    // the last chunk may have paused the load, which has nothing left to read
+    {
+        std::lock_guard<std::mutex> l(_lock);
+        if (ctx->paused) {
+            ctx->paused = false;
+            _paused_loads.remove(ctx);
+        }
+    }
+    event_del(ctx->resume_event);
+
+    // the last line may not end with a line delimiter
+    if (!ctx->partial_line.empty()) {
+        std::string line;
+        line.swap(ctx->partial_line);
+        auto st = _process_line(ctx, line.data(), line.size());
+        if (!st.ok()) {
+            HttpChannel::send_reply(
+                http_req, HttpStatus::INTERNAL_SERVER_ERROR, st.get_error_msg());
+            return;
+        }
+    }
+
+    int64_t num_rows = ctx->num_loaded_rows + ctx->num_filtered_rows;
+    if (ctx->num_filtered_rows > ctx->max_filter_ratio * num_rows) {
+        std::stringstream ss;
+        ss << "too many filtered rows, filtered_rows=" << ctx->num_filtered_rows
+            << ", total_rows=" << num_rows << ", first error: " << ctx->first_filtered_reason;
+        HttpChannel::send_reply(http_req, HttpStatus::BAD_REQUEST, ss.str());
+        return;
+    }
+
+    // writing the delta takes long, do not block the other requests of this thread
+    ctx->pushing = true;
+    if (!_push_pool->offer(boost::bind(&StreamLoadAction::_push, this, ctx))) {
+        ctx->pushing = false;
+        HttpChannel::send_reply(http_req, HttpStatus::SERVICE_UNAVAILABLE,
+                                "stream load is stopped.");
+    }
+}
+
+void StreamLoadAction::_push(StreamLoadCtx* ctx) {
+    PushHandler push_handler;
+    push_handler.set_mem_table(ctx->mem_table.get());
+    std::vector<TTabletInfo> tablet_infos;
+    ctx->push_status = push_handler.process(
+            ctx->table, ctx->push_req, PUSH_NORMAL, &tablet_infos);
+    ctx->mem_table.reset();
+    release_memory(ctx);
+    // reply on the http thread of the request
+    event_active(ctx->pushed_event, 0, 0);
+}
+
+void StreamLoadAction::on_pushed(StreamLoadCtx* ctx) {
+    ctx->pushing = false;
+    HttpRequest* http_req = ctx->http_req;
+    if (http_req == nullptr) {
+        LOG(WARNING) << "stream load request is freed before its delta is written, tablet="
+            << ctx->table->full_name() << ", res=" << ctx->push_status;
+        delete ctx;
+        return;
+    }
+
+    OLAPStatus res = ctx->push_status;
+    if (res != OLAP_SUCCESS) {
+        std::stringstream ss;
+        ss << "push delta failed, res=" << res;
+        LOG(WARNING) << ss.str() << ", tablet=" << ctx->table->full_name();
+        HttpChannel::send_reply(http_req, HttpStatus::INTERNAL_SERVER_ERROR, ss.str());
+        return;
+    }
+    LOG(INFO) << "finish stream load, tablet=" << ctx->table->full_name()
+        << ", version=" << ctx->push_req.version
+        << ", loaded_rows=" << ctx->num_loaded_rows
+        << ", filtered_rows=" << ctx->num_filtered_rows;
+
+    std::stringstream ss;
+    ss << "{\n";
+    ss << "\t\"status\": \"Success\",\n";
+    ss << "\t\"msg\": \"OK\",\n";
+    ss << "\t\"loaded_rows\": " << ctx->num_loaded_rows << ",\n";
+    ss << "\t\"filtered_rows\": " << ctx->num_filtered_rows << "\n";
+    ss << "}\n";
+    HttpChannel::send_reply(http_req, ss.str());
+}
+
+}
@@ -0,0 +1,113 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_HTTP_ACTION_STREAM_LOAD_H
+#define BDG_PALO_BE_SRC_HTTP_ACTION_STREAM_LOAD_H
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "common/status.h"
+#include "http/http_handler.h"
+
+namespace palo {
+
+class ExecEnv;
+class ThreadPool;
+struct StreamLoadCtx;
+
+// Loads the body of a request, rows of text, into one tablet as a new delta,
+// without writing the body to a file first.
+// path is /api/_stream_load, with parameters db, table and label checked with the
+// master together with the Basic authorization as for a mini load, tablet_id,
+// schema_hash, version and version_hash like a push task, and optionally
+// column_separator (default \t) and max_filter_ratio (default 0).
+//
+// Not registered yet: the FE does not assign the versions of these loads nor
+// route their rows to the other replicas of the tablet, so a load would make the
+// replicas diverge behind the back of the FE.
+//
+// The body is parsed as it arrives and its rows are sorted and aggregated in a
+// MemTable, which is written as the delta of the version by PushHandler once
+// the body is complete. The delta is written by config::stream_load_push_thread_num
+// threads, and the reply is sent back on the http thread of the request.
+//
+// The memtables of all stream loads share config::stream_load_mem_limit_mb. While
+// they exceed it, loads stop reading their bodies until other loads finish, so
+// clients are pushed back by TCP. The http threads never wait: reading from the
+// connection of a paused load is disabled, and enabled again when memory is
+// released. A load paused longer than config::stream_load_mem_wait_seconds, or
+// using more than the whole budget by itself, fails.
+class StreamLoadAction : public HttpHandler {
+public:
+    StreamLoadAction(ExecEnv* exec_env);
+
+    virtual ~StreamLoadAction();
+
+    void handle(HttpRequest *req) override;
+
+    bool request_will_be_read_progressively() override { return true; }
+
+    int on_header(HttpRequest* req) override;
+
+    void on_chunk_data(HttpRequest* req) override;
+    void free_handler_ctx(void* ctx) override;
+
+    // Returns the memory used by the memtable of 'ctx' to the budget, and resumes
+    // the paused loads if they fit in it again.
+    void release_memory(StreamLoadCtx* ctx);
+
+    // Called on the http thread of 'ctx' when it is resumed, or paused for too long
+    // if 'timeout'.
+    void on_resume(StreamLoadCtx* ctx, bool timeout);
+
+    // Called on the http thread of 'ctx' when its delta is written.
+    void on_pushed(StreamLoadCtx* ctx);
+
+private:
+    Status _on_header(HttpRequest* req, StreamLoadCtx* ctx);
+
+    // Accounts the memory used by the memtable of 'ctx' in the budget, and pauses
+    // reading the body of 'ctx' if the budget is exceeded.
+    Status _update_memory(StreamLoadCtx* ctx);
+
+    // Writes the memtable of 'ctx' as a delta, run by _push_pool.
+    void _push(StreamLoadCtx* ctx);
+
+    // Fails the load of 'req' with 'msg', the body is not read any more.
+    void _cancel(HttpRequest* req, StreamLoadCtx* ctx, const std::string& msg);
+
+    // Parses the complete lines of 'data', the rest is kept for the next chunk.
+    Status _process_data(StreamLoadCtx* ctx, const char* data, size_t len);
+
+    // Parses one line into a row of the memtable, or counts it as filtered.
+    Status _process_line(StreamLoadCtx* ctx, const char* line, size_t len);
+
+    ExecEnv* _exec_env;
+    std::unique_ptr<ThreadPool> _push_pool;
+
+    // protects _mem_usage, _paused_loads and the paused flag of the loads
+    std::mutex _lock;
+    // bytes used by the memtables of all loads
+    int64_t _mem_usage;
+    // loads waiting for memory, resumed in this order
+    std::list<StreamLoadCtx*> _paused_loads;
+};
+
+}
+
+#endif
@@ -20,12 +20,19 @@
 #include <fcntl.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <string>
 #include <sstream>
 
+#include <event2/event.h>
+#include <event2/http.h>
+
+#include "boost/algorithm/string/trim.hpp"
+#include "boost/bind.hpp"
 #include "boost/lexical_cast.hpp"
 
 #include "agent/cgroups_mgr.h"
+#include "common/config.h"
 #include "http/http_channel.h"
 #include "http/http_headers.h"
 #include "http/http_request.h"
@@ -34,6 +41,7 @@
 #include "util/defer_op.h"
 #include "util/file_utils.h"
 #include "util/filesystem_util.h"
+#include "util/thread_pool.hpp"
 #include "runtime/exec_env.h"
 
 namespace palo {
@@ -42,11 +50,67 @@ const std::string FILE_PARAMETER = "file";
 const std::string DB_PARAMETER = "db";
 const std::string LABEL_PARAMETER = "label";
 const std::string TOKEN_PARAMETER = "token";
+const std::string CHECKSUM_PARAMETER = "checksum";
+const std::string OFFSET_PARAMETER = "offset";
+const std::string LENGTH_PARAMETER = "length";
+const std::string RANGE_UNIT = "bytes";
+
+static void on_checksum_done_event(evutil_socket_t fd, short what, void* arg);
+
+// context of a checksum request, lives from handle() until both the reply is sent and
+// the request is freed
+struct ChecksumCtx {
+    ChecksumCtx(DownloadAction* handler_, HttpRequest* http_req_) :
+            handler(handler_), http_req(http_req_) {
+        struct event_base* base = evhttp_connection_get_base(
+                evhttp_request_get_connection(http_req->get_evhttp_request()));
+        done_event = event_new(base, -1, 0, on_checksum_done_event, this);
+    }
+    ~ChecksumCtx() {
+        event_free(done_event);
+    }
+
+    DownloadAction* handler;
+    // reset when the request is freed while the checksum is computed
+    HttpRequest* http_req;
+    // activated by the checksum thread when the checksum is computed
+    struct event* done_event;
+    // whether the checksum thread owns the context, only used on the http thread
+    bool computing = false;
+
+    std::string file_path;
+    // the whole file if length < 0
+    int64_t offset = 0;
+    int64_t length = -1;
+
+    Status status;
+    std::string md5sum;
+};
+
+static void on_checksum_done_event(evutil_socket_t fd, short what, void* arg) {
+    ChecksumCtx* ctx = (ChecksumCtx*)arg;
+    ctx->handler->on_checksum_done(ctx);
+}
+
+// Parses a decimal number of at most 18 digits.
+static bool parse_non_negative(const std::string& str, int64_t* value) {
+    if (str.empty() || str.size() > 18) {
+        return false;
+    }
+    for (char c : str) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+    }
+    *value = strtoll(str.c_str(), NULL, 10);
+    return true;
+}
 
 DownloadAction::DownloadAction(ExecEnv* exec_env, const std::vector<std::string>& allow_dirs) :
     _exec_env(exec_env),
     _download_type(NORMAL),
-    _allow_paths(allow_dirs) {
+    _allow_paths(allow_dirs),
+    _checksum_pool(new ThreadPool(config::download_checksum_thread_num, 1024)) {
 
 }
 
@@ -57,6 +121,9 @@ DownloadAction::DownloadAction(ExecEnv* exec_env, const std::string& error_log_r
 
 }
 
+DownloadAction::~DownloadAction() {
+}
+
 void DownloadAction::handle_normal(
         HttpRequest *req,
         const std::string& file_param) {
@@ -80,6 +147,8 @@ void DownloadAction::handle_normal(
 
     if (FileUtils::is_dir(file_param)) {
         do_dir_response(file_param, req);
+    } else if (!req->param(CHECKSUM_PARAMETER).empty()) {
+        do_checksum_response(file_param, req);
     } else {
         do_file_response(file_param, req);
     }
@@ -171,13 +240,24 @@ void DownloadAction::do_file_response(const std::string& file_path, HttpRequest
     int64_t file_size = st.st_size;
 
     // TODO(lingbin): process "IF_MODIFIED_SINCE" header
-    // TODO(lingbin): process "RANGE" header
+    int64_t offset = 0;
+    int64_t length = file_size;
+    RangeType range_type = RANGE_NONE;
     const std::string& range_header = req->header(HttpHeaders::RANGE);
     if (!range_header.empty()) {
-        // analyse range header
+        range_type = parse_range(range_header, file_size, &offset, &length);
+    }
+    if (range_type == RANGE_NOT_SATISFIABLE) {
+        close(fd);
+        std::stringstream content_range;
+        content_range << RANGE_UNIT << " */" << file_size;
+        req->add_output_header(HttpHeaders::CONTENT_RANGE, content_range.str().c_str());
+        HttpChannel::send_reply(req, HttpStatus::REQUESTED_RANGE_NOT_SATISFIED);
+        return;
     }
 
     req->add_output_header(HttpHeaders::CONTENT_TYPE, get_content_type(file_path).c_str());
+    req->add_output_header(HttpHeaders::ACCEPT_RANGES, RANGE_UNIT.c_str());
 
     if (req->method() == HttpMethod::HEAD) {
         close(fd);
@@ -187,9 +267,134 @@ void DownloadAction::do_file_response(const std::string& file_path, HttpRequest
         return;
     }
 
+    if (range_type == RANGE_SATISFIABLE) {
+        std::stringstream content_range;
+        content_range << RANGE_UNIT << " " << offset << "-" << offset + length - 1
+            << "/" << file_size;
+        req->add_output_header(HttpHeaders::CONTENT_RANGE, content_range.str().c_str());
+        HttpChannel::send_file(req, fd, offset, length, HttpStatus::PARTIAL_CONTENT);
+        return;
+    }
+
     HttpChannel::send_file(req, fd, 0, file_size);
 }
 
+void DownloadAction::do_checksum_response(const std::string& file_path, HttpRequest *req) {
+    if (req->param(CHECKSUM_PARAMETER) != "md5") {
+        HttpChannel::send_reply(req, HttpStatus::BAD_REQUEST, "only md5 checksum is supported.");
+        return;
+    }
+
+    std::unique_ptr<ChecksumCtx> ctx(new ChecksumCtx(this, req));
+    ctx->file_path = file_path;
+    const std::string& offset_str = req->param(OFFSET_PARAMETER);
+    const std::string& length_str = req->param(LENGTH_PARAMETER);
+    if (!offset_str.empty() || !length_str.empty()) {
+        if ((!offset_str.empty() && !parse_non_negative(offset_str, &ctx->offset))
+                || !parse_non_negative(length_str, &ctx->length)) {
+            HttpChannel::send_reply(req, HttpStatus::BAD_REQUEST, "invalid offset or length.");
+            return;
+        }
+    }
+
+    // reading the file takes long, do not block the other requests of this thread
+    ChecksumCtx* computing_ctx = ctx.get();
+    computing_ctx->computing = true;
+    req->set_handler_ctx(ctx.release());
+    if (!_checksum_pool->offer(
+            boost::bind(&DownloadAction::compute_checksum, this, computing_ctx))) {
+        computing_ctx->computing = false;
+        HttpChannel::send_reply(req, HttpStatus::SERVICE_UNAVAILABLE,
+                                "download is stopped.");
+    }
+}
+
+void DownloadAction::compute_checksum(ChecksumCtx* ctx) {
+    if (ctx->length < 0) {
+        ctx->status = FileUtils::md5sum(ctx->file_path, &ctx->md5sum);
+    } else {
+        ctx->status = FileUtils::md5sum(ctx->file_path, ctx->offset, ctx->length, &ctx->md5sum);
+    }
+    // reply on the http thread of the request
+    event_active(ctx->done_event, 0, 0);
+}
+
+void DownloadAction::on_checksum_done(ChecksumCtx* ctx) {
+    ctx->computing = false;
+    HttpRequest* req = ctx->http_req;
+    if (req == nullptr) {
+        // the request is gone, nobody waits for the checksum
+        delete ctx;
+        return;
+    }
+    if (!ctx->status.ok()) {
+        LOG(WARNING) << "Failed to calc md5sum. file=" << ctx->file_path
+            << ", error=" << ctx->status.get_error_msg();
+        HttpChannel::send_error(req, HttpStatus::NOT_FOUND);
+        return;
+    }
+    HttpChannel::send_reply(req, ctx->md5sum);
+}
+
+void DownloadAction::free_handler_ctx(void* param) {
+    ChecksumCtx* ctx = (ChecksumCtx*)param;
+    if (ctx->computing) {
+        // the request is gone, on_checksum_done() frees the context
+        ctx->http_req = nullptr;
+        return;
+    }
+    delete ctx;
+}
+
+DownloadAction::RangeType DownloadAction::parse_range(
+        const std::string& range_header, int64_t file_size,
+        int64_t* offset, int64_t* length) {
+    // bytes=first-last, bytes=first- or bytes=-suffix_length
+    const std::string prefix = RANGE_UNIT + "=";
+    if (range_header.compare(0, prefix.size(), prefix) != 0) {
+        return RANGE_NONE;
+    }
+    std::string spec = range_header.substr(prefix.size());
+    size_t dash = spec.find('-');
+    if (dash == std::string::npos || spec.find(',') != std::string::npos) {
+        return RANGE_NONE;
+    }
+    std::string first = spec.substr(0, dash);
+    std::string last = spec.substr(dash + 1);
+    boost::algorithm::trim(first);
+    boost::algorithm::trim(last);
+
+    int64_t start = 0;
+    int64_t end = file_size - 1;
+    if (first.empty()) {
+        int64_t suffix_length = 0;
+        if (!parse_non_negative(last, &suffix_length)) {
+            return RANGE_NONE;
+        }
+        if (suffix_length == 0) {
+            return RANGE_NOT_SATISFIABLE;
+        }
+        start = std::max(file_size - suffix_length, 0L);
+    } else {
+        if (!parse_non_negative(first, &start)) {
+            return RANGE_NONE;
+        }
+        if (!last.empty()) {
+            int64_t last_pos = 0;
+            if (!parse_non_negative(last, &last_pos) || last_pos < start) {
+                return RANGE_NONE;
+            }
+            end = std::min(end, last_pos);
+        }
+    }
+    if (start >= file_size) {
+        return RANGE_NOT_SATISFIABLE;
+    }
+    *offset = start;
+    *length = end - start + 1;
+    return RANGE_SATISFIABLE;
+}
+
 // If 'file_name' contains a dot but does not consist solely of one or to two dots,
 // returns the substring of file_name starting at the rightmost dot and ending at the path's end.
 // Otherwise, returns an empty string
@@ -16,6 +16,8 @@
 #ifndef  BDG_PALO_BE_SRC_HTTP_DOWNLOAD_ACTION_H
 #define  BDG_PALO_BE_SRC_HTTP_DOWNLOAD_ACTION_H
 
+#include <memory>
+
 #include "exec/csv_scanner.h"
 #include "exec/scan_node.h"
 #include "runtime/descriptors.h"
@@ -24,23 +26,47 @@
 namespace palo {
 
 class ExecEnv;
+class ThreadPool;
+struct ChecksumCtx;
 
 // A simple handler that serves incoming HTTP requests of file-download to send their respective HTTP responses.
 //
-// TODO(lingbin): implements two useful header ('If-Modified-Since' and 'RANGE') to reduce
-// transmission consumption.
+// TODO(lingbin): implements 'If-Modified-Since' header to reduce transmission consumption.
 // We use parameter named 'file' to specify the static resource path, it is an absolute path.
+//
+// A single byte range in the 'Range' header is served as 206(Partial Content), so a
+// clone can download one file concurrently and resume it. With 'checksum=md5', the
+// reply is the md5sum of the file, or of the 'length' bytes of it starting at 'offset'.
+// Checksums are computed by config::download_checksum_thread_num threads, so reading
+// a large file does not block the other requests of the http thread.
 class DownloadAction : public HttpHandler {
 public:
+    enum RangeType {
+        // no range, or one this handler ignores, the whole file is sent
+        RANGE_NONE,
+        RANGE_SATISFIABLE,
+        RANGE_NOT_SATISFIABLE
+    };
+
+    // Parses the value of a 'Range' header of a file of 'file_size' bytes into
+    // the range [*offset, *offset + *length). Only a single byte range is supported.
+    static RangeType parse_range(const std::string& range_header, int64_t file_size,
+                                 int64_t* offset, int64_t* length);
+
     DownloadAction(ExecEnv* exec_env, const std::vector<std::string>& allow_dirs);
 
     // for load error
     DownloadAction(ExecEnv* exec_env, const std::string& error_log_root_dir);
 
-    virtual ~DownloadAction() {}
+    virtual ~DownloadAction();
 
     void handle(HttpRequest *req) override;
 
+    void free_handler_ctx(void* ctx) override;
+
+    // Called on the http thread of 'ctx' when its checksum is computed.
+    void on_checksum_done(ChecksumCtx* ctx);
+
 private:
     enum DOWNLOAD_TYPE {
         NORMAL = 1,
@@ -58,6 +84,10 @@ private:
 
     void do_file_response(const std::string& dir_path, HttpRequest *req);
     void do_dir_response(const std::string& dir_path, HttpRequest *req);
+    void do_checksum_response(const std::string& file_path, HttpRequest *req);
+
+    // Computes the checksum of 'ctx', run by _checksum_pool.
+    void compute_checksum(ChecksumCtx* ctx);
 
     Status get_file_content(
             FILE* fp, char* buffer, int32_t buffer_size,
@@ -75,6 +105,8 @@ private:
     std::vector<std::string> _allow_paths;
     std::string _error_log_root_dir;
 
+    // NULL for error logs, which have no checksums
+    std::unique_ptr<ThreadPool> _checksum_pool;
 
 }; // end class DownloadAction
 
@@ -24,6 +24,7 @@
 #include <event2/http.h>
 #include <event2/http_struct.h>
 #include <event2/keyvalq_struct.h>
+#include <event2/thread.h>
 
 #include "common/logging.h"
 #include "service/brpc.h"
@@ -88,6 +89,9 @@ EvHttpServer::~EvHttpServer() {
 Status EvHttpServer::start() {
     // bind to 
     RETURN_IF_ERROR(_bind());
+    // handlers may hand a request to other threads, which activate events of the
+    // base of its connection to get back to it
+    evthread_use_pthreads();
     for (int i = 0; i < _num_workers; ++i) {
         auto worker = [this, i] () {
             LOG(INFO) << "EvHttpSerer worker start, id=" << i;
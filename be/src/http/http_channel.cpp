@@ -55,12 +55,13 @@ void HttpChannel::send_reply(
     evbuffer_free(evb);
 }
 
-void HttpChannel::send_file(HttpRequest* request, int fd, size_t off, size_t size) {
+void HttpChannel::send_file(HttpRequest* request, int fd, size_t off, size_t size,
+                            HttpStatus status) {
     auto evb = evbuffer_new();
     evbuffer_add_file(evb, fd, off, size);
     evhttp_send_reply(request->get_evhttp_request(),
-                      HttpStatus::OK,
-                      defalut_reason(HttpStatus::OK).c_str(), evb);
+                      status,
+                      defalut_reason(status).c_str(), evb);
     evbuffer_free(evb);
 }
 
@@ -224,18 +224,15 @@ struct AggregateFuncTraits<OLAP_FIELD_AGGREGATION_HLL_UNION, OLAP_FIELD_TYPE_HLL
         StringSlice* slice = reinterpret_cast<StringSlice*>(data);
         size_t hll_ptr = *(size_t*)(slice->data - sizeof(HllContext*));
         HllContext* context = (reinterpret_cast<HllContext*>(hll_ptr));
-        std::map<int, uint8_t> index_to_value;
+        int non_zero_registers = 0;
         if (context->has_sparse_or_full ||
                 context->hash64_set->size() > HLL_EXPLICLIT_INT64_NUM) {
             HllSetHelper::set_max_register(context->registers, HLL_REGISTERS_COUNT,
                                            *(context->hash64_set));
-            for (int i = 0; i < HLL_REGISTERS_COUNT; i++) {
-                if (context->registers[i] != 0) {
-                    index_to_value[i] = context->registers[i];
-                }
-            }
+            non_zero_registers = HllSetHelper::count_non_zero_registers(
+                    context->registers, HLL_REGISTERS_COUNT);
         }
-        int sparse_set_len = index_to_value.size() *
+        int sparse_set_len = non_zero_registers *
             (sizeof(HllSetResolver::SparseIndexType)
              + sizeof(HllSetResolver::SparseValueType))
             + sizeof(HllSetResolver::SparseLengthValueType);
@@ -245,9 +242,10 @@ struct AggregateFuncTraits<OLAP_FIELD_AGGREGATION_HLL_UNION, OLAP_FIELD_TYPE_HLL
             // full set
             HllSetHelper::set_full(slice->data, context->registers,
                                    HLL_REGISTERS_COUNT, result_len);
-        } else if (index_to_value.size() > 0) {
+        } else if (non_zero_registers > 0) {
             // sparse set
-            HllSetHelper::set_sparse(slice->data, index_to_value, result_len);
+            HllSetHelper::set_sparse(slice->data, context->registers,
+                                     HLL_REGISTERS_COUNT, result_len);
         } else if (context->hash64_set->size() > 0) {
             // expliclit set
             HllSetHelper::set_expliclit(slice->data, *(context->hash64_set), result_len);
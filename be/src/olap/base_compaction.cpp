@@ -15,12 +15,16 @@
 
 #include "olap/base_compaction.h"
 
+#include <stdio.h>
 #include <algorithm>
 #include <list>
 #include <map>
 #include <string>
 #include <vector>
 
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
 #include "olap/delete_handler.h"
 #include "olap/merger.h"
 #include "olap/olap_data.h"
@@ -28,11 +32,14 @@
 #include "olap/olap_header.h"
 #include "olap/olap_index.h"
 #include "olap/olap_table.h"
+#include "olap/row_cursor.h"
 #include "olap/utils.h"
+#include "olap/wrapper_field.h"
 #include "util/palo_metrics.h"
 
 using std::list;
 using std::map;
+using std::pair;
 using std::string;
 using std::vector;
 
@@ -434,12 +441,58 @@ OLAPStatus BaseCompaction::_do_base_compaction(VersionHash new_base_version_hash
         }
         _table->release_header_lock();
 
-        Merger merger(_table, new_base, READER_BASE_COMPACTION);
-        res = merger.merge(
-                *base_data_sources, use_simple_merge, &merged_rows, &filted_rows);
-        if (res == OLAP_SUCCESS) {
-            *row_count = merger.row_count();
-            *selectivities = merger.selectivities();
+        // 数据量大时按key区间切分，用本磁盘空闲的merge slot并行merge。
+        // 只有一个非空版本时仍走Merger，以便直接建硬链接
+        uint64_t source_rows = 0;
+        uint32_t num_no_empty = 0;
+        OLAPIndex* base_index = NULL;
+        for (IData* i_data : *base_data_sources) {
+            source_rows += i_data->olap_index()->num_rows();
+            num_no_empty += i_data->empty() ? 0 : 1;
+            if (i_data->version().first == 0) {
+                base_index = i_data->olap_index();
+            }
+        }
+        uint64_t num_ranges = source_rows
+                / std::max<int64_t>(config::base_compaction_min_rows_per_range, 1);
+        bool use_slots = num_ranges > 1 && base_index != NULL
+                && (num_no_empty > 1 || !use_simple_merge);
+        uint32_t slots = 1;
+        if (use_slots) {
+            slots = OLAPEngine::get_instance()->acquire_base_compaction_slots(
+                    _table->storage_root_path_name(),
+                    std::min<uint64_t>(num_ranges, UINT32_MAX));
+        }
+
+        vector<RowCursor*> boundaries;
+        if (slots > 1) {
+            res = _split_key_ranges(base_index, slots, &boundaries);
+        }
+
+        if (res != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("fail to split key ranges. [table='%s' res=%d]",
+                             _table->full_name().c_str(), res);
+        } else if (boundaries.empty()) {
+            Merger merger(_table, new_base, READER_BASE_COMPACTION);
+            res = merger.merge(
+                    *base_data_sources, use_simple_merge, &merged_rows, &filted_rows);
+            if (res == OLAP_SUCCESS) {
+                *row_count = merger.row_count();
+                *selectivities = merger.selectivities();
+            }
+        } else {
+            OLAP_LOG_INFO("merge new base by key ranges. [table='%s' ranges=%lu]",
+                          _table->full_name().c_str(), boundaries.size() + 1);
+            res = _merge_key_ranges(new_base, boundaries, base_data_sources,
+                                    &merged_rows, &filted_rows, selectivities, row_count);
+        }
+
+        for (RowCursor* boundary : boundaries) {
+            SAFE_DELETE(boundary);
+        }
+        if (use_slots) {
+            OLAPEngine::get_instance()->release_base_compaction_slots(
+                    _table->storage_root_path_name(), slots);
         }
     } else {
         OLAP_LOG_WARNING("unknown data file type. [type=%s]",
@@ -500,6 +553,259 @@ OLAPStatus BaseCompaction::_do_base_compaction(VersionHash new_base_version_hash
     return OLAP_SUCCESS;
 }
 
+OLAPStatus BaseCompaction::_split_key_ranges(OLAPIndex* base_index,
+                                             uint32_t num_ranges,
+                                             vector<RowCursor*>* boundaries) {
+    size_t rows_per_block = base_index->current_num_rows_per_row_block();
+    uint64_t num_blocks = rows_per_block == 0 ? 0 : base_index->num_rows() / rows_per_block;
+    if (num_blocks < num_ranges) {
+        return OLAP_SUCCESS;
+    }
+    int64_t blocks_per_range = num_blocks / num_ranges;
+
+    RowBlockPosition pos;
+    if (base_index->find_first_row_block(&pos) != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to get first block pos. [table='%s']",
+                         _table->full_name().c_str());
+        return OLAP_ERR_TABLE_INDEX_FIND_ERROR;
+    }
+
+    RowCursor entry_key;
+    if (entry_key.init(_table->tablet_schema(), _table->num_short_key_fields()) != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to init row cursor.");
+        return OLAP_ERR_INIT_FAILED;
+    }
+
+    EntrySlice entry;
+    for (uint32_t i = 1; i < num_ranges; ++i) {
+        OLAPStatus res = base_index->advance_row_block(blocks_per_range, &pos);
+        if (res == OLAP_ERR_INDEX_EOF) {
+            break;
+        } else if (res != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("fail to advance row block. [res=%d]", res);
+            return res;
+        }
+
+        if (base_index->get_row_block_entry(pos, &entry) != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("get block entry failed.");
+            return OLAP_ERR_ROWBLOCK_FIND_ROW_EXCEPTION;
+        }
+        entry_key.attach(entry.data);
+
+        // 一个短key的行可能跨多个行块，同一个key只能作为一个区间的起点
+        if (!boundaries->empty() && entry_key.cmp(*boundaries->back()) <= 0) {
+            continue;
+        }
+
+        RowCursor* boundary = new(std::nothrow) RowCursor();
+        if (boundary == NULL) {
+            OLAP_LOG_WARNING("fail to new RowCursor.");
+            return OLAP_ERR_MALLOC_ERROR;
+        }
+        boundaries->push_back(boundary);
+        if (boundary->init(_table->tablet_schema(), _table->num_short_key_fields())
+                != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("fail to init row cursor.");
+            return OLAP_ERR_INIT_FAILED;
+        }
+        boundary->allocate_memory_for_string_type(_table->tablet_schema());
+        boundary->copy_without_pool(entry_key);
+    }
+
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus BaseCompaction::_merge_key_ranges(OLAPIndex* new_base,
+                                             const vector<RowCursor*>& boundaries,
+                                             vector<IData*>* base_data_sources,
+                                             uint64_t* merged_rows,
+                                             uint64_t* filted_rows,
+                                             vector<uint32_t>* selectivities,
+                                             uint64_t* row_count) {
+    vector<Version> versions;
+    for (IData* i_data : *base_data_sources) {
+        versions.push_back(i_data->version());
+    }
+
+    OLAPStatus res = OLAP_SUCCESS;
+    size_t num_ranges = boundaries.size() + 1;
+    vector<KeyRangeMerge> ranges(num_ranges);
+    for (size_t i = 0; i < num_ranges; ++i) {
+        KeyRangeMerge& range = ranges[i];
+        range.start_key = i == 0 ? NULL : boundaries[i - 1];
+        range.end_key = i + 1 == num_ranges ? NULL : boundaries[i];
+        range.index = new (std::nothrow) OLAPIndex(_table.get(),
+                                                   _new_base_version,
+                                                   new_base->version_hash() + i + 1,
+                                                   false,
+                                                   0, 0);
+        if (range.index == NULL) {
+            OLAP_LOG_WARNING("fail to new OLAPIndex.");
+            res = OLAP_ERR_MALLOC_ERROR;
+            break;
+        }
+
+        // IData带有读的状态，每个线程需要自己的一份
+        if (i == 0) {
+            range.data_sources = *base_data_sources;
+            continue;
+        }
+        _table->obtain_header_rdlock();
+        _table->acquire_data_sources_by_versions(versions, &range.data_sources);
+        _table->release_header_lock();
+        range.own_data_sources = true;
+        if (range.data_sources.size() != versions.size()) {
+            OLAP_LOG_WARNING("fail to acquire data sources. [table='%s']",
+                             _table->full_name().c_str());
+            res = OLAP_ERR_VERSION_NOT_EXIST;
+            break;
+        }
+    }
+
+    if (res == OLAP_SUCCESS) {
+        boost::thread_group merge_threads;
+        for (KeyRangeMerge& range : ranges) {
+            merge_threads.create_thread(
+                    boost::bind(&BaseCompaction::_merge_key_range, this, &range));
+        }
+        merge_threads.join_all();
+    }
+
+    *merged_rows = 0;
+    *filted_rows = 0;
+    *row_count = 0;
+    vector<uint64_t> uniq_keys(_table->num_key_fields(), 0);
+    const RowCursor* prev_last_key = NULL;
+    for (KeyRangeMerge& range : ranges) {
+        if (range.own_data_sources) {
+            _table->release_data_sources(&range.data_sources);
+        }
+        if (res == OLAP_SUCCESS && range.res != OLAP_SUCCESS) {
+            res = range.res;
+        }
+        *merged_rows += range.merged_rows;
+        *filted_rows += range.filted_rows;
+        *row_count += range.row_count;
+        if (res != OLAP_SUCCESS || range.row_count == 0) {
+            continue;
+        }
+        for (size_t i = 0; i < uniq_keys.size() && i < range.uniq_keys.size(); ++i) {
+            uniq_keys[i] += range.uniq_keys[i];
+        }
+        // 区间按短key切分，短于短key的前缀组合可能跨越区间边界。区间内首行的每个
+        // 前缀都被计为新值，与前一个区间末行相同的前缀需要扣除
+        if (prev_last_key != NULL) {
+            size_t first_diff_id = 0;
+            res = prev_last_key->get_first_different_column_id(*range.first_key,
+                                                               &first_diff_id);
+            if (res != OLAP_SUCCESS) {
+                OLAP_LOG_WARNING("fail to get_first_different_column_id.");
+                continue;
+            }
+            for (size_t i = 0; i < first_diff_id && i < uniq_keys.size(); ++i) {
+                --uniq_keys[i];
+            }
+        }
+        prev_last_key = range.last_key.get();
+    }
+
+    if (res == OLAP_SUCCESS) {
+        res = _combine_key_ranges(new_base, &ranges);
+    }
+
+    for (KeyRangeMerge& range : ranges) {
+        if (range.index != NULL) {
+            range.index->delete_all_files();
+            SAFE_DELETE(range.index);
+        }
+    }
+
+    if (res != OLAP_SUCCESS) {
+        return res;
+    }
+
+    selectivities->resize(uniq_keys.size());
+    for (size_t i = 0; i < uniq_keys.size(); ++i) {
+        (*selectivities)[i] = static_cast<uint32_t>(*row_count / std::max(uniq_keys[i], 1UL));
+    }
+    return OLAP_SUCCESS;
+}
+
+void BaseCompaction::_merge_key_range(KeyRangeMerge* range) {
+    Merger merger(_table, range->index, READER_BASE_COMPACTION);
+    merger.set_key_range(range->start_key, range->end_key);
+    range->res = merger.merge(
+            range->data_sources, false, &range->merged_rows, &range->filted_rows);
+    if (range->res == OLAP_SUCCESS) {
+        range->row_count = merger.row_count();
+        range->uniq_keys = merger.uniq_keys();
+        merger.release_boundary_keys(&range->first_key, &range->last_key);
+    } else {
+        OLAP_LOG_WARNING("fail to merge key range. [table='%s' res=%d]",
+                         _table->full_name().c_str(), range->res);
+    }
+}
+
+OLAPStatus BaseCompaction::_combine_key_ranges(OLAPIndex* new_base,
+                                               vector<KeyRangeMerge>* ranges) {
+    // 区间按key的顺序排列，各区间的segment依次改名为new_base连续的segment后即是
+    // 整个新base。空的区间直接丢弃，除非所有区间都为空
+    uint32_t num_segments = 0;
+    vector<pair<WrapperField*, WrapperField*>> column_statistics;
+    for (size_t i = 0; i < ranges->size(); ++i) {
+        OLAPIndex* index = (*ranges)[i].index;
+        if ((*ranges)[i].row_count == 0 && !(num_segments == 0 && i + 1 == ranges->size())) {
+            continue;
+        }
+
+        for (uint32_t seg = 0; seg < index->num_segments(); ++seg) {
+            // 在改名前计入，失败时由new_base->delete_all_files()删除
+            new_base->set_num_segments(++num_segments);
+            string paths[2][2] = {
+                { _table->construct_index_file_path(
+                            index->version(), index->version_hash(), seg),
+                  _table->construct_index_file_path(
+                            new_base->version(), new_base->version_hash(), num_segments - 1) },
+                { _table->construct_data_file_path(
+                            index->version(), index->version_hash(), seg),
+                  _table->construct_data_file_path(
+                            new_base->version(), new_base->version_hash(), num_segments - 1) }
+            };
+            for (auto& path : paths) {
+                if (0 != rename(path[0].c_str(), path[1].c_str())) {
+                    OLAP_LOG_WARNING("fail to rename file. [from=%s to=%s] [%m]",
+                                     path[0].c_str(), path[1].c_str());
+                    return OLAP_ERR_OS_ERROR;
+                }
+            }
+        }
+        // 文件都已归new_base所有
+        index->set_num_segments(0);
+
+        if (!index->has_column_statistics()) {
+            continue;
+        }
+        const vector<pair<WrapperField*, WrapperField*>>& stats = index->get_column_statistics();
+        if (column_statistics.empty()) {
+            column_statistics = stats;
+            continue;
+        }
+        for (size_t col = 0; col < column_statistics.size(); ++col) {
+            if (stats[col].first->cmp(column_statistics[col].first) < 0) {
+                column_statistics[col].first = stats[col].first;
+            }
+            if (stats[col].second->cmp(column_statistics[col].second) > 0) {
+                column_statistics[col].second = stats[col].second;
+            }
+        }
+    }
+
+    if (!column_statistics.empty()) {
+        return new_base->set_column_statistics(column_statistics);
+    }
+    return OLAP_SUCCESS;
+}
+
 OLAPStatus BaseCompaction::_update_header(const vector<uint32_t>& selectivities,
                                                 uint64_t row_count,
                                                 vector<OLAPIndex*>* unused_olap_indices) {
@@ -17,6 +17,7 @@
 #define BDG_PALO_BE_SRC_OLAP_BASE_COMPACTION_H
 
 #include <map>
+#include <memory>
 #include <string>
 
 #include "olap/olap_common.h"
@@ -27,6 +28,7 @@
 namespace palo {
 
 class IData;
+class RowCursor;
 
 // @brief 实现对START_BASE_COMPACTION命令的处理逻辑，并返回处理结果
 class BaseCompaction {
@@ -96,6 +98,57 @@ private:
                                   std::vector<IData*>* base_data_sources,
                                   std::vector<uint32_t>* selectivities,
                                   uint64_t* row_count);
+
+    // 一个key区间的merge
+    struct KeyRangeMerge {
+        KeyRangeMerge() :
+                start_key(NULL),
+                end_key(NULL),
+                index(NULL),
+                own_data_sources(false),
+                res(OLAP_SUCCESS),
+                merged_rows(0),
+                filted_rows(0),
+                row_count(0) {}
+
+        // [start_key, end_key), NULL表示不限
+        const RowCursor* start_key;
+        const RowCursor* end_key;
+        // 区间先写成一个临时的版本，与新base同version，以version_hash区分
+        OLAPIndex* index;
+        std::vector<IData*> data_sources;
+        bool own_data_sources;
+        OLAPStatus res;
+        uint64_t merged_rows;
+        uint64_t filted_rows;
+        uint64_t row_count;
+        std::vector<uint64_t> uniq_keys;
+        // 区间内首行和末行的key列，用于合并相邻区间的前缀统计
+        std::unique_ptr<RowCursor> first_key;
+        std::unique_ptr<RowCursor> last_key;
+    };
+
+    // 按base版本的短key索引把key空间切成至多num_ranges个行块数相近的区间
+    //
+    // 输出参数：
+    // - boundaries: 除第一个区间外，各区间的起始key，由调用者释放
+    OLAPStatus _split_key_ranges(OLAPIndex* base_index,
+                                 uint32_t num_ranges,
+                                 std::vector<RowCursor*>* boundaries);
+
+    // 每个key区间各用一个线程merge，成功后把各区间的segment按key的顺序
+    // 依次改名为new_base的segment，合成一个版本
+    OLAPStatus _merge_key_ranges(OLAPIndex* new_base,
+                                 const std::vector<RowCursor*>& boundaries,
+                                 std::vector<IData*>* base_data_sources,
+                                 uint64_t* merged_rows,
+                                 uint64_t* filted_rows,
+                                 std::vector<uint32_t>* selectivities,
+                                 uint64_t* row_count);
+
+    void _merge_key_range(KeyRangeMerge* range);
+
+    OLAPStatus _combine_key_ranges(OLAPIndex* new_base, std::vector<KeyRangeMerge>* ranges);
    
     // 更新Header使得修改对外可见
     // 
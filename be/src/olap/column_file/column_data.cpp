@@ -125,6 +125,7 @@ OLAPStatus ColumnData::_seek_to_block(const RowBlockPosition& block_pos, bool wi
             OLAP_LOG_WARNING("fail to malloc segment reader.");
             return OLAP_ERR_MALLOC_ERROR;
         }
+        _segment_reader->set_load_key_bloom_filter(_load_key_bloom_filter);
 
         _current_segment = block_pos.segment; 
         auto res = _segment_reader->init(_is_using_cache);
@@ -332,6 +333,73 @@ const RowCursor* ColumnData::seek_and_get_current_row(const RowBlockPosition& po
     return _current_row();
 }
 
+OLAPStatus ColumnData::lookup_row(
+        const RowCursor& key, uint64_t key_hash, const RowCursor** row) {
+    _is_normal_read = true;
+    _end_key_is_set = false;
+    _load_key_bloom_filter = true;
+
+    RowBlockPosition position;
+    auto res = _find_position_by_short_key(key, false, &position);
+    if (res != OLAP_SUCCESS) {
+        return res;
+    }
+
+    // rows with the short key of 'key' may span segments, this is the last
+    // segment that may hold 'key'
+    uint32_t last_segment = _olap_index->num_segments() - 1;
+    RowBlockPosition end_position;
+    res = _olap_index->find_short_key(key, &_short_key_cursor, true, &end_position);
+    if (res == OLAP_SUCCESS) {
+        last_segment = end_position.segment;
+    } else if (res != OLAP_ERR_INDEX_EOF) {
+        OLAP_LOG_WARNING("find row block failed. [res=%d]", res);
+        return res;
+    }
+
+    while (true) {
+        res = _seek_to_block(position, true);
+        if (res != OLAP_SUCCESS) {
+            return res;
+        }
+        if (_segment_reader->key_may_exist(key_hash)) {
+            break;
+        }
+        if (position.segment >= last_segment) {
+            return OLAP_ERR_DATA_EOF;
+        }
+        position.segment++;
+        position.data_offset = 0;
+    }
+
+    do {
+        res = _get_block(true);
+        if (res != OLAP_SUCCESS) {
+            return res;
+        }
+        // rows are sorted by key, find the first one not less than 'key'
+        size_t low = _read_block->pos();
+        size_t high = _read_block->limit();
+        while (low < high) {
+            size_t mid = low + (high - low) / 2;
+            _read_block->get_row(mid, &_cursor);
+            if (_cursor.cmp(key) < 0) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        _read_block->set_pos(low);
+    } while (!_read_block->has_remaining());
+
+    const RowCursor* current = _current_row();
+    if (current->cmp(key) != 0) {
+        return OLAP_ERR_DATA_EOF;
+    }
+    *row = current;
+    return OLAP_SUCCESS;
+}
+
 OLAPStatus ColumnData::prepare_block_read(
         const RowCursor* start_key, bool find_start_key,
         const RowCursor* end_key, bool find_end_key,
@@ -64,6 +64,14 @@ public:
     // Only used to binary search in full-key find row
     const RowCursor* seek_and_get_current_row(const RowBlockPosition& position);
 
+    // Point lookup used by PointReader: find the row whose key columns equal
+    // 'key', which must contain all key columns. 'key_hash' is key.key_hash_code(),
+    // segments whose key bloom filter excludes it are skipped without reading any
+    // data block, and the row is found by a binary search in the block.
+    // Returns OLAP_ERR_DATA_EOF if there is no such row. '*row' is valid until
+    // the next read on this data.
+    OLAPStatus lookup_row(const RowCursor& key, uint64_t key_hash, const RowCursor** row);
+
     virtual uint64_t get_filted_rows();
 
 private:
@@ -113,6 +121,8 @@ private:
     bool _is_using_cache;
     bool _segment_eof = false;
     bool _need_eval_predicates = false;
+    // set by lookup_row, segment readers load the key bloom filter
+    bool _load_key_bloom_filter = false;
 
     std::vector<uint32_t> _return_columns;
     std::vector<uint32_t> _seek_columns;
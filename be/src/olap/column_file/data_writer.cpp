@@ -17,7 +17,10 @@
 
 #include <math.h>
 
+#include <boost/bind.hpp>
+
 #include "olap/column_file/segment_writer.h"
+#include "olap/olap_engine.h"
 #include "olap/olap_index.h"
 #include "olap/row_block.h"
 
@@ -33,9 +36,28 @@ ColumnDataWriter::ColumnDataWriter(SmartOLAPTable table, OLAPIndex* index, bool
         _num_rows(0),
         _block_id(0),
         _max_segment_size(OLAP_MAX_SEGMENT_FILE_SIZE),
-        _segment(0) {}
+        _segment(0),
+        _pipelined(false),
+        _encode_pool(NULL),
+        _full_blocks(NULL),
+        _free_blocks(NULL),
+        _sealed_segments(NULL),
+        _pipeline_res(OLAP_SUCCESS) {}
 
 ColumnDataWriter::~ColumnDataWriter() {
+    if (_pipelined) {
+        // 如果没有finalize, 剩下的数据不需要再写入
+        _set_pipeline_error(OLAP_ERR_OTHER_ERROR);
+        _stop_encoder();
+        _stop_writer();
+        for (RowBlock* row_block : _pipeline_blocks) {
+            SAFE_DELETE(row_block);
+        }
+        _row_block = NULL;
+        SAFE_DELETE(_full_blocks);
+        SAFE_DELETE(_free_blocks);
+        SAFE_DELETE(_sealed_segments);
+    }
     SAFE_DELETE(_row_block);
     SAFE_DELETE(_segment_writer);
 }
@@ -53,14 +75,6 @@ OLAPStatus ColumnDataWriter::init() {
     size *= OLAP_COLUMN_FILE_SEGMENT_SIZE_SCALE;
     _max_segment_size = (uint32_t)lround(size);
 
-    _row_block = new(std::nothrow) RowBlock(_table->tablet_schema());
-
-    if (NULL == _row_block) {
-        OLAP_LOG_WARNING("fail to new RowBlock. [table='%s']",
-                _table->full_name().c_str());
-        return OLAP_ERR_MALLOC_ERROR;
-    }
-
     res = _cursor.init(_table->tablet_schema());
     if (OLAP_SUCCESS != res) {
         OLAP_LOG_WARNING("fail to initiate row cursor. [res=%d]", res);
@@ -69,13 +83,8 @@ OLAPStatus ColumnDataWriter::init() {
 
     OLAP_LOG_DEBUG("init ColumnData writer. [table='%s' block_row_size=%lu]",
             _table->full_name().c_str(), _table->num_rows_per_row_block());
-    RowBlockInfo block_info(0U, _table->num_rows_per_row_block(), 0);
-    block_info.data_file_type = DataFileType::COLUMN_ORIENTED_FILE;
-    block_info.null_supported = true;
-
-    res = _row_block->init(block_info);
+    res = _create_row_block(&_row_block);
     if (OLAP_SUCCESS != res) {
-        OLAP_LOG_WARNING("fail to initiate row block. [res=%d]", res);
         return res;
     }
 
@@ -91,9 +100,135 @@ OLAPStatus ColumnDataWriter::init() {
         return res;
     }
 
+    if (_is_push_write && config::push_write_pipeline_depth > 0) {
+        res = _start_pipeline();
+        if (OLAP_SUCCESS != res) {
+            OLAP_LOG_WARNING("fail to start write pipeline. [res=%d]", res);
+            return res;
+        }
+    }
+
     return res;
 }
 
+OLAPStatus ColumnDataWriter::_create_row_block(RowBlock** row_block) {
+    *row_block = new(std::nothrow) RowBlock(_table->tablet_schema());
+    if (NULL == *row_block) {
+        OLAP_LOG_WARNING("fail to new RowBlock. [table='%s']",
+                _table->full_name().c_str());
+        return OLAP_ERR_MALLOC_ERROR;
+    }
+
+    RowBlockInfo block_info(0U, _table->num_rows_per_row_block(), 0);
+    block_info.data_file_type = DataFileType::COLUMN_ORIENTED_FILE;
+    block_info.null_supported = true;
+
+    OLAPStatus res = (*row_block)->init(block_info);
+    if (OLAP_SUCCESS != res) {
+        OLAP_LOG_WARNING("fail to initiate row block. [res=%d]", res);
+        return res;
+    }
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus ColumnDataWriter::_start_pipeline() {
+    _pipelined = true;
+    _encode_pool = OLAPEngine::get_instance()->column_encode_pool();
+
+    // 解析中的block, 排队等待编码的block和编码中的block
+    size_t depth = config::push_write_pipeline_depth;
+    _pipeline_blocks.push_back(_row_block);
+    _full_blocks = new BlockingQueue<RowBlock*>(depth);
+    _free_blocks = new BlockingQueue<RowBlock*>(depth + 2);
+    _sealed_segments = new BlockingQueue<SegmentWriter*>(1);
+    for (size_t i = 0; i < depth + 1; ++i) {
+        RowBlock* row_block = NULL;
+        OLAPStatus res = _create_row_block(&row_block);
+        _pipeline_blocks.push_back(row_block);
+        if (OLAP_SUCCESS != res) {
+            return res;
+        }
+        _free_blocks->blocking_put(row_block);
+    }
+
+    _encode_thread = boost::thread(boost::bind(&ColumnDataWriter::_encode_row_blocks, this));
+    _write_thread = boost::thread(boost::bind(&ColumnDataWriter::_write_segments, this));
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus ColumnDataWriter::_stop_encoder() {
+    _full_blocks->shutdown();
+    if (_encode_thread.joinable()) {
+        _encode_thread.join();
+    }
+    return _pipeline_res.load();
+}
+
+OLAPStatus ColumnDataWriter::_stop_writer() {
+    _sealed_segments->shutdown();
+    if (_write_thread.joinable()) {
+        _write_thread.join();
+    }
+    return _pipeline_res.load();
+}
+
+void ColumnDataWriter::_set_pipeline_error(OLAPStatus res) {
+    OLAPStatus expected = OLAP_SUCCESS;
+    _pipeline_res.compare_exchange_strong(expected, res);
+}
+
+OLAPStatus ColumnDataWriter::_queue_row_block() {
+    OLAPStatus res = _pipeline_res.load();
+    if (OLAP_SUCCESS != res) {
+        OLAP_LOG_WARNING("write pipeline failed. [table='%s' res=%d]",
+                _table->full_name().c_str(), res);
+        return res;
+    }
+
+    if (!_full_blocks->blocking_put(_row_block)
+            || !_free_blocks->blocking_get(&_row_block)) {
+        OLAP_LOG_WARNING("write pipeline is stopped. [table='%s']",
+                _table->full_name().c_str());
+        return OLAP_ERR_WRITER_DATA_WRITE_ERROR;
+    }
+    _row_index = 0U;
+    return OLAP_SUCCESS;
+}
+
+void ColumnDataWriter::_encode_row_blocks() {
+    RowBlock* row_block = NULL;
+    while (_full_blocks->blocking_get(&row_block)) {
+        if (OLAP_SUCCESS == _pipeline_res.load()) {
+            OLAPStatus res = _flush_row_block(row_block, false);
+            if (OLAP_SUCCESS != res) {
+                OLAP_LOG_WARNING("fail to encode row block. [table='%s' res=%d]",
+                        _table->full_name().c_str(), res);
+                _set_pipeline_error(res);
+            }
+            _num_rows += row_block->row_block_info().row_num;
+        }
+
+        // In order to reuse row_block, clear the row_block after finalize
+        row_block->clear();
+        _free_blocks->blocking_put(row_block);
+    }
+}
+
+void ColumnDataWriter::_write_segments() {
+    SegmentWriter* segment_writer = NULL;
+    while (_sealed_segments->blocking_get(&segment_writer)) {
+        if (OLAP_SUCCESS == _pipeline_res.load()) {
+            OLAPStatus res = segment_writer->write_file(true);
+            if (OLAP_SUCCESS != res) {
+                OLAP_LOG_WARNING("fail to write segment file. [table='%s' res=%d]",
+                        _table->full_name().c_str(), res);
+                _set_pipeline_error(res);
+            }
+        }
+        SAFE_DELETE(segment_writer);
+    }
+}
+
 OLAPStatus ColumnDataWriter::attached_by(RowCursor* row_cursor) {
     if (_row_index >= _table->num_rows_per_row_block()) {
         if (OLAP_SUCCESS != _flush_row_block(false)) {
@@ -108,6 +243,15 @@ OLAPStatus ColumnDataWriter::attached_by(RowCursor* row_cursor) {
 OLAPStatus ColumnDataWriter::finalize() {
     OLAPStatus res;
 
+    if (_pipelined) {
+        // 最后一个block由当前线程编码, 因为它不能触发新的segment
+        res = _stop_encoder();
+        if (OLAP_SUCCESS != res) {
+            OLAP_LOG_WARNING("fail to encode row blocks. [res=%d]", res);
+            return res;
+        }
+    }
+
     res =  _flush_row_block(true);
     if (OLAP_SUCCESS != res) {
         OLAP_LOG_WARNING("failed to flush data while attaching row cursor.[res=%d]", res);
@@ -120,6 +264,14 @@ OLAPStatus ColumnDataWriter::finalize() {
         return res;
     }
 
+    if (_pipelined) {
+        res = _stop_writer();
+        if (OLAP_SUCCESS != res) {
+            OLAP_LOG_WARNING("fail to write segment files. [res=%d]", res);
+            return res;
+        }
+    }
+
     res = _index->set_column_statistics(_column_statistics);
     if (res != OLAP_SUCCESS) {
         OLAP_LOG_WARNING("Fail to set delta pruning![res=%d]", res);
@@ -171,7 +323,13 @@ OLAPStatus ColumnDataWriter::_finalize_segment() {
     OLAPStatus res = OLAP_SUCCESS;
     uint32_t data_segment_size;
 
-    if (OLAP_SUCCESS != _segment_writer->finalize(&data_segment_size)) {
+    if (_pipelined) {
+        // 文件由写线程生成, 索引只需要文件的大小
+        res = _segment_writer->seal(&data_segment_size);
+    } else {
+        res = _segment_writer->finalize(&data_segment_size);
+    }
+    if (OLAP_SUCCESS != res) {
         OLAP_LOG_WARNING("fail to finish segment from olap_data.");
         return OLAP_ERR_WRITER_DATA_WRITE_ERROR;
     }
@@ -181,6 +339,14 @@ OLAPStatus ColumnDataWriter::_finalize_segment() {
         return OLAP_ERR_WRITER_INDEX_WRITE_ERROR;
     }
 
+    if (_pipelined && _sealed_segments->blocking_put(_segment_writer)) {
+        _segment_writer = NULL;
+        return res;
+    } else if (_pipelined) {
+        OLAP_LOG_WARNING("write pipeline is stopped.");
+        res = OLAP_ERR_WRITER_DATA_WRITE_ERROR;
+    }
+
     SAFE_DELETE(_segment_writer);
     return res;
 }
@@ -188,14 +354,22 @@ OLAPStatus ColumnDataWriter::_finalize_segment() {
 OLAPStatus ColumnDataWriter::_flush_row_block(RowBlock* row_block, bool is_finalized) {
     OLAPStatus res;
 
-    // 目标是将自己的block按条写入目标block中。
-    for (uint32_t i = 0; i < row_block->row_block_info().row_num; i++) {
-        row_block->get_row(i, &_cursor);
-        res = _segment_writer->write(&_cursor);
+    if (_pipelined && NULL != _encode_pool) {
+        res = _segment_writer->write_row_block(*row_block, _encode_pool);
         if (OLAP_SUCCESS != res) {
-            OLAP_LOG_WARNING("fail to write row to segment. [res=%d]", res);
+            OLAP_LOG_WARNING("fail to write row block to segment. [res=%d]", res);
             return OLAP_ERR_WRITER_DATA_WRITE_ERROR;
         }
+    } else {
+        // 目标是将自己的block按条写入目标block中。
+        for (uint32_t i = 0; i < row_block->row_block_info().row_num; i++) {
+            row_block->get_row(i, &_cursor);
+            res = _segment_writer->write(&_cursor);
+            if (OLAP_SUCCESS != res) {
+                OLAP_LOG_WARNING("fail to write row to segment. [res=%d]", res);
+                return OLAP_ERR_WRITER_DATA_WRITE_ERROR;
+            }
+        }
     }
 
     // 在OLAPIndex中记录的不是数据文件的偏移,而是block的编号
@@ -246,6 +420,10 @@ OLAPStatus ColumnDataWriter::_flush_row_block(bool is_finalized) {
         return OLAP_ERR_WRITER_ROW_BLOCK_ERROR;
     }
 
+    if (_pipelined && !is_finalized) {
+        return _queue_row_block();
+    }
+
     res = _flush_row_block(_row_block, is_finalized);
     if (OLAP_SUCCESS != res) {
         OLAP_LOG_WARNING("fail to flush row block. [res=%d]", res);
@@ -263,6 +441,7 @@ OLAPStatus ColumnDataWriter::_flush_row_block(bool is_finalized) {
 // 这个接口目前只使用在schema change的时候. 对于ColumnFile而言, 未来
 // 的schema change应该是轻量级的Schema change, 这个接口就只会用来进行
 // Roll up. 从OLAP Data创建Column File的roll up应该是非常少的.
+// Merger also writes the merged rows through it, one whole block at a time.
 OLAPStatus ColumnDataWriter::write_row_block(RowBlock* row_block) {
     OLAP_LOG_DEBUG("write block, block size = %d", row_block->row_block_info().row_num);
 
@@ -270,7 +449,18 @@ OLAPStatus ColumnDataWriter::write_row_block(RowBlock* row_block) {
         return OLAP_SUCCESS;
     }
 
-    return _flush_row_block(row_block, false);
+    if (_pipelined) {
+        // 流水线中segment由编码线程写入
+        OLAP_LOG_WARNING("push writer does not write row blocks.");
+        return OLAP_ERR_FUNC_NOT_IMPLEMENTED;
+    }
+
+    OLAPStatus res = _flush_row_block(row_block, false);
+    if (OLAP_SUCCESS != res) {
+        return res;
+    }
+    _num_rows += row_block->row_block_info().row_num;
+    return OLAP_SUCCESS;
 }
 
 uint64_t ColumnDataWriter::written_bytes() {
@@ -16,15 +16,32 @@
 #ifndef BDG_PALO_BE_SRC_OLAP_COLUMN_FILE_DATA_WRITER_H
 #define BDG_PALO_BE_SRC_OLAP_COLUMN_FILE_DATA_WRITER_H
 
+#include <atomic>
+
+#include <boost/thread/thread.hpp>
+
 #include "olap/row_block.h"
 #include "olap/writer.h"
+#include "util/blocking_queue.hpp"
 
 namespace palo {
 class RowBlock;
+class ThreadPool;
 namespace column_file {
 class SegmentWriter;
 
 // 列文件格式的Writer,接口参考IWriter中的定义
+//
+// A push writes through a pipeline of three stages when
+// config::push_write_pipeline_depth > 0:
+// 1. the caller parses rows into row blocks through attached_by() and next();
+// 2. full blocks are queued to the encode thread, which encodes and compresses them
+//    into the segment, each column by its own task of OLAPEngine::column_encode_pool();
+// 3. full segments are sealed and queued to the write thread, which writes and fsyncs
+//    their files.
+// At most push_write_pipeline_depth blocks wait for the encoder and one segment waits
+// for the writer. Errors of the encoder and the writer are returned by the next
+// attached_by() or by finalize().
 class ColumnDataWriter : public IWriter {
 public:
     ColumnDataWriter(SmartOLAPTable table, OLAPIndex* index, bool is_push_write);
@@ -40,6 +57,18 @@ private:
     OLAPStatus _finalize_segment();
     OLAPStatus _flush_row_block(RowBlock* row_block, bool is_finalized);
     OLAPStatus _flush_row_block(bool is_finalized);
+    OLAPStatus _create_row_block(RowBlock** row_block);
+
+    OLAPStatus _start_pipeline();
+    // Waits for the queued blocks to be encoded and stops the encode thread.
+    OLAPStatus _stop_encoder();
+    // Waits for the queued segments to be written and stops the write thread.
+    OLAPStatus _stop_writer();
+    // Hands the full _row_block to the encode thread and takes a free one.
+    OLAPStatus _queue_row_block();
+    void _encode_row_blocks();
+    void _write_segments();
+    void _set_pipeline_error(OLAPStatus res);
 
     OLAPIndex* _index;
     RowBlock* _row_block;      // 使用RowBlcok缓存要写入的数据
@@ -50,6 +79,18 @@ private:
     uint32_t _max_segment_size;
     uint32_t _segment;
 
+    bool _pipelined;
+    ThreadPool* _encode_pool;
+    // all row blocks of the pipeline, _row_block is one of them
+    std::vector<RowBlock*> _pipeline_blocks;
+    BlockingQueue<RowBlock*>* _full_blocks;
+    BlockingQueue<RowBlock*>* _free_blocks;
+    BlockingQueue<SegmentWriter*>* _sealed_segments;
+    boost::thread _encode_thread;
+    boost::thread _write_thread;
+    // first error of the encode thread or the write thread
+    std::atomic<OLAPStatus> _pipeline_res;
+
     DISALLOW_COPY_AND_ASSIGN(ColumnDataWriter);
 };
 
@@ -55,7 +55,9 @@ OutStream* OutStreamFactory::create_stream(
         uint32_t column_unique_id, StreamInfoMessage::Kind kind) {
     OutStream* stream = NULL;
 
-    if (StreamInfoMessage::ROW_INDEX == kind || StreamInfoMessage::BLOOM_FILTER == kind) {
+    if (StreamInfoMessage::ROW_INDEX == kind
+            || StreamInfoMessage::BLOOM_FILTER == kind
+            || StreamInfoMessage::KEY_BLOOM_FILTER == kind) {
         stream = new(std::nothrow) OutStream(_stream_buffer_size, NULL);
     } else {
         stream = new(std::nothrow) OutStream(_stream_buffer_size, _compressor);
@@ -83,6 +83,7 @@ SegmentReader::~SegmentReader() {
     for (auto& bf_it : _bloom_filters) {
         SAFE_DELETE(bf_it.second);
     }
+    SAFE_DELETE(_key_bloom_filter);
 
     for (auto handle : _cache_handle) {
         if (handle != nullptr) {
@@ -621,11 +622,7 @@ OLAPStatus SegmentReader::_load_index(bool is_using_cache) {
             continue;
         }
 
-        if ((_is_column_included(unique_column_id)
-                && message.kind() == StreamInfoMessage::ROW_INDEX)
-                || (_is_bf_column_included(unique_column_id)
-                && message.kind() == StreamInfoMessage::BLOOM_FILTER)) {
-        } else {
+        if (!_is_index_stream_included(message)) {
             continue;
         }
 
@@ -693,6 +690,27 @@ OLAPStatus SegmentReader::_load_index(bool is_using_cache) {
 
             // 每个index的entry数量应该一致, 也就是block的数量
             _block_count = index_message->entry_count();
+        } else if (message.kind() == StreamInfoMessage::KEY_BLOOM_FILTER) {
+            BloomFilterIndexReader* key_bf = new(std::nothrow) BloomFilterIndexReader;
+            if (key_bf == NULL) {
+                OLAP_LOG_WARNING("fail to malloc memory. [size=%lu]",
+                                 sizeof(BloomFilterIndexReader));
+                return OLAP_ERR_MALLOC_ERROR;
+            }
+
+            res = key_bf->init(stream_buffer, stream_length, is_using_cache,
+                    _header_message().key_bf_hash_function_num(),
+                    _header_message().key_bf_bit_num());
+            if (res != OLAP_SUCCESS) {
+                OLAP_LOG_WARNING("fail to init key bloom filter reader. [res=%d]", res);
+                SAFE_DELETE(key_bf);
+                return res;
+            }
+
+            // 整个segment只有一个entry, 不参与block数目的检查
+            SAFE_DELETE(_key_bloom_filter);
+            _key_bloom_filter = key_bf;
+            continue;
         } else {
             BloomFilterIndexReader* bf_message = new(std::nothrow) BloomFilterIndexReader;
             if (bf_message == NULL) {
@@ -771,7 +789,8 @@ OLAPStatus SegmentReader::_read_all_data_streams(size_t* buffer_size) {
         }
 
         if (message.kind() == StreamInfoMessage::ROW_INDEX ||
-            message.kind() == StreamInfoMessage::BLOOM_FILTER) {
+            message.kind() == StreamInfoMessage::BLOOM_FILTER ||
+            message.kind() == StreamInfoMessage::KEY_BLOOM_FILTER) {
             continue;
         }
 
@@ -124,6 +124,20 @@ public:
         _is_using_mmap = is_using_mmap;
     }
 
+    // 在init之前设置, init时一并加载segment的key bloom filter
+    void set_load_key_bloom_filter(bool load_key_bloom_filter) {
+        _load_key_bf = load_key_bloom_filter;
+    }
+
+    // key_hash由RowCursor::key_hash_code生成. 返回false时segment中一定没有这个key;
+    // 没有加载key bloom filter时总是返回true
+    bool key_may_exist(uint64_t key_hash) {
+        if (_key_bloom_filter == NULL || _key_bloom_filter->entry_count() == 0) {
+            return true;
+        }
+        return _key_bloom_filter->entry(0).test_hash(key_hash);
+    }
+
 private:
     typedef std::vector<ColumnId>::iterator ColumnIdIterator;
 
@@ -159,6 +173,21 @@ private:
         return _include_bf_columns.count(column_unique_id) != 0;
     }
 
+    // 判断一个流是否需要在_load_index中加载
+    inline bool _is_index_stream_included(const StreamInfoMessage& message) {
+        ColumnId unique_column_id = message.column_unique_id();
+        switch (message.kind()) {
+        case StreamInfoMessage::ROW_INDEX:
+            return _is_column_included(unique_column_id);
+        case StreamInfoMessage::BLOOM_FILTER:
+            return _is_bf_column_included(unique_column_id);
+        case StreamInfoMessage::KEY_BLOOM_FILTER:
+            return _load_key_bf;
+        default:
+            return false;
+        }
+    }
+
     // 加载文件和必要的文件信息
     OLAPStatus _load_segment_file();
 
@@ -247,10 +276,7 @@ private:
                 continue;
             }
 
-            if ((_is_column_included(unique_column_id)
-                    && message.kind() == StreamInfoMessage::ROW_INDEX)
-                    || (_is_bf_column_included(unique_column_id)
-                    && message.kind() == StreamInfoMessage::BLOOM_FILTER)) {
+            if (_is_index_stream_included(message)) {
                 ++included_row_index_stream_num;
             }
         }
@@ -322,6 +348,8 @@ private:
     std::map<StreamName, ReadOnlyFileStream*> _streams;      //需要读取的流
     UniqueIdEncodingMap _encodings_map;            // 保存encoding
     std::map<ColumnId, BloomFilterIndexReader*> _bloom_filters;
+    bool _load_key_bf = false;
+    BloomFilterIndexReader* _key_bloom_filter = NULL;
     Decompressor _decompressor;                    //根据压缩格式，设置的解压器
     ByteBuffer* _mmap_buffer;
 
@@ -15,10 +15,19 @@
 
 #include "olap/column_file/segment_writer.h"
 
+#include <unistd.h>
+
+#include <boost/bind.hpp>
+
+#include "olap/column_file/bloom_filter.hpp"
+#include "olap/column_file/bloom_filter_writer.h"
 #include "olap/column_file/column_writer.h"
 #include "olap/column_file/out_stream.h"
 #include "olap/file_helper.h"
+#include "olap/row_block.h"
 #include "olap/utils.h"
+#include "util/count_down_latch.hpp"
+#include "util/thread_pool.hpp"
 
 
 namespace palo {
@@ -43,6 +52,10 @@ SegmentWriter::~SegmentWriter() {
             it != _root_writers.end(); ++it) {
         SAFE_DELETE(*it);
     }
+
+    for (RowCursor* cursor : _column_cursors) {
+        SAFE_DELETE(cursor);
+    }
 }
 
 OLAPStatus SegmentWriter::init(uint32_t write_mbytes_per_sec) {
@@ -107,11 +120,95 @@ OLAPStatus SegmentWriter::write(RowCursor* row_cursor) {
         }
     }
 
+    if (_table->keys_type() == UNIQUE_KEYS) {
+        _key_hashes.push_back(row_cursor->key_hash_code());
+    }
+
     ++_row_count;
     ++_row_in_block;
     return res;
 }
 
+OLAPStatus SegmentWriter::write_row_block(const RowBlock& row_block, ThreadPool* encode_pool) {
+    if (_column_cursors.empty()) {
+        for (size_t i = 0; i < _root_writers.size(); ++i) {
+            RowCursor* cursor = new(std::nothrow) RowCursor();
+            if (NULL == cursor) {
+                OLAP_LOG_WARNING("fail to allocate RowCursor");
+                return OLAP_ERR_MALLOC_ERROR;
+            }
+            _column_cursors.push_back(cursor);
+
+            OLAPStatus res = cursor->init(_table->tablet_schema());
+            if (OLAP_SUCCESS != res) {
+                OLAP_LOG_WARNING("fail to init row cursor. [res=%d]", res);
+                return res;
+            }
+        }
+    }
+
+    // 各列的writer只使用自己的流, 可以并行写入
+    std::vector<OLAPStatus> results(_root_writers.size(), OLAP_SUCCESS);
+    CountDownLatch latch(_root_writers.size());
+    for (size_t i = 0; i < _root_writers.size(); ++i) {
+        if (!encode_pool->offer(boost::bind(&SegmentWriter::_write_column, this, i,
+                                            &row_block, &results[i], &latch))) {
+            results[i] = OLAP_ERR_OTHER_ERROR;
+            latch.count_down();
+        }
+    }
+    latch.await();
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        if (OLAP_SUCCESS != results[i]) {
+            OLAP_LOG_WARNING("fail to write column. [column_id=%u res=%d]",
+                             _root_writers[i]->column_id(), results[i]);
+            return results[i];
+        }
+    }
+
+    // 与write()相同的计数, 索引项已经由各列的任务生成
+    bool unique_keys = _table->keys_type() == UNIQUE_KEYS;
+    for (uint32_t i = 0; i < row_block.row_block_info().row_num; ++i) {
+        if (_row_in_block == _table->num_rows_per_row_block()) {
+            ++_block_count;
+            _row_in_block = 0;
+        }
+        if (unique_keys) {
+            // 各列的任务已经结束, 可以复用它们的cursor
+            row_block.get_row(i, _column_cursors[0]);
+            _key_hashes.push_back(_column_cursors[0]->key_hash_code());
+        }
+        ++_row_count;
+        ++_row_in_block;
+    }
+    return OLAP_SUCCESS;
+}
+
+void SegmentWriter::_write_column(size_t index, const RowBlock* row_block,
+                                  OLAPStatus* res, CountDownLatch* latch) {
+    ColumnWriter* writer = _root_writers[index];
+    RowCursor* cursor = _column_cursors[index];
+    uint64_t row_in_block = _row_in_block;
+    for (uint32_t i = 0; i < row_block->row_block_info().row_num; ++i) {
+        if (row_in_block == _table->num_rows_per_row_block()) {
+            *res = writer->create_row_index_entry();
+            if (OLAP_SUCCESS != *res) {
+                break;
+            }
+            row_in_block = 0;
+        }
+
+        row_block->get_row(i, cursor);
+        *res = writer->write(cursor);
+        if (OLAP_UNLIKELY(OLAP_SUCCESS != *res)) {
+            break;
+        }
+        ++row_in_block;
+    }
+    latch->count_down();
+}
+
 uint64_t SegmentWriter::estimate_segment_size() {
     uint64_t result = 0;
 
@@ -167,6 +264,14 @@ OLAPStatus SegmentWriter::_make_file_header(ColumnDataHeaderMessage* file_header
         }
     }
 
+    if (!_key_hashes.empty()) {
+        res = _write_key_bloom_filter(file_header);
+        if (OLAP_SUCCESS != res) {
+            OLAP_LOG_WARNING("fail to write key bloom filter. [res=%d]", res);
+            return res;
+        }
+    }
+
     uint64_t index_length = 0;
     uint64_t data_length = 0;
 
@@ -191,7 +296,8 @@ OLAPStatus SegmentWriter::_make_file_header(ColumnDataHeaderMessage* file_header
         stream_info->set_kind(it->first.kind());
 
         if (it->first.kind() == StreamInfoMessage::ROW_INDEX || 
-                it->first.kind() == StreamInfoMessage::BLOOM_FILTER) {
+                it->first.kind() == StreamInfoMessage::BLOOM_FILTER ||
+                it->first.kind() == StreamInfoMessage::KEY_BLOOM_FILTER) {
             index_length += stream->get_stream_length();
         } else {
             data_length += stream->get_stream_length();
@@ -207,18 +313,64 @@ OLAPStatus SegmentWriter::_make_file_header(ColumnDataHeaderMessage* file_header
     return res;
 }
 
+OLAPStatus SegmentWriter::_write_key_bloom_filter(ColumnDataHeaderMessage* file_header) {
+    BloomFilter* bf = new(std::nothrow) BloomFilter();
+    if (NULL == bf || !bf->init(_key_hashes.size(), _table->bloom_filter_fpp())) {
+        OLAP_LOG_WARNING("fail to init key bloom filter. [rows=%lu]", _key_hashes.size());
+        SAFE_DELETE(bf);
+        return OLAP_ERR_MALLOC_ERROR;
+    }
+    for (uint64_t hash : _key_hashes) {
+        bf->add_hash(hash);
+    }
+    file_header->set_key_bf_hash_function_num(bf->hash_function_num());
+    file_header->set_key_bf_bit_num(bf->bit_num());
+
+    // 和普通的bloom filter流格式相同, 只有一个entry
+    BloomFilterIndexWriter bf_index;
+    OLAPStatus res = bf_index.add_bloom_filter(bf);
+    if (OLAP_SUCCESS != res) {
+        SAFE_DELETE(bf);
+        return res;
+    }
+
+    // 流挂在第一个key列上, 读取时随key列一起被选中
+    OutStream* stream = _stream_factory->create_stream(
+            _table->tablet_schema()[0].unique_id, StreamInfoMessage::KEY_BLOOM_FILTER);
+    if (NULL == stream) {
+        OLAP_LOG_WARNING("fail to create key bloom filter stream");
+        return OLAP_ERR_MALLOC_ERROR;
+    }
+
+    res = bf_index.write_to_buffer(stream);
+    if (OLAP_SUCCESS != res) {
+        OLAP_LOG_WARNING("fail to write key bloom filter stream");
+        return res;
+    }
+
+    res = stream->flush();
+    if (OLAP_SUCCESS != res) {
+        OLAP_LOG_WARNING("fail to flush key bloom filter stream");
+        return res;
+    }
+
+    _key_hashes.clear();
+    return OLAP_SUCCESS;
+}
+
 // 之前所有的数据都缓存在内存里, 现在创建文件, 写入数据
 OLAPStatus SegmentWriter::finalize(uint32_t* segment_file_size) {
-    OLAPStatus res = OLAP_SUCCESS;
-    FileHandler file_handle;
-    FileHeader<ColumnDataHeaderMessage> file_header;
-
-    if (OLAP_SUCCESS != (res = file_handle.open_with_mode(
-            _file_name, O_CREAT | O_EXCL | O_WRONLY , S_IRUSR | S_IWUSR))) {
-        OLAP_LOG_WARNING("fail to open file. [file_name=%s]", _file_name.c_str());
+    OLAPStatus res = seal(segment_file_size);
+    if (OLAP_SUCCESS != res) {
         return res;
     }
 
+    return write_file(false);
+}
+
+OLAPStatus SegmentWriter::seal(uint32_t* segment_file_size) {
+    OLAPStatus res = OLAP_SUCCESS;
+
     if (_row_in_block > 0) {
         res = create_row_index_entry();
         if (OLAP_SUCCESS != res) {
@@ -226,26 +378,53 @@ OLAPStatus SegmentWriter::finalize(uint32_t* segment_file_size) {
         }
     }
 
-    res = _make_file_header(file_header.mutable_message());
+    res = _make_file_header(_file_header.mutable_message());
     if (OLAP_SUCCESS != res) {
         OLAP_LOG_WARNING("fail to make file header. [res=%d]", res);
         return res;
     }
 
-    res = file_header.prepare(&file_handle);
+    FileHandler file_handle;
+    res = _file_header.prepare(&file_handle);
     if (OLAP_SUCCESS != res) {
-        OLAP_LOG_WARNING("write file header error. [err=%m]");
+        OLAP_LOG_WARNING("prepare file header error. [file_name=%s]", _file_name.c_str());
+        return res;
+    }
+
+    // 文件由FileHeader和没有被掐掉的流依次组成, 写入之前就可以确定长度和校验值
+    uint32_t checksum = CRC32_INIT;
+    uint64_t file_length = _file_header.size();
+    for (std::map<StreamName, OutStream*>::const_iterator it = _stream_factory->streams().begin();
+            it != _stream_factory->streams().end(); ++it) {
+        OutStream* stream = it->second;
+        if (!stream->is_suppressed()) {
+            checksum = stream->crc32(checksum);
+            file_length += stream->get_stream_length();
+        }
+    }
+
+    _file_header.set_file_length(file_length);
+    _file_header.set_checksum(checksum);
+    *segment_file_size = file_length;
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus SegmentWriter::write_file(bool sync) {
+    OLAPStatus res = OLAP_SUCCESS;
+    FileHandler file_handle;
+
+    if (OLAP_SUCCESS != (res = file_handle.open_with_mode(
+            _file_name, O_CREAT | O_EXCL | O_WRONLY , S_IRUSR | S_IWUSR))) {
+        OLAP_LOG_WARNING("fail to open file. [file_name=%s]", _file_name.c_str());
         return res;
     }
 
     // 跳过FileHeader
-    if (-1 == file_handle.seek(file_header.size(), SEEK_SET)) {
+    if (-1 == file_handle.seek(_file_header.size(), SEEK_SET)) {
         OLAP_LOG_WARNING("lseek header file error. [err=%m]");
         return OLAP_ERR_IO_ERROR;
     }
 
-    uint32_t checksum = CRC32_INIT;
-
     // 写入数据
     for (std::map<StreamName, OutStream*>::const_iterator it = _stream_factory->streams().begin();
             it != _stream_factory->streams().end(); ++it) {
@@ -253,7 +432,6 @@ OLAPStatus SegmentWriter::finalize(uint32_t* segment_file_size) {
 
         // 输出没有被掐掉的流
         if (!stream->is_suppressed()) {
-            checksum = stream->crc32(checksum);
             OLAP_LOG_DEBUG("stream id = %u, type = %d",
                     it->first.unique_column_id(),
                     it->first.kind());
@@ -267,18 +445,26 @@ OLAPStatus SegmentWriter::finalize(uint32_t* segment_file_size) {
         }
     }
 
-    uint64_t file_length = file_handle.tell();
-    file_header.set_file_length(file_length);
-    file_header.set_checksum(checksum);
-    *segment_file_size = file_length;
+    if (file_handle.tell() != static_cast<off_t>(_file_header.file_length())) {
+        OLAP_LOG_WARNING("file length is not the sealed one. [file_name=%s length=%ld "
+                         "sealed_length=%lu]",
+                         _file_name.c_str(), file_handle.tell(), _file_header.file_length());
+        return OLAP_ERR_WRITER_DATA_WRITE_ERROR;
+    }
 
     // 写入更新之后的FileHeader
-    res = file_header.serialize(&file_handle);
+    res = _file_header.serialize(&file_handle);
     if (OLAP_SUCCESS != res) {
         OLAP_LOG_WARNING("write file header error. [err=%m]");
         return res;
     }
 
+    // FileHandler::sync()不做任何事
+    if (sync && 0 != ::fdatasync(file_handle.fd())) {
+        OLAP_LOG_WARNING("fail to sync file. [file_name=%s err=%m]", _file_name.c_str());
+        return OLAP_ERR_IO_ERROR;
+    }
+
     res = file_handle.close();
     if (OLAP_SUCCESS != res) {
         OLAP_LOG_WARNING("fail to close file. [err=%m]");
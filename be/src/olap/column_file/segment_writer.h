@@ -16,15 +16,21 @@
 #ifndef BDG_PALO_BE_SRC_OLAP_COLUMN_FILE_SEGMENT_WRITER_H
 #define BDG_PALO_BE_SRC_OLAP_COLUMN_FILE_SEGMENT_WRITER_H
 
+#include <gen_cpp/column_data_file.pb.h>
+
+#include "olap/file_helper.h"
 #include "olap/olap_define.h"
 #include "olap/writer.h"
 
 namespace palo {
+class CountDownLatch;
+class RowBlock;
+class ThreadPool;
+
 namespace column_file {
 
 class ColumnWriter;
 class OutStreamFactory;
-class ColumnDataHeaderMessage;
 
 // 列文件格式的Writer,接口参考IWriter中的定义
 class SegmentWriter {
@@ -36,6 +42,8 @@ public:
     OLAPStatus init(uint32_t write_mbytes_per_sec);
     // 写入一行数据, 使用row_cursor读取每个列
     OLAPStatus write(RowCursor* row_cursor);
+    // 写入row_block的所有行, 每一列由encode_pool中的一个任务编码压缩, 各列并行
+    OLAPStatus write_row_block(const RowBlock& row_block, ThreadPool* encode_pool);
     // 记录index信息
     OLAPStatus create_row_index_entry();
     // 通过对缓存的使用,预估最终segment的大小
@@ -43,6 +51,12 @@ public:
     // 生成文件并写入缓存的数据
     OLAPStatus finalize(uint32_t* segment_file_size);
 
+    // finalize分为两步, 以便由其他线程生成文件:
+    // seal之后不能再写入数据, 返回将要生成的文件大小
+    OLAPStatus seal(uint32_t* segment_file_size);
+    // 生成seal之后的文件, sync为true时在关闭前fsync
+    OLAPStatus write_file(bool sync);
+
     bool is_row_block_full() {
         return (_row_in_block >= _table->num_rows_per_row_block()) ? true : false;
     }
@@ -50,18 +64,32 @@ private:
     // Helper: 生成最终的PB文件头
     OLAPStatus _make_file_header(ColumnDataHeaderMessage* file_header);
 
+    // write_row_block中编码一列的任务
+    void _write_column(size_t index, const RowBlock* row_block,
+                       OLAPStatus* res, CountDownLatch* latch);
+
+    // UNIQUE_KEYS表生成整个segment的key bloom filter流
+    OLAPStatus _write_key_bloom_filter(ColumnDataHeaderMessage* file_header);
+
     std::string _file_name;
     SmartOLAPTable _table;
     uint32_t _stream_buffer_size; // 输出缓冲区大小
     std::vector<ColumnWriter*> _root_writers;
+    // write_row_block中每一列的任务使用各自的RowCursor
+    std::vector<RowCursor*> _column_cursors;
     OutStreamFactory* _stream_factory;
     uint64_t _row_count;    // 已经写入的行总数
     uint64_t _row_in_block; // 当前block中的数据
     uint64_t _block_count;  // 已经写入的block个数
+    // UNIQUE_KEYS表每一行key的hash, seal时生成key bloom filter
+    std::vector<uint64_t> _key_hashes;
 
     // write limit
     uint32_t _write_mbytes_per_sec;
 
+    // seal时生成
+    FileHeader<ColumnDataHeaderMessage> _file_header;
+
     DISALLOW_COPY_AND_ASSIGN(SegmentWriter);
 };
 
@@ -0,0 +1,346 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "olap/compaction_scheduler.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+
+#include <gperftools/profiler.h>
+
+#include "agent/cgroups_mgr.h"
+#include "olap/base_compaction.h"
+#include "olap/cumulative_compaction.h"
+#include "olap/olap_engine.h"
+#include "olap/olap_table.h"
+#include "util/palo_metrics.h"
+
+using std::map;
+using std::pair;
+using std::string;
+using std::vector;
+
+namespace palo {
+
+const uint32_t CompactionScheduler::MIN_DELTAS_OF_SCANNED_TABLET;
+
+CompactionScheduler::CompactionScheduler() :
+        _cond(_mutex) {}
+
+CompactionScheduler::~CompactionScheduler() {}
+
+OLAPStatus CompactionScheduler::start() {
+    if (0 != pthread_create(&_schedule_thread, NULL, _schedule_thread_callback, this)) {
+        OLAP_LOG_FATAL("failed to start compaction schedule thread.");
+        return OLAP_ERR_INIT_FAILED;
+    }
+
+    int32_t worker_num = config::compaction_worker_num;
+    _worker_threads.resize(worker_num, -1);
+    for (uint32_t i = 0; i < worker_num; ++i) {
+        if (0 != pthread_create(&_worker_threads[i], NULL, _worker_thread_callback, this)) {
+            OLAP_LOG_FATAL("failed to start compaction worker thread. [id=%u]", i);
+            return OLAP_ERR_INIT_FAILED;
+        }
+    }
+    return OLAP_SUCCESS;
+}
+
+void* CompactionScheduler::_schedule_thread_callback(void* arg) {
+#ifdef GOOGLE_PROFILER
+    ProfilerRegisterThread();
+#endif
+    CompactionScheduler* scheduler = static_cast<CompactionScheduler*>(arg);
+    uint32_t interval = config::compaction_schedule_interval_seconds;
+    if (interval <= 0) {
+        OLAP_LOG_WARNING("compaction schedule interval config is illegal: [%d], "
+                         "force set to 1", interval);
+        interval = 1;
+    }
+
+    while (true) {
+        scheduler->_schedule();
+        sleep(interval);
+    }
+
+    return NULL;
+}
+
+void* CompactionScheduler::_worker_thread_callback(void* arg) {
+#ifdef GOOGLE_PROFILER
+    ProfilerRegisterThread();
+#endif
+    CompactionScheduler* scheduler = static_cast<CompactionScheduler*>(arg);
+    while (true) {
+        // must be here, because this thread is start on start and
+        // cgroup is not initialized at this time
+        CgroupsMgr::apply_system_cgroup();
+        Candidate candidate;
+        scheduler->_take_candidate(&candidate);
+        scheduler->_run(candidate);
+        scheduler->_finish(candidate);
+    }
+
+    return NULL;
+}
+
+void CompactionScheduler::_schedule() {
+    OLAPEngine* engine = OLAPEngine::get_instance();
+    vector<SmartOLAPTable> tables;
+    engine->_tablet_map_lock.rdlock();
+    for (const auto& it : engine->_tablet_map) {
+        for (SmartOLAPTable table : it.second.table_arr) {
+            tables.push_back(table);
+        }
+    }
+    engine->_tablet_map_lock.unlock();
+
+    bool base_compaction_allowed = OLAPEngine::_in_base_compaction_hours();
+
+    // several schema hashes of a tablet share its scans
+    map<TTabletId, pair<int64_t, int64_t>> scan_stats;
+    for (SmartOLAPTable table : tables) {
+        scan_stats[table->tablet_id()].first += table->scan_count();
+    }
+    {
+        AutoMutexLock auto_lock(&_mutex);
+        for (auto& it : scan_stats) {
+            auto last = _scan_stats.find(it.first);
+            if (last == _scan_stats.end()) {
+                continue;
+            }
+            it.second.second = last->second.second / 2
+                    + std::max(it.second.first - last->second.first, 0L);
+        }
+    }
+
+    vector<Candidate> queue;
+    for (SmartOLAPTable table : tables) {
+        if (!table->is_loaded()) {
+            continue;
+        }
+
+        // versions above the cumulative layer point are deltas, which a cumulative
+        // compaction merges; the ones below are the base and the cumulatives
+        uint32_t num_deltas = 0;
+        uint32_t num_base_versions = 0;
+        int64_t delta_bytes = 0;
+        int64_t base_bytes = 0;
+        bool base_version_exists = false;
+        table->obtain_header_rdlock();
+        const int32_t point = table->cumulative_layer_point();
+        for (int i = 0; i < table->file_version_size(); ++i) {
+            const FileVersionMessage& version = table->file_version(i);
+            int64_t bytes = version.data_size() + version.index_size();
+            if (version.start_version() >= point) {
+                ++num_deltas;
+                delta_bytes += bytes;
+            } else {
+                ++num_base_versions;
+                base_bytes += bytes;
+            }
+            if (version.start_version() == 0) {
+                base_version_exists = true;
+            }
+        }
+        table->release_header_lock();
+
+        // base不存在可能是tablet正在做alter table，先不选它
+        if (!base_version_exists) {
+            continue;
+        }
+
+        Candidate candidate;
+        candidate.tablet_id = table->tablet_id();
+        candidate.schema_hash = table->schema_hash();
+        candidate.root_path = table->storage_root_path_name();
+        candidate.recent_scans = scan_stats[table->tablet_id()].second;
+
+        // a tablet being read does not wait for the usual number of deltas
+        if (num_deltas >= config::cumulative_compaction_num_singleton_deltas
+                || (candidate.recent_scans > 0 && num_deltas >= MIN_DELTAS_OF_SCANNED_TABLET)) {
+            candidate.type = CUMULATIVE_COMPACTION;
+            candidate.num_versions = num_deltas;
+            candidate.bytes = delta_bytes;
+            candidate.score = static_cast<double>(num_deltas) * (1 + candidate.recent_scans);
+            queue.push_back(candidate);
+        }
+
+        // BaseCompaction::init() still checks the base compaction policy
+        if (base_compaction_allowed && num_base_versions > 1) {
+            candidate.type = BASE_COMPACTION;
+            candidate.num_versions = num_base_versions;
+            candidate.bytes = base_bytes;
+            candidate.score = static_cast<double>(num_base_versions) * (1 + candidate.recent_scans);
+            queue.push_back(candidate);
+        }
+    }
+
+    std::stable_sort(queue.begin(), queue.end(),
+                     [](const Candidate& left, const Candidate& right) {
+                         return left.score > right.score;
+                     });
+
+    AutoMutexLock auto_lock(&_mutex);
+    _queue.swap(queue);
+    _scan_stats.swap(scan_stats);
+    _cond.notify_all();
+}
+
+void CompactionScheduler::_take_candidate(Candidate* candidate) {
+    int64_t budget = config::compaction_disk_budget_mbytes * 1024 * 1024;
+    AutoMutexLock auto_lock(&_mutex);
+    while (true) {
+        for (auto it = _queue.begin(); it != _queue.end(); ++it) {
+            bool tablet_running = false;
+            for (const Candidate& running : _running) {
+                if (running.tablet_id == it->tablet_id) {
+                    tablet_running = true;
+                    break;
+                }
+            }
+            if (tablet_running) {
+                continue;
+            }
+
+            int64_t& running_bytes = _disk_running_bytes[it->root_path];
+            if (running_bytes > 0 && running_bytes + it->bytes > budget) {
+                continue;
+            }
+
+            running_bytes += it->bytes;
+            *candidate = *it;
+            _running.push_back(*it);
+            _queue.erase(it);
+            return;
+        }
+        _cond.wait();
+    }
+}
+
+void CompactionScheduler::_run(const Candidate& candidate) {
+    OLAPEngine* engine = OLAPEngine::get_instance();
+    SmartOLAPTable table = engine->get_table(candidate.tablet_id, candidate.schema_hash);
+    if (table.get() == NULL) {
+        // tablet已经不存在
+        return;
+    }
+
+    // 跳过正在做schema change的tablet
+    if (!engine->_can_do_compaction(table)) {
+        OLAP_LOG_DEBUG("skip tablet, it is schema changing. [tablet=%s]",
+                       table->full_name().c_str());
+        return;
+    }
+
+    if (candidate.type == CUMULATIVE_COMPACTION) {
+        // same relaxed policy as the one the candidate was queued by
+        uint32_t min_deltas = candidate.recent_scans > 0
+                ? MIN_DELTAS_OF_SCANNED_TABLET
+                : config::cumulative_compaction_num_singleton_deltas;
+        CumulativeCompaction cumulative_compaction;
+        if (cumulative_compaction.init(table, min_deltas) != OLAP_SUCCESS) {
+            return;
+        }
+        PaloMetrics::cumulative_compaction_request_total.increment(1);
+        if (cumulative_compaction.run() != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("failed to do cumulative. [tablet='%s']",
+                             table->full_name().c_str());
+            PaloMetrics::cumulative_compaction_request_failed.increment(1);
+        }
+    } else {
+        BaseCompaction base_compaction;
+        if (base_compaction.init(table, false) != OLAP_SUCCESS) {
+            return;
+        }
+        OLAP_LOG_NOTICE_PUSH("request", "START_BASE_COMPACTION");
+        PaloMetrics::base_compaction_request_total.increment(1);
+        if (base_compaction.run() != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("failed to do base compaction. [tablet='%s']",
+                             table->full_name().c_str());
+            PaloMetrics::base_compaction_request_failed.increment(1);
+        }
+    }
+}
+
+void CompactionScheduler::_finish(const Candidate& candidate) {
+    AutoMutexLock auto_lock(&_mutex);
+    _disk_running_bytes[candidate.root_path] -= candidate.bytes;
+    for (auto it = _running.begin(); it != _running.end(); ++it) {
+        if (it->tablet_id == candidate.tablet_id && it->type == candidate.type) {
+            _running.erase(it);
+            break;
+        }
+    }
+    _cond.notify_all();
+}
+
+static rapidjson::Value candidate_to_json(const CompactionScheduler::Candidate& candidate,
+                                          rapidjson::Document::AllocatorType& allocator) {
+    rapidjson::Value value(rapidjson::kObjectType);
+    value.AddMember("tablet_id", candidate.tablet_id, allocator);
+    value.AddMember("schema_hash", candidate.schema_hash, allocator);
+    const char* type = candidate.type == CompactionScheduler::BASE_COMPACTION
+            ? "base" : "cumulative";
+    value.AddMember("type", rapidjson::Value(type, allocator).Move(), allocator);
+    value.AddMember("root_path",
+                    rapidjson::Value(candidate.root_path.c_str(), allocator).Move(),
+                    allocator);
+    value.AddMember("num_versions", candidate.num_versions, allocator);
+    value.AddMember("recent_scans", candidate.recent_scans, allocator);
+    value.AddMember("bytes", candidate.bytes, allocator);
+    value.AddMember("score", candidate.score, allocator);
+    return value;
+}
+
+void CompactionScheduler::get_status(rapidjson::Document* document) {
+    rapidjson::Document::AllocatorType& allocator = document->GetAllocator();
+    rapidjson::Value queue(rapidjson::kArrayType);
+    rapidjson::Value running(rapidjson::kArrayType);
+    rapidjson::Value disks(rapidjson::kArrayType);
+    rapidjson::Value tablets(rapidjson::kArrayType);
+
+    AutoMutexLock auto_lock(&_mutex);
+    for (const Candidate& candidate : _queue) {
+        queue.PushBack(candidate_to_json(candidate, allocator), allocator);
+    }
+    for (const Candidate& candidate : _running) {
+        running.PushBack(candidate_to_json(candidate, allocator), allocator);
+    }
+    for (const auto& it : _disk_running_bytes) {
+        rapidjson::Value disk(rapidjson::kObjectType);
+        disk.AddMember("root_path", rapidjson::Value(it.first.c_str(), allocator).Move(),
+                       allocator);
+        disk.AddMember("running_bytes", it.second, allocator);
+        disks.PushBack(disk, allocator);
+    }
+    for (const auto& it : _scan_stats) {
+        rapidjson::Value tablet(rapidjson::kObjectType);
+        tablet.AddMember("tablet_id", it.first, allocator);
+        tablet.AddMember("scan_count", it.second.first, allocator);
+        tablet.AddMember("recent_scans", it.second.second, allocator);
+        tablets.PushBack(tablet, allocator);
+    }
+
+    document->AddMember("disk_budget_bytes",
+                        config::compaction_disk_budget_mbytes * 1024 * 1024, allocator);
+    document->AddMember("queue", queue, allocator);
+    document->AddMember("running", running, allocator);
+    document->AddMember("disks", disks, allocator);
+    document->AddMember("tablets", tablets, allocator);
+}
+
+}  // namespace palo
@@ -0,0 +1,121 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_OLAP_COMPACTION_SCHEDULER_H
+#define BDG_PALO_BE_SRC_OLAP_COMPACTION_SCHEDULER_H
+
+#include <pthread.h>
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <rapidjson/document.h>
+
+#include "olap/olap_common.h"
+#include "olap/olap_define.h"
+#include "olap/utils.h"
+
+namespace palo {
+
+// Runs the base and cumulative compactions of all tablets on one pool of
+// config::compaction_worker_num workers.
+//
+// Every config::compaction_schedule_interval_seconds the tablets are scored by the
+// merge cost their reads pay: the number of versions a read has to merge times
+// (1 + the recent number of scans of the tablet). Recent scans are the scans of the
+// last round plus half of the recent scans of the round before. So hot tablets with
+// many deltas are compacted before cold ones. A tablet with recent scans is also
+// compacted from fewer deltas than config::cumulative_compaction_num_singleton_deltas.
+//
+// A worker takes the best candidate whose disk has I/O budget left: the bytes merged
+// by the compactions running on a disk stay under config::compaction_disk_budget_mbytes,
+// except that an idle disk always takes one compaction.
+class CompactionScheduler {
+    DECLARE_SINGLETON(CompactionScheduler)
+public:
+    enum CompactionType {
+        BASE_COMPACTION = 0,
+        CUMULATIVE_COMPACTION = 1
+    };
+
+    struct Candidate {
+        Candidate() :
+                tablet_id(0),
+                schema_hash(0),
+                type(CUMULATIVE_COMPACTION),
+                num_versions(0),
+                recent_scans(0),
+                bytes(0),
+                score(0) {}
+
+        TTabletId tablet_id;
+        TSchemaHash schema_hash;
+        CompactionType type;
+        std::string root_path;
+        // versions merged by this compaction, which reads merge too
+        uint32_t num_versions;
+        int64_t recent_scans;
+        int64_t bytes;
+        double score;
+    };
+
+    // Starts the scheduling thread and the workers.
+    OLAPStatus start();
+
+    // Fills 'document', an object, with the queued and running compactions, the
+    // bytes running on each disk and the recent scans of each tablet.
+    void get_status(rapidjson::Document* document);
+
+private:
+    // A tablet scanned since the last rounds is compacted from this number of deltas
+    // on, instead of config::cumulative_compaction_num_singleton_deltas.
+    static const uint32_t MIN_DELTAS_OF_SCANNED_TABLET = 2;
+
+    static void* _schedule_thread_callback(void* arg);
+    static void* _worker_thread_callback(void* arg);
+
+    // Scores all tablets and replaces the queue.
+    void _schedule();
+
+    // Waits for a queued candidate that its disk can take and moves it to _running.
+    void _take_candidate(Candidate* candidate);
+
+    void _run(const Candidate& candidate);
+
+    void _finish(const Candidate& candidate);
+
+    // guards all the fields below
+    MutexLock _mutex;
+    // signaled when the queue is replaced or a compaction finishes
+    Condition _cond;
+    // sorted by score, highest first
+    std::vector<Candidate> _queue;
+    std::vector<Candidate> _running;
+    // root path -> bytes merged by the running compactions
+    std::map<std::string, int64_t> _disk_running_bytes;
+    // tablet id -> (scan count seen by the last round, recent scans)
+    std::map<TTabletId, std::pair<int64_t, int64_t>> _scan_stats;
+
+    pthread_t _schedule_thread;
+    std::vector<pthread_t> _worker_threads;
+
+    DISALLOW_COPY_AND_ASSIGN(CompactionScheduler);
+};
+
+}  // namespace palo
+
+#endif // BDG_PALO_BE_SRC_OLAP_COMPACTION_SCHEDULER_H
@@ -31,6 +31,10 @@ using std::vector;
 namespace palo {
 
 OLAPStatus CumulativeCompaction::init(SmartOLAPTable table) {
+    return init(table, config::cumulative_compaction_num_singleton_deltas);
+}
+
+OLAPStatus CumulativeCompaction::init(SmartOLAPTable table, uint32_t min_deltas) {
     OLAP_LOG_TRACE("init cumulative compaction handler. [table=%s]", table->full_name().c_str());
 
     if (_is_init) {
@@ -45,6 +49,7 @@ OLAPStatus CumulativeCompaction::init(SmartOLAPTable table) {
 
     _table = table;
     _max_delta_file_size = config::cumulative_compaction_budgeted_bytes;
+    _min_deltas = min_deltas;
 
     if (!_table->try_cumulative_lock()) {
         OLAP_LOG_WARNING("another cumulative is running. [table=%s]",
@@ -196,18 +201,16 @@ OLAPStatus CumulativeCompaction::_check_whether_satisfy_policy() {
         return res;
     }
     
-    if (delta_versions.size() < config::cumulative_compaction_num_singleton_deltas) {
+    if (delta_versions.size() < _min_deltas) {
         OLAP_LOG_TRACE("do not satisfy cumulative policy. "
-                       "[num_existed_singleton_deltas=%d cumulative_compaction_num_singleton_deltas=%d]",
-                       delta_versions.size(),
-                       config::cumulative_compaction_num_singleton_deltas);
+                       "[num_existed_singleton_deltas=%d min_deltas=%u]",
+                       delta_versions.size(), _min_deltas);
         return OLAP_ERR_CUMULATIVE_NO_SUITABLE_VERSIONS;
     }
 
     OLAP_LOG_INFO("satisfy cumulative policy."
-                  "[num_existed_singleton_delta=%d cumulative_compaction_num_singleton_deltas=%d]",
-                  delta_versions.size(),
-                  config::cumulative_compaction_num_singleton_deltas);
+                  "[num_existed_singleton_delta=%d min_deltas=%u]",
+                  delta_versions.size(), _min_deltas);
     return OLAP_SUCCESS;
 }
 
@@ -36,6 +36,7 @@ public:
             _old_cumulative_layer_point(0),
             _new_cumulative_layer_point(0),
             _max_delta_file_size(0),
+            _min_deltas(0),
             _new_cumulative_index(NULL) {}
 
     ~CumulativeCompaction() {}
@@ -52,6 +53,10 @@ public:
     // - 否则，返回对应错误码
     OLAPStatus init(SmartOLAPTable table);
 
+    // 同上，但delta文件数达到min_deltas即触发cumulative compaction，
+    // CompactionScheduler对正在被查询的tablet放宽触发条件时使用
+    OLAPStatus init(SmartOLAPTable table, uint32_t min_deltas);
+
     // 执行cumulative compaction
     //
     // 返回值：
@@ -165,6 +170,8 @@ private:
     // 一个cumulative文件大小的最大值
     // 当delta文件的大小超过该值时，我们认为该delta文件是cumulative文件
     size_t _max_delta_file_size;
+    // 触发cumulative compaction所需的最少delta文件数
+    uint32_t _min_deltas;
     // 待执行cumulative compaction的olap table
     SmartOLAPTable _table;
     // 新cumulative文件的版本
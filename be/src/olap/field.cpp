@@ -50,8 +50,10 @@ Field* Field::create_by_type(const FieldType& type) {
 
 Field::Field(const FieldInfo& field_info)
         : _type(field_info.type),
+          _aggregation(field_info.aggregation),
           _index_size(field_info.index_length),
-          _offset(0) {
+          _offset(0),
+          _sketch_capacity(0) {
 
     _type_info = get_type_info(field_info.type);
     if (_type == OLAP_FIELD_TYPE_CHAR || _type == OLAP_FIELD_TYPE_VARCHAR
@@ -68,6 +70,53 @@ Field::Field(const FieldInfo& field_info)
     _index_size = field_info.index_length;
     _aggregate_func = get_aggregate_func(field_info.aggregation, field_info.type);
     _finalize_func = get_finalize_func(field_info.aggregation, field_info.type);
+    if (_aggregation == OLAP_FIELD_AGGREGATION_BITMAP_UNION) {
+        DCHECK_EQ(_type, OLAP_FIELD_TYPE_VARCHAR);
+        _sketch.reset(new SketchUnionImpl<RoaringBitmap>());
+    } else if (_aggregation == OLAP_FIELD_AGGREGATION_QUANTILE_UNION) {
+        DCHECK_EQ(_type, OLAP_FIELD_TYPE_VARCHAR);
+        _sketch.reset(new SketchUnionImpl<TDigest>());
+    }
+    if (_sketch != nullptr) {
+        _sketch_capacity = field_info.length - OLAP_STRING_MAX_BYTES;
+    }
+}
+
+void Field::_sketch_agg_init(char* dest, const char* src) {
+    *reinterpret_cast<bool*>(dest) = true;
+    _sketch->clear();
+    _sketch_aggregate(dest, src);
+}
+
+void Field::_sketch_aggregate(char* dest, const char* src) {
+    // the union ignores NULL values
+    if (*reinterpret_cast<const bool*>(src)) {
+        return;
+    }
+    *reinterpret_cast<bool*>(dest) = false;
+    const StringSlice* slice = reinterpret_cast<const StringSlice*>(src + 1);
+    if (!_sketch->merge(slice->data, slice->size)) {
+        OLAP_LOG_WARNING("invalid sketch value, ignore it. [aggregation=%d size=%lu]",
+                         _aggregation, slice->size);
+    }
+}
+
+OLAPStatus Field::_sketch_finalize(char* data) {
+    StringSlice* slice = reinterpret_cast<StringSlice*>(data);
+    size_t size = _sketch->serialized_size();
+    // the row buffers of a VARCHAR column only hold its declared length, and a
+    // truncated union would be wrong, so the merge fails instead. can_aggregate()
+    // keeps the unions of values that fit in the column within it, so only a value
+    // longer than the column by itself gets here.
+    if (size > _sketch_capacity) {
+        OLAP_LOG_WARNING("merged sketch is longer than the column. "
+                         "[aggregation=%d size=%lu capacity=%lu]",
+                         _aggregation, size, _sketch_capacity);
+        return OLAP_ERR_BUFFER_OVERFLOW;
+    }
+    _sketch->serialize(slice->data);
+    slice->size = size;
+    return OLAP_SUCCESS;
 }
 
 }  // namespace palo
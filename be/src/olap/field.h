@@ -16,6 +16,7 @@
 #ifndef BDG_PALO_BE_SRC_OLAP_FIELD_H
 #define BDG_PALO_BE_SRC_OLAP_FIELD_H
 
+#include <memory>
 #include <string>
 
 #include "olap/aggregate_func.h"
@@ -28,9 +29,82 @@
 #include "runtime/mem_pool.h"
 #include "util/hash_util.hpp"
 #include "util/mem_util.hpp"
+#include "util/roaring_bitmap.h"
+#include "util/tdigest.h"
 
 namespace palo {
 
+// Merge state of a sketch column, BITMAP_UNION or QUANTILE_UNION: the serialized
+// sketches of the merged rows are added to one sketch, serialized again at the end.
+//
+// A union grows with the rows merged, while a column only holds its declared length,
+// so the mergers ask can_merge() before each row and start a new row of the same
+// key once the union is full. The union of two sketches never serializes to more
+// bytes than the two of them less one header, so the merged sizes bound the union,
+// and the sketch is only sized when that bound does not fit.
+class SketchUnion {
+public:
+    explicit SketchUnion(size_t header_size) : _header_size(header_size), _size_bound(0) { }
+    virtual ~SketchUnion() { }
+
+    void clear() {
+        _clear();
+        _size_bound = 0;
+    }
+
+    // Returns false if 'data' is not a valid serialized sketch.
+    bool merge(const char* data, size_t size) {
+        _size_bound = _bound_after(size);
+        return _merge(data, size);
+    }
+
+    // Whether the union still serializes to at most 'capacity' bytes once a
+    // serialized sketch of 'size' bytes is merged.
+    bool can_merge(size_t size, size_t capacity) {
+        if (_bound_after(size) <= capacity) {
+            return true;
+        }
+        _size_bound = serialized_size();
+        return _bound_after(size) <= capacity;
+    }
+
+    virtual size_t serialized_size() = 0;
+    virtual void serialize(char* dst) = 0;
+
+protected:
+    virtual void _clear() = 0;
+    virtual bool _merge(const char* data, size_t size) = 0;
+
+private:
+    size_t _bound_after(size_t size) const {
+        if (_size_bound == 0) {
+            return size;
+        }
+        return _size_bound + (size > _header_size ? size - _header_size : 0);
+    }
+
+    // bytes of the serialized format shared by all sketches
+    const size_t _header_size;
+    // upper bound of serialized_size(), 0 while nothing is merged
+    size_t _size_bound;
+};
+
+template <typename Sketch>
+class SketchUnionImpl : public SketchUnion {
+public:
+    SketchUnionImpl() : SketchUnion(Sketch::HEADER_SIZE) { }
+
+    virtual size_t serialized_size() { return _sketch.serialized_size(); }
+    virtual void serialize(char* dst) { _sketch.serialize(dst); }
+
+protected:
+    virtual void _clear() { _sketch.clear(); }
+    virtual bool _merge(const char* data, size_t size) { return _sketch.merge(data, size); }
+
+private:
+    Sketch _sketch;
+};
+
 // Field内部参数为Field*的方法都要求实例类型和当前类型一致，否则会产生无法预知的错误
 // 出于效率的考虑，大部分函数实现均没有对参数进行检查
 class Field {
@@ -77,8 +151,14 @@ public:
     inline int index_cmp(char* left, char* right) const;
     inline bool equal(char* left, char* right);
 
+    // Whether 'src' can be aggregated into the value started by agg_init(): false
+    // once the merged value of a sketch column would not fit in the column, the
+    // rows left then go to another row of the same key.
+    inline bool can_aggregate(const char* src);
     inline void aggregate(char* dest, char* src);
-    inline void finalize(char* data);
+    // Fails if the merged value of a sketch column does not fit in the column,
+    // which can_aggregate() prevents for values that fit by themselves.
+    inline OLAPStatus finalize(char* data);
 
     inline void copy_with_pool(char* dest, const char* src, MemPool* mem_pool);
     inline void copy_without_pool(char* dest, const char* src);
@@ -104,7 +184,15 @@ public:
 
     inline uint32_t hash_code(char* data, uint32_t seed) const;
 private:
+    // Sketch columns keep the union of the rows merged since agg_init() in _sketch,
+    // and only serialize it into the row in finalize(). This works because every
+    // RowCursor has its own Field objects.
+    void _sketch_agg_init(char* dest, const char* src);
+    void _sketch_aggregate(char* dest, const char* src);
+    OLAPStatus _sketch_finalize(char* data);
+
     FieldType _type;
+    FieldAggregationMethod _aggregation;
     // Field的长度，单位为字节
     uint16_t _size;
     // Field的最大长度，单位为字节，通常等于length， 变长字符串不同
@@ -114,6 +202,11 @@ private:
 
     AggregateFunc _aggregate_func;
     FinalizeFunc _finalize_func;
+
+    // set for BITMAP_UNION and QUANTILE_UNION columns only
+    std::unique_ptr<SketchUnion> _sketch;
+    // bytes available for the serialized sketch in the row buffer of the RowCursor
+    size_t _sketch_capacity;
 };
 
 // 返回-1，0，1，分别代表当前field小于，等于，大于传入参数中的field
@@ -169,15 +262,30 @@ inline bool Field::equal(char* left, char* right) {
     }
 }
 
+inline bool Field::can_aggregate(const char* src) {
+    if (OLAP_LIKELY(_sketch == nullptr) || *reinterpret_cast<const bool*>(src)) {
+        return true;
+    }
+    const StringSlice* slice = reinterpret_cast<const StringSlice*>(src + 1);
+    return _sketch->can_merge(slice->size, _sketch_capacity);
+}
+
 inline void Field::aggregate(char* dest, char* src) {
+    if (OLAP_UNLIKELY(_sketch != nullptr)) {
+        _sketch_aggregate(dest, src);
+        return;
+    }
     _aggregate_func(dest, src);
 }
 
-inline void Field::finalize(char* data) {
+inline OLAPStatus Field::finalize(char* data) {
     if (OLAP_UNLIKELY(_type == OLAP_FIELD_TYPE_HLL)) {
         // hyperloglog type use this function
         _finalize_func(data);
+    } else if (OLAP_UNLIKELY(_sketch != nullptr)) {
+        return _sketch_finalize(data);
     }
+    return OLAP_SUCCESS;
 }
 
 inline void Field::copy_with_pool(char* dest, const char* src, MemPool* mem_pool) {
@@ -199,7 +307,9 @@ inline void Field::copy_without_pool(char* dest, const char* src) {
 }
 
 inline void Field::agg_init(char* dest, const char* src) {
-    if (OLAP_LIKELY(_type != OLAP_FIELD_TYPE_HLL)) {
+    if (OLAP_UNLIKELY(_sketch != nullptr)) {
+        _sketch_agg_init(dest, src);
+    } else if (OLAP_LIKELY(_type != OLAP_FIELD_TYPE_HLL)) {
         copy_without_pool(dest, src);
     } else {
         bool is_null = *reinterpret_cast<const bool*>(src);
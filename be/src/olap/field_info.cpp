@@ -93,6 +93,10 @@ FieldAggregationMethod FieldInfo::get_aggregation_type_by_string(const string& s
         aggregation_type = OLAP_FIELD_AGGREGATION_REPLACE;
     } else if (0 == upper_str.compare("HLL_UNION")) {
         aggregation_type = OLAP_FIELD_AGGREGATION_HLL_UNION;
+    } else if (0 == upper_str.compare("BITMAP_UNION")) {
+        aggregation_type = OLAP_FIELD_AGGREGATION_BITMAP_UNION;
+    } else if (0 == upper_str.compare("QUANTILE_UNION")) {
+        aggregation_type = OLAP_FIELD_AGGREGATION_QUANTILE_UNION;
     } else {
         OLAP_LOG_WARNING("invalid aggregation type string. [aggregation='%s']", str.c_str());
         aggregation_type = OLAP_FIELD_AGGREGATION_UNKNOWN;
@@ -191,6 +195,12 @@ string FieldInfo::get_string_by_aggregation_type(FieldAggregationMethod type) {
         case OLAP_FIELD_AGGREGATION_HLL_UNION:
             return "HLL_UNION";
 
+        case OLAP_FIELD_AGGREGATION_BITMAP_UNION:
+            return "BITMAP_UNION";
+
+        case OLAP_FIELD_AGGREGATION_QUANTILE_UNION:
+            return "QUANTILE_UNION";
+
         default:
             return "UNKNOWN";
     }
@@ -15,6 +15,12 @@
 
 #include "olap/hll.h"
 
+#ifdef __AVX2__
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include <algorithm>
 #include <map>
 #include <sstream>
@@ -33,7 +39,6 @@ void HllSetResolver::parse() {
     // skip LengthValueType
     char*  pdata = _buf_ref;
     _set_type = (HllDataType)pdata[0];
-    char* sparse_data = NULL;
     switch (_set_type) {
         case HLL_DATA_EXPLICIT:
             // first byte : type
@@ -47,14 +52,15 @@ void HllSetResolver::parse() {
             // first byte : type
             // second ～（2^HLL_COLUMN_PRECISION)/8 byte : bitmap mark which is not zero
             // 2^HLL_COLUMN_PRECISION)/8 ＋ 1以后value
-            _sparse_count = (SparseLengthValueType*)(pdata + sizeof (SetTypeValueType));
-            sparse_data = pdata + sizeof(SetTypeValueType) + sizeof(SparseLengthValueType);
-            for (int i = 0; i < *_sparse_count; i++) {
-                SparseIndexType* index = (SparseIndexType*)sparse_data;
-                sparse_data += sizeof(SparseIndexType);
-                SparseValueType* value = (SparseValueType*)sparse_data;
-                _sparse_map[*index] = *value;
-                sparse_data += sizeof(SetTypeValueType);
+            // the (index, value) pairs are written in index order, so they are
+            // read in place instead of being decoded
+            memcpy(&_sparse_count, pdata + sizeof(SetTypeValueType),
+                   sizeof(SparseLengthValueType));
+            _sparse_data = pdata + sizeof(SetTypeValueType) + sizeof(SparseLengthValueType);
+            if (_buf_len > 0) {
+                int max_count = (_buf_len - (int)(sizeof(SetTypeValueType)
+                            + sizeof(SparseLengthValueType))) / SPARSE_PAIR_SIZE;
+                _sparse_count = std::max(0, std::min(_sparse_count, max_count));
             }
             break;
         case HLL_DATA_FULL:
@@ -77,18 +83,15 @@ void HllSetResolver::fill_registers(char* registers, int len) {
             registers[idx] = std::max((uint8_t)registers[idx], first_one_bit);
         }
     } else if (_set_type == HLL_DATA_SPRASE) {
-        std::map<SparseIndexType, SparseValueType>& sparse_map = get_sparse_map();
-        for (std::map<SparseIndexType, SparseValueType>::iterator iter = sparse_map.begin();
-                iter != sparse_map.end(); iter++) {
-            registers[iter->first] =
-                std::max((uint8_t)registers[iter->first], (uint8_t)iter->second);
+        for (int i = 0; i < get_sparse_count(); ++i) {
+            SparseIndexType idx = get_sparse_index(i);
+            if (idx >= len) {
+                continue;
+            }
+            registers[idx] = std::max((uint8_t)registers[idx], get_sparse_value(i));
         }
     } else if (_set_type == HLL_DATA_FULL) {
-        char* full_value = get_full_value();
-        for (int i = 0; i < len; i++) {
-            registers[i] = std::max((uint8_t)registers[i], (uint8_t)full_value[i]);
-        }
-
+        HllSetHelper::merge_registers((uint8_t*)registers, (const uint8_t*)get_full_value(), len);
     } else {
         // HLL_DATA_EMPTY
     }
@@ -108,16 +111,9 @@ void HllSetResolver::fill_index_to_value_map(std::map<int, uint8_t>* index_to_va
             }
         }
     } else if (_set_type == HLL_DATA_SPRASE) {
-        std::map<SparseIndexType, SparseValueType>& sparse_map = get_sparse_map();
-        for (std::map<SparseIndexType, SparseValueType>::iterator iter = sparse_map.begin();
-                iter != sparse_map.end(); iter++) {
-            if (index_to_value->find(iter->first) != index_to_value->end()) {
-                (*index_to_value)[iter->first] =
-                    (*index_to_value)[iter->first]
-                        < iter->second ? iter->second : (*index_to_value)[iter->first];
-            } else {
-                (*index_to_value)[iter->first] = iter->second;
-            }
+        for (int i = 0; i < get_sparse_count(); ++i) {
+            uint8_t& value = (*index_to_value)[get_sparse_index(i)];
+            value = std::max(value, get_sparse_value(i));
         }
     } else if (_set_type == HLL_DATA_FULL) {
         char* registers = get_full_value();
@@ -161,6 +157,54 @@ void HllSetHelper::set_sparse(
     *(int*)(result + 1) = registers_count;
 }
 
+void HllSetHelper::set_sparse(char* result, const char* registers, int registers_len, int& len) {
+    result[0] = HLL_DATA_SPRASE;
+    len = sizeof(HllSetResolver::SetTypeValueType) + sizeof(HllSetResolver::SparseLengthValueType);
+    char* write_value_pos = result + len;
+    int registers_count = 0;
+    for (int i = 0; i < registers_len; ++i) {
+        if (registers[i] == 0) {
+            continue;
+        }
+        write_value_pos[0] = (char)(i & 0xff);
+        write_value_pos[1] = (char)(i >> 8 & 0xff);
+        write_value_pos[2] = registers[i];
+        write_value_pos += 3;
+        ++registers_count;
+    }
+    len += registers_count * (sizeof(HllSetResolver::SparseIndexType)
+            + sizeof(HllSetResolver::SparseValueType));
+    memcpy(result + 1, &registers_count, sizeof(HllSetResolver::SparseLengthValueType));
+}
+
+int HllSetHelper::count_non_zero_registers(const char* registers, int registers_len) {
+    int count = 0;
+    for (int i = 0; i < registers_len; ++i) {
+        count += (registers[i] != 0);
+    }
+    return count;
+}
+
+void HllSetHelper::merge_registers(uint8_t* dst, const uint8_t* src, int len) {
+    int i = 0;
+#ifdef __AVX2__
+    for (; i + 32 <= len; i += 32) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_max_epu8(a, b));
+    }
+#elif defined(__SSE2__)
+    for (; i + 16 <= len; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_max_epu8(a, b));
+    }
+#endif
+    for (; i < len; ++i) {
+        dst[i] = std::max(dst[i], src[i]);
+    }
+}
+
 void HllSetHelper::set_expliclit(char* result, const std::set<uint64_t>& hash_value_set, int& len) {
     result[0] = HLL_DATA_EXPLICIT;
     result[1] = (HllSetResolver::ExpliclitLengthValueType)(hash_value_set.size());
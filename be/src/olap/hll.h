@@ -18,6 +18,7 @@
 
 #include <math.h>
 #include <stdio.h>
+#include <string.h>
 #include <set>
 #include <map>
 
@@ -48,7 +49,9 @@ public:
                        _set_type(HLL_DATA_EMPTY),
                        _full_value_position(nullptr),
                        _expliclit_value(nullptr),
-                       _expliclit_num(0) {}
+                       _expliclit_num(0),
+                       _sparse_data(nullptr),
+                       _sparse_count(0) {}
 
     ~HllSetResolver() {}
 
@@ -94,15 +97,23 @@ public:
 
     // get sparse (index, value) count
     int get_sparse_count() {
-        return (int)*_sparse_count;
+        return (int)_sparse_count;
     };
 
-    // get (index, value) map
-    std::map<SparseIndexType, SparseValueType>& get_sparse_map() {
-        return _sparse_map;
+    // get register index of the index-th sparse (index, value) pair
+    SparseIndexType get_sparse_index(int index) {
+        SparseIndexType register_index;
+        memcpy(&register_index, _sparse_data + index * SPARSE_PAIR_SIZE, sizeof(SparseIndexType));
+        return register_index;
+    };
+
+    // get register value of the index-th sparse (index, value) pair
+    SparseValueType get_sparse_value(int index) {
+        return (SparseValueType)_sparse_data[index * SPARSE_PAIR_SIZE + sizeof(SparseIndexType)];
     };
 
     // parse set , call after copy() or init()
+    // only points into the buffer, sparse pairs are read in place as a sorted array
     void parse();
 
     // fill registers with set
@@ -115,14 +126,16 @@ public:
     void fill_hash64_set(std::set<uint64_t>* hash_set);
 
 private :
+    static const int SPARSE_PAIR_SIZE = sizeof(SparseIndexType) + sizeof(SparseValueType);
+
     char* _buf_ref;    // set
     int _buf_len;      // set len
     HllDataType _set_type;        //set type
     char* _full_value_position;
     uint64_t* _expliclit_value;
     ExpliclitLengthValueType _expliclit_num;
-    std::map<SparseIndexType, SparseValueType> _sparse_map;
-    SparseLengthValueType* _sparse_count;
+    char* _sparse_data;   // (index, value) pairs, not aligned
+    SparseLengthValueType _sparse_count;
 };
 
 // 通过varchar的变长编码方式实现hll集合
@@ -137,6 +150,12 @@ private :
 class HllSetHelper {
 public:
     static void set_sparse(char *result, const std::map<int, uint8_t>& index_to_value, int& len);
+    // write the non zero registers as a sparse set, in index order
+    static void set_sparse(char* result, const char* registers, int registers_len, int& len);
+    // number of non zero registers
+    static int count_non_zero_registers(const char* registers, int registers_len);
+    // dst[i] = max(dst[i], src[i]), 32 or 16 registers at a time
+    static void merge_registers(uint8_t* dst, const uint8_t* src, int len);
     static void set_expliclit(char* result, const std::set<uint64_t>& hash_value_set, int& len);
     static void set_full(char* result, const char* registers, const int set_len, int& len);
     static void set_full(char* result, const std::map<int, uint8_t>& index_to_value,
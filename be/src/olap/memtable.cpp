@@ -0,0 +1,144 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "olap/memtable.h"
+
+#include "olap/writer.h"
+#include "runtime/mem_pool.h"
+#include "runtime/mem_tracker.h"
+
+namespace palo {
+
+MemTable::MemTable(SmartOLAPTable table) :
+        _table(table),
+        _mem_tracker(new MemTracker(-1)),
+        _mem_pool(new MemPool(_mem_tracker.get())),
+        _aggregate(false),
+        _aggregate_in_place(false),
+        _num_rows(0) {}
+
+MemTable::~MemTable() {}
+
+OLAPStatus MemTable::init() {
+    const std::vector<FieldInfo>& tablet_schema = _table->tablet_schema();
+    OLAPStatus res = _row.init(tablet_schema);
+    if (res != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to init row cursor. [res=%d]", res);
+        return res;
+    }
+
+    _aggregate = _table->keys_type() != KeysType::DUP_KEYS;
+    _aggregate_in_place = _aggregate;
+    for (uint32_t cid = 0; cid < tablet_schema.size(); ++cid) {
+        const FieldInfo& field_info = tablet_schema[cid];
+        if (field_info.is_key) {
+            _key_cids.push_back(cid);
+            continue;
+        }
+        _value_cids.push_back(cid);
+        // strings may not fit in the row they replace, and hll and sketch columns
+        // need a context to be merged in
+        if (field_info.type == OLAP_FIELD_TYPE_CHAR
+                || field_info.type == OLAP_FIELD_TYPE_VARCHAR
+                || field_info.type == OLAP_FIELD_TYPE_HLL
+                || field_info.aggregation == OLAP_FIELD_AGGREGATION_BITMAP_UNION
+                || field_info.aggregation == OLAP_FIELD_AGGREGATION_QUANTILE_UNION) {
+            _aggregate_in_place = false;
+        }
+    }
+
+    _skip_list.reset(new(std::nothrow) Table(
+            RowComparator(&_row, _table->num_key_fields()), _mem_pool.get()));
+    if (_skip_list == nullptr) {
+        OLAP_LOG_WARNING("fail to malloc skip list.");
+        return OLAP_ERR_MALLOC_ERROR;
+    }
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus MemTable::insert(const RowCursor& row) {
+    ++_num_rows;
+    if (_aggregate_in_place) {
+        char* found = nullptr;
+        if (_skip_list->find(row.get_buf(), &found)) {
+            _row.attach(found);
+            RowCursor::aggregate(_value_cids, &_row, &row);
+            return OLAP_SUCCESS;
+        }
+    }
+
+    char* buf = reinterpret_cast<char*>(_mem_pool->allocate(_row.get_fixed_len()));
+    if (buf == nullptr) {
+        OLAP_LOG_WARNING("fail to allocate row. [size=%lu]", _row.get_fixed_len());
+        return OLAP_ERR_MALLOC_ERROR;
+    }
+    _row.attach(buf);
+    _row.copy(row, _mem_pool.get());
+    _skip_list->insert(buf);
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus MemTable::flush(IWriter* writer) {
+    const std::vector<FieldInfo>& tablet_schema = _table->tablet_schema();
+    RowCursor row;
+    OLAPStatus res = row.init(tablet_schema);
+    if (res != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to init row cursor. [res=%d]", res);
+        return res;
+    }
+
+    Table::Iterator it(_skip_list.get());
+    it.seek_to_first();
+    while (it.valid()) {
+        // write directly into the row block of the writer
+        res = writer->attached_by(&row);
+        if (res != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("fail to attach row to writer. [res=%d table='%s']",
+                             res, _table->full_name().c_str());
+            return res;
+        }
+        row.allocate_memory_for_string_type(tablet_schema, writer->mem_pool());
+
+        _row.attach(it.key());
+        it.next();
+        if (!_aggregate) {
+            row.copy_without_pool(_row);
+        } else {
+            row.agg_init(_row);
+            for (; it.valid(); it.next()) {
+                _row.attach(it.key());
+                if (!RowCursor::equal(_key_cids, &row, &_row)
+                        || !RowCursor::can_aggregate(_value_cids, &row, &_row)) {
+                    break;
+                }
+                RowCursor::aggregate(_value_cids, &row, &_row);
+            }
+            res = row.finalize_one_merge(_value_cids);
+            if (res != OLAP_SUCCESS) {
+                OLAP_LOG_WARNING("fail to merge rows. [res=%d table='%s']",
+                                 res, _table->full_name().c_str());
+                return res;
+            }
+        }
+        writer->next(row);
+    }
+    return OLAP_SUCCESS;
+}
+
+int64_t MemTable::memory_usage() const {
+    return _mem_pool->total_allocated_bytes();
+}
+
+}  // namespace palo
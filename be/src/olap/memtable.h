@@ -0,0 +1,106 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_OLAP_MEMTABLE_H
+#define BDG_PALO_BE_SRC_OLAP_MEMTABLE_H
+
+#include <memory>
+#include <vector>
+
+#include "olap/olap_define.h"
+#include "olap/olap_table.h"
+#include "olap/row_cursor.h"
+#include "olap/skiplist.h"
+
+namespace palo {
+
+class IWriter;
+class MemPool;
+class MemTracker;
+
+// Rows of one tablet kept in memory sorted by key, so that they can be written
+// as a delta without an external sort.
+//
+// For AGG_KEYS and UNIQUE_KEYS tablets, a row is aggregated at once into the row
+// of the same key already in the memtable when all value columns have a fixed
+// length. Otherwise rows of the same key are kept in the order they are inserted
+// and aggregated when the memtable is flushed.
+//
+// Usage:
+// 1. MemTable mem_table(table); mem_table.init();
+// 2. loop: mem_table.insert(row)
+// 3. writer = IWriter::create(table, delta_index, true); writer->init();
+//    mem_table.flush(writer); writer->finalize();
+class MemTable {
+public:
+    explicit MemTable(SmartOLAPTable table);
+    ~MemTable();
+
+    OLAPStatus init();
+
+    // Copies 'row', a row of the tablet schema, into the memtable.
+    OLAPStatus insert(const RowCursor& row);
+
+    // Writes all rows in key order through 'writer', which is not finalized.
+    OLAPStatus flush(IWriter* writer);
+
+    // Bytes allocated for the rows
+    int64_t memory_usage() const;
+
+    // Rows inserted, including the ones aggregated into another row
+    size_t num_rows() const { return _num_rows; }
+
+private:
+    class RowComparator {
+    public:
+        RowComparator(const RowCursor* row, size_t num_key_fields) :
+                _row(row), _num_key_fields(num_key_fields) {}
+
+        int operator()(char* left, char* right) const {
+            for (size_t i = 0; i < _num_key_fields; ++i) {
+                const Field* field = _row->get_field_by_index(i);
+                int res = field->cmp(field->get_field_ptr(left), field->get_field_ptr(right));
+                if (res != 0) {
+                    return res;
+                }
+            }
+            return 0;
+        }
+
+    private:
+        const RowCursor* _row;
+        size_t _num_key_fields;
+    };
+
+    typedef SkipList<char*, RowComparator> Table;
+
+    SmartOLAPTable _table;
+    std::unique_ptr<MemTracker> _mem_tracker;
+    std::unique_ptr<MemPool> _mem_pool;
+    // attached to a row in the memtable, also gives the layout of the rows
+    RowCursor _row;
+    std::vector<uint32_t> _key_cids;
+    std::vector<uint32_t> _value_cids;
+    bool _aggregate;
+    bool _aggregate_in_place;
+    std::unique_ptr<Table> _skip_list;
+    size_t _num_rows;
+
+    DISALLOW_COPY_AND_ASSIGN(MemTable);
+};
+
+}  // namespace palo
+
+#endif // BDG_PALO_BE_SRC_OLAP_MEMTABLE_H
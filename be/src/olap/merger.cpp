@@ -15,6 +15,7 @@
 
 #include "olap/merger.h"
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 
@@ -23,8 +24,13 @@
 #include "olap/olap_index.h"
 #include "olap/olap_table.h"
 #include "olap/reader.h"
+#include "olap/row_block.h"
 #include "olap/row_cursor.h"
+#include "olap/utils.h"
 #include "olap/writer.h"
+#include "runtime/mem_pool.h"
+#include "runtime/mem_tracker.h"
+#include "util/palo_metrics.h"
 
 using std::list;
 using std::string;
@@ -34,20 +40,39 @@ using std::vector;
 
 namespace palo {
 
+// Copies the key columns of 'row' to a new RowCursor.
+static OLAPStatus copy_key(const SmartOLAPTable& table, const RowCursor& row,
+                           unique_ptr<RowCursor>* key) {
+    key->reset(new(std::nothrow) RowCursor());
+    if (*key == NULL) {
+        OLAP_LOG_WARNING("fail to malloc RowCursor.");
+        return OLAP_ERR_MALLOC_ERROR;
+    }
+    if (OLAP_SUCCESS != (*key)->init(table->tablet_schema(), table->num_key_fields())) {
+        OLAP_LOG_WARNING("fail to init row cursor.");
+        return OLAP_ERR_INIT_FAILED;
+    }
+    (*key)->allocate_memory_for_string_type(table->tablet_schema());
+    return (*key)->copy_without_pool(row);
+}
+
 Merger::Merger(SmartOLAPTable table, OLAPIndex* index, ReaderType type) : 
         _table(table),
         _index(index),
         _reader_type(type),
         _row_count(0),
         _uniq_keys(table->num_key_fields(), 1),
-        _selectivities(table->num_key_fields(), 1) {}
+        _selectivities(table->num_key_fields(), 1),
+        _start_key(NULL),
+        _end_key(NULL) {}
 
 OLAPStatus Merger::merge(
         const vector<IData*>& olap_data_arr,
         bool use_simple_merge,
         uint64_t* merged_rows,
         uint64_t* filted_rows) {
-    if (use_simple_merge && _check_simple_merge(olap_data_arr)) {
+    bool is_key_range = _start_key != NULL || _end_key != NULL;
+    if (use_simple_merge && !is_key_range && _check_simple_merge(olap_data_arr)) {
         *merged_rows = 0;
         *filted_rows = 0;
         return _create_hard_link();
@@ -161,6 +186,8 @@ OLAPStatus Merger::_merge(
     reader_params.olap_table = _table;
     reader_params.reader_type = _reader_type;
     reader_params.olap_data_arr = olap_data_arr;
+    reader_params.merge_start_key = _start_key;
+    reader_params.merge_end_key = _end_key;
 
     if (_reader_type == READER_BASE_COMPACTION) {
         reader_params.version = _index->version();
@@ -187,8 +214,30 @@ OLAPStatus Merger::_merge(
     }
 
     bool has_error = false;
+    OlapStopWatch watch;
     // We calculate selectivities only when base compactioning.
     bool need_calculate_selectivities = (_index->version().first == 0);
+
+    // Column files are written a whole block at a time: the rows are merged straight
+    // into a block of our own, rather than attached to the block of the writer one by one.
+    bool write_by_block = _table->data_file_type() == COLUMN_ORIENTED_FILE;
+    unique_ptr<RowBlock> row_block;
+    uint32_t num_block_rows = 0;
+    if (write_by_block) {
+        row_block.reset(new(std::nothrow) RowBlock(_table->tablet_schema()));
+        if (NULL == row_block) {
+            OLAP_LOG_WARNING("fail to allocate row block.");
+            return OLAP_ERR_MALLOC_ERROR;
+        }
+        RowBlockInfo block_info(0U, _table->num_rows_per_row_block(), 0);
+        block_info.data_file_type = COLUMN_ORIENTED_FILE;
+        block_info.null_supported = true;
+        if (OLAP_SUCCESS != row_block->init(block_info)) {
+            OLAP_LOG_WARNING("fail to init row block.");
+            return OLAP_ERR_INIT_FAILED;
+        }
+    }
+
     RowCursor row_cursor;
 
     if (OLAP_SUCCESS != row_cursor.init(_table->tablet_schema())) {
@@ -204,19 +253,37 @@ OLAPStatus Merger::_merge(
     }
 
     bool eof = false;
-    MemPool* mem_pool = writer->mem_pool();
+    // holds the strings of last_row only, the blocks being written are cleared
+    // once they are flushed
+    MemTracker last_row_tracker(-1);
+    MemPool last_row_pool(&last_row_tracker);
 
     // The following procedure would last for long time, half of one day, etc.
     while (!has_error) {
-        // Attach row cursor to the memory position of the row block being
-        // written in writer.
-        if (OLAP_SUCCESS != writer->attached_by(&row_cursor)) {
-            OLAP_LOG_WARNING("attach row failed. [table='%s']",
-                    _table->full_name().c_str());
-            has_error = true;
-            break;
+        if (write_by_block) {
+            if (num_block_rows == row_block->capacity()) {
+                if (OLAP_SUCCESS != _write_row_block(
+                        writer.get(), row_block.get(), num_block_rows)) {
+                    has_error = true;
+                    break;
+                }
+                num_block_rows = 0;
+            }
+            row_block->get_row(num_block_rows, &row_cursor);
+            row_cursor.allocate_memory_for_string_type(
+                    _table->tablet_schema(), row_block->mem_pool());
+        } else {
+            // Attach row cursor to the memory position of the row block being
+            // written in writer.
+            if (OLAP_SUCCESS != writer->attached_by(&row_cursor)) {
+                OLAP_LOG_WARNING("attach row failed. [table='%s']",
+                        _table->full_name().c_str());
+                has_error = true;
+                break;
+            }
+            row_cursor.allocate_memory_for_string_type(
+                    _table->tablet_schema(), writer->mem_pool());
         }
-        row_cursor.allocate_memory_for_string_type(_table->tablet_schema(), mem_pool);
 
         // Read one row into row_cursor
         OLAPStatus res = reader.next_row_with_aggregation(&row_cursor, &eof);
@@ -229,12 +296,22 @@ OLAPStatus Merger::_merge(
             break;
         }
 
-        // Goto next row position in the row block being written
-        writer->next(row_cursor);
+        if (write_by_block) {
+            writer->update_column_statistics(row_cursor);
+            ++num_block_rows;
+        } else {
+            // Goto next row position in the row block being written
+            writer->next(row_cursor);
+        }
 
         if (need_calculate_selectivities) {
             // Calculate statistics while base compaction
-            if (0 != _row_count) {
+            if (0 == _row_count) {
+                if (OLAP_SUCCESS != copy_key(_table, row_cursor, &_first_key)) {
+                    has_error = true;
+                    break;
+                }
+            } else {
                 size_t first_diff_id = 0;
 
                 if (OLAP_SUCCESS != last_row.get_first_different_column_id(
@@ -250,7 +327,8 @@ OLAPStatus Merger::_merge(
             }
 
             // set last row for next comapration.
-            if (OLAP_SUCCESS != last_row.copy(row_cursor, mem_pool)) {
+            last_row_pool.clear();
+            if (OLAP_SUCCESS != last_row.copy(row_cursor, &last_row_pool)) {
                 OLAP_LOG_WARNING("fail to copy last row.");
                 has_error = true;
                 break;
@@ -260,6 +338,18 @@ OLAPStatus Merger::_merge(
         ++_row_count;
     }
 
+    if (!has_error && need_calculate_selectivities && 0 != _row_count) {
+        if (OLAP_SUCCESS != copy_key(_table, last_row, &_last_key)) {
+            has_error = true;
+        }
+    }
+
+    if (!has_error && write_by_block && num_block_rows > 0) {
+        if (OLAP_SUCCESS != _write_row_block(writer.get(), row_block.get(), num_block_rows)) {
+            has_error = true;
+        }
+    }
+
     if (OLAP_SUCCESS != writer->finalize()) {
         OLAP_LOG_WARNING("fail to finalize writer. [table='%s']",
                 _table->full_name().c_str());
@@ -276,10 +366,38 @@ OLAPStatus Merger::_merge(
     if (!has_error) {
         *merged_rows = reader.merged_rows();
         *filted_rows = reader.filted_rows();
+
+        uint64_t input_rows = _row_count + reader.merged_rows() + reader.filted_rows();
+        uint64_t elapsed_us = watch.get_elapse_time_us();
+        OLAP_LOG_INFO("finish merging rows. [table=%s; reader_type=%d; input_rows=%lu; "
+                      "output_rows=%lu; elapsed_us=%lu; rows_per_sec=%lu]",
+                      _table->full_name().c_str(), _reader_type, input_rows, _row_count,
+                      elapsed_us, input_rows * 1000000 / std::max<uint64_t>(elapsed_us, 1));
+        if (_reader_type == READER_BASE_COMPACTION) {
+            PaloMetrics::base_compaction_rows_total.increment(input_rows);
+        } else if (_reader_type == READER_CUMULATIVE_COMPACTION) {
+            PaloMetrics::cumulative_compaction_rows_total.increment(input_rows);
+        }
     }
 
     return has_error ? OLAP_ERR_OTHER_ERROR : OLAP_SUCCESS;
 }
 
+OLAPStatus Merger::_write_row_block(IWriter* writer, RowBlock* row_block, uint32_t num_rows) {
+    OLAPStatus res = row_block->finalize(num_rows);
+    if (OLAP_SUCCESS != res) {
+        OLAP_LOG_WARNING("fail to finalize row block. [num_rows=%u res=%d]", num_rows, res);
+        return res;
+    }
+    res = writer->write_row_block(row_block);
+    if (OLAP_SUCCESS != res) {
+        OLAP_LOG_WARNING("fail to write row block. [table='%s' res=%d]",
+                _table->full_name().c_str(), res);
+        return res;
+    }
+    row_block->clear();
+    return OLAP_SUCCESS;
+}
+
 
 }  // namespace palo
@@ -23,6 +23,9 @@ namespace palo {
 
 class OLAPIndex;
 class IData;
+class IWriter;
+class RowBlock;
+class RowCursor;
 
 class Merger {
 public:
@@ -49,6 +52,26 @@ public:
     const std::vector<uint32_t>& selectivities() {
         return _selectivities;
     }
+    // 获取每一种前缀组合的独特值个数
+    const std::vector<uint64_t>& uniq_keys() {
+        return _uniq_keys;
+    }
+
+    // Hands over the key columns of the first and the last merged rows, which are kept
+    // when the selectivities are calculated. Left NULL if no row was merged. Key ranges
+    // merged apart use them to count the prefixes that span two ranges once.
+    void release_boundary_keys(std::unique_ptr<RowCursor>* first_key,
+                               std::unique_ptr<RowCursor>* last_key) {
+        *first_key = std::move(_first_key);
+        *last_key = std::move(_last_key);
+    }
+
+    // Only merges the rows whose short key is in [start_key, end_key), NULL leaving
+    // that side open. The keys are owned by the caller. Disables the hard link merge.
+    void set_key_range(const RowCursor* start_key, const RowCursor* end_key) {
+        _start_key = start_key;
+        _end_key = end_key;
+    }
 
 private:
     OLAPStatus _merge(
@@ -56,6 +79,9 @@ private:
             uint64_t* merged_rows,
             uint64_t* filted_rows);
 
+    // Writes the first 'num_rows' rows of 'row_block' and clears it.
+    OLAPStatus _write_row_block(IWriter* writer, RowBlock* row_block, uint32_t num_rows);
+
     bool _check_simple_merge(const std::vector<IData*>& olap_data_arr);
 
     OLAPStatus _create_hard_link();
@@ -66,7 +92,11 @@ private:
     uint64_t _row_count;
     std::vector<uint64_t> _uniq_keys;      // 存储每一种前缀组合的独特值个数
     std::vector<uint32_t> _selectivities;  // 保存每一种前缀组合的selectivity
+    std::unique_ptr<RowCursor> _first_key;
+    std::unique_ptr<RowCursor> _last_key;
     Version _simple_merge_version;
+    const RowCursor* _start_key;
+    const RowCursor* _end_key;
 
     DISALLOW_COPY_AND_ASSIGN(Merger);
 };
@@ -115,7 +115,11 @@ enum FieldAggregationMethod {
     OLAP_FIELD_AGGREGATION_MAX = 3,
     OLAP_FIELD_AGGREGATION_REPLACE = 4,
     OLAP_FIELD_AGGREGATION_HLL_UNION = 5,
-    OLAP_FIELD_AGGREGATION_UNKNOWN = 6
+    OLAP_FIELD_AGGREGATION_UNKNOWN = 6,
+    // union of roaring bitmaps serialized in a VARCHAR column, see Field
+    OLAP_FIELD_AGGREGATION_BITMAP_UNION = 7,
+    // merge of t-digests serialized in a VARCHAR column, see Field
+    OLAP_FIELD_AGGREGATION_QUANTILE_UNION = 8
 };
 
 // 压缩算法类型
@@ -71,6 +71,7 @@ static const std::string SNAPSHOT_PREFIX = "/snapshot";
 static const std::string TRASH_PREFIX = "/trash";
 static const std::string UNUSED_PREFIX = "/unused";
 static const std::string ERROR_LOG_PREFIX = "/error_log";
+static const std::string META_PREFIX = "/meta";
 
 static const int32_t OLAP_DATA_VERSION_APPLIED = PALO_V1;
 
@@ -257,6 +258,8 @@ enum OLAPStatus {
     // [-1400, -1500)
     OLAP_ERR_HEADER_ADD_VERSION = -1400,
     OLAP_ERR_HEADER_DELETE_VERSION = -1401,
+    OLAP_ERR_HEADER_META_ERROR = -1402,
+    OLAP_ERR_HEADER_NOT_IN_META = -1403,
 
     // OLAPTableSchema
     // [-1500, -1600)
@@ -32,13 +32,16 @@
 #include "olap/cumulative_compaction.h"
 #include "olap/lru_cache.h"
 #include "olap/olap_header.h"
+#include "olap/olap_meta.h"
 #include "olap/olap_rootpath.h"
 #include "olap/olap_snapshot.h"
 #include "olap/push_handler.h"
 #include "olap/schema_change.h"
 #include "olap/utils.h"
 #include "olap/writer.h"
+#include "runtime/mem_tracker.h"
 #include "util/palo_metrics.h"
+#include "util/thread_pool.hpp"
 
 using boost::filesystem::canonical;
 using boost::filesystem::directory_iterator;
@@ -71,24 +74,42 @@ bool _sort_table_by_create_time(const SmartOLAPTable& a, const SmartOLAPTable& b
 OLAPEngine::OLAPEngine() :
         _global_table_id(0),
         _file_descriptor_lru_cache(NULL),
-        _index_stream_lru_cache(NULL) {}
+        _index_stream_lru_cache(NULL),
+        _index_entry_lru_cache(NULL),
+        _index_mem_tracker(new MemTracker(-1, "OLAPIndex")),
+        _column_encode_pool(NULL) {}
 
 OLAPEngine::~OLAPEngine() {
     clear();
+    SAFE_DELETE(_index_mem_tracker);
 }
 
 OLAPStatus OLAPEngine::_load_tables(const string& tablet_root_path) {
-    // 遍历跟目录寻找所有的shard
+    OLAPMeta* meta = get_meta(tablet_root_path);
+    if (meta == NULL) {
+        OLAP_LOG_WARNING("fail to get meta. [root=%s]", tablet_root_path.c_str());
+        return OLAP_ERR_INIT_FAILED;
+    }
+
+    set<string> meta_schema_hash_paths;
+    OLAPStatus res = _load_tables_from_meta(meta, &meta_schema_hash_paths);
+    if (res != OLAP_SUCCESS) {
+        return res;
+    }
+
+    // 只遍历目录不读文件, 加载OLAPMeta中没有的表, 如升级前创建的表,
+    // 以及clone和restore拷贝了表头文件但尚未导入时重启的表
+    string data_path = meta->root_path() + DATA_PREFIX;
     set<string> shards;
-    if (dir_walk(tablet_root_path + DATA_PREFIX, &shards, NULL) != OLAP_SUCCESS) {
-        OLAP_LOG_WARNING("fail to walk dir. [root=%s]", tablet_root_path.c_str());
+    if (dir_walk(data_path, &shards, NULL) != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to walk dir. [root=%s]", data_path.c_str());
         return OLAP_ERR_INIT_FAILED;
     }
 
     for (const auto& shard : shards) {
         // 遍历shard目录寻找此shard的所有tablet
         set<string> tablets;
-        string one_shard_path = tablet_root_path + DATA_PREFIX +  '/' + shard;
+        string one_shard_path = data_path + '/' + shard;
         if (dir_walk(one_shard_path, &tablets, NULL) != OLAP_SUCCESS) {
             OLAP_LOG_WARNING("fail to walk dir. [root=%s]", one_shard_path.c_str());
             continue;
@@ -104,17 +125,21 @@ OLAPStatus OLAPEngine::_load_tables(const string& tablet_root_path) {
             }
 
             for (const auto& schema_hash : schema_hashes) {
+                string schema_hash_path = one_tablet_path + '/' + schema_hash;
+                if (meta_schema_hash_paths.find(schema_hash_path)
+                        != meta_schema_hash_paths.end()) {
+                    continue;
+                }
+
                 TTabletId tablet_id = strtoul(tablet.c_str(), NULL, 10);
                 TSchemaHash tablet_schema_hash = strtoul(schema_hash.c_str(), NULL, 10);
 
-                // 遍历schema_hash目录寻找此index的所有schema
                 // 加载失败依然加载下一个Table
-                if (load_one_tablet(
-                        tablet_id,
-                        tablet_schema_hash,
-                        one_tablet_path + '/' + schema_hash) != OLAP_SUCCESS) {
+                OLAP_LOG_INFO("load table not in meta. [path='%s']", schema_hash_path.c_str());
+                if (load_one_tablet(tablet_id, tablet_schema_hash, schema_hash_path)
+                        != OLAP_SUCCESS) {
                     OLAP_LOG_WARNING("fail to load one table, but continue. [path='%s']",
-                                     (one_tablet_path + '/' + schema_hash).c_str());
+                                     schema_hash_path.c_str());
                 }
             }
         }
@@ -123,6 +148,85 @@ OLAPStatus OLAPEngine::_load_tables(const string& tablet_root_path) {
     return OLAP_SUCCESS;
 }
 
+OLAPStatus OLAPEngine::_load_tables_from_meta(OLAPMeta* meta, set<string>* schema_hash_paths) {
+    auto load_table = [this, meta, schema_hash_paths](const string& schema_hash_path,
+                                                      const string& value) {
+        schema_hash_paths->insert(schema_hash_path);
+
+        // sample: root_path/DATA_PREFIX/shard/tablet_id/schema_hash
+        path boost_schema_hash_path(schema_hash_path);
+        TTabletId tablet_id = strtoul(
+                boost_schema_hash_path.parent_path().filename().string().c_str(), NULL, 10);
+        SchemaHash schema_hash = strtoul(
+                boost_schema_hash_path.filename().string().c_str(), NULL, 10);
+
+        stringstream header_name_stream;
+        header_name_stream << schema_hash_path << "/" << tablet_id << ".hdr";
+        if (access(header_name_stream.str().c_str(), F_OK) == 0) {
+            // 表头文件是clone或restore拷贝来尚未导入的表头, 比OLAPMeta中的新
+            if (load_one_tablet(tablet_id, schema_hash, schema_hash_path) != OLAP_SUCCESS) {
+                OLAP_LOG_WARNING("fail to load one table, but continue. [path='%s']",
+                                 schema_hash_path.c_str());
+            }
+            return;
+        }
+
+        if (access(schema_hash_path.c_str(), F_OK) != 0) {
+            OLAP_LOG_WARNING("tablet in meta not exist, remove it. [path='%s']",
+                             schema_hash_path.c_str());
+            meta->remove_header(schema_hash_path);
+            return;
+        }
+
+        OLAPTable* olap_table = _create_table_from_meta(
+                tablet_id, schema_hash, schema_hash_path, value);
+        if (olap_table == NULL) {
+            OLAP_LOG_WARNING("fail to load table from meta. [path='%s']",
+                             schema_hash_path.c_str());
+            move_to_trash(boost_schema_hash_path, boost_schema_hash_path);
+            meta->remove_header(schema_hash_path);
+            return;
+        }
+
+        OLAPStatus res = _add_loaded_table(
+                tablet_id, schema_hash, olap_table, schema_hash_path, false);
+        if (res != OLAP_SUCCESS && res != OLAP_ERR_ENGINE_INSERT_EXISTS_TABLE) {
+            OLAP_LOG_WARNING("fail to load one table, but continue. [path='%s']",
+                             schema_hash_path.c_str());
+            meta->remove_header(schema_hash_path);
+        }
+    };
+
+    OLAPStatus res = meta->load_headers(load_table);
+    if (res != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to load tables from meta. [root=%s]",
+                         meta->root_path().c_str());
+        return OLAP_ERR_INIT_FAILED;
+    }
+
+    return OLAP_SUCCESS;
+}
+
+OLAPTable* OLAPEngine::_create_table_from_meta(
+        TTabletId tablet_id, SchemaHash schema_hash, const string& schema_hash_path,
+        const string& header) {
+    // 表头文件名仍用于生成数据文件名
+    stringstream header_name_stream;
+    header_name_stream << schema_hash_path << "/" << tablet_id << ".hdr";
+    OLAPHeader* olap_header = new(nothrow) OLAPHeader(header_name_stream.str());
+    if (olap_header == NULL) {
+        OLAP_LOG_WARNING("fail to malloc OLAPHeader.");
+        return NULL;
+    }
+
+    if (olap_header->load_from_meta(header) != OLAP_SUCCESS) {
+        delete olap_header;
+        return NULL;
+    }
+
+    return OLAPTable::create_from_header(olap_header, tablet_id, schema_hash);
+}
+
 OLAPStatus OLAPEngine::load_one_tablet(
         TTabletId tablet_id, SchemaHash schema_hash, const string& schema_hash_path,
         bool force) {
@@ -131,23 +235,77 @@ OLAPStatus OLAPEngine::load_one_tablet(
     string header_path = header_name_stream.str();
     path boost_schema_hash_path(schema_hash_path);
 
-    if (access(header_path.c_str(), F_OK) != 0) {
-        OLAP_LOG_WARNING("fail to find header file. [header_path=%s]", header_path.c_str());
-        move_to_trash(boost_schema_hash_path, boost_schema_hash_path);
-        return OLAP_ERR_FILE_NOT_EXIST;
-    }
+    OLAPTable* olap_table = NULL;
+    bool import_header_file = access(header_path.c_str(), F_OK) == 0;
+    if (import_header_file) {
+        olap_table = OLAPTable::create_from_header_file(tablet_id, schema_hash, header_path);
+    } else {
+        OLAPMeta* meta = NULL;
+        OLAPStatus res = _get_tablet_meta(schema_hash_path, &meta);
+        if (res != OLAP_SUCCESS) {
+            return res;
+        }
 
-    OLAPTable* olap_table = OLAPTable::create_from_header_file(
-            tablet_id, schema_hash, header_path);
+        string header;
+        res = meta == NULL ? OLAP_ERR_HEADER_NOT_IN_META
+                           : meta->get_header(schema_hash_path, &header);
+        if (res == OLAP_ERR_HEADER_NOT_IN_META) {
+            OLAP_LOG_WARNING("fail to find header. [header_path=%s]", header_path.c_str());
+            move_to_trash(boost_schema_hash_path, boost_schema_hash_path);
+            return OLAP_ERR_FILE_NOT_EXIST;
+        } else if (res != OLAP_SUCCESS) {
+            return res;
+        }
+        olap_table = _create_table_from_meta(tablet_id, schema_hash, schema_hash_path, header);
+    }
     if (olap_table == NULL) {
         OLAP_LOG_WARNING("fail to load table. [header_path=%s]", header_path.c_str());
         move_to_trash(boost_schema_hash_path, boost_schema_hash_path);
         return OLAP_ERR_ENGINE_LOAD_INDEX_TABLE_ERROR;
     }
+
+    OLAPStatus res = _add_loaded_table(tablet_id, schema_hash, olap_table, schema_hash_path,
+                                       force);
+    if (res != OLAP_SUCCESS) {
+        // 插入已经存在的table时返回成功
+        if (res == OLAP_ERR_ENGINE_INSERT_EXISTS_TABLE) {
+            return OLAP_SUCCESS;
+        }
+        return res;
+    }
+
+    if (!import_header_file) {
+        return OLAP_SUCCESS;
+    }
+
+    // 表头存入OLAPMeta后删除表头文件, 删除前重启时会再次导入
+    SmartOLAPTable table = get_table(tablet_id, schema_hash);
+    if (table.get() != NULL) {
+        table->obtain_header_rdlock();
+        res = table->save_header();
+        table->release_header_lock();
+        if (res != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("fail to save header to meta. [res=%d table=%s]",
+                             res, table->full_name().c_str());
+            return OLAP_ERR_HEADER_META_ERROR;
+        }
+    }
+    if (remove(header_path.c_str()) != 0) {
+        OLAP_LOG_WARNING("fail to remove imported header file. [header_path=%s]",
+                         header_path.c_str());
+    }
+
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus OLAPEngine::_add_loaded_table(
+        TTabletId tablet_id, SchemaHash schema_hash, OLAPTable* olap_table,
+        const string& schema_hash_path, bool force) {
+    path boost_schema_hash_path(schema_hash_path);
     if (olap_table->latest_version() == NULL && !olap_table->is_schema_changing()) {
         OLAP_LOG_WARNING("tablet not in schema change state without delta is invalid. "
-                         "[header_path=%s]",
-                         header_path.c_str());
+                         "[path=%s]",
+                         schema_hash_path.c_str());
         move_to_trash(boost_schema_hash_path, boost_schema_hash_path);
         SAFE_DELETE(olap_table);
         return OLAP_ERR_ENGINE_LOAD_INDEX_TABLE_ERROR;
@@ -158,9 +316,8 @@ OLAPStatus OLAPEngine::load_one_tablet(
     string table_name = olap_table->full_name();
     res = add_table(tablet_id, schema_hash, olap_table, force);
     if (res != OLAP_SUCCESS) {
-        // 插入已经存在的table时返回成功
         if (res == OLAP_ERR_ENGINE_INSERT_EXISTS_TABLE) {
-            return OLAP_SUCCESS;
+            return res;
         }
 
         OLAP_LOG_WARNING("failed to add table. [table=%s]", table_name.c_str());
@@ -186,6 +343,116 @@ OLAPStatus OLAPEngine::load_one_tablet(
     return OLAP_SUCCESS;
 }
 
+OLAPMeta* OLAPEngine::get_meta(const string& root_path) {
+    string meta_root_path = root_path;
+    while (meta_root_path.size() > 1 && meta_root_path[meta_root_path.size() - 1] == '/') {
+        meta_root_path.erase(meta_root_path.size() - 1);
+    }
+
+    AutoMutexLock l(&_meta_lock);
+    auto it = _metas.find(meta_root_path);
+    if (it != _metas.end()) {
+        return it->second;
+    }
+
+    OLAPMeta* meta = new(nothrow) OLAPMeta(meta_root_path);
+    if (meta == NULL) {
+        OLAP_LOG_WARNING("fail to malloc OLAPMeta.");
+        return NULL;
+    }
+    if (meta->init() != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to init meta. [root=%s]", meta_root_path.c_str());
+        delete meta;
+        return NULL;
+    }
+    _metas[meta_root_path] = meta;
+    return meta;
+}
+
+OLAPStatus OLAPEngine::_get_tablet_meta(const string& schema_hash_path, OLAPMeta** meta) {
+    *meta = NULL;
+    // sample: root_path/DATA_PREFIX/shard/tablet_id/schema_hash
+    string tablet_path = schema_hash_path;
+    while (tablet_path.size() > 1 && tablet_path[tablet_path.size() - 1] == '/') {
+        tablet_path.erase(tablet_path.size() - 1);
+    }
+    path data_path = path(tablet_path).parent_path().parent_path().parent_path();
+    if ("/" + data_path.filename().string() != DATA_PREFIX) {
+        return OLAP_SUCCESS;
+    }
+
+    string root_path = data_path.parent_path().string();
+    *meta = get_meta(root_path);
+    if (*meta == NULL) {
+        return OLAP_ERR_HEADER_META_ERROR;
+    }
+    if (!(*meta)->is_tablet_path(tablet_path)) {
+        *meta = NULL;
+    }
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus OLAPEngine::save_header(const OLAPHeader& header) {
+    string schema_hash_path = path(header.file_name()).parent_path().string();
+    OLAPMeta* meta = NULL;
+    OLAPStatus res = _get_tablet_meta(schema_hash_path, &meta);
+    if (res != OLAP_SUCCESS) {
+        return res;
+    }
+    if (meta == NULL) {
+        // 快照等目录中的表头只保存在表头文件中, 供clone和restore拷贝
+        return header.save();
+    }
+
+    res = meta->save_header(schema_hash_path, header);
+    if (res != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to save header to meta. [res=%d path=%s]",
+                         res, schema_hash_path.c_str());
+    }
+    return res;
+}
+
+OLAPStatus OLAPEngine::save_headers(const vector<SmartOLAPTable>& tables) {
+    OLAPStatus res = OLAP_SUCCESS;
+    map<OLAPMeta*, vector<SmartOLAPTable>> meta_tables;
+    for (SmartOLAPTable table : tables) {
+        string schema_hash_path = table->construct_dir_path();
+        OLAPMeta* meta = NULL;
+        res = _get_tablet_meta(schema_hash_path, &meta);
+        if (res != OLAP_SUCCESS) {
+            return res;
+        }
+        if (meta == NULL) {
+            res = table->save_header();
+            if (res != OLAP_SUCCESS) {
+                return res;
+            }
+            continue;
+        }
+        meta_tables[meta].push_back(table);
+    }
+
+    for (auto& it : meta_tables) {
+        OLAPMeta* meta = it.first;
+        OLAPMeta::Batch batch;
+        for (SmartOLAPTable table : it.second) {
+            string schema_hash_path = table->construct_dir_path();
+            res = batch.put_header(meta, schema_hash_path, table->header());
+            if (res != OLAP_SUCCESS) {
+                return res;
+            }
+        }
+        res = meta->write(&batch);
+        if (res != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("fail to save headers to meta. [res=%d root=%s]",
+                             res, meta->root_path().c_str());
+            return res;
+        }
+    }
+
+    return OLAP_SUCCESS;
+}
+
 void* load_root_path_thread_callback(void* arg) {
     OLAPStatus res = OLAP_SUCCESS;
     string root_path = (char*)arg;
@@ -260,6 +527,19 @@ OLAPStatus OLAPEngine::init() {
         return OLAP_ERR_INIT_FAILED;
     }
 
+    _index_entry_lru_cache = new_lru_cache(config::index_entry_cache_capacity);
+    if (_index_entry_lru_cache == NULL) {
+        OLAP_LOG_WARNING("failed to init index entry LRUCache");
+        _tablet_map.clear();
+        return OLAP_ERR_INIT_FAILED;
+    }
+
+    if (config::column_encode_thread_num > 0) {
+        // 每个任务编码一个row block的一列
+        _column_encode_pool = new ThreadPool(config::column_encode_thread_num,
+                                             config::column_encode_thread_num * 16);
+    }
+
     // 初始化CE调度器
     vector<RootPathInfo> all_root_paths_info;
     OLAPRootPath::get_instance()->get_all_root_path_info(&all_root_paths_info);
@@ -289,9 +569,17 @@ OLAPStatus OLAPEngine::clear() {
     // 删除lru中所有内容,其实进程退出这么做本身意义不大,但对单测和更容易发现问题还是有很大意义的
     SAFE_DELETE(_file_descriptor_lru_cache);
     SAFE_DELETE(_index_stream_lru_cache);
+    SAFE_DELETE(_column_encode_pool);
 
     _tablet_map.clear();
     _global_table_id = 0;
+    // 表中的OLAPIndex析构时还要访问index entry cache
+    SAFE_DELETE(_index_entry_lru_cache);
+
+    for (auto& it : _metas) {
+        SAFE_DELETE(it.second);
+    }
+    _metas.clear();
 
     return OLAP_SUCCESS;
 }
@@ -654,11 +942,22 @@ OLAPTable* OLAPEngine::create_table(
             }
         }
 
-        olap_table = OLAPTable::create_from_header_file(
-                request.tablet_id, request.tablet_schema.schema_hash, header_path);
+        // 表头已存入OLAPMeta, 和启动时一样由OLAPMeta中的表头创建表
+        string schema_hash_path = path(header_path).parent_path().string();
+        OLAPMeta* meta = NULL;
+        string header;
+        if (_get_tablet_meta(schema_hash_path, &meta) == OLAP_SUCCESS && meta != NULL
+                && meta->get_header(schema_hash_path, &header) == OLAP_SUCCESS) {
+            olap_table = _create_table_from_meta(
+                    request.tablet_id, request.tablet_schema.schema_hash,
+                    schema_hash_path, header);
+        }
         if (olap_table == NULL) {
             OLAP_LOG_WARNING("fail to load olap table from header. [header_path=%s]",
                              header_path.c_str());
+            if (meta != NULL) {
+                meta->remove_header(schema_hash_path);
+            }
             if (remove_parent_dir(header_path) != OLAP_SUCCESS) {
                 OLAP_LOG_WARNING("fail to remove header path. [header_path=%s]",
                                  header_path.c_str());
@@ -921,7 +1220,7 @@ void OLAPEngine::start_clean_fd_cache() {
     OLAP_LOG_TRACE("end clean file descritpor cache");
 }
 
-void OLAPEngine::start_base_compaction(string* last_base_compaction_fs, TTabletId* last_base_compaction_tablet_id) {
+bool OLAPEngine::_in_base_compaction_hours() {
     uint64_t base_compaction_start_hour = config::base_compaction_start_hour;
     uint64_t base_compaction_end_hour = config::base_compaction_end_hour;
     time_t current_time = time(NULL);
@@ -935,7 +1234,7 @@ void OLAPEngine::start_base_compaction(string* last_base_compaction_fs, TTabletI
                            current_hour,
                            base_compaction_start_hour,
                            base_compaction_end_hour);
-            return;
+            return false;
         }
     } else { // 如果执行BE的时间区间设置为类似以下的形式：[22:00, 8:00)
         if (current_hour < base_compaction_start_hour
@@ -945,9 +1244,16 @@ void OLAPEngine::start_base_compaction(string* last_base_compaction_fs, TTabletI
                            current_hour,
                            base_compaction_start_hour,
                            base_compaction_end_hour);
-            return;
+            return false;
         }
     }
+    return true;
+}
+
+void OLAPEngine::start_base_compaction(string* last_base_compaction_fs, TTabletId* last_base_compaction_tablet_id) {
+    if (!_in_base_compaction_hours()) {
+        return;
+    }
 
     SmartOLAPTable tablet;
     BaseCompaction base_compaction;
@@ -1011,6 +1317,21 @@ TRY_START_BE_OK:
     }
 }
 
+uint32_t OLAPEngine::acquire_base_compaction_slots(const string& root_path, uint32_t wanted) {
+    AutoMutexLock auto_lock(&_fs_task_mutex);
+    uint32_t& used = _fs_base_compaction_slot_num_map[root_path];
+    uint32_t budget = std::max(config::base_compaction_slots_per_disk, 1);
+    uint32_t slots = used < budget ? std::min(wanted, budget - used) : 0;
+    slots = std::max(slots, 1U);
+    used += slots;
+    return slots;
+}
+
+void OLAPEngine::release_base_compaction_slots(const string& root_path, uint32_t slots) {
+    AutoMutexLock auto_lock(&_fs_task_mutex);
+    _fs_base_compaction_slot_num_map[root_path] -= slots;
+}
+
 void OLAPEngine::_select_candidate() {
     // 这是一个小根堆，用于记录nice最大的top k个candidate tablet
     SmartOLAPTable tablet;
@@ -1426,10 +1747,10 @@ OLAPStatus OLAPEngine::_create_new_table_header_file(
         header.set_in_restore_mode(true);
     }
 
-    // save header file
+    // save header into OLAPMeta
     header.set_creation_time(time(NULL));
     header.set_cumulative_layer_point(-1);
-    res = header.save();
+    res = save_header(header);
     if (res != OLAP_SUCCESS) {
         remove_dir(header_dir);
         return res;
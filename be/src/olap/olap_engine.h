@@ -39,7 +39,10 @@ namespace palo {
 
 void* load_root_path_thread_callback(void* arg);
 
+class MemTracker;
+class OLAPMeta;
 class OLAPTable;
+class ThreadPool;
 
 // OLAPEngine singleton to manage all Table pointers.
 // Providing add/drop/get operations.
@@ -47,6 +50,7 @@ class OLAPTable;
 // allocation/deallocation must be done outside.
 class OLAPEngine {
     friend void* load_root_path_thread_callback(void* arg);
+    friend class CompactionScheduler;
 
     DECLARE_SINGLETON(OLAPEngine)
 public:
@@ -116,6 +120,13 @@ public:
     void start_clean_fd_cache();
     void start_base_compaction(std::string* last_base_compaction_fs, TTabletId* last_base_compaction_tablet_id);
 
+    // A base compaction merges its key ranges with as many threads as it holds merge
+    // slots of its disk. Each disk has config::base_compaction_slots_per_disk slots.
+    // Takes up to 'wanted' free slots of 'root_path', and always at least one, so that
+    // a compaction never waits. Returns the number of slots taken.
+    uint32_t acquire_base_compaction_slots(const std::string& root_path, uint32_t wanted);
+    void release_base_compaction_slots(const std::string& root_path, uint32_t slots);
+
     // 调度ce，优先级调度
     void start_cumulative_priority();
 
@@ -126,11 +137,27 @@ public:
     // 是允许的，但re-load全新的path是不允许的，因为此处没有彻底更新ce调度器信息
     void load_root_paths(const OLAPRootPath::RootPathVec& root_paths);
 
+    // Loads the tablet in 'schema_hash_path'. A header file in the dir, copied there by
+    // a clone, restore or migration, is imported into the OLAPMeta and removed,
+    // otherwise the header is read from the OLAPMeta.
     OLAPStatus load_one_tablet(TTabletId tablet_id,
                                SchemaHash schema_hash,
                                const std::string& schema_hash_path,
                                bool force = false);
 
+    // Returns the OLAPMeta holding the headers of the tablets of 'root_path', opening
+    // it on first use. Returns NULL if it cannot be opened.
+    OLAPMeta* get_meta(const std::string& root_path);
+
+    // Saves 'header' into the OLAPMeta of its root path if it is the header of a
+    // tablet under root_path/DATA_PREFIX, otherwise, eg for a snapshot, into its
+    // header file.
+    OLAPStatus save_header(const OLAPHeader& header);
+
+    // Saves the headers of 'tables' like save_header(), the headers of the tables of
+    // one root path in one atomic batch of its OLAPMeta.
+    OLAPStatus save_headers(const std::vector<SmartOLAPTable>& tables);
+
     Cache* index_stream_lru_cache() {
         return _index_stream_lru_cache;
     }
@@ -139,6 +166,23 @@ public:
         return _file_descriptor_lru_cache;
     }
 
+    // Short key entries of the OLAPIndexes, loaded on their first lookup.
+    // NULL before init().
+    Cache* index_entry_lru_cache() {
+        return _index_entry_lru_cache;
+    }
+
+    // Tracks the memory of the short key entries in the cache above.
+    MemTracker* index_mem_tracker() {
+        return _index_mem_tracker;
+    }
+
+    // Shared by the writers of all pushes to encode the columns of a row block in
+    // parallel. NULL if config::column_encode_thread_num is 0.
+    ThreadPool* column_encode_pool() {
+        return _column_encode_pool;
+    }
+
     // 清理trash和snapshot文件，返回清理后的磁盘使用量
     OLAPStatus start_trash_sweep(double *usage);
 
@@ -186,9 +230,29 @@ private:
                      std::set<std::string>* dirs,
                      std::set<std::string>* files);
 
-    // 扫描目录, 加载表
+    // 顺序扫描OLAPMeta加载表, 再遍历目录加载OLAPMeta中没有的表
     OLAPStatus _load_tables(const std::string& tables_root_path);
 
+    // 顺序扫描一遍OLAPMeta加载所有表, 返回OLAPMeta中所有表的目录
+    OLAPStatus _load_tables_from_meta(OLAPMeta* meta, std::set<std::string>* schema_hash_paths);
+
+    // 由OLAPMeta中的表头创建表, 失败时返回NULL
+    OLAPTable* _create_table_from_meta(TTabletId tablet_id,
+                                       SchemaHash schema_hash,
+                                       const std::string& schema_hash_path,
+                                       const std::string& header);
+
+    // schema_hash_path为root_path/DATA_PREFIX/shard/tablet_id/schema_hash时, 返回其OLAPMeta,
+    // 否则*meta为NULL
+    OLAPStatus _get_tablet_meta(const std::string& schema_hash_path, OLAPMeta** meta);
+
+    // 检查并登记一个加载好的表, 失败时将schema_hash_path移到trash
+    OLAPStatus _add_loaded_table(TTabletId tablet_id,
+                                 SchemaHash schema_hash,
+                                 OLAPTable* olap_table,
+                                 const std::string& schema_hash_path,
+                                 bool force);
+
     OLAPStatus _create_new_table_header_file(const TCreateTabletReq& request,
                                              const std::string& root_path,
                                              std::string* header_path,
@@ -199,6 +263,9 @@ private:
 
     bool _can_do_compaction(SmartOLAPTable table);
 
+    // 当前时间是否在允许执行base compaction的时间区间内
+    static bool _in_base_compaction_hours();
+
     void _select_candidate();
 
     void _cancel_unfinished_schema_change();
@@ -213,11 +280,20 @@ private:
     size_t _global_table_id;
     Cache* _file_descriptor_lru_cache;
     Cache* _index_stream_lru_cache;
+    Cache* _index_entry_lru_cache;
+    MemTracker* _index_mem_tracker;
+    ThreadPool* _column_encode_pool;
+
+    MutexLock _meta_lock;
+    // root path -> OLAPMeta, guarded by _meta_lock
+    std::map<std::string, OLAPMeta*> _metas;
     uint32_t _max_base_compaction_task_per_disk;
     uint32_t _max_cumulative_compaction_task_per_disk;
 
     MutexLock _fs_task_mutex;
     file_system_task_count_t _fs_base_compaction_task_num_map;
+    // merge slots taken on each disk, guarded by _fs_task_mutex
+    file_system_task_count_t _fs_base_compaction_slot_num_map;
     std::vector<CompactionCandidate> _cumulative_compaction_candidate;
     std::vector<CompactionDiskStat> _cumulative_compaction_disk_stat;
     std::map<std::string, uint32_t> _disk_id_map;
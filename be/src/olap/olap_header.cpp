@@ -99,6 +99,30 @@ OLAPStatus OLAPHeader::load() {
         return OLAP_ERR_PARSE_PROTOBUF_ERROR;
     }
 
+    return _construct_version_graph();
+}
+
+OLAPStatus OLAPHeader::load_from_meta(const string& value) {
+    if (!ParseFromString(value)) {
+        OLAP_LOG_WARNING("fail to parse header from meta. [path='%s']", _file_name.c_str());
+        return OLAP_ERR_PARSE_PROTOBUF_ERROR;
+    }
+
+    return _construct_version_graph();
+}
+
+OLAPStatus OLAPHeader::load_from(const OLAPHeaderMessage& header) {
+    try {
+        CopyFrom(header);
+    } catch (...) {
+        OLAP_LOG_WARNING("fail to copy protocol buffer object. [path='%s']", _file_name.c_str());
+        return OLAP_ERR_OTHER_ERROR;
+    }
+
+    return _construct_version_graph();
+}
+
+OLAPStatus OLAPHeader::_construct_version_graph() {
     clear_version_graph(&_version_graph, &_vertex_helper_map);
 
     if (construct_version_graph(file_version(),
@@ -111,11 +135,11 @@ OLAPStatus OLAPHeader::load() {
     return OLAP_SUCCESS;
 }
 
-OLAPStatus OLAPHeader::save() {
+OLAPStatus OLAPHeader::save() const {
     return save(_file_name);
 }
 
-OLAPStatus OLAPHeader::save(const string& file_path) {
+OLAPStatus OLAPHeader::save(const string& file_path) const {
     FileHeader<OLAPHeaderMessage> file_header;
     FileHandler file_handler;
 
@@ -40,9 +40,17 @@ public:
     // tablet schema, delta version and so on.
     OLAPStatus load();
 
-    // Saves the header to disk, returning true on success.
-    OLAPStatus save();
-    OLAPStatus save(const std::string& file_path);
+    // Loads the header from 'value', a header serialized in the OLAPMeta of its root
+    // path. file_name() still names the header file.
+    OLAPStatus load_from_meta(const std::string& value);
+
+    // Loads a copy of 'header', the header of a loaded table.
+    OLAPStatus load_from(const OLAPHeaderMessage& header);
+
+    // Saves the header to disk, returning true on success. The headers of the tablets
+    // of a root path are saved with OLAPEngine::save_header() instead.
+    OLAPStatus save() const;
+    OLAPStatus save(const std::string& file_path) const;
 
     // Return the file name of the heade.
     std::string file_name() const {
@@ -91,6 +99,8 @@ public:
     const OLAPStatus version_creation_time(const Version& version, int64_t* creation_time) const;
 
 private:
+    OLAPStatus _construct_version_graph();
+
     // Compute schema hash(all fields name and type, index name and its field
     // names) using lzo_adler32 function.
     OLAPStatus _compute_schema_hash(SchemaHash* schema_hash);
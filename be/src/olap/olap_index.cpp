@@ -15,17 +15,24 @@
 
 #include "olap/olap_index.h"
 
+#include <sys/mman.h>
+
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cmath>
 #include <fstream>
 
 #include "olap/olap_data.h"
+#include "olap/olap_engine.h"
 #include "olap/olap_table.h"
 #include "olap/row_block.h"
 #include "olap/row_cursor.h"
 #include "olap/utils.h"
 #include "olap/wrapper_field.h"
+#include "runtime/mem_tracker.h"
+#include "util/defer_op.h"
+#include "util/palo_metrics.h"
 
 using std::ifstream;
 using std::string;
@@ -42,6 +49,18 @@ namespace palo {
         } \
     } while (0);
 
+// The entries stay pinned until the end of the lookup, also when the caller did not
+// acquire the index.
+#define ENTRIES_LOAD() \
+    _pin(); \
+    DeferOp unpin_entries(std::bind<void>(&OLAPIndex::_unpin, this)); \
+    do { \
+        OLAPStatus load_res = _load_entries(); \
+        if (load_res != OLAP_SUCCESS) { \
+            return load_res; \
+        } \
+    } while (0);
+
 #define POS_PARAM_VALIDATE(pos) \
     do { \
         if (NULL == pos) { \
@@ -91,14 +110,31 @@ OLAPIndex::OLAPIndex(OLAPTable* table,
     }
 
     _index_loaded = false;
-    _ref_count = 0;
+    _ref_count.store(0);
     _header_file_name = _table->header_file_name();
+
+    static std::atomic<uint64_t> s_next_entries_cache_id(0);
+    _entries_cache_id = s_next_entries_cache_id.fetch_add(1);
+    _entries.store(NULL);
+    _entries_cache = NULL;
+    _entries_handle = NULL;
 }
 
 OLAPIndex::~OLAPIndex() {
     delete [] _short_key_buf;
     _current_file_handler.close();
 
+    _index.detach_entries();
+    if (_entries_handle != NULL) {
+        _entries_cache->release(_entries_handle);
+    }
+    if (_entries_cache != NULL) {
+        _entries_cache->erase(_entries_cache_key());
+    } else {
+        // 没有cache时索引项归OLAPIndex所有
+        delete _entries.load();
+    }
+
     if (_inited_column_statistics) {
             for (size_t i = 0; i < _column_statistics.size(); ++i) {
             SAFE_DELETE(_column_statistics[i].first);
@@ -110,19 +146,47 @@ OLAPIndex::~OLAPIndex() {
 }
 
 void OLAPIndex::acquire() {
-    atomic_inc(&_ref_count);
+    _pin();
 }
 
 int64_t OLAPIndex::ref_count() {
-    return _ref_count;
+    return _ref_count.load();
 }
 
 void OLAPIndex::release() {
-    atomic_dec(&_ref_count);
+    _unpin();
 }
 
 bool OLAPIndex::is_in_use() {
-    return _ref_count > 0;
+    return _ref_count.load() > 0;
+}
+
+void OLAPIndex::_pin() const {
+    // the entries are not released while the count stays above 0
+    int64_t ref_count = _ref_count.load();
+    while (ref_count > 0) {
+        if (_ref_count.compare_exchange_weak(ref_count, ref_count + 1)) {
+            return;
+        }
+    }
+    // from 0 to 1 under the lock, so that the entries are not released meanwhile
+    boost::lock_guard<boost::mutex> guard(_index_load_lock);
+    _ref_count.fetch_add(1);
+}
+
+void OLAPIndex::_unpin() const {
+    int64_t ref_count = _ref_count.load();
+    while (ref_count > 1) {
+        if (_ref_count.compare_exchange_weak(ref_count, ref_count - 1)) {
+            return;
+        }
+    }
+    // from 1 to 0 under the lock, the entries can only be pinned again after
+    // they are released
+    boost::lock_guard<boost::mutex> guard(_index_load_lock);
+    if (_ref_count.fetch_sub(1) == 1) {
+        _release_entries();
+    }
 }
 
 // you can not use OLAPIndex after delete_all_files(), or else unknown behavior occurs.
@@ -277,6 +341,85 @@ OLAPStatus OLAPIndex::load() {
     return OLAP_SUCCESS;
 }
 
+static void delete_index_entries(const CacheKey& key, void* value) {
+    MemIndexEntries* entries = reinterpret_cast<MemIndexEntries*>(value);
+    PaloMetrics::index_entry_cache_bytes.increment(-static_cast<int64_t>(entries->charge()));
+    delete entries;
+}
+
+OLAPStatus OLAPIndex::_load_entries() const {
+    // 索引项只在没有人持有索引时才会被释放
+    if (_entries.load(std::memory_order_acquire) != NULL) {
+        return OLAP_SUCCESS;
+    }
+
+    boost::lock_guard<boost::mutex> guard(_index_load_lock);
+    if (_entries.load() != NULL) {
+        return OLAP_SUCCESS;
+    }
+
+    OLAPEngine* engine = OLAPEngine::get_instance();
+    Cache* cache = engine->index_entry_lru_cache();
+    string key = _entries_cache_key();
+    if (cache != NULL) {
+        Cache::Handle* handle = cache->lookup(key);
+        if (handle != NULL) {
+            PaloMetrics::index_entry_cache_hit_total.increment(1);
+            MemIndexEntries* entries = reinterpret_cast<MemIndexEntries*>(cache->value(handle));
+            _entries_cache = cache;
+            _entries_handle = handle;
+            _index.attach_entries(entries);
+            _entries.store(entries, std::memory_order_release);
+            return OLAP_SUCCESS;
+        }
+        PaloMetrics::index_entry_cache_miss_total.increment(1);
+    }
+
+    OlapStopWatch watch;
+    MemIndexEntries* entries = new(std::nothrow) MemIndexEntries(engine->index_mem_tracker());
+    if (entries == NULL) {
+        OLAP_LOG_WARNING("fail to malloc index entries.");
+        return OLAP_ERR_MALLOC_ERROR;
+    }
+    entries->resize(_index.segment_count());
+    for (uint32_t seg_id = 0; seg_id < _index.segment_count(); ++seg_id) {
+        string path = _table->construct_index_file_path(_version, _version_hash, seg_id);
+        OLAPStatus res = _index.load_entries(
+                seg_id, path.c_str(), config::index_entry_cache_use_mmap, entries);
+        if (res != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("fail to load index entries. [path='%s']", path.c_str());
+            _check_io_error(res);
+            delete entries;
+            return res;
+        }
+    }
+    if (config::enable_short_key_index) {
+        _index.build_short_key_index(entries);
+    }
+    PaloMetrics::index_entry_load_duration_us.increment(watch.get_elapse_time_us());
+
+    if (cache != NULL) {
+        PaloMetrics::index_entry_cache_bytes.increment(entries->charge());
+        _entries_cache = cache;
+        _entries_handle = cache->insert(key, entries, entries->charge(), delete_index_entries);
+    }
+    _index.attach_entries(entries);
+    _entries.store(entries, std::memory_order_release);
+    return OLAP_SUCCESS;
+}
+
+void OLAPIndex::_release_entries() const {
+    // 没有cache时索引项一直留在内存中
+    if (_ref_count.load() > 0 || _entries_handle == NULL) {
+        return;
+    }
+
+    _index.detach_entries();
+    _entries.store(NULL);
+    _entries_cache->release(_entries_handle);
+    _entries_handle = NULL;
+}
+
 OLAPStatus OLAPIndex::load_pb(const char* file, uint32_t seg_id) {
     OLAPStatus res = OLAP_SUCCESS;
 
@@ -338,6 +481,7 @@ OLAPStatus OLAPIndex::find_row_block(const RowCursor& key,
                                  bool find_last,
                                  RowBlockPosition* pos) const {
     TABLE_PARAM_VALIDATE();
+    ENTRIES_LOAD();
     POS_PARAM_VALIDATE(pos);
 
     // 将这部分逻辑从memindex移出来，这样可以复用find。
@@ -363,6 +507,7 @@ OLAPStatus OLAPIndex::find_short_key(const RowCursor& key,
                                  bool find_last,
                                  RowBlockPosition* pos) const {
     TABLE_PARAM_VALIDATE();
+    ENTRIES_LOAD();
     POS_PARAM_VALIDATE(pos);
 
     // 由于find会从前一个segment找起，如果前一个segment中恰好没有该key，
@@ -383,6 +528,7 @@ OLAPStatus OLAPIndex::find_short_key(const RowCursor& key,
 
 OLAPStatus OLAPIndex::get_row_block_entry(const RowBlockPosition& pos, EntrySlice* entry) const {
     TABLE_PARAM_VALIDATE();
+    ENTRIES_LOAD();
     SLICE_PARAM_VALIDATE(entry);
     
     return _index.get_entry(_index.get_offset(pos), entry);
@@ -390,6 +536,7 @@ OLAPStatus OLAPIndex::get_row_block_entry(const RowBlockPosition& pos, EntrySlic
 
 OLAPStatus OLAPIndex::find_first_row_block(RowBlockPosition* position) const {
     TABLE_PARAM_VALIDATE();
+    ENTRIES_LOAD();
     POS_PARAM_VALIDATE(position);
     
     return _index.get_row_block_position(_index.find_first(), position);
@@ -397,6 +544,7 @@ OLAPStatus OLAPIndex::find_first_row_block(RowBlockPosition* position) const {
 
 OLAPStatus OLAPIndex::find_last_row_block(RowBlockPosition* position) const {
     TABLE_PARAM_VALIDATE();
+    ENTRIES_LOAD();
     POS_PARAM_VALIDATE(position);
     
     return _index.get_row_block_position(_index.find_last(), position);
@@ -404,6 +552,7 @@ OLAPStatus OLAPIndex::find_last_row_block(RowBlockPosition* position) const {
 
 OLAPStatus OLAPIndex::find_next_row_block(RowBlockPosition* pos, bool* eof) const {
     TABLE_PARAM_VALIDATE();
+    ENTRIES_LOAD();
     POS_PARAM_VALIDATE(pos);
     POS_PARAM_VALIDATE(eof);
 
@@ -438,6 +587,8 @@ OLAPStatus OLAPIndex::find_mid_point(const RowBlockPosition& low,
 
 OLAPStatus OLAPIndex::find_prev_point(
         const RowBlockPosition& current, RowBlockPosition* prev) const {
+    ENTRIES_LOAD();
+
     OLAPIndexOffset current_offset = _index.get_offset(current);
     OLAPIndexOffset prev_offset = _index.prev(current_offset);
 
@@ -446,6 +597,7 @@ OLAPStatus OLAPIndex::find_prev_point(
 
 OLAPStatus OLAPIndex::advance_row_block(int64_t num_row_blocks, RowBlockPosition* position) const {
     TABLE_PARAM_VALIDATE();
+    ENTRIES_LOAD();
     POS_PARAM_VALIDATE(position);
 
     OLAPIndexOffset off = _index.get_offset(*position);
@@ -460,6 +612,12 @@ OLAPStatus OLAPIndex::advance_row_block(int64_t num_row_blocks, RowBlockPosition
 // PRECONDITION position1 < position2
 uint32_t OLAPIndex::compute_distance(const RowBlockPosition& position1,
                                      const RowBlockPosition& position2) const {
+    _pin();
+    DeferOp unpin_entries(std::bind<void>(&OLAPIndex::_unpin, this));
+    if (_load_entries() != OLAP_SUCCESS) {
+        return 0;
+    }
+
     iterator_offset_t offset1 = _index.get_absolute_offset(_index.get_offset(position1));
     iterator_offset_t offset2 = _index.get_absolute_offset(_index.get_offset(position2));
     
@@ -612,33 +770,58 @@ VersionHash OLAPIndex::version_hash() const {
     return _version_hash;
 }
 
-void OLAPIndex::_check_io_error(OLAPStatus res) {
+void OLAPIndex::_check_io_error(OLAPStatus res) const {
     if (is_io_error(res)) {
         _table->set_io_error();
     }
 }
 
+OLAPStatus OLAPIndex::get_row_block_position(
+        const OLAPIndexOffset& pos, RowBlockPosition* rbp) const {
+    ENTRIES_LOAD();
+
+    return _index.get_row_block_position(pos, rbp);
+}
+
 uint64_t OLAPIndex::num_index_entries() const {
     return _index.count();
 }
 
+MemIndexEntries::MemIndexEntries(MemTracker* tracker) :
+        heap_bytes(0),
+        mapped_bytes(0),
+        tracker(tracker),
+        mem_pool(new MemPool(tracker)) {}
+
+MemIndexEntries::~MemIndexEntries() {
+    for (size_t i = 0; i < buffers.size(); ++i) {
+        if (mappings[i].first != NULL) {
+            munmap(mappings[i].first, mappings[i].second);
+        } else {
+            free(buffers[i].data);
+        }
+    }
+    tracker->release(heap_bytes);
+    if (short_key_index != nullptr) {
+        tracker->release(short_key_index->memory_bytes());
+    }
+}
+
+void MemIndexEntries::resize(size_t num_segments) {
+    buffers.resize(num_segments);
+    mappings.resize(num_segments, std::pair<void*, size_t>(NULL, 0));
+}
+
 MemIndex::MemIndex()
     : _key_length(0),
       _num_entries(0),
       _index_size(0),
       _data_size(0),
-      _num_rows(0) {
-    _tracker.reset(new MemTracker(-1));
-    _mem_pool.reset(new MemPool(_tracker.get()));
-}
+      _num_rows(0),
+      _short_key_index(NULL) {}
 
 MemIndex::~MemIndex() {
     _num_entries = 0;
-    for (vector<SegmentMetaInfo>::iterator it = _meta.begin(); it != _meta.end(); ++it) {
-        free(it->buffer.data);
-        it->buffer.data = NULL;
-        it->buffer.length = 0;
-    }
 }
 
 OLAPStatus MemIndex::load_segment(const char* file, size_t *current_num_rows_per_row_block) {
@@ -646,7 +829,6 @@ OLAPStatus MemIndex::load_segment(const char* file, size_t *current_num_rows_per
 
     SegmentMetaInfo meta;
     OLAPIndexHeaderMessage pb;
-    uint32_t adler_checksum = 0;
     uint32_t num_entries = 0;
 
     if (file == NULL) {
@@ -715,8 +897,57 @@ OLAPStatus MemIndex::load_segment(const char* file, size_t *current_num_rows_per
     (current_num_rows_per_row_block == NULL
      || (*current_num_rows_per_row_block = meta.file_header.message().num_rows_per_block()));
 
+    file_handler.close();
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus MemIndex::load_entries(uint32_t seg_id, const char* file, bool use_mmap,
+                                  MemIndexEntries* entries) const {
+    OLAPStatus res = OLAP_SUCCESS;
+    const SegmentMetaInfo& meta = _meta[seg_id];
+    size_t num_entries = meta.count();
     if (OLAP_UNLIKELY(num_entries == 0)) {
+        return OLAP_SUCCESS;
+    }
+
+    FileHandler file_handler;
+    if ((res = file_handler.open_with_cache(file, O_RDONLY)) != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to open index file. [file='%s']", file);
+        return res;
+    }
+
+    size_t storage_length = meta.file_header.file_length() - meta.file_header.size();
+    bool null_supported = meta.file_header.message().has_null_supported()
+            && meta.file_header.message().null_supported();
+    size_t num_short_key_fields = short_key_num();
+
+    // 没有CHAR/VARCHAR时存储格式和内存格式相同, 可以直接使用文件映射的页
+    bool same_layout = null_supported;
+    for (size_t i = 0; i < num_short_key_fields; ++i) {
+        if ((*_fields)[i].type == OLAP_FIELD_TYPE_VARCHAR
+                || (*_fields)[i].type == OLAP_FIELD_TYPE_CHAR) {
+            same_layout = false;
+        }
+    }
+    if (use_mmap && same_layout) {
+        size_t map_length = meta.file_header.file_length();
+        void* map = mmap(NULL, map_length, PROT_READ, MAP_SHARED, file_handler.fd(), 0);
         file_handler.close();
+        if (map == MAP_FAILED) {
+            OLAP_LOG_WARNING("fail to mmap index file. [file='%s' err=%m]", file);
+            return OLAP_ERR_IO_ERROR;
+        }
+        entries->mappings[seg_id] = std::make_pair(map, map_length);
+        entries->mapped_bytes += map_length;
+
+        char* storage_data = reinterpret_cast<char*>(map) + meta.file_header.size();
+        if (olap_adler32(ADLER32_INIT, storage_data, storage_length)
+                != meta.file_header.checksum()) {
+            OLAP_LOG_WARNING("checksum validation error. [file='%s']", file);
+            return OLAP_ERR_INDEX_CHECKSUM_ERROR;
+        }
+        entries->buffers[seg_id].data = storage_data;
+        entries->buffers[seg_id].length = storage_length;
         return OLAP_SUCCESS;
     }
 
@@ -732,7 +963,6 @@ OLAPStatus MemIndex::load_segment(const char* file, size_t *current_num_rows_per
     }
 
     // 读取索引内容
-    // 为了启动加速，此处可使用mmap方式。
     if (file_handler.pread(storage_data,
                            storage_length,
                            meta.file_header.size()) != OLAP_SUCCESS) {
@@ -744,7 +974,7 @@ OLAPStatus MemIndex::load_segment(const char* file, size_t *current_num_rows_per
     }
 
     // checksum validation
-    adler_checksum = olap_adler32(ADLER32_INIT, storage_data, storage_length);
+    uint32_t adler_checksum = olap_adler32(ADLER32_INIT, storage_data, storage_length);
     if (adler_checksum != meta.file_header.checksum()) {
         res = OLAP_ERR_INDEX_CHECKSUM_ERROR;
         OLAP_LOG_WARNING("checksum validation error.");
@@ -795,7 +1025,7 @@ OLAPStatus MemIndex::load_segment(const char* file, size_t *current_num_rows_per
                 size_t storage_field_bytes =
                     *reinterpret_cast<StringLengthType*>(storage_ptr + null_byte);
                 StringSlice* slice = reinterpret_cast<StringSlice*>(mem_ptr + 1);
-                char* data = reinterpret_cast<char*>(_mem_pool->allocate(storage_field_bytes));
+                char* data = reinterpret_cast<char*>(entries->mem_pool->allocate(storage_field_bytes));
                 memory_copy(data, storage_ptr + sizeof(StringLengthType) + null_byte, storage_field_bytes);
                 slice->data = data;
                 slice->size = storage_field_bytes;
@@ -820,7 +1050,7 @@ OLAPStatus MemIndex::load_segment(const char* file, size_t *current_num_rows_per
 
                 // 2. copy length and content
                 StringSlice* slice = reinterpret_cast<StringSlice*>(mem_ptr + 1);
-                char* data = reinterpret_cast<char*>(_mem_pool->allocate(storage_field_bytes));
+                char* data = reinterpret_cast<char*>(entries->mem_pool->allocate(storage_field_bytes));
                 memory_copy(data, storage_ptr + null_byte, storage_field_bytes);
                 slice->data = data;
                 slice->size = storage_field_bytes;
@@ -849,14 +1079,59 @@ OLAPStatus MemIndex::load_segment(const char* file, size_t *current_num_rows_per
         storage_ptr += storage_row_bytes;
     }
 
-    _meta.back().buffer.data = mem_buf;
-    _meta.back().buffer.length = num_entries * mem_row_bytes;
+
+    entries->buffers[seg_id].data = mem_buf;
+    entries->buffers[seg_id].length = num_entries * mem_row_bytes;
+    entries->heap_bytes += num_entries * mem_row_bytes;
+    entries->tracker->consume(num_entries * mem_row_bytes);
     free(storage_data);
 
     file_handler.close();
     return OLAP_SUCCESS;
 }
 
+void MemIndex::build_short_key_index(MemIndexEntries* entries) const {
+    if (!ShortKeyIndex::is_supported(*_fields, _key_num)) {
+        return;
+    }
+
+    std::unique_ptr<ShortKeyIndex> index(new(std::nothrow) ShortKeyIndex(*_fields, _key_num));
+    if (index == nullptr) {
+        OLAP_LOG_WARNING("fail to malloc short key index.");
+        return;
+    }
+    size_t entry_length = new_entry_length();
+    for (size_t i = 0; i < entries->buffers.size(); ++i) {
+        const EntrySlice& buffer = entries->buffers[i];
+        for (size_t offset = 0; offset + entry_length <= buffer.length; offset += entry_length) {
+            index->add_entry(buffer.data + offset);
+        }
+    }
+    index->finish();
+    if (index->count() != _num_entries) {
+        OLAP_LOG_WARNING("short key index does not match index entries. "
+                         "[index_count=%u entry_count=%lu]", index->count(), _num_entries);
+        return;
+    }
+    entries->tracker->consume(index->memory_bytes());
+    entries->short_key_index.swap(index);
+}
+
+void MemIndex::attach_entries(const MemIndexEntries* entries) {
+    for (size_t i = 0; i < _meta.size(); ++i) {
+        _meta[i].buffer = entries->buffers[i];
+    }
+    _short_key_index = entries->short_key_index.get();
+}
+
+void MemIndex::detach_entries() {
+    for (SegmentMetaInfo& meta : _meta) {
+        meta.buffer.data = NULL;
+        meta.buffer.length = 0;
+    }
+    _short_key_index = NULL;
+}
+
 OLAPStatus MemIndex::init(size_t short_key_len, size_t new_short_key_len,
                           size_t short_key_num, RowFields* fields) {
     if (fields == NULL) {
@@ -893,6 +1168,21 @@ const OLAPIndexOffset MemIndex::find(const RowCursor& k,
         return begin();
     }
 
+    if (_short_key_index != NULL) {
+        char encoded_key[ShortKeyIndex::MAX_KEY_LENGTH];
+        int length = _short_key_index->encode_key(k, encoded_key);
+        if (length >= 0) {
+            uint32_t pos = _short_key_index->find(encoded_key, length, find_last);
+            // 和下面的两步查找结果一致: 返回pos前一项所在的segment, 以及它之后的位置
+            if (pos == 0) {
+                return begin();
+            }
+            OLAPIndexOffset offset = get_relative_offset(pos - 1);
+            offset.offset += 1;
+            return offset;
+        }
+    }
+
     OLAPIndexOffset offset;
     BinarySearchIterator it;
     BinarySearchIterator seg_beg(0);
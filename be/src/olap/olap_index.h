@@ -18,7 +18,9 @@
 
 #include <boost/thread/condition_variable.hpp>
 #include <boost/thread/mutex.hpp>
+#include <atomic>
 #include <iterator>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -29,10 +31,12 @@
 #include "olap/atomic.h"
 #include "olap/field.h"
 #include "olap/file_helper.h"
+#include "olap/lru_cache.h"
 #include "olap/olap_common.h"
 #include "olap/olap_define.h"
 #include "olap/olap_table.h"
 #include "olap/row_cursor.h"
+#include "olap/short_key_index.h"
 #include "olap/utils.h"
 
 namespace palo {
@@ -158,10 +162,43 @@ struct SegmentMetaInfo {
     }
 
     IDRange     range;
+    // points into the attached MemIndexEntries, empty while none is attached
     EntrySlice       buffer;
     FileHeader<OLAPIndexHeaderMessage, OLAPIndexFixedHeader>  file_header;
 };
 
+// Index entries of all segments of an OLAPIndex. They are loaded on the first lookup
+// of the index and kept in OLAPEngine::index_entry_lru_cache(), so that the indices
+// of tablets not queried recently do not stay in memory.
+struct MemIndexEntries {
+    explicit MemIndexEntries(MemTracker* tracker);
+    ~MemIndexEntries();
+
+    void resize(size_t num_segments);
+
+    // bytes charged to the cache
+    size_t charge() const {
+        return heap_bytes + mem_pool->total_reserved_bytes() + mapped_bytes
+                + (short_key_index == nullptr ? 0 : short_key_index->memory_bytes());
+    }
+
+    // one per segment
+    std::vector<EntrySlice> buffers;
+    // bytes of the buffers allocated on the heap, consumed on 'tracker'
+    size_t heap_bytes;
+    // one per segment, the mapped index file if its pages are the buffer,
+    // see config::index_entry_cache_use_mmap
+    std::vector<std::pair<void*, size_t>> mappings;
+    size_t mapped_bytes;
+    MemTracker* tracker;
+    // contents of CHAR and VARCHAR keys
+    std::unique_ptr<MemPool> mem_pool;
+    // NULL if the short keys can not be encoded, see ShortKeyIndex::is_supported()
+    std::unique_ptr<ShortKeyIndex> short_key_index;
+
+    DISALLOW_COPY_AND_ASSIGN(MemIndexEntries);
+};
+
 // In memory index structure, all index hold here
 class MemIndex {
 public:
@@ -176,9 +213,20 @@ public:
     OLAPStatus init(size_t short_key_len, size_t new_short_key_len,
                     size_t short_key_num, RowFields* fields);
 
-    // 加载一个segment到内存
+    // 加载一个segment的文件头, 索引项由load_entries()按需加载
     OLAPStatus load_segment(const char* file, size_t *current_num_rows_per_row_block);
 
+    // 加载一个segment的索引项到entries->buffers[seg_id]
+    OLAPStatus load_entries(uint32_t seg_id, const char* file, bool use_mmap,
+                            MemIndexEntries* entries) const;
+
+    // 用所有segment的索引项构建entries->short_key_index, short key类型不支持时不构建
+    void build_short_key_index(MemIndexEntries* entries) const;
+
+    // 使用entries中的索引项, 之后才能查找
+    void attach_entries(const MemIndexEntries* entries);
+    void detach_entries();
+
     // Return the IndexOffset of the first element, physically, it's (0, 0)
     const OLAPIndexOffset begin() const {
         OLAPIndexOffset off;
@@ -332,9 +380,9 @@ private:
     size_t _data_size;
     size_t _num_rows;
     RowFields*  _fields;
+    // short keys of the attached entries, find() uses it when not NULL
+    const ShortKeyIndex* _short_key_index;
 
-    std::unique_ptr<MemTracker> _tracker;
-    std::unique_ptr<MemPool> _mem_pool;
     DISALLOW_COPY_AND_ASSIGN(MemIndex);
 };
 
@@ -445,7 +493,8 @@ public:
 
     virtual ~OLAPIndex();
 
-    // Load the index into memory.
+    // Load the headers of the index files. The index entries are loaded on the first
+    // lookup, and stay in memory at least while the index is acquired.
     OLAPStatus load();
     bool index_loaded();
     OLAPStatus load_pb(const char* file, uint32_t seg_id);
@@ -528,7 +577,10 @@ public:
     OLAPStatus finalize_segment(uint32_t data_segment_size, int64_t num_rows);
     void sync();
 
-    // reference count
+    // reference count. The index entries may be evicted once nobody holds the index.
+    // Each lookup holds the index while it runs, but the entries returned by
+    // get_row_block_entry() are only valid until release(), so lookups which keep
+    // them are done between acquire() and release().
     void acquire();
     void release();
     bool is_in_use();
@@ -604,9 +656,7 @@ public:
         return _current_num_rows_per_row_block;
     }
 
-    OLAPStatus get_row_block_position(const OLAPIndexOffset& pos, RowBlockPosition* rbp) const {
-        return _index.get_row_block_position(pos, rbp);
-    }
+    OLAPStatus get_row_block_position(const OLAPIndexOffset& pos, RowBlockPosition* rbp) const;
     
     inline const FileHeader<column_file::ColumnDataHeaderMessage>* get_seg_pb(uint32_t seg_id) const {
         return &(_seg_pb_map.at(seg_id));
@@ -617,7 +667,26 @@ public:
     }
 
 private:
-    void _check_io_error(OLAPStatus res);
+    void _check_io_error(OLAPStatus res) const;
+
+    // Adds and drops a reference. The count only goes from 0 to 1 and from 1 to 0
+    // under _index_load_lock, and the entries are released at 0 under it, so a
+    // reference pins the entries.
+    void _pin() const;
+    void _unpin() const;
+
+    // Attaches the index entries to _index, from the cache or from the index files.
+    // The caller holds a reference.
+    OLAPStatus _load_entries() const;
+
+    // Gives the index entries back to the cache if nobody holds the index. The
+    // caller holds _index_load_lock.
+    void _release_entries() const;
+
+    std::string _entries_cache_key() const {
+        return std::string(reinterpret_cast<const char*>(&_entries_cache_id),
+                           sizeof(_entries_cache_id));
+    }
 
     std::string _construct_index_file_path(const Version& version,
                                            VersionHash version_hash,
@@ -646,8 +715,16 @@ private:
     uint32_t _num_segments;            // number of segments in this index
     VersionHash _version_hash;      // version hash for this index
     bool _index_loaded;                // whether the index has been read
-    atomic_t _ref_count;               // reference count
-    MemIndex _index;
+    mutable std::atomic<int64_t> _ref_count; // reference count
+    // _index is only modified to attach and detach its entries, under _index_load_lock
+    mutable MemIndex _index;
+
+    // unique among all OLAPIndexes, even of the same files
+    uint64_t _entries_cache_id;
+    // entries attached to _index, owned by the cache if _entries_handle is not NULL
+    mutable std::atomic<MemIndexEntries*> _entries;
+    mutable Cache* _entries_cache;
+    mutable Cache::Handle* _entries_handle;
 
     std::string _header_file_name;     // the name of the related header file
     // short key对应的field_info数组
@@ -0,0 +1,178 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "olap/olap_meta.h"
+
+#include <leveldb/db.h>
+#include <leveldb/write_batch.h>
+
+#include "olap/utils.h"
+
+using std::string;
+
+namespace palo {
+
+static const string HEADER_KEY_PREFIX = "hdr_";
+
+OLAPMeta::Batch::Batch() : _batch(new leveldb::WriteBatch()), _num_updates(0) {}
+
+OLAPMeta::Batch::~Batch() {
+    SAFE_DELETE(_batch);
+}
+
+OLAPStatus OLAPMeta::Batch::put_header(const OLAPMeta* meta,
+                                       const string& schema_hash_path,
+                                       const OLAPHeaderMessage& header) {
+    string key;
+    if (!meta->_header_key(schema_hash_path, &key)) {
+        return OLAP_SUCCESS;
+    }
+    string value;
+    if (!header.SerializeToString(&value)) {
+        OLAP_LOG_WARNING("fail to serialize header. [path='%s']", schema_hash_path.c_str());
+        return OLAP_ERR_SERIALIZE_PROTOBUF_ERROR;
+    }
+    _batch->Put(key, value);
+    ++_num_updates;
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus OLAPMeta::Batch::remove_header(const OLAPMeta* meta, const string& schema_hash_path) {
+    string key;
+    if (meta->_header_key(schema_hash_path, &key)) {
+        _batch->Delete(key);
+        ++_num_updates;
+    }
+    return OLAP_SUCCESS;
+}
+
+OLAPMeta::OLAPMeta(const string& root_path) : _root_path(root_path), _db(NULL) {
+    while (_root_path.size() > 1 && _root_path[_root_path.size() - 1] == '/') {
+        _root_path.erase(_root_path.size() - 1);
+    }
+}
+
+OLAPMeta::~OLAPMeta() {
+    SAFE_DELETE(_db);
+}
+
+OLAPStatus OLAPMeta::init() {
+    leveldb::Options options;
+    options.create_if_missing = true;
+    string meta_path = _root_path + META_PREFIX;
+    leveldb::Status s = leveldb::DB::Open(options, meta_path, &_db);
+    if (!s.ok()) {
+        OLAP_LOG_WARNING("fail to open meta. [path='%s' error='%s']",
+                         meta_path.c_str(), s.ToString().c_str());
+        _db = NULL;
+        return OLAP_ERR_HEADER_META_ERROR;
+    }
+    return OLAP_SUCCESS;
+}
+
+bool OLAPMeta::_header_key(const string& schema_hash_path, string* key) const {
+    // paths outside root_path/DATA_PREFIX, eg snapshots, are not tablets of the root path
+    if (schema_hash_path.compare(0, _root_path.size(), _root_path) != 0) {
+        return false;
+    }
+    size_t pos = schema_hash_path.find_first_not_of('/', _root_path.size());
+    if (pos == string::npos
+            || schema_hash_path.compare(pos, DATA_PREFIX.size() - 1, DATA_PREFIX, 1,
+                                        string::npos) != 0
+            || schema_hash_path.size() <= pos + DATA_PREFIX.size()
+            || schema_hash_path[pos + DATA_PREFIX.size() - 1] != '/') {
+        return false;
+    }
+    *key = HEADER_KEY_PREFIX + '/' + schema_hash_path.substr(pos);
+    return true;
+}
+
+bool OLAPMeta::is_tablet_path(const string& schema_hash_path) const {
+    string key;
+    return _header_key(schema_hash_path, &key);
+}
+
+OLAPStatus OLAPMeta::get_header(const string& schema_hash_path, string* header) {
+    string key;
+    if (!_header_key(schema_hash_path, &key)) {
+        return OLAP_ERR_HEADER_NOT_IN_META;
+    }
+    leveldb::Status s = _db->Get(leveldb::ReadOptions(), key, header);
+    if (s.IsNotFound()) {
+        return OLAP_ERR_HEADER_NOT_IN_META;
+    } else if (!s.ok()) {
+        OLAP_LOG_WARNING("fail to read meta. [path='%s' error='%s']",
+                         schema_hash_path.c_str(), s.ToString().c_str());
+        return OLAP_ERR_HEADER_META_ERROR;
+    }
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus OLAPMeta::save_header(const string& schema_hash_path,
+                                 const OLAPHeaderMessage& header) {
+    Batch batch;
+    OLAPStatus res = batch.put_header(this, schema_hash_path, header);
+    if (res != OLAP_SUCCESS) {
+        return res;
+    }
+    return write(&batch);
+}
+
+OLAPStatus OLAPMeta::remove_header(const string& schema_hash_path) {
+    Batch batch;
+    batch.remove_header(this, schema_hash_path);
+    return write(&batch);
+}
+
+OLAPStatus OLAPMeta::write(Batch* batch) {
+    if (batch->_num_updates == 0) {
+        return OLAP_SUCCESS;
+    }
+    leveldb::WriteOptions options;
+    options.sync = true;
+    leveldb::Status s = _db->Write(options, batch->_batch);
+    if (!s.ok()) {
+        OLAP_LOG_WARNING("fail to write meta. [root=%s error='%s']",
+                         _root_path.c_str(), s.ToString().c_str());
+        return OLAP_ERR_HEADER_META_ERROR;
+    }
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus OLAPMeta::load_headers(
+        std::function<void(const string& schema_hash_path, const string& header)> func) {
+    leveldb::ReadOptions options;
+    // a startup scan reads every header once, keep it out of the block cache
+    options.fill_cache = false;
+    leveldb::Iterator* it = _db->NewIterator(options);
+    for (it->Seek(HEADER_KEY_PREFIX); it->Valid(); it->Next()) {
+        leveldb::Slice key = it->key();
+        if (!key.starts_with(HEADER_KEY_PREFIX)) {
+            break;
+        }
+        key.remove_prefix(HEADER_KEY_PREFIX.size());
+        func(_root_path + key.ToString(), it->value().ToString());
+    }
+    leveldb::Status s = it->status();
+    delete it;
+    if (!s.ok()) {
+        OLAP_LOG_WARNING("fail to scan meta. [root=%s error='%s']",
+                         _root_path.c_str(), s.ToString().c_str());
+        return OLAP_ERR_HEADER_META_ERROR;
+    }
+    return OLAP_SUCCESS;
+}
+
+}  // namespace palo
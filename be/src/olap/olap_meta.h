@@ -0,0 +1,107 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_OLAP_OLAP_META_H
+#define BDG_PALO_BE_SRC_OLAP_OLAP_META_H
+
+#include <functional>
+#include <string>
+
+#include "gen_cpp/olap_file.pb.h"
+#include "olap/olap_define.h"
+
+namespace leveldb {
+class DB;
+class WriteBatch;
+}
+
+namespace palo {
+
+// Headers of all tablets of one root path, kept in a LevelDB under
+// root_path/META_PREFIX. The key of a tablet is "hdr_" followed by the path of its
+// schema hash directory relative to the root path, eg "hdr_/data/12/10001/368169781",
+// and the value is its serialized OLAPHeaderMessage.
+//
+// The store is the only copy of the headers of the tablets under root_path/DATA_PREFIX.
+// Header files are written for snapshots only, and a header file found in a tablet dir
+// was copied there by a clone or restore and is newer than the store, until it is
+// imported and removed.
+//
+// Loading all tablets of a root path is one sequential scan of the keys, instead of
+// walking the directories and reading one header file per tablet. A batch of header
+// updates is written atomically.
+class OLAPMeta {
+public:
+    // Header updates written together by write().
+    class Batch {
+    public:
+        Batch();
+        ~Batch();
+
+        // Updates of paths outside root_path/DATA_PREFIX, eg snapshots, are ignored.
+        OLAPStatus put_header(const OLAPMeta* meta,
+                              const std::string& schema_hash_path,
+                              const OLAPHeaderMessage& header);
+        OLAPStatus remove_header(const OLAPMeta* meta, const std::string& schema_hash_path);
+
+    private:
+        friend class OLAPMeta;
+        leveldb::WriteBatch* _batch;
+        uint32_t _num_updates;
+
+        DISALLOW_COPY_AND_ASSIGN(Batch);
+    };
+
+    explicit OLAPMeta(const std::string& root_path);
+    ~OLAPMeta();
+
+    // Opens the store, creating it if it does not exist.
+    OLAPStatus init();
+
+    // Whether 'schema_hash_path' is the dir of a tablet of the root path, whose header
+    // is kept in the store.
+    bool is_tablet_path(const std::string& schema_hash_path) const;
+
+    // Returns OLAP_ERR_HEADER_NOT_IN_META if the store has no header for the tablet.
+    OLAPStatus get_header(const std::string& schema_hash_path, std::string* header);
+    OLAPStatus save_header(const std::string& schema_hash_path, const OLAPHeaderMessage& header);
+    OLAPStatus remove_header(const std::string& schema_hash_path);
+
+    // Writes all updates of 'batch' atomically, and syncs them.
+    OLAPStatus write(Batch* batch);
+
+    // Calls 'func' with the schema hash path and the serialized header of every
+    // tablet, in key order.
+    OLAPStatus load_headers(
+            std::function<void(const std::string& schema_hash_path,
+                               const std::string& header)> func);
+
+    const std::string& root_path() const {
+        return _root_path;
+    }
+
+private:
+    // Returns false if 'schema_hash_path' is not under the root path.
+    bool _header_key(const std::string& schema_hash_path, std::string* key) const;
+
+    std::string _root_path;
+    leveldb::DB* _db;
+
+    DISALLOW_COPY_AND_ASSIGN(OLAPMeta);
+};
+
+}  // namespace palo
+
+#endif // BDG_PALO_BE_SRC_OLAP_OLAP_META_H
@@ -25,6 +25,7 @@
 #include <gperftools/profiler.h>
 
 #include "olap/command_executor.h"
+#include "olap/compaction_scheduler.h"
 #include "olap/cumulative_compaction.h"
 #include "olap/olap_common.h"
 #include "olap/olap_define.h"
@@ -86,6 +87,28 @@ OLAPStatus OLAPServer::init(const char* config_path, const char* config_file) {
     }
 
     // start be and ce threads for merge data
+    if (config::compaction_worker_num > 0) {
+        if (CompactionScheduler::get_instance()->start() != OLAP_SUCCESS) {
+            OLAP_LOG_FATAL("failed to start compaction scheduler.");
+            return OLAP_ERR_INIT_FAILED;
+        }
+    } else {
+        OLAPStatus res = _start_compaction_threads();
+        if (res != OLAP_SUCCESS) {
+            return res;
+        }
+    }
+
+    if (0 != pthread_create(&_fd_cache_clean_thread, NULL, _fd_cache_clean_callback, NULL)) {
+        OLAP_LOG_FATAL("failed to start fd_cache_clean thread"); 
+        return OLAP_ERR_INIT_FAILED;
+    }
+
+    OLAP_LOG_TRACE("init finished.");
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus OLAPServer::_start_compaction_threads() {
     int32_t base_compaction_num_threads = config::base_compaction_num_threads;
     _base_compaction_threads.resize(base_compaction_num_threads, -1);
     for (uint32_t i = 0; i < base_compaction_num_threads; ++i) {
@@ -109,13 +132,6 @@ OLAPStatus OLAPServer::init(const char* config_path, const char* config_file) {
             return OLAP_ERR_INIT_FAILED;
         }
     }
-
-    if (0 != pthread_create(&_fd_cache_clean_thread, NULL, _fd_cache_clean_callback, NULL)) {
-        OLAP_LOG_FATAL("failed to start fd_cache_clean thread"); 
-        return OLAP_ERR_INIT_FAILED;
-    }
-
-    OLAP_LOG_TRACE("init finished.");
     return OLAP_SUCCESS;
 }
 
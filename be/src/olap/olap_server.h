@@ -33,6 +33,9 @@ public:
     OLAPStatus init(const char* path, const char* file);
 
 private:
+    // 每种compaction各自启动固定数目的线程，compaction_worker_num为0时使用
+    OLAPStatus _start_compaction_threads();
+
     // Thread functions
 
     // base compaction thread process function
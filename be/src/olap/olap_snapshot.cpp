@@ -345,19 +345,18 @@ OLAPStatus OLAPSnapshot::_create_snapshot_files(
             break;
         }
 
-        // load table header, in order to remove versions that not in shortest version path
-        string old_header_path = ref_olap_table->header_file_name();
-        new_olap_header = new(nothrow) OLAPHeader(old_header_path);
+        // copy table header, in order to remove versions that not in shortest version path
+        new_olap_header = new(nothrow) OLAPHeader(header_path);
         if (new_olap_header == NULL) {
             OLAP_LOG_WARNING("fail to malloc OLAPHeader.");
             res = OLAP_ERR_MALLOC_ERROR;
             break;
         }
 
-        res = new_olap_header->load();
+        res = new_olap_header->load_from(ref_olap_table->header());
         if (res != OLAP_SUCCESS) {
-            OLAP_LOG_WARNING("fail to load header. [res=%d header_file=%s]",
-                    res, old_header_path.c_str());
+            OLAP_LOG_WARNING("fail to copy header. [res=%d table='%s']",
+                    res, ref_olap_table->full_name().c_str());
             break;
         }
 
@@ -365,8 +364,8 @@ OLAPStatus OLAPSnapshot::_create_snapshot_files(
         header_locked = false;
         _update_header_file_info(shortest_versions, new_olap_header);
 
-        // save new header
-        if ((res = new_olap_header->save(header_path)) != OLAP_SUCCESS) {
+        // save new header, into the header file of the snapshot
+        if ((res = OLAPEngine::get_instance()->save_header(*new_olap_header)) != OLAP_SUCCESS) {
             OLAP_LOG_WARNING("save header error. [table='%s' path='%s']",
                     ref_olap_table->full_name().c_str(), header_path.c_str());
             break;
@@ -631,16 +630,16 @@ OLAPStatus OLAPSnapshot::_generate_new_header(
 
     {
         AutoRWLock auto_lock(tablet->get_header_lock_ptr(), true);
-        new_olap_header = new(nothrow) OLAPHeader(tablet->header_file_name());
+        new_olap_header = new(nothrow) OLAPHeader(new_header_path);
         if (new_olap_header == NULL) {
             OLAP_LOG_WARNING("fail to malloc OLAPHeader. [size=%d]", sizeof(OLAPHeader));
             return OLAP_ERR_MALLOC_ERROR;
         }
 
-        res = new_olap_header->load();
+        res = new_olap_header->load_from(tablet->header());
         if (res != OLAP_SUCCESS) {
-            OLAP_LOG_WARNING("fail to load header. [res=%d header_file=%s]",
-                    res, tablet->header_file_name().c_str());
+            OLAP_LOG_WARNING("fail to copy header. [res=%d table='%s']",
+                    res, tablet->full_name().c_str());
             SAFE_DELETE(new_olap_header);
             return res;
         }
@@ -648,7 +647,8 @@ OLAPStatus OLAPSnapshot::_generate_new_header(
 
     _update_header_file_info(version_entity_vec, new_olap_header);
 
-    res = new_olap_header->save(new_header_path);
+    // saved into OLAPMeta, load_one_tablet() loads the new table from there
+    res = OLAPEngine::get_instance()->save_header(*new_olap_header);
     if (res != OLAP_SUCCESS) {
         OLAP_LOG_WARNING("fail to save olap header to new path. [res=%d new_header_path='%s']",
                 res, new_header_path.c_str());
@@ -31,6 +31,7 @@
 #include "olap/olap_define.h"
 #include "olap/olap_engine.h"
 #include "olap/olap_index.h"
+#include "olap/olap_meta.h"
 #include "olap/olap_rootpath.h"
 #include "olap/reader.h"
 #include "olap/row_cursor.h"
@@ -64,16 +65,23 @@ OLAPTable* OLAPTable::create_from_header_file(
         return NULL;
     }
 
+    return create_from_header(olap_header, tablet_id, schema_hash);
+}
+
+OLAPTable* OLAPTable::create_from_header(
+        OLAPHeader* olap_header, TTabletId tablet_id, TSchemaHash schema_hash) {
+    bool header_changed = false;
     if (olap_header->data_file_type() == OLAP_DATA_FILE) {
         if (config::default_num_rows_per_data_block != olap_header->num_rows_per_data_block()) {
             olap_header->set_num_rows_per_data_block(config::default_num_rows_per_data_block);
-            olap_header->save();
+            header_changed = true;
         }
     }
 
-    olap_table = new(nothrow) OLAPTable(olap_header);
+    OLAPTable* olap_table = new(nothrow) OLAPTable(olap_header);
     if (olap_table == NULL) {
-        OLAP_LOG_WARNING("fail to validate table. [header_file=%s]", header_file.c_str());
+        OLAP_LOG_WARNING("fail to validate table. [header_file=%s]",
+                         olap_header->file_name().c_str());
         delete olap_header;
         return NULL;
     }
@@ -84,6 +92,10 @@ OLAPTable* OLAPTable::create_from_header_file(
     full_name_stream << tablet_id << "." << schema_hash;
     olap_table->_full_name = full_name_stream.str();
 
+    if (header_changed) {
+        olap_table->save_header();
+    }
+
     return olap_table;
 }
 
@@ -94,7 +106,8 @@ OLAPTable::OLAPTable(OLAPHeader* header) :
         _num_null_fields(0),
         _num_key_fields(0),
         _id(0),
-        _is_loaded(false) {
+        _is_loaded(false),
+        _scan_count(0) {
     if (header == NULL) {
         return;  // for convenience of mock test.
     }
@@ -217,12 +230,29 @@ OLAPTable::~OLAPTable() {
     // 移动数据目录
     if (_is_dropped) {
         path table_path = path_name.parent_path();
+        OLAPMeta* meta = OLAPEngine::get_instance()->get_meta(_storage_root_path);
+        if (meta == NULL || meta->remove_header(table_path.string()) != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("fail to remove header from meta. [table_path=%s]",
+                             table_path.c_str());
+        }
         if (move_to_trash(table_path, table_path) != OLAP_SUCCESS) {
             OLAP_LOG_WARNING("fail to delete table. [table_path=%s]", table_path.c_str());
         }
     }
 }
 
+OLAPStatus OLAPTable::save_header() {
+    OLAPStatus res = OLAPEngine::get_instance()->save_header(*_header);
+    if (res != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to save header. [res=%d table='%s']", res, _full_name.c_str());
+        if (is_io_error(res)) {
+            set_io_error();
+        }
+    }
+
+    return res;
+}
+
 OLAPStatus OLAPTable::load() {
     OLAPStatus res = OLAP_SUCCESS;
     AutoMutexLock l(&_load_lock);
@@ -754,7 +784,7 @@ OLAPStatus OLAPTable::merge_header(const OLAPHeader& hdr, int to_version) {
                 v.start_version(), v.end_version());
     }
 
-    st = _header->save();
+    st = save_header();
     if (st != OLAP_SUCCESS) {
        OLAP_LOG_FATAL("failed to save header when merging. tablet: %d", _tablet_id);
        return st;
@@ -859,6 +889,10 @@ OLAPStatus OLAPTable::split_range(
         return OLAP_SUCCESS;
     }
 
+    // 持有base_index期间它的索引项不会被淘汰
+    base_index->acquire();
+    DeferOp release_index(std::bind<void>(&OLAPIndex::release, base_index));
+
     uint64_t expected_rows = request_block_row_count
             / base_index->current_num_rows_per_row_block();
     if (expected_rows == 0) {
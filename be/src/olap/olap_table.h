@@ -16,6 +16,7 @@
 #ifndef BDG_PALO_BE_SRC_OLAP_OLAP_TABLE_H
 #define BDG_PALO_BE_SRC_OLAP_OLAP_TABLE_H
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <set>
@@ -95,6 +96,13 @@ public:
             TSchemaHash schema_hash,
             const std::string& header_file);
 
+    // Creates the table of a loaded header, which it owns from then on. Deletes the
+    // header and returns NULL on failure.
+    static OLAPTable* create_from_header(
+            OLAPHeader* header,
+            TTabletId tablet_id,
+            TSchemaHash schema_hash);
+
     virtual ~OLAPTable();
 
     // Initializes table and loads indices for all versions.
@@ -105,15 +113,23 @@ public:
         return _is_loaded;
     }
 
+    // 查询扫描本tablet的次数，CompactionScheduler据此估计读放大的代价
+    void record_scan() {
+        ++_scan_count;
+    }
+
+    int64_t scan_count() const {
+        return _scan_count.load();
+    }
+
     OLAPStatus load_indices();
 
-    OLAPStatus save_header() {
-        OLAPStatus res = _header->save();
-        if (res != OLAP_SUCCESS && is_io_error(res)) {
-            set_io_error();
-        }
+    // Saves the header with OLAPEngine::save_header(), into the OLAPMeta of the root
+    // path, or into the header file for a table of a snapshot.
+    OLAPStatus save_header();
 
-        return res;
+    const OLAPHeader& header() const {
+        return *_header;
     }
 
     OLAPStatus select_versions_to_span(const Version& version,
@@ -687,6 +703,7 @@ private:
     std::string _storage_root_path;
     volatile bool _is_loaded;
     MutexLock _load_lock;
+    std::atomic<int64_t> _scan_count;
 
     DISALLOW_COPY_AND_ASSIGN(OLAPTable);
 };
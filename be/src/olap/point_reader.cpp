@@ -0,0 +1,124 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "olap/point_reader.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "olap/column_file/column_data.h"
+#include "olap/column_predicate.h"
+#include "olap/delete_handler.h"
+#include "olap/i_data.h"
+#include "olap/olap_cond.h"
+#include "olap/row_cursor.h"
+
+namespace palo {
+
+OLAPStatus PointReader::lookup(const Version& version, const RowCursor& key,
+                               RowCursor* row, MemPool* mem_pool, bool* found) {
+    *found = false;
+    if (_table->keys_type() != UNIQUE_KEYS) {
+        OLAP_LOG_WARNING("point lookup needs a unique keys table. [table=%s]",
+                         _table->full_name().c_str());
+        return OLAP_ERR_INPUT_PARAMETER_ERROR;
+    }
+    if (key.field_count() != _table->num_key_fields()) {
+        OLAP_LOG_WARNING("point lookup needs all key columns. [table=%s key_num=%lu]",
+                         _table->full_name().c_str(), key.field_count());
+        return OLAP_ERR_INPUT_PARAMETER_ERROR;
+    }
+
+    std::vector<IData*> data_sources;
+    DeleteHandler delete_handler;
+    _table->obtain_header_rdlock();
+    _table->acquire_data_sources(version, &data_sources);
+    OLAPStatus res = delete_handler.init(_table, version.second);
+    _table->release_header_lock();
+
+    if (data_sources.empty()) {
+        OLAP_LOG_WARNING("fail to acquire data sources. [table=%s version=%d-%d]",
+                         _table->full_name().c_str(), version.first, version.second);
+        delete_handler.finalize();
+        return OLAP_ERR_VERSION_NOT_EXIST;
+    }
+
+    // the versions of a span do not overlap, newest first
+    std::sort(data_sources.begin(), data_sources.end(),
+              [](IData* left, IData* right) {
+                  return left->version().second > right->version().second;
+              });
+
+    std::vector<uint32_t> return_columns;
+    for (uint32_t i = 0; i < _table->tablet_schema().size(); ++i) {
+        return_columns.push_back(i);
+    }
+    Conditions conditions;
+    std::vector<ColumnPredicate*> col_predicates;
+    std::vector<RowCursor*> keys;
+    uint64_t key_hash = key.key_hash_code();
+
+    for (auto i_data : data_sources) {
+        if (res != OLAP_SUCCESS) {
+            break;
+        }
+        if (i_data->empty()) {
+            continue;
+        }
+        if (i_data->data_file_type() != COLUMN_ORIENTED_FILE) {
+            OLAP_LOG_WARNING("point lookup needs column oriented data. [table=%s version=%d-%d]",
+                             _table->full_name().c_str(),
+                             i_data->version().first, i_data->version().second);
+            res = OLAP_ERR_READER_READING_ERROR;
+            break;
+        }
+
+        column_file::ColumnData* column_data = static_cast<column_file::ColumnData*>(i_data);
+        column_data->set_stats(&_stats);
+        column_data->set_delete_handler(delete_handler);
+        column_data->set_read_params(return_columns, std::set<uint32_t>(),
+                                     conditions, col_predicates, keys, keys,
+                                     true, nullptr);
+
+        const RowCursor* current = nullptr;
+        res = column_data->lookup_row(key, key_hash, &current);
+        if (res == OLAP_ERR_DATA_EOF) {
+            res = OLAP_SUCCESS;
+            continue;
+        } else if (res != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("fail to lookup row. [table=%s version=%d-%d res=%d]",
+                             _table->full_name().c_str(),
+                             i_data->version().first, i_data->version().second, res);
+            break;
+        }
+
+        if (delete_handler.is_filter_data(i_data->version().second, *current)) {
+            _stats.rows_del_filtered++;
+            continue;
+        }
+
+        res = row->copy(*current, mem_pool);
+        if (res == OLAP_SUCCESS) {
+            *found = true;
+        }
+        break;
+    }
+
+    delete_handler.finalize();
+    _table->release_data_sources(&data_sources);
+    return res;
+}
+
+}  // namespace palo
@@ -0,0 +1,63 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_OLAP_POINT_READER_H
+#define BDG_PALO_BE_SRC_OLAP_POINT_READER_H
+
+#include "olap/olap_common.h"
+#include "olap/olap_define.h"
+#include "olap/olap_table.h"
+
+namespace palo {
+
+class MemPool;
+class RowCursor;
+
+// Reads one row of a UNIQUE_KEYS table by its full key, without the merge
+// of Reader.
+//
+// The versions are searched from the newest to the oldest, and the search
+// stops at the first version that has the key, as in a UNIQUE_KEYS table the
+// newest row of a key replaces the older ones. In each version the segments
+// are pruned with their key bloom filter before any data block is read.
+// A row filtered by a delete condition lets the older versions show through,
+// the same as the merge of Reader does.
+class PointReader {
+public:
+    explicit PointReader(SmartOLAPTable table) : _table(table) {}
+    ~PointReader() {}
+
+    // Finds the row whose key columns equal 'key' in 'version'. 'key' must
+    // hold all key columns of the table, e.g. a cursor from init_scan_key().
+    // On success '*found' tells whether the row exists; if it does, it is
+    // copied to 'row', which is initialized with the table schema, and its
+    // strings are allocated from 'mem_pool'.
+    OLAPStatus lookup(const Version& version, const RowCursor& key,
+                      RowCursor* row, MemPool* mem_pool, bool* found);
+
+    const OlapReaderStatistics& stats() const {
+        return _stats;
+    }
+
+private:
+    SmartOLAPTable _table;
+    OlapReaderStatistics _stats;
+
+    DISALLOW_COPY_AND_ASSIGN(PointReader);
+};
+
+}  // namespace palo
+
+#endif // BDG_PALO_BE_SRC_OLAP_POINT_READER_H
@@ -21,6 +21,7 @@
 
 #include <boost/filesystem.hpp>
 
+#include "olap/memtable.h"
 #include "olap/olap_engine.h"
 #include "olap/olap_table.h"
 #include "olap/schema_change.h"
@@ -195,6 +196,7 @@ OLAPStatus PushHandler::process(
     if (push_type == PUSH_FOR_DELETE) {
         _obtain_header_wrlock();
         DeleteConditionHandler del_cond_handler;
+        vector<SmartOLAPTable> tables_to_save;
 
         for (TableVars& table_var : table_infoes) {
             if (table_var.olap_table.get() == NULL) {
@@ -208,13 +210,15 @@ OLAPStatus PushHandler::process(
                                  res, table_var.olap_table->full_name().c_str());
                 goto EXIT;
             }
+            tables_to_save.push_back(table_var.olap_table);
+        }
 
-            res = table_var.olap_table->save_header();
-            if (res != OLAP_SUCCESS) {
-                OLAP_LOG_WARNING("fail to save header. [res=%d table='%s']",
-                                 res, table_var.olap_table->full_name().c_str());
-                goto EXIT;
-            }
+        // 各表的删除条件一起存入OLAPMeta
+        res = OLAPEngine::get_instance()->save_headers(tables_to_save);
+        if (res != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("fail to save headers. [res=%d table='%s']",
+                             res, olap_table->full_name().c_str());
+            goto EXIT;
         }
 
         _release_header_lock();
@@ -406,7 +410,6 @@ OLAPStatus PushHandler::_convert(
             break;
         }
 
-        MemPool* mem_pool = writer->mem_pool();
         // 4. Init RowCursor
         if (OLAP_SUCCESS != (res = row.init(curr_olap_table->tablet_schema()))) {
             OLAP_LOG_WARNING("fail to init rowcursor. [res=%d]", res);
@@ -426,7 +429,8 @@ OLAPStatus PushHandler::_convert(
                     break;
                 }
 
-                res = reader->next(&row, mem_pool);
+                // a push writer switches row blocks, and their mem pools, in attached_by()
+                res = reader->next(&row, writer->mem_pool());
                 if (OLAP_SUCCESS != res) {
                     OLAP_LOG_WARNING("read next row failed. [res=%d read_rows=%u]",
                                      res, num_rows);
@@ -444,6 +448,16 @@ OLAPStatus PushHandler::_convert(
                 res = OLAP_ERR_PUSH_BUILD_DELTA_ERROR;
                 break;
             }
+        } else if (_mem_table != NULL) {
+            // rows are already sorted in memory
+            OLAP_LOG_DEBUG("start to flush memtable to delta.");
+
+            if (OLAP_SUCCESS != (res = _mem_table->flush(writer))) {
+                OLAP_LOG_WARNING("fail to flush memtable. [res=%d table='%s']",
+                                 res, curr_olap_table->full_name().c_str());
+                break;
+            }
+            num_rows = _mem_table->num_rows();
         }
 
         if (OLAP_SUCCESS != (res = writer->finalize())) {
@@ -37,6 +37,7 @@ typedef std::vector<OLAPIndex*> Indices;
 class BinaryFile;
 class BinaryReader;
 class ColumnMapping;
+class MemTable;
 class RowCursor;
 
 struct TableVars {
@@ -59,6 +60,11 @@ public:
             const TPushReq& request,
             PushType push_type,
             std::vector<TTabletInfo>* tablet_info_vec);
+
+    // Push the rows of 'mem_table' as the delta of the request, which has no file.
+    // The caller keeps the ownership of 'mem_table'.
+    void set_mem_table(MemTable* mem_table) { _mem_table = mem_table; }
+
     int64_t write_bytes() const { return _write_bytes; }
     int64_t write_rows() const { return _write_rows; }
 private:
@@ -159,6 +165,8 @@ private:
 
     int64_t _write_bytes = 0;
     int64_t _write_rows = 0;
+    // rows to push instead of the file of the request, if not null
+    MemTable* _mem_table = NULL;
     DISALLOW_COPY_AND_ASSIGN(PushHandler);
 };
 
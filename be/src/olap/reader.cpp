@@ -45,7 +45,7 @@ public:
 
     OLAPStatus add_child(IData* data, RowBlock* block);
 
-    // Get top row of the heap, NULL if reach end.
+    // Get the smallest row of the children, NULL if reach end.
     const RowCursor* current_row(bool* delete_flag) const {
         if (_cur_child != nullptr) {
             return _cur_child->current_row(delete_flag);
@@ -53,8 +53,7 @@ public:
         return nullptr;
     }
 
-    // Pop the top element and rebuild the heap to 
-    // get the next row cursor.
+    // Advance the child of the current row and get the next row cursor.
     inline OLAPStatus next(const RowCursor** row, bool* delete_flag);
 
     // Clear the MergeSet element and reset state.
@@ -159,6 +158,9 @@ private:
     // If _merge is true, result row must be ordered
     bool _merge = true;
 
+    // When _merge is true, the children other than _cur_child. _cur_child is kept out of
+    // the heap, so that a run of rows of one child, which is common as deltas mostly
+    // cover distinct keys, is read without touching the heap.
     typedef std::priority_queue<ChildCtx*, std::vector<ChildCtx*>, ChildCtxComparator> MergeHeap;
     MergeHeap _heap;
 
@@ -204,8 +206,14 @@ OLAPStatus CollectIterator::add_child(IData* data, RowBlock* block) {
     ChildCtx* child_ptr = child.release();
     _children.push_back(child_ptr);
     if (_merge) {
-        _heap.push(child_ptr);
-        _cur_child = _heap.top();
+        if (_cur_child == nullptr) {
+            _cur_child = child_ptr;
+        } else if (ChildCtxComparator()(_cur_child, child_ptr)) {
+            _heap.push(_cur_child);
+            _cur_child = child_ptr;
+        } else {
+            _heap.push(child_ptr);
+        }
     } else {
         if (_cur_child == nullptr) {
             _cur_child = _children[_child_idx];
@@ -224,15 +232,20 @@ inline OLAPStatus CollectIterator::next(const RowCursor** row, bool* delete_flag
 }
 
 inline OLAPStatus CollectIterator::_merge_next(const RowCursor** row, bool* delete_flag) {
-    _heap.pop();
     auto res = _cur_child->next(row, delete_flag);
     if (res == OLAP_SUCCESS) {
-        _heap.push(_cur_child);
-        _cur_child = _heap.top();
+        // only go through the heap when another child has a smaller row
+        if (!_heap.empty() && ChildCtxComparator()(_cur_child, _heap.top())) {
+            ChildCtx* next_child = _heap.top();
+            _heap.pop();
+            _heap.push(_cur_child);
+            _cur_child = next_child;
+        }
     } else if (res == OLAP_ERR_DATA_EOF) {
         _reader->_stats.rows_del_filtered += _cur_child->num_filtered_rows();
         if (_heap.size() > 0) {
             _cur_child = _heap.top();
+            _heap.pop();
         } else {
             _cur_child = nullptr;
             return OLAP_ERR_DATA_EOF;
@@ -294,6 +307,8 @@ void CollectIterator::clear() {
 
 Reader::Reader()
         : _next_key_index(0),
+        _merge_start_key(NULL),
+        _merge_end_key(NULL),
         _aggregation(false),
         _version_locked(false),
         _reader_type(READER_FETCH),
@@ -402,7 +417,11 @@ OLAPStatus Reader::_agg_key_next_row(RowCursor* row_cursor, bool* eof) {
             break;
         }
         // break while can NOT doing aggregation
-        if (!RowCursor::equal(_key_cids, row_cursor, _next_key)) {
+        if (!RowCursor::key_equal(_key_cids, row_cursor, _next_key)) {
+            break;
+        }
+        // a full sketch column, the rows left of the key go to the next row
+        if (!RowCursor::can_aggregate(_value_cids, row_cursor, _next_key)) {
             break;
         }
 
@@ -410,8 +429,7 @@ OLAPStatus Reader::_agg_key_next_row(RowCursor* row_cursor, bool* eof) {
         ++merged_count;
     } while (true);
     _merged_rows += merged_count;
-    row_cursor->finalize_one_merge(_value_cids);
-    return OLAP_SUCCESS;
+    return row_cursor->finalize_one_merge(_value_cids);
 }
 
 OLAPStatus Reader::_unique_key_next_row(RowCursor* row_cursor, bool* eof) {
@@ -447,12 +465,18 @@ OLAPStatus Reader::_unique_key_next_row(RowCursor* row_cursor, bool* eof) {
             //   2. to make cost of  each scan round reasonable, we will control merged_count.
             if (_olap_table->keys_type() == KeysType::DUP_KEYS
                 || (_aggregation && merged_count > config::palo_scanner_row_num)) {
-                row_cursor->finalize_one_merge(_value_cids);
+                res = row_cursor->finalize_one_merge(_value_cids);
+                if (res != OLAP_SUCCESS) {
+                    return res;
+                }
                 break;
             }
             // break while can NOT doing aggregation
-            if (!RowCursor::equal(_key_cids, row_cursor, _next_key)) {
-                row_cursor->finalize_one_merge(_value_cids);
+            if (!RowCursor::key_equal(_key_cids, row_cursor, _next_key)) {
+                res = row_cursor->finalize_one_merge(_value_cids);
+                if (res != OLAP_SUCCESS) {
+                    return res;
+                }
                 break;
             }
 
@@ -561,6 +585,8 @@ OLAPStatus Reader::_init_params(const ReaderParams& read_params) {
     _reader_type = read_params.reader_type;
     _olap_table = read_params.olap_table;
     _version = read_params.version;
+    _merge_start_key = read_params.merge_start_key;
+    _merge_end_key = read_params.merge_end_key;
     
     res = _init_conditions_param(read_params);
     if (res != OLAP_SUCCESS) {
@@ -655,8 +681,8 @@ OLAPStatus Reader::_attach_data_to_merge_set(bool first, bool *eof) {
     *eof = false;
 
     do {
-        RowCursor *start_key = NULL;
-        RowCursor *end_key = NULL;
+        const RowCursor *start_key = NULL;
+        const RowCursor *end_key = NULL;
         bool find_last_row = false;
         bool end_key_find_last_row = false;
         _collect_iter->clear();
@@ -723,6 +749,10 @@ OLAPStatus Reader::_attach_data_to_merge_set(bool first, bool *eof) {
         } else if (false == first) {
             *eof = true;
             return res;
+        } else {
+            // a compaction merging one key range reads [start, end)
+            start_key = _merge_start_key;
+            end_key = _merge_end_key;
         }
 
         for (auto data : _data_sources) {
@@ -58,12 +58,18 @@ struct ReaderParams {
     // The IData will be set when using Merger, eg Cumulative, BE.
     std::vector<IData*> olap_data_arr;
     std::vector<uint32_t> return_columns;
+    // Limits a compaction reader to the rows whose short key is in
+    // [merge_start_key, merge_end_key). NULL leaves that side open.
+    const RowCursor* merge_start_key;
+    const RowCursor* merge_end_key;
     RuntimeProfile* profile;
     RuntimeState* runtime_state;
 
     ReaderParams() :
             reader_type(READER_FETCH),
             aggregation(true),
+            merge_start_key(NULL),
+            merge_end_key(NULL),
             profile(NULL),
             runtime_state(NULL) {
         start_key.clear();
@@ -205,6 +211,8 @@ private:
 
     KeysParam _keys_param;
     int32_t _next_key_index;
+    const RowCursor* _merge_start_key;
+    const RowCursor* _merge_end_key;
 
     Conditions _conditions;
     std::vector<ColumnPredicate*> _col_predicates;
@@ -107,6 +107,23 @@ OLAPStatus RowCursor::_init(const std::vector<FieldInfo>& tablet_schema,
         offset += field_buf_lens[cid] + 1;
     }
 
+    // identical bytes mean equal values for fixed length keys except the
+    // floating ones, string keys only hold a pointer so are left out
+    size_t key_prefix_len = 0;
+    for (size_t i = 0; i < _key_column_num; ++i) {
+        FieldType type = tablet_schema[i].type;
+        if (i >= _columns.size() || _columns[i] != i
+                || type == OLAP_FIELD_TYPE_CHAR || type == OLAP_FIELD_TYPE_VARCHAR
+                || type == OLAP_FIELD_TYPE_HLL || type == OLAP_FIELD_TYPE_FLOAT
+                || type == OLAP_FIELD_TYPE_DOUBLE
+                || type == OLAP_FIELD_TYPE_DISCRETE_DOUBLE) {
+            key_prefix_len = 0;
+            break;
+        }
+        key_prefix_len = _field_offsets[i] + field_buf_lens[i] + 1;
+    }
+    _key_prefix_len = key_prefix_len;
+
     return OLAP_SUCCESS;
 }
 
@@ -329,14 +346,31 @@ bool RowCursor::equal(const RowCursor& other) const {
     return true;
 }
 
-void RowCursor::finalize_one_merge() {
+OLAPStatus RowCursor::finalize_one_merge() {
     for (size_t i = _key_column_num; i < _field_array.size(); ++i) {
         if (_field_array[i] == NULL) {
             continue;
         }
         char* dest = _field_array[i]->get_ptr(_fixed_buf);
-        _field_array[i]->finalize(dest);
+        OLAPStatus res = _field_array[i]->finalize(dest);
+        if (res != OLAP_SUCCESS) {
+            return res;
+        }
+    }
+    return OLAP_SUCCESS;
+}
+
+bool RowCursor::can_aggregate(const RowCursor& other) const {
+    for (size_t i = _key_column_num; i < _field_array.size(); ++i) {
+        if (_field_array[i] == NULL || other._field_array[i] == NULL) {
+            continue;
+        }
+        char* src = other._field_array[i]->get_field_ptr(other.get_buf());
+        if (!_field_array[i]->can_aggregate(src)) {
+            return false;
+        }
     }
+    return true;
 }
 
 void RowCursor::aggregate(const RowCursor& other) {
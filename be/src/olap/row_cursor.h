@@ -16,6 +16,8 @@
 #ifndef BDG_PALO_BE_SRC_OLAP_ROW_CURSOR_H
 #define BDG_PALO_BE_SRC_OLAP_ROW_CURSOR_H
 
+#include <string.h>
+
 #include <string>
 #include <vector>
 
@@ -41,6 +43,30 @@ public:
         return true;
     }
 
+    // Same result as equal() over key columns 'ids', used to find the runs of
+    // rows to merge: rows whose key bytes are identical are equal without
+    // going through every field, only the others take the per field compare.
+    static inline bool key_equal(const std::vector<uint32_t>& ids,
+                                 const RowCursor* lhs, const RowCursor* rhs) {
+        size_t len = lhs->_key_prefix_len;
+        if (len != 0 && len == rhs->_key_prefix_len
+                && memcmp(lhs->_fixed_buf, rhs->_fixed_buf, len) == 0) {
+            return true;
+        }
+        return equal(ids, lhs, rhs);
+    }
+
+    // Whether 'rhs' can be aggregated into 'lhs'; see Field::can_aggregate().
+    static inline bool can_aggregate(const std::vector<uint32_t>& cids,
+                                     RowCursor* lhs, const RowCursor* rhs) {
+        for (auto cid : cids) {
+            if (!lhs->_field_array[cid]->can_aggregate(rhs->get_field_ptr(cid))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     static inline void aggregate(const std::vector<uint32_t>& cids,
                                  RowCursor* lhs, const RowCursor* rhs) {
         // 只有value column才会参与aggregate
@@ -93,11 +119,13 @@ public:
     bool equal(const RowCursor& other) const;
 
     // 两个RowCursor做累加，结果是this += other
+    bool can_aggregate(const RowCursor& other) const;
     void aggregate(const RowCursor& other);
 
-    // now only used by hll column, do aggregating
-    void finalize_one_merge();
-    inline void finalize_one_merge(const std::vector<uint32_t>& ids);
+    // now only used by hll and sketch columns, do aggregating; fails if a merged
+    // sketch does not fit in its column
+    OLAPStatus finalize_one_merge();
+    inline OLAPStatus finalize_one_merge(const std::vector<uint32_t>& ids);
 
     // RowCursor attach到一段连续的buf
     inline void attach(char* buf) { _fixed_buf = buf; }
@@ -122,11 +150,22 @@ public:
     // 要求输入字符串和row cursor有相同的列数，
     OLAPStatus from_string(const std::vector<std::string>& val_string_arr);
 
+    // 从字符串反序列化第index列的值，不修改null标记
+    OLAPStatus from_string(size_t index, const std::string& val_string) {
+        Field* field = _field_array[index];
+        return field->from_string(field->get_ptr(_fixed_buf), val_string);
+    }
+
     // 返回当前row cursor中列的个数
     size_t field_count() const {
         return _columns.size();
     }
 
+    // 返回schema中key列的个数, 不在cursor中的列对应的field为NULL
+    size_t key_column_num() const {
+        return _key_column_num;
+    }
+
     // 以string格式输出rowcursor内容，仅供log及debug使用
     std::string to_string() const;
     std::string to_string(std::string sep) const;
@@ -172,6 +211,10 @@ public:
     char* get_field_content_ptr(uint32_t cid) const { return _fixed_buf + _field_offsets[cid] + 1; }
 
     inline uint32_t hash_code(uint32_t seed) const;
+
+    // key列的64位hash, 用于UNIQUE_KEYS表的key bloom filter.
+    // 由两个不同seed的32位hash拼成, bloom filter需要高低两部分各自独立
+    inline uint64_t key_hash_code() const;
 private:
     // common init function
     OLAPStatus _init(const std::vector<FieldInfo>& tablet_schema,
@@ -181,6 +224,9 @@ private:
     std::vector<size_t> _field_offsets;  // field offset in _fixed_buf
 
     size_t _key_column_num;              // key num in row_cursor
+    // bytes at the head of _fixed_buf holding all the key columns, 0 when the
+    // keys are not all in the cursor or one of them can't be compared bytewise
+    size_t _key_prefix_len = 0;
 
     std::vector<uint32_t> _columns;      // column_id in schema
     char* _fixed_buf = nullptr;          // point to fixed buf
@@ -229,11 +275,15 @@ inline OLAPStatus RowCursor::agg_init(const RowCursor& other) {
     return OLAP_SUCCESS;
 }
 
-inline void RowCursor::finalize_one_merge(const std::vector<uint32_t>& ids) {
+inline OLAPStatus RowCursor::finalize_one_merge(const std::vector<uint32_t>& ids) {
     for (uint32_t id : ids) {
         char* dest = _field_array[id]->get_ptr(_fixed_buf);
-        _field_array[id]->finalize(dest);
+        OLAPStatus res = _field_array[id]->finalize(dest);
+        if (OLAP_UNLIKELY(res != OLAP_SUCCESS)) {
+            return res;
+        }
     }
+    return OLAP_SUCCESS;
 }
 
 inline uint32_t RowCursor::hash_code(uint32_t seed) const {
@@ -244,6 +294,17 @@ inline uint32_t RowCursor::hash_code(uint32_t seed) const {
     return seed;
 }
 
+inline uint64_t RowCursor::key_hash_code() const {
+    uint32_t low = 0;
+    uint32_t high = 0x9e3779b9;
+    for (size_t cid = 0; cid < _key_column_num; ++cid) {
+        char* dest = _field_array[cid]->get_field_ptr(_fixed_buf);
+        low = _field_array[cid]->hash_code(dest, low);
+        high = _field_array[cid]->hash_code(dest, high);
+    }
+    return (static_cast<uint64_t>(high) << 32) | low;
+}
+
 }  // namespace palo
 
 #endif // BDG_PALO_BE_SRC_OLAP_ROW_CURSOR_H
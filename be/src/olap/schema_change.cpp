@@ -579,14 +579,18 @@ bool RowBlockMerger::merge(
             continue;
         }
 
-        while (!_heap.empty() && row_cursor.full_key_cmp(*(_heap.top().row_cursor)) == 0) {
+        while (!_heap.empty() && row_cursor.full_key_cmp(*(_heap.top().row_cursor)) == 0
+                && row_cursor.can_aggregate(*(_heap.top().row_cursor))) {
             row_cursor.aggregate(*(_heap.top().row_cursor));
             ++tmp_merged_rows;
             if (!_pop_heap()) {
                 goto MERGE_ERR;
             }
         }
-        row_cursor.finalize_one_merge();
+        if (row_cursor.finalize_one_merge() != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("fail to merge rows.");
+            goto MERGE_ERR;
+        }
         writer->next(row_cursor);
     }
     if (writer->finalize() != OLAP_SUCCESS) {
@@ -1843,17 +1847,13 @@ OLAPStatus SchemaChangeHandler::_save_schema_change_info(
                                               alter_table_type);
 
     // save new olap table header :只有一个父ref table
-    res = new_olap_table->save_header();
-    if (res != OLAP_SUCCESS) {
-        OLAP_LOG_FATAL("fail to save new table header. [res=%d table='%s']",
-                       res, new_olap_table->full_name().c_str());
-        return res;
-    }
-
-    res = ref_olap_table->save_header();
+    // 两个表在同一根目录时, 两个表头原子地存入OLAPMeta
+    vector<SmartOLAPTable> tables = {new_olap_table, ref_olap_table};
+    res = OLAPEngine::get_instance()->save_headers(tables);
     if (res != OLAP_SUCCESS) {
-        OLAP_LOG_FATAL("fail to save ref table header. [res=%d table='%s']",
-                       res, ref_olap_table->full_name().c_str());
+        OLAP_LOG_FATAL("fail to save table headers. [res=%d new_table='%s' ref_table='%s']",
+                       res, new_olap_table->full_name().c_str(),
+                       ref_olap_table->full_name().c_str());
         return res;
     }
 
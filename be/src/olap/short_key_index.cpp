@@ -0,0 +1,299 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "olap/short_key_index.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "olap/field.h"
+#include "olap/row_cursor.h"
+
+namespace palo {
+
+const uint32_t ShortKeyIndex::LEAF_SIZE;
+const size_t ShortKeyIndex::MAX_KEY_LENGTH;
+
+// Length of the encoded value of a type, 0 if the type is not supported.
+static size_t encoded_value_length(FieldType type) {
+    switch (type) {
+    case OLAP_FIELD_TYPE_TINYINT:
+    case OLAP_FIELD_TYPE_UNSIGNED_TINYINT:
+        return 1;
+    case OLAP_FIELD_TYPE_SMALLINT:
+    case OLAP_FIELD_TYPE_UNSIGNED_SMALLINT:
+        return 2;
+    case OLAP_FIELD_TYPE_DATE:
+        return 3;
+    case OLAP_FIELD_TYPE_INT:
+    case OLAP_FIELD_TYPE_UNSIGNED_INT:
+        return 4;
+    case OLAP_FIELD_TYPE_BIGINT:
+    case OLAP_FIELD_TYPE_UNSIGNED_BIGINT:
+    case OLAP_FIELD_TYPE_DATETIME:
+        return 8;
+    case OLAP_FIELD_TYPE_DECIMAL:
+        return 12;
+    case OLAP_FIELD_TYPE_LARGEINT:
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+template<typename T>
+static inline void store_big_endian(char* dst, T value) {
+    for (int i = sizeof(T) - 1; i >= 0; --i) {
+        dst[i] = static_cast<char>(value & 0xFF);
+        value >>= 8;
+    }
+}
+
+template<typename U>
+static inline void encode_unsigned(const char* src, char* dst) {
+    U value;
+    memcpy(&value, src, sizeof(U));
+    store_big_endian(dst, value);
+}
+
+// flipping the sign bit orders negative values before positive ones
+template<typename T, typename U>
+static inline void encode_signed(const char* src, char* dst) {
+    T value;
+    memcpy(&value, src, sizeof(T));
+    U bits = static_cast<U>(value) ^ (static_cast<U>(1) << (sizeof(U) * 8 - 1));
+    store_big_endian(dst, bits);
+}
+
+// First 8 bytes of 'key' as a big endian integer, padded with zeros.
+static inline uint64_t load_prefix(const char* key, size_t length) {
+    size_t n = std::min(length, sizeof(uint64_t));
+    uint64_t prefix = 0;
+    for (size_t i = 0; i < n; ++i) {
+        prefix = (prefix << 8) | static_cast<uint8_t>(key[i]);
+    }
+    return n == 0 ? 0 : prefix << (8 * (sizeof(uint64_t) - n));
+}
+
+// Number of leading 'prefixes' whose masked value is less than (or not greater than,
+// if INCLUSIVE) 'value'. The loop has no data dependent branch, the comparison
+// compiles to a conditional move.
+template<bool INCLUSIVE>
+static inline uint32_t count_before(const uint64_t* prefixes, uint32_t n,
+                                    uint64_t mask, uint64_t value) {
+    if (n == 0) {
+        return 0;
+    }
+    const uint64_t* base = prefixes;
+    while (n > 1) {
+        uint32_t half = n / 2;
+        uint64_t probe = base[half] & mask;
+        base = (INCLUSIVE ? probe <= value : probe < value) ? base + half : base;
+        n -= half;
+    }
+    uint64_t probe = *base & mask;
+    return (base - prefixes) + (INCLUSIVE ? probe <= value : probe < value);
+}
+
+bool ShortKeyIndex::is_supported(const std::vector<FieldInfo>& fields, size_t num_fields) {
+    if (num_fields == 0 || num_fields > fields.size()) {
+        return false;
+    }
+    size_t key_length = 0;
+    for (size_t i = 0; i < num_fields; ++i) {
+        size_t length = encoded_value_length(fields[i].type);
+        if (length == 0 || length != fields[i].index_length) {
+            return false;
+        }
+        key_length += 1 + length;
+    }
+    return key_length <= MAX_KEY_LENGTH;
+}
+
+ShortKeyIndex::ShortKeyIndex(const std::vector<FieldInfo>& fields, size_t num_fields) :
+        _key_length(0),
+        _num_entries(0) {
+    for (size_t i = 0; i < num_fields; ++i) {
+        EncodedField field;
+        field.type = fields[i].type;
+        field.entry_offset = _key_length;
+        field.length = fields[i].index_length;
+        _fields.push_back(field);
+        // 非字符串类型的索引项格式为 null byte|value
+        _key_length += 1 + field.length;
+    }
+}
+
+void ShortKeyIndex::_encode_field(const EncodedField& field, const char* src, char* dst) const {
+    if (*reinterpret_cast<const bool*>(src)) {
+        memset(dst, 0, 1 + field.length);
+        return;
+    }
+    dst[0] = 1;
+    const char* value = src + 1;
+    char* value_dst = dst + 1;
+    switch (field.type) {
+    case OLAP_FIELD_TYPE_TINYINT:
+        encode_signed<int8_t, uint8_t>(value, value_dst);
+        break;
+    case OLAP_FIELD_TYPE_UNSIGNED_TINYINT:
+        encode_unsigned<uint8_t>(value, value_dst);
+        break;
+    case OLAP_FIELD_TYPE_SMALLINT:
+        encode_signed<int16_t, uint16_t>(value, value_dst);
+        break;
+    case OLAP_FIELD_TYPE_UNSIGNED_SMALLINT:
+        encode_unsigned<uint16_t>(value, value_dst);
+        break;
+    case OLAP_FIELD_TYPE_INT:
+        encode_signed<int32_t, uint32_t>(value, value_dst);
+        break;
+    case OLAP_FIELD_TYPE_UNSIGNED_INT:
+        encode_unsigned<uint32_t>(value, value_dst);
+        break;
+    case OLAP_FIELD_TYPE_BIGINT:
+    case OLAP_FIELD_TYPE_DATETIME:
+        encode_signed<int64_t, uint64_t>(value, value_dst);
+        break;
+    case OLAP_FIELD_TYPE_UNSIGNED_BIGINT:
+        encode_unsigned<uint64_t>(value, value_dst);
+        break;
+    case OLAP_FIELD_TYPE_LARGEINT:
+        encode_signed<int128_t, uint128_t>(value, value_dst);
+        break;
+    case OLAP_FIELD_TYPE_DATE:
+        // uint24_t is stored little endian
+        value_dst[0] = value[2];
+        value_dst[1] = value[1];
+        value_dst[2] = value[0];
+        break;
+    case OLAP_FIELD_TYPE_DECIMAL:
+        // decimal12_t compares its integer part, then its fraction
+        encode_signed<int64_t, uint64_t>(value, value_dst);
+        encode_signed<int32_t, uint32_t>(value + sizeof(int64_t), value_dst + sizeof(int64_t));
+        break;
+    default:
+        break;
+    }
+}
+
+void ShortKeyIndex::add_entry(const char* entry) {
+    char key[MAX_KEY_LENGTH];
+    for (const EncodedField& field : _fields) {
+        _encode_field(field, entry + field.entry_offset, key + field.entry_offset);
+    }
+
+    if (_num_entries % LEAF_SIZE == 0) {
+        _prefixes.push_back(load_prefix(key, _key_length));
+        _heads.append(key, _key_length);
+        _leaf_offsets.push_back(_leaf_data.size());
+    } else {
+        size_t shared = 0;
+        while (shared < _key_length && _last_key[shared] == key[shared]) {
+            ++shared;
+        }
+        _leaf_data.push_back(static_cast<char>(shared));
+        _leaf_data.append(key + shared, _key_length - shared);
+    }
+    _last_key.assign(key, _key_length);
+    ++_num_entries;
+}
+
+void ShortKeyIndex::finish() {
+    _leaf_offsets.push_back(_leaf_data.size());
+    _prefixes.shrink_to_fit();
+    _heads.shrink_to_fit();
+    _leaf_offsets.shrink_to_fit();
+    _leaf_data.shrink_to_fit();
+    std::string().swap(_last_key);
+}
+
+int ShortKeyIndex::encode_key(const RowCursor& key, char* dst) const {
+    size_t num_fields = std::min(_fields.size(), key.key_column_num());
+    size_t length = 0;
+    bool key_end = false;
+    for (size_t i = 0; i < num_fields; ++i) {
+        const Field* field = key.get_field_by_index(i);
+        // index_cmp()跳过key中不存在的列, 只有缺少的是末尾的列时才能按前缀比较
+        if (field == NULL) {
+            key_end = true;
+            continue;
+        }
+        if (key_end) {
+            return -1;
+        }
+        _encode_field(_fields[i], field->get_field_ptr(key.get_buf()), dst + length);
+        length += 1 + _fields[i].length;
+    }
+    return length;
+}
+
+uint32_t ShortKeyIndex::_find_leaf(const char* key, size_t length, bool find_last) const {
+    size_t prefix_length = std::min(length, sizeof(uint64_t));
+    uint64_t mask = ~0UL << (8 * (sizeof(uint64_t) - prefix_length));
+    uint64_t prefix = load_prefix(key, length);
+
+    uint32_t num_leaves = _prefixes.size();
+    uint32_t low = count_before<false>(&_prefixes[0], num_leaves, mask, prefix);
+    uint32_t high = count_before<true>(&_prefixes[0], num_leaves, mask, prefix);
+    if (length <= sizeof(uint64_t)) {
+        return find_last ? high : low;
+    }
+
+    // the first keys of the leaves in [low, high) share their first 8 bytes with 'key'
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        int res = memcmp(&_heads[mid * _key_length], key, length);
+        if (res < 0 || (find_last && res == 0)) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+uint32_t ShortKeyIndex::find(const char* key, size_t length, bool find_last) const {
+    if (_num_entries == 0 || length == 0) {
+        return find_last ? _num_entries : 0;
+    }
+
+    uint32_t leaf = _find_leaf(key, length, find_last);
+    if (leaf == 0) {
+        return 0;
+    }
+    // the first key of the previous leaf is before 'key', the result is one of its
+    // other keys or the first key of the next leaf
+    --leaf;
+    uint32_t pos = leaf * LEAF_SIZE + 1;
+    char current[MAX_KEY_LENGTH];
+    memcpy(current, &_heads[leaf * _key_length], _key_length);
+    const char* data = _leaf_data.data() + _leaf_offsets[leaf];
+    const char* end = _leaf_data.data() + _leaf_offsets[leaf + 1];
+    while (data < end) {
+        size_t shared = static_cast<uint8_t>(*data++);
+        memcpy(current + shared, data, _key_length - shared);
+        data += _key_length - shared;
+        int res = memcmp(current, key, length);
+        if (res > 0 || (!find_last && res == 0)) {
+            return pos;
+        }
+        ++pos;
+    }
+    return pos;
+}
+
+}  // namespace palo
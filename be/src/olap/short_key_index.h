@@ -0,0 +1,119 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_OLAP_SHORT_KEY_INDEX_H
+#define BDG_PALO_BE_SRC_OLAP_SHORT_KEY_INDEX_H
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "olap/field_info.h"
+#include "olap/olap_define.h"
+
+namespace palo {
+
+class RowCursor;
+
+// Short keys of the entries of a MemIndex, encoded so that memcmp() orders them as
+// RowCursor::index_cmp() does, for lookups that do not compare field by field.
+//
+// The entries are cut into leaves of LEAF_SIZE entries. The upper level keeps, per
+// leaf, the first 8 encoded bytes of its first key as a big endian integer, so that
+// a lookup first runs a branchless binary search over a small array of integers,
+// which stays in L1/L2, and only compares full keys when those bytes tie. Inside a
+// leaf each key only stores the bytes that differ from the previous key.
+//
+// Encoding of a field: one byte, 0 if the value is NULL and 1 otherwise, then the
+// value in big endian, with the sign bit flipped for signed types; a NULL value is
+// encoded as zeros. Only fixed length types are supported, see is_supported().
+class ShortKeyIndex {
+public:
+    static const uint32_t LEAF_SIZE = 16;
+    static const size_t MAX_KEY_LENGTH = 255;
+
+    // Returns whether the first 'num_fields' fields of 'fields' can be encoded.
+    static bool is_supported(const std::vector<FieldInfo>& fields, size_t num_fields);
+
+    ShortKeyIndex(const std::vector<FieldInfo>& fields, size_t num_fields);
+
+    // Appends an in-memory index entry, as in SegmentMetaInfo::buffer. Entries are
+    // added in key order.
+    void add_entry(const char* entry);
+
+    // Must be called after the last add_entry() and before any lookup.
+    void finish();
+
+    // Encodes the short key fields of 'key' into 'dst', which has room for
+    // key_length() bytes, and returns the number of bytes written. Like
+    // RowCursor::index_cmp(), only the leading key fields present in 'key' are
+    // encoded. Returns -1 if 'key' can not be encoded.
+    int encode_key(const RowCursor& key, char* dst) const;
+
+    // Returns the number of entries whose key is less than (find_last is false) or
+    // not greater than (find_last is true) the encoded 'key', comparing the first
+    // 'length' bytes of the keys.
+    uint32_t find(const char* key, size_t length, bool find_last) const;
+
+    // Length of the encoding of all short key fields.
+    size_t key_length() const {
+        return _key_length;
+    }
+
+    uint32_t count() const {
+        return _num_entries;
+    }
+
+    size_t memory_bytes() const {
+        return _prefixes.capacity() * sizeof(uint64_t) + _heads.capacity()
+                + _leaf_offsets.capacity() * sizeof(uint32_t) + _leaf_data.capacity();
+    }
+
+private:
+    struct EncodedField {
+        FieldType type;
+        // offset of the field in an in-memory index entry
+        size_t entry_offset;
+        size_t length;
+    };
+
+    void _encode_field(const EncodedField& field, const char* src, char* dst) const;
+
+    // Index of the first leaf whose first key is not less than (find_last is false) or
+    // greater than (find_last is true) 'key'.
+    uint32_t _find_leaf(const char* key, size_t length, bool find_last) const;
+
+    std::vector<EncodedField> _fields;
+    size_t _key_length;
+    uint32_t _num_entries;
+
+    // first 8 bytes of the first key of each leaf
+    std::vector<uint64_t> _prefixes;
+    // first key of each leaf
+    std::string _heads;
+    // offset in _leaf_data of the keys following the first key of each leaf
+    std::vector<uint32_t> _leaf_offsets;
+    // per key: one byte of the length shared with the previous key, then the rest
+    std::string _leaf_data;
+    // last key added, to prefix compress the next one
+    std::string _last_key;
+
+    DISALLOW_COPY_AND_ASSIGN(ShortKeyIndex);
+};
+
+}  // namespace palo
+
+#endif // BDG_PALO_BE_SRC_OLAP_SHORT_KEY_INDEX_H
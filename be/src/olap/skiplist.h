@@ -0,0 +1,163 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_OLAP_SKIPLIST_H
+#define BDG_PALO_BE_SRC_OLAP_SKIPLIST_H
+
+#include <stdlib.h>
+
+#include <new>
+
+#include "olap/olap_define.h"
+#include "runtime/mem_pool.h"
+
+namespace palo {
+
+// Sorted list of keys in the nodes of a skip list, allocated from a MemPool and
+// freed with it. Keys with equal values are kept in the order they are inserted.
+//
+// Comparator is a functor, cmp(a, b) returns <0, 0 or >0 like memcmp.
+// Not thread safe.
+template<typename Key, class Comparator>
+class SkipList {
+private:
+    struct Node;
+
+public:
+    SkipList(Comparator cmp, MemPool* mem_pool) :
+            _cmp(cmp),
+            _mem_pool(mem_pool),
+            _head(_new_node(Key(), MAX_HEIGHT)),
+            _height(1),
+            _size(0),
+            _seed(0xdeadbeef) {
+        for (int i = 0; i < MAX_HEIGHT; ++i) {
+            _head->next[i] = nullptr;
+        }
+    }
+
+    // Returns the first key equal to 'key' in 'found', if there is one.
+    bool find(const Key& key, Key* found) const {
+        Node* node = _find_greater_or_equal(key);
+        if (node != nullptr && _cmp(node->key, key) == 0) {
+            *found = node->key;
+            return true;
+        }
+        return false;
+    }
+
+    // Inserts 'key' after the keys equal to it.
+    void insert(const Key& key) {
+        Node* prev[MAX_HEIGHT];
+        _find_greater(key, prev);
+
+        int height = _random_height();
+        if (height > _height) {
+            for (int i = _height; i < height; ++i) {
+                prev[i] = _head;
+            }
+            _height = height;
+        }
+
+        Node* node = _new_node(key, height);
+        for (int i = 0; i < height; ++i) {
+            node->next[i] = prev[i]->next[i];
+            prev[i]->next[i] = node;
+        }
+        ++_size;
+    }
+
+    size_t size() const { return _size; }
+
+    class Iterator {
+    public:
+        explicit Iterator(const SkipList* list) : _list(list), _node(nullptr) {}
+
+        bool valid() const { return _node != nullptr; }
+        const Key& key() const { return _node->key; }
+        void next() { _node = _node->next[0]; }
+        void seek_to_first() { _node = _list->_head->next[0]; }
+
+    private:
+        const SkipList* _list;
+        Node* _node;
+    };
+
+private:
+    static const int MAX_HEIGHT = 12;
+    // one node in BRANCHING of a level is also in the level above
+    static const uint32_t BRANCHING = 4;
+
+    struct Node {
+        Key key;
+        // next node in each level, as many as the height of the node
+        Node* next[1];
+    };
+
+    Node* _new_node(const Key& key, int height) {
+        uint8_t* mem = _mem_pool->allocate(sizeof(Node) + sizeof(Node*) * (height - 1));
+        Node* node = reinterpret_cast<Node*>(mem);
+        new (&node->key) Key(key);
+        return node;
+    }
+
+    int _random_height() {
+        int height = 1;
+        while (height < MAX_HEIGHT && rand_r(&_seed) % BRANCHING == 0) {
+            ++height;
+        }
+        return height;
+    }
+
+    // Returns the first node not less than 'key'.
+    Node* _find_greater_or_equal(const Key& key) const {
+        Node* node = _head;
+        Node* next = nullptr;
+        for (int level = _height - 1; level >= 0; --level) {
+            next = node->next[level];
+            while (next != nullptr && _cmp(next->key, key) < 0) {
+                node = next;
+                next = node->next[level];
+            }
+        }
+        return next;
+    }
+
+    // Fills 'prev' with the last node of each level not greater than 'key'.
+    void _find_greater(const Key& key, Node** prev) const {
+        Node* node = _head;
+        for (int level = _height - 1; level >= 0; --level) {
+            Node* next = node->next[level];
+            while (next != nullptr && _cmp(next->key, key) <= 0) {
+                node = next;
+                next = node->next[level];
+            }
+            prev[level] = node;
+        }
+    }
+
+    Comparator const _cmp;
+    MemPool* _mem_pool;
+    Node* const _head;
+    int _height;
+    size_t _size;
+    unsigned int _seed;
+
+    DISALLOW_COPY_AND_ASSIGN(SkipList);
+};
+
+}  // namespace palo
+
+#endif // BDG_PALO_BE_SRC_OLAP_SKIPLIST_H
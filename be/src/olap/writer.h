@@ -65,6 +65,11 @@ public:
     }
     virtual OLAPStatus attached_by(RowCursor* row_cursor) = 0;
     void next(const RowCursor& row_cursor) {
+        update_column_statistics(row_cursor);
+        ++_row_index;
+    }
+    // Accounts a row written through write_row_block() in the min and max key values.
+    void update_column_statistics(const RowCursor& row_cursor) {
         for (size_t i = 0; i < _table->num_key_fields(); ++i) {
             char* right = row_cursor.get_field_by_index(i)->get_field_ptr(row_cursor.get_buf());
             if (_column_statistics[i].first->cmp(right) > 0) {
@@ -75,8 +80,6 @@ public:
                 _column_statistics[i].second->copy(right);
             }
         }
-
-        ++_row_index;
     }
     virtual OLAPStatus finalize() = 0;
     virtual OLAPStatus write_row_block(RowBlock* row_block) = 0;
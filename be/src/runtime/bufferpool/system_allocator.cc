@@ -25,6 +25,7 @@
 #include <gperftools/malloc_extension.h>
 
 #include "gutil/strings/substitute.h"
+#include "runtime/chunk_allocator.h"
 #include "util/bit_util.h"
 
 #include "common/names.h"
@@ -45,7 +46,6 @@ namespace palo {
 
 /// These are the page sizes on x86-64. We could parse /proc/meminfo to programmatically
 /// get this, but it is unlikely to change unless we port to a different architecture.
-static int64_t SMALL_PAGE_SIZE = 4LL * 1024;
 static int64_t HUGE_PAGE_SIZE = 2LL * 1024 * 1024;
 
 SystemAllocator::SystemAllocator(int64_t min_buffer_len)
@@ -65,13 +65,20 @@ Status SystemAllocator::Allocate(int64_t len, BufferPool::BufferHandle* buffer)
   DCHECK_LE(len, BufferPool::MAX_BUFFER_BYTES);
   DCHECK(BitUtil::IsPowerOf2(len)) << len;
 
-  uint8_t* buffer_mem;
   if (config::FLAGS_mmap_buffers) {
+    uint8_t* buffer_mem;
     RETURN_IF_ERROR(AllocateViaMMap(len, &buffer_mem));
+    buffer->Open(buffer_mem, len, CpuInfo::get_current_core());
   } else {
-    RETURN_IF_ERROR(AllocateViaMalloc(len, &buffer_mem));
+    // A buffer may reuse a chunk freed by a MemPool.
+    Chunk chunk;
+    if (!ChunkAllocator::instance()->allocate(len, &chunk)) {
+      std::stringstream ss;
+      ss << "ChunkAllocator failed to allocate buffer: " << get_str_err_msg();
+      return Status(ss.str());
+    }
+    buffer->Open(chunk.data, len, chunk.core_id);
   }
-  buffer->Open(buffer_mem, len, CpuInfo::get_current_core());
   return Status::OK;
 }
 
@@ -118,57 +125,18 @@ Status SystemAllocator::AllocateViaMMap(int64_t len, uint8_t** buffer_mem) {
   return Status::OK;
 }
 
-Status SystemAllocator::AllocateViaMalloc(int64_t len, uint8_t** buffer_mem) {
-  bool use_huge_pages = len % HUGE_PAGE_SIZE == 0 && config::FLAGS_madvise_huge_pages;
-  // Allocate, aligned to the page size that we expect to back the memory range.
-  // This ensures that it can be backed by a whole pages, rather than parts of pages.
-  size_t alignment = use_huge_pages ? HUGE_PAGE_SIZE : SMALL_PAGE_SIZE;
-  int rc = posix_memalign(reinterpret_cast<void**>(buffer_mem), alignment, len);
-#if !defined(ADDRESS_SANITIZER) && !defined(LEAK_SANITIZER)
-  // Workaround ASAN bug where posix_memalign returns 0 even when allocation fails.
-  // It should instead return ENOMEM. See https://bugs.llvm.org/show_bug.cgi?id=32968.
-  if (rc == 0 && *buffer_mem == nullptr && len != 0) rc = ENOMEM;
-#endif
-  if (rc != 0) {
-    std::stringstream ss;
-    ss << "posix_memalign() failed to allocate buffer: " << get_str_err_msg();
-    return Status(ss.str());
-  }
-  if (use_huge_pages) {
-#ifdef MADV_HUGEPAGE
-    // According to madvise() docs it may return EAGAIN to signal that we should retry.
-    do {
-      rc = madvise(*buffer_mem, len, MADV_HUGEPAGE);
-    } while (rc == -1 && errno == EAGAIN);
-    DCHECK(rc == 0) << "madvise(MADV_HUGEPAGE) shouldn't fail" << errno;
-#endif
-  }
-  return Status::OK;
-}
-
 void SystemAllocator::Free(BufferPool::BufferHandle&& buffer) {
   if (config::FLAGS_mmap_buffers) {
     int rc = munmap(buffer.data(), buffer.len());
     DCHECK_EQ(rc, 0) << "Unexpected munmap() error: " << errno;
   } else {
-    bool use_huge_pages = buffer.len() % HUGE_PAGE_SIZE == 0 && config::FLAGS_madvise_huge_pages;
-    if (use_huge_pages) {
-      // Undo the madvise so that is isn't a candidate to be newly backed by huge pages.
-      // We depend on TCMalloc's "aggressive decommit" mode decommitting the physical
-      // huge pages with madvise(DONTNEED) when we call free(). Otherwise, this huge
-      // page region may be divvied up and subsequently decommitted in smaller chunks,
-      // which may not actually release the physical memory, causing Impala physical
-      // memory usage to exceed the process limit.
-#ifdef MADV_NOHUGEPAGE
-      // According to madvise() docs it may return EAGAIN to signal that we should retry.
-      int rc;
-      do {
-        rc = madvise(buffer.data(), buffer.len(), MADV_NOHUGEPAGE);
-      } while (rc == -1 && errno == EAGAIN);
-      DCHECK(rc == 0) << "madvise(MADV_NOHUGEPAGE) shouldn't fail" << errno;
-#endif
-    }
-    free(buffer.data());
+    Chunk chunk;
+    chunk.data = buffer.data();
+    chunk.size = buffer.len();
+    chunk.core_id = buffer.home_core_;
+    // The BufferAllocator already keeps freed buffers in its own free lists, so the
+    // ones it frees go back to the system.
+    ChunkAllocator::instance()->free(chunk, false);
   }
   buffer.Reset(); // Avoid DCHECK in ~BufferHandle().
 }
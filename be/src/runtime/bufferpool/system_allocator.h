@@ -28,9 +28,10 @@
 namespace palo {
 
 /// The underlying memory allocator for the buffer pool that allocates buffer memory from
-/// the operating system using mmap(). All buffers are allocated through the BufferPool's
-/// SystemAllocator. The allocator only handles allocating buffers that are power-of-two
-/// multiples of the minimum buffer length.
+/// the operating system using mmap(), or from the process wide ChunkAllocator otherwise.
+/// All buffers are allocated through the BufferPool's SystemAllocator. The allocator
+/// only handles allocating buffers that are power-of-two multiples of the minimum buffer
+/// length.
 class SystemAllocator {
  public:
   SystemAllocator(int64_t min_buffer_len);
@@ -46,9 +47,6 @@ class SystemAllocator {
   /// Allocate 'len' bytes of memory for a buffer via mmap().
   Status AllocateViaMMap(int64_t len, uint8_t** buffer_mem);
 
-  /// Allocate 'len' bytes of memory for a buffer via our malloc implementation.
-  Status AllocateViaMalloc(int64_t len, uint8_t** buffer_mem);
-
   const int64_t min_buffer_len_;
 };
 }
@@ -0,0 +1,283 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "runtime/chunk_allocator.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <utility>
+
+#include "common/config.h"
+#include "common/logging.h"
+#include "gutil/dynamic_annotations.h"
+#include "runtime/mem_tracker.h"
+#include "util/bit_util.h"
+#include "util/cpu_info.h"
+#include "util/palo_metrics.h"
+#include "util/spinlock.h"
+
+namespace palo {
+
+static const int64_t SMALL_PAGE_SIZE = 4LL * 1024;
+static const int64_t HUGE_PAGE_SIZE = 2LL * 1024 * 1024;
+// one size class per power of two
+static const int NUM_SIZE_CLASSES = 64;
+
+// Free lists of one core, or the shared overflow. The bytes in them are consumed from
+// a MemTracker under the same lock, so that the tracker can be replaced exactly.
+class ChunkArena {
+public:
+    explicit ChunkArena(MemTracker* mem_tracker) :
+            _chunk_lists(NUM_SIZE_CLASSES), _bytes(0), _mem_tracker(mem_tracker) {}
+
+    bool pop_free_chunk(size_t size, uint8_t** data) {
+        auto& chunks = _chunk_lists[BitUtil::Log2Ceiling64(size)];
+        std::lock_guard<SpinLock> l(_lock);
+        if (chunks.empty()) {
+            return false;
+        }
+        *data = chunks.back();
+        chunks.pop_back();
+        _bytes -= size;
+        _mem_tracker->release_direct(size);
+        return true;
+    }
+
+    // Pushes the chunk unless the arena would hold more than 'limit' bytes.
+    bool push_free_chunk(uint8_t* data, size_t size, int64_t limit) {
+        auto& chunks = _chunk_lists[BitUtil::Log2Ceiling64(size)];
+        std::lock_guard<SpinLock> l(_lock);
+        if (_bytes + static_cast<int64_t>(size) > limit) {
+            return false;
+        }
+        chunks.push_back(data);
+        _bytes += size;
+        _mem_tracker->consume_direct(size);
+        return true;
+    }
+
+    // Frees chunks to the system, the largest first, until 'bytes' bytes are freed or
+    // the arena is empty. Returns the freed bytes.
+    template <typename FreeFunc>
+    int64_t free_chunks(int64_t bytes, FreeFunc free_func) {
+        std::vector<std::pair<uint8_t*, size_t>> chunks;
+        int64_t freed = 0;
+        {
+            std::lock_guard<SpinLock> l(_lock);
+            for (int i = NUM_SIZE_CLASSES - 1; i >= 0 && freed < bytes; --i) {
+                auto& list = _chunk_lists[i];
+                while (!list.empty() && freed < bytes) {
+                    chunks.emplace_back(list.back(), 1ULL << i);
+                    list.pop_back();
+                    freed += 1LL << i;
+                }
+            }
+            _bytes -= freed;
+            _mem_tracker->release_direct(freed);
+        }
+        // out of the lock, the system may be slow to take them back
+        for (auto& chunk : chunks) {
+            free_func(chunk.first, chunk.second);
+        }
+        return freed;
+    }
+
+    // Moves the bytes in the free lists from the current tracker to 'mem_tracker'.
+    void set_mem_tracker(MemTracker* mem_tracker) {
+        std::lock_guard<SpinLock> l(_lock);
+        _mem_tracker->release_direct(_bytes);
+        mem_tracker->consume_direct(_bytes);
+        _mem_tracker = mem_tracker;
+    }
+
+private:
+    SpinLock _lock;
+    std::vector<std::vector<uint8_t*>> _chunk_lists;
+    int64_t _bytes;
+    MemTracker* _mem_tracker;
+};
+
+ChunkAllocator* ChunkAllocator::instance() {
+    static std::once_flag once;
+    static ChunkAllocator* s_instance = nullptr;
+    std::call_once(once, [] {
+        s_instance = new ChunkAllocator(config::chunk_reserved_bytes_limit);
+    });
+    return s_instance;
+}
+
+ChunkAllocator::ChunkAllocator(int64_t reserve_limit) :
+        _reserve_limit(reserve_limit),
+        _core_reserve_limit(reserve_limit / std::max(CpuInfo::get_max_num_cores(), 1)),
+        _reserved_bytes(0),
+        _mem_tracker(new MemTracker(-1, "ChunkAllocator")),
+        _overflow_arena(new ChunkArena(_mem_tracker.get())) {
+    int num_arenas = std::max(CpuInfo::get_max_num_cores(), 1);
+    for (int i = 0; i < num_arenas; ++i) {
+        _arenas.emplace_back(new ChunkArena(_mem_tracker.get()));
+    }
+}
+
+ChunkAllocator::~ChunkAllocator() {
+    release_reserved(std::numeric_limits<int64_t>::max());
+    if (_mem_tracker->parent() != NULL) {
+        _mem_tracker->unregister_from_parent();
+    }
+    _mem_tracker->close();
+}
+
+void ChunkAllocator::track_in(MemTracker* process_mem_tracker) {
+    std::lock_guard<std::mutex> l(_track_lock);
+    std::unique_ptr<MemTracker> mem_tracker(
+            new MemTracker(-1, "ChunkAllocator", process_mem_tracker));
+    for (auto& arena : _arenas) {
+        arena->set_mem_tracker(mem_tracker.get());
+    }
+    _overflow_arena->set_mem_tracker(mem_tracker.get());
+    // no arena refers to the previous tracker anymore
+    if (_mem_tracker->parent() != NULL) {
+        _mem_tracker->unregister_from_parent();
+    }
+    _mem_tracker->close();
+    _mem_tracker.swap(mem_tracker);
+
+    process_mem_tracker->AddGcFunction([this](int64_t bytes_to_free) {
+        release_reserved(bytes_to_free);
+    });
+}
+
+int64_t ChunkAllocator::release_reserved(int64_t bytes) {
+    int64_t freed = _overflow_arena->free_chunks(bytes, _system_free);
+    for (auto& arena : _arenas) {
+        if (freed >= bytes) {
+            break;
+        }
+        freed += arena->free_chunks(bytes - freed, _system_free);
+    }
+    if (freed > 0) {
+        _reserved_bytes.fetch_sub(freed, std::memory_order_relaxed);
+        PaloMetrics::chunk_pool_reserved_bytes.increment(-freed);
+    }
+    return freed;
+}
+
+bool ChunkAllocator::allocate(size_t size, Chunk* chunk) {
+    int core_id = CpuInfo::get_current_core();
+    chunk->size = size;
+    chunk->core_id = core_id;
+
+    if (BitUtil::IsPowerOf2(size)) {
+        bool found = false;
+        if (_core_arena(core_id)->pop_free_chunk(size, &chunk->data)) {
+            found = true;
+            PaloMetrics::chunk_pool_local_core_alloc_count.increment(1);
+        } else if (_overflow_arena->pop_free_chunk(size, &chunk->data)) {
+            found = true;
+            PaloMetrics::chunk_pool_other_core_alloc_count.increment(1);
+        } else {
+            for (size_t i = 1; i < _arenas.size() && !found; ++i) {
+                found = _core_arena(core_id + i)->pop_free_chunk(size, &chunk->data);
+            }
+            if (found) {
+                PaloMetrics::chunk_pool_other_core_alloc_count.increment(1);
+            }
+        }
+        if (found) {
+            _reserved_bytes.fetch_sub(size, std::memory_order_relaxed);
+            PaloMetrics::chunk_pool_reserved_bytes.increment(-static_cast<int64_t>(size));
+            return true;
+        }
+    }
+
+    chunk->data = _system_allocate(size);
+    if (chunk->data == nullptr) {
+        return false;
+    }
+    PaloMetrics::chunk_pool_system_alloc_count.increment(1);
+    return true;
+}
+
+void ChunkAllocator::free(const Chunk& chunk, bool keep) {
+    // MemPool poisons the unused parts of its chunks, the next owner may be another user
+    ASAN_UNPOISON_MEMORY_REGION(chunk.data, chunk.size);
+    if (keep && BitUtil::IsPowerOf2(chunk.size)) {
+        int64_t reserved = _reserved_bytes.fetch_add(chunk.size, std::memory_order_relaxed);
+        if (reserved + static_cast<int64_t>(chunk.size) <= _reserve_limit) {
+            ChunkArena* arena = _core_arena(chunk.core_id < 0 ? 0 : chunk.core_id);
+            if (arena->push_free_chunk(chunk.data, chunk.size, _core_reserve_limit)
+                    || _overflow_arena->push_free_chunk(chunk.data, chunk.size,
+                                                        _reserve_limit)) {
+                PaloMetrics::chunk_pool_reserved_bytes.increment(chunk.size);
+                return;
+            }
+        }
+        _reserved_bytes.fetch_sub(chunk.size, std::memory_order_relaxed);
+    }
+
+    _system_free(chunk.data, chunk.size);
+    PaloMetrics::chunk_pool_system_free_count.increment(1);
+}
+
+uint8_t* ChunkAllocator::_system_allocate(size_t size) {
+    bool use_huge_pages = size % HUGE_PAGE_SIZE == 0 && config::FLAGS_madvise_huge_pages;
+    // align to the page size that backs the chunk, so that it takes whole pages
+    size_t alignment = alignof(max_align_t);
+    if (use_huge_pages) {
+        alignment = HUGE_PAGE_SIZE;
+    } else if (size >= SMALL_PAGE_SIZE) {
+        alignment = SMALL_PAGE_SIZE;
+    }
+
+    void* data = nullptr;
+    int rc = posix_memalign(&data, alignment, size);
+    if (rc != 0 || data == nullptr) {
+        LOG(WARNING) << "posix_memalign() failed to allocate chunk, size=" << size
+            << ", rc=" << rc;
+        return nullptr;
+    }
+    if (use_huge_pages) {
+#ifdef MADV_HUGEPAGE
+        // According to madvise() docs it may return EAGAIN to signal that we should retry.
+        do {
+            rc = madvise(data, size, MADV_HUGEPAGE);
+        } while (rc == -1 && errno == EAGAIN);
+        DCHECK(rc == 0) << "madvise(MADV_HUGEPAGE) shouldn't fail" << errno;
+#endif
+    }
+    return reinterpret_cast<uint8_t*>(data);
+}
+
+void ChunkAllocator::_system_free(uint8_t* data, size_t size) {
+    bool use_huge_pages = size % HUGE_PAGE_SIZE == 0 && config::FLAGS_madvise_huge_pages;
+    if (use_huge_pages) {
+        // Undo the madvise so that the memory is not a candidate to be newly backed by
+        // huge pages; TCMalloc's aggressive decommit then releases the physical pages.
+#ifdef MADV_NOHUGEPAGE
+        int rc;
+        do {
+            rc = madvise(data, size, MADV_NOHUGEPAGE);
+        } while (rc == -1 && errno == EAGAIN);
+        DCHECK(rc == 0) << "madvise(MADV_NOHUGEPAGE) shouldn't fail" << errno;
+#endif
+    }
+    ::free(data);
+}
+
+}
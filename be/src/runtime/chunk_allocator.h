@@ -0,0 +1,113 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_RUNTIME_CHUNK_ALLOCATOR_H
+#define BDG_PALO_BE_RUNTIME_CHUNK_ALLOCATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "gutil/macros.h"
+
+namespace palo {
+
+class ChunkArena;
+class MemTracker;
+
+// A chunk of memory from ChunkAllocator.
+struct Chunk {
+    uint8_t* data = nullptr;
+    size_t size = 0;
+    // the core whose free list takes the chunk back when it is freed
+    int core_id = -1;
+};
+
+// Process wide cache of the memory chunks of MemPool and BufferPool's SystemAllocator,
+// so that short queries do not go to the system allocator for every row batch.
+//
+// Chunks of power-of-two sizes are kept on free lists when they are freed, one list
+// per size class. Each core has its own free lists and takes up to an equal share of
+// the budget, config::chunk_reserved_bytes_limit; beyond its share a core frees into
+// the shared overflow lists. A chunk is taken from the free lists of the current core,
+// then from the overflow, then from the other cores, and only then from the system.
+// Chunks beyond the budget and chunks whose size is not a power of two go back to the
+// system.
+//
+// The chunks in the free lists are consumed from a MemTracker of the allocator, which
+// track_in() moves under the process MemTracker. They are then freed by a GC function
+// of the process MemTracker when the process limit is reached.
+//
+// When config::FLAGS_madvise_huge_pages is set, chunks that are multiples of the huge
+// page size are aligned to it and advised to be backed by transparent huge pages.
+class ChunkAllocator {
+public:
+    static ChunkAllocator* instance();
+
+    explicit ChunkAllocator(int64_t reserve_limit);
+    ~ChunkAllocator();
+
+    // Tracks the free lists in a child of 'process_mem_tracker' from now on, and frees
+    // them when 'process_mem_tracker' reaches its limit. Called once at startup; the
+    // allocator may already be in use.
+    void track_in(MemTracker* process_mem_tracker);
+
+    // Allocates a chunk of 'size' bytes. Returns false if the system is out of memory.
+    bool allocate(size_t size, Chunk* chunk);
+
+    // Frees a chunk from allocate(), to the free lists if 'keep' and the budget allows.
+    // Callers that cache their freed memory themselves, like the buffer pool, pass false.
+    void free(const Chunk& chunk, bool keep = true);
+
+    // Frees chunks of the free lists to the system, the largest first, until 'bytes'
+    // bytes are freed or the free lists are empty. Returns the freed bytes.
+    int64_t release_reserved(int64_t bytes);
+
+    MemTracker* mem_tracker() const { return _mem_tracker.get(); }
+
+    // Bytes in the free lists.
+    int64_t reserved_bytes() const {
+        return _reserved_bytes.load(std::memory_order_relaxed);
+    }
+
+private:
+    static uint8_t* _system_allocate(size_t size);
+    static void _system_free(uint8_t* data, size_t size);
+
+    ChunkArena* _core_arena(int core_id) {
+        return _arenas[core_id % _arenas.size()].get();
+    }
+
+    const int64_t _reserve_limit;
+    // equal share of the budget of each core
+    const int64_t _core_reserve_limit;
+    std::atomic<int64_t> _reserved_bytes;
+    // consumes the bytes in the free lists
+    std::unique_ptr<MemTracker> _mem_tracker;
+    std::mutex _track_lock;
+
+    std::vector<std::unique_ptr<ChunkArena>> _arenas;
+    std::unique_ptr<ChunkArena> _overflow_arena;
+
+    DISALLOW_COPY_AND_ASSIGN(ChunkAllocator);
+};
+
+}
+
+#endif
@@ -60,10 +60,7 @@ SlotDescriptor::SlotDescriptor(const TSlotDescriptor& tdesc)
       _slot_idx(tdesc.slotIdx),
       _slot_size(_type.get_slot_size()),
       _field_idx(-1),
-      _is_materialized(tdesc.isMaterialized),
-      _is_null_fn(NULL),
-      _set_not_null_fn(NULL),
-      _set_null_fn(NULL) {
+      _is_materialized(tdesc.isMaterialized) {
 }
 
 std::string SlotDescriptor::debug_string() const {
@@ -167,8 +164,7 @@ TupleDescriptor::TupleDescriptor(const TTupleDescriptor& tdesc) :
         _num_null_bytes(tdesc.numNullBytes),
         _num_materialized_slots(0),
         _slots(),
-        _has_varlen_slots(false),
-        _llvm_struct(NULL) {
+        _has_varlen_slots(false) {
       if (false == tdesc.__isset.numNullSlots) {
         //be compatible for existing tables with no NULL value
         _num_null_slots = 0;
@@ -182,6 +178,7 @@ void TupleDescriptor::add_slot(SlotDescriptor* slot) {
 
     if (slot->is_materialized()) {
         ++_num_materialized_slots;
+        slot->_field_idx = slot->_slot_idx + _num_null_bytes;
 
         if (slot->type().is_string_type()) {
             _string_slots.push_back(slot);
@@ -530,8 +527,9 @@ bool SlotDescriptor::layout_equals(const SlotDescriptor& other_desc) const {
 //   ret i1 %is_null
 // }
 llvm::Function* SlotDescriptor::codegen_is_null(LlvmCodeGen* codegen, llvm::StructType* tuple) {
-    if (_is_null_fn != NULL) {
-        return _is_null_fn;
+    llvm::Function* cached_fn = codegen->get_slot_fn(this, "IsNull");
+    if (cached_fn != NULL) {
+        return cached_fn;
     }
 
     llvm::PointerType* tuple_ptr_type = llvm::PointerType::get(tuple, 0);
@@ -552,7 +550,9 @@ llvm::Function* SlotDescriptor::codegen_is_null(LlvmCodeGen* codegen, llvm::Stru
     llvm::Value* is_null = builder.CreateICmpNE(null_mask, zero, "is_null");
     builder.CreateRet(is_null);
 
-    return _is_null_fn = codegen->finalize_function(fn);
+    fn = codegen->finalize_function(fn);
+    codegen->set_slot_fn(this, "IsNull", fn);
+    return fn;
 }
 
 // Generate function to set a slot to be null or not-null.  The resulting IR
@@ -568,17 +568,14 @@ llvm::Function* SlotDescriptor::codegen_is_null(LlvmCodeGen* codegen, llvm::Stru
 // }
 llvm::Function* SlotDescriptor::codegen_update_null(LlvmCodeGen* codegen,
         llvm::StructType* tuple, bool set_null) {
-    if (set_null && _set_null_fn != NULL) {
-        return _set_null_fn;
-    }
-
-    if (!set_null && _set_not_null_fn != NULL) {
-        return _set_not_null_fn;
+    const char* fn_name = set_null ? "SetNull" : "SetNotNull";
+    llvm::Function* cached_fn = codegen->get_slot_fn(this, fn_name);
+    if (cached_fn != NULL) {
+        return cached_fn;
     }
 
     llvm::PointerType* tuple_ptr_type = llvm::PointerType::get(tuple, 0);
-    LlvmCodeGen::FnPrototype prototype(codegen, (set_null) ? "SetNull" : "SetNotNull",
-                                       codegen->void_type());
+    LlvmCodeGen::FnPrototype prototype(codegen, fn_name, codegen->void_type());
     prototype.add_argument(LlvmCodeGen::NamedVariable("tuple", tuple_ptr_type));
 
     LlvmCodeGen::LlvmBuilder builder(codegen->context());
@@ -605,13 +602,7 @@ llvm::Function* SlotDescriptor::codegen_update_null(LlvmCodeGen* codegen,
     builder.CreateRetVoid();
 
     fn = codegen->finalize_function(fn);
-
-    if (set_null) {
-        _set_null_fn = fn;
-    } else {
-        _set_not_null_fn = fn;
-    }
-
+    codegen->set_slot_fn(this, fn_name, fn);
     return fn;
 }
 
@@ -621,8 +612,9 @@ llvm::Function* SlotDescriptor::codegen_update_null(LlvmCodeGen* codegen,
 // rules.
 llvm::StructType* TupleDescriptor::generate_llvm_struct(LlvmCodeGen* codegen) {
     // If we already generated the llvm type, just return it.
-    if (_llvm_struct != NULL) {
-        return _llvm_struct;
+    llvm::StructType* cached_struct = codegen->get_tuple_struct(this);
+    if (cached_struct != NULL) {
+        return cached_struct;
     }
 
     // For each null byte, add a byte to the struct
@@ -638,7 +630,6 @@ llvm::StructType* TupleDescriptor::generate_llvm_struct(LlvmCodeGen* codegen) {
         SlotDescriptor* slot_desc = slots()[i];
 
         if (slot_desc->is_materialized()) {
-            slot_desc->_field_idx = slot_desc->_slot_idx + _num_null_bytes;
             DCHECK_LT(slot_desc->field_idx(), struct_fields.size());
             struct_fields[slot_desc->field_idx()] = codegen->get_type(slot_desc->type().type);
         }
@@ -676,7 +667,7 @@ llvm::StructType* TupleDescriptor::generate_llvm_struct(LlvmCodeGen* codegen) {
         }
     }
 
-    _llvm_struct = tuple_struct;
+    codegen->set_tuple_struct(this, tuple_struct);
     return tuple_struct;
 }
 
@@ -133,11 +133,11 @@ public:
     std::string debug_string() const;
 
     // Codegen for: bool IsNull(Tuple* tuple)
-    // The codegen function is cached.
+    // The codegen function is cached in 'codegen'.
     llvm::Function* codegen_is_null(LlvmCodeGen*, llvm::StructType* tuple);
 
     // Codegen for: void SetNull(Tuple* tuple) / SetNotNull
-    // The codegen function is cached.
+    // The codegen function is cached in 'codegen'.
     llvm::Function* codegen_update_null(LlvmCodeGen*, llvm::StructType* tuple, bool set_null);
 
 private:
@@ -161,17 +161,12 @@ private:
     const int _slot_size;
 
     // the idx of the slot in the llvm codegen'd tuple struct
-    // this is set by TupleDescriptor during codegen and takes into account
+    // this is set by TupleDescriptor::add_slot() and takes into account
     // leading null bytes.
     int _field_idx;
 
     const bool _is_materialized;
 
-    // Cached codegen'd functions
-    llvm::Function* _is_null_fn;
-    llvm::Function* _set_not_null_fn;
-    llvm::Function* _set_null_fn;
-
     SlotDescriptor(const TSlotDescriptor& tdesc);
 };
 
@@ -363,8 +358,6 @@ private:
     // True if _string_slots or _collection_slots have entries.
     bool _has_varlen_slots;
 
-    llvm::StructType* _llvm_struct; // cache for the llvm struct type for this tuple desc
-
     TupleDescriptor(const TTupleDescriptor& tdesc);
     void add_slot(SlotDescriptor* slot);
 
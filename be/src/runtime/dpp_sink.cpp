@@ -118,6 +118,51 @@ private:
     std::vector<HllMergeValue*> _hll_last_row;
 };
 
+// Merges the BITMAP_UNION and QUANTILE_UNION columns of rows with the same key.
+// As HllDppSinkMerge, the values are added to one sketch per column while the key
+// does not change, and the union is serialized into the last row by
+// finalize_one_merge. As in the storage engine, a union that would not fit in its
+// column ends the row, and the rows left of the key go to another row.
+class SketchDppSinkMerge {
+public:
+    ~SketchDppSinkMerge() {
+        close();
+    }
+
+    static bool is_sketch_op(TAggregationType::type op) {
+        return op == TAggregationType::BITMAP_UNION
+                || op == TAggregationType::QUANTILE_UNION;
+    }
+
+    // create one sketch for each sketch column of 'rollup_schema'
+    void prepare(const RollupSchema& rollup_schema);
+
+    // whether 'row' can be merged into 'agg_row' with every union still fitting
+    // in its column
+    bool can_update(TupleRow* agg_row, TupleRow* row, const RollupSchema& rollup_schema);
+
+    // merge the value of 'row' into the sketch of the index-th sketch column,
+    // and the value of 'agg_row' too if it is the first row merged into it
+    void update_sketch(TupleRow* agg_row, TupleRow* row, ExprContext* ctx, int index);
+
+    // serialize the merged sketches into 'agg_row', allocated from 'pool'; fails
+    // if a value is longer than its column
+    Status finalize_one_merge(TupleRow* agg_row, MemPool* pool,
+                              const RollupSchema& rollup_schema);
+
+    void close();
+
+private:
+    void _start_merge(TupleRow* agg_row, ExprContext* ctx, int index);
+    void _merge(int index, StringValue* value);
+
+    std::vector<SketchUnion*> _sketches;
+    // whether the sketch holds the values of the current key
+    std::vector<bool> _merging;
+    // whether a value merged into the sketch is not NULL
+    std::vector<bool> _not_null;
+};
+
 // same tablet which (partition, rollup, bucket) all equals
 // this is used by next steps
 //  1. new one Translator
@@ -241,6 +286,7 @@ private:
     RuntimeProfile::Counter* _agg_timer;
     RuntimeProfile::Counter* _writer_timer;
     HllDppSinkMerge _hll_merge;
+    SketchDppSinkMerge _sketch_merge;
 };
 
 
@@ -490,6 +536,11 @@ Status Translator::create_value_updaters() {
             case TAggregationType::MIN:
             case TAggregationType::SUM:
                 return Status("Unsupport max/min/sum operation on char/varchar column.");
+            case TAggregationType::BITMAP_UNION:
+            case TAggregationType::QUANTILE_UNION:
+                // only placeholder，merge in Translator::update_row
+                _value_updaters.push_back(fake_update);
+                break;
             default:
                 // Only replace has meaning
                 _value_updaters.push_back(fake_update);
@@ -572,6 +623,7 @@ Status Translator::prepare(RuntimeState* state) {
     }   
     _hll_merge.prepare(hll_column_count, 
                         ((QSorter*)_sorter)->get_mem_pool());
+    _sketch_merge.prepare(_rollup_schema);
     return Status::OK;
 }
 
@@ -608,12 +660,16 @@ void Translator::copy_row(TupleRow* row) {
 // merge value must be slot expr,
 void Translator::update_row(TupleRow* agg_row, TupleRow* row) {
     int index = 0;
+    int sketch_index = 0;
     for (int i = 0; i < _rollup_schema.values().size(); ++i) {
         ExprContext* ctx = _rollup_schema.values()[i];
         SlotRef* ref = (SlotRef*)(ctx->root());
         if (_rollup_schema.value_ops()[i] == TAggregationType::HLL_UNION) {
             _hll_merge.update_hll_set(agg_row, row, ctx, index);
             index++;
+        } else if (SketchDppSinkMerge::is_sketch_op(_rollup_schema.value_ops()[i])) {
+            _sketch_merge.update_sketch(agg_row, row, ctx, sketch_index);
+            sketch_index++;
         } else {
             _value_updaters[i](ref, agg_row, row);
         }
@@ -733,6 +789,124 @@ void HllDppSinkMerge::close() {
     _hll_last_row.clear();
 }
 
+void SketchDppSinkMerge::prepare(const RollupSchema& rollup_schema) {
+    for (int i = 0; i < rollup_schema.value_ops().size(); ++i) {
+        switch (rollup_schema.value_ops()[i]) {
+        case TAggregationType::BITMAP_UNION:
+            _sketches.push_back(new SketchUnionImpl<RoaringBitmap>());
+            _merging.push_back(false);
+            _not_null.push_back(false);
+            break;
+        case TAggregationType::QUANTILE_UNION:
+            _sketches.push_back(new SketchUnionImpl<TDigest>());
+            _merging.push_back(false);
+            _not_null.push_back(false);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+void SketchDppSinkMerge::_merge(int index, StringValue* value) {
+    // the union ignores NULL values
+    if (value == NULL) {
+        return;
+    }
+    _not_null[index] = true;
+    if (!_sketches[index]->merge(value->ptr, value->len)) {
+        LOG(WARNING) << "invalid sketch value, ignore it. size=" << value->len;
+    }
+}
+
+void SketchDppSinkMerge::_start_merge(TupleRow* agg_row, ExprContext* ctx, int index) {
+    _sketches[index]->clear();
+    _not_null[index] = false;
+    _merging[index] = true;
+    _merge(index, static_cast<StringValue*>(SlotRef::get_value(ctx->root(), agg_row)));
+}
+
+bool SketchDppSinkMerge::can_update(TupleRow* agg_row, TupleRow* row,
+                                    const RollupSchema& rollup_schema) {
+    int index = 0;
+    for (int i = 0; i < rollup_schema.values().size(); ++i) {
+        if (!is_sketch_op(rollup_schema.value_ops()[i])) {
+            continue;
+        }
+        int cur = index++;
+        ExprContext* ctx = rollup_schema.values()[i];
+        StringValue* value = static_cast<StringValue*>(SlotRef::get_value(ctx->root(), row));
+        if (value == NULL) {
+            continue;
+        }
+        size_t capacity = ctx->root()->type().len;
+        if (!_merging[cur]) {
+            StringValue* agg_value =
+                static_cast<StringValue*>(SlotRef::get_value(ctx->root(), agg_row));
+            if (agg_value == NULL || (size_t)(agg_value->len + value->len) <= capacity) {
+                continue;
+            }
+            // the two values may overlap, only their union tells
+            _start_merge(agg_row, ctx, cur);
+        }
+        if (!_sketches[cur]->can_merge(value->len, capacity)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SketchDppSinkMerge::update_sketch(TupleRow* agg_row, TupleRow* row,
+                                       ExprContext* ctx, int index) {
+    if (!_merging[index]) {
+        _start_merge(agg_row, ctx, index);
+    }
+    _merge(index, static_cast<StringValue*>(SlotRef::get_value(ctx->root(), row)));
+}
+
+Status SketchDppSinkMerge::finalize_one_merge(TupleRow* agg_row, MemPool* pool,
+                                              const RollupSchema& rollup_schema) {
+    int index = 0;
+    for (int i = 0; i < rollup_schema.values().size(); ++i) {
+        if (!is_sketch_op(rollup_schema.value_ops()[i])) {
+            continue;
+        }
+        int cur = index++;
+        bool merging = _merging[cur];
+        _merging[cur] = false;
+        // a single row, whose value is already the union, or only NULL values
+        if (!merging || !_not_null[cur]) {
+            continue;
+        }
+        SketchUnion* sketch = _sketches[cur];
+        SlotRef* ref = (SlotRef*)(rollup_schema.values()[i]->root());
+        int len = sketch->serialized_size();
+        // can_update() keeps the union of values that fit in the column within
+        // it, so only a value longer than the column by itself gets here
+        if (len > ref->type().len) {
+            std::stringstream ss;
+            ss << "merged sketch is longer than its column. size=" << len
+                << ", column length=" << ref->type().len;
+            LOG(WARNING) << ss.str();
+            return Status(ss.str());
+        }
+        char* result = (char*)pool->allocate(len);
+        sketch->serialize(result);
+        ref->get_tuple(agg_row)->set_not_null(ref->null_indicator_offset());
+        static_cast<StringValue*>(ref->get_slot(agg_row))->replace(result, len);
+    }
+    return Status::OK;
+}
+
+void SketchDppSinkMerge::close() {
+    for (int i = 0; i < _sketches.size(); ++i) {
+        delete _sketches[i];
+    }
+    _sketches.clear();
+    _merging.clear();
+    _not_null.clear();
+}
+
 // use batch to release data 
 Status Translator::process_one_row(TupleRow* row) {
     if (row == nullptr) {
@@ -753,7 +927,8 @@ Status Translator::process_one_row(TupleRow* row) {
     TupleRow* last_row = _batch_to_write->get_row(row_idx);
     std::string keys_type = _rollup_schema.keys_type();
     if ("AGG_KEYS" == keys_type || "UNIQUE_KEYS" == keys_type) {
-        if (eq_tuple_row(last_row, row)) {
+        if (eq_tuple_row(last_row, row)
+                && _sketch_merge.can_update(last_row, row, _rollup_schema)) {
             // Just merge to last row and return
             update_row(last_row, row);
             return Status::OK;
@@ -762,6 +937,8 @@ Status Translator::process_one_row(TupleRow* row) {
     _hll_merge.finalize_one_merge(last_row, 
                                   ((QSorter*)_sorter)->get_mem_pool(), 
                                    _rollup_schema);
+    RETURN_IF_ERROR(_sketch_merge.finalize_one_merge(
+            last_row, _batch_to_write->tuple_data_pool(), _rollup_schema));
     // Commit last row and check if batch is full
     _batch_to_write->commit_last_row();
     if (_batch_to_write->is_full()) {
@@ -807,6 +984,8 @@ Status Translator::process(RuntimeState* state) {
         _hll_merge.finalize_one_merge(last_row, 
                                       ((QSorter*)_sorter)->get_mem_pool(), 
                                       _rollup_schema);
+        RETURN_IF_ERROR(_sketch_merge.finalize_one_merge(
+                last_row, _batch_to_write->tuple_data_pool(), _rollup_schema));
     }
 
     // Send the last batch if there any
@@ -833,6 +1012,7 @@ Status Translator::close(RuntimeState* state) {
     Expr::close(_output_row_expr_ctxs, state);
     _batch_to_write.reset();
     _hll_merge.close();
+    _sketch_merge.close();
     return Status::OK;
 }
 
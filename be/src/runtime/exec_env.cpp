@@ -26,6 +26,7 @@
 
 #include "common/logging.h"
 #include "runtime/broker_mgr.h"
+#include "runtime/chunk_allocator.h"
 #include "runtime/bufferpool/buffer_pool.h"
 #include "runtime/client_cache.h"
 #include "runtime/data_stream_mgr.h"
@@ -34,6 +35,7 @@
 #include "runtime/mem_tracker.h"
 #include "runtime/thread_resource_mgr.h"
 #include "runtime/fragment_mgr.h"
+#include "runtime/fragment_status_reporter.h"
 #include "runtime/tmp_file_mgr.h"
 #include "runtime/bufferpool/reservation_tracker.h"
 #include "util/metrics.h"
@@ -43,9 +45,12 @@
 #include "util/parse_util.h"
 #include "util/mem_info.h"
 #include "util/debug_util.h"
+#include "util/cpu_info.h"
+#include "util/priority_work_stealing_thread_pool.hpp"
 #include "http/ev_http_server.h"
 #include "http/action/mini_load.h"
 #include "http/action/checksum_action.h"
+#include "http/action/compaction_action.h"
 #include "http/action/health_action.h"
 #include "http/action/reload_tablet_action.h"
 #include "http/action/snapshot_action.h"
@@ -73,6 +78,21 @@ namespace palo {
 
 ExecEnv* ExecEnv::_exec_env = nullptr;
 
+static PriorityThreadPool* create_scanner_thread_pool() {
+    int thread_num = config::palo_scanner_thread_pool_thread_num;
+    int queue_num = config::palo_scanner_thread_pool_queue_num;
+    if (queue_num <= 0) {
+        queue_num = CpuInfo::get_max_num_cores();
+    }
+    queue_num = std::max(1, std::min(queue_num, thread_num));
+    if (queue_num == 1) {
+        return new PriorityThreadPool(
+            thread_num, config::palo_scanner_thread_pool_queue_size);
+    }
+    return new PriorityWorkStealingThreadPool(
+        thread_num, queue_num, config::palo_scanner_thread_pool_queue_size);
+}
+
 ExecEnv::ExecEnv() :
         _stream_mgr(new DataStreamMgr()),
         _result_mgr(new ResultBufferMgr()),
@@ -84,13 +104,12 @@ ExecEnv::ExecEnv() :
         _mem_tracker(NULL),
         _pool_mem_trackers(new PoolMemTrackerRegistry),
         _thread_mgr(new ThreadResourceMgr),
-        _thread_pool(new PriorityThreadPool(
-                config::palo_scanner_thread_pool_thread_num,
-                config::palo_scanner_thread_pool_queue_size)),
+        _thread_pool(create_scanner_thread_pool()),
         _etl_thread_pool(new ThreadPool(
                 config::etl_thread_pool_size,
                 config::etl_thread_pool_queue_size)),
         _cgroups_mgr(new CgroupsMgr(this, config::palo_cgroups)),
+        _fragment_status_reporter(new FragmentStatusReporter(this)),
         _fragment_mgr(new FragmentMgr(this)),
         _master_info(new TMasterInfo()),
         _etl_job_mgr(new EtlJobMgr(this)),
@@ -172,6 +191,9 @@ Status ExecEnv::start_services() {
     if (bytes_limit > 0) {
         _mem_tracker.reset(new MemTracker(bytes_limit));
     }
+    if (_mem_tracker != nullptr) {
+        ChunkAllocator::instance()->track_in(_mem_tracker.get());
+    }
 
     if (bytes_limit > MemInfo::physical_mem()) {
         LOG(WARNING) << "Memory limit "
@@ -256,6 +278,11 @@ Status ExecEnv::start_webserver() {
     // Register BE snapshot action
     SnapshotAction* snapshot_action = new SnapshotAction(this);
     _ev_http_server->register_handler(HttpMethod::GET, "/api/snapshot", snapshot_action);
+
+    // Register BE compaction action
+    CompactionAction* compaction_action = new CompactionAction(this);
+    _ev_http_server->register_handler(
+            HttpMethod::GET, "/api/compaction/show", compaction_action);
 #endif
 
     RETURN_IF_ERROR(_ev_http_server->start());
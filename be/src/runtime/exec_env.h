@@ -46,6 +46,7 @@ class MemTracker;
 class PoolMemTrackerRegistry;
 class ThreadResourceMgr;
 class FragmentMgr;
+class FragmentStatusReporter;
 class TMasterInfo;
 class EtlJobMgr;
 class LoadPathMgr;
@@ -123,6 +124,9 @@ public:
     FragmentMgr* fragment_mgr() {
         return _fragment_mgr.get();
     }
+    FragmentStatusReporter* fragment_status_reporter() {
+        return _fragment_status_reporter.get();
+    }
     TMasterInfo* master_info() {
         return _master_info.get();
     }
@@ -193,6 +197,8 @@ private:
     boost::scoped_ptr<PriorityThreadPool> _thread_pool;
     boost::scoped_ptr<ThreadPool> _etl_thread_pool;
     boost::scoped_ptr<CgroupsMgr> _cgroups_mgr;
+    // destroyed after _fragment_mgr, whose fragments may still report
+    boost::scoped_ptr<FragmentStatusReporter> _fragment_status_reporter;
     boost::scoped_ptr<FragmentMgr> _fragment_mgr;
     boost::scoped_ptr<TMasterInfo> _master_info;
     boost::scoped_ptr<EtlJobMgr> _etl_job_mgr;
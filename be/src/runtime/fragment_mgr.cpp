@@ -21,6 +21,7 @@
 #include "runtime/fragment_mgr.h"
 
 #include <memory>
+#include <thread>
 #include <sstream>
 
 #include <gperftools/profiler.h>
@@ -28,7 +29,7 @@
 
 #include "agent/cgroups_mgr.h"
 #include "common/resource_tls.h"
-#include "service/backend_options.h"
+#include "runtime/descriptors.h"
 #include "runtime/plan_fragment_executor.h"
 #include "runtime/exec_env.h"
 #include "runtime/datetime_value.h"
@@ -51,6 +52,17 @@ using apache::thrift::transport::TTransportException;
 
 class RuntimeProfile;
 
+// State shared by the fragment instances of one query on this backend, built by the
+// first instance to arrive. It lives as long as one of the instances.
+class QueryExecCtx {
+public:
+    QueryExecCtx() : desc_tbl(NULL) { }
+
+    ObjectPool obj_pool;
+    // read only once built, the llvm code generated for it is kept per instance
+    DescriptorTbl* desc_tbl;
+};
+
 class FragmentExecState {
 public:
     FragmentExecState(
@@ -58,7 +70,8 @@ public:
         const TUniqueId& instance_id,
         int backend_num,
         ExecEnv* exec_env,
-        const TNetworkAddress& coord_hostport);
+        const TNetworkAddress& coord_hostport,
+        const std::shared_ptr<QueryExecCtx>& query_ctx);
 
     ~FragmentExecState();
 
@@ -67,9 +80,6 @@ public:
     // just no use now
     void callback(const Status& status, RuntimeProfile* profile, bool done);
 
-    std::string to_http_path(const std::string& file_name);
-    std::string to_load_error_http_path(const std::string& file_name);
-
     Status execute();
 
     Status cancel();
@@ -123,6 +133,8 @@ private:
     ExecEnv* _exec_env;
     TNetworkAddress _coord_addr;
 
+    // declared before _executor, which refers to it until destroyed
+    std::shared_ptr<QueryExecCtx> _query_ctx;
     PlanFragmentExecutor _executor;
     DateTimeValue _start_time;
 
@@ -143,12 +155,14 @@ FragmentExecState::FragmentExecState(
         const TUniqueId& fragment_instance_id,
         int backend_num,
         ExecEnv* exec_env,
-        const TNetworkAddress& coord_addr) :
+        const TNetworkAddress& coord_addr,
+        const std::shared_ptr<QueryExecCtx>& query_ctx) :
             _query_id(query_id),
             _fragment_instance_id(fragment_instance_id),
             _backend_num(backend_num),
             _exec_env(exec_env),
             _coord_addr(coord_addr),
+            _query_ctx(query_ctx),
             _executor(exec_env, boost::bind<void>(
                     boost::mem_fn(&FragmentExecState::coordinator_callback), this, _1, _2, _3)),
             _set_rsc_info(false),
@@ -168,7 +182,7 @@ Status FragmentExecState::prepare(const TExecPlanFragmentParams& params) {
         set_group(params.resource_info);
     }
 
-    return _executor.prepare(params);
+    return _executor.prepare(params, _query_ctx->desc_tbl);
 }
 
 static void register_cgroups(const std::string& user, const std::string& group) {
@@ -211,27 +225,9 @@ Status FragmentExecState::cancel() {
 void FragmentExecState::callback(const Status& status, RuntimeProfile* profile, bool done) {
 }
 
-std::string FragmentExecState::to_http_path(const std::string& file_name) {
-    std::stringstream url;
-    url << "http://" << BackendOptions::get_localhost() << ":" << config::webserver_port
-        << "/api/_download_load?"
-        << "token=" << _exec_env->token()
-        << "&file=" << file_name;
-    return url.str();
-}
-
-std::string FragmentExecState::to_load_error_http_path(const std::string& file_name) {
-    std::stringstream url;
-    url << "http://" << BackendOptions::get_localhost() << ":" << config::webserver_port
-        << "/api/_load_error_log?"
-        << "file=" << file_name;
-    return url.str();
-}
-
-// There can only be one of these callbacks in-flight at any moment, because
-// it is only invoked from the executor's reporting thread.
-// Also, the reported status will always reflect the most recent execution status,
-// including the final status when execution finishes.
+// Sends the final report of the fragment; the periodic reports are sent by the
+// FragmentStatusReporter. It is only invoked from the thread executing the fragment,
+// and the reported status reflects the final execution status.
 void FragmentExecState::coordinator_callback(
         const Status& status,
         RuntimeProfile* profile,
@@ -260,33 +256,8 @@ void FragmentExecState::coordinator_callback(
     params.__isset.profile = true;
 
     RuntimeState* runtime_state = _executor.runtime_state();
-    if (!runtime_state->output_files().empty()) {
-        params.__isset.delta_urls = true;
-        for (auto& it : runtime_state->output_files()) {
-            params.delta_urls.push_back(to_http_path(it));
-        }
-    }
-    if (runtime_state->num_rows_load_success() > 0 ||
-            runtime_state->num_rows_load_filtered() > 0) {
-        params.__isset.load_counters = true;
-        // TODO(zc)
-        static std::string s_dpp_normal_all = "dpp.norm.ALL";
-        static std::string s_dpp_abnormal_all = "dpp.abnorm.ALL";
-
-        params.load_counters.emplace(
-            s_dpp_normal_all, std::to_string(runtime_state->num_rows_load_success()));
-        params.load_counters.emplace(
-            s_dpp_abnormal_all, std::to_string(runtime_state->num_rows_load_filtered()));
-    }
-    if (!runtime_state->get_error_log_file_path().empty()) {
-        params.__set_tracking_url(
-                to_load_error_http_path(runtime_state->get_error_log_file_path()));
-    }
-    if (!runtime_state->export_output_files().empty()) {
-        params.__isset.export_files = true;
-        params.export_files = runtime_state->export_output_files();
-    }
     DCHECK(runtime_state != NULL);
+    _executor.get_load_report_params(&params);
 
     // Send new errors to coordinator
     runtime_state->get_unreported_errors(&(params.error_log));
@@ -350,6 +321,7 @@ FragmentMgr::~FragmentMgr() {
     {
         std::lock_guard<std::mutex> lock(_lock);
         _fragment_map.clear();
+        _query_ctx_map.clear();
     }
 }
 
@@ -392,8 +364,130 @@ static void* fragment_executor(void* param) {
 Status FragmentMgr::exec_plan_fragment(
         const TExecPlanFragmentParams& params,
         FinishCallback cb) {
-    const TUniqueId& fragment_instance_id = params.params.fragment_instance_id;
+    int64_t duration_ns = 0;
+    {
+        SCOPED_RAW_TIMER(&duration_ns);
+        std::shared_ptr<QueryExecCtx> query_ctx;
+        RETURN_IF_ERROR(_get_query_ctx(params, &query_ctx));
+        RETURN_IF_ERROR(_exec_plan_fragment(params, query_ctx, cb));
+    }
+    PaloMetrics::single_fragment_start_requests_total.increment(1);
+    PaloMetrics::single_fragment_start_duration_us.increment(duration_ns / 1000);
+    return Status::OK;
+}
+
+Status FragmentMgr::exec_plan_fragments(const std::vector<TExecPlanFragmentParams>& params) {
+    if (params.empty()) {
+        return Status::OK;
+    }
+    const TUniqueId& query_id = params[0].params.query_id;
+    for (auto& it : params) {
+        if (it.params.query_id != query_id) {
+            std::stringstream ss;
+            ss << "fragment instances of different queries in one batch, query_id="
+                << query_id << ", other query_id=" << it.params.query_id;
+            return Status(ss.str());
+        }
+    }
+    std::shared_ptr<QueryExecCtx> query_ctx;
+    RETURN_IF_ERROR(_get_query_ctx(params[0], &query_ctx));
+    if (query_ctx->desc_tbl == NULL) {
+        std::stringstream ss;
+        ss << "no descriptor table for query, query_id=" << query_id;
+        return Status(ss.str());
+    }
+    int64_t duration_ns = 0;
+    {
+        SCOPED_RAW_TIMER(&duration_ns);
+        // Prepare is the expensive part of starting an instance (plan tree, codegen),
+        // so the instances are prepared concurrently and none of them is started
+        // unless all are prepared. Dedicated threads are used because the threads
+        // of the fragment pool are held by running instances.
+        std::vector<std::shared_ptr<FragmentExecState>> exec_states(params.size());
+        std::vector<Status> statuses(params.size());
+        std::vector<std::thread> threads;
+        threads.reserve(params.size() - 1);
+        for (size_t i = 1; i < params.size(); ++i) {
+            threads.emplace_back([this, &params, &query_ctx, &exec_states, &statuses, i] {
+                statuses[i] = _prepare_fragment(params[i], query_ctx, &exec_states[i]);
+            });
+        }
+        statuses[0] = _prepare_fragment(params[0], query_ctx, &exec_states[0]);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        for (auto& status : statuses) {
+            RETURN_IF_ERROR(status);
+        }
+        for (auto& exec_state : exec_states) {
+            if (exec_state == nullptr) {
+                // Duplicated
+                continue;
+            }
+            RETURN_IF_ERROR(_start_fragment(
+                    exec_state, std::bind<void>(&empty_function, std::placeholders::_1)));
+        }
+    }
+    PaloMetrics::batch_fragment_start_requests_total.increment(1);
+    PaloMetrics::batch_fragment_start_duration_us.increment(duration_ns / 1000);
+    PaloMetrics::batch_fragment_start_instances_total.increment(params.size());
+    return Status::OK;
+}
+
+Status FragmentMgr::_get_query_ctx(
+        const TExecPlanFragmentParams& params,
+        std::shared_ptr<QueryExecCtx>* query_ctx) {
+    const TUniqueId& query_id = params.params.query_id;
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        auto iter = _query_ctx_map.find(query_id);
+        if (iter != _query_ctx_map.end()) {
+            *query_ctx = iter->second.lock();
+            if (*query_ctx != nullptr) {
+                return Status::OK;
+            }
+        }
+    }
+
+    std::shared_ptr<QueryExecCtx> new_ctx(new QueryExecCtx());
+    if (!params.__isset.desc_tbl) {
+        // not shared, the executor reports the missing descriptor table
+        *query_ctx = new_ctx;
+        return Status::OK;
+    }
+    // built without the lock, instances of other queries need not wait for it
+    RETURN_IF_ERROR(DescriptorTbl::create(
+            &new_ctx->obj_pool, params.desc_tbl, &new_ctx->desc_tbl));
+
+    std::lock_guard<std::mutex> lock(_lock);
+    std::weak_ptr<QueryExecCtx>& entry = _query_ctx_map[query_id];
+    *query_ctx = entry.lock();
+    if (*query_ctx == nullptr) {
+        entry = new_ctx;
+        *query_ctx = new_ctx;
+    }
+    return Status::OK;
+}
+
+Status FragmentMgr::_exec_plan_fragment(
+        const TExecPlanFragmentParams& params,
+        const std::shared_ptr<QueryExecCtx>& query_ctx,
+        FinishCallback cb) {
     std::shared_ptr<FragmentExecState> exec_state;
+    RETURN_IF_ERROR(_prepare_fragment(params, query_ctx, &exec_state));
+    if (exec_state == nullptr) {
+        // Duplicated
+        return Status::OK;
+    }
+    return _start_fragment(exec_state, cb);
+}
+
+Status FragmentMgr::_prepare_fragment(
+        const TExecPlanFragmentParams& params,
+        const std::shared_ptr<QueryExecCtx>& query_ctx,
+        std::shared_ptr<FragmentExecState>* exec_state) {
+    const TUniqueId& fragment_instance_id = params.params.fragment_instance_id;
+    exec_state->reset();
     {
         std::lock_guard<std::mutex> lock(_lock);
         auto iter = _fragment_map.find(fragment_instance_id);
@@ -402,13 +496,22 @@ Status FragmentMgr::exec_plan_fragment(
             return Status::OK;
         }
     }
-    exec_state.reset(new FragmentExecState(
+    std::shared_ptr<FragmentExecState> new_state(new FragmentExecState(
             params.params.query_id,
             fragment_instance_id,
             params.backend_num,
             _exec_env,
-            params.coord));
-    RETURN_IF_ERROR(exec_state->prepare(params));
+            params.coord,
+            query_ctx));
+    RETURN_IF_ERROR(new_state->prepare(params));
+    *exec_state = new_state;
+    return Status::OK;
+}
+
+Status FragmentMgr::_start_fragment(
+        const std::shared_ptr<FragmentExecState>& exec_state,
+        FinishCallback cb) {
+    const TUniqueId& fragment_instance_id = exec_state->fragment_instance_id();
     bool use_pool = true;
     {
         std::lock_guard<std::mutex> lock(_lock);
@@ -478,6 +581,13 @@ void FragmentMgr::cancel_worker() {
                     to_delete.push_back(it.second->fragment_instance_id());
                 }
             }
+            for (auto it = _query_ctx_map.begin(); it != _query_ctx_map.end();) {
+                if (it->second.expired()) {
+                    it = _query_ctx_map.erase(it);
+                } else {
+                    ++it;
+                }
+            }
         }
         for (auto& id : to_delete) {
             LOG(INFO) << "FragmentMgr cancel worker going to cancel fragment " << id;
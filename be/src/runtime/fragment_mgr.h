@@ -26,6 +26,7 @@
 #include <unordered_map>
 #include <functional>
 #include <thread>
+#include <vector>
 
 #include "common/status.h"
 #include "gen_cpp/Types_types.h"
@@ -37,6 +38,7 @@ namespace palo {
 
 class ExecEnv;
 class FragmentExecState;
+class QueryExecCtx;
 class TExecPlanFragmentParams;
 class PlanFragmentExecutor;
 
@@ -54,6 +56,10 @@ public:
     // TODO(zc): report this is over
     Status exec_plan_fragment(const TExecPlanFragmentParams& params, FinishCallback cb);
 
+    // execute instances of one query, which share the descriptor table of the query
+    // on this backend. Only the first params need to carry the descriptor table.
+    Status exec_plan_fragments(const std::vector<TExecPlanFragmentParams>& params);
+
     Status cancel(const TUniqueId& fragment_id);
 
     void cancel_worker();
@@ -63,6 +69,25 @@ private:
     void exec_actual(std::shared_ptr<FragmentExecState> exec_state,
                      FinishCallback cb);
 
+    // Returns the state shared by the instances of the query of 'params', which is
+    // built from params.desc_tbl if no instance of the query is running.
+    Status _get_query_ctx(const TExecPlanFragmentParams& params,
+                          std::shared_ptr<QueryExecCtx>* query_ctx);
+
+    Status _exec_plan_fragment(const TExecPlanFragmentParams& params,
+                               const std::shared_ptr<QueryExecCtx>& query_ctx,
+                               FinishCallback cb);
+
+    // Prepares the instance of 'params' without registering it. 'exec_state' is
+    // left NULL if the instance is already running.
+    Status _prepare_fragment(const TExecPlanFragmentParams& params,
+                             const std::shared_ptr<QueryExecCtx>& query_ctx,
+                             std::shared_ptr<FragmentExecState>* exec_state);
+
+    // Registers a prepared instance and hands it to an exec thread.
+    Status _start_fragment(const std::shared_ptr<FragmentExecState>& exec_state,
+                           FinishCallback cb);
+
     // This is input params
     ExecEnv* _exec_env;
 
@@ -71,6 +96,10 @@ private:
     // Make sure that remove this before no data reference FragmentExecState
     std::unordered_map<TUniqueId, std::shared_ptr<FragmentExecState>> _fragment_map;
 
+    // query id -> state shared by the running instances of the query, expired entries
+    // are removed by the cancel thread
+    std::unordered_map<TUniqueId, std::weak_ptr<QueryExecCtx>> _query_ctx_map;
+
     // Cancel thread
     bool _stop;
     std::thread _cancel_thread;
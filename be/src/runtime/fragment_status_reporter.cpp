@@ -0,0 +1,349 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "runtime/fragment_status_reporter.h"
+
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+
+#include <boost/bind.hpp>
+#include <thrift/TApplicationException.h>
+
+#include "common/config.h"
+#include "common/logging.h"
+#include "gen_cpp/FrontendService.h"
+#include "runtime/client_cache.h"
+#include "runtime/exec_env.h"
+#include "runtime/plan_fragment_executor.h"
+#include "util/debug_util.h"
+#include "util/stopwatch.hpp"
+
+namespace palo {
+
+using apache::thrift::TApplicationException;
+using apache::thrift::TException;
+using apache::thrift::transport::TTransportException;
+
+const int FragmentStatusReporter::WHEEL_SLOTS;
+
+void ReportedProfile::encode_delta(TRuntimeProfileTree* tree) {
+    _pending_counters.clear();
+    _pending_info_strings.clear();
+    // the nodes are in preorder: path of each ancestor and its children not seen yet
+    std::vector<std::pair<std::string, int32_t>> parents;
+    for (TRuntimeProfileNode& node : tree->nodes) {
+        while (!parents.empty() && parents.back().second == 0) {
+            parents.pop_back();
+        }
+        std::string path;
+        if (!parents.empty()) {
+            path = parents.back().first;
+            --parents.back().second;
+        }
+        path.append(node.name).push_back('\0');
+
+        std::vector<TCounter> counters;
+        for (const TCounter& counter : node.counters) {
+            std::string key = path + counter.name;
+            auto it = _counters.find(key);
+            if (it != _counters.end() && it->second == counter.value) {
+                continue;
+            }
+            _pending_counters[key] = counter.value;
+            counters.push_back(counter);
+        }
+        node.counters.swap(counters);
+
+        std::map<std::string, std::string> info_strings;
+        std::vector<std::string> display_order;
+        for (const std::string& name : node.info_strings_display_order) {
+            auto value = node.info_strings.find(name);
+            if (value == node.info_strings.end()) {
+                continue;
+            }
+            std::string key = path + name;
+            auto it = _info_strings.find(key);
+            if (it != _info_strings.end() && it->second == value->second) {
+                continue;
+            }
+            _pending_info_strings[key] = value->second;
+            info_strings.insert(*value);
+            display_order.push_back(name);
+        }
+        node.info_strings.swap(info_strings);
+        node.info_strings_display_order.swap(display_order);
+
+        parents.emplace_back(path, node.num_children);
+    }
+}
+
+void ReportedProfile::commit() {
+    for (auto& it : _pending_counters) {
+        _counters[it.first] = it.second;
+    }
+    for (auto& it : _pending_info_strings) {
+        _info_strings[it.first] = it.second;
+    }
+    _pending_counters.clear();
+    _pending_info_strings.clear();
+}
+
+FragmentStatusReporter::FragmentStatusReporter(ExecEnv* exec_env) :
+        _exec_env(exec_env),
+        _stop(false),
+        _wheel(WHEEL_SLOTS),
+        _cursor(0),
+        _pool(config::status_report_thread_num, 1024),
+        _timer_thread(&FragmentStatusReporter::_timer_loop, this) {
+}
+
+FragmentStatusReporter::~FragmentStatusReporter() {
+    {
+        std::lock_guard<std::mutex> l(_lock);
+        _stop = true;
+    }
+    _stop_cv.notify_all();
+    _timer_thread.join();
+    _pool.drain_and_shutdown();
+    for (auto& it : _fragments) {
+        delete it.second;
+    }
+}
+
+void FragmentStatusReporter::register_fragment(PlanFragmentExecutor* executor) {
+    Fragment* fragment = new Fragment();
+    fragment->executor = executor;
+    fragment->coord_addr = executor->coord_addr();
+    std::stringstream key;
+    key << fragment->coord_addr.hostname << ":" << fragment->coord_addr.port;
+    fragment->coord_key = key.str();
+    fragment->sending = false;
+    fragment->unregistered = false;
+    int interval = std::max(config::status_report_interval, 1);
+
+    std::lock_guard<std::mutex> l(_lock);
+    DCHECK(_fragments.find(executor) == _fragments.end());
+    _fragments[executor] = fragment;
+    ++_coordinators[fragment->coord_key].num_fragments;
+    // spread the reports of the instances over the interval
+    _schedule(fragment, 1 + rand() % interval);
+}
+
+void FragmentStatusReporter::unregister_fragment(PlanFragmentExecutor* executor) {
+    std::unique_lock<std::mutex> l(_lock);
+    auto it = _fragments.find(executor);
+    if (it == _fragments.end()) {
+        return;
+    }
+    Fragment* fragment = it->second;
+    if (fragment->sending) {
+        fragment->unregistered = true;
+        while (fragment->sending) {
+            _sent_cv.wait(l);
+        }
+    } else {
+        _wheel[fragment->slot].erase(fragment->it);
+    }
+    _fragments.erase(executor);
+
+    auto coord = _coordinators.find(fragment->coord_key);
+    DCHECK(coord != _coordinators.end());
+    if (--coord->second.num_fragments == 0 && !coord->second.sending) {
+        _coordinators.erase(coord);
+    }
+    delete fragment;
+}
+
+void FragmentStatusReporter::_schedule(Fragment* fragment, int delay_seconds) {
+    DCHECK_GT(delay_seconds, 0);
+    fragment->slot = (_cursor + delay_seconds) % WHEEL_SLOTS;
+    fragment->rounds = (delay_seconds - 1) / WHEEL_SLOTS;
+    fragment->it = _wheel[fragment->slot].insert(_wheel[fragment->slot].end(), fragment);
+}
+
+void FragmentStatusReporter::_timer_loop() {
+    std::unique_lock<std::mutex> l(_lock);
+    auto next_tick = std::chrono::steady_clock::now();
+    while (true) {
+        next_tick += std::chrono::seconds(1);
+        while (!_stop && _stop_cv.wait_until(l, next_tick) != std::cv_status::timeout) {
+        }
+        if (_stop) {
+            break;
+        }
+
+        _cursor = (_cursor + 1) % WHEEL_SLOTS;
+        std::map<std::string, std::vector<Fragment*>> batches;
+        std::list<Fragment*>& slot = _wheel[_cursor];
+        for (auto it = slot.begin(); it != slot.end();) {
+            Fragment* fragment = *it;
+            if (fragment->rounds > 0) {
+                --fragment->rounds;
+                ++it;
+                continue;
+            }
+            it = slot.erase(it);
+            if (_coordinators[fragment->coord_key].sending) {
+                // the coordinator is still busy with the last batch
+                _schedule(fragment, 1);
+                continue;
+            }
+            fragment->sending = true;
+            batches[fragment->coord_key].push_back(fragment);
+        }
+        if (batches.empty()) {
+            continue;
+        }
+        for (auto& batch : batches) {
+            _coordinators[batch.first].sending = true;
+        }
+
+        l.unlock();
+        for (auto& batch : batches) {
+            _pool.offer(boost::bind<void>(boost::mem_fn(&FragmentStatusReporter::_send_batch),
+                                          this, batch.first, batch.second));
+        }
+        l.lock();
+    }
+}
+
+void FragmentStatusReporter::_send_batch(
+        const std::string& coord_key, std::vector<Fragment*> fragments) {
+    // the fragments cannot be unregistered while they are sending, so their
+    // executors are alive
+    std::vector<TReportExecStatusParams> params(fragments.size());
+    for (int i = 0; i < fragments.size(); ++i) {
+        fragments[i]->executor->get_report_params(&params[i]);
+        fragments[i]->reported.encode_delta(&params[i].profile);
+    }
+
+    Coordinator* coord = NULL;
+    {
+        std::lock_guard<std::mutex> l(_lock);
+        coord = &_coordinators[coord_key];
+    }
+    MonotonicStopWatch watch;
+    watch.start();
+    std::vector<TReportExecStatusResult> results;
+    Status status = _send_reports(fragments[0]->coord_addr, coord, &params, &results);
+    int64_t elapsed_ms = watch.elapsed_time() / 1000 / 1000;
+
+    for (int i = 0; i < fragments.size(); ++i) {
+        Status report_status = status.ok() ? Status(results[i].status) : status;
+        if (report_status.ok()) {
+            fragments[i]->reported.commit();
+            continue;
+        }
+        LOG(WARNING) << "failed to report status of fragment instance "
+                     << print_id(fragments[i]->executor->runtime_state()->fragment_instance_id())
+                     << ": " << report_status.get_error_msg();
+        // we need to cancel the execution of this fragment
+        fragments[i]->executor->cancel();
+    }
+
+    std::lock_guard<std::mutex> l(_lock);
+    coord->sending = false;
+    if (!status.ok() || elapsed_ms > config::status_report_slow_rpc_ms) {
+        coord->backoff_seconds = std::min(std::max(coord->backoff_seconds * 2, 1),
+                                          config::status_report_max_backoff_seconds);
+        LOG(INFO) << "coordinator " << coord_key << " is slow to take status reports, "
+                  << "back off " << coord->backoff_seconds << " seconds. rpc_time="
+                  << elapsed_ms << "ms";
+    } else {
+        coord->backoff_seconds = 0;
+    }
+    int delay = std::max(config::status_report_interval, 1) + coord->backoff_seconds;
+    for (Fragment* fragment : fragments) {
+        fragment->sending = false;
+        if (!fragment->unregistered) {
+            _schedule(fragment, delay);
+        }
+    }
+    if (coord->num_fragments == 0) {
+        _coordinators.erase(coord_key);
+    }
+    _sent_cv.notify_all();
+}
+
+Status FragmentStatusReporter::_send_reports(
+        const TNetworkAddress& addr, Coordinator* coord,
+        std::vector<TReportExecStatusParams>* params,
+        std::vector<TReportExecStatusResult>* results) {
+    Status status;
+    FrontendServiceConnection client(_exec_env->frontend_client_cache(), addr, &status);
+    if (!status.ok()) {
+        std::stringstream ss;
+        ss << "couldn't get a client for " << addr;
+        return Status(TStatusCode::INTERNAL_ERROR, ss.str(), false);
+    }
+
+    try {
+        // only the thread sending to 'coord' uses batch_unsupported
+        if (!coord->batch_unsupported) {
+            TBatchReportExecStatusParams request;
+            request.protocol_version = FrontendServiceVersion::V1;
+            request.params.swap(*params);
+            request.__isset.params = true;
+            TBatchReportExecStatusResult result;
+            try {
+                try {
+                    client->batchReportExecStatus(result, request);
+                } catch (TTransportException& e) {
+                    LOG(WARNING) << "Retrying batchReportExecStatus: " << e.what();
+                    RETURN_IF_ERROR(client.reopen());
+                    client->batchReportExecStatus(result, request);
+                }
+                if (result.results.size() != request.params.size()) {
+                    std::stringstream ss;
+                    ss << "coordinator " << addr << " answered " << result.results.size()
+                       << " of " << request.params.size() << " status reports";
+                    return Status(TStatusCode::INTERNAL_ERROR, ss.str(), false);
+                }
+                results->swap(result.results);
+                return Status::OK;
+            } catch (TApplicationException& e) {
+                if (e.getType() != TApplicationException::UNKNOWN_METHOD) {
+                    throw;
+                }
+                LOG(INFO) << "coordinator " << addr << " does not know batchReportExecStatus, "
+                          << "report fragment instances one by one";
+                coord->batch_unsupported = true;
+                params->swap(request.params);
+            }
+        }
+
+        results->resize(params->size());
+        for (int i = 0; i < params->size(); ++i) {
+            try {
+                client->reportExecStatus((*results)[i], (*params)[i]);
+            } catch (TTransportException& e) {
+                LOG(WARNING) << "Retrying ReportExecStatus: " << e.what();
+                RETURN_IF_ERROR(client.reopen());
+                client->reportExecStatus((*results)[i], (*params)[i]);
+            }
+        }
+    } catch (TException& e) {
+        std::stringstream msg;
+        msg << "ReportExecStatus() to " << addr << " failed:\n" << e.what();
+        LOG(WARNING) << msg.str();
+        return Status(TStatusCode::INTERNAL_ERROR, msg.str(), false);
+    }
+    return Status::OK;
+}
+
+}
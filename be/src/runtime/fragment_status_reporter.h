@@ -0,0 +1,161 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#ifndef BDG_PALO_BE_RUNTIME_FRAGMENT_STATUS_REPORTER_H
+#define BDG_PALO_BE_RUNTIME_FRAGMENT_STATUS_REPORTER_H
+
+#include <condition_variable>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "common/status.h"
+#include "gen_cpp/FrontendService_types.h"
+#include "gen_cpp/RuntimeProfile_types.h"
+#include "gen_cpp/Types_types.h"
+#include "util/thread_pool.hpp"
+
+namespace palo {
+
+class ExecEnv;
+class PlanFragmentExecutor;
+
+// The counters and info strings of a fragment instance's profile as last accepted by
+// its coordinator. They are keyed by the names of their profile node and the node's
+// ancestors, because nodes may be added to the profile between two reports.
+class ReportedProfile {
+public:
+    // Removes from 'tree' the counters and info strings that did not change since the
+    // last committed report. All nodes are kept, so that the coordinator, which merges
+    // the reports by name, can still match them. The values left in 'tree' are
+    // remembered until commit() or the next encode_delta().
+    void encode_delta(TRuntimeProfileTree* tree);
+
+    // The coordinator accepted the report of the last encode_delta().
+    void commit();
+
+private:
+    std::map<std::string, int64_t> _counters;
+    std::map<std::string, std::string> _info_strings;
+    std::map<std::string, int64_t> _pending_counters;
+    std::map<std::string, std::string> _pending_info_strings;
+};
+
+// Sends the periodic status reports of all the fragment instances running on this
+// backend, instead of one report thread per PlanFragmentExecutor.
+//
+// - Instances wait for their next report in a timer wheel that one thread advances
+//   every second. The first report of an instance is at a random point of the first
+//   config::status_report_interval, so that the reports are spread.
+// - The reports due at the same time for the same coordinator are sent in one
+//   batchReportExecStatus() RPC by a pool of config::status_report_thread_num threads.
+//   Coordinators without that RPC get one reportExecStatus() per instance.
+// - A report only carries the counters and info strings that changed since the last
+//   report the coordinator accepted.
+// - A coordinator gets at most one batch at a time. When its RPC fails or takes more
+//   than config::status_report_slow_rpc_ms, the next reports to it are delayed by a
+//   backoff doubling up to config::status_report_max_backoff_seconds.
+//
+// As with the report threads, a fragment instance whose report fails is cancelled.
+// The final report of an instance is still sent by its PlanFragmentExecutor.
+class FragmentStatusReporter {
+public:
+    explicit FragmentStatusReporter(ExecEnv* exec_env);
+    ~FragmentStatusReporter();
+
+    // Starts the periodic reports of 'executor', which must have been prepared with
+    // a coordinator address.
+    void register_fragment(PlanFragmentExecutor* executor);
+
+    // Stops the periodic reports of 'executor'. Waits for a report of it being sent.
+    void unregister_fragment(PlanFragmentExecutor* executor);
+
+private:
+    static const int WHEEL_SLOTS = 64;
+
+    struct Fragment {
+        PlanFragmentExecutor* executor;
+        std::string coord_key;
+        TNetworkAddress coord_addr;
+        ReportedProfile reported;
+        // position in the wheel, valid when !sending
+        int slot;
+        int rounds;
+        std::list<Fragment*>::iterator it;
+        // a report of this instance is in a batch
+        bool sending;
+        // unregister_fragment() waits for the batch, do not schedule it again
+        bool unregistered;
+    };
+
+    struct Coordinator {
+        Coordinator() :
+                num_fragments(0),
+                sending(false),
+                backoff_seconds(0),
+                batch_unsupported(false) {}
+
+        int num_fragments;
+        // a batch to this coordinator is being sent
+        bool sending;
+        int backoff_seconds;
+        // the coordinator does not know batchReportExecStatus()
+        bool batch_unsupported;
+    };
+
+    // Puts 'fragment' in the wheel 'delay_seconds' from now. Called with _lock held.
+    void _schedule(Fragment* fragment, int delay_seconds);
+
+    // Advances the wheel every second and hands the due reports to the pool.
+    void _timer_loop();
+
+    // Builds and sends the reports of 'fragments', which all have coordinator
+    // 'coord_key', then schedules their next reports.
+    void _send_batch(const std::string& coord_key, std::vector<Fragment*> fragments);
+
+    // Sends 'params' to 'addr', the address of 'coord'. Sets 'results' to one result
+    // per report if the coordinator answered.
+    Status _send_reports(const TNetworkAddress& addr, Coordinator* coord,
+                         std::vector<TReportExecStatusParams>* params,
+                         std::vector<TReportExecStatusResult>* results);
+
+    ExecEnv* _exec_env;
+
+    // guards all the fields below but _pool
+    std::mutex _lock;
+    // signaled when a fragment stops sending
+    std::condition_variable _sent_cv;
+    std::condition_variable _stop_cv;
+    bool _stop;
+
+    std::vector<std::list<Fragment*>> _wheel;
+    int _cursor;
+    std::unordered_map<PlanFragmentExecutor*, Fragment*> _fragments;
+    // "host:port" -> coordinator
+    std::map<std::string, Coordinator> _coordinators;
+
+    ThreadPool _pool;
+    std::thread _timer_thread;
+};
+
+}
+
+#endif
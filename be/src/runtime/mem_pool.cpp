@@ -51,9 +51,10 @@ MemPool::MemPool(MemTracker* mem_tracker)
   DCHECK_EQ(zero_length_region_, MEM_POOL_POISON);
 }
 
-MemPool::ChunkInfo::ChunkInfo(int64_t size, uint8_t* buf)
-  : data(buf),
-    size(size),
+MemPool::ChunkInfo::ChunkInfo(const Chunk& chunk)
+  : data(chunk.data),
+    size(chunk.size),
+    core_id(chunk.core_id),
     allocated_bytes(0) {
    PaloMetrics::memory_pool_bytes_total.increment(size);
 }
@@ -62,7 +63,7 @@ MemPool::~MemPool() {
   int64_t total_bytes_released = 0;
   for (size_t i = 0; i < chunks_.size(); ++i) {
     total_bytes_released += chunks_[i].size;
-    free(chunks_[i].data);
+    ChunkAllocator::instance()->free(chunks_[i].chunk());
   }
  
   mem_tracker_->release(total_bytes_released);
@@ -88,7 +89,7 @@ void MemPool::free_all() {
   int64_t total_bytes_released = 0;
   for (auto& chunk: chunks_) {
     total_bytes_released += chunk.size;
-    free(chunk.data);
+    ChunkAllocator::instance()->free(chunk.chunk());
   }
   chunks_.clear();
   next_chunk_size_ = INITIAL_CHUNK_SIZE;
@@ -144,20 +145,20 @@ bool MemPool::FindChunk(size_t min_size, bool check_limits) {
     mem_tracker_->consume(chunk_size);
   }
 
-  // Allocate a new chunk. Return early if malloc fails.
-  uint8_t* buf = reinterpret_cast<uint8_t*>(malloc(chunk_size));
-  if (UNLIKELY(buf == NULL)) {
+  // Allocate a new chunk. Return early if the allocation fails.
+  Chunk chunk;
+  if (UNLIKELY(!ChunkAllocator::instance()->allocate(chunk_size, &chunk))) {
     mem_tracker_->release(chunk_size);
     return false;
   }
 
-  ASAN_POISON_MEMORY_REGION(buf, chunk_size);
+  ASAN_POISON_MEMORY_REGION(chunk.data, chunk_size);
 
   // Put it before the first free chunk. If no free chunks, it goes at the end.
   if (first_free_idx == static_cast<int>(chunks_.size())) {
-    chunks_.push_back(ChunkInfo(chunk_size, buf));
+    chunks_.push_back(ChunkInfo(chunk));
   } else {
-    chunks_.insert(chunks_.begin() + first_free_idx, ChunkInfo(chunk_size, buf));
+    chunks_.insert(chunks_.begin() + first_free_idx, ChunkInfo(chunk));
   }
   current_chunk_idx_ = first_free_idx;
   total_reserved_bytes_ += chunk_size;
@@ -30,6 +30,7 @@
 #include <vector>
 
 #include "common/logging.h"
+#include "runtime/chunk_allocator.h"
 #include "gutil/dynamic_annotations.h"
 #include "util/bit_util.h"
 
@@ -53,6 +54,8 @@ class MemTracker;
 /// big enough otherwise a new chunk is added to the list.
 /// In order to keep allocation overhead low, chunk sizes double with each new one
 /// added, until they hit a maximum size.
+/// Chunks come from and go back to the process wide ChunkAllocator, which keeps
+/// freed chunks for reuse by other pools.
 ///
 /// Allocated chunks can be reused for new allocations if Clear() is called to free
 /// all allocations or ReturnPartialAllocation() is called to return part of the last
@@ -188,16 +191,27 @@ class MemPool {
   struct ChunkInfo {
     uint8_t* data; // Owned by the ChunkInfo.
     int64_t size;  // in bytes
+    /// core of the ChunkAllocator free list the chunk goes back to
+    int core_id;
 
     /// bytes allocated via Allocate() in this chunk
     int64_t allocated_bytes;
 
-    explicit ChunkInfo(int64_t size, uint8_t* buf);
+    explicit ChunkInfo(const Chunk& chunk);
 
     ChunkInfo()
       : data(NULL),
         size(0),
+        core_id(-1),
         allocated_bytes(0) {}
+
+    Chunk chunk() const {
+      Chunk chunk;
+      chunk.data = data;
+      chunk.size = size;
+      chunk.core_id = core_id;
+      return chunk;
+    }
   };
 
   /// A static field used as non-NULL pointer for zero length allocations. NULL is
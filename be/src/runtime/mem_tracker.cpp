@@ -21,12 +21,14 @@
 #include "runtime/mem_tracker.h"
 
 #include <stdint.h>
+#include <algorithm>
 #include <limits>
 #include <memory>
 //#include <boost/lexical_cast.hpp>
 //#include <boost/shared_ptr.hpp>
 //include <boost/weak_ptr.hpp>
 
+#include "common/config.h"
 #include "gutil/strings/substitute.h"
 #include "runtime/exec_env.h"
 #include "runtime/runtime_state.h"
@@ -47,6 +49,109 @@ namespace palo {
 
 const std::string MemTracker::COUNTER_NAME = "PeakMemoryUsage";
 
+const int ScopedMemTrackerCache::NUM_ENTRIES;
+__thread ScopedMemTrackerCache* ScopedMemTrackerCache::_s_current = NULL;
+
+ScopedMemTrackerCache::ScopedMemTrackerCache()
+    : _active(_s_current == NULL),
+    _batch_bytes(config::mem_tracker_consume_batch_bytes),
+    _num_entries(0) {
+    if (_active) _s_current = this;
+}
+
+ScopedMemTrackerCache::~ScopedMemTrackerCache() {
+    if (!_active) return;
+    flush();
+    _s_current = NULL;
+}
+
+void ScopedMemTrackerCache::flush() {
+    for (int i = 0; i < _num_entries; ++i) {
+        _entries[i].tracker->release_direct(_entries[i].reserved);
+        --_entries[i].tracker->_num_caches;
+    }
+    _num_entries = 0;
+}
+
+void ScopedMemTrackerCache::remove(MemTracker* tracker) {
+    for (int i = 0; i < _num_entries; ++i) {
+        if (_entries[i].tracker != tracker) continue;
+        tracker->release_direct(_entries[i].reserved);
+        --tracker->_num_caches;
+        _entries[i] = _entries[--_num_entries];
+        return;
+    }
+}
+
+ScopedMemTrackerCache::Entry* ScopedMemTrackerCache::find_entry(MemTracker* tracker) {
+    for (int i = 0; i < _num_entries; ++i) {
+        if (_entries[i].tracker == tracker) return &_entries[i];
+    }
+    if (_num_entries == NUM_ENTRIES) {
+        _entries[0].tracker->release_direct(_entries[0].reserved);
+        --_entries[0].tracker->_num_caches;
+        std::copy(_entries + 1, _entries + NUM_ENTRIES, _entries);
+        --_num_entries;
+    }
+    Entry* entry = &_entries[_num_entries++];
+    entry->tracker = tracker;
+    entry->reserved = 0;
+    ++tracker->_num_caches;
+    return entry;
+}
+
+void ScopedMemTrackerCache::consume(MemTracker* tracker, int64_t bytes) {
+    if (bytes <= 0) {
+        if (bytes < 0) release(tracker, -bytes);
+        return;
+    }
+    if (bytes >= _batch_bytes) {
+        tracker->consume_direct(bytes);
+        return;
+    }
+    Entry* entry = find_entry(tracker);
+    if (entry->reserved < bytes) {
+        int64_t refill = _batch_bytes + bytes - entry->reserved;
+        tracker->consume_direct(refill);
+        entry->reserved += refill;
+    }
+    entry->reserved -= bytes;
+}
+
+bool ScopedMemTrackerCache::try_consume(MemTracker* tracker, int64_t bytes) {
+    if (bytes <= 0) return true;
+    if (bytes >= _batch_bytes) return tracker->try_consume_direct(bytes);
+    Entry* entry = find_entry(tracker);
+    if (entry->reserved < bytes) {
+        int64_t refill = _batch_bytes + bytes - entry->reserved;
+        if (tracker->spare_capacity() < refill || !tracker->try_consume_direct(refill)) {
+            // Close to a limit: take only the missing bytes, which may GC.
+            refill = bytes - entry->reserved;
+            if (!tracker->try_consume_direct(refill)) return false;
+        }
+        entry->reserved += refill;
+    }
+    entry->reserved -= bytes;
+    return true;
+}
+
+void ScopedMemTrackerCache::release(MemTracker* tracker, int64_t bytes) {
+    if (bytes <= 0) {
+        if (bytes < 0) consume(tracker, -bytes);
+        return;
+    }
+    if (bytes >= _batch_bytes) {
+        tracker->release_direct(bytes);
+        return;
+    }
+    Entry* entry = find_entry(tracker);
+    entry->reserved += bytes;
+    if (entry->reserved > 2 * _batch_bytes) {
+        tracker->release_direct(entry->reserved - _batch_bytes);
+        entry->reserved = _batch_bytes;
+    }
+}
+
 // Name for request pool MemTrackers. '$0' is replaced with the pool name.
 const std::string REQUEST_POOL_MEM_TRACKER_LABEL_FORMAT = "RequestPool=$0";
 
@@ -115,6 +220,9 @@ void MemTracker::Init() {
 
 // TODO chenhao , set MemTracker close state
 void MemTracker::close() {
+    ScopedMemTrackerCache* cache = ScopedMemTrackerCache::current();
+    if (cache != NULL) cache->remove(this);
+    DCHECK_EQ(_num_caches.load(), 0) << _label << " is still cached by another thread";
 }
 
 void MemTracker::enable_reservation_reporting(const ReservationTrackerCounters& counters) {
@@ -185,6 +293,9 @@ MemTracker* MemTracker::CreateQueryMemTracker(const TUniqueId& id,
 }
 
 MemTracker::~MemTracker() {
+    ScopedMemTrackerCache* cache = ScopedMemTrackerCache::current();
+    if (cache != NULL) cache->remove(this);
+    DCHECK_EQ(_num_caches.load(), 0) << _label << " is still cached by another thread";
     DCHECK_EQ(_consumption->current_value(), 0) << _label << "\n"
         << get_stack_trace() << "\n"
         << LogUsage("");
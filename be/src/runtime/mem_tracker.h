@@ -41,6 +41,65 @@ class ReservationTrackerCounters;
 class RuntimeState;
 class TQueryOptions;
 
+/// Batches the consume()/release()/try_consume() calls the current thread makes on
+/// MemTrackers while the scope is alive, so that threads working for one query do not
+/// update the counters of the query and process trackers on every allocation.
+///
+/// For each of the trackers it used last, the thread keeps some headroom consumed on
+/// the tracker and its ancestors, up to about config::mem_tracker_consume_batch_bytes,
+/// and serves smaller consumptions and releases from it. The counters of the trackers
+/// therefore include the headroom held by the threads: limits are checked against more
+/// than the memory really used, never less. Close to a limit, only the missing bytes
+/// are consumed. Consumptions of at least the batch size go to the trackers directly.
+///
+/// The headroom is given back by flush() and when the scope ends. A tracker closed or
+/// destroyed by the thread of the scope gives it back too, but the scopes of other
+/// threads are not reachable from the tracker: a tracker must only be used in the
+/// scopes that end before it is closed, which is DCHECKed. Scopes do not nest: an
+/// inner scope does nothing.
+class ScopedMemTrackerCache {
+public:
+    ScopedMemTrackerCache();
+    ~ScopedMemTrackerCache();
+
+    /// Gives back the headroom held on all trackers.
+    void flush();
+
+    /// Returns the scope of the current thread, NULL if there is none.
+    static ScopedMemTrackerCache* current() {
+        return _s_current;
+    }
+
+private:
+    friend class MemTracker;
+
+    static const int NUM_ENTRIES = 4;
+
+    struct Entry {
+        MemTracker* tracker;
+        /// bytes consumed on 'tracker' and not handed out yet
+        int64_t reserved;
+    };
+
+    void consume(MemTracker* tracker, int64_t bytes);
+    bool try_consume(MemTracker* tracker, int64_t bytes);
+    void release(MemTracker* tracker, int64_t bytes);
+
+    /// Gives back the headroom held on 'tracker', which is being closed.
+    void remove(MemTracker* tracker);
+
+    /// Returns the entry of 'tracker', evicting the oldest entry if all are in use.
+    Entry* find_entry(MemTracker* tracker);
+
+    static __thread ScopedMemTrackerCache* _s_current;
+
+    /// false for an inner scope
+    bool _active;
+    int64_t _batch_bytes;
+    int _num_entries;
+    Entry _entries[NUM_ENTRIES];
+};
+
 /// A MemTracker tracks memory consumption; it contains an optional limit
 /// and can be arranged into a tree structure such that the consumption tracked
 /// by a MemTracker is also tracked by its ancestors.
@@ -127,8 +186,18 @@ public:
             int64_t byte_limit, MemTracker* parent);
 
     void consume(int64_t bytes) {
+        ScopedMemTrackerCache* cache = ScopedMemTrackerCache::current();
+        if (cache != NULL && _consumption_metric == NULL) {
+            cache->consume(this, bytes);
+            return;
+        }
+        consume_direct(bytes);
+    }
+
+    /// Like consume(), but bypasses the ScopedMemTrackerCache of the thread.
+    void consume_direct(int64_t bytes) {
         if (bytes <= 0) {
-            if (bytes < 0) release(-bytes);
+            if (bytes < 0) release_direct(-bytes);
             return;
         }
 
@@ -170,6 +239,16 @@ public:
     /// Returns true if the try succeeded.
     WARN_UNUSED_RESULT
     bool try_consume(int64_t bytes) {
+        ScopedMemTrackerCache* cache = ScopedMemTrackerCache::current();
+        if (cache != NULL && _consumption_metric == NULL) {
+            return cache->try_consume(this, bytes);
+        }
+        return try_consume_direct(bytes);
+    }
+
+    /// Like try_consume(), but bypasses the ScopedMemTrackerCache of the thread.
+    WARN_UNUSED_RESULT
+    bool try_consume_direct(int64_t bytes) {
         if (_consumption_metric != NULL) RefreshConsumptionFromMetric();
         if (UNLIKELY(bytes <= 0)) return true;
         int i;
@@ -210,8 +289,18 @@ public:
 
     /// Decreases consumption of this tracker and its ancestors by 'bytes'.
     void release(int64_t bytes) {
+        ScopedMemTrackerCache* cache = ScopedMemTrackerCache::current();
+        if (cache != NULL && _consumption_metric == NULL) {
+            cache->release(this, bytes);
+            return;
+        }
+        release_direct(bytes);
+    }
+
+    /// Like release(), but bypasses the ScopedMemTrackerCache of the thread.
+    void release_direct(int64_t bytes) {
         if (bytes <= 0) {
-            if (bytes < 0) consume(-bytes);
+            if (bytes < 0) consume_direct(-bytes);
             return;
         }
 
@@ -451,6 +540,9 @@ private:
     /// are owned by the fragment's RuntimeProfile.
     AtomicPtr<ReservationTrackerCounters> _reservation_counters;
 
+    /// Number of ScopedMemTrackerCache holding headroom on this tracker.
+    AtomicInt<int32_t> _num_caches;
+
     std::vector<MemTracker*> _all_trackers;  // this tracker plus all of its ancestors
     std::vector<MemTracker*> _limit_trackers;  // _all_trackers with valid limits
 
@@ -20,6 +20,8 @@
 
 #include "runtime/plan_fragment_executor.h"
 
+#include <sstream>
+
 #include <thrift/protocol/TDebugProtocol.h>
 #include <boost/date_time/posix_time/posix_time_types.hpp>
 #include <boost/unordered_map.hpp>
@@ -33,12 +35,15 @@
 #include "exec/exchange_node.h"
 #include "exec/scan_node.h"
 #include "exprs/expr.h"
+#include "gen_cpp/FrontendService_types.h"
 #include "runtime/exec_env.h"
 #include "runtime/descriptors.h"
+#include "runtime/fragment_status_reporter.h"
 #include "runtime/data_stream_mgr.h"
 #include "runtime/result_buffer_mgr.h"
 #include "runtime/row_batch.h"
 #include "runtime/mem_tracker.h"
+#include "service/backend_options.h"
 #include "util/cpu_info.h"
 #include "util/debug_util.h"
 #include "util/container_util.hpp"
@@ -52,7 +57,7 @@ PlanFragmentExecutor::PlanFragmentExecutor(
     ExecEnv* exec_env, const report_status_callback& report_status_cb)
     : _exec_env(exec_env),
       _report_status_cb(report_status_cb),
-      _report_thread_active(false),
+      _periodic_reports_active(false),
       _done(false),
       _prepared(false),
       _closed(false),
@@ -64,13 +69,17 @@ PlanFragmentExecutor::~PlanFragmentExecutor() {
     // if (_prepared) {
     close();
     // }
-    // at this point, the report thread should have been stopped
-    DCHECK(!_report_thread_active);
+    // at this point, the periodic reports should have been stopped
+    DCHECK(!_periodic_reports_active);
 }
 
-Status PlanFragmentExecutor::prepare(const TExecPlanFragmentParams& request) {
+Status PlanFragmentExecutor::prepare(const TExecPlanFragmentParams& request,
+                                     DescriptorTbl* desc_tbl) {
     const TPlanFragmentExecParams& params = request.params;
     _query_id = params.query_id;
+    if (request.__isset.coord) {
+        _coord_addr = request.coord;
+    }
 
     LOG(INFO) << "Prepare(): query_id=" << print_id(_query_id)
                << " instance_id=" << print_id(params.fragment_instance_id)
@@ -136,9 +145,10 @@ Status PlanFragmentExecutor::prepare(const TExecPlanFragmentParams& request) {
     RETURN_IF_ERROR(_runtime_state->create_block_mgr());
 
     // set up desc tbl
-    DescriptorTbl* desc_tbl = NULL;
-    DCHECK(request.__isset.desc_tbl);
-    RETURN_IF_ERROR(DescriptorTbl::create(obj_pool(), request.desc_tbl, &desc_tbl));
+    if (desc_tbl == NULL) {
+        DCHECK(request.__isset.desc_tbl);
+        RETURN_IF_ERROR(DescriptorTbl::create(obj_pool(), request.desc_tbl, &desc_tbl));
+    }
     _runtime_state->set_desc_tbl(desc_tbl);
 
     // set up plan
@@ -257,17 +267,13 @@ void PlanFragmentExecutor::print_volume_ids(
 Status PlanFragmentExecutor::open() {
     LOG(INFO) << "Open(): instance_id=" << _runtime_state->fragment_instance_id();
 
-    // we need to start the profile-reporting thread before calling Open(), since it
+    // we need to start the periodic reports before calling Open(), since it
     // may block
-    // TODO: if no report thread is started, make sure to send a final profile
+    // TODO: if no periodic report is started, make sure to send a final profile
     // at end, otherwise the coordinator hangs in case we finish w/ an error
     if (_is_report_success && !_report_status_cb.empty() && config::status_report_interval > 0) {
-        boost::unique_lock<boost::mutex> l(_report_thread_lock);
-        _report_thread = boost::thread(&PlanFragmentExecutor::report_profile, this);
-        // make sure the thread started up, otherwise report_profile() might get into a race
-        // with stop_report_thread()
-        _report_thread_started_cv.wait(l);
-        _report_thread_active = true;
+        _exec_env->fragment_status_reporter()->register_fragment(this);
+        _periodic_reports_active = true;
     }
 
     optimize_llvm_module();
@@ -321,7 +327,7 @@ Status PlanFragmentExecutor::open_internal() {
         RETURN_IF_ERROR(_sink->send(runtime_state(), batch));
     }
 
-    // Close the sink *before* stopping the report thread. Close may
+    // Close the sink *before* stopping the periodic reports. Close may
     // need to add some important information to the last report that
     // gets sent. (e.g. table sinks record the files they have written
     // to in this method)
@@ -344,60 +350,12 @@ Status PlanFragmentExecutor::open_internal() {
 
     release_thread_token();
 
-    stop_report_thread();
+    stop_periodic_reports();
     send_report(true);
 
     return Status::OK;
 }
 
-void PlanFragmentExecutor::report_profile() {
-    VLOG_FILE << "report_profile(): instance_id="
-              << _runtime_state->fragment_instance_id();
-    DCHECK(!_report_status_cb.empty());
-    boost::unique_lock<boost::mutex> l(_report_thread_lock);
-    // tell Open() that we started
-    _report_thread_started_cv.notify_one();
-
-    // Jitter the reporting time of remote fragments by a random amount between
-    // 0 and the report_interval.  This way, the coordinator doesn't get all the
-    // updates at once so its better for contention as well as smoother progress
-    // reporting.
-    int report_fragment_offset = rand() % config::status_report_interval;
-    boost::system_time timeout =
-        boost::get_system_time() + boost::posix_time::seconds(report_fragment_offset);
-    // We don't want to wait longer than it takes to run the entire fragment.
-    _stop_report_thread_cv.timed_wait(l, timeout);
-
-    while (_report_thread_active) {
-        boost::system_time timeout =
-            boost::get_system_time() + boost::posix_time::seconds(config::status_report_interval);
-
-        // timed_wait can return because the timeout occurred or the condition variable
-        // was signaled.  We can't rely on its return value to distinguish between the
-        // two cases (e.g. there is a race here where the wait timed out but before grabbing
-        // the lock, the condition variable was signaled).  Instead, we will use an external
-        // flag, _report_thread_active, to coordinate this.
-        _stop_report_thread_cv.timed_wait(l, timeout);
-
-        if (VLOG_FILE_IS_ON) {
-            VLOG_FILE << "Reporting " << (!_report_thread_active ? "final " : " ")
-                      << "profile for instance " << _runtime_state->fragment_instance_id();
-            std::stringstream ss;
-            profile()->pretty_print(&ss);
-            VLOG_FILE << ss.str();
-        }
-
-        if (!_report_thread_active) {
-            break;
-        }
-
-        send_report(false);
-    }
-
-    VLOG_FILE << "exiting reporting thread: instance_id="
-              << _runtime_state->fragment_instance_id();
-}
-
 void PlanFragmentExecutor::send_report(bool done) {
     if (_report_status_cb.empty()) {
         return;
@@ -419,18 +377,79 @@ void PlanFragmentExecutor::send_report(bool done) {
     _report_status_cb(status, profile(), done || !status.ok());
 }
 
-void PlanFragmentExecutor::stop_report_thread() {
-    if (!_report_thread_active) {
-        return;
+void PlanFragmentExecutor::get_report_params(TReportExecStatusParams* params) {
+    Status status;
+    {
+        boost::lock_guard<boost::mutex> l(_status_lock);
+        status = _status;
     }
 
-    {
-        boost::lock_guard<boost::mutex> l(_report_thread_lock);
-        _report_thread_active = false;
+    params->protocol_version = FrontendServiceVersion::V1;
+    params->__set_query_id(_query_id);
+    params->__set_backend_num(_runtime_state->be_number());
+    params->__set_fragment_instance_id(_runtime_state->fragment_instance_id());
+    status.set_t_status(params);
+    // only the final report, which send_report() sends, is done
+    params->__set_done(false);
+    profile()->to_thrift(&params->profile);
+    params->__isset.profile = true;
+    get_load_report_params(params);
+    _runtime_state->get_unreported_errors(&params->error_log);
+    params->__isset.error_log = !params->error_log.empty();
+}
+
+void PlanFragmentExecutor::get_load_report_params(TReportExecStatusParams* params) {
+    if (!_runtime_state->output_files().empty()) {
+        params->__isset.delta_urls = true;
+        for (auto& it : _runtime_state->output_files()) {
+            params->delta_urls.push_back(to_http_path(it));
+        }
     }
+    if (_runtime_state->num_rows_load_success() > 0 ||
+            _runtime_state->num_rows_load_filtered() > 0) {
+        params->__isset.load_counters = true;
+        // TODO(zc)
+        static std::string s_dpp_normal_all = "dpp.norm.ALL";
+        static std::string s_dpp_abnormal_all = "dpp.abnorm.ALL";
 
-    _stop_report_thread_cv.notify_one();
-    _report_thread.join();
+        params->load_counters.emplace(
+            s_dpp_normal_all, std::to_string(_runtime_state->num_rows_load_success()));
+        params->load_counters.emplace(
+            s_dpp_abnormal_all, std::to_string(_runtime_state->num_rows_load_filtered()));
+    }
+    if (!_runtime_state->get_error_log_file_path().empty()) {
+        params->__set_tracking_url(
+                to_load_error_http_path(_runtime_state->get_error_log_file_path()));
+    }
+    if (!_runtime_state->export_output_files().empty()) {
+        params->__isset.export_files = true;
+        params->export_files = _runtime_state->export_output_files();
+    }
+}
+
+std::string PlanFragmentExecutor::to_http_path(const std::string& file_name) {
+    std::stringstream url;
+    url << "http://" << BackendOptions::get_localhost() << ":" << config::webserver_port
+        << "/api/_download_load?"
+        << "token=" << _exec_env->token()
+        << "&file=" << file_name;
+    return url.str();
+}
+
+std::string PlanFragmentExecutor::to_load_error_http_path(const std::string& file_name) {
+    std::stringstream url;
+    url << "http://" << BackendOptions::get_localhost() << ":" << config::webserver_port
+        << "/api/_load_error_log?"
+        << "file=" << file_name;
+    return url.str();
+}
+
+void PlanFragmentExecutor::stop_periodic_reports() {
+    if (!_periodic_reports_active) {
+        return;
+    }
+    _periodic_reports_active = false;
+    _exec_env->fragment_status_reporter()->unregister_fragment(this);
 }
 
 Status PlanFragmentExecutor::get_next(RowBatch** batch) {
@@ -443,7 +462,7 @@ Status PlanFragmentExecutor::get_next(RowBatch** batch) {
                    << " instance_id=" << print_id(_runtime_state->fragment_instance_id());
         // Query is done, return the thread token
         release_thread_token();
-        stop_report_thread();
+        stop_periodic_reports();
         send_report(true);
     }
 
@@ -489,7 +508,7 @@ void PlanFragmentExecutor::update_status(const Status& status) {
         }
     }
 
-    stop_report_thread();
+    stop_periodic_reports();
     send_report(true);
 }
 
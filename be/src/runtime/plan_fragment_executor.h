@@ -43,6 +43,7 @@ class TPlanExecRequest;
 class TPlanFragment;
 class TPlanFragmentExecParams;
 class TPlanExecParams;
+class TReportExecStatusParams;
 
 // PlanFragmentExecutor handles all aspects of the execution of a single plan fragment,
 // including setup and tear-down, both in the success and error case.
@@ -52,9 +53,10 @@ class TPlanExecParams;
 // The executor makes an aggregated profile for the entire fragment available,
 // which includes profile information for the plan itself as well as the output
 // sink, if any.
-// The ReportStatusCallback passed into the c'tor is invoked periodically to report the
-// execution status. The frequency of those reports is controlled by the flag
-// status_report_interval; setting that flag to 0 disables periodic reporting altogether
+// While a report callback is specified, the execution status is also reported
+// periodically by the FragmentStatusReporter of the ExecEnv. The frequency of those
+// reports is controlled by the flag status_report_interval; setting that flag to 0
+// disables periodic reporting altogether.
 // Regardless of the value of that flag, if a report callback is specified, it is
 // invoked at least once at the end of execution with an overall status and profile
 // (and 'done' indicator). The only exception is when execution is cancelled, in which
@@ -75,8 +77,8 @@ public:
     void (const Status& status, RuntimeProfile* profile, bool done) >
     report_status_callback;
 
-    // report_status_cb, if !empty(), is used to report the accumulated profile
-    // information periodically during execution (open() or get_next()).
+    // report_status_cb, if !empty(), is used to report the final status and profile;
+    // it also enables the periodic reports during execution (open() or get_next()).
     PlanFragmentExecutor(ExecEnv* exec_env, const report_status_callback& report_status_cb);
 
     // Closes the underlying plan fragment and frees up all resources allocated
@@ -92,23 +94,26 @@ public:
     // If request.query_options.mem_limit > 0, it is used as an approximate limit on the
     // number of bytes this query can consume at runtime.
     // The query will be aborted (MEM_LIMIT_EXCEEDED) if it goes over that limit.
-    Status prepare(const TExecPlanFragmentParams& request);
+    // If 'desc_tbl' is not NULL it is used instead of building the descriptor table of
+    // the request; it is shared with other instances of the query and must outlive
+    // this executor.
+    Status prepare(const TExecPlanFragmentParams& request, DescriptorTbl* desc_tbl = NULL);
 
     // Start execution. Call this prior to get_next().
     // If this fragment has a sink, open() will send all rows produced
     // by the fragment to that sink. Therefore, open() may block until
     // all rows are produced (and a subsequent call to get_next() will not return
     // any rows).
-    // This also starts the status-reporting thread, if the interval flag
+    // This also starts the periodic status reports, if the interval flag
     // is > 0 and a callback was specified in the c'tor.
     // If this fragment has a sink, report_status_cb will have been called for the final
-    // time when open() returns, and the status-reporting thread will have been stopped.
+    // time when open() returns, and the periodic reports will have been stopped.
     Status open();
 
     // Return results through 'batch'. Sets '*batch' to NULL if no more results.
     // '*batch' is owned by PlanFragmentExecutor and must not be deleted.
     // When *batch == NULL, get_next() should not be called anymore. Also, report_status_cb
-    // will have been called for the final time and the status-reporting thread
+    // will have been called for the final time and the periodic reports
     // will have been stopped.
     Status get_next(RowBatch** batch);
 
@@ -138,26 +143,35 @@ public:
     DataSink* get_sink() {
         return _sink.get();
     }
+
+    // Coordinator of this fragment, valid after prepare().
+    const TNetworkAddress& coord_addr() const {
+        return _coord_addr;
+    }
+
+    // Fills 'params' with a periodic status report of this fragment: its ids, status,
+    // new errors and cumulative profile. Called by the FragmentStatusReporter.
+    void get_report_params(TReportExecStatusParams* params);
+
+    // Fills the load and export results of 'params': load counters, delta urls,
+    // tracking url and export files. Shared by the periodic and the final reports.
+    void get_load_report_params(TReportExecStatusParams* params);
+
 private:
+    std::string to_http_path(const std::string& file_name);
+    std::string to_load_error_http_path(const std::string& file_name);
+
     ExecEnv* _exec_env;  // not owned
     ExecNode* _plan;  // lives in _runtime_state->obj_pool()
     TUniqueId _query_id;
+    TNetworkAddress _coord_addr;
     // MemTracker* _mem_tracker;
     boost::scoped_ptr<MemTracker> _mem_tracker;
 
     // profile reporting-related
     report_status_callback _report_status_cb;
-    boost::thread _report_thread;
-    boost::mutex _report_thread_lock;
-
-    // Indicates that profile reporting thread should stop.
-    // Tied to _report_thread_lock.
-    boost::condition_variable _stop_report_thread_cv;
-
-    // Indicates that profile reporting thread started.
-    // Tied to _report_thread_lock.
-    boost::condition_variable _report_thread_started_cv;
-    bool _report_thread_active;  // true if we started the thread
+    // true if this fragment is registered with the FragmentStatusReporter
+    bool _periodic_reports_active;
 
     // true if _plan->get_next() indicated that it's done
     bool _done;
@@ -178,9 +192,6 @@ private:
     Status _status;
 
     // Protects _status
-    // lock ordering:
-    // 1. _report_thread_lock
-    // 2. _status_lock
     boost::mutex _status_lock;
 
     // Output sink for rows sent to this fragment. May not be set, in which case rows are
@@ -209,18 +220,13 @@ private:
     // typedef for TPlanFragmentExecParams.per_node_scan_ranges
     typedef std::map<TPlanNodeId, std::vector<TScanRangeParams> > PerNodeScanRanges;
 
-    // Main loop of profile reporting thread.
-    // Exits when notified on _done_cv.
-    // On exit, *no report is sent*, ie, this will not send the final report.
-    void report_profile();
-
     // Invoked the report callback if there is a report callback and the current
     // status isn't CANCELLED. Sets 'done' to true in the callback invocation if
     // done == true or we have an error status.
     void send_report(bool done);
 
     // If _status.ok(), sets _status to status.
-    // If we're transitioning to an error status, stops report thread and
+    // If we're transitioning to an error status, stops the periodic reports and
     // sends a final report.
     void update_status(const Status& status);
 
@@ -236,16 +242,16 @@ private:
     // If this plan fragment has no sink, open_internal() does nothing.
     // If this plan fragment has a sink and open_internal() returns without an
     // error condition, all rows will have been sent to the sink, the sink will
-    // have been closed, a final report will have been sent and the report thread will
+    // have been closed, a final report will have been sent and the periodic reports will
     // have been stopped. _sink will be set to NULL after successful execution.
     Status open_internal();
 
     // Executes get_next() logic and returns resulting status.
     Status get_next_internal(RowBatch** batch);
 
-    // Stops report thread, if one is running. Blocks until report thread terminates.
-    // Idempotent.
-    void stop_report_thread();
+    // Stops the periodic reports, if they were started. Blocks until a report being
+    // sent is done. Idempotent.
+    void stop_periodic_reports();
 
     // Print stats about scan ranges for each volumeId in params to info log.
     void print_volume_ids(const TPlanExecParams& params);
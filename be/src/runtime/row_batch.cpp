@@ -25,6 +25,7 @@
 
 #include "runtime/exec_env.h"
 #include "runtime/runtime_state.h"
+#include "runtime/string_dictionary.h"
 #include "runtime/string_value.h"
 #include "runtime/tuple_row.h"
 #include "runtime/buffered_tuple_stream2.inline.h"
@@ -307,6 +308,10 @@ int RowBatch::serialize(TRowBatch* output_batch) {
     // pointers into offsets in the process)
     int offset = 0; // current offset into output_batch->tuple_data
     char* tuple_data = const_cast<char*>(output_batch->tuple_data.c_str());
+    bool use_dict = config::rowbatch_string_dict_max_entries > 0
+            && _row_desc.has_varlen_slots();
+    StringDictionary string_dict(config::rowbatch_string_dict_max_entries);
+    int saved_bytes = 0;
 
     for (int i = 0; i < _num_rows; ++i) {
         TupleRow* row = get_row(i);
@@ -322,12 +327,25 @@ int RowBatch::serialize(TRowBatch* output_batch) {
 
             // Record offset before creating copy (which increments offset and tuple_data)
             output_batch->tuple_offsets.push_back(offset);
-            row->get_tuple(j)->deep_copy(**desc, &tuple_data, &offset, /* convert_ptrs */ true);
+            if (use_dict) {
+                saved_bytes += row->get_tuple(j)->deep_copy_with_dict(
+                    **desc, &tuple_data, &offset, &string_dict);
+                // a full dictionary means many distinct values, stop paying for lookups
+                use_dict = !string_dict.is_full();
+            } else {
+                row->get_tuple(j)->deep_copy(**desc, &tuple_data, &offset, /* convert_ptrs */ true);
+            }
             DCHECK_LE(offset, size);
         }
     }
 
-    DCHECK_EQ(offset, size);
+    // Repeated string values were written only once, so the serialized data
+    // may be shorter than total_byte_size().
+    DCHECK_EQ(offset + saved_bytes, size);
+    if (saved_bytes > 0) {
+        size -= saved_bytes;
+        output_batch->tuple_data.resize(size);
+    }
 
     if (config::compress_rowbatches && size > 0) {
         // Try compressing tuple_data to _compression_scratch, swap if compressed data is
@@ -376,6 +394,10 @@ int RowBatch::serialize(PRowBatch* output_batch) {
     // pointers into offsets in the process)
     int offset = 0; // current offset into output_batch->tuple_data
     char* tuple_data = const_cast<char*>(mutable_tuple_data->data());
+    bool use_dict = config::rowbatch_string_dict_max_entries > 0
+            && _row_desc.has_varlen_slots();
+    StringDictionary string_dict(config::rowbatch_string_dict_max_entries);
+    int saved_bytes = 0;
     for (int i = 0; i < _num_rows; ++i) {
         TupleRow* row = get_row(i);
         const vector<TupleDescriptor*>& tuple_descs = _row_desc.tuple_descriptors();
@@ -390,12 +412,25 @@ int RowBatch::serialize(PRowBatch* output_batch) {
 
             // Record offset before creating copy (which increments offset and tuple_data)
             output_batch->mutable_tuple_offsets()->Add(offset);
-            row->get_tuple(j)->deep_copy(**desc, &tuple_data, &offset, /* convert_ptrs */ true);
+            if (use_dict) {
+                saved_bytes += row->get_tuple(j)->deep_copy_with_dict(
+                    **desc, &tuple_data, &offset, &string_dict);
+                // a full dictionary means many distinct values, stop paying for lookups
+                use_dict = !string_dict.is_full();
+            } else {
+                row->get_tuple(j)->deep_copy(**desc, &tuple_data, &offset, /* convert_ptrs */ true);
+            }
             DCHECK_LE(offset, size);
         }
     }
 
-    DCHECK_EQ(offset, size);
+    // Repeated string values were written only once, so the serialized data
+    // may be shorter than total_byte_size().
+    DCHECK_EQ(offset + saved_bytes, size);
+    if (saved_bytes > 0) {
+        size -= saved_bytes;
+        mutable_tuple_data->resize(size);
+    }
 
     if (config::compress_rowbatches && size > 0) {
         // Try compressing tuple_data to _compression_scratch, swap if compressed data is
@@ -596,6 +631,20 @@ void RowBatch::acquire_state(RowBatch* src) {
     src->transfer_resource_ownership(this);
 }
 
+void RowBatch::deep_copy_to(RowBatch* dst) {
+    DCHECK(dst->_row_desc.equals(_row_desc));
+    DCHECK_EQ(dst->_num_rows, 0);
+    DCHECK_GE(dst->_capacity, _num_rows);
+    dst->add_rows(_num_rows);
+    for (int i = 0; i < _num_rows; ++i) {
+        TupleRow* src_row = get_row(i);
+        TupleRow* dst_row = dst->get_row(i);
+        src_row->deep_copy(dst_row, _row_desc.tuple_descriptors(),
+                           dst->_tuple_data_pool.get(), false);
+    }
+    dst->commit_rows(_num_rows);
+}
+
 void RowBatch::swap(RowBatch* other) {
     DCHECK(_row_desc.equals(other->_row_desc));
     DCHECK_EQ(_num_tuples_per_row, other->_num_tuples_per_row);
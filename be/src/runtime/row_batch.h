@@ -366,6 +366,9 @@ public:
     // data it references to output_batch.tuple_data. output_batch.tuple_data will be
     // snappy-compressed unless the compressed data is larger than the uncompressed
     // data. Use output_batch.is_compressed to determine whether tuple_data is compressed.
+    // Repeated string values of low-cardinality columns are stored only once in
+    // tuple_data (see config::rowbatch_string_dict_max_entries); the receiving side
+    // needs no change, since every string slot still holds an offset into tuple_data.
     // If an in-flight row is present in this row batch, it is ignored.
     // This function does not reset().
     // Returns the uncompressed serialized size (this will be the true size of output_batch
@@ -581,6 +581,8 @@ private:
     int64_t _normal_row_number;
     int64_t _error_row_number;
     std::string _error_log_file_path;
+    // Lock protecting _error_log_file, scanners of a load may append errors in parallel
+    boost::mutex _error_log_file_lock;
     std::ofstream* _error_log_file; // error file path, absolute path
     std::unique_ptr<LoadErrorHub> _error_hub;
 
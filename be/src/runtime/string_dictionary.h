@@ -0,0 +1,70 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_RUNTIME_STRING_DICTIONARY_H
+#define BDG_PALO_BE_RUNTIME_STRING_DICTIONARY_H
+
+#include <boost/unordered_set.hpp>
+
+#include "runtime/string_value.hpp"
+
+namespace palo {
+
+// Bounded set of the distinct string values already written to a buffer, used by
+// RowBatch::serialize() to write each value of a batch once: a later occurrence
+// refers to the earlier copy. It is meant for low-cardinality string columns, so
+// the number of entries is bounded by 'max_entries'; once the dictionary is full,
+// new values are rejected and callers copy values as usual.
+//
+// The dictionary does not copy the string data: inserted values must stay valid
+// for as long as the dictionary is used.
+class StringDictionary {
+public:
+    explicit StringDictionary(int max_entries) : _max_entries(max_entries) { }
+
+    // Returns the inserted value equal to 'value', or NULL if there is none.
+    const StringValue* find(const StringValue& value) const {
+        ValueSet::const_iterator it = _values.find(value);
+        return it == _values.end() ? NULL : &*it;
+    }
+
+    // Adds 'value', which must not be in the dictionary yet. Returns false if the
+    // dictionary is full.
+    bool insert(const StringValue& value) {
+        if (is_full()) {
+            return false;
+        }
+        _values.insert(value);
+        return true;
+    }
+
+    int size() const { return _values.size(); }
+
+    bool is_full() const { return size() >= _max_entries; }
+
+    void clear() {
+        _values.clear();
+    }
+
+private:
+    typedef boost::unordered_set<StringValue> ValueSet;
+
+    const int _max_entries;
+    ValueSet _values;
+};
+
+}
+
+#endif
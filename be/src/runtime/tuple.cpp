@@ -29,6 +29,7 @@
 #include "runtime/raw_value.h"
 #include "runtime/tuple_row.h"
 #include "runtime/string_value.h"
+#include "runtime/string_dictionary.h"
 #include "util/debug_util.h"
 
 namespace palo {
@@ -148,6 +149,41 @@ void Tuple::deep_copy(const TupleDescriptor& desc, char** data, int* offset,
     }
 }
 
+int Tuple::deep_copy_with_dict(const TupleDescriptor& desc, char** data, int* offset,
+                               StringDictionary* dict) {
+    Tuple* dst = reinterpret_cast<Tuple*>(*data);
+    memory_copy(dst, this, desc.byte_size());
+    // start of the buffer that offsets are relative to
+    char* base = *data - *offset;
+    *data += desc.byte_size();
+    *offset += desc.byte_size();
+
+    int saved_bytes = 0;
+    for (auto slot : desc.string_slots()) {
+        DCHECK(slot->type().is_string_type());
+        if (dst->is_null(slot->null_indicator_offset())) {
+            continue;
+        }
+        StringValue* string_v = dst->get_string_slot(slot->tuple_offset());
+        if (string_v->len != 0 && !dict->is_full()) {
+            const StringValue* copied = dict->find(*string_v);
+            if (copied != NULL) {
+                string_v->ptr = reinterpret_cast<char*>(copied->ptr - base);
+                saved_bytes += string_v->len;
+                continue;
+            }
+        }
+        memory_copy(*data, string_v->ptr, string_v->len);
+        if (string_v->len != 0 && !dict->is_full()) {
+            dict->insert(StringValue(*data, string_v->len));
+        }
+        string_v->ptr = reinterpret_cast<char*>(*offset);
+        *data += string_v->len;
+        *offset += string_v->len;
+    }
+    return saved_bytes;
+}
+
 template <bool collect_string_vals>
 void Tuple::materialize_exprs(
     TupleRow* row, const TupleDescriptor& desc,
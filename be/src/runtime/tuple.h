@@ -29,6 +29,7 @@
 namespace palo {
 
 struct StringValue;
+class StringDictionary;
 class TupleDescriptor;
 class DateTimeValue;
 class TupleRow;
@@ -107,6 +108,14 @@ public:
         deep_copy(desc, data, offset, false);
     }
 
+    // Same as deep_copy(desc, data, offset, true), except that string values
+    // already recorded in 'dict' are not copied again: the slot refers to the offset
+    // of the earlier copy instead. Newly copied values are added to 'dict' (pointing
+    // into data) while it has room; a full 'dict' is not consulted any more.
+    // Returns the number of string bytes saved.
+    int deep_copy_with_dict(const TupleDescriptor& desc, char** data, int* offset,
+                            StringDictionary* dict);
+
     // Materialize this by evaluating the expressions in materialize_exprs
     // over the specified 'row'. 'pool' is used to allocate var-length data.
     // (Memory for this tuple itself must already be allocated.)
@@ -15,7 +15,14 @@
 
 #include "service/internal_service.h"
 
+#include <sstream>
+
 #include "gen_cpp/BackendService.h"
+#include "olap/olap_engine.h"
+#include "olap/point_reader.h"
+#include "olap/row_cursor.h"
+#include "runtime/mem_pool.h"
+#include "runtime/mem_tracker.h"
 #include "runtime/exec_env.h"
 #include "runtime/data_stream_mgr.h"
 #include "runtime/fragment_mgr.h"
@@ -84,6 +91,37 @@ Status PInternalServiceImpl::_exec_plan_fragment(brpc::Controller* cntl) {
     return _exec_env->fragment_mgr()->exec_plan_fragment(t_request);
 }
 
+void PInternalServiceImpl::exec_plan_fragments(
+        google::protobuf::RpcController* cntl_base,
+        const PExecPlanFragmentRequest* request,
+        PExecPlanFragmentResult* response,
+        google::protobuf::Closure* done) {
+    brpc::ClosureGuard closure_guard(done);
+    brpc::Controller* cntl = static_cast<brpc::Controller*>(cntl_base);
+    auto st = _exec_plan_fragments(cntl);
+    if (!st.ok()) {
+        LOG(WARNING) << "exec plan fragments failed, errmsg=" << st.get_error_msg();
+    }
+    st.to_protobuf(response->mutable_status());
+}
+
+Status PInternalServiceImpl::_exec_plan_fragments(brpc::Controller* cntl) {
+    auto ser_request = cntl->request_attachment().to_string();
+    TExecPlanFragmentsParams t_request;
+    {
+        const uint8_t* buf = (const uint8_t*)ser_request.data();
+        uint32_t len = ser_request.size();
+        RETURN_IF_ERROR(deserialize_thrift_msg(buf, &len, false, &t_request));
+    }
+    if (t_request.params.empty()) {
+        return Status::OK;
+    }
+    LOG(INFO) << "exec plan fragments, query_id=" << t_request.params[0].params.query_id
+        << ", num_instances=" << t_request.params.size()
+        << ", coord=" << t_request.params[0].coord;
+    return _exec_env->fragment_mgr()->exec_plan_fragments(t_request.params);
+}
+
 void PInternalServiceImpl::cancel_plan_fragment(
         google::protobuf::RpcController* cntl_base,
         const PCancelPlanFragmentRequest* request,
@@ -111,4 +149,73 @@ void PInternalServiceImpl::fetch_data(
     _exec_env->result_mgr()->fetch_data(request->finst_id(), ctx);
 }
 
+void PInternalServiceImpl::lookup_row(
+        google::protobuf::RpcController* cntl_base,
+        const PLookupRowRequest* request,
+        PLookupRowResult* result,
+        google::protobuf::Closure* done) {
+    brpc::ClosureGuard closure_guard(done);
+    auto st = _lookup_row(request, result);
+    if (!st.ok()) {
+        LOG(WARNING) << "lookup row failed, tablet_id=" << request->tablet_id()
+            << ", errmsg=" << st.get_error_msg();
+    }
+    st.to_protobuf(result->mutable_status());
+}
+
+Status PInternalServiceImpl::_lookup_row(
+        const PLookupRowRequest* request, PLookupRowResult* result) {
+    SmartOLAPTable table = OLAPEngine::get_instance()->get_table(
+        request->tablet_id(), request->schema_hash());
+    if (table.get() == nullptr) {
+        return Status("tablet does not exist");
+    }
+    table->record_scan();
+    {
+        AutoRWLock auto_lock(table->get_header_lock_ptr(), true);
+        const FileVersionMessage* message = table->latest_version();
+        if (message == NULL) {
+            return Status("fail to get latest version");
+        }
+        if (message->end_version() == request->version()
+                && message->version_hash() != request->version_hash()) {
+            return Status("fail to check version hash");
+        }
+    }
+
+    std::vector<std::string> key_values(request->key().begin(), request->key().end());
+    RowCursor key;
+    if (key.init_scan_key(table->tablet_schema(), key_values) != OLAP_SUCCESS
+            || key.from_string(key_values) != OLAP_SUCCESS) {
+        return Status("invalid key");
+    }
+
+    RowCursor row;
+    if (row.init(table->tablet_schema()) != OLAP_SUCCESS) {
+        return Status("fail to init row cursor");
+    }
+    MemTracker tracker(-1);
+    MemPool mem_pool(&tracker);
+
+    PointReader reader(table);
+    bool found = false;
+    Version version(0, request->version());
+    OLAPStatus res = reader.lookup(version, key, &row, &mem_pool, &found);
+    if (res != OLAP_SUCCESS) {
+        std::stringstream ss;
+        ss << "fail to lookup row, res=" << res;
+        return Status(ss.str());
+    }
+
+    result->set_found(found);
+    if (found) {
+        std::vector<std::string> values = row.to_string_vector();
+        for (size_t i = 0; i < values.size(); ++i) {
+            result->add_is_null(row.is_null(i));
+            result->add_values(row.is_null(i) ? "" : values[i]);
+        }
+    }
+    return Status::OK;
+}
+
 }
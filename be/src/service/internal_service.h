@@ -41,6 +41,12 @@ public:
         PExecPlanFragmentResult* result,
         google::protobuf::Closure* done) override;
 
+    void exec_plan_fragments(
+        google::protobuf::RpcController* controller,
+        const PExecPlanFragmentRequest* request,
+        PExecPlanFragmentResult* result,
+        google::protobuf::Closure* done) override;
+
     void cancel_plan_fragment(
         google::protobuf::RpcController* controller,
         const PCancelPlanFragmentRequest* request,
@@ -52,9 +58,19 @@ public:
         const PFetchDataRequest* request,
         PFetchDataResult* result,
         google::protobuf::Closure* done) override;
+
+    void lookup_row(
+        google::protobuf::RpcController* controller,
+        const PLookupRowRequest* request,
+        PLookupRowResult* result,
+        google::protobuf::Closure* done) override;
 private:
     Status _exec_plan_fragment(brpc::Controller* cntl);
 
+    Status _exec_plan_fragments(brpc::Controller* cntl);
+
+    Status _lookup_row(const PLookupRowRequest* request, PLookupRowResult* result);
+
 private:
     ExecEnv* _exec_env;
 };
@@ -52,22 +52,7 @@ public:
 
         while (true) {
             if (!_queue.empty()) {
-                // 定期提高队列中残留的任务优先级
-                // 保证优先级较低的大查询不至于完全饿死
-                if (_upgrade_counter > 128) {
-                    std::priority_queue<T> tmp_queue;
-                    while (!_queue.empty()) {
-                        T v = _queue.top();
-                        _queue.pop();
-                        ++v;
-                        tmp_queue.push(v);
-                    }
-                    swap(_queue, tmp_queue);
-                    _upgrade_counter = 0;
-                }
-                *out = _queue.top();
-                _queue.pop();
-                ++_upgrade_counter;
+                _pop_locked(out);
                 _total_get_wait_time += timer.elapsed_time();
                 unique_lock.unlock();
                 _put_cv.notify_one();
@@ -83,6 +68,20 @@ public:
         }
     }
 
+    // Get an element from the queue without waiting. Returns false if the queue
+    // is empty or it is already locked by another thread, so that callers polling
+    // several queues never block on a busy one.
+    bool non_blocking_get(T* out) {
+        boost::unique_lock<boost::mutex> unique_lock(_lock, boost::try_to_lock);
+        if (!unique_lock.owns_lock() || _queue.empty()) {
+            return false;
+        }
+        _pop_locked(out);
+        unique_lock.unlock();
+        _put_cv.notify_one();
+        return true;
+    }
+
     // Puts an element into the queue, waiting indefinitely until there is space.
     // If the queue is shut down, returns false.
     bool blocking_put(const T& val) {
@@ -135,6 +134,27 @@ public:
     }
 
 private:
+    // Pop the top element into 'out'. Caller must hold _lock and the queue must
+    // not be empty.
+    void _pop_locked(T* out) {
+        // 定期提高队列中残留的任务优先级
+        // 保证优先级较低的大查询不至于完全饿死
+        if (_upgrade_counter > 128) {
+            std::priority_queue<T> tmp_queue;
+            while (!_queue.empty()) {
+                T v = _queue.top();
+                _queue.pop();
+                ++v;
+                tmp_queue.push(v);
+            }
+            swap(_queue, tmp_queue);
+            _upgrade_counter = 0;
+        }
+        *out = _queue.top();
+        _queue.pop();
+        ++_upgrade_counter;
+    }
+
     bool _shutdown;
     const int _max_element;
     boost::condition_variable _get_cv;   // 'get' callers wait on this
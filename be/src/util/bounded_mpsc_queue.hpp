@@ -0,0 +1,130 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_COMMON_UTIL_BOUNDED_MPSC_QUEUE_HPP
+#define BDG_PALO_BE_SRC_COMMON_UTIL_BOUNDED_MPSC_QUEUE_HPP
+
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+#include "common/compiler_util.h"
+#include "common/logging.h"
+#include "gutil/macros.h"
+#include "util/bit_util.h"
+
+namespace palo {
+
+// Fixed capacity, lock-free FIFO queue for any number of producer threads and a
+// single consumer thread. Neither side ever blocks: try_push() fails if the queue is
+// full and try_pop() fails if it is empty, callers decide how to wait.
+//
+// Each slot of the ring carries a sequence number telling whether it is ready to be
+// written (sequence == position) or to be read (sequence == position + 1). Producers
+// claim a position with a single CAS, so pushes from many threads do not serialize
+// on a mutex. See Dmitry Vyukov's bounded MPMC queue, of which this is the single
+// consumer variant.
+template <typename T>
+class BoundedMpscQueue {
+public:
+    // 'capacity' is rounded up to a power of two.
+    explicit BoundedMpscQueue(size_t capacity) :
+            _mask(BitUtil::next_power_of_two(std::max<size_t>(capacity, 2)) - 1),
+            _cells(new Cell[_mask + 1]),
+            _enqueue_pos(0),
+            _dequeue_pos(0) {
+        for (size_t i = 0; i <= _mask; ++i) {
+            _cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // Adds 'value' to the tail of the queue. Thread safe.
+    // Returns false if the queue is full.
+    bool try_push(const T& value) {
+        Cell* cell = nullptr;
+        size_t pos = _enqueue_pos.load(std::memory_order_relaxed);
+        while (true) {
+            cell = &_cells[pos & _mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (_enqueue_pos.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                // the slot of the previous round has not been consumed yet
+                return false;
+            } else {
+                pos = _enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = value;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Removes the head of the queue into 'value'. Must only be called from one
+    // thread at a time. Returns false if the queue is empty.
+    bool try_pop(T* value) {
+        size_t pos = _dequeue_pos.load(std::memory_order_relaxed);
+        Cell* cell = &_cells[pos & _mask];
+        size_t seq = cell->sequence.load(std::memory_order_acquire);
+        if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1) < 0) {
+            return false;
+        }
+        *value = cell->value;
+        cell->sequence.store(pos + _mask + 1, std::memory_order_release);
+        _dequeue_pos.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Number of elements in the queue. Only a hint when other threads are pushing
+    // or popping concurrently.
+    size_t size() const {
+        size_t enqueue_pos = _enqueue_pos.load(std::memory_order_relaxed);
+        size_t dequeue_pos = _dequeue_pos.load(std::memory_order_relaxed);
+        return enqueue_pos > dequeue_pos ? enqueue_pos - dequeue_pos : 0;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    size_t capacity() const {
+        return _mask + 1;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    const size_t _mask;
+    std::unique_ptr<Cell[]> _cells;
+    // keep the producer and consumer positions on different cache lines
+    char _pad0[CACHE_LINE_SIZE];
+    std::atomic<size_t> _enqueue_pos;
+    char _pad1[CACHE_LINE_SIZE];
+    std::atomic<size_t> _dequeue_pos;
+
+    DISALLOW_COPY_AND_ASSIGN(BoundedMpscQueue);
+};
+
+}
+
+#endif
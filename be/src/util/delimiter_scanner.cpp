@@ -0,0 +1,62 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/delimiter_scanner.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace palo {
+
+void DelimiterScanner::find_all(const uint8_t* base, size_t begin, size_t end,
+                                uint8_t first, uint8_t second,
+                                std::vector<size_t>* positions) {
+    size_t i = begin;
+#ifdef __AVX2__
+    const __m256i first_v = _mm256_set1_epi8(first);
+    const __m256i second_v = _mm256_set1_epi8(second);
+    for (; i + 32 <= end; i += 32) {
+        __m256i data = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(base + i));
+        uint32_t mask = _mm256_movemask_epi8(_mm256_or_si256(
+                _mm256_cmpeq_epi8(data, first_v), _mm256_cmpeq_epi8(data, second_v)));
+        while (mask != 0) {
+            positions->push_back(i + __builtin_ctz(mask));
+            mask &= mask - 1;
+        }
+    }
+#elif defined(__SSE2__)
+    const __m128i first_v = _mm_set1_epi8(first);
+    const __m128i second_v = _mm_set1_epi8(second);
+    for (; i + 16 <= end; i += 16) {
+        __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(base + i));
+        uint32_t mask = _mm_movemask_epi8(_mm_or_si128(
+                _mm_cmpeq_epi8(data, first_v), _mm_cmpeq_epi8(data, second_v)));
+        while (mask != 0) {
+            positions->push_back(i + __builtin_ctz(mask));
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; i < end; ++i) {
+        if (base[i] == first || base[i] == second) {
+            positions->push_back(i);
+        }
+    }
+}
+
+}
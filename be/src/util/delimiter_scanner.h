@@ -0,0 +1,37 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_UTIL_DELIMITER_SCANNER_H
+#define BDG_PALO_BE_SRC_UTIL_DELIMITER_SCANNER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace palo {
+
+// Finds the delimiters of delimited text, such as the field and line delimiters of
+// a csv file, comparing 32 bytes at a time with AVX2 or 16 with SSE2.
+class DelimiterScanner {
+public:
+    // Appends to 'positions' the offsets from 'base' of the bytes in
+    // [base + begin, base + end) equal to 'first' or 'second', in increasing order.
+    static void find_all(const uint8_t* base, size_t begin, size_t end,
+                         uint8_t first, uint8_t second, std::vector<size_t>* positions);
+};
+
+}
+
+#endif
@@ -28,6 +28,7 @@
 #include <sstream>
 #include <algorithm>
 #include <iomanip>
+#include <memory>
 
 #include <boost/filesystem.hpp>
 #include <boost/system/error_code.hpp>
@@ -247,5 +248,40 @@ Status FileUtils::md5sum(const std::string& file, std::string* md5sum) {
     return Status::OK;
 }
 
+Status FileUtils::md5sum(const std::string& file, int64_t offset, int64_t length,
+                         std::string* md5sum) {
+    int fd = open(file.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return Status("failed to open file");
+    }
+    DeferOp close_fd(std::bind<void>(&close, fd));
+
+    MD5_CTX ctx;
+    MD5_Init(&ctx);
+    const int64_t buf_size = 1024 * 1024;
+    std::unique_ptr<char[]> buf(new char[buf_size]);
+    while (length > 0) {
+        ssize_t n = pread(fd, buf.get(), std::min(buf_size, length), offset);
+        if (n < 0) {
+            return Status("failed to read file");
+        }
+        if (n == 0) {
+            return Status("file is shorter than the range");
+        }
+        MD5_Update(&ctx, buf.get(), n);
+        offset += n;
+        length -= n;
+    }
+    unsigned char result[MD5_DIGEST_LENGTH];
+    MD5_Final(result, &ctx);
+
+    std::stringstream ss;
+    for (int32_t i = 0; i < MD5_DIGEST_LENGTH; i++) {
+        ss << std::setfill('0') << std::setw(2) << std::hex << (int) result[i];
+    }
+    ss >> *md5sum;
+    return Status::OK;
+}
+
 }
 
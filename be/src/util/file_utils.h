@@ -64,6 +64,11 @@ public:
 
     // calc md5sum of a local file
     static Status md5sum(const std::string& file, std::string* md5sum);
+
+    // calc md5sum of 'length' bytes of a local file starting at 'offset',
+    // fails if the file ends before them
+    static Status md5sum(const std::string& file, int64_t offset, int64_t length,
+                         std::string* md5sum);
 };
 
 }
@@ -25,6 +25,11 @@ PaloMetrics PaloMetrics::_s_palo_metrics;
 // counters
 IntCounter PaloMetrics::fragment_requests_total;
 IntCounter PaloMetrics::fragment_request_duration_us;
+IntCounter PaloMetrics::single_fragment_start_requests_total;
+IntCounter PaloMetrics::single_fragment_start_duration_us;
+IntCounter PaloMetrics::batch_fragment_start_requests_total;
+IntCounter PaloMetrics::batch_fragment_start_duration_us;
+IntCounter PaloMetrics::batch_fragment_start_instances_total;
 IntCounter PaloMetrics::http_requests_total;
 IntCounter PaloMetrics::http_request_duration_us;
 IntCounter PaloMetrics::http_request_send_bytes;
@@ -69,11 +74,24 @@ IntCounter PaloMetrics::base_compaction_request_total;
 IntCounter PaloMetrics::base_compaction_request_failed;
 IntCounter PaloMetrics::cumulative_compaction_deltas_total;
 IntCounter PaloMetrics::cumulative_compaction_bytes_total;
+IntCounter PaloMetrics::base_compaction_rows_total;
+IntCounter PaloMetrics::cumulative_compaction_rows_total;
 IntCounter PaloMetrics::cumulative_compaction_request_total;
 IntCounter PaloMetrics::cumulative_compaction_request_failed;
 
+IntCounter PaloMetrics::index_entry_cache_hit_total;
+IntCounter PaloMetrics::index_entry_cache_miss_total;
+IntCounter PaloMetrics::index_entry_load_duration_us;
+
+IntCounter PaloMetrics::chunk_pool_local_core_alloc_count;
+IntCounter PaloMetrics::chunk_pool_other_core_alloc_count;
+IntCounter PaloMetrics::chunk_pool_system_alloc_count;
+IntCounter PaloMetrics::chunk_pool_system_free_count;
+
 // gauges
 IntGauge PaloMetrics::memory_pool_bytes_total;
+IntGauge PaloMetrics::index_entry_cache_bytes;
+IntGauge PaloMetrics::chunk_pool_reserved_bytes;
 
 PaloMetrics::PaloMetrics() : _metrics(nullptr), _system_metrics(nullptr) {
 }
@@ -93,6 +111,19 @@ void PaloMetrics::initialize(const std::string& name,
     // You can put PaloMetrics's metrics initial code here
     REGISTER_PALO_METRIC(fragment_requests_total);
     REGISTER_PALO_METRIC(fragment_request_duration_us);
+    _metrics->register_metric(
+        "fragment_start_requests_total", MetricLabels().add("type", "single"),
+        &single_fragment_start_requests_total);
+    _metrics->register_metric(
+        "fragment_start_requests_total", MetricLabels().add("type", "batch"),
+        &batch_fragment_start_requests_total);
+    _metrics->register_metric(
+        "fragment_start_duration_us", MetricLabels().add("type", "single"),
+        &single_fragment_start_duration_us);
+    _metrics->register_metric(
+        "fragment_start_duration_us", MetricLabels().add("type", "batch"),
+        &batch_fragment_start_duration_us);
+    REGISTER_PALO_METRIC(batch_fragment_start_instances_total);
     REGISTER_PALO_METRIC(http_requests_total);
     REGISTER_PALO_METRIC(http_request_duration_us);
     REGISTER_PALO_METRIC(http_request_send_bytes);
@@ -159,9 +190,30 @@ void PaloMetrics::initialize(const std::string& name,
     _metrics->register_metric(
         "compaction_bytes_total", MetricLabels().add("type", "cumulative"),
         &cumulative_compaction_bytes_total);
+    _metrics->register_metric(
+        "compaction_rows_total", MetricLabels().add("type", "base"),
+        &base_compaction_rows_total);
+    _metrics->register_metric(
+        "compaction_rows_total", MetricLabels().add("type", "cumulative"),
+        &cumulative_compaction_rows_total);
+
+    _metrics->register_metric(
+        "index_entry_cache_requests_total", MetricLabels().add("type", "hit"),
+        &index_entry_cache_hit_total);
+    _metrics->register_metric(
+        "index_entry_cache_requests_total", MetricLabels().add("type", "miss"),
+        &index_entry_cache_miss_total);
+    REGISTER_PALO_METRIC(index_entry_load_duration_us);
+
+    REGISTER_PALO_METRIC(chunk_pool_local_core_alloc_count);
+    REGISTER_PALO_METRIC(chunk_pool_other_core_alloc_count);
+    REGISTER_PALO_METRIC(chunk_pool_system_alloc_count);
+    REGISTER_PALO_METRIC(chunk_pool_system_free_count);
 
     // Gauge
     REGISTER_PALO_METRIC(memory_pool_bytes_total);
+    REGISTER_PALO_METRIC(index_entry_cache_bytes);
+    REGISTER_PALO_METRIC(chunk_pool_reserved_bytes);
 
     if (init_system_metrics) {
         _system_metrics = new SystemMetrics();
@@ -31,6 +31,12 @@ public:
     // counters
     static IntCounter fragment_requests_total;
     static IntCounter fragment_request_duration_us;
+    // time spent to prepare and start fragment instances, by successful exec requests
+    static IntCounter single_fragment_start_requests_total;
+    static IntCounter single_fragment_start_duration_us;
+    static IntCounter batch_fragment_start_requests_total;
+    static IntCounter batch_fragment_start_duration_us;
+    static IntCounter batch_fragment_start_instances_total;
     static IntCounter http_requests_total;
     static IntCounter http_request_duration_us;
     static IntCounter http_request_send_bytes;
@@ -78,12 +84,25 @@ public:
     static IntCounter base_compaction_bytes_total;
     static IntCounter cumulative_compaction_deltas_total;
     static IntCounter cumulative_compaction_bytes_total;
+    static IntCounter base_compaction_rows_total;
+    static IntCounter cumulative_compaction_rows_total;
 
     static IntCounter alter_task_success_total;
     static IntCounter alter_task_failed_total;
 
+    static IntCounter index_entry_cache_hit_total;
+    static IntCounter index_entry_cache_miss_total;
+    static IntCounter index_entry_load_duration_us;
+
+    static IntCounter chunk_pool_local_core_alloc_count;
+    static IntCounter chunk_pool_other_core_alloc_count;
+    static IntCounter chunk_pool_system_alloc_count;
+    static IntCounter chunk_pool_system_free_count;
+
     // Gauges
     static IntGauge memory_pool_bytes_total;
+    static IntGauge index_entry_cache_bytes;
+    static IntGauge chunk_pool_reserved_bytes;
 
     ~PaloMetrics();
     // call before calling metrics
@@ -42,6 +42,9 @@ public:
     public:
         int priority;
         WorkFunction work_function;
+        // Hint for pools with several queues (see PriorityWorkStealingThreadPool),
+        // tasks with the same queue_id go to the same queue. Ignored otherwise.
+        int queue_id = 0;
         bool operator< (const Task& o) const {
             return priority < o.priority;
         }
@@ -71,7 +74,7 @@ public:
 
     // Destructor ensures that all threads are terminated before this object is freed
     // (otherwise they may continue to run and reference member variables)
-    ~PriorityThreadPool() {
+    virtual ~PriorityThreadPool() {
         shutdown();
         join();
     }
@@ -87,7 +90,7 @@ public:
     //
     // Returns true if the work item was successfully added to the queue, false otherwise
     // (which typically means that the thread pool has already been shut down).
-    bool offer(Task task) {
+    virtual bool offer(Task task) {
         return _work_queue.blocking_put(task);
     }
 
@@ -95,7 +98,7 @@ public:
     // and the worker threads to terminate once they have processed their current work item.
     // Returns once the shutdown flag has been set, does not wait for the threads to
     // terminate.
-    void shutdown() {
+    virtual void shutdown() {
         {
             boost::lock_guard<boost::mutex> l(_lock);
             _shutdown = true;
@@ -109,14 +112,14 @@ public:
         _threads.join_all();
     }
 
-    uint32_t get_queue_size() const {
+    virtual uint32_t get_queue_size() const {
         return _work_queue.get_size();
     }
 
     // Blocks until the work queue is empty, and then calls shutdown to stop the worker
     // threads and Join to wait until they are finished.
     // Any work Offer()'ed during DrainAndshutdown may or may not be processed.
-    void drain_and_shutdown() {
+    virtual void drain_and_shutdown() {
         {
             boost::unique_lock<boost::mutex> l(_lock);
             while (_work_queue.get_size() != 0) {
@@ -127,6 +130,33 @@ public:
         join();
     }
 
+protected:
+    // Used by subclasses that bring their own queues and worker threads; no thread
+    // is started and _work_queue stays unused.
+    PriorityThreadPool() :
+            _thread_num(0),
+            _work_queue(1),
+            _shutdown(false) {
+    }
+
+    // Returns value of _shutdown under a lock, forcing visibility to threads in the pool.
+    bool is_shutdown() {
+        boost::lock_guard<boost::mutex> l(_lock);
+        return _shutdown;
+    }
+
+    // Collection of worker threads that process work from the queue.
+    boost::thread_group _threads;
+
+    // Guards _shutdown and _empty_cv
+    boost::mutex _lock;
+
+    // Signalled when the queue becomes empty
+    boost::condition_variable _empty_cv;
+
+    // Set to true when threads should stop doing work and terminate.
+    bool _shutdown;
+
 private:
     // Driver method for each thread in the pool. Continues to read work from the queue
     // until the pool is shutdown.
@@ -142,29 +172,11 @@ private:
         }
     }
 
-    // Returns value of _shutdown under a lock, forcing visibility to threads in the pool.
-    bool is_shutdown() {
-        boost::lock_guard<boost::mutex> l(_lock);
-        return _shutdown;
-    }
-
     uint32_t _thread_num;
 
     // Queue on which work items are held until a thread is available to process them in
     // FIFO order.
     BlockingPriorityQueue<Task> _work_queue;
-
-    // Collection of worker threads that process work from the queue.
-    boost::thread_group _threads;
-
-    // Guards _shutdown and _empty_cv
-    boost::mutex _lock;
-
-    // Set to true when threads should stop doing work and terminate.
-    bool _shutdown;
-
-    // Signalled when the queue becomes empty
-    boost::condition_variable _empty_cv;
 };
 
 }
@@ -0,0 +1,186 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_COMMON_UTIL_PRIORITY_WORK_STEALING_THREAD_POOL_HPP
+#define BDG_PALO_BE_SRC_COMMON_UTIL_PRIORITY_WORK_STEALING_THREAD_POOL_HPP
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <boost/thread/condition_variable.hpp>
+
+#include "common/logging.h"
+#include "util/priority_thread_pool.hpp"
+
+namespace palo {
+
+// PriorityThreadPool with one priority queue per group of worker threads instead of
+// a single shared queue. A task is put on the queue selected by its 'queue_id', so
+// all tasks of one producer (e.g. the scanners of one query) share a home queue and
+// do not crowd out the tasks of other producers. Worker threads serve their own
+// queue first and steal from the other queues when it is empty, so no thread stays
+// idle while there is work left. Idle workers sleep on a condition variable shared by
+// all queues until a task is offered to any of them. Within a queue tasks are still
+// served by priority,
+// and the priorities of waiting tasks are raised periodically (see
+// BlockingPriorityQueue) so that low priority tasks are not starved.
+class PriorityWorkStealingThreadPool : public PriorityThreadPool {
+public:
+    // Creates a new thread pool and start num_threads threads.
+    //  -- num_threads: how many threads are part of this pool
+    //  -- num_queues: how many queues are part of this pool, worker thread i serves
+    //     queue i % num_queues first.
+    //  -- queue_size: the maximum size of each queue on which work items are offered.
+    //     If the queue exceeds this size, subsequent calls to offer() will block until
+    //     there is capacity available.
+    PriorityWorkStealingThreadPool(uint32_t num_threads, uint32_t num_queues,
+                                   uint32_t queue_size) :
+            _num_tasks(0),
+            _num_idle(0) {
+        DCHECK_GT(num_queues, 0);
+        DCHECK_GE(num_threads, num_queues);
+        for (int i = 0; i < num_queues; ++i) {
+            _work_queues.emplace_back(new BlockingPriorityQueue<Task>(queue_size));
+        }
+        for (int i = 0; i < num_threads; ++i) {
+            _threads.create_thread(
+                    boost::bind<void>(
+                        boost::mem_fn(&PriorityWorkStealingThreadPool::work_thread),
+                        this, i));
+        }
+    }
+
+    virtual ~PriorityWorkStealingThreadPool() {
+        shutdown();
+        join();
+    }
+
+    // Blocking operation that puts a work item on the queue selected by
+    // task.queue_id. If the queue is full, blocks until there is capacity available.
+    //
+    // Returns true if the work item was successfully added to the queue, false otherwise
+    // (which typically means that the thread pool has already been shut down).
+    virtual bool offer(Task task) {
+        // counted before it is queued, so a worker that takes it never sees the
+        // count drop below zero
+        ++_num_tasks;
+        if (!_work_queues[_queue_index(task.queue_id)]->blocking_put(task)) {
+            --_num_tasks;
+            return false;
+        }
+        // pairs with _wait_for_work(): either the idle worker sees the task or we see
+        // the idle worker
+        if (_num_idle.load() > 0) {
+            boost::lock_guard<boost::mutex> l(_lock);
+            _work_cv.notify_one();
+        }
+        return true;
+    }
+
+    // Shuts the thread pool down, causing the work queues to cease accepting offered work
+    // and the worker threads to terminate once they have processed their current work item.
+    // Returns once the shutdown flag has been set, does not wait for the threads to
+    // terminate.
+    virtual void shutdown() {
+        {
+            boost::lock_guard<boost::mutex> l(_lock);
+            _shutdown = true;
+            _work_cv.notify_all();
+        }
+        for (auto& work_queue : _work_queues) {
+            work_queue->shutdown();
+        }
+    }
+
+    virtual uint32_t get_queue_size() const {
+        return _num_tasks.load();
+    }
+
+    // Blocks until all work queues are empty, and then calls shutdown to stop the worker
+    // threads and join to wait until they are finished.
+    // Any work offer()'ed during drain_and_shutdown may or may not be processed.
+    virtual void drain_and_shutdown() {
+        {
+            boost::unique_lock<boost::mutex> l(_lock);
+            while (get_queue_size() != 0) {
+                _empty_cv.wait(l);
+            }
+        }
+        shutdown();
+        join();
+    }
+
+private:
+    int _queue_index(int queue_id) const {
+        return (static_cast<uint32_t>(queue_id)) % _work_queues.size();
+    }
+
+    // Driver method for each thread in the pool. Continues to read work from the queues
+    // until the pool is shutdown.
+    void work_thread(int thread_id) {
+        int home = _queue_index(thread_id);
+        while (!is_shutdown()) {
+            Task task;
+            // own queue first, then try to steal from the others
+            bool got_task = false;
+            for (int i = 0; !got_task && i < _work_queues.size(); ++i) {
+                got_task = _work_queues[_queue_index(home + i)]->non_blocking_get(&task);
+            }
+            if (!got_task) {
+                _wait_for_work();
+                continue;
+            }
+            --_num_tasks;
+            task.work_function();
+            if (_num_tasks.load() == 0) {
+                boost::lock_guard<boost::mutex> l(_lock);
+                _empty_cv.notify_all();
+            }
+        }
+    }
+
+    // Sleeps until a task is offered or the pool is shut down. If tasks are queued but
+    // were missed because their queue was busy or not yet filled, only yields.
+    void _wait_for_work() {
+        boost::unique_lock<boost::mutex> l(_lock);
+        ++_num_idle;
+        bool waited = false;
+        while (_num_tasks.load() == 0 && !_shutdown) {
+            _work_cv.wait(l);
+            waited = true;
+        }
+        --_num_idle;
+        if (!waited) {
+            l.unlock();
+            boost::this_thread::yield();
+        }
+    }
+
+    std::vector<std::unique_ptr<BlockingPriorityQueue<Task>>> _work_queues;
+
+    // Number of tasks offered and not yet taken by a worker, over all queues.
+    std::atomic<uint32_t> _num_tasks;
+
+    // Number of workers sleeping on _work_cv, changed under _lock.
+    std::atomic<uint32_t> _num_idle;
+
+    // Signalled under _lock when a task is offered to any queue or the pool shuts down.
+    boost::condition_variable _work_cv;
+};
+
+}
+
+#endif
@@ -0,0 +1,51 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "util/rate_limiter.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "util/time.h"
+
+namespace palo {
+
+RateLimiter::RateLimiter(int64_t bytes_per_second) :
+        _bytes_per_second(bytes_per_second),
+        _next_free_us(0) {
+}
+
+void RateLimiter::acquire(int64_t bytes) {
+    if (_bytes_per_second <= 0 || bytes <= 0) {
+        return;
+    }
+    int64_t now = MonotonicMicros();
+    int64_t wait_until = 0;
+    {
+        std::lock_guard<std::mutex> l(_lock);
+        _next_free_us = std::max(_next_free_us, now);
+        _next_free_us += bytes * 1000000 / _bytes_per_second;
+        wait_until = _next_free_us;
+    }
+    // the bytes of this call pass during the sleep
+    int64_t wait_us = wait_until - now - bytes * 1000000 / _bytes_per_second;
+    if (wait_us > 0) {
+        usleep(wait_us);
+    }
+}
+
+}
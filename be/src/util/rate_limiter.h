@@ -0,0 +1,51 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#ifndef BDG_PALO_BE_SRC_UTIL_RATE_LIMITER_H
+#define BDG_PALO_BE_SRC_UTIL_RATE_LIMITER_H
+
+#include <stdint.h>
+
+#include <mutex>
+
+namespace palo {
+
+// Limits the rate of bytes passing through it, shared by any number of threads.
+//
+// acquire() books the bytes on a virtual clock that advances by bytes / rate and
+// sleeps until the clock reaches the booked time, so concurrent callers share the rate
+// and a caller coming after an idle period does not get a burst larger than one call.
+class RateLimiter {
+public:
+    // 'bytes_per_second' <= 0 means no limit.
+    explicit RateLimiter(int64_t bytes_per_second);
+
+    // Blocks until 'bytes' may pass.
+    void acquire(int64_t bytes);
+
+    int64_t rate() const { return _bytes_per_second; }
+
+private:
+    const int64_t _bytes_per_second;
+
+    std::mutex _lock;
+    // monotonic time in microseconds at which the bytes booked so far have passed
+    int64_t _next_free_us;
+};
+
+}
+
+#endif
@@ -0,0 +1,236 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/roaring_bitmap.h"
+
+#include <string.h>
+#include <algorithm>
+#include <iterator>
+
+namespace palo {
+
+const int32_t RoaringBitmap::ARRAY_MAX_SIZE;
+const size_t RoaringBitmap::HEADER_SIZE;
+const int32_t RoaringBitmap::BITSET_WORDS;
+
+bool RoaringBitmap::Container::contains(uint16_t low) const {
+    if (is_bitset()) {
+        return (bitset[low >> 6] >> (low & 63)) & 1;
+    }
+    return std::binary_search(array.begin(), array.end(), low);
+}
+
+void RoaringBitmap::Container::add(uint16_t low) {
+    if (!is_bitset()) {
+        auto it = std::lower_bound(array.begin(), array.end(), low);
+        if (it != array.end() && *it == low) {
+            return;
+        }
+        if (cardinality < ARRAY_MAX_SIZE) {
+            array.insert(it, low);
+            ++cardinality;
+            return;
+        }
+        convert_to_bitset();
+    }
+    uint64_t mask = 1ULL << (low & 63);
+    if ((bitset[low >> 6] & mask) == 0) {
+        bitset[low >> 6] |= mask;
+        ++cardinality;
+    }
+}
+
+void RoaringBitmap::Container::add_array(const uint16_t* values, int32_t num) {
+    if (!is_bitset()) {
+        std::vector<uint16_t> merged;
+        merged.reserve(array.size() + num);
+        std::set_union(array.begin(), array.end(), values, values + num,
+                       std::back_inserter(merged));
+        if (merged.size() <= ARRAY_MAX_SIZE) {
+            array.swap(merged);
+            cardinality = array.size();
+            return;
+        }
+        array.swap(merged);
+        cardinality = array.size();
+        convert_to_bitset();
+        return;
+    }
+    for (int32_t i = 0; i < num; ++i) {
+        uint64_t mask = 1ULL << (values[i] & 63);
+        if ((bitset[values[i] >> 6] & mask) == 0) {
+            bitset[values[i] >> 6] |= mask;
+            ++cardinality;
+        }
+    }
+}
+
+void RoaringBitmap::Container::add_bitset(const uint64_t* words) {
+    if (!is_bitset()) {
+        convert_to_bitset();
+    }
+    int32_t count = 0;
+    for (int32_t i = 0; i < BITSET_WORDS; ++i) {
+        bitset[i] |= words[i];
+        count += __builtin_popcountll(bitset[i]);
+    }
+    cardinality = count;
+}
+
+void RoaringBitmap::Container::convert_to_bitset() {
+    bitset.assign(BITSET_WORDS, 0);
+    for (uint16_t low : array) {
+        bitset[low >> 6] |= 1ULL << (low & 63);
+    }
+    std::vector<uint16_t>().swap(array);
+}
+
+char* RoaringBitmap::Container::write_array(char* dst) const {
+    if (!is_bitset()) {
+        memcpy(dst, &array[0], array.size() * sizeof(uint16_t));
+        return dst + array.size() * sizeof(uint16_t);
+    }
+    for (int32_t i = 0; i < BITSET_WORDS; ++i) {
+        uint64_t word = bitset[i];
+        while (word != 0) {
+            uint16_t low = i * 64 + __builtin_ctzll(word);
+            memcpy(dst, &low, sizeof(low));
+            dst += sizeof(low);
+            word &= word - 1;
+        }
+    }
+    return dst;
+}
+
+RoaringBitmap::Container* RoaringBitmap::_find_or_create(uint16_t high) {
+    auto it = std::lower_bound(_keys.begin(), _keys.end(), high);
+    size_t index = it - _keys.begin();
+    if (it == _keys.end() || *it != high) {
+        _keys.insert(it, high);
+        _containers.insert(_containers.begin() + index, Container());
+    }
+    return &_containers[index];
+}
+
+void RoaringBitmap::add(uint32_t value) {
+    _find_or_create(value >> 16)->add(value & 0xFFFF);
+}
+
+bool RoaringBitmap::contains(uint32_t value) const {
+    auto it = std::lower_bound(_keys.begin(), _keys.end(), value >> 16);
+    if (it == _keys.end() || *it != (value >> 16)) {
+        return false;
+    }
+    return _containers[it - _keys.begin()].contains(value & 0xFFFF);
+}
+
+int64_t RoaringBitmap::cardinality() const {
+    int64_t count = 0;
+    for (auto& container : _containers) {
+        count += container.cardinality;
+    }
+    return count;
+}
+
+void RoaringBitmap::merge(const RoaringBitmap& other) {
+    for (size_t i = 0; i < other._keys.size(); ++i) {
+        const Container& src = other._containers[i];
+        Container* dst = _find_or_create(other._keys[i]);
+        if (src.is_bitset()) {
+            dst->add_bitset(&src.bitset[0]);
+        } else {
+            dst->add_array(&src.array[0], src.cardinality);
+        }
+    }
+}
+
+bool RoaringBitmap::merge(const char* data, size_t size) {
+    if (size < sizeof(uint32_t)) {
+        return false;
+    }
+    uint32_t num_containers = 0;
+    memcpy(&num_containers, data, sizeof(uint32_t));
+    if (num_containers * 2 * sizeof(uint16_t) > size - sizeof(uint32_t)) {
+        return false;
+    }
+    const char* header = data + sizeof(uint32_t);
+    const char* values = header + num_containers * 2 * sizeof(uint16_t);
+    const char* end = data + size;
+    // the values of a container may be unaligned in 'data'
+    std::vector<uint16_t> array;
+    std::vector<uint64_t> words;
+    for (uint32_t i = 0; i < num_containers; ++i) {
+        uint16_t high = 0;
+        uint16_t cardinality_minus_one = 0;
+        memcpy(&high, header, sizeof(uint16_t));
+        memcpy(&cardinality_minus_one, header + sizeof(uint16_t), sizeof(uint16_t));
+        header += 2 * sizeof(uint16_t);
+        int32_t cardinality = cardinality_minus_one + 1;
+        if (cardinality <= ARRAY_MAX_SIZE) {
+            size_t bytes = cardinality * sizeof(uint16_t);
+            if (values + bytes > end) {
+                return false;
+            }
+            array.resize(cardinality);
+            memcpy(&array[0], values, bytes);
+            values += bytes;
+            _find_or_create(high)->add_array(&array[0], cardinality);
+        } else {
+            size_t bytes = BITSET_WORDS * sizeof(uint64_t);
+            if (values + bytes > end) {
+                return false;
+            }
+            words.resize(BITSET_WORDS);
+            memcpy(&words[0], values, bytes);
+            values += bytes;
+            _find_or_create(high)->add_bitset(&words[0]);
+        }
+    }
+    return values == end;
+}
+
+size_t RoaringBitmap::serialized_size() const {
+    size_t size = sizeof(uint32_t) + _keys.size() * 2 * sizeof(uint16_t);
+    for (auto& container : _containers) {
+        if (container.cardinality <= ARRAY_MAX_SIZE) {
+            size += container.cardinality * sizeof(uint16_t);
+        } else {
+            size += BITSET_WORDS * sizeof(uint64_t);
+        }
+    }
+    return size;
+}
+
+void RoaringBitmap::serialize(char* dst) const {
+    uint32_t num_containers = _keys.size();
+    memcpy(dst, &num_containers, sizeof(uint32_t));
+    dst += sizeof(uint32_t);
+    for (size_t i = 0; i < _keys.size(); ++i) {
+        uint16_t cardinality_minus_one = _containers[i].cardinality - 1;
+        memcpy(dst, &_keys[i], sizeof(uint16_t));
+        memcpy(dst + sizeof(uint16_t), &cardinality_minus_one, sizeof(uint16_t));
+        dst += 2 * sizeof(uint16_t);
+    }
+    for (auto& container : _containers) {
+        if (container.cardinality <= ARRAY_MAX_SIZE) {
+            dst = container.write_array(dst);
+        } else {
+            memcpy(dst, &container.bitset[0], BITSET_WORDS * sizeof(uint64_t));
+            dst += BITSET_WORDS * sizeof(uint64_t);
+        }
+    }
+}
+
+}
@@ -0,0 +1,119 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_COMMON_UTIL_ROARING_BITMAP_H
+#define BDG_PALO_BE_SRC_COMMON_UTIL_ROARING_BITMAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace palo {
+
+// Compressed bitmap of uint32 values, following the Roaring bitmap layout
+// (Chambi, Lemire et al.): values are grouped by their high 16 bits, and each
+// group keeps its low 16 bits either as a sorted array, while it holds no more
+// than ARRAY_MAX_SIZE values, or as a 65536 bit bitset beyond that. Sparse and
+// dense sets of ids both take few bytes per value, and unions work group by group.
+//
+// Serialized format, all integers little endian:
+//   uint32 number of groups
+//   per group: uint16 high bits, uint16 cardinality - 1
+//   per group: the sorted uint16 low bits if cardinality <= ARRAY_MAX_SIZE,
+//              otherwise the 1024 uint64 words of the bitset
+// This is not the portable format of the other Roaring implementations.
+class RoaringBitmap {
+public:
+    static const int32_t ARRAY_MAX_SIZE = 4096;
+    // bytes of the serialized format before the groups
+    static const size_t HEADER_SIZE = sizeof(uint32_t);
+
+    RoaringBitmap() { }
+
+    void add(uint32_t value);
+
+    bool contains(uint32_t value) const;
+
+    // Number of values in the bitmap.
+    int64_t cardinality() const;
+
+    bool empty() const { return _keys.empty(); }
+
+    // Adds all values of 'other' to this bitmap.
+    void merge(const RoaringBitmap& other);
+
+    // Adds all values of a bitmap serialized by serialize() to this bitmap, without
+    // building it first. Returns false if 'data' is not a valid serialized bitmap,
+    // in which case this bitmap may hold part of its values.
+    bool merge(const char* data, size_t size);
+
+    // Replaces the content of this bitmap by a bitmap serialized by serialize().
+    bool deserialize(const char* data, size_t size) {
+        clear();
+        return merge(data, size);
+    }
+
+    // Number of bytes written by serialize().
+    size_t serialized_size() const;
+
+    // Writes serialized_size() bytes to 'dst'.
+    void serialize(char* dst) const;
+
+    void clear() {
+        _keys.clear();
+        _containers.clear();
+    }
+
+private:
+    static const int32_t BITSET_WORDS = 65536 / 64;
+
+    // values of one group of high bits
+    struct Container {
+        Container() : cardinality(0) { }
+
+        bool is_bitset() const { return !bitset.empty(); }
+
+        bool contains(uint16_t low) const;
+
+        void add(uint16_t low);
+
+        // adds 'num' sorted values
+        void add_array(const uint16_t* values, int32_t num);
+
+        // ORs BITSET_WORDS words into the bitset
+        void add_bitset(const uint64_t* words);
+
+        void convert_to_bitset();
+
+        // writes the values as a sorted array
+        char* write_array(char* dst) const;
+
+        // sorted values, while cardinality <= ARRAY_MAX_SIZE
+        std::vector<uint16_t> array;
+        // BITSET_WORDS words, once cardinality > ARRAY_MAX_SIZE
+        std::vector<uint64_t> bitset;
+        int32_t cardinality;
+    };
+
+    Container* _find_or_create(uint16_t high);
+
+    // sorted high bits of the groups, _containers[i] holds the values of _keys[i]
+    std::vector<uint16_t> _keys;
+    std::vector<Container> _containers;
+};
+
+}
+
+#endif
@@ -126,6 +126,48 @@ private:
     bool _running;
 };
 
+// Stop watch for reporting the CPU time consumed by the calling thread in nanosec,
+// based on CLOCK_THREAD_CPUTIME_ID. Time the thread spends blocked (e.g. waiting for
+// IO or a lock) is not counted. start() and stop() must be called from the same thread.
+class ThreadCpuStopWatch {
+public:
+    ThreadCpuStopWatch() {
+        _total_time = 0;
+        _running = false;
+    }
+
+    void start() {
+        if (!_running) {
+            clock_gettime(CLOCK_THREAD_CPUTIME_ID, &_start);
+            _running = true;
+        }
+    }
+
+    void stop() {
+        if (_running) {
+            _total_time += elapsed_time();
+            _running = false;
+        }
+    }
+
+    // Returns time in nanosecond.
+    uint64_t elapsed_time() const {
+        if (!_running) {
+            return _total_time;
+        }
+
+        timespec end;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &end);
+        return (end.tv_sec - _start.tv_sec) * 1000L * 1000L * 1000L +
+               (end.tv_nsec - _start.tv_nsec);
+    }
+
+private:
+    timespec _start;
+    uint64_t _total_time; // in nanosec
+    bool _running;
+};
+
 }
 
 #endif
@@ -0,0 +1,200 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/tdigest.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace palo {
+
+const int32_t TDigest::DEFAULT_COMPRESSION;
+const size_t TDigest::HEADER_SIZE;
+const size_t TDigest::CENTROID_SIZE;
+
+TDigest::TDigest(double compression) :
+        _compression(compression),
+        _total_weight(0),
+        _buffer_weight(0),
+        _min(std::numeric_limits<double>::infinity()),
+        _max(-std::numeric_limits<double>::infinity()) {
+}
+
+void TDigest::add(double value, double weight) {
+    if (std::isnan(value) || !(weight > 0)) {
+        return;
+    }
+    Centroid centroid = { value, weight };
+    _buffer.push_back(centroid);
+    _buffer_weight += weight;
+    _min = std::min(_min, value);
+    _max = std::max(_max, value);
+    if (_buffer.size() >= 5 * _compression) {
+        _compress();
+    }
+}
+
+void TDigest::merge(const TDigest& other) {
+    for (auto& centroid : other._centroids) {
+        add(centroid.mean, centroid.weight);
+    }
+    for (auto& centroid : other._buffer) {
+        add(centroid.mean, centroid.weight);
+    }
+}
+
+bool TDigest::merge(const char* data, size_t size) {
+    if (size < HEADER_SIZE) {
+        return false;
+    }
+    uint32_t num_centroids = 0;
+    memcpy(&num_centroids, data, sizeof(uint32_t));
+    if ((size - HEADER_SIZE) / CENTROID_SIZE != num_centroids
+            || (size - HEADER_SIZE) % CENTROID_SIZE != 0) {
+        return false;
+    }
+    const char* values = data + HEADER_SIZE;
+    for (uint32_t i = 0; i < num_centroids; ++i) {
+        double weight = 0;
+        memcpy(&weight, values + i * CENTROID_SIZE + sizeof(double), sizeof(double));
+        if (!(weight > 0)) {
+            return false;
+        }
+    }
+    double min = 0;
+    double max = 0;
+    memcpy(&min, data + sizeof(uint32_t), sizeof(double));
+    memcpy(&max, data + sizeof(uint32_t) + sizeof(double), sizeof(double));
+    for (uint32_t i = 0; i < num_centroids; ++i) {
+        Centroid centroid;
+        memcpy(&centroid.mean, values + i * CENTROID_SIZE, sizeof(double));
+        memcpy(&centroid.weight, values + i * CENTROID_SIZE + sizeof(double), sizeof(double));
+        add(centroid.mean, centroid.weight);
+    }
+    if (num_centroids > 0) {
+        // the extremes were averaged into the first and last centroids
+        _min = std::min(_min, min);
+        _max = std::max(_max, max);
+    }
+    return true;
+}
+
+double TDigest::_q_limit(double q) const {
+    // scale function k(q) = compression / (2 * pi) * asin(2 * q - 1)
+    double k = _compression / (2 * M_PI) * asin(2 * q - 1) + 1;
+    if (k >= _compression / 4) {
+        return 1;
+    }
+    return (sin(k * 2 * M_PI / _compression) + 1) / 2;
+}
+
+void TDigest::_compress() {
+    if (_buffer.empty()) {
+        return;
+    }
+    _buffer.insert(_buffer.end(), _centroids.begin(), _centroids.end());
+    std::sort(_buffer.begin(), _buffer.end());
+    _total_weight += _buffer_weight;
+    _buffer_weight = 0;
+
+    _centroids.clear();
+    Centroid current = _buffer[0];
+    // weight of the centroids before 'current'
+    double weight_so_far = 0;
+    double q_limit = _q_limit(0);
+    for (size_t i = 1; i < _buffer.size(); ++i) {
+        const Centroid& next = _buffer[i];
+        double merged_weight = current.weight + next.weight;
+        if ((weight_so_far + merged_weight) / _total_weight <= q_limit) {
+            current.mean += (next.mean - current.mean) * next.weight / merged_weight;
+            current.weight = merged_weight;
+        } else {
+            weight_so_far += current.weight;
+            _centroids.push_back(current);
+            current = next;
+            q_limit = _q_limit(weight_so_far / _total_weight);
+        }
+    }
+    _centroids.push_back(current);
+    _buffer.clear();
+}
+
+double TDigest::quantile(double q) {
+    _compress();
+    if (_centroids.empty()) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    if (_centroids.size() == 1) {
+        return _centroids[0].mean;
+    }
+    q = std::max(0.0, std::min(1.0, q));
+    double index = q * _total_weight;
+
+    // a centroid stands for its weight spread around its mean, so its mean is at
+    // the cumulative weight before it plus half of its own
+    const Centroid& first = _centroids.front();
+    if (index < first.weight / 2) {
+        return _min + (first.mean - _min) * index / (first.weight / 2);
+    }
+    const Centroid& last = _centroids.back();
+    if (index > _total_weight - last.weight / 2) {
+        double remaining = _total_weight - index;
+        return _max - (_max - last.mean) * remaining / (last.weight / 2);
+    }
+    double weight_so_far = first.weight / 2;
+    for (size_t i = 0; i + 1 < _centroids.size(); ++i) {
+        const Centroid& left = _centroids[i];
+        const Centroid& right = _centroids[i + 1];
+        double gap = (left.weight + right.weight) / 2;
+        if (index <= weight_so_far + gap) {
+            return left.mean + (right.mean - left.mean) * (index - weight_so_far) / gap;
+        }
+        weight_so_far += gap;
+    }
+    return last.mean;
+}
+
+size_t TDigest::serialized_size() {
+    _compress();
+    return HEADER_SIZE + _centroids.size() * CENTROID_SIZE;
+}
+
+void TDigest::serialize(char* dst) {
+    _compress();
+    uint32_t num_centroids = _centroids.size();
+    memcpy(dst, &num_centroids, sizeof(uint32_t));
+    memcpy(dst + sizeof(uint32_t), &_min, sizeof(double));
+    memcpy(dst + sizeof(uint32_t) + sizeof(double), &_max, sizeof(double));
+    dst += HEADER_SIZE;
+    for (auto& centroid : _centroids) {
+        memcpy(dst, &centroid.mean, sizeof(double));
+        memcpy(dst + sizeof(double), &centroid.weight, sizeof(double));
+        dst += CENTROID_SIZE;
+    }
+}
+
+void TDigest::clear() {
+    _centroids.clear();
+    _total_weight = 0;
+    _buffer.clear();
+    _buffer_weight = 0;
+    _min = std::numeric_limits<double>::infinity();
+    _max = -std::numeric_limits<double>::infinity();
+}
+
+}
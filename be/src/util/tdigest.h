@@ -0,0 +1,111 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_COMMON_UTIL_TDIGEST_H
+#define BDG_PALO_BE_SRC_COMMON_UTIL_TDIGEST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace palo {
+
+// Mergeable sketch of a distribution of doubles for approximate quantiles, following
+// the merging t-digest of Ted Dunning. Values are summarized by sorted centroids
+// (mean, weight). A centroid may only span one unit of the scale function
+// k(q) = compression / (2 * pi) * asin(2 * q - 1), q being the quantile, so centroids
+// are small near the tails and quantiles such as p99 stay accurate. The digest keeps
+// at most about 'compression' centroids, whatever the number of values.
+//
+// Added values are buffered and merged into the centroids in batches.
+//
+// Serialized format, all numbers little endian:
+//   uint32 number of centroids
+//   double min, double max
+//   per centroid: double mean, double weight, in increasing order of mean
+class TDigest {
+public:
+    static const int32_t DEFAULT_COMPRESSION = 100;
+    // bytes of the serialized format before the centroids
+    static const size_t HEADER_SIZE = sizeof(uint32_t) + 2 * sizeof(double);
+
+    explicit TDigest(double compression = DEFAULT_COMPRESSION);
+
+    // Adds 'value' with the given weight. NaN values are ignored.
+    void add(double value, double weight = 1);
+
+    // Adds all values of 'other' to this digest.
+    void merge(const TDigest& other);
+
+    // Adds all values of a digest serialized by serialize() to this digest.
+    // Returns false, and leaves this digest unchanged, if 'data' is not a valid
+    // serialized digest.
+    bool merge(const char* data, size_t size);
+
+    // Replaces the content of this digest by a digest serialized by serialize().
+    bool deserialize(const char* data, size_t size) {
+        clear();
+        return merge(data, size);
+    }
+
+    // Returns the approximate value at quantile 'q', in [0, 1].
+    // Must not be called on an empty digest.
+    double quantile(double q);
+
+    // Sum of the weights of all values added.
+    double total_weight() const { return _total_weight + _buffer_weight; }
+
+    bool empty() const { return total_weight() == 0; }
+
+    // Number of bytes written by serialize(). Merges the buffered values first.
+    size_t serialized_size();
+
+    // Writes serialized_size() bytes to 'dst'.
+    void serialize(char* dst);
+
+    void clear();
+
+private:
+    struct Centroid {
+        double mean;
+        double weight;
+
+        bool operator<(const Centroid& other) const {
+            return mean < other.mean;
+        }
+    };
+
+    static const size_t CENTROID_SIZE = 2 * sizeof(double);
+
+    // Largest quantile the end of a centroid starting at quantile 'q' may reach.
+    double _q_limit(double q) const;
+
+    // Merges the buffered values into the centroids.
+    void _compress();
+
+    const double _compression;
+    // sorted by mean
+    std::vector<Centroid> _centroids;
+    double _total_weight;
+    // values not merged into _centroids yet
+    std::vector<Centroid> _buffer;
+    double _buffer_weight;
+    double _min;
+    double _max;
+};
+
+}
+
+#endif
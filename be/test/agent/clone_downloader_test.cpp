@@ -0,0 +1,181 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "agent/clone_downloader.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+#include "agent/mock_file_downloader.h"
+#include "common/config.h"
+#include "util/file_utils.h"
+#include "util/logging.h"
+
+using ::testing::_;
+using ::testing::DoAll;
+using ::testing::Return;
+using ::testing::SetArgPointee;
+using std::string;
+
+namespace palo {
+
+MockFileDownloader::MockFileDownloader(const FileDownloaderParam& param):FileDownloader(param) {
+}
+
+static const uint64_t CHUNK_SIZE = 1024 * 1024;
+static const string FILE_NAME = "10000_0_1_0_0.dat";
+
+class CloneDownloaderTest : public testing::Test {
+protected:
+    void SetUp() {
+        char buffer[1024];
+        ASSERT_TRUE(getcwd(buffer, sizeof(buffer)) != NULL);
+        _local_dir = string(buffer) + "/clone_downloader_test";
+        FileUtils::remove_all(_local_dir);
+        ASSERT_TRUE(FileUtils::create_dir(_local_dir).ok());
+
+        _chunk_mbytes = config::clone_download_chunk_mbytes;
+        _thread_num = config::clone_download_thread_num;
+        config::clone_download_chunk_mbytes = CHUNK_SIZE / 1024 / 1024;
+        // one download at a time keeps the order of the calls
+        config::clone_download_thread_num = 1;
+    }
+
+    void TearDown() {
+        config::clone_download_chunk_mbytes = _chunk_mbytes;
+        config::clone_download_thread_num = _thread_num;
+        FileUtils::remove_all(_local_dir);
+    }
+
+    string local_path() const {
+        return _local_dir + "/" + FILE_NAME;
+    }
+
+    string chunks_path() const {
+        return local_path() + ".chunks";
+    }
+
+    // Writes 'size' bytes of 'c' as the local file.
+    void write_local_file(uint64_t size, char c) {
+        std::ofstream file(local_path(), std::ios::trunc | std::ios::binary);
+        file << string(size, c);
+    }
+
+    void write_chunks(uint64_t chunk_size, const std::vector<uint32_t>& chunks) {
+        std::ofstream file(chunks_path(), std::ios::trunc);
+        file << chunk_size << "\n";
+        for (uint32_t chunk : chunks) {
+            file << chunk << "\n";
+        }
+    }
+
+    string local_md5sum(uint64_t offset, uint64_t length) {
+        string md5sum;
+        EXPECT_TRUE(FileUtils::md5sum(local_path(), offset, length, &md5sum).ok());
+        return md5sum;
+    }
+
+    string _local_dir;
+    int32_t _chunk_mbytes;
+    int32_t _thread_num;
+};
+
+// A failed clone left chunks 0 and 2 of 4, chunk 2 differs from the remote one.
+TEST_F(CloneDownloaderTest, resume_chunks) {
+    const uint64_t file_size = 3 * CHUNK_SIZE + 100;
+    write_local_file(file_size, 'a');
+    write_chunks(CHUNK_SIZE, {0, 2});
+
+    FileDownloader::FileDownloaderParam param;
+    MockFileDownloader file_downloader(param);
+    file_downloader._accept_ranges = true;
+    CloneDownloader downloader("http://127.0.0.1:8040/api/_tablet/_download?file=/dir/",
+                               _local_dir, "/disk");
+    downloader._file_downloader_ptr = &file_downloader;
+
+    EXPECT_CALL(file_downloader, get_length(_))
+            .WillOnce(DoAll(SetArgPointee<0>(file_size), Return(PALO_SUCCESS)));
+    EXPECT_CALL(file_downloader, get_md5sum(0, CHUNK_SIZE, _))
+            .WillOnce(DoAll(SetArgPointee<2>(local_md5sum(0, CHUNK_SIZE)),
+                            Return(PALO_SUCCESS)));
+    EXPECT_CALL(file_downloader, get_md5sum(2 * CHUNK_SIZE, CHUNK_SIZE, _))
+            .WillOnce(DoAll(SetArgPointee<2>(string(32, '0')), Return(PALO_SUCCESS)));
+    // chunk 0 is reused, the others are downloaded
+    EXPECT_CALL(file_downloader, download_range(0, _)).Times(0);
+    EXPECT_CALL(file_downloader, download_range(CHUNK_SIZE, CHUNK_SIZE))
+            .WillOnce(Return(PALO_SUCCESS));
+    EXPECT_CALL(file_downloader, download_range(2 * CHUNK_SIZE, CHUNK_SIZE))
+            .WillOnce(Return(PALO_SUCCESS));
+    EXPECT_CALL(file_downloader, download_range(3 * CHUNK_SIZE, 100))
+            .WillOnce(Return(PALO_SUCCESS));
+    EXPECT_CALL(file_downloader, download_file()).Times(0);
+
+    ASSERT_EQ(PALO_SUCCESS, downloader.download({FILE_NAME}));
+    ASSERT_EQ(CHUNK_SIZE, downloader.reused_bytes());
+    ASSERT_EQ(2 * CHUNK_SIZE + 100, downloader.downloaded_bytes());
+    // the file is complete
+    ASSERT_NE(0, access(chunks_path().c_str(), F_OK));
+    struct stat st;
+    ASSERT_EQ(0, stat(local_path().c_str(), &st));
+    ASSERT_EQ(file_size, st.st_size);
+}
+
+// A failed download keeps the list of the chunks done for the next clone.
+TEST_F(CloneDownloaderTest, keep_chunks_of_failed_download) {
+    const uint64_t file_size = 2 * CHUNK_SIZE;
+
+    FileDownloader::FileDownloaderParam param;
+    MockFileDownloader file_downloader(param);
+    file_downloader._accept_ranges = true;
+    CloneDownloader downloader("http://127.0.0.1:8040/api/_tablet/_download?file=/dir/",
+                               _local_dir, "/disk");
+    downloader._file_downloader_ptr = &file_downloader;
+
+    EXPECT_CALL(file_downloader, get_length(_))
+            .WillOnce(DoAll(SetArgPointee<0>(file_size), Return(PALO_SUCCESS)));
+    EXPECT_CALL(file_downloader, download_range(0, CHUNK_SIZE))
+            .WillOnce(Return(PALO_SUCCESS));
+    EXPECT_CALL(file_downloader, download_range(CHUNK_SIZE, CHUNK_SIZE))
+            .WillRepeatedly(Return(PALO_FILE_DOWNLOAD_FAILED));
+
+    ASSERT_EQ(PALO_ERROR, downloader.download({FILE_NAME}));
+    std::ifstream chunks_file(chunks_path());
+    ASSERT_TRUE(chunks_file.is_open());
+    uint64_t listed_chunk_size = 0;
+    uint32_t index = 1;
+    ASSERT_TRUE(chunks_file >> listed_chunk_size >> index);
+    ASSERT_EQ(CHUNK_SIZE, listed_chunk_size);
+    ASSERT_EQ(0, index);
+    ASSERT_FALSE(chunks_file >> index);
+}
+
+}  // namespace palo
+
+int main(int argc, char** argv) {
+    std::string conffile = std::string(getenv("PALO_HOME")) + "/conf/be.conf";
+    if (!palo::config::init(conffile.c_str(), false)) {
+        fprintf(stderr, "error read config file. \n");
+        return -1;
+    }
+    palo::init_glog("be-test");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -25,6 +25,8 @@ class MockFileDownloader : public FileDownloader {
 public:
     explicit MockFileDownloader(const FileDownloaderParam& param);
     MOCK_METHOD0(download_file, AgentStatus());
+    MOCK_METHOD2(download_range, AgentStatus(uint64_t offset, uint64_t length));
+    MOCK_METHOD3(get_md5sum, AgentStatus(uint64_t offset, uint64_t length, std::string* md5sum));
     MOCK_METHOD1(list_file_dir, AgentStatus(std::string* file_list_string));
     MOCK_METHOD1(get_length, AgentStatus(uint64_t* length));
 };  // class MockFileDownloader
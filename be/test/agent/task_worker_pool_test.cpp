@@ -826,6 +826,9 @@ TEST(TaskWorkerPoolTest, TestClone) {
     AgentUtils* original_agent_utils;
     original_agent_utils = task_worker_pool._agent_utils;
     task_worker_pool._agent_utils = &mock_agent_utils;
+    // one download at a time keeps the order of the calls
+    int32_t original_clone_download_thread_num = config::clone_download_thread_num;
+    config::clone_download_thread_num = 1;
 
     // Tablet has exist, get tablet info failed
     agent_task_request.clone_req.tablet_id = 123;
@@ -1023,8 +1026,9 @@ TEST(TaskWorkerPoolTest, TestClone) {
             .Times(clone_req.src_backends.size())
             .WillRepeatedly(
                     DoAll(SetArgPointee<0>("1.hdr\n1.idx\n1.dat"), Return(PALO_SUCCESS)));
+    // the data files are sized before they are downloaded
     EXPECT_CALL(mock_file_downloader, get_length(_))
-            .Times(clone_req.src_backends.size())
+            .Times(clone_req.src_backends.size() * 2)
             .WillRepeatedly(Return(PALO_SUCCESS));
     EXPECT_CALL(mock_file_downloader, download_file())
             .Times(clone_req.src_backends.size() * DOWNLOAD_FILE_MAX_RETRY)
@@ -1069,7 +1073,7 @@ TEST(TaskWorkerPoolTest, TestClone) {
                     DoAll(SetArgPointee<0>("1.hdr\n1.idx\n1.dat"), Return(PALO_SUCCESS)));
     uint64_t file_size = 5;
     EXPECT_CALL(mock_file_downloader, get_length(_))
-            .Times(clone_req.src_backends.size())
+            .Times(clone_req.src_backends.size() * 2)
             .WillRepeatedly(DoAll(SetArgPointee<0>(file_size), Return(PALO_SUCCESS)));
     EXPECT_CALL(mock_file_downloader, download_file())
             .Times(clone_req.src_backends.size() * DOWNLOAD_FILE_MAX_RETRY)
@@ -1116,6 +1120,10 @@ TEST(TaskWorkerPoolTest, TestClone) {
     EXPECT_CALL(mock_file_downloader, get_length(_))
             .Times(3)
             .WillRepeatedly(DoAll(SetArgPointee<0>(file_size), Return(PALO_SUCCESS)));
+    // the local files of the remote size are not the remote ones
+    EXPECT_CALL(mock_file_downloader, get_md5sum(0, file_size, _))
+            .Times(3)
+            .WillRepeatedly(Return(PALO_FILE_DOWNLOAD_GET_CHECKSUM_FAILED));
     EXPECT_CALL(mock_file_downloader, download_file())
             .Times(3)
             .WillRepeatedly(Return(PALO_SUCCESS));
@@ -1165,6 +1173,10 @@ TEST(TaskWorkerPoolTest, TestClone) {
     EXPECT_CALL(mock_file_downloader, get_length(_))
             .Times(3)
             .WillRepeatedly(DoAll(SetArgPointee<0>(file_size), Return(PALO_SUCCESS)));
+    // the local files of the remote size are not the remote ones
+    EXPECT_CALL(mock_file_downloader, get_md5sum(0, file_size, _))
+            .Times(3)
+            .WillRepeatedly(Return(PALO_FILE_DOWNLOAD_GET_CHECKSUM_FAILED));
     EXPECT_CALL(mock_file_downloader, download_file())
             .Times(3)
             .WillRepeatedly(Return(PALO_SUCCESS));
@@ -1190,7 +1202,7 @@ TEST(TaskWorkerPoolTest, TestClone) {
 
     // Tablet not exist, obtain root path success, make snapshot success
     // List remote dir success, get remote file length success
-    // Download file success, load header success
+    // Local files verified, load header success
     // Release snapshot success, get tablet info success
     EXPECT_CALL(mock_command_executor, get_table(
             agent_task_request.clone_req.tablet_id,
@@ -1215,9 +1227,17 @@ TEST(TaskWorkerPoolTest, TestClone) {
     EXPECT_CALL(mock_file_downloader, get_length(_))
             .Times(3)
             .WillRepeatedly(DoAll(SetArgPointee<0>(file_size), Return(PALO_SUCCESS)));
-    EXPECT_CALL(mock_file_downloader, download_file())
+    // the local files are the remote ones, left by a failed clone
+    EXPECT_CALL(mock_file_downloader, get_md5sum(0, file_size, _))
             .Times(3)
-            .WillRepeatedly(Return(PALO_SUCCESS));
+            .WillOnce(DoAll(SetArgPointee<2>("40b134ab8a3dee5dd9760a7805fd495c"),
+                            Return(PALO_SUCCESS)))
+            .WillOnce(DoAll(SetArgPointee<2>("348bd3ce10ec00ecc29d31ec97cd5839"),
+                            Return(PALO_SUCCESS)))
+            .WillOnce(DoAll(SetArgPointee<2>("1181c1834012245d785120e3505ed169"),
+                            Return(PALO_SUCCESS)));
+    EXPECT_CALL(mock_file_downloader, download_file())
+            .Times(0);
     EXPECT_CALL(mock_command_executor, load_header(_, _, _))
             .Times(1)
             .WillOnce(Return(OLAPStatus::OLAP_SUCCESS));
@@ -1243,6 +1263,7 @@ TEST(TaskWorkerPoolTest, TestClone) {
     task_worker_pool._agent_client = original_agent_server_client;
     task_worker_pool._agent_utils = original_agent_utils;
     task_worker_pool._file_downloader_ptr = original_file_downloader_ptr;
+    config::clone_download_thread_num = original_clone_download_thread_num;
 }
 
 TEST(TaskWorkerPoolTest, TestCancelDeleteData) {
@@ -0,0 +1,178 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "exec/aggregation_node.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "common/config.h"
+#include "common/object_pool.h"
+#include "runtime/descriptors.h"
+#include "runtime/mem_pool.h"
+#include "runtime/mem_tracker.h"
+#include "runtime/row_batch.h"
+#include "runtime/string_value.hpp"
+#include "runtime/tuple.h"
+#include "runtime/tuple_row.h"
+#include "testutil/desc_tbl_builder.h"
+#include "gen_cpp/PlanNodes_types.h"
+
+namespace palo {
+
+class AggregationNodeTest : public testing::Test {
+public:
+    AggregationNodeTest() : _worker_num(config::aggregation_worker_num) { }
+
+protected:
+    virtual void SetUp() {
+        config::aggregation_worker_num = 4;
+
+        DescriptorTblBuilder builder(&_pool);
+        builder.declare_tuple() << TYPE_INT << TypeDescriptor::create_varchar_type(32);
+        DescriptorTbl* desc_tbl = builder.build();
+        std::vector<bool> nullable_tuples(1, false);
+        std::vector<TTupleId> tuple_ids(1, static_cast<TTupleId>(0));
+        _row_desc = _pool.add(new RowDescriptor(*desc_tbl, tuple_ids, nullable_tuples));
+        _tuple_desc = desc_tbl->get_tuple_descriptor(0);
+    }
+
+    virtual void TearDown() {
+        config::aggregation_worker_num = _worker_num;
+    }
+
+    // Fills 'batch' with 'num_rows' rows whose tuples and strings live in its own pool,
+    // like the batches a scan returns.
+    void fill_batch(RowBatch* batch, int num_rows, const std::string& prefix) {
+        const SlotDescriptor* int_slot = _tuple_desc->slots()[0];
+        const SlotDescriptor* str_slot = _tuple_desc->slots()[1];
+        for (int i = 0; i < num_rows; ++i) {
+            int idx = batch->add_row();
+            TupleRow* row = batch->get_row(idx);
+            Tuple* tuple = Tuple::create(_tuple_desc->byte_size(), batch->tuple_data_pool());
+            tuple->set_not_null(int_slot->null_indicator_offset());
+            tuple->set_not_null(str_slot->null_indicator_offset());
+            *reinterpret_cast<int32_t*>(tuple->get_slot(int_slot->tuple_offset())) = i;
+            std::string value = prefix + std::to_string(i);
+            char* buf = reinterpret_cast<char*>(
+                batch->tuple_data_pool()->allocate(value.size()));
+            memcpy(buf, value.data(), value.size());
+            StringValue* str = tuple->get_string_slot(str_slot->tuple_offset());
+            str->ptr = buf;
+            str->len = value.size();
+            row->set_tuple(0, tuple);
+            batch->commit_last_row();
+        }
+    }
+
+    TPlanNode group_by_node() {
+        TPlanNode tnode;
+        tnode.node_type = TPlanNodeType::AGGREGATION_NODE;
+        tnode.limit = -1;
+        TExpr grouping_expr;
+        grouping_expr.nodes.push_back(TExprNode());
+        tnode.agg_node.grouping_exprs.push_back(grouping_expr);
+        tnode.agg_node.need_finalize = true;
+        return tnode;
+    }
+
+    TExpr aggregate_function(const std::string& name) {
+        TExprNode node;
+        node.fn.name.function_name = name;
+        TExpr expr;
+        expr.nodes.push_back(node);
+        return expr;
+    }
+
+    ObjectPool _pool;
+    MemTracker _tracker;
+    RowDescriptor* _row_desc;
+    TupleDescriptor* _tuple_desc;
+    int _worker_num;
+};
+
+// The child batch is reset and refilled while the workers still consume the queued
+// copy, so the copy must not point into the child batch.
+TEST_F(AggregationNodeTest, queued_batch_outlives_child_batch) {
+    const int num_rows = 100;
+    RowBatch child_batch(*_row_desc, num_rows, &_tracker);
+    fill_batch(&child_batch, num_rows, "value_");
+
+    RowBatch queued(*_row_desc, child_batch.num_rows(), &_tracker);
+    child_batch.deep_copy_to(&queued);
+    ASSERT_EQ(num_rows, queued.num_rows());
+
+    child_batch.reset();
+    fill_batch(&child_batch, num_rows, "other_");
+    child_batch.reset();
+
+    const SlotDescriptor* int_slot = _tuple_desc->slots()[0];
+    const SlotDescriptor* str_slot = _tuple_desc->slots()[1];
+    for (int i = 0; i < num_rows; ++i) {
+        Tuple* tuple = queued.get_row(i)->get_tuple(0);
+        ASSERT_EQ(i, *reinterpret_cast<int32_t*>(tuple->get_slot(int_slot->tuple_offset())));
+        ASSERT_EQ("value_" + std::to_string(i),
+                  tuple->get_string_slot(str_slot->tuple_offset())->to_string());
+    }
+}
+
+TEST_F(AggregationNodeTest, can_aggregate_parallel) {
+    TPlanNode tnode = group_by_node();
+    tnode.agg_node.aggregate_functions.push_back(aggregate_function("sum"));
+    ASSERT_TRUE(AggregationNode::can_aggregate_parallel(tnode));
+
+    // a single worker keeps the serial aggregation
+    config::aggregation_worker_num = 1;
+    ASSERT_FALSE(AggregationNode::can_aggregate_parallel(tnode));
+    config::aggregation_worker_num = 4;
+
+    // no grouping
+    TPlanNode no_group = tnode;
+    no_group.agg_node.grouping_exprs.clear();
+    ASSERT_FALSE(AggregationNode::can_aggregate_parallel(no_group));
+
+    // streaming preaggregation
+    TPlanNode streaming = tnode;
+    streaming.agg_node.__set_use_streaming_preaggregation(true);
+    streaming.agg_node.need_finalize = false;
+    ASSERT_FALSE(AggregationNode::can_aggregate_parallel(streaming));
+    // merge aggregations which finalize are not streamed
+    streaming.agg_node.need_finalize = true;
+    ASSERT_TRUE(AggregationNode::can_aggregate_parallel(streaming));
+
+    // distinct group by with limit
+    TPlanNode limited = group_by_node();
+    limited.limit = 10;
+    ASSERT_FALSE(AggregationNode::can_aggregate_parallel(limited));
+    limited.agg_node.aggregate_functions.push_back(aggregate_function("count"));
+    ASSERT_TRUE(AggregationNode::can_aggregate_parallel(limited));
+
+    // distinct aggregates
+    TPlanNode distinct = tnode;
+    distinct.agg_node.aggregate_functions.push_back(aggregate_function("count_distinct"));
+    ASSERT_FALSE(AggregationNode::can_aggregate_parallel(distinct));
+    distinct = tnode;
+    distinct.agg_node.aggregate_functions.push_back(aggregate_function("sum_distinct"));
+    ASSERT_FALSE(AggregationNode::can_aggregate_parallel(distinct));
+}
+
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -21,6 +21,7 @@
 
 #include <gtest/gtest.h>
 
+#include "common/config.h"
 #include "common/object_pool.h"
 #include "runtime/tuple.h"
 #include "exec/local_file_reader.h"
@@ -344,6 +345,8 @@ void BrokerScanNodeTest::init() {
 }
 
 TEST_F(BrokerScanNodeTest, normal) {
+    // one scanner returns the ranges in order
+    config::broker_scanner_thread_num = 1;
     BrokerScanNode scan_node(&_obj_pool, _tnode, *_desc_tbl);
     auto status = scan_node.prepare(&_runtime_state);
     ASSERT_TRUE(status.ok());
@@ -421,6 +424,53 @@ TEST_F(BrokerScanNodeTest, normal) {
     }
 }
 
+TEST_F(BrokerScanNodeTest, parallel) {
+    config::broker_scanner_thread_num = 3;
+    BrokerScanNode scan_node(&_obj_pool, _tnode, *_desc_tbl);
+    auto status = scan_node.prepare(&_runtime_state);
+    ASSERT_TRUE(status.ok());
+
+    // more ranges than scanners, 3 rows each
+    std::vector<TScanRangeParams> scan_ranges;
+    for (int i = 0; i < 5; ++i) {
+        TScanRangeParams scan_range_params;
+
+        TBrokerScanRange broker_scan_range;
+        broker_scan_range.params = _params;
+
+        TBrokerRangeDesc range;
+        range.path = "./be/test/exec/test_data/broker_scanner/normal.csv";
+        range.start_offset = 0;
+        range.size = -1;
+        range.file_type = TFileType::FILE_LOCAL;
+        range.format_type = TFileFormatType::FORMAT_CSV_PLAIN;
+        range.splittable = true;
+        broker_scan_range.ranges.push_back(range);
+
+        scan_range_params.scan_range.__set_broker_scan_range(broker_scan_range);
+
+        scan_ranges.push_back(scan_range_params);
+    }
+
+    scan_node.set_scan_ranges(scan_ranges);
+
+    status = scan_node.open(&_runtime_state);
+    ASSERT_TRUE(status.ok());
+
+    RowBatch batch(scan_node.row_desc(), 1024, _runtime_state.instance_mem_tracker());
+    int num_rows = 0;
+    bool eos = false;
+    while (!eos) {
+        batch.reset();
+        status = scan_node.get_next(&_runtime_state, &batch, &eos);
+        ASSERT_TRUE(status.ok());
+        num_rows += batch.num_rows();
+    }
+    ASSERT_EQ(15, num_rows);
+
+    scan_node.close(&_runtime_state);
+}
+
 }
 
 int main(int argc, char** argv) {
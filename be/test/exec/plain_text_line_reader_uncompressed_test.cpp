@@ -235,6 +235,40 @@ TEST_F(PlainTextLineReaderTest, uncompressed_test_limit5) {
     ASSERT_TRUE(eof);
 }
 
+TEST_F(PlainTextLineReaderTest, uncompressed_field_positions) {
+    LocalFileReader file_reader("./be/test/exec/test_data/plain_text_line_reader/test_file.csv", 0);
+    auto st = file_reader.open();
+    ASSERT_TRUE(st.ok());
+
+    Decompressor* decompressor;
+    st = Decompressor::create_decompressor(CompressType::UNCOMPRESSED, &decompressor);
+    ASSERT_TRUE(st.ok());
+
+    PlainTextLineReader line_reader(&_profile, &file_reader, decompressor, -1, '\n');
+    line_reader.set_field_delimiter(',');
+    const uint8_t* ptr;
+    size_t size;
+    bool eof;
+
+    // 1,2
+    st = line_reader.read_line(&ptr, &size, &eof);
+    ASSERT_TRUE(st.ok());
+    ASSERT_EQ(3, size);
+    ASSERT_EQ(std::vector<size_t>({1}), line_reader.field_positions());
+
+    // Empty
+    st = line_reader.read_line(&ptr, &size, &eof);
+    ASSERT_TRUE(st.ok());
+    ASSERT_EQ(0, size);
+    ASSERT_TRUE(line_reader.field_positions().empty());
+
+    // 1,2,3,4
+    st = line_reader.read_line(&ptr, &size, &eof);
+    ASSERT_TRUE(st.ok());
+    ASSERT_EQ(7, size);
+    ASSERT_EQ(std::vector<size_t>({1, 3, 5}), line_reader.field_positions());
+}
+
 } // end namespace palo
 
 int main(int argc, char** argv) {
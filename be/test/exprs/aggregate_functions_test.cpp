@@ -0,0 +1,117 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "exprs/aggregate_functions.h"
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "exprs/expr_context.h"
+#include "runtime/mem_pool.h"
+#include "runtime/mem_tracker.h"
+#include "udf/udf_internal.h"
+
+namespace palo {
+
+using palo_udf::FunctionContext;
+using palo_udf::StringVal;
+
+class AggregateFunctionsTest : public testing::Test {
+public:
+    AggregateFunctionsTest() : _mem_pool(&_mem_tracker) { }
+
+    virtual void SetUp() {
+        FunctionContext::TypeDesc return_type;
+        return_type.type = FunctionContext::TYPE_VARCHAR;
+        std::vector<FunctionContext::TypeDesc> arg_types;
+        arg_types.push_back(return_type);
+        _ctx = FunctionContextImpl::create_context(
+                NULL, &_mem_pool, return_type, arg_types, 0, false);
+    }
+
+    virtual void TearDown() {
+        _ctx->impl()->close();
+        delete _ctx;
+    }
+
+protected:
+    // Aggregates each value of 'values' as a group of its own and serializes it, like
+    // the rows a streaming preaggregation passes through. The serialized values are
+    // copied to 'out_pool'.
+    void pass_through(const std::vector<std::string>& values, MemPool* out_pool,
+                      std::vector<StringVal>* out) {
+        for (const std::string& value : values) {
+            StringVal dst;
+            AggregateFunctions::init_null_string(_ctx, &dst);
+            // what the update of min or max keeps
+            uint8_t* copy = _ctx->allocate(value.size());
+            memcpy(copy, value.data(), value.size());
+            dst = StringVal(copy, value.size());
+
+            StringVal serialized = AggregateFunctions::string_val_serialize_or_finalize(_ctx, dst);
+            uint8_t* out_copy = out_pool->allocate(serialized.len);
+            memcpy(out_copy, serialized.ptr, serialized.len);
+            out->push_back(StringVal(out_copy, serialized.len));
+        }
+    }
+
+    MemTracker _mem_tracker;
+    MemPool _mem_pool;
+    FunctionContext* _ctx;
+};
+
+TEST_F(AggregateFunctionsTest, serialize_allocations_freed_per_batch) {
+    std::vector<std::string> values;
+    for (int i = 0; i < 100; ++i) {
+        values.push_back("value_" + std::to_string(i) + std::string(i % 10, 'x'));
+    }
+
+    MemTracker out_tracker;
+    int64_t consumption = 0;
+    for (int batch = 0; batch < 10; ++batch) {
+        MemPool out_pool(&out_tracker);
+        std::vector<StringVal> out;
+        pass_through(values, &out_pool, &out);
+        ASSERT_FALSE(_ctx->impl()->check_local_allocations_empty());
+        ExprContext::free_local_allocations(std::vector<FunctionContext*>(1, _ctx));
+        ASSERT_TRUE(_ctx->impl()->check_local_allocations_empty());
+        ASSERT_TRUE(_ctx->impl()->check_allocations_empty());
+
+        // the copies survive the free
+        ASSERT_EQ(values.size(), out.size());
+        for (int i = 0; i < values.size(); ++i) {
+            ASSERT_EQ(values[i], std::string(reinterpret_cast<char*>(out[i].ptr), out[i].len));
+        }
+
+        // the freed memory is reused by the next batch instead of growing
+        if (batch == 0) {
+            consumption = _mem_tracker.consumption();
+            ASSERT_GT(consumption, 0);
+        } else {
+            ASSERT_EQ(consumption, _mem_tracker.consumption());
+        }
+    }
+}
+
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,144 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "exprs/flat_hash_set.h"
+
+#include <set>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "runtime/mem_pool.h"
+#include "runtime/mem_tracker.h"
+#include "udf/udf_internal.h"
+
+namespace palo {
+
+class FlatHashSetTest : public testing::Test {
+public:
+    FlatHashSetTest() : _mem_pool(&_mem_tracker) { }
+
+    virtual void SetUp() {
+        FunctionContext::TypeDesc return_type;
+        return_type.type = FunctionContext::TYPE_BIGINT;
+        std::vector<FunctionContext::TypeDesc> arg_types;
+        _ctx = FunctionContextImpl::create_context(
+                NULL, &_mem_pool, return_type, arg_types, 0, false);
+    }
+
+    virtual void TearDown() {
+        _ctx->impl()->close();
+        delete _ctx;
+    }
+
+protected:
+    MemTracker _mem_tracker;
+    MemPool _mem_pool;
+    FunctionContext* _ctx;
+};
+
+TEST_F(FlatHashSetTest, inline_values) {
+    FlatHashSet<int64_t> set;
+    ASSERT_EQ(0, set.size());
+    for (int64_t i = 0; i < FlatHashSet<int64_t>::INLINE_CAPACITY; ++i) {
+        set.insert(_ctx, i + 1);
+        set.insert(_ctx, i + 1);
+    }
+    ASSERT_EQ(FlatHashSet<int64_t>::INLINE_CAPACITY, set.size());
+    // nothing is allocated while the values fit inline
+    ASSERT_EQ(0, _mem_tracker.consumption());
+    ASSERT_TRUE(set.contains(1));
+    ASSERT_FALSE(set.contains(0));
+    set.release(_ctx);
+}
+
+TEST_F(FlatHashSetTest, zero_value) {
+    FlatHashSet<int32_t> set;
+    set.insert(_ctx, 0);
+    set.insert(_ctx, 0);
+    set.insert(_ctx, 5);
+    ASSERT_EQ(2, set.size());
+    ASSERT_TRUE(set.contains(0));
+    int64_t sum = 0;
+    int count = 0;
+    set.for_each([&](int32_t value) { sum += value; ++count; });
+    ASSERT_EQ(5, sum);
+    ASSERT_EQ(2, count);
+    set.release(_ctx);
+}
+
+TEST_F(FlatHashSetTest, grow) {
+    FlatHashSet<int64_t> set;
+    std::set<int64_t> expected;
+    for (int64_t i = 0; i < 100000; ++i) {
+        int64_t value = (i * 7919) % 30011 - 15000;
+        set.insert(_ctx, value);
+        expected.insert(value);
+    }
+    ASSERT_EQ(static_cast<int64_t>(expected.size()), set.size());
+    for (int64_t value : expected) {
+        ASSERT_TRUE(set.contains(value));
+    }
+    ASSERT_FALSE(set.contains(1000000));
+    // the table is accounted in the mem tracker of the function context
+    ASSERT_GT(_mem_tracker.consumption(), static_cast<int64_t>(expected.size() * sizeof(int64_t)));
+
+    std::vector<int64_t> values(set.size());
+    uint8_t* end = set.copy_to(reinterpret_cast<uint8_t*>(&values[0]));
+    ASSERT_EQ(reinterpret_cast<uint8_t*>(&values[0] + values.size()), end);
+    ASSERT_EQ(expected, std::set<int64_t>(values.begin(), values.end()));
+    set.release(_ctx);
+    ASSERT_EQ(0, set.size());
+}
+
+TEST_F(FlatHashSetTest, reserve) {
+    FlatHashSet<__int128> set;
+    set.reserve(_ctx, 1000);
+    int64_t consumption = _mem_tracker.consumption();
+    for (int i = 0; i < 1000; ++i) {
+        set.insert(_ctx, static_cast<__int128>(i) << 64);
+    }
+    ASSERT_EQ(1000, set.size());
+    // no rehash happened after reserve()
+    ASSERT_EQ(consumption, _mem_tracker.consumption());
+    set.release(_ctx);
+}
+
+TEST_F(FlatHashSetTest, table_too_big) {
+    FlatHashSet<int64_t> set;
+    for (int64_t i = 1; i <= 100; ++i) {
+        set.insert(_ctx, i);
+    }
+    int64_t consumption = _mem_tracker.consumption();
+    ASSERT_FALSE(_ctx->has_error());
+
+    // 2^29 slots of 8 bytes do not fit in an int
+    set.reserve(_ctx, 1L << 28);
+    ASSERT_TRUE(_ctx->has_error());
+    ASSERT_EQ(consumption, _mem_tracker.consumption());
+
+    // the current table is kept
+    ASSERT_EQ(100, set.size());
+    for (int64_t i = 1; i <= 100; ++i) {
+        ASSERT_TRUE(set.contains(i));
+    }
+    set.release(_ctx);
+}
+
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,79 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "http/download_action.h"
+
+#include <gtest/gtest.h>
+
+namespace palo {
+
+class DownloadActionTest : public testing::Test {
+};
+
+TEST_F(DownloadActionTest, parse_range) {
+    int64_t offset = -1;
+    int64_t length = -1;
+    ASSERT_EQ(DownloadAction::RANGE_SATISFIABLE,
+              DownloadAction::parse_range("bytes=0-99", 1000, &offset, &length));
+    ASSERT_EQ(0, offset);
+    ASSERT_EQ(100, length);
+
+    // open and past the end ranges end with the file
+    ASSERT_EQ(DownloadAction::RANGE_SATISFIABLE,
+              DownloadAction::parse_range("bytes=900-", 1000, &offset, &length));
+    ASSERT_EQ(900, offset);
+    ASSERT_EQ(100, length);
+    ASSERT_EQ(DownloadAction::RANGE_SATISFIABLE,
+              DownloadAction::parse_range("bytes=990-2000", 1000, &offset, &length));
+    ASSERT_EQ(990, offset);
+    ASSERT_EQ(10, length);
+
+    // suffix ranges
+    ASSERT_EQ(DownloadAction::RANGE_SATISFIABLE,
+              DownloadAction::parse_range("bytes=-10", 1000, &offset, &length));
+    ASSERT_EQ(990, offset);
+    ASSERT_EQ(10, length);
+    ASSERT_EQ(DownloadAction::RANGE_SATISFIABLE,
+              DownloadAction::parse_range("bytes=-2000", 1000, &offset, &length));
+    ASSERT_EQ(0, offset);
+    ASSERT_EQ(1000, length);
+
+    ASSERT_EQ(DownloadAction::RANGE_NOT_SATISFIABLE,
+              DownloadAction::parse_range("bytes=1000-", 1000, &offset, &length));
+    ASSERT_EQ(DownloadAction::RANGE_NOT_SATISFIABLE,
+              DownloadAction::parse_range("bytes=-0", 1000, &offset, &length));
+    ASSERT_EQ(DownloadAction::RANGE_NOT_SATISFIABLE,
+              DownloadAction::parse_range("bytes=0-", 0, &offset, &length));
+
+    // the whole file is sent for the others
+    ASSERT_EQ(DownloadAction::RANGE_NONE,
+              DownloadAction::parse_range("items=0-99", 1000, &offset, &length));
+    ASSERT_EQ(DownloadAction::RANGE_NONE,
+              DownloadAction::parse_range("bytes=0-9,20-29", 1000, &offset, &length));
+    ASSERT_EQ(DownloadAction::RANGE_NONE,
+              DownloadAction::parse_range("bytes=99-0", 1000, &offset, &length));
+    ASSERT_EQ(DownloadAction::RANGE_NONE,
+              DownloadAction::parse_range("bytes=a-9", 1000, &offset, &length));
+    ASSERT_EQ(DownloadAction::RANGE_NONE,
+              DownloadAction::parse_range("bytes=-", 1000, &offset, &length));
+}
+
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,203 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "olap/base_compaction.h"
+#include "olap/command_executor.h"
+#include "olap/i_data.h"
+#include "olap/olap_define.h"
+#include "olap/olap_engine.h"
+#include "olap/olap_main.cpp"
+#include "olap/row_cursor.h"
+#include "olap/utils.h"
+#include "olap/writer.h"
+#include "util/logging.h"
+
+using namespace std;
+
+namespace palo {
+
+static const uint32_t MAX_PATH_LEN = 1024;
+
+void set_default_create_tablet_request(TCreateTabletReq* request) {
+    request->tablet_id = 10009;
+    request->__set_version(1);
+    request->__set_version_hash(0);
+    request->tablet_schema.schema_hash = 270068381;
+    request->tablet_schema.short_key_column_count = 2;
+    request->tablet_schema.keys_type = TKeysType::DUP_KEYS;
+    request->tablet_schema.storage_type = TStorageType::COLUMN;
+
+    TColumn k1;
+    k1.column_name = "k1";
+    k1.__set_is_key(true);
+    k1.column_type.type = TPrimitiveType::INT;
+    request->tablet_schema.columns.push_back(k1);
+
+    TColumn k2;
+    k2.column_name = "k2";
+    k2.__set_is_key(true);
+    k2.column_type.type = TPrimitiveType::INT;
+    request->tablet_schema.columns.push_back(k2);
+
+    TColumn v;
+    v.column_name = "v";
+    v.__set_is_key(false);
+    v.column_type.type = TPrimitiveType::BIGINT;
+    request->tablet_schema.columns.push_back(v);
+}
+
+class TestBaseCompaction : public testing::Test {
+protected:
+    void SetUp() {
+        char buffer[MAX_PATH_LEN];
+        getcwd(buffer, MAX_PATH_LEN);
+        config::storage_root_path = string(buffer) + "/data_base_compaction";
+        remove_all_dir(config::storage_root_path);
+        ASSERT_EQ(create_dir(config::storage_root_path), OLAP_SUCCESS);
+        OLAPRootPath::get_instance()->reload_root_paths(config::storage_root_path.c_str());
+
+        // small blocks so that a version splits into several key ranges
+        _rows_per_block = config::default_num_rows_per_column_file_block;
+        config::default_num_rows_per_column_file_block = 16;
+
+        _command_executor = new(nothrow) CommandExecutor();
+        ASSERT_TRUE(_command_executor != NULL);
+        set_default_create_tablet_request(&_create_tablet);
+        ASSERT_EQ(OLAP_SUCCESS, _command_executor->create_table(_create_tablet));
+        _olap_table = _command_executor->get_table(
+                _create_tablet.tablet_id, _create_tablet.tablet_schema.schema_hash);
+        ASSERT_TRUE(_olap_table.get() != NULL);
+        _tablet_path = _olap_table->construct_dir_path();
+    }
+
+    void TearDown() {
+        config::default_num_rows_per_column_file_block = _rows_per_block;
+        _olap_table.reset();
+        OLAPEngine::get_instance()->drop_table(
+                _create_tablet.tablet_id, _create_tablet.tablet_schema.schema_hash);
+        while (0 == access(_tablet_path.c_str(), F_OK)) {
+            sleep(1);
+        }
+        ASSERT_EQ(OLAP_SUCCESS, remove_all_dir(config::storage_root_path));
+        SAFE_DELETE(_command_executor);
+    }
+
+    // Writes 'num_k1' * 'num_k2' rows keyed by (k1, k2) in key order.
+    OLAPIndex* write_version(int32_t version, int num_k1, int num_k2) {
+        OLAPIndex* index = new OLAPIndex(
+                _olap_table.get(), Version(version, version), version, false, 0, 0);
+        IWriter* writer = IWriter::create(_olap_table, index, false);
+        EXPECT_TRUE(writer != NULL);
+        EXPECT_EQ(OLAP_SUCCESS, writer->init());
+
+        RowCursor row;
+        EXPECT_EQ(OLAP_SUCCESS, row.init(_olap_table->tablet_schema()));
+        for (int k1 = 0; k1 < num_k1; ++k1) {
+            for (int k2 = 0; k2 < num_k2; ++k2) {
+                EXPECT_EQ(OLAP_SUCCESS, writer->attached_by(&row));
+                row.set_not_null(0);
+                row.set_not_null(1);
+                row.set_not_null(2);
+                EXPECT_EQ(OLAP_SUCCESS, row.from_string(
+                        {std::to_string(k1), std::to_string(k2), std::to_string(version)}));
+                writer->next(row);
+            }
+        }
+        EXPECT_EQ(OLAP_SUCCESS, writer->finalize());
+        delete writer;
+
+        EXPECT_EQ(OLAP_SUCCESS, index->load());
+        _olap_table->obtain_header_wrlock();
+        EXPECT_EQ(OLAP_SUCCESS, _olap_table->register_data_source(index));
+        _olap_table->release_header_lock();
+        return index;
+    }
+
+    std::string _tablet_path;
+    SmartOLAPTable _olap_table;
+    TCreateTabletReq _create_tablet;
+    CommandExecutor* _command_executor;
+    int32_t _rows_per_block;
+};
+
+TEST_F(TestBaseCompaction, selectivities_of_key_ranges) {
+    // k1 has 2 values and every one spans several key ranges
+    OLAPIndex* index = write_version(2, 2, 100);
+    write_version(3, 2, 100);
+
+    BaseCompaction base_compaction;
+    base_compaction._table = _olap_table;
+    base_compaction._new_base_version = Version(0, 3);
+
+    vector<RowCursor*> boundaries;
+    ASSERT_EQ(OLAP_SUCCESS, base_compaction._split_key_ranges(index, 4, &boundaries));
+    ASSERT_EQ(3, boundaries.size());
+
+    vector<Version> versions = {Version(2, 2), Version(3, 3)};
+    vector<IData*> data_sources;
+    _olap_table->obtain_header_rdlock();
+    _olap_table->acquire_data_sources_by_versions(versions, &data_sources);
+    _olap_table->release_header_lock();
+    ASSERT_EQ(2, data_sources.size());
+
+    OLAPIndex* new_base = new OLAPIndex(_olap_table.get(), Version(0, 3), 100, false, 0, 0);
+    uint64_t merged_rows = 0;
+    uint64_t filted_rows = 0;
+    vector<uint32_t> selectivities;
+    uint64_t row_count = 0;
+    OLAPStatus res = base_compaction._merge_key_ranges(
+            new_base, boundaries, &data_sources,
+            &merged_rows, &filted_rows, &selectivities, &row_count);
+    _olap_table->release_data_sources(&data_sources);
+    for (RowCursor* boundary : boundaries) {
+        delete boundary;
+    }
+
+    ASSERT_EQ(OLAP_SUCCESS, res);
+    ASSERT_EQ(400, row_count);
+    ASSERT_EQ(OLAP_SUCCESS, new_base->load());
+    ASSERT_EQ(400, new_base->num_rows());
+    // 2 distinct k1 and 200 distinct (k1, k2), as a single merge counts them
+    ASSERT_EQ(2, selectivities.size());
+    ASSERT_EQ(200, selectivities[0]);
+    ASSERT_EQ(2, selectivities[1]);
+
+    new_base->delete_all_files();
+    delete new_base;
+}
+
+}  // namespace palo
+
+int main(int argc, char** argv) {
+    std::string conffile = std::string(getenv("PALO_HOME")) + "/conf/be.conf";
+    if (!palo::config::init(conffile.c_str(), false)) {
+        fprintf(stderr, "error read config file. \n");
+        return -1;
+    }
+    palo::init_glog("be-test");
+    testing::InitGoogleTest(&argc, argv);
+    palo::touch_all_singleton();
+    int ret = RUN_ALL_TESTS();
+    google::protobuf::ShutdownProtobufLibrary();
+    return ret;
+}
@@ -30,6 +30,7 @@
 #include "olap/command_executor.h"
 #include "olap/field.h"
 #include "olap/olap_engine.h"
+#include "olap/olap_meta.h"
 #include "olap/olap_main.cpp"
 #include "olap/olap_table.h"
 #include "olap/utils.h"
@@ -235,7 +236,11 @@ TEST_F(TestCreateTable, create_tablet) {
     SmartOLAPTable tablet = _command_executor->get_table(
             request.tablet_id, request.tablet_schema.schema_hash);
     ASSERT_TRUE(tablet.get() != NULL);
-    ASSERT_EQ(0, access(tablet->header_file_name().c_str(), F_OK));
+    // the header is kept in the meta only
+    ASSERT_NE(0, access(tablet->header_file_name().c_str(), F_OK));
+    std::string header;
+    ASSERT_EQ(OLAP_SUCCESS, OLAPEngine::get_instance()->get_meta(config::storage_root_path)
+              ->get_header(tablet->construct_dir_path(), &header));
 
     Version base_version(0, request.version);
     string index_name = tablet->construct_index_file_path(base_version, request.version_hash, 0);
@@ -274,7 +279,11 @@ TEST_F(TestCreateTable, column_create_tablet) {
     SmartOLAPTable tablet = _command_executor->get_table(
             request.tablet_id, request.tablet_schema.schema_hash);
     ASSERT_TRUE(tablet.get() != NULL);
-    ASSERT_EQ(0, access(tablet->header_file_name().c_str(), F_OK));
+    // the header is kept in the meta only
+    ASSERT_NE(0, access(tablet->header_file_name().c_str(), F_OK));
+    std::string header;
+    ASSERT_EQ(OLAP_SUCCESS, OLAPEngine::get_instance()->get_meta(config::storage_root_path)
+              ->get_header(tablet->construct_dir_path(), &header));
 
     Version base_version(0, request.version);
     string index_name = tablet->construct_index_file_path(base_version, request.version_hash, 0);
@@ -1476,7 +1485,7 @@ public:
         SmartOLAPTable tablet = _command_executor->get_table(
                 _create_tablet.tablet_id, _create_tablet.tablet_schema.schema_hash);
         ASSERT_TRUE(tablet.get() != NULL);
-        _header_file_name = tablet->header_file_name();
+        _tablet_path = tablet->construct_dir_path();
 
         // push data
         set_default_push_request(_create_tablet, &_push_req);
@@ -1490,12 +1499,12 @@ public:
         // Remove all dir.
         OLAPEngine::get_instance()->drop_table(
                 _create_tablet.tablet_id, _create_tablet.tablet_schema.schema_hash);
-        ASSERT_EQ(access(_header_file_name.c_str(), F_OK), -1);
+        ASSERT_EQ(access(_tablet_path.c_str(), F_OK), -1);
         ASSERT_EQ(OLAP_SUCCESS, remove_all_dir(config::storage_root_path));
     }
     
     CommandExecutor* _command_executor;
-    std::string _header_file_name;
+    std::string _tablet_path;
     TCreateTabletReq _create_tablet;
     TPushReq _push_req;
 };
@@ -1518,7 +1527,7 @@ TEST_F(TestClone, make_snapshot_abnormal) {
     SmartOLAPTable tablet = _command_executor->get_table(
             request.tablet_id, request.tablet_schema.schema_hash);
     ASSERT_TRUE(tablet.get() != NULL);
-    std::string header_file_name = tablet->header_file_name();
+    std::string tablet_path = tablet->construct_dir_path();
 
     res = _command_executor->make_snapshot(
             request.tablet_id, request.tablet_schema.schema_hash, &snapshot_path);
@@ -1528,7 +1537,7 @@ TEST_F(TestClone, make_snapshot_abnormal) {
     tablet.reset();
     OLAPEngine::get_instance()->drop_table(
             request.tablet_id, request.tablet_schema.schema_hash);
-    ASSERT_EQ(access(header_file_name.c_str(), F_OK), -1);
+    ASSERT_EQ(access(tablet_path.c_str(), F_OK), -1);
 }
 
 TEST_F(TestClone, make_snapshot) {
@@ -1624,7 +1633,7 @@ TEST_F(TestClone, load_header) {
     // to avoid delete tablet has same name: .delete.schema_hash.datetime
     OLAPEngine::get_instance()->drop_table(
             _create_tablet.tablet_id, _create_tablet.tablet_schema.schema_hash);
-    ASSERT_EQ(access(_header_file_name.c_str(), F_OK), -1);
+    ASSERT_EQ(access(_tablet_path.c_str(), F_OK), -1);
     system(("rm -fr " + root_path + "/[^s]*").c_str());
     system(("cp -r " + snapshot_path + "/* " + root_path).c_str());
 
@@ -1672,7 +1681,7 @@ public:
         SmartOLAPTable tablet = _command_executor->get_table(
                 _create_tablet.tablet_id, _create_tablet.tablet_schema.schema_hash);
         ASSERT_TRUE(tablet.get() != NULL);
-        _header_file_name = tablet->header_file_name();
+        _tablet_path = tablet->construct_dir_path();
 
         // push data
         set_default_push_request(_create_tablet, &_push_req);
@@ -1686,14 +1695,14 @@ public:
         // Remove all dir.
         OLAPEngine::get_instance()->drop_table(
                 _create_tablet.tablet_id, _create_tablet.tablet_schema.schema_hash);
-        while (0 == access(_header_file_name.c_str(), F_OK)) {
+        while (0 == access(_tablet_path.c_str(), F_OK)) {
             sleep(1);
         }
         ASSERT_EQ(OLAP_SUCCESS, remove_all_dir(config::storage_root_path));
     }
     
     CommandExecutor* _command_executor;
-    std::string _header_file_name;
+    std::string _tablet_path;
     TCreateTabletReq _create_tablet;
     TPushReq _push_req;
 };
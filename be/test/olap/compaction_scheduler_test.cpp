@@ -0,0 +1,275 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "olap/command_executor.h"
+#include "olap/compaction_scheduler.h"
+#include "olap/cumulative_compaction.h"
+#include "olap/olap_define.h"
+#include "olap/olap_engine.h"
+#include "olap/olap_main.cpp"
+#include "olap/row_cursor.h"
+#include "olap/utils.h"
+#include "olap/writer.h"
+#include "util/logging.h"
+
+using namespace std;
+
+namespace palo {
+
+static const uint32_t MAX_PATH_LEN = 1024;
+
+void set_default_create_tablet_request(TCreateTabletReq* request) {
+    request->tablet_id = 10008;
+    request->__set_version(1);
+    request->__set_version_hash(0);
+    request->tablet_schema.schema_hash = 270068380;
+    request->tablet_schema.short_key_column_count = 1;
+    request->tablet_schema.keys_type = TKeysType::DUP_KEYS;
+    request->tablet_schema.storage_type = TStorageType::COLUMN;
+
+    TColumn k1;
+    k1.column_name = "k1";
+    k1.__set_is_key(true);
+    k1.column_type.type = TPrimitiveType::INT;
+    request->tablet_schema.columns.push_back(k1);
+
+    TColumn v;
+    v.column_name = "v";
+    v.__set_is_key(false);
+    v.column_type.type = TPrimitiveType::BIGINT;
+    request->tablet_schema.columns.push_back(v);
+}
+
+class TestCompactionScheduler : public testing::Test {
+protected:
+    void SetUp() {
+        char buffer[MAX_PATH_LEN];
+        getcwd(buffer, MAX_PATH_LEN);
+        config::storage_root_path = string(buffer) + "/data_compaction_scheduler";
+        remove_all_dir(config::storage_root_path);
+        ASSERT_EQ(create_dir(config::storage_root_path), OLAP_SUCCESS);
+        OLAPRootPath::get_instance()->reload_root_paths(config::storage_root_path.c_str());
+
+        _num_singleton_deltas = config::cumulative_compaction_num_singleton_deltas;
+        config::cumulative_compaction_num_singleton_deltas = 5;
+        _disk_budget_mbytes = config::compaction_disk_budget_mbytes;
+
+        _command_executor = new(nothrow) CommandExecutor();
+        ASSERT_TRUE(_command_executor != NULL);
+        set_default_create_tablet_request(&_create_tablet);
+        ASSERT_EQ(OLAP_SUCCESS, _command_executor->create_table(_create_tablet));
+        _olap_table = _command_executor->get_table(
+                _create_tablet.tablet_id, _create_tablet.tablet_schema.schema_hash);
+        ASSERT_TRUE(_olap_table.get() != NULL);
+        _tablet_path = _olap_table->construct_dir_path();
+
+        // fewer deltas than cumulative_compaction_num_singleton_deltas
+        for (int32_t version = 2; version <= 4; ++version) {
+            write_version(version);
+        }
+    }
+
+    void TearDown() {
+        config::cumulative_compaction_num_singleton_deltas = _num_singleton_deltas;
+        config::compaction_disk_budget_mbytes = _disk_budget_mbytes;
+        _olap_table.reset();
+        OLAPEngine::get_instance()->drop_table(
+                _create_tablet.tablet_id, _create_tablet.tablet_schema.schema_hash);
+        while (0 == access(_tablet_path.c_str(), F_OK)) {
+            sleep(1);
+        }
+        ASSERT_EQ(OLAP_SUCCESS, remove_all_dir(config::storage_root_path));
+        SAFE_DELETE(_command_executor);
+    }
+
+    void write_version(int32_t version) {
+        OLAPIndex* index = new OLAPIndex(
+                _olap_table.get(), Version(version, version), version, false, 0, 0);
+        IWriter* writer = IWriter::create(_olap_table, index, false);
+        ASSERT_TRUE(writer != NULL);
+        ASSERT_EQ(OLAP_SUCCESS, writer->init());
+
+        RowCursor row;
+        ASSERT_EQ(OLAP_SUCCESS, row.init(_olap_table->tablet_schema()));
+        for (int i = 0; i < 100; ++i) {
+            ASSERT_EQ(OLAP_SUCCESS, writer->attached_by(&row));
+            row.set_not_null(0);
+            row.set_not_null(1);
+            ASSERT_EQ(OLAP_SUCCESS,
+                      row.from_string({std::to_string(i), std::to_string(version)}));
+            writer->next(row);
+        }
+        ASSERT_EQ(OLAP_SUCCESS, writer->finalize());
+        delete writer;
+
+        ASSERT_EQ(OLAP_SUCCESS, index->load());
+        _olap_table->obtain_header_wrlock();
+        OLAPStatus res = _olap_table->register_data_source(index);
+        _olap_table->release_header_lock();
+        ASSERT_EQ(OLAP_SUCCESS, res);
+    }
+
+    int num_versions() {
+        _olap_table->obtain_header_rdlock();
+        int num = _olap_table->file_version_size();
+        _olap_table->release_header_lock();
+        return num;
+    }
+
+    // Returns the queued candidates of the table.
+    vector<CompactionScheduler::Candidate> queued(CompactionScheduler* scheduler) {
+        vector<CompactionScheduler::Candidate> candidates;
+        AutoMutexLock auto_lock(&scheduler->_mutex);
+        for (const CompactionScheduler::Candidate& candidate : scheduler->_queue) {
+            if (candidate.tablet_id == _create_tablet.tablet_id) {
+                candidates.push_back(candidate);
+            }
+        }
+        return candidates;
+    }
+
+    static CompactionScheduler::Candidate make_candidate(
+            TTabletId tablet_id, CompactionScheduler::CompactionType type,
+            const string& root_path, int64_t bytes) {
+        CompactionScheduler::Candidate candidate;
+        candidate.tablet_id = tablet_id;
+        candidate.type = type;
+        candidate.root_path = root_path;
+        candidate.bytes = bytes;
+        return candidate;
+    }
+
+    std::string _tablet_path;
+    SmartOLAPTable _olap_table;
+    TCreateTabletReq _create_tablet;
+    CommandExecutor* _command_executor;
+    int64_t _num_singleton_deltas;
+    int64_t _disk_budget_mbytes;
+};
+
+TEST_F(TestCompactionScheduler, relaxed_cumulative_policy) {
+    // versions 0-1, 2, 3 and 4
+    ASSERT_EQ(4, num_versions());
+
+    CumulativeCompaction by_config;
+    ASSERT_EQ(OLAP_ERR_CUMULATIVE_NO_SUITABLE_VERSIONS, by_config.init(_olap_table));
+
+    CumulativeCompaction relaxed;
+    ASSERT_EQ(OLAP_SUCCESS, relaxed.init(_olap_table, 2));
+    ASSERT_EQ(OLAP_SUCCESS, relaxed.run());
+    ASSERT_LT(num_versions(), 4);
+    // the newest delta is never merged
+    ASSERT_EQ(4, _olap_table->cumulative_layer_point());
+}
+
+TEST_F(TestCompactionScheduler, scanned_tablet_is_compacted) {
+    CompactionScheduler* scheduler = CompactionScheduler::get_instance();
+
+    // too few deltas for a tablet nobody reads
+    scheduler->_schedule();
+    ASSERT_TRUE(queued(scheduler).empty());
+
+    _olap_table->record_scan();
+    _olap_table->record_scan();
+    scheduler->_schedule();
+    vector<CompactionScheduler::Candidate> candidates = queued(scheduler);
+    ASSERT_EQ(1, candidates.size());
+    ASSERT_EQ(CompactionScheduler::CUMULATIVE_COMPACTION, candidates[0].type);
+    ASSERT_EQ(3, candidates[0].num_versions);
+    ASSERT_EQ(2, candidates[0].recent_scans);
+    ASSERT_DOUBLE_EQ(3 * (1 + 2), candidates[0].score);
+
+    // the worker runs it with the same relaxed policy
+    CompactionScheduler::Candidate candidate;
+    scheduler->_take_candidate(&candidate);
+    ASSERT_EQ(_create_tablet.tablet_id, candidate.tablet_id);
+    scheduler->_run(candidate);
+    scheduler->_finish(candidate);
+    ASSERT_LT(num_versions(), 4);
+    ASSERT_TRUE(scheduler->_running.empty());
+    ASSERT_EQ(0, scheduler->_disk_running_bytes[candidate.root_path]);
+}
+
+TEST_F(TestCompactionScheduler, disk_budget) {
+    // a busy disk takes no other compaction
+    config::compaction_disk_budget_mbytes = 0;
+    CompactionScheduler* scheduler = CompactionScheduler::get_instance();
+    {
+        AutoMutexLock auto_lock(&scheduler->_mutex);
+        scheduler->_queue.clear();
+        scheduler->_queue.push_back(make_candidate(
+                1, CompactionScheduler::CUMULATIVE_COMPACTION, "/disk1", 100));
+        scheduler->_queue.push_back(make_candidate(
+                1, CompactionScheduler::BASE_COMPACTION, "/disk1", 10));
+        scheduler->_queue.push_back(make_candidate(
+                2, CompactionScheduler::CUMULATIVE_COMPACTION, "/disk1", 10));
+        scheduler->_queue.push_back(make_candidate(
+                3, CompactionScheduler::CUMULATIVE_COMPACTION, "/disk2", 100));
+    }
+
+    CompactionScheduler::Candidate first;
+    scheduler->_take_candidate(&first);
+    ASSERT_EQ(1, first.tablet_id);
+    ASSERT_EQ(CompactionScheduler::CUMULATIVE_COMPACTION, first.type);
+
+    // tablet 1 is running and disk1 is busy
+    CompactionScheduler::Candidate second;
+    scheduler->_take_candidate(&second);
+    ASSERT_EQ(3, second.tablet_id);
+    ASSERT_EQ(100, scheduler->_disk_running_bytes["/disk1"]);
+    ASSERT_EQ(100, scheduler->_disk_running_bytes["/disk2"]);
+
+    scheduler->_finish(first);
+    CompactionScheduler::Candidate third;
+    scheduler->_take_candidate(&third);
+    ASSERT_EQ(1, third.tablet_id);
+    ASSERT_EQ(CompactionScheduler::BASE_COMPACTION, third.type);
+
+    scheduler->_finish(third);
+    CompactionScheduler::Candidate fourth;
+    scheduler->_take_candidate(&fourth);
+    ASSERT_EQ(2, fourth.tablet_id);
+
+    scheduler->_finish(second);
+    scheduler->_finish(fourth);
+    ASSERT_TRUE(scheduler->_queue.empty());
+    ASSERT_TRUE(scheduler->_running.empty());
+    ASSERT_EQ(0, scheduler->_disk_running_bytes["/disk1"]);
+    ASSERT_EQ(0, scheduler->_disk_running_bytes["/disk2"]);
+}
+
+}  // namespace palo
+
+int main(int argc, char** argv) {
+    std::string conffile = std::string(getenv("PALO_HOME")) + "/conf/be.conf";
+    if (!palo::config::init(conffile.c_str(), false)) {
+        fprintf(stderr, "error read config file. \n");
+        return -1;
+    }
+    palo::init_glog("be-test");
+    testing::InitGoogleTest(&argc, argv);
+    palo::touch_all_singleton();
+    int ret = RUN_ALL_TESTS();
+    google::protobuf::ShutdownProtobufLibrary();
+    return ret;
+}
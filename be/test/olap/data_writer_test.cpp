@@ -0,0 +1,229 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "olap/column_file/data_writer.h"
+#include "olap/command_executor.h"
+#include "olap/i_data.h"
+#include "olap/olap_define.h"
+#include "olap/olap_engine.h"
+#include "olap/olap_main.cpp"
+#include "olap/reader.h"
+#include "olap/row_cursor.h"
+#include "olap/utils.h"
+#include "olap/writer.h"
+#include "util/logging.h"
+#include "util/thread_pool.hpp"
+
+using namespace std;
+
+namespace palo {
+
+static const uint32_t MAX_PATH_LEN = 1024;
+
+void set_default_create_tablet_request(TCreateTabletReq* request) {
+    request->tablet_id = 10010;
+    request->__set_version(1);
+    request->__set_version_hash(0);
+    request->tablet_schema.schema_hash = 270068382;
+    request->tablet_schema.short_key_column_count = 1;
+    request->tablet_schema.keys_type = TKeysType::DUP_KEYS;
+    request->tablet_schema.storage_type = TStorageType::COLUMN;
+
+    TColumn k1;
+    k1.column_name = "k1";
+    k1.__set_is_key(true);
+    k1.column_type.type = TPrimitiveType::INT;
+    request->tablet_schema.columns.push_back(k1);
+
+    TColumn v;
+    v.column_name = "v";
+    v.__set_is_key(false);
+    v.column_type.type = TPrimitiveType::BIGINT;
+    request->tablet_schema.columns.push_back(v);
+}
+
+class TestColumnDataWriter : public testing::Test {
+protected:
+    void SetUp() {
+        char buffer[MAX_PATH_LEN];
+        getcwd(buffer, MAX_PATH_LEN);
+        config::storage_root_path = string(buffer) + "/data_data_writer";
+        remove_all_dir(config::storage_root_path);
+        ASSERT_EQ(create_dir(config::storage_root_path), OLAP_SUCCESS);
+        OLAPRootPath::get_instance()->reload_root_paths(config::storage_root_path.c_str());
+
+        // small blocks, so that a few rows fill many blocks
+        _rows_per_block = config::default_num_rows_per_column_file_block;
+        config::default_num_rows_per_column_file_block = 16;
+        _pipeline_depth = config::push_write_pipeline_depth;
+        config::push_write_pipeline_depth = 2;
+
+        _command_executor = new(nothrow) CommandExecutor();
+        ASSERT_TRUE(_command_executor != NULL);
+        set_default_create_tablet_request(&_create_tablet);
+        ASSERT_EQ(OLAP_SUCCESS, _command_executor->create_table(_create_tablet));
+        _olap_table = _command_executor->get_table(
+                _create_tablet.tablet_id, _create_tablet.tablet_schema.schema_hash);
+        ASSERT_TRUE(_olap_table.get() != NULL);
+        _tablet_path = _olap_table->construct_dir_path();
+    }
+
+    void TearDown() {
+        config::default_num_rows_per_column_file_block = _rows_per_block;
+        config::push_write_pipeline_depth = _pipeline_depth;
+        _olap_table.reset();
+        OLAPEngine::get_instance()->drop_table(
+                _create_tablet.tablet_id, _create_tablet.tablet_schema.schema_hash);
+        while (0 == access(_tablet_path.c_str(), F_OK)) {
+            sleep(1);
+        }
+        ASSERT_EQ(OLAP_SUCCESS, remove_all_dir(config::storage_root_path));
+        SAFE_DELETE(_command_executor);
+    }
+
+    // Creates a push writer of 'index', which writes through the pipeline.
+    column_file::ColumnDataWriter* create_push_writer(OLAPIndex* index) {
+        IWriter* writer = IWriter::create(_olap_table, index, true);
+        EXPECT_TRUE(writer != NULL);
+        EXPECT_EQ(OLAP_SUCCESS, writer->init());
+        column_file::ColumnDataWriter* column_writer =
+                dynamic_cast<column_file::ColumnDataWriter*>(writer);
+        EXPECT_TRUE(column_writer != NULL);
+        EXPECT_TRUE(column_writer->_pipelined);
+        return column_writer;
+    }
+
+    // Writes row i as (i, i * 10).
+    OLAPStatus write_row(IWriter* writer, RowCursor* row, int i) {
+        OLAPStatus res = writer->attached_by(row);
+        if (res != OLAP_SUCCESS) {
+            return res;
+        }
+        row->set_not_null(0);
+        row->set_not_null(1);
+        res = row->from_string({std::to_string(i), std::to_string(i * 10)});
+        if (res != OLAP_SUCCESS) {
+            return res;
+        }
+        writer->next(*row);
+        return OLAP_SUCCESS;
+    }
+
+    std::string _tablet_path;
+    SmartOLAPTable _olap_table;
+    TCreateTabletReq _create_tablet;
+    CommandExecutor* _command_executor;
+    int32_t _rows_per_block;
+    int32_t _pipeline_depth;
+};
+
+TEST_F(TestColumnDataWriter, pipelined_round_trip) {
+    const int num_rows = 1000;
+    OLAPIndex* index = new OLAPIndex(_olap_table.get(), Version(2, 2), 2, false, 0, 0);
+    column_file::ColumnDataWriter* writer = create_push_writer(index);
+    // a new segment after every block
+    writer->_max_segment_size = 1;
+
+    RowCursor row;
+    ASSERT_EQ(OLAP_SUCCESS, row.init(_olap_table->tablet_schema()));
+    for (int i = 0; i < num_rows; ++i) {
+        ASSERT_EQ(OLAP_SUCCESS, write_row(writer, &row, i));
+    }
+    ASSERT_EQ(OLAP_SUCCESS, writer->finalize());
+    delete writer;
+
+    ASSERT_EQ(OLAP_SUCCESS, index->load());
+    ASSERT_GT(index->num_segments(), 1);
+    ASSERT_EQ(num_rows, index->num_rows());
+    _olap_table->obtain_header_wrlock();
+    ASSERT_EQ(OLAP_SUCCESS, _olap_table->register_data_source(index));
+    _olap_table->release_header_lock();
+
+    vector<IData*> data_sources;
+    _olap_table->obtain_header_rdlock();
+    _olap_table->acquire_data_sources_by_versions({Version(2, 2)}, &data_sources);
+    _olap_table->release_header_lock();
+    ASSERT_EQ(1, data_sources.size());
+
+    Reader reader;
+    ReaderParams reader_params;
+    reader_params.olap_table = _olap_table;
+    reader_params.reader_type = READER_CUMULATIVE_COMPACTION;
+    reader_params.olap_data_arr = data_sources;
+    ASSERT_EQ(OLAP_SUCCESS, reader.init(reader_params));
+
+    RowCursor read_row;
+    ASSERT_EQ(OLAP_SUCCESS, read_row.init(_olap_table->tablet_schema()));
+    int num_read = 0;
+    bool eof = false;
+    while (true) {
+        ASSERT_EQ(OLAP_SUCCESS, reader.next_row_with_aggregation(&read_row, &eof));
+        if (eof) {
+            break;
+        }
+        ASSERT_EQ(num_read, *(int32_t*)read_row.get_field_content_ptr(0));
+        ASSERT_EQ(num_read * 10, *(int64_t*)read_row.get_field_content_ptr(1));
+        ++num_read;
+    }
+    ASSERT_EQ(num_rows, num_read);
+    _olap_table->release_data_sources(&data_sources);
+}
+
+TEST_F(TestColumnDataWriter, encode_error) {
+    OLAPIndex* index = new OLAPIndex(_olap_table.get(), Version(2, 2), 2, false, 0, 0);
+    // the encode thread fails to offer the columns of its first block
+    ThreadPool stopped_pool(1, 1);
+    stopped_pool.shutdown();
+    column_file::ColumnDataWriter* writer = create_push_writer(index);
+    writer->_encode_pool = &stopped_pool;
+
+    RowCursor row;
+    ASSERT_EQ(OLAP_SUCCESS, row.init(_olap_table->tablet_schema()));
+    OLAPStatus res = OLAP_SUCCESS;
+    for (int i = 0; i < 1000 && res == OLAP_SUCCESS; ++i) {
+        res = write_row(writer, &row, i);
+    }
+    // the error of the encode thread is returned by a later attached_by()
+    ASSERT_NE(OLAP_SUCCESS, res);
+    ASSERT_NE(OLAP_SUCCESS, writer->finalize());
+    delete writer;
+
+    index->delete_all_files();
+    delete index;
+}
+
+}  // namespace palo
+
+int main(int argc, char** argv) {
+    std::string conffile = std::string(getenv("PALO_HOME")) + "/conf/be.conf";
+    if (!palo::config::init(conffile.c_str(), false)) {
+        fprintf(stderr, "error read config file. \n");
+        return -1;
+    }
+    palo::init_glog("be-test");
+    testing::InitGoogleTest(&argc, argv);
+    palo::touch_all_singleton();
+    int ret = RUN_ALL_TESTS();
+    google::protobuf::ShutdownProtobufLibrary();
+    return ret;
+}
@@ -175,7 +175,7 @@ protected:
         _olap_table = _command_executor->get_table(
                 _create_tablet.tablet_id, _create_tablet.tablet_schema.schema_hash);
         ASSERT_TRUE(_olap_table.get() != NULL);
-        _header_file_name = _olap_table->header_file_name();
+        _tablet_path = _olap_table->construct_dir_path();
     }
 
     OLAPStatus push_empty_delta(int32_t version) {
@@ -193,7 +193,7 @@ protected:
         _olap_table.reset();
         OLAPEngine::get_instance()->drop_table(
                 _create_tablet.tablet_id, _create_tablet.tablet_schema.schema_hash);
-        while (0 == access(_header_file_name.c_str(), F_OK)) {
+        while (0 == access(_tablet_path.c_str(), F_OK)) {
             sleep(1);
         }
         ASSERT_EQ(OLAP_SUCCESS, remove_all_dir(config::storage_root_path));
@@ -203,7 +203,7 @@ protected:
 
     typedef RepeatedPtrField<DeleteDataConditionMessage> del_cond_array;
 
-    std::string _header_file_name;
+    std::string _tablet_path;
     SmartOLAPTable _olap_table;
     TCreateTabletReq _create_tablet;
     CommandExecutor* _command_executor;
@@ -492,7 +492,7 @@ protected:
         _olap_table = _command_executor->get_table(
                 _create_tablet.tablet_id, _create_tablet.tablet_schema.schema_hash);
         ASSERT_TRUE(_olap_table.get() != NULL);
-        _header_file_name = _olap_table->header_file_name();
+        _tablet_path = _olap_table->construct_dir_path();
     }
 
     void TearDown() {
@@ -500,7 +500,7 @@ protected:
         _olap_table.reset();
         OLAPEngine::get_instance()->drop_table(
                 _create_tablet.tablet_id, _create_tablet.tablet_schema.schema_hash);
-        while (0 == access(_header_file_name.c_str(), F_OK)) {
+        while (0 == access(_tablet_path.c_str(), F_OK)) {
             sleep(1);
         }
         ASSERT_EQ(OLAP_SUCCESS, remove_all_dir(config::storage_root_path));
@@ -510,7 +510,7 @@ protected:
 
     typedef RepeatedPtrField<DeleteDataConditionMessage> del_cond_array;
 
-    std::string _header_file_name;
+    std::string _tablet_path;
     SmartOLAPTable _olap_table;
     TCreateTabletReq _create_tablet;
     CommandExecutor* _command_executor;
@@ -807,7 +807,7 @@ protected:
         _olap_table = _command_executor->get_table(
                 _create_tablet.tablet_id, _create_tablet.tablet_schema.schema_hash);
         ASSERT_TRUE(_olap_table.get() != NULL);
-        _header_file_name = _olap_table->header_file_name();
+        _tablet_path = _olap_table->construct_dir_path();
 
         _data_row_cursor.init(_olap_table->tablet_schema());
         _data_row_cursor.allocate_memory_for_string_type(_olap_table->tablet_schema());
@@ -829,7 +829,7 @@ protected:
         _delete_handler.finalize();
         OLAPEngine::get_instance()->drop_table(
                 _create_tablet.tablet_id, _create_tablet.tablet_schema.schema_hash);
-        while (0 == access(_header_file_name.c_str(), F_OK)) {
+        while (0 == access(_tablet_path.c_str(), F_OK)) {
             sleep(1);
         }
         ASSERT_EQ(OLAP_SUCCESS, remove_all_dir(config::storage_root_path));
@@ -839,7 +839,7 @@ protected:
 
     typedef RepeatedPtrField<DeleteDataConditionMessage> del_cond_array;
 
-    std::string _header_file_name;
+    std::string _tablet_path;
     RowCursor _data_row_cursor;
     SmartOLAPTable _olap_table;
     TCreateTabletReq _create_tablet;
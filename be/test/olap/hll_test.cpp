@@ -0,0 +1,106 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "olap/hll.h"
+
+#include <vector>
+#include <gtest/gtest.h>
+
+namespace palo {
+
+class HllTest : public testing::Test {
+};
+
+TEST_F(HllTest, merge_registers) {
+    // odd length to cover the scalar tail
+    const int len = 16384 + 7;
+    std::vector<uint8_t> dst(len);
+    std::vector<uint8_t> src(len);
+    for (int i = 0; i < len; ++i) {
+        dst[i] = i % 61;
+        src[i] = (i * 7) % 53;
+    }
+    std::vector<uint8_t> expected(len);
+    for (int i = 0; i < len; ++i) {
+        expected[i] = std::max(dst[i], src[i]);
+    }
+    HllSetHelper::merge_registers(&dst[0], &src[0], len);
+    ASSERT_EQ(expected, dst);
+}
+
+TEST_F(HllTest, sparse) {
+    char registers[HLL_REGISTERS_COUNT];
+    memset(registers, 0, HLL_REGISTERS_COUNT);
+    registers[3] = 5;
+    registers[300] = 1;
+    registers[HLL_REGISTERS_COUNT - 1] = 12;
+    ASSERT_EQ(3, HllSetHelper::count_non_zero_registers(registers, HLL_REGISTERS_COUNT));
+
+    char buf[HLL_COLUMN_DEFAULT_LEN];
+    int len = 0;
+    HllSetHelper::set_sparse(buf, registers, HLL_REGISTERS_COUNT, len);
+    ASSERT_EQ(1 + 4 + 3 * 3, len);
+
+    HllSetResolver resolver;
+    resolver.init(buf, len);
+    resolver.parse();
+    ASSERT_EQ(HLL_DATA_SPRASE, resolver.get_hll_data_type());
+    ASSERT_EQ(3, resolver.get_sparse_count());
+    ASSERT_EQ(300, resolver.get_sparse_index(1));
+    ASSERT_EQ(1, resolver.get_sparse_value(1));
+
+    char merged[HLL_REGISTERS_COUNT];
+    memset(merged, 0, HLL_REGISTERS_COUNT);
+    merged[3] = 7;
+    merged[4] = 2;
+    resolver.fill_registers(merged, HLL_REGISTERS_COUNT);
+    ASSERT_EQ(7, merged[3]);
+    ASSERT_EQ(2, merged[4]);
+    ASSERT_EQ(1, merged[300]);
+    ASSERT_EQ(12, merged[HLL_REGISTERS_COUNT - 1]);
+
+    // a truncated set only exposes its complete pairs
+    resolver.init(buf, len - 1);
+    resolver.parse();
+    ASSERT_EQ(2, resolver.get_sparse_count());
+}
+
+TEST_F(HllTest, full) {
+    char buf[HLL_COLUMN_DEFAULT_LEN];
+    char registers[HLL_REGISTERS_COUNT];
+    for (int i = 0; i < HLL_REGISTERS_COUNT; ++i) {
+        registers[i] = i % 9;
+    }
+    int len = 0;
+    HllSetHelper::set_full(buf, registers, HLL_REGISTERS_COUNT, len);
+    ASSERT_EQ(HLL_COLUMN_DEFAULT_LEN, len);
+
+    HllSetResolver resolver;
+    resolver.init(buf, len);
+    resolver.parse();
+    char merged[HLL_REGISTERS_COUNT];
+    memset(merged, 4, HLL_REGISTERS_COUNT);
+    resolver.fill_registers(merged, HLL_REGISTERS_COUNT);
+    for (int i = 0; i < HLL_REGISTERS_COUNT; ++i) {
+        ASSERT_EQ(std::max(4, i % 9), merged[i]);
+    }
+}
+
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
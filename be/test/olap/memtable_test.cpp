@@ -0,0 +1,224 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "olap/command_executor.h"
+#include "olap/memtable.h"
+#include "olap/olap_define.h"
+#include "olap/olap_engine.h"
+#include "olap/olap_main.cpp"
+#include "olap/row_cursor.h"
+#include "olap/utils.h"
+#include "olap/writer.h"
+#include "runtime/mem_pool.h"
+#include "runtime/mem_tracker.h"
+#include "util/logging.h"
+
+using namespace std;
+
+namespace palo {
+
+static const uint32_t MAX_PATH_LEN = 1024;
+
+// Keeps the rows flushed by a memtable instead of writing a delta.
+class RowCollector : public IWriter {
+public:
+    RowCollector(SmartOLAPTable table) :
+            IWriter(true, table), _mem_tracker(-1), _mem_pool(&_mem_tracker) {}
+
+    OLAPStatus attached_by(RowCursor* row_cursor) override {
+        char* buf = reinterpret_cast<char*>(_mem_pool.allocate(row_cursor->get_fixed_len()));
+        row_cursor->attach(buf);
+        _rows.push_back(buf);
+        return OLAP_SUCCESS;
+    }
+    OLAPStatus finalize() override { return OLAP_SUCCESS; }
+    OLAPStatus write_row_block(RowBlock* row_block) override {
+        return OLAP_ERR_FUNC_NOT_IMPLEMENTED;
+    }
+    uint64_t written_bytes() override { return 0; }
+    MemPool* mem_pool() override { return &_mem_pool; }
+
+    // the rows in flush order, their values separated by commas
+    vector<string> rows() {
+        RowCursor row;
+        row.init(_table->tablet_schema());
+        vector<string> rows;
+        for (char* buf : _rows) {
+            row.attach(buf);
+            rows.push_back(row.to_string(","));
+        }
+        return rows;
+    }
+
+private:
+    MemTracker _mem_tracker;
+    MemPool _mem_pool;
+    vector<char*> _rows;
+};
+
+void set_create_tablet_request(TKeysType::type keys_type, bool with_varchar,
+                               TCreateTabletReq* request) {
+    request->tablet_id = 10006;
+    request->__set_version(1);
+    request->__set_version_hash(0);
+    request->tablet_schema.schema_hash = 270068378;
+    request->tablet_schema.short_key_column_count = 1;
+    request->tablet_schema.keys_type = keys_type;
+    request->tablet_schema.storage_type = TStorageType::COLUMN;
+
+    TColumn k1;
+    k1.column_name = "k1";
+    k1.__set_is_key(true);
+    k1.column_type.type = TPrimitiveType::INT;
+    request->tablet_schema.columns.push_back(k1);
+
+    TColumn v1;
+    v1.column_name = "v1";
+    v1.__set_is_key(false);
+    v1.column_type.type = TPrimitiveType::BIGINT;
+    if (keys_type != TKeysType::DUP_KEYS) {
+        v1.__set_aggregation_type(TAggregationType::SUM);
+    }
+    request->tablet_schema.columns.push_back(v1);
+
+    if (with_varchar) {
+        TColumn v2;
+        v2.column_name = "v2";
+        v2.__set_is_key(false);
+        v2.column_type.__set_len(16);
+        v2.column_type.type = TPrimitiveType::VARCHAR;
+        v2.__set_aggregation_type(TAggregationType::REPLACE);
+        request->tablet_schema.columns.push_back(v2);
+    }
+}
+
+class TestMemTable : public testing::Test {
+protected:
+    void SetUp() {
+        char buffer[MAX_PATH_LEN];
+        getcwd(buffer, MAX_PATH_LEN);
+        config::storage_root_path = string(buffer) + "/data_memtable";
+        remove_all_dir(config::storage_root_path);
+        ASSERT_EQ(create_dir(config::storage_root_path), OLAP_SUCCESS);
+        OLAPRootPath::get_instance()->reload_root_paths(config::storage_root_path.c_str());
+
+        _command_executor = new(nothrow) CommandExecutor();
+        ASSERT_TRUE(_command_executor != NULL);
+    }
+
+    void TearDown() {
+        if (_olap_table.get() != NULL) {
+            string tablet_path = _olap_table->construct_dir_path();
+            _olap_table.reset();
+            OLAPEngine::get_instance()->drop_table(
+                    _create_tablet.tablet_id, _create_tablet.tablet_schema.schema_hash);
+            while (0 == access(tablet_path.c_str(), F_OK)) {
+                sleep(1);
+            }
+        }
+        ASSERT_EQ(OLAP_SUCCESS, remove_all_dir(config::storage_root_path));
+        SAFE_DELETE(_command_executor);
+    }
+
+    void create_table(TKeysType::type keys_type, bool with_varchar) {
+        set_create_tablet_request(keys_type, with_varchar, &_create_tablet);
+        ASSERT_EQ(OLAP_SUCCESS, _command_executor->create_table(_create_tablet));
+        _olap_table = _command_executor->get_table(
+                _create_tablet.tablet_id, _create_tablet.tablet_schema.schema_hash);
+        ASSERT_TRUE(_olap_table.get() != NULL);
+    }
+
+    // Inserts 'rows' into a new memtable in this order and returns the flushed rows.
+    void insert_and_flush(const vector<vector<string>>& rows, vector<string>* flushed) {
+        MemTable mem_table(_olap_table);
+        ASSERT_EQ(OLAP_SUCCESS, mem_table.init());
+
+        const vector<FieldInfo>& tablet_schema = _olap_table->tablet_schema();
+        RowCursor row;
+        ASSERT_EQ(OLAP_SUCCESS, row.init(tablet_schema));
+        ASSERT_EQ(OLAP_SUCCESS, row.allocate_memory_for_string_type(tablet_schema));
+        int64_t memory_usage = mem_table.memory_usage();
+        for (const vector<string>& values : rows) {
+            for (size_t i = 0; i < values.size(); ++i) {
+                row.set_not_null(i);
+            }
+            ASSERT_EQ(OLAP_SUCCESS, row.from_string(values));
+            ASSERT_EQ(OLAP_SUCCESS, mem_table.insert(row));
+            ASSERT_GE(mem_table.memory_usage(), memory_usage);
+            memory_usage = mem_table.memory_usage();
+        }
+        ASSERT_EQ(rows.size(), mem_table.num_rows());
+        ASSERT_GT(memory_usage, 0);
+
+        RowCollector collector(_olap_table);
+        ASSERT_EQ(OLAP_SUCCESS, collector.init());
+        ASSERT_EQ(OLAP_SUCCESS, mem_table.flush(&collector));
+        *flushed = collector.rows();
+    }
+
+    CommandExecutor* _command_executor;
+    TCreateTabletReq _create_tablet;
+    SmartOLAPTable _olap_table;
+};
+
+TEST_F(TestMemTable, aggregate_in_place) {
+    create_table(TKeysType::AGG_KEYS, false);
+    vector<string> flushed;
+    insert_and_flush({{"3", "1"}, {"1", "10"}, {"3", "2"}, {"2", "5"}, {"1", "20"}},
+                     &flushed);
+    ASSERT_EQ(vector<string>({"1,30", "2,5", "3,3"}), flushed);
+}
+
+TEST_F(TestMemTable, aggregate_on_flush) {
+    // a string value is aggregated when the memtable is flushed
+    create_table(TKeysType::AGG_KEYS, true);
+    vector<string> flushed;
+    insert_and_flush({{"2", "1", "first"}, {"1", "10", "a"}, {"2", "2", "second"},
+                      {"2", "4", "a longer string"}, {"1", "20", "b"}},
+                     &flushed);
+    ASSERT_EQ(vector<string>({"1,30,b", "2,7,a longer string"}), flushed);
+}
+
+TEST_F(TestMemTable, duplicate_keys) {
+    create_table(TKeysType::DUP_KEYS, false);
+    vector<string> flushed;
+    insert_and_flush({{"3", "1"}, {"1", "10"}, {"3", "2"}, {"2", "5"}, {"1", "10"}},
+                     &flushed);
+    // sorted by key, the rows of one key are all kept in the order they are inserted
+    ASSERT_EQ(vector<string>({"1,10", "1,10", "2,5", "3,1", "3,2"}), flushed);
+}
+
+}  // namespace palo
+
+int main(int argc, char** argv) {
+    std::string conffile = std::string(getenv("PALO_HOME")) + "/conf/be.conf";
+    if (!palo::config::init(conffile.c_str(), false)) {
+        fprintf(stderr, "error read config file. \n");
+        return -1;
+    }
+    palo::init_glog("be-test");
+    testing::InitGoogleTest(&argc, argv);
+    palo::touch_all_singleton();
+    int ret = RUN_ALL_TESTS();
+    google::protobuf::ShutdownProtobufLibrary();
+    return ret;
+}
@@ -0,0 +1,234 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <unistd.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "olap/command_executor.h"
+#include "olap/olap_define.h"
+#include "olap/olap_engine.h"
+#include "olap/olap_index.h"
+#include "olap/olap_main.cpp"
+#include "olap/row_cursor.h"
+#include "olap/utils.h"
+#include "olap/writer.h"
+#include "util/logging.h"
+#include "util/palo_metrics.h"
+
+using namespace std;
+
+namespace palo {
+
+static const uint32_t MAX_PATH_LEN = 1024;
+static const size_t ROWS_PER_BLOCK = 16;
+static const int NUM_ROWS = 1000;
+
+void set_default_create_tablet_request(TCreateTabletReq* request) {
+    request->tablet_id = 10007;
+    request->__set_version(1);
+    request->__set_version_hash(0);
+    request->tablet_schema.schema_hash = 270068379;
+    request->tablet_schema.short_key_column_count = 1;
+    request->tablet_schema.keys_type = TKeysType::DUP_KEYS;
+    request->tablet_schema.storage_type = TStorageType::COLUMN;
+
+    TColumn k1;
+    k1.column_name = "k1";
+    k1.__set_is_key(true);
+    k1.column_type.type = TPrimitiveType::INT;
+    request->tablet_schema.columns.push_back(k1);
+
+    TColumn v;
+    v.column_name = "v";
+    v.__set_is_key(false);
+    v.column_type.type = TPrimitiveType::BIGINT;
+    request->tablet_schema.columns.push_back(v);
+}
+
+class TestOLAPIndex : public testing::Test {
+protected:
+    void SetUp() {
+        char buffer[MAX_PATH_LEN];
+        getcwd(buffer, MAX_PATH_LEN);
+        config::storage_root_path = string(buffer) + "/data_olap_index";
+        remove_all_dir(config::storage_root_path);
+        ASSERT_EQ(create_dir(config::storage_root_path), OLAP_SUCCESS);
+        OLAPRootPath::get_instance()->reload_root_paths(config::storage_root_path.c_str());
+
+        // small blocks, so that the index has many entries
+        _rows_per_block = config::default_num_rows_per_column_file_block;
+        config::default_num_rows_per_column_file_block = ROWS_PER_BLOCK;
+
+        _command_executor = new(nothrow) CommandExecutor();
+        ASSERT_TRUE(_command_executor != NULL);
+        set_default_create_tablet_request(&_create_tablet);
+        ASSERT_EQ(OLAP_SUCCESS, _command_executor->create_table(_create_tablet));
+        _olap_table = _command_executor->get_table(
+                _create_tablet.tablet_id, _create_tablet.tablet_schema.schema_hash);
+        ASSERT_TRUE(_olap_table.get() != NULL);
+        _tablet_path = _olap_table->construct_dir_path();
+
+        write_version(2);
+    }
+
+    void TearDown() {
+        config::default_num_rows_per_column_file_block = _rows_per_block;
+        _olap_table.reset();
+        OLAPEngine::get_instance()->drop_table(
+                _create_tablet.tablet_id, _create_tablet.tablet_schema.schema_hash);
+        while (0 == access(_tablet_path.c_str(), F_OK)) {
+            sleep(1);
+        }
+        ASSERT_EQ(OLAP_SUCCESS, remove_all_dir(config::storage_root_path));
+        SAFE_DELETE(_command_executor);
+    }
+
+    void write_version(int32_t version) {
+        _index = new OLAPIndex(_olap_table.get(), Version(version, version), version, false, 0, 0);
+        IWriter* writer = IWriter::create(_olap_table, _index, false);
+        ASSERT_TRUE(writer != NULL);
+        ASSERT_EQ(OLAP_SUCCESS, writer->init());
+
+        RowCursor row;
+        ASSERT_EQ(OLAP_SUCCESS, row.init(_olap_table->tablet_schema()));
+        for (int i = 0; i < NUM_ROWS; ++i) {
+            ASSERT_EQ(OLAP_SUCCESS, writer->attached_by(&row));
+            row.set_not_null(0);
+            row.set_not_null(1);
+            ASSERT_EQ(OLAP_SUCCESS, row.from_string({std::to_string(i), std::to_string(i)}));
+            writer->next(row);
+        }
+        ASSERT_EQ(OLAP_SUCCESS, writer->finalize());
+        delete writer;
+
+        ASSERT_EQ(OLAP_SUCCESS, _index->load());
+        _olap_table->obtain_header_wrlock();
+        OLAPStatus res = _olap_table->register_data_source(_index);
+        _olap_table->release_header_lock();
+        ASSERT_EQ(OLAP_SUCCESS, res);
+    }
+
+    // Looks up the short key of the 'num_blocks'th row block.
+    void get_entry(int64_t num_blocks, string* entry) {
+        RowBlockPosition pos;
+        ASSERT_EQ(OLAP_SUCCESS, _index->find_first_row_block(&pos));
+        ASSERT_EQ(OLAP_SUCCESS, _index->advance_row_block(num_blocks, &pos));
+        EntrySlice slice;
+        ASSERT_EQ(OLAP_SUCCESS, _index->get_row_block_entry(pos, &slice));
+        entry->assign(slice.data, slice.length);
+    }
+
+    std::string _tablet_path;
+    SmartOLAPTable _olap_table;
+    TCreateTabletReq _create_tablet;
+    CommandExecutor* _command_executor;
+    int32_t _rows_per_block;
+    // owned by _olap_table
+    OLAPIndex* _index;
+};
+
+TEST_F(TestOLAPIndex, lookup_without_acquire) {
+    ASSERT_EQ(0, _index->ref_count());
+    RowBlockPosition pos;
+    ASSERT_EQ(OLAP_SUCCESS, _index->find_first_row_block(&pos));
+    // the lookup gave its pin back, the entries are left to the cache
+    ASSERT_EQ(0, _index->ref_count());
+    ASSERT_FALSE(_index->is_in_use());
+
+    // and looked up again in it by the next lookup
+    int64_t hits = PaloMetrics::index_entry_cache_hit_total.value();
+    ASSERT_EQ(OLAP_SUCCESS, _index->find_last_row_block(&pos));
+    ASSERT_EQ(hits + 1, PaloMetrics::index_entry_cache_hit_total.value());
+    ASSERT_EQ(0, _index->ref_count());
+}
+
+TEST_F(TestOLAPIndex, acquire_pins_entries) {
+    _index->acquire();
+    ASSERT_EQ(1, _index->ref_count());
+    RowBlockPosition pos;
+    ASSERT_EQ(OLAP_SUCCESS, _index->find_first_row_block(&pos));
+    ASSERT_EQ(1, _index->ref_count());
+
+    // the entries stay attached, lookups do not go to the cache
+    int64_t hits = PaloMetrics::index_entry_cache_hit_total.value();
+    int64_t misses = PaloMetrics::index_entry_cache_miss_total.value();
+    string first;
+    string last;
+    get_entry(0, &first);
+    get_entry(NUM_ROWS / ROWS_PER_BLOCK - 1, &last);
+    ASSERT_NE(first, last);
+    ASSERT_EQ(hits, PaloMetrics::index_entry_cache_hit_total.value());
+    ASSERT_EQ(misses, PaloMetrics::index_entry_cache_miss_total.value());
+
+    _index->release();
+    ASSERT_EQ(0, _index->ref_count());
+}
+
+TEST_F(TestOLAPIndex, concurrent_acquire_and_release) {
+    const int64_t num_blocks = NUM_ROWS / ROWS_PER_BLOCK;
+    vector<string> expected(num_blocks);
+    _index->acquire();
+    for (int64_t i = 0; i < num_blocks; ++i) {
+        get_entry(i, &expected[i]);
+    }
+    _index->release();
+
+    // Some threads hold the index while they read entries, the others only look
+    // up positions, so that the count keeps going through 0 while entries are read.
+    vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([this, t, num_blocks, &expected] () {
+            for (int i = 0; i < 500; ++i) {
+                int64_t block = (t * 131 + i * 17) % num_blocks;
+                if (t % 2 == 0) {
+                    _index->acquire();
+                    string entry;
+                    get_entry(block, &entry);
+                    _index->release();
+                    ASSERT_EQ(expected[block], entry);
+                } else {
+                    RowBlockPosition pos;
+                    ASSERT_EQ(OLAP_SUCCESS, _index->find_first_row_block(&pos));
+                    ASSERT_EQ(OLAP_SUCCESS, _index->advance_row_block(block, &pos));
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(0, _index->ref_count());
+}
+
+}  // namespace palo
+
+int main(int argc, char** argv) {
+    std::string conffile = std::string(getenv("PALO_HOME")) + "/conf/be.conf";
+    if (!palo::config::init(conffile.c_str(), false)) {
+        fprintf(stderr, "error read config file. \n");
+        return -1;
+    }
+    palo::init_glog("be-test");
+    testing::InitGoogleTest(&argc, argv);
+    palo::touch_all_singleton();
+    int ret = RUN_ALL_TESTS();
+    google::protobuf::ShutdownProtobufLibrary();
+    return ret;
+}
@@ -0,0 +1,132 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "olap/olap_meta.h"
+
+#include <map>
+#include <string>
+
+#include <boost/filesystem.hpp>
+#include <gtest/gtest.h>
+
+using std::map;
+using std::string;
+
+namespace palo {
+
+class OLAPMetaTest : public testing::Test {
+public:
+    virtual void SetUp() {
+        boost::filesystem::remove_all(_root_path);
+        ASSERT_TRUE(boost::filesystem::create_directories(_root_path));
+    }
+
+    virtual void TearDown() {
+        boost::filesystem::remove_all(_root_path);
+    }
+
+    static map<string, string> load_all(OLAPMeta* meta) {
+        map<string, string> headers;
+        OLAPStatus res = meta->load_headers(
+                [&headers](const string& schema_hash_path, const string& header) {
+                    headers[schema_hash_path] = header;
+                });
+        EXPECT_EQ(OLAP_SUCCESS, res);
+        return headers;
+    }
+
+    static OLAPHeaderMessage make_header(int64_t creation_time) {
+        OLAPHeaderMessage header;
+        header.set_num_rows_per_data_block(1024);
+        header.set_cumulative_layer_point(-1);
+        header.set_num_short_key_fields(1);
+        header.set_creation_time(creation_time);
+        return header;
+    }
+
+    static const string _root_path;
+};
+
+const string OLAPMetaTest::_root_path = "./ut_dir/olap_meta_test";
+
+TEST_F(OLAPMetaTest, save_load_remove) {
+    OLAPMeta meta(_root_path + "/");
+    ASSERT_EQ(OLAP_SUCCESS, meta.init());
+
+    const string path1 = _root_path + "/data/0/10001/1111";
+    const string path2 = _root_path + "//data/1/10002/2222";
+    ASSERT_EQ(OLAP_SUCCESS, meta.save_header(path1, make_header(1)));
+    ASSERT_EQ(OLAP_SUCCESS, meta.save_header(path2, make_header(2)));
+    ASSERT_TRUE(meta.is_tablet_path(path1));
+    ASSERT_FALSE(meta.is_tablet_path(_root_path + "/snapshot/1/10001/1111"));
+    // snapshots are not tablets of the root path
+    ASSERT_EQ(OLAP_SUCCESS,
+              meta.save_header(_root_path + "/snapshot/1/10001/1111", make_header(3)));
+    ASSERT_EQ(OLAP_SUCCESS,
+              meta.save_header(_root_path + "/data_x/0/10001/1111", make_header(4)));
+
+    map<string, string> headers = load_all(&meta);
+    ASSERT_EQ(2, headers.size());
+    ASSERT_EQ(1, headers.count(path1));
+    ASSERT_EQ(1, headers.count(_root_path + "/data/1/10002/2222"));
+    OLAPHeaderMessage header;
+    ASSERT_TRUE(header.ParseFromString(headers[path1]));
+    ASSERT_EQ(1, header.creation_time());
+
+    // a newer header replaces the old one
+    ASSERT_EQ(OLAP_SUCCESS, meta.save_header(path1, make_header(5)));
+    ASSERT_EQ(OLAP_SUCCESS, meta.remove_header(path2));
+    headers = load_all(&meta);
+    ASSERT_EQ(1, headers.size());
+    ASSERT_TRUE(header.ParseFromString(headers[path1]));
+    ASSERT_EQ(5, header.creation_time());
+
+    string value;
+    ASSERT_EQ(OLAP_SUCCESS, meta.get_header(path1, &value));
+    ASSERT_TRUE(header.ParseFromString(value));
+    ASSERT_EQ(5, header.creation_time());
+    ASSERT_EQ(OLAP_ERR_HEADER_NOT_IN_META, meta.get_header(path2, &value));
+}
+
+TEST_F(OLAPMetaTest, batch) {
+    const string path1 = _root_path + "/data/0/10001/1111";
+    const string path2 = _root_path + "/data/0/10001/3333";
+    {
+        OLAPMeta meta(_root_path);
+        ASSERT_EQ(OLAP_SUCCESS, meta.init());
+        ASSERT_EQ(OLAP_SUCCESS, meta.save_header(path1, make_header(1)));
+
+        OLAPMeta::Batch batch;
+        ASSERT_EQ(OLAP_SUCCESS, batch.remove_header(&meta, path1));
+        ASSERT_EQ(OLAP_SUCCESS, batch.put_header(&meta, path2, make_header(2)));
+        // nothing is written before write()
+        ASSERT_EQ(1, load_all(&meta).count(path1));
+        ASSERT_EQ(OLAP_SUCCESS, meta.write(&batch));
+    }
+
+    // reopened
+    OLAPMeta meta(_root_path);
+    ASSERT_EQ(OLAP_SUCCESS, meta.init());
+    map<string, string> headers = load_all(&meta);
+    ASSERT_EQ(1, headers.size());
+    ASSERT_EQ(1, headers.count(path2));
+}
+
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -146,7 +146,7 @@ public:
         // Remove all dir.
         OLAPEngine::get_instance()->drop_table(
                 _create_tablet.tablet_id, _create_tablet.tablet_schema.schema_hash);
-        while (0 == access(_header_file_name.c_str(), F_OK)) {
+        while (0 == access(_tablet_path.c_str(), F_OK)) {
             sleep(1);
         }
         ASSERT_EQ(OLAP_SUCCESS, remove_all_dir(config::storage_root_path));
@@ -171,7 +171,7 @@ public:
         SmartOLAPTable tablet = command_executor.get_table(
                 _create_tablet.tablet_id, _create_tablet.tablet_schema.schema_hash);
         ASSERT_TRUE(tablet.get() != NULL);
-        _header_file_name = tablet->header_file_name();
+        _tablet_path = tablet->construct_dir_path();
 
         // push data
         set_default_push_request(&_push_req);
@@ -435,7 +435,7 @@ public:
 
 private:
     TCreateTabletReq _create_tablet;
-    std::string _header_file_name;
+    std::string _tablet_path;
     TPushReq _push_req;
 
     TPlanNode _tnode;
@@ -681,7 +681,7 @@ public:
         // Remove all dir.
         OLAPEngine::get_instance()->drop_table(
                 _create_tablet.tablet_id, _create_tablet.tablet_schema.schema_hash);
-        while (0 == access(_header_file_name.c_str(), F_OK)) {
+        while (0 == access(_tablet_path.c_str(), F_OK)) {
             sleep(1);
         }
         ASSERT_EQ(OLAP_SUCCESS, remove_all_dir(config::storage_root_path));
@@ -707,7 +707,7 @@ public:
         SmartOLAPTable tablet = command_executor.get_table(
                 _create_tablet.tablet_id, _create_tablet.tablet_schema.schema_hash);
         ASSERT_TRUE(tablet.get() != NULL);
-        _header_file_name = tablet->header_file_name();
+        _tablet_path = tablet->construct_dir_path();
 
         // push data
         set_default_push_request(&_push_req);
@@ -972,7 +972,7 @@ public:
 
 private:
     TCreateTabletReq _create_tablet;
-    std::string _header_file_name;
+    std::string _tablet_path;
     TPushReq _push_req;
 
     TPlanNode _tnode;
@@ -1165,7 +1165,7 @@ public:
         // Remove all dir.
         OLAPEngine::get_instance()->drop_table(
                 _create_tablet.tablet_id, _create_tablet.tablet_schema.schema_hash);
-        while (0 == access(_header_file_name.c_str(), F_OK)) {
+        while (0 == access(_tablet_path.c_str(), F_OK)) {
             sleep(1);
         }
         ASSERT_EQ(OLAP_SUCCESS, remove_all_dir(config::storage_root_path));
@@ -1190,7 +1190,7 @@ public:
         SmartOLAPTable tablet = command_executor.get_table(
                 _create_tablet.tablet_id, _create_tablet.tablet_schema.schema_hash);
         ASSERT_TRUE(tablet.get() != NULL);
-        _header_file_name = tablet->header_file_name();
+        _tablet_path = tablet->construct_dir_path();
 
         // push data
         set_default_push_request(&_push_req);
@@ -1472,7 +1472,7 @@ public:
 
 private:
     TCreateTabletReq _create_tablet;
-    std::string _header_file_name;
+    std::string _tablet_path;
     TPushReq _push_req;
     TPushReq _delete_req;
 
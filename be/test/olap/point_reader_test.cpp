@@ -0,0 +1,276 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "olap/command_executor.h"
+#include "olap/delete_handler.h"
+#include "olap/olap_define.h"
+#include "olap/olap_engine.h"
+#include "olap/olap_index.h"
+#include "olap/olap_main.cpp"
+#include "olap/point_reader.h"
+#include "olap/row_cursor.h"
+#include "olap/utils.h"
+#include "olap/writer.h"
+#include "runtime/mem_pool.h"
+#include "runtime/mem_tracker.h"
+#include "util/logging.h"
+
+using namespace std;
+
+namespace palo {
+
+static const uint32_t MAX_PATH_LEN = 1024;
+static const size_t ROWS_PER_BLOCK = 16;
+static const int NUM_ROWS = 200;
+
+void set_default_create_tablet_request(TCreateTabletReq* request) {
+    request->tablet_id = 10005;
+    request->__set_version(1);
+    request->__set_version_hash(0);
+    request->tablet_schema.schema_hash = 270068377;
+    request->tablet_schema.short_key_column_count = 1;
+    request->tablet_schema.keys_type = TKeysType::UNIQUE_KEYS;
+    request->tablet_schema.storage_type = TStorageType::COLUMN;
+
+    TColumn k1;
+    k1.column_name = "k1";
+    k1.__set_is_key(true);
+    k1.column_type.type = TPrimitiveType::INT;
+    request->tablet_schema.columns.push_back(k1);
+
+    TColumn k2;
+    k2.column_name = "k2";
+    k2.__set_is_key(true);
+    k2.column_type.type = TPrimitiveType::BIGINT;
+    request->tablet_schema.columns.push_back(k2);
+
+    TColumn v;
+    v.column_name = "v";
+    v.__set_is_key(false);
+    v.column_type.type = TPrimitiveType::BIGINT;
+    v.__set_aggregation_type(TAggregationType::REPLACE);
+    request->tablet_schema.columns.push_back(v);
+}
+
+class TestPointReader : public testing::Test {
+protected:
+    void SetUp() {
+        char buffer[MAX_PATH_LEN];
+        getcwd(buffer, MAX_PATH_LEN);
+        config::storage_root_path = string(buffer) + "/data_point_reader";
+        remove_all_dir(config::storage_root_path);
+        ASSERT_EQ(create_dir(config::storage_root_path), OLAP_SUCCESS);
+        OLAPRootPath::get_instance()->reload_root_paths(config::storage_root_path.c_str());
+
+        // small blocks, and one block per segment, so that a version spans
+        // many segments and the rows of one short key span several of them
+        _rows_per_block = config::default_num_rows_per_column_file_block;
+        config::default_num_rows_per_column_file_block = ROWS_PER_BLOCK;
+
+        _command_executor = new(nothrow) CommandExecutor();
+        ASSERT_TRUE(_command_executor != NULL);
+        set_default_create_tablet_request(&_create_tablet);
+        ASSERT_EQ(OLAP_SUCCESS, _command_executor->create_table(_create_tablet));
+        _olap_table = _command_executor->get_table(
+                _create_tablet.tablet_id, _create_tablet.tablet_schema.schema_hash);
+        ASSERT_TRUE(_olap_table.get() != NULL);
+        const_cast<OLAPHeader&>(_olap_table->header()).set_segment_size(1);
+        _tablet_path = _olap_table->construct_dir_path();
+
+        _mem_tracker.reset(new MemTracker(-1));
+        _mem_pool.reset(new MemPool(_mem_tracker.get()));
+    }
+
+    void TearDown() {
+        config::default_num_rows_per_column_file_block = _rows_per_block;
+        _olap_table.reset();
+        OLAPEngine::get_instance()->drop_table(
+                _create_tablet.tablet_id, _create_tablet.tablet_schema.schema_hash);
+        while (0 == access(_tablet_path.c_str(), F_OK)) {
+            sleep(1);
+        }
+        ASSERT_EQ(OLAP_SUCCESS, remove_all_dir(config::storage_root_path));
+        SAFE_DELETE(_command_executor);
+    }
+
+    // Writes 'rows', sorted by key, as a new version of the table.
+    void write_version(int32_t version, const vector<vector<string>>& rows) {
+        OLAPIndex* index = new OLAPIndex(
+                _olap_table.get(), Version(version, version), version, false, 0, 0);
+        IWriter* writer = IWriter::create(_olap_table, index, false);
+        ASSERT_TRUE(writer != NULL);
+        ASSERT_EQ(OLAP_SUCCESS, writer->init());
+
+        RowCursor row;
+        ASSERT_EQ(OLAP_SUCCESS, row.init(_olap_table->tablet_schema()));
+        for (const vector<string>& values : rows) {
+            ASSERT_EQ(OLAP_SUCCESS, writer->attached_by(&row));
+            for (size_t i = 0; i < values.size(); ++i) {
+                row.set_not_null(i);
+            }
+            ASSERT_EQ(OLAP_SUCCESS, row.from_string(values));
+            writer->next(row);
+        }
+        ASSERT_EQ(OLAP_SUCCESS, writer->finalize());
+        delete writer;
+
+        ASSERT_EQ(OLAP_SUCCESS, index->load());
+        if (rows.size() > ROWS_PER_BLOCK) {
+            ASSERT_GT(index->num_segments(), 1);
+        }
+        _olap_table->obtain_header_wrlock();
+        OLAPStatus res = _olap_table->register_data_source(index);
+        _olap_table->release_header_lock();
+        ASSERT_EQ(OLAP_SUCCESS, res);
+    }
+
+    void lookup(int32_t version, int64_t k1, int64_t k2, bool* found, int64_t* v) {
+        vector<string> keys = {std::to_string(k1), std::to_string(k2)};
+        RowCursor key;
+        ASSERT_EQ(OLAP_SUCCESS, key.init_scan_key(_olap_table->tablet_schema(), keys));
+        ASSERT_EQ(OLAP_SUCCESS, key.from_string(keys));
+
+        RowCursor row;
+        ASSERT_EQ(OLAP_SUCCESS, row.init(_olap_table->tablet_schema()));
+        PointReader reader(_olap_table);
+        ASSERT_EQ(OLAP_SUCCESS, reader.lookup(
+                Version(0, version), key, &row, _mem_pool.get(), found));
+        if (*found) {
+            ASSERT_EQ(std::to_string(k1), row.to_string_vector()[0]);
+            ASSERT_EQ(std::to_string(k2), row.to_string_vector()[1]);
+            *v = std::stoll(row.to_string_vector()[2]);
+        }
+    }
+
+    std::string _tablet_path;
+    SmartOLAPTable _olap_table;
+    TCreateTabletReq _create_tablet;
+    CommandExecutor* _command_executor;
+    int32_t _rows_per_block;
+    std::unique_ptr<MemTracker> _mem_tracker;
+    std::unique_ptr<MemPool> _mem_pool;
+};
+
+TEST_F(TestPointReader, lookup_across_versions) {
+    // version 2 has every key, version 3 replaces every tenth row
+    vector<vector<string>> rows;
+    for (int i = 0; i < NUM_ROWS; ++i) {
+        rows.push_back({std::to_string(i / 4), std::to_string(i), std::to_string(i)});
+    }
+    write_version(2, rows);
+    rows.clear();
+    for (int i = 0; i < NUM_ROWS; i += 10) {
+        rows.push_back({std::to_string(i / 4), std::to_string(i), std::to_string(i + 1000)});
+    }
+    write_version(3, rows);
+
+    // every key passes the key bloom filter of its segment and is found
+    bool found = false;
+    int64_t v = 0;
+    for (int i = 0; i < NUM_ROWS; ++i) {
+        lookup(3, i / 4, i, &found, &v);
+        ASSERT_TRUE(found) << "key " << i;
+        ASSERT_EQ(i % 10 == 0 ? i + 1000 : i, v);
+    }
+
+    // an older version does not see the replaced values
+    lookup(2, 0, 0, &found, &v);
+    ASSERT_TRUE(found);
+    ASSERT_EQ(0, v);
+
+    // keys that are not there, with and without a matching short key
+    lookup(3, 1, 3, &found, &v);
+    ASSERT_FALSE(found);
+    lookup(3, 1, NUM_ROWS + 1, &found, &v);
+    ASSERT_FALSE(found);
+    lookup(3, NUM_ROWS, NUM_ROWS * 4, &found, &v);
+    ASSERT_FALSE(found);
+    lookup(3, -1, 0, &found, &v);
+    ASSERT_FALSE(found);
+}
+
+TEST_F(TestPointReader, deleted_row) {
+    vector<vector<string>> rows;
+    for (int i = 0; i < NUM_ROWS; ++i) {
+        rows.push_back({std::to_string(i / 4), std::to_string(i), std::to_string(i)});
+    }
+    write_version(2, rows);
+
+    // delete k1 = 3 in version 3, which hides the rows of the versions up to 3
+    std::vector<TCondition> conditions;
+    TCondition condition;
+    condition.column_name = "k1";
+    condition.condition_op = "=";
+    condition.condition_values.push_back("3");
+    conditions.push_back(condition);
+    DeleteConditionHandler delete_condition_handler;
+    ASSERT_EQ(OLAP_SUCCESS, delete_condition_handler.store_cond(_olap_table, 3, conditions));
+    write_version(3, {});
+    write_version(4, {{"3", "13", "113"}});
+
+    bool found = false;
+    int64_t v = 0;
+    lookup(2, 3, 12, &found, &v);
+    ASSERT_TRUE(found);
+    ASSERT_EQ(12, v);
+    lookup(4, 3, 12, &found, &v);
+    ASSERT_FALSE(found);
+    lookup(4, 3, 13, &found, &v);
+    ASSERT_TRUE(found);
+    ASSERT_EQ(113, v);
+    lookup(4, 3, 14, &found, &v);
+    ASSERT_FALSE(found);
+    lookup(4, 2, 11, &found, &v);
+    ASSERT_TRUE(found);
+    ASSERT_EQ(11, v);
+}
+
+TEST_F(TestPointReader, partial_key) {
+    RowCursor key;
+    RowCursor row;
+    ASSERT_EQ(OLAP_SUCCESS, key.init_scan_key(_olap_table->tablet_schema(),
+                                              vector<string>({"1"})));
+    ASSERT_EQ(OLAP_SUCCESS, row.init(_olap_table->tablet_schema()));
+    bool found = false;
+    PointReader reader(_olap_table);
+    // only a part of the key columns
+    ASSERT_EQ(OLAP_ERR_INPUT_PARAMETER_ERROR,
+              reader.lookup(Version(0, 1), key, &row, _mem_pool.get(), &found));
+    ASSERT_FALSE(found);
+}
+
+}  // namespace palo
+
+int main(int argc, char** argv) {
+    std::string conffile = std::string(getenv("PALO_HOME")) + "/conf/be.conf";
+    if (!palo::config::init(conffile.c_str(), false)) {
+        fprintf(stderr, "error read config file. \n");
+        return -1;
+    }
+    palo::init_glog("be-test");
+    testing::InitGoogleTest(&argc, argv);
+    palo::touch_all_singleton();
+    int ret = RUN_ALL_TESTS();
+    google::protobuf::ShutdownProtobufLibrary();
+    return ret;
+}
@@ -0,0 +1,219 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "olap/command_executor.h"
+#include "olap/i_data.h"
+#include "olap/olap_define.h"
+#include "olap/olap_engine.h"
+#include "olap/olap_main.cpp"
+#include "olap/reader.h"
+#include "olap/row_cursor.h"
+#include "olap/utils.h"
+#include "olap/writer.h"
+#include "util/logging.h"
+
+using namespace std;
+
+namespace palo {
+
+static const uint32_t MAX_PATH_LEN = 1024;
+
+void set_default_create_tablet_request(TCreateTabletReq* request) {
+    request->tablet_id = 10011;
+    request->__set_version(1);
+    request->__set_version_hash(0);
+    request->tablet_schema.schema_hash = 270068383;
+    request->tablet_schema.short_key_column_count = 1;
+    request->tablet_schema.keys_type = TKeysType::DUP_KEYS;
+    request->tablet_schema.storage_type = TStorageType::COLUMN;
+
+    TColumn k1;
+    k1.column_name = "k1";
+    k1.__set_is_key(true);
+    k1.column_type.type = TPrimitiveType::INT;
+    request->tablet_schema.columns.push_back(k1);
+
+    TColumn v;
+    v.column_name = "v";
+    v.__set_is_key(false);
+    v.column_type.type = TPrimitiveType::BIGINT;
+    request->tablet_schema.columns.push_back(v);
+}
+
+// A row of a version, as it is written and expected back.
+struct TestRow {
+    int32_t key;
+    int32_t version;
+    int64_t value;
+};
+
+class TestReader : public testing::Test {
+protected:
+    void SetUp() {
+        char buffer[MAX_PATH_LEN];
+        getcwd(buffer, MAX_PATH_LEN);
+        config::storage_root_path = string(buffer) + "/data_reader";
+        remove_all_dir(config::storage_root_path);
+        ASSERT_EQ(create_dir(config::storage_root_path), OLAP_SUCCESS);
+        OLAPRootPath::get_instance()->reload_root_paths(config::storage_root_path.c_str());
+
+        // small blocks, so that the children of the merge cross many blocks
+        _rows_per_block = config::default_num_rows_per_column_file_block;
+        config::default_num_rows_per_column_file_block = 16;
+
+        _command_executor = new(nothrow) CommandExecutor();
+        ASSERT_TRUE(_command_executor != NULL);
+        set_default_create_tablet_request(&_create_tablet);
+        ASSERT_EQ(OLAP_SUCCESS, _command_executor->create_table(_create_tablet));
+        _olap_table = _command_executor->get_table(
+                _create_tablet.tablet_id, _create_tablet.tablet_schema.schema_hash);
+        ASSERT_TRUE(_olap_table.get() != NULL);
+        _tablet_path = _olap_table->construct_dir_path();
+    }
+
+    void TearDown() {
+        config::default_num_rows_per_column_file_block = _rows_per_block;
+        _olap_table.reset();
+        OLAPEngine::get_instance()->drop_table(
+                _create_tablet.tablet_id, _create_tablet.tablet_schema.schema_hash);
+        while (0 == access(_tablet_path.c_str(), F_OK)) {
+            sleep(1);
+        }
+        ASSERT_EQ(OLAP_SUCCESS, remove_all_dir(config::storage_root_path));
+        SAFE_DELETE(_command_executor);
+    }
+
+    // Writes every key of 'keys', which is sorted, 'dup' times as version 'version',
+    // and appends the written rows to 'rows'.
+    void write_version(int32_t version, const vector<int32_t>& keys, int dup,
+                       vector<TestRow>* rows) {
+        OLAPIndex* index = new OLAPIndex(
+                _olap_table.get(), Version(version, version), version, false, 0, 0);
+        IWriter* writer = IWriter::create(_olap_table, index, false);
+        ASSERT_TRUE(writer != NULL);
+        ASSERT_EQ(OLAP_SUCCESS, writer->init());
+
+        RowCursor row;
+        ASSERT_EQ(OLAP_SUCCESS, row.init(_olap_table->tablet_schema()));
+        for (int32_t key : keys) {
+            for (int i = 0; i < dup; ++i) {
+                int64_t value = version * 100000L + static_cast<int64_t>(rows->size());
+                TestRow test_row = {key, version, value};
+                ASSERT_EQ(OLAP_SUCCESS, writer->attached_by(&row));
+                row.set_not_null(0);
+                row.set_not_null(1);
+                ASSERT_EQ(OLAP_SUCCESS, row.from_string(
+                        {std::to_string(test_row.key), std::to_string(test_row.value)}));
+                writer->next(row);
+                rows->push_back(test_row);
+            }
+        }
+        ASSERT_EQ(OLAP_SUCCESS, writer->finalize());
+        delete writer;
+
+        ASSERT_EQ(OLAP_SUCCESS, index->load());
+        _olap_table->obtain_header_wrlock();
+        ASSERT_EQ(OLAP_SUCCESS, _olap_table->register_data_source(index));
+        _olap_table->release_header_lock();
+    }
+
+    std::string _tablet_path;
+    SmartOLAPTable _olap_table;
+    TCreateTabletReq _create_tablet;
+    CommandExecutor* _command_executor;
+    int32_t _rows_per_block;
+};
+
+TEST_F(TestReader, merge_overlapping_versions) {
+    vector<TestRow> rows;
+    // version 2 and 3 overlap on [100, 200) and are read in runs elsewhere,
+    // version 4 repeats a few keys of both
+    vector<int32_t> keys;
+    for (int32_t key = 0; key < 200; key += 2) {
+        keys.push_back(key);
+    }
+    write_version(2, keys, 2, &rows);
+    keys.clear();
+    for (int32_t key = 100; key < 300; ++key) {
+        keys.push_back(key);
+    }
+    write_version(3, keys, 1, &rows);
+    write_version(4, {0, 50, 100, 150, 151, 250, 299}, 3, &rows);
+
+    // rows come out in key order, the equal keys of different versions in
+    // version order and the equal keys of one version in written order
+    std::stable_sort(rows.begin(), rows.end(), [](const TestRow& a, const TestRow& b) {
+        if (a.key != b.key) {
+            return a.key < b.key;
+        }
+        return a.version < b.version;
+    });
+
+    vector<IData*> data_sources;
+    _olap_table->obtain_header_rdlock();
+    _olap_table->acquire_data_sources_by_versions(
+            {Version(2, 2), Version(3, 3), Version(4, 4)}, &data_sources);
+    _olap_table->release_header_lock();
+    ASSERT_EQ(3, data_sources.size());
+
+    Reader reader;
+    ReaderParams reader_params;
+    reader_params.olap_table = _olap_table;
+    reader_params.reader_type = READER_CUMULATIVE_COMPACTION;
+    reader_params.olap_data_arr = data_sources;
+    ASSERT_EQ(OLAP_SUCCESS, reader.init(reader_params));
+
+    RowCursor read_row;
+    ASSERT_EQ(OLAP_SUCCESS, read_row.init(_olap_table->tablet_schema()));
+    size_t num_read = 0;
+    bool eof = false;
+    while (true) {
+        ASSERT_EQ(OLAP_SUCCESS, reader.next_row_with_aggregation(&read_row, &eof));
+        if (eof) {
+            break;
+        }
+        ASSERT_LT(num_read, rows.size());
+        ASSERT_EQ(rows[num_read].key, *(int32_t*)read_row.get_field_content_ptr(0));
+        ASSERT_EQ(rows[num_read].value, *(int64_t*)read_row.get_field_content_ptr(1));
+        ++num_read;
+    }
+    ASSERT_EQ(rows.size(), num_read);
+    _olap_table->release_data_sources(&data_sources);
+}
+
+}  // namespace palo
+
+int main(int argc, char** argv) {
+    std::string conffile = std::string(getenv("PALO_HOME")) + "/conf/be.conf";
+    if (!palo::config::init(conffile.c_str(), false)) {
+        fprintf(stderr, "error read config file. \n");
+        return -1;
+    }
+    palo::init_glog("be-test");
+    testing::InitGoogleTest(&argc, argv);
+    palo::touch_all_singleton();
+    int ret = RUN_ALL_TESTS();
+    google::protobuf::ShutdownProtobufLibrary();
+    return ret;
+}
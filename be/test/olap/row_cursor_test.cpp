@@ -13,12 +13,16 @@
 // specific language governing permissions and limitations
 // under the License.
 
+#include <numeric>
+
 #include <gtest/gtest.h>
 
 #include "olap/row_cursor.h"
 #include "runtime/mem_tracker.h"
 #include "runtime/mem_pool.h"
 #include "util/logging.h"
+#include "util/roaring_bitmap.h"
+#include "util/tdigest.h"
 
 namespace palo {
 
@@ -232,6 +236,53 @@ void set_tablet_schema_for_cmp_and_aggregate(std::vector<FieldInfo>* tablet_sche
     tablet_schema->push_back(v4);
 }
 
+void set_tablet_schema_for_sketch(std::vector<FieldInfo>* tablet_schema,
+                                  FieldAggregationMethod aggregation) {
+    FieldInfo k1;
+    k1.name = "k1";
+    k1.type = OLAP_FIELD_TYPE_INT;
+    k1.length = 4;
+    k1.is_key = true;
+    k1.index_length = 4;
+    k1.is_allow_null = true;
+    tablet_schema->push_back(k1);
+
+    FieldInfo v1;
+    v1.name = "v1";
+    v1.type = OLAP_FIELD_TYPE_VARCHAR;
+    v1.length = 16 + OLAP_STRING_MAX_BYTES;
+    v1.aggregation = aggregation;
+    v1.is_key = false;
+    v1.is_allow_null = true;
+    tablet_schema->push_back(v1);
+}
+
+void set_bitmap(RowCursor* row, const std::vector<uint32_t>& values,
+                std::string* buf, MemPool* mem_pool) {
+    RoaringBitmap bitmap;
+    for (uint32_t value : values) {
+        bitmap.add(value);
+    }
+    buf->resize(bitmap.serialized_size());
+    bitmap.serialize(&(*buf)[0]);
+    StringSlice slice(*buf);
+    row->set_not_null(1);
+    row->set_field_content(1, reinterpret_cast<char*>(&slice), mem_pool);
+}
+
+void set_tdigest(RowCursor* row, const std::vector<double>& values,
+                 std::string* buf, MemPool* mem_pool) {
+    TDigest digest;
+    for (double value : values) {
+        digest.add(value);
+    }
+    buf->resize(digest.serialized_size());
+    digest.serialize(&(*buf)[0]);
+    StringSlice slice(*buf);
+    row->set_not_null(1);
+    row->set_field_content(1, reinterpret_cast<char*>(&slice), mem_pool);
+}
+
 class TestRowCursor : public testing::Test {
 public:
     TestRowCursor() {
@@ -369,6 +420,84 @@ TEST_F(TestRowCursor, EqualAndCompare) {
     ASSERT_GT(left.cmp(right_gt), 0);
 }
 
+TEST_F(TestRowCursor, KeyEqual) {
+    std::vector<FieldInfo> tablet_schema;
+    FieldInfo k1;
+    k1.name = "k1";
+    k1.type = OLAP_FIELD_TYPE_BIGINT;
+    k1.length = 8;
+    k1.is_key = true;
+    k1.index_length = 8;
+    k1.is_allow_null = false;
+    tablet_schema.push_back(k1);
+
+    FieldInfo k2;
+    k2.name = "k2";
+    k2.type = OLAP_FIELD_TYPE_INT;
+    k2.length = 4;
+    k2.is_key = true;
+    k2.index_length = 4;
+    k2.is_allow_null = true;
+    tablet_schema.push_back(k2);
+
+    FieldInfo v1;
+    v1.name = "v1";
+    v1.type = OLAP_FIELD_TYPE_BIGINT;
+    v1.length = 8;
+    v1.aggregation = OLAP_FIELD_AGGREGATION_SUM;
+    v1.is_key = false;
+    v1.is_allow_null = true;
+    tablet_schema.push_back(v1);
+
+    std::vector<uint32_t> key_cids = {0, 1};
+
+    RowCursor left;
+    ASSERT_EQ(left.init(tablet_schema), OLAP_SUCCESS);
+    ASSERT_EQ(left._key_prefix_len, 14);
+    RowCursor right;
+    ASSERT_EQ(right.init(tablet_schema), OLAP_SUCCESS);
+
+    int64_t k1_value = 100;
+    int32_t k2_value = 10;
+    int64_t l_value = 1;
+    int64_t r_value = 2;
+    left.set_not_null(0);
+    left.set_field_content(0, reinterpret_cast<char*>(&k1_value), _mem_pool.get());
+    left.set_not_null(1);
+    left.set_field_content(1, reinterpret_cast<char*>(&k2_value), _mem_pool.get());
+    left.set_not_null(2);
+    left.set_field_content(2, reinterpret_cast<char*>(&l_value), _mem_pool.get());
+    right.set_not_null(0);
+    right.set_field_content(0, reinterpret_cast<char*>(&k1_value), _mem_pool.get());
+    right.set_not_null(1);
+    right.set_field_content(1, reinterpret_cast<char*>(&k2_value), _mem_pool.get());
+    right.set_not_null(2);
+    right.set_field_content(2, reinterpret_cast<char*>(&r_value), _mem_pool.get());
+    // values are not part of the key
+    ASSERT_TRUE(RowCursor::key_equal(key_cids, &left, &right));
+
+    int32_t other_k2_value = 11;
+    right.set_field_content(1, reinterpret_cast<char*>(&other_k2_value), _mem_pool.get());
+    ASSERT_FALSE(RowCursor::key_equal(key_cids, &left, &right));
+
+    // null keys with different stale bytes are still equal
+    left.set_null(1);
+    right.set_null(1);
+    ASSERT_TRUE(RowCursor::key_equal(key_cids, &left, &right));
+
+    // string keys and cursors missing a key column use the per field compare
+    std::vector<FieldInfo> string_schema;
+    set_tablet_schema_for_cmp_and_aggregate(&string_schema);
+    RowCursor string_cursor;
+    ASSERT_EQ(string_cursor.init(string_schema), OLAP_SUCCESS);
+    ASSERT_EQ(string_cursor._key_prefix_len, 0);
+
+    std::vector<uint32_t> col_ids = {1, 2};
+    RowCursor partial_cursor;
+    ASSERT_EQ(partial_cursor.init(tablet_schema, col_ids), OLAP_SUCCESS);
+    ASSERT_EQ(partial_cursor._key_prefix_len, 0);
+}
+
 TEST_F(TestRowCursor, IndexCmp) {
     std::vector<FieldInfo> tablet_schema;
     set_tablet_schema_for_cmp_and_aggregate(&tablet_schema);
@@ -567,6 +696,144 @@ TEST_F(TestRowCursor, AggregateWithNull) {
     ASSERT_TRUE(is_null_varchar);
 }
 
+TEST_F(TestRowCursor, AggregateSketch) {
+    std::vector<FieldInfo> tablet_schema;
+    set_tablet_schema_for_sketch(&tablet_schema, OLAP_FIELD_AGGREGATION_BITMAP_UNION);
+
+    RowCursor row;
+    OLAPStatus res = row.init(tablet_schema);
+    ASSERT_EQ(res, OLAP_SUCCESS);
+    row.allocate_memory_for_string_type(tablet_schema);
+
+    std::string l_buf;
+    std::string r_buf;
+    RowCursor left;
+    res = left.init(tablet_schema);
+    int32_t l_int = 10;
+    left.set_field_content(0, reinterpret_cast<char*>(&l_int), _mem_pool.get());
+    set_bitmap(&left, {1}, &l_buf, _mem_pool.get());
+    RowCursor right;
+    res = right.init(tablet_schema);
+    right.set_field_content(0, reinterpret_cast<char*>(&l_int), _mem_pool.get());
+    set_bitmap(&right, {2}, &r_buf, _mem_pool.get());
+
+    res = row.agg_init(left);
+    ASSERT_EQ(res, OLAP_SUCCESS);
+    row.aggregate(right);
+    ASSERT_EQ(OLAP_SUCCESS, row.finalize_one_merge());
+
+    ASSERT_FALSE(row.is_null(1));
+    StringSlice* agg_bitmap = reinterpret_cast<StringSlice*>(row.get_field_content_ptr(1));
+    RoaringBitmap bitmap;
+    ASSERT_TRUE(bitmap.deserialize(agg_bitmap->data, agg_bitmap->size));
+    ASSERT_EQ(2, bitmap.cardinality());
+    ASSERT_TRUE(bitmap.contains(1));
+    ASSERT_TRUE(bitmap.contains(2));
+
+    // the union of the next rows does not fit in the 16 bytes of the column
+    set_bitmap(&right, {3, 4, 5}, &r_buf, _mem_pool.get());
+    res = row.agg_init(left);
+    ASSERT_EQ(res, OLAP_SUCCESS);
+    ASSERT_FALSE(row.can_aggregate(right));
+    ASSERT_EQ(OLAP_SUCCESS, row.finalize_one_merge());
+    agg_bitmap = reinterpret_cast<StringSlice*>(row.get_field_content_ptr(1));
+    ASSERT_TRUE(bitmap.deserialize(agg_bitmap->data, agg_bitmap->size));
+    ASSERT_EQ(1, bitmap.cardinality());
+}
+
+TEST_F(TestRowCursor, AggregateSketchPastColumnLength) {
+    std::vector<FieldInfo> tablet_schema;
+    set_tablet_schema_for_sketch(&tablet_schema, OLAP_FIELD_AGGREGATION_BITMAP_UNION);
+
+    RowCursor row;
+    ASSERT_EQ(OLAP_SUCCESS, row.init(tablet_schema));
+    row.allocate_memory_for_string_type(tablet_schema);
+
+    // rows of one key with the bitmaps {0}, {1}, ... {9}, while the 16 bytes of
+    // the column hold 4 values at most
+    const int num_rows = 10;
+    std::vector<std::string> bufs(num_rows);
+    std::vector<std::unique_ptr<RowCursor>> rows;
+    int32_t key = 10;
+    for (int i = 0; i < num_rows; ++i) {
+        rows.emplace_back(new RowCursor());
+        ASSERT_EQ(OLAP_SUCCESS, rows[i]->init(tablet_schema));
+        rows[i]->set_field_content(0, reinterpret_cast<char*>(&key), _mem_pool.get());
+        set_bitmap(rows[i].get(), {(uint32_t)i}, &bufs[i], _mem_pool.get());
+    }
+
+    // merge as the Reader does, starting a new row when the union is full
+    std::vector<int64_t> cardinalities;
+    RoaringBitmap all;
+    auto finalize_row = [&]() {
+        ASSERT_EQ(OLAP_SUCCESS, row.finalize_one_merge());
+        StringSlice* slice = reinterpret_cast<StringSlice*>(row.get_field_content_ptr(1));
+        ASSERT_LE(slice->size, 16UL);
+        RoaringBitmap bitmap;
+        ASSERT_TRUE(bitmap.deserialize(slice->data, slice->size));
+        cardinalities.push_back(bitmap.cardinality());
+        all.merge(bitmap);
+    };
+    ASSERT_EQ(OLAP_SUCCESS, row.agg_init(*rows[0]));
+    for (int i = 1; i < num_rows; ++i) {
+        if (row.can_aggregate(*rows[i])) {
+            row.aggregate(*rows[i]);
+        } else {
+            finalize_row();
+            ASSERT_EQ(OLAP_SUCCESS, row.agg_init(*rows[i]));
+        }
+    }
+    finalize_row();
+
+    // every row is kept exactly once, in more than one row of the key
+    ASSERT_GT(cardinalities.size(), 1UL);
+    ASSERT_EQ(num_rows, std::accumulate(cardinalities.begin(), cardinalities.end(), 0L));
+    ASSERT_EQ(num_rows, all.cardinality());
+}
+
+TEST_F(TestRowCursor, AggregateQuantileSketch) {
+    std::vector<FieldInfo> tablet_schema;
+    set_tablet_schema_for_sketch(&tablet_schema, OLAP_FIELD_AGGREGATION_QUANTILE_UNION);
+    // room for two centroids only
+    tablet_schema[1].length = 52 + OLAP_STRING_MAX_BYTES;
+
+    RowCursor row;
+    OLAPStatus res = row.init(tablet_schema);
+    ASSERT_EQ(res, OLAP_SUCCESS);
+    row.allocate_memory_for_string_type(tablet_schema);
+
+    std::string l_buf;
+    std::string r_buf;
+    RowCursor left;
+    res = left.init(tablet_schema);
+    int32_t l_int = 10;
+    left.set_field_content(0, reinterpret_cast<char*>(&l_int), _mem_pool.get());
+    set_tdigest(&left, {1}, &l_buf, _mem_pool.get());
+    RowCursor right;
+    res = right.init(tablet_schema);
+    right.set_field_content(0, reinterpret_cast<char*>(&l_int), _mem_pool.get());
+    set_tdigest(&right, {3}, &r_buf, _mem_pool.get());
+
+    res = row.agg_init(left);
+    ASSERT_EQ(res, OLAP_SUCCESS);
+    row.aggregate(right);
+    ASSERT_EQ(OLAP_SUCCESS, row.finalize_one_merge());
+
+    StringSlice* agg_digest = reinterpret_cast<StringSlice*>(row.get_field_content_ptr(1));
+    TDigest digest;
+    ASSERT_TRUE(digest.deserialize(agg_digest->data, agg_digest->size));
+    ASSERT_DOUBLE_EQ(2, digest.total_weight());
+    ASSERT_DOUBLE_EQ(1, digest.quantile(0));
+    ASSERT_DOUBLE_EQ(3, digest.quantile(1));
+
+    // three more centroids do not fit
+    set_tdigest(&right, {3, 5, 7}, &r_buf, _mem_pool.get());
+    res = row.agg_init(left);
+    ASSERT_EQ(res, OLAP_SUCCESS);
+    ASSERT_FALSE(row.can_aggregate(right));
+    ASSERT_EQ(OLAP_SUCCESS, row.finalize_one_merge());
+}
+
 } // namespace palo
 
 int main(int argc, char** argv) {
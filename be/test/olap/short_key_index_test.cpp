@@ -0,0 +1,222 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "olap/short_key_index.h"
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "olap/row_cursor.h"
+#include "util/logging.h"
+#include "util/stopwatch.hpp"
+
+namespace palo {
+
+// in-memory index entry of (k1 INT NULL, k2 BIGINT): null byte|value per key,
+// then the data file offset
+static const size_t ENTRY_LENGTH = 1 + 4 + 1 + 8 + 4;
+
+class ShortKeyIndexTest : public testing::Test {
+public:
+    void SetUp() {
+        FieldInfo k1;
+        k1.name = "k1";
+        k1.type = OLAP_FIELD_TYPE_INT;
+        k1.length = 4;
+        k1.index_length = 4;
+        k1.is_key = true;
+        k1.is_allow_null = true;
+        _schema.push_back(k1);
+
+        FieldInfo k2;
+        k2.name = "k2";
+        k2.type = OLAP_FIELD_TYPE_BIGINT;
+        k2.length = 8;
+        k2.index_length = 8;
+        k2.is_key = true;
+        k2.is_allow_null = true;
+        _schema.push_back(k2);
+    }
+
+    // Fills _entries with 'num_entries' sorted entries, with duplicates, negative
+    // values and some NULL k1.
+    void make_entries(size_t num_entries, uint32_t seed) {
+        std::mt19937 rng(seed);
+        std::vector<std::pair<int64_t, int64_t>> keys;
+        for (size_t i = 0; i < num_entries; ++i) {
+            // INT64_MIN stands for a NULL k1, which is less than any value
+            int64_t k1 = rng() % 10 == 0 ? INT64_MIN : static_cast<int32_t>(rng() % 2000) - 1000;
+            int64_t k2 = static_cast<int64_t>(rng() % 64) - 32;
+            if (rng() % 4 == 0) {
+                k2 *= 1L << 40;
+            }
+            keys.push_back(std::make_pair(k1, k2));
+        }
+        std::sort(keys.begin(), keys.end());
+
+        _entries.assign(num_entries * ENTRY_LENGTH, 0);
+        for (size_t i = 0; i < num_entries; ++i) {
+            char* entry = &_entries[i * ENTRY_LENGTH];
+            if (keys[i].first == INT64_MIN) {
+                entry[0] = 1;
+            } else {
+                int32_t k1 = keys[i].first;
+                memcpy(entry + 1, &k1, sizeof(k1));
+            }
+            memcpy(entry + 6, &keys[i].second, sizeof(int64_t));
+        }
+    }
+
+    ShortKeyIndex* build_index() {
+        ShortKeyIndex* index = new ShortKeyIndex(_schema, 2);
+        for (size_t i = 0; i < _entries.size(); i += ENTRY_LENGTH) {
+            index->add_entry(&_entries[i]);
+        }
+        index->finish();
+        return index;
+    }
+
+    void init_key(RowCursor* key, const std::vector<std::string>& values) {
+        ASSERT_EQ(OLAP_SUCCESS, key->init_scan_key(_schema, values));
+        ASSERT_EQ(OLAP_SUCCESS, key->from_string(values));
+        for (size_t i = 0; i < values.size(); ++i) {
+            key->set_not_null(i);
+        }
+    }
+
+    // The search done by MemIndex::find() in a segment, comparing field by field.
+    uint32_t find_by_cursor(RowCursor* helper, const RowCursor& key, bool find_last) {
+        uint32_t low = 0;
+        uint32_t high = _entries.size() / ENTRY_LENGTH;
+        while (low < high) {
+            uint32_t mid = low + (high - low) / 2;
+            helper->attach(&_entries[mid * ENTRY_LENGTH]);
+            int res = helper->index_cmp(key);
+            if (res < 0 || (find_last && res == 0)) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return low;
+    }
+
+protected:
+    std::vector<FieldInfo> _schema;
+    std::vector<char> _entries;
+};
+
+TEST_F(ShortKeyIndexTest, is_supported) {
+    ASSERT_TRUE(ShortKeyIndex::is_supported(_schema, 1));
+    ASSERT_TRUE(ShortKeyIndex::is_supported(_schema, 2));
+    ASSERT_FALSE(ShortKeyIndex::is_supported(_schema, 3));
+
+    FieldInfo k3;
+    k3.type = OLAP_FIELD_TYPE_VARCHAR;
+    k3.length = 20;
+    k3.index_length = 20;
+    _schema.push_back(k3);
+    ASSERT_FALSE(ShortKeyIndex::is_supported(_schema, 3));
+}
+
+TEST_F(ShortKeyIndexTest, find) {
+    RowCursor helper;
+    ASSERT_EQ(OLAP_SUCCESS, helper.init(_schema));
+
+    for (size_t num_entries : { 0, 1, 15, 16, 17, 1000, 5000 }) {
+        make_entries(num_entries, num_entries);
+        std::unique_ptr<ShortKeyIndex> index(build_index());
+        ASSERT_EQ(num_entries, index->count());
+
+        std::mt19937 rng(1);
+        for (int i = 0; i < 500; ++i) {
+            std::vector<std::string> values;
+            values.push_back(std::to_string(static_cast<int32_t>(rng() % 2200) - 1100));
+            // prefix keys only compare k1
+            if (rng() % 3 != 0) {
+                values.push_back(std::to_string(static_cast<int64_t>(rng() % 80) - 40));
+            }
+            RowCursor key;
+            init_key(&key, values);
+
+            char encoded_key[ShortKeyIndex::MAX_KEY_LENGTH];
+            int length = index->encode_key(key, encoded_key);
+            ASSERT_EQ(values.size() == 1 ? 5 : 14, length);
+            for (bool find_last : { false, true }) {
+                ASSERT_EQ(find_by_cursor(&helper, key, find_last),
+                          index->find(encoded_key, length, find_last))
+                        << "entries=" << num_entries << " key=" << key.to_string()
+                        << " find_last=" << find_last;
+            }
+        }
+    }
+}
+
+// Compares lookups against the field by field binary search of find_short_key().
+TEST_F(ShortKeyIndexTest, benchmark) {
+    const size_t num_entries = 1 << 20;
+    const int num_lookups = 1 << 18;
+    make_entries(num_entries, 0);
+    std::unique_ptr<ShortKeyIndex> index(build_index());
+    LOG(INFO) << "entries: " << num_entries << ", entry bytes: " << _entries.size()
+              << ", short key index bytes: " << index->memory_bytes();
+
+    std::mt19937 rng(2);
+    std::vector<std::unique_ptr<RowCursor>> keys;
+    for (int i = 0; i < 1024; ++i) {
+        std::vector<std::string> values;
+        values.push_back(std::to_string(static_cast<int32_t>(rng() % 2000) - 1000));
+        values.push_back(std::to_string(static_cast<int64_t>(rng() % 64) - 32));
+        keys.emplace_back(new RowCursor());
+        init_key(keys.back().get(), values);
+    }
+
+    RowCursor helper;
+    ASSERT_EQ(OLAP_SUCCESS, helper.init(_schema));
+    uint64_t cursor_sum = 0;
+    MonotonicStopWatch cursor_watch;
+    cursor_watch.start();
+    for (int i = 0; i < num_lookups; ++i) {
+        cursor_sum += find_by_cursor(&helper, *keys[i % keys.size()], false);
+    }
+    uint64_t cursor_ns = cursor_watch.elapsed_time();
+
+    uint64_t index_sum = 0;
+    MonotonicStopWatch index_watch;
+    index_watch.start();
+    for (int i = 0; i < num_lookups; ++i) {
+        char encoded_key[ShortKeyIndex::MAX_KEY_LENGTH];
+        int length = index->encode_key(*keys[i % keys.size()], encoded_key);
+        index_sum += index->find(encoded_key, length, false);
+    }
+    uint64_t index_ns = index_watch.elapsed_time();
+
+    LOG(INFO) << "field by field: " << cursor_ns / num_lookups << "ns/lookup, "
+              << "short key index: " << index_ns / num_lookups << "ns/lookup";
+    ASSERT_EQ(cursor_sum, index_sum);
+}
+
+}  // namespace palo
+
+int main(int argc, char** argv) {
+    palo::init_glog("be-test");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,95 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "olap/skiplist.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "runtime/mem_tracker.h"
+
+namespace palo {
+
+// compares the first of a pair, the second records the order of insertion
+struct PairComparator {
+    int operator()(const std::pair<int, int>& left, const std::pair<int, int>& right) const {
+        return left.first < right.first ? -1 : (left.first > right.first ? 1 : 0);
+    }
+};
+
+typedef SkipList<std::pair<int, int>, PairComparator> PairSkipList;
+
+class SkipListTest : public testing::Test {
+public:
+    SkipListTest() : _mem_tracker(-1), _mem_pool(&_mem_tracker) {}
+
+protected:
+    MemTracker _mem_tracker;
+    MemPool _mem_pool;
+};
+
+TEST_F(SkipListTest, empty) {
+    PairSkipList list(PairComparator(), &_mem_pool);
+    ASSERT_EQ(0, list.size());
+    std::pair<int, int> found;
+    ASSERT_FALSE(list.find(std::make_pair(1, 0), &found));
+    PairSkipList::Iterator it(&list);
+    it.seek_to_first();
+    ASSERT_FALSE(it.valid());
+}
+
+TEST_F(SkipListTest, sorted_and_stable) {
+    PairSkipList list(PairComparator(), &_mem_pool);
+    std::vector<std::pair<int, int>> expected;
+    for (int i = 0; i < 10000; ++i) {
+        std::pair<int, int> key((i * 7919) % 997, i);
+        list.insert(key);
+        expected.push_back(key);
+    }
+    ASSERT_EQ(10000, list.size());
+
+    std::stable_sort(expected.begin(), expected.end(),
+                     [](const std::pair<int, int>& left, const std::pair<int, int>& right) {
+                         return left.first < right.first;
+                     });
+    PairSkipList::Iterator it(&list);
+    it.seek_to_first();
+    for (auto& key : expected) {
+        ASSERT_TRUE(it.valid());
+        ASSERT_EQ(key, it.key());
+        it.next();
+    }
+    ASSERT_FALSE(it.valid());
+
+    // find returns the first inserted of the equal keys
+    std::pair<int, int> found;
+    ASSERT_TRUE(list.find(std::make_pair(expected[50].first, -1), &found));
+    ASSERT_EQ(expected[50].first, found.first);
+    ASSERT_EQ(std::find_if(expected.begin(), expected.end(),
+                           [&](const std::pair<int, int>& key) {
+                               return key.first == found.first;
+                           })->second,
+              found.second);
+    ASSERT_FALSE(list.find(std::make_pair(1000, 0), &found));
+}
+
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
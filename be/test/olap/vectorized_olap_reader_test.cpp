@@ -148,7 +148,7 @@ public:
         // Remove all dir.
         OLAPEngine::get_instance()->drop_table(
                 _create_tablet.tablet_id, _create_tablet.tablet_schema.schema_hash);
-        while (0 == access(_header_file_name.c_str(), F_OK)) {
+        while (0 == access(_tablet_path.c_str(), F_OK)) {
             sleep(1);
         }
         ASSERT_EQ(OLAP_SUCCESS, remove_all_dir(config::storage_root_path));
@@ -173,7 +173,7 @@ public:
         SmartOLAPTable tablet = command_executor.get_table(
                 _create_tablet.tablet_id, _create_tablet.tablet_schema.schema_hash);
         ASSERT_TRUE(tablet.get() != NULL);
-        _header_file_name = tablet->header_file_name();
+        _tablet_path = tablet->construct_dir_path();
 
         // push data
         set_default_push_request(&_push_req);
@@ -203,7 +203,7 @@ public:
         SmartOLAPTable tablet = command_executor.get_table(
                 _create_tablet.tablet_id, _create_tablet.tablet_schema.schema_hash);
         ASSERT_TRUE(tablet.get() != NULL);
-        _header_file_name = tablet->header_file_name();
+        _tablet_path = tablet->construct_dir_path();
 
         // push data
         set_default_push_request(&_push_req);
@@ -528,7 +528,7 @@ public:
     }
 private:
     TCreateTabletReq _create_tablet;
-    std::string _header_file_name;
+    std::string _tablet_path;
     TPushReq _push_req;
 
     TPlanNode _tnode;
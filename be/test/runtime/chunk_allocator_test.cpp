@@ -0,0 +1,139 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "runtime/chunk_allocator.h"
+
+#include <string.h>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "runtime/mem_tracker.h"
+#include "util/cpu_info.h"
+#include "util/logging.h"
+
+namespace palo {
+
+TEST(ChunkAllocatorTest, Reuse) {
+    ChunkAllocator allocator(64 * 1024);
+    Chunk chunk;
+    ASSERT_TRUE(allocator.allocate(4096, &chunk));
+    ASSERT_EQ(4096U, chunk.size);
+    uint8_t* data = chunk.data;
+    memset(data, 1, 4096);
+    allocator.free(chunk);
+    ASSERT_EQ(4096, allocator.reserved_bytes());
+
+    // the freed chunk is taken back, whatever core this thread runs on now
+    Chunk other;
+    ASSERT_TRUE(allocator.allocate(4096, &other));
+    ASSERT_EQ(data, other.data);
+    ASSERT_EQ(0, allocator.reserved_bytes());
+
+    // a chunk of another size class comes from the system
+    Chunk larger;
+    ASSERT_TRUE(allocator.allocate(8192, &larger));
+    ASSERT_NE(data, larger.data);
+    allocator.free(other);
+    allocator.free(larger);
+    ASSERT_EQ(4096 + 8192, allocator.reserved_bytes());
+}
+
+TEST(ChunkAllocatorTest, Budget) {
+    ChunkAllocator allocator(64 * 1024);
+    std::vector<Chunk> chunks(32);
+    for (auto& chunk : chunks) {
+        ASSERT_TRUE(allocator.allocate(4096, &chunk));
+    }
+    for (auto& chunk : chunks) {
+        allocator.free(chunk);
+    }
+    // the chunks over the budget went back to the system
+    ASSERT_EQ(64 * 1024, allocator.reserved_bytes());
+
+    // sizes that are not a power of two are never kept
+    Chunk chunk;
+    ASSERT_TRUE(allocator.allocate(5000, &chunk));
+    allocator.free(chunk);
+    ASSERT_EQ(64 * 1024, allocator.reserved_bytes());
+}
+
+TEST(ChunkAllocatorTest, NotKept) {
+    ChunkAllocator allocator(64 * 1024);
+    Chunk chunk;
+    ASSERT_TRUE(allocator.allocate(4096, &chunk));
+    allocator.free(chunk, false);
+    ASSERT_EQ(0, allocator.reserved_bytes());
+    ASSERT_EQ(0, allocator.mem_tracker()->consumption());
+}
+
+TEST(ChunkAllocatorTest, MemTracker) {
+    MemTracker process_mem_tracker(-1);
+    ChunkAllocator allocator(64 * 1024);
+    std::vector<Chunk> chunks(4);
+    for (auto& chunk : chunks) {
+        ASSERT_TRUE(allocator.allocate(4096, &chunk));
+    }
+    allocator.free(chunks[0]);
+    allocator.free(chunks[1]);
+    ASSERT_EQ(8192, allocator.mem_tracker()->consumption());
+
+    // the chunks kept so far move under the process tracker
+    allocator.track_in(&process_mem_tracker);
+    ASSERT_EQ(&process_mem_tracker, allocator.mem_tracker()->parent());
+    ASSERT_EQ(8192, process_mem_tracker.consumption());
+    allocator.free(chunks[2]);
+    allocator.free(chunks[3]);
+    ASSERT_EQ(4 * 4096, process_mem_tracker.consumption());
+
+    Chunk chunk;
+    ASSERT_TRUE(allocator.allocate(4096, &chunk));
+    ASSERT_EQ(3 * 4096, process_mem_tracker.consumption());
+    allocator.free(chunk);
+
+    ASSERT_EQ(8192, allocator.release_reserved(8192));
+    ASSERT_EQ(8192, allocator.reserved_bytes());
+    ASSERT_EQ(8192, process_mem_tracker.consumption());
+}
+
+TEST(ChunkAllocatorTest, FreedWhenProcessLimitReached) {
+    MemTracker process_mem_tracker(64 * 1024);
+    ChunkAllocator allocator(64 * 1024);
+    allocator.track_in(&process_mem_tracker);
+    std::vector<Chunk> chunks(16);
+    for (auto& chunk : chunks) {
+        ASSERT_TRUE(allocator.allocate(4096, &chunk));
+    }
+    for (auto& chunk : chunks) {
+        allocator.free(chunk);
+    }
+    ASSERT_EQ(64 * 1024, process_mem_tracker.consumption());
+
+    // a query over the process limit gets the memory of the free lists
+    MemTracker query_mem_tracker(-1, "query", &process_mem_tracker);
+    ASSERT_TRUE(query_mem_tracker.try_consume_direct(4096));
+    ASSERT_EQ(0, allocator.reserved_bytes());
+    ASSERT_EQ(4096, process_mem_tracker.consumption());
+    query_mem_tracker.release_direct(4096);
+    query_mem_tracker.unregister_from_parent();
+}
+
+}
+
+int main(int argc, char** argv) {
+    palo::init_glog("be-test");
+    palo::CpuInfo::init();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
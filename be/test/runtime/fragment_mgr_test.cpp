@@ -13,6 +13,8 @@
 // specific language governing permissions and limitations
 // under the License.
 
+#include <mutex>
+#include <vector>
 #include <gtest/gtest.h>
 #include "runtime/fragment_mgr.h"
 #include "runtime/plan_fragment_executor.h"
@@ -20,11 +22,15 @@
 #include "runtime/row_batch.h"
 #include "exec/data_sink.h"
 #include "common/configbase.h"
+#include "util/stopwatch.hpp"
 
 namespace palo {
 
 static Status s_prepare_status;
 static Status s_open_status;
+static int s_prepare_sleep_us;
+static std::mutex s_desc_tbls_lock;
+static std::vector<DescriptorTbl*> s_desc_tbls;
 // Mock used for this unittest
 PlanFragmentExecutor::PlanFragmentExecutor(ExecEnv* exec_env, 
                                            const report_status_callback& report_status_cb) : 
@@ -35,7 +41,11 @@ PlanFragmentExecutor::PlanFragmentExecutor(ExecEnv* exec_env,
 PlanFragmentExecutor::~PlanFragmentExecutor() {
 }
 
-Status PlanFragmentExecutor::prepare(const TExecPlanFragmentParams& request) {
+Status PlanFragmentExecutor::prepare(const TExecPlanFragmentParams& request,
+                                     DescriptorTbl* desc_tbl) {
+    usleep(s_prepare_sleep_us);
+    std::lock_guard<std::mutex> l(s_desc_tbls_lock);
+    s_desc_tbls.push_back(desc_tbl);
     return s_prepare_status;
 }
 
@@ -59,6 +69,8 @@ protected:
     virtual void SetUp() {
         s_prepare_status = Status::OK;
         s_open_status = Status::OK;
+        s_prepare_sleep_us = 0;
+        s_desc_tbls.clear();
     }
     virtual void TearDown() {
     }
@@ -116,6 +128,67 @@ TEST_F(FragmentMgrTest, PrepareFailed) {
     ASSERT_FALSE(mgr.exec_plan_fragment(params).ok());
 }
 
+TEST_F(FragmentMgrTest, BatchSharesDescTbl) {
+    FragmentMgr mgr(nullptr);
+    std::vector<TExecPlanFragmentParams> params(3);
+    for (int i = 0; i < params.size(); ++i) {
+        params[i].params.query_id.__set_hi(1);
+        params[i].params.query_id.__set_lo(2);
+        params[i].params.fragment_instance_id.__set_hi(100 + i);
+        params[i].params.fragment_instance_id.__set_lo(200);
+    }
+    // only the first instance carries the descriptor table
+    params[0].__isset.desc_tbl = true;
+    ASSERT_TRUE(mgr.exec_plan_fragments(params).ok());
+    ASSERT_EQ(3, s_desc_tbls.size());
+    ASSERT_TRUE(s_desc_tbls[0] != NULL);
+    ASSERT_EQ(s_desc_tbls[0], s_desc_tbls[1]);
+    ASSERT_EQ(s_desc_tbls[0], s_desc_tbls[2]);
+}
+
+TEST_F(FragmentMgrTest, BatchPreparesConcurrently) {
+    s_prepare_sleep_us = 200000;
+    FragmentMgr mgr(nullptr);
+    std::vector<TExecPlanFragmentParams> params(4);
+    for (int i = 0; i < params.size(); ++i) {
+        params[i].params.fragment_instance_id.__set_hi(100 + i);
+    }
+    params[0].__isset.desc_tbl = true;
+    MonotonicStopWatch watch;
+    watch.start();
+    ASSERT_TRUE(mgr.exec_plan_fragments(params).ok());
+    // serial prepares would take 800ms
+    ASSERT_LT(watch.elapsed_time(), 600 * 1000 * 1000UL);
+    ASSERT_EQ(4, s_desc_tbls.size());
+}
+
+TEST_F(FragmentMgrTest, BatchPrepareFailed) {
+    s_prepare_status = Status("Prepare failed.");
+    FragmentMgr mgr(nullptr);
+    std::vector<TExecPlanFragmentParams> params(3);
+    for (int i = 0; i < params.size(); ++i) {
+        params[i].params.fragment_instance_id.__set_hi(100 + i);
+    }
+    params[0].__isset.desc_tbl = true;
+    ASSERT_FALSE(mgr.exec_plan_fragments(params).ok());
+    // no instance is started
+    ASSERT_TRUE(mgr._fragment_map.empty());
+}
+
+TEST_F(FragmentMgrTest, BatchWithoutDescTbl) {
+    FragmentMgr mgr(nullptr);
+    std::vector<TExecPlanFragmentParams> params(2);
+    params[0].params.fragment_instance_id.__set_hi(100);
+    params[1].params.fragment_instance_id.__set_hi(101);
+    ASSERT_FALSE(mgr.exec_plan_fragments(params).ok());
+    ASSERT_TRUE(s_desc_tbls.empty());
+
+    // instances of different queries
+    params[0].__isset.desc_tbl = true;
+    params[1].params.query_id.__set_hi(1);
+    ASSERT_FALSE(mgr.exec_plan_fragments(params).ok());
+}
+
 }
 
 int main(int argc, char** argv) {
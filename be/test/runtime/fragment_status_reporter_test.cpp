@@ -0,0 +1,122 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "runtime/fragment_status_reporter.h"
+
+#include <gtest/gtest.h>
+
+namespace palo {
+
+class ReportedProfileTest : public testing::Test {
+protected:
+    static TRuntimeProfileNode make_node(const std::string& name, int num_children) {
+        TRuntimeProfileNode node;
+        node.name = name;
+        node.num_children = num_children;
+        node.metadata = 0;
+        node.indent = true;
+        return node;
+    }
+
+    static void add_counter(TRuntimeProfileNode* node, const std::string& name,
+                            int64_t value) {
+        TCounter counter;
+        counter.name = name;
+        counter.type = TUnit::UNIT;
+        counter.value = value;
+        node->counters.push_back(counter);
+    }
+
+    static void add_info_string(TRuntimeProfileNode* node, const std::string& key,
+                                const std::string& value) {
+        node->info_strings[key] = value;
+        node->info_strings_display_order.push_back(key);
+    }
+
+    // fragment
+    //   scan: RowsRead
+    //   sink: RowsRead
+    static TRuntimeProfileTree make_tree(int64_t scan_rows, int64_t sink_rows,
+                                         const std::string& state) {
+        TRuntimeProfileTree tree;
+        TRuntimeProfileNode fragment = make_node("fragment", 2);
+        add_info_string(&fragment, "State", state);
+        tree.nodes.push_back(fragment);
+        TRuntimeProfileNode scan = make_node("scan", 0);
+        add_counter(&scan, "RowsRead", scan_rows);
+        tree.nodes.push_back(scan);
+        TRuntimeProfileNode sink = make_node("sink", 0);
+        add_counter(&sink, "RowsRead", sink_rows);
+        tree.nodes.push_back(sink);
+        return tree;
+    }
+};
+
+TEST_F(ReportedProfileTest, only_changes) {
+    ReportedProfile reported;
+    TRuntimeProfileTree tree = make_tree(10, 10, "running");
+    reported.encode_delta(&tree);
+    ASSERT_EQ(3, tree.nodes.size());
+    ASSERT_EQ(1, tree.nodes[0].info_strings_display_order.size());
+    ASSERT_EQ(1, tree.nodes[1].counters.size());
+    ASSERT_EQ(1, tree.nodes[2].counters.size());
+    reported.commit();
+
+    // counters with the same name in different nodes are told apart
+    tree = make_tree(20, 10, "running");
+    reported.encode_delta(&tree);
+    ASSERT_EQ(3, tree.nodes.size());
+    ASSERT_EQ(2, tree.nodes[0].num_children);
+    ASSERT_TRUE(tree.nodes[0].info_strings.empty());
+    ASSERT_TRUE(tree.nodes[0].info_strings_display_order.empty());
+    ASSERT_EQ(1, tree.nodes[1].counters.size());
+    ASSERT_EQ(20, tree.nodes[1].counters[0].value);
+    ASSERT_TRUE(tree.nodes[2].counters.empty());
+    reported.commit();
+
+    tree = make_tree(20, 10, "done");
+    reported.encode_delta(&tree);
+    ASSERT_EQ("done", tree.nodes[0].info_strings["State"]);
+    ASSERT_TRUE(tree.nodes[1].counters.empty());
+}
+
+TEST_F(ReportedProfileTest, not_committed) {
+    ReportedProfile reported;
+    TRuntimeProfileTree tree = make_tree(10, 10, "running");
+    reported.encode_delta(&tree);
+    reported.commit();
+
+    tree = make_tree(20, 30, "running");
+    reported.encode_delta(&tree);
+    // the coordinator did not get it, the changes are sent again
+    tree = make_tree(20, 30, "running");
+    reported.encode_delta(&tree);
+    ASSERT_EQ(1, tree.nodes[1].counters.size());
+    ASSERT_EQ(1, tree.nodes[2].counters.size());
+    reported.commit();
+
+    tree = make_tree(20, 30, "running");
+    reported.encode_delta(&tree);
+    ASSERT_TRUE(tree.nodes[1].counters.empty());
+    ASSERT_TRUE(tree.nodes[2].counters.empty());
+}
+
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -15,10 +15,17 @@
 
 #include "runtime/mem_tracker.h"
 
+#include <memory>
+#include <thread>
+#include <vector>
+
 #include <gtest/gtest.h>
 
+#include "common/config.h"
+#include "runtime/mem_pool.h"
 #include "util/metrics.h"
 #include "util/logging.h"
+#include "util/stopwatch.hpp"
 
 namespace palo {
 
@@ -249,6 +256,151 @@ TEST(MemTestTest, GcFunctions) {
 }
 #endif // enf #if 0
 
+TEST(MemTestTest, ThreadCacheBatchesConsumption) {
+    config::mem_tracker_consume_batch_bytes = 1024;
+    MemTracker query(-1);
+    MemTracker node(-1, "", &query);
+    {
+        ScopedMemTrackerCache cache;
+        node.consume(100);
+        // the headroom is consumed on the tracker and its ancestors
+        EXPECT_EQ(1124, node.consumption());
+        EXPECT_EQ(1124, query.consumption());
+        node.consume(100);
+        EXPECT_EQ(1124, node.consumption());
+        node.release(150);
+        EXPECT_EQ(1124, node.consumption());
+
+        // large consumptions are not batched
+        node.consume(4096);
+        EXPECT_EQ(5220, query.consumption());
+        node.release(4096);
+        EXPECT_EQ(1124, query.consumption());
+
+        // an inner scope does nothing
+        {
+            ScopedMemTrackerCache inner;
+            node.consume(50);
+        }
+        EXPECT_EQ(1124, node.consumption());
+
+        // releases are batched too, and too much headroom is given back
+        node.consume(3000);
+        node.release(1000);
+        node.release(1000);
+        EXPECT_EQ(2124, node.consumption());
+        node.release(1000);
+        EXPECT_EQ(2124, node.consumption());
+        node.release(100);
+        EXPECT_EQ(1024, node.consumption());
+    }
+    EXPECT_EQ(0, node.consumption());
+    EXPECT_EQ(0, query.consumption());
+}
+
+TEST(MemTestTest, ThreadCacheTryConsumeNearLimit) {
+    config::mem_tracker_consume_batch_bytes = 1024;
+    MemTracker query(1500);
+    MemTracker node(-1, "", &query);
+    {
+        ScopedMemTrackerCache cache;
+        // no room for the headroom, only the bytes asked for are consumed
+        EXPECT_TRUE(node.try_consume(600));
+        EXPECT_EQ(600, query.consumption());
+        EXPECT_TRUE(node.try_consume(600));
+        EXPECT_EQ(1200, query.consumption());
+        EXPECT_FALSE(node.try_consume(600));
+        EXPECT_EQ(1200, query.consumption());
+        node.release(1200);
+    }
+    EXPECT_EQ(0, query.consumption());
+
+    MemTracker other(-1, "", &query);
+    {
+        ScopedMemTrackerCache cache;
+        EXPECT_TRUE(other.try_consume(100));
+        EXPECT_EQ(1124, query.consumption());
+        // the headroom held for 'other' counts against the limit
+        EXPECT_FALSE(node.try_consume(500));
+        other.release(100);
+    }
+    EXPECT_EQ(0, query.consumption());
+}
+
+TEST(MemTestTest, ThreadCacheCountsHolders) {
+    config::mem_tracker_consume_batch_bytes = 1024;
+    MemTracker query(-1);
+    MemTracker node(-1, "", &query);
+    {
+        ScopedMemTrackerCache cache;
+        node.consume(100);
+        EXPECT_EQ(1, node._num_caches.load());
+        EXPECT_EQ(0, query._num_caches.load());
+
+        // the scope of another thread is counted on its own
+        std::thread other([&node]() {
+            ScopedMemTrackerCache other_cache;
+            node.consume(100);
+            EXPECT_EQ(2, node._num_caches.load());
+            node.release(100);
+        });
+        other.join();
+        EXPECT_EQ(1, node._num_caches.load());
+
+        // a tracker closed by the thread of the scope leaves it
+        MemTracker child(-1, "", &node);
+        child.consume(10);
+        EXPECT_EQ(1, child._num_caches.load());
+        child.release(10);
+        child.close();
+        EXPECT_EQ(0, child._num_caches.load());
+
+        node.release(100);
+        cache.flush();
+        EXPECT_EQ(0, node._num_caches.load());
+    }
+    EXPECT_EQ(0, query.consumption());
+}
+
+// 64 threads allocate from their own MemPools under one query tracker, with and
+// without batching the consumption. Prints the times, which depend on the machine.
+TEST(MemTestTest, ThreadCacheMemPoolBenchmark) {
+    const int num_threads = 64;
+    const int num_rounds = 2000;
+    config::mem_tracker_consume_batch_bytes = 1024 * 1024;
+    MemTracker process(-1, "Process");
+    MemTracker query(8L * 1024 * 1024 * 1024, "Query", &process);
+
+    for (bool batched : { false, true }) {
+        MonotonicStopWatch watch;
+        watch.start();
+        std::vector<std::thread> threads;
+        for (int i = 0; i < num_threads; ++i) {
+            threads.emplace_back([&query, batched, num_rounds]() {
+                MemTracker fragment(-1, "Fragment", &query);
+                std::unique_ptr<ScopedMemTrackerCache> cache;
+                if (batched) cache.reset(new ScopedMemTrackerCache());
+                for (int round = 0; round < num_rounds; ++round) {
+                    MemPool pool(&fragment);
+                    for (int j = 0; j < 32; ++j) {
+                        ASSERT_TRUE(pool.try_allocate(1024) != NULL);
+                    }
+                    pool.free_all();
+                }
+                cache.reset();
+                EXPECT_EQ(0, fragment.consumption());
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        LOG(INFO) << (batched ? "batched" : "unbatched") << " consumption of "
+                  << num_threads << " threads: " << watch.elapsed_time() / 1000000 << "ms";
+        EXPECT_EQ(0, query.consumption());
+        EXPECT_EQ(0, process.consumption());
+    }
+}
+
 } // end namespace palo
 
 int main(int argc, char** argv) {
@@ -0,0 +1,180 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#include "runtime/row_batch.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "common/config.h"
+#include "common/object_pool.h"
+#include "gen_cpp/Data_types.h"
+#include "gen_cpp/data.pb.h"
+#include "runtime/descriptors.h"
+#include "runtime/mem_pool.h"
+#include "runtime/mem_tracker.h"
+#include "runtime/string_value.hpp"
+#include "runtime/tuple.h"
+#include "runtime/tuple_row.h"
+#include "testutil/desc_tbl_builder.h"
+
+namespace palo {
+
+static const std::string CITIES[] = {"beijing", "shanghai", "guangzhou", "shenzhen"};
+static const int NUM_CITIES = sizeof(CITIES) / sizeof(std::string);
+
+class RowBatchTest : public testing::Test {
+public:
+    RowBatchTest() : _tracker(-1) { }
+    virtual ~RowBatchTest() { }
+
+protected:
+    virtual void SetUp() {
+        _compress_rowbatches = config::compress_rowbatches;
+        _dict_max_entries = config::rowbatch_string_dict_max_entries;
+        config::compress_rowbatches = false;
+
+        // (city VARCHAR, name VARCHAR, id INT), the tuple is nullable
+        DescriptorTblBuilder builder(&_pool);
+        builder.declare_tuple() << TYPE_VARCHAR << TYPE_VARCHAR << TYPE_INT;
+        std::vector<bool> nullable_tuples(1, true);
+        std::vector<TTupleId> tuple_ids(1, static_cast<TTupleId>(0));
+        _row_desc = _pool.add(new RowDescriptor(*builder.build(), tuple_ids, nullable_tuples));
+    }
+
+    virtual void TearDown() {
+        config::compress_rowbatches = _compress_rowbatches;
+        config::rowbatch_string_dict_max_entries = _dict_max_entries;
+    }
+
+    const TupleDescriptor& tuple_desc() {
+        return *_row_desc->tuple_descriptors()[0];
+    }
+
+    // Every 7th city is NULL, every 11th tuple is NULL and every name is distinct.
+    RowBatch* create_batch(int num_rows) {
+        RowBatch* batch = _pool.add(new RowBatch(*_row_desc, num_rows, &_tracker));
+        const std::vector<SlotDescriptor*>& slots = tuple_desc().slots();
+        for (int i = 0; i < num_rows; ++i) {
+            TupleRow* row = batch->get_row(batch->add_row());
+            if (i % 11 == 0) {
+                row->set_tuple(0, NULL);
+                batch->commit_last_row();
+                continue;
+            }
+            Tuple* tuple = Tuple::create(tuple_desc().byte_size(), batch->tuple_data_pool());
+            if (i % 7 == 0) {
+                tuple->set_null(slots[0]->null_indicator_offset());
+            } else {
+                set_string(tuple, slots[0], CITIES[i % NUM_CITIES], batch->tuple_data_pool());
+            }
+            set_string(tuple, slots[1], "name_" + std::to_string(i), batch->tuple_data_pool());
+            *reinterpret_cast<int32_t*>(tuple->get_slot(slots[2]->tuple_offset())) = i;
+            row->set_tuple(0, tuple);
+            batch->commit_last_row();
+        }
+        return batch;
+    }
+
+    void set_string(Tuple* tuple, SlotDescriptor* slot, const std::string& value,
+                    MemPool* pool) {
+        StringValue* string_v = tuple->get_string_slot(slot->tuple_offset());
+        string_v->ptr = reinterpret_cast<char*>(pool->allocate(value.size()));
+        string_v->len = value.size();
+        memcpy(string_v->ptr, value.data(), value.size());
+    }
+
+    void check_equal(RowBatch* expected, RowBatch* actual) {
+        ASSERT_EQ(expected->num_rows(), actual->num_rows());
+        const std::vector<SlotDescriptor*>& slots = tuple_desc().slots();
+        for (int i = 0; i < expected->num_rows(); ++i) {
+            Tuple* left = expected->get_row(i)->get_tuple(0);
+            Tuple* right = actual->get_row(i)->get_tuple(0);
+            if (left == NULL) {
+                ASSERT_TRUE(right == NULL) << "row " << i;
+                continue;
+            }
+            ASSERT_TRUE(right != NULL) << "row " << i;
+            for (int s = 0; s < 2; ++s) {
+                ASSERT_EQ(left->is_null(slots[s]->null_indicator_offset()),
+                          right->is_null(slots[s]->null_indicator_offset())) << "row " << i;
+                if (!left->is_null(slots[s]->null_indicator_offset())) {
+                    ASSERT_TRUE(*left->get_string_slot(slots[s]->tuple_offset())
+                                == *right->get_string_slot(slots[s]->tuple_offset()))
+                        << "row " << i;
+                }
+            }
+            ASSERT_EQ(*reinterpret_cast<int32_t*>(left->get_slot(slots[2]->tuple_offset())),
+                      *reinterpret_cast<int32_t*>(right->get_slot(slots[2]->tuple_offset())));
+        }
+    }
+
+    ObjectPool _pool;
+    MemTracker _tracker;
+    RowDescriptor* _row_desc;
+    bool _compress_rowbatches;
+    int32_t _dict_max_entries;
+};
+
+TEST_F(RowBatchTest, thrift_round_trip) {
+    // large enough for the cities only while the distinct names fill it
+    config::rowbatch_string_dict_max_entries = 16;
+    RowBatch* batch = create_batch(1024);
+    int full_size = batch->total_byte_size();
+
+    TRowBatch thrift_batch;
+    batch->serialize(&thrift_batch);
+    ASSERT_FALSE(thrift_batch.is_compressed);
+    // the cities repeated before the dictionary filled up were written once
+    ASSERT_LT(thrift_batch.tuple_data.size(), full_size);
+
+    RowBatch output(*_row_desc, thrift_batch, &_tracker);
+    check_equal(batch, &output);
+}
+
+TEST_F(RowBatchTest, protobuf_round_trip) {
+    config::rowbatch_string_dict_max_entries = 16;
+    RowBatch* batch = create_batch(1024);
+    int full_size = batch->total_byte_size();
+
+    PRowBatch pb_batch;
+    batch->serialize(&pb_batch);
+    ASSERT_FALSE(pb_batch.is_compressed());
+    ASSERT_LT(pb_batch.tuple_data().size(), full_size);
+
+    RowBatch output(*_row_desc, pb_batch, &_tracker);
+    check_equal(batch, &output);
+}
+
+TEST_F(RowBatchTest, without_dictionary) {
+    config::rowbatch_string_dict_max_entries = 0;
+    RowBatch* batch = create_batch(100);
+    int full_size = batch->total_byte_size();
+
+    TRowBatch thrift_batch;
+    batch->serialize(&thrift_batch);
+    ASSERT_EQ(full_size, thrift_batch.tuple_data.size());
+
+    RowBatch output(*_row_desc, thrift_batch, &_tracker);
+    check_equal(batch, &output);
+}
+
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
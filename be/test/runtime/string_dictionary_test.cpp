@@ -0,0 +1,77 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "runtime/string_dictionary.h"
+
+#include <string>
+#include <gtest/gtest.h>
+
+namespace palo {
+
+class StringDictionaryTest : public testing::Test {
+public:
+    StringDictionaryTest() { }
+    virtual ~StringDictionaryTest() { }
+};
+
+TEST_F(StringDictionaryTest, insert_and_find) {
+    std::string beijing = "beijing";
+    std::string shanghai = "shanghai";
+    // same content as 'beijing' but a different buffer
+    std::string beijing2 = "beijing";
+
+    StringDictionary dict(16);
+    ASSERT_EQ(0, dict.size());
+    ASSERT_TRUE(dict.find(StringValue(beijing)) == NULL);
+
+    ASSERT_TRUE(dict.insert(StringValue(beijing)));
+    ASSERT_TRUE(dict.insert(StringValue(shanghai)));
+    ASSERT_EQ(2, dict.size());
+
+    // the inserted value is returned, values are not copied
+    const StringValue* found = dict.find(StringValue(beijing2));
+    ASSERT_TRUE(found != NULL);
+    ASSERT_EQ(beijing.c_str(), found->ptr);
+    ASSERT_TRUE(*dict.find(StringValue(shanghai)) == StringValue(shanghai));
+
+    dict.clear();
+    ASSERT_EQ(0, dict.size());
+    ASSERT_TRUE(dict.find(StringValue(beijing)) == NULL);
+}
+
+TEST_F(StringDictionaryTest, full) {
+    std::string values[] = {"a", "b", "c"};
+
+    StringDictionary dict(2);
+    ASSERT_TRUE(dict.insert(StringValue(values[0])));
+    ASSERT_FALSE(dict.is_full());
+    ASSERT_TRUE(dict.insert(StringValue(values[1])));
+    ASSERT_TRUE(dict.is_full());
+    ASSERT_FALSE(dict.insert(StringValue(values[2])));
+    ASSERT_EQ(2, dict.size());
+    ASSERT_TRUE(dict.find(StringValue(values[1])) != NULL);
+    ASSERT_TRUE(dict.find(StringValue(values[2])) == NULL);
+
+    StringDictionary disabled(0);
+    ASSERT_TRUE(disabled.is_full());
+    ASSERT_FALSE(disabled.insert(StringValue(values[0])));
+}
+
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
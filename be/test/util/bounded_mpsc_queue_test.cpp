@@ -0,0 +1,104 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/bounded_mpsc_queue.hpp"
+
+#include <vector>
+
+#include <boost/thread.hpp>
+#include <gtest/gtest.h>
+
+namespace palo {
+
+class BoundedMpscQueueTest : public testing::Test {
+public:
+    BoundedMpscQueueTest() { }
+    virtual ~BoundedMpscQueueTest() { }
+};
+
+TEST_F(BoundedMpscQueueTest, single_thread) {
+    BoundedMpscQueue<int> queue(5);
+    ASSERT_EQ(8, queue.capacity());
+    ASSERT_TRUE(queue.empty());
+
+    int value = 0;
+    ASSERT_FALSE(queue.try_pop(&value));
+    for (int i = 0; i < 8; ++i) {
+        ASSERT_TRUE(queue.try_push(i));
+    }
+    ASSERT_FALSE(queue.try_push(8));
+    ASSERT_EQ(8, queue.size());
+
+    for (int i = 0; i < 8; ++i) {
+        ASSERT_TRUE(queue.try_pop(&value));
+        ASSERT_EQ(i, value);
+    }
+    ASSERT_FALSE(queue.try_pop(&value));
+
+    // wrap around
+    for (int round = 0; round < 3; ++round) {
+        ASSERT_TRUE(queue.try_push(round));
+        ASSERT_TRUE(queue.try_pop(&value));
+        ASSERT_EQ(round, value);
+    }
+    ASSERT_TRUE(queue.empty());
+}
+
+TEST_F(BoundedMpscQueueTest, multi_producer) {
+    const int NUM_PRODUCERS = 8;
+    const int NUM_VALUES = 100000;
+    BoundedMpscQueue<int64_t> queue(64);
+
+    boost::thread_group producers;
+    for (int p = 0; p < NUM_PRODUCERS; ++p) {
+        producers.create_thread([&queue, p] () {
+            for (int i = 0; i < NUM_VALUES; ++i) {
+                int64_t value = (int64_t)p * NUM_VALUES + i;
+                while (!queue.try_push(value)) {
+                    boost::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    // values of each producer must come out in the order they were pushed
+    std::vector<int64_t> last(NUM_PRODUCERS, -1);
+    int64_t sum = 0;
+    int64_t num_popped = 0;
+    while (num_popped < (int64_t)NUM_PRODUCERS * NUM_VALUES) {
+        int64_t value = 0;
+        if (!queue.try_pop(&value)) {
+            boost::this_thread::yield();
+            continue;
+        }
+        int p = value / NUM_VALUES;
+        ASSERT_LT(last[p], value);
+        last[p] = value;
+        sum += value;
+        ++num_popped;
+    }
+    producers.join_all();
+
+    int64_t total = (int64_t)NUM_PRODUCERS * NUM_VALUES;
+    ASSERT_EQ(total * (total - 1) / 2, sum);
+    ASSERT_TRUE(queue.empty());
+}
+
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,64 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "util/delimiter_scanner.h"
+
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+namespace palo {
+
+class DelimiterScannerTest : public testing::Test {
+};
+
+TEST_F(DelimiterScannerTest, find_all) {
+    // longer than a few registers, with a tail not filling one
+    std::string text;
+    for (int i = 0; i < 100; ++i) {
+        text.append(i % 7 == 0 ? "abc,de\n" : "f,,ghijklmnop,q");
+    }
+    text.append(",x");
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(text.data());
+
+    for (size_t begin : { 0, 3, 33 }) {
+        std::vector<size_t> expected;
+        for (size_t i = begin; i < text.size(); ++i) {
+            if (text[i] == ',' || text[i] == '\n') {
+                expected.push_back(i);
+            }
+        }
+        std::vector<size_t> positions;
+        DelimiterScanner::find_all(data, begin, text.size(), ',', '\n', &positions);
+        ASSERT_EQ(expected, positions);
+    }
+
+    // appends to what is already there
+    std::vector<size_t> positions({ 1 });
+    DelimiterScanner::find_all(data, 2, 7, '\n', '\n', &positions);
+    ASSERT_EQ(std::vector<size_t>({ 1, 6 }), positions);
+
+    positions.clear();
+    DelimiterScanner::find_all(data, 5, 5, ',', '\n', &positions);
+    ASSERT_TRUE(positions.empty());
+}
+
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,115 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/priority_work_stealing_thread_pool.hpp"
+
+#include <atomic>
+#include <unistd.h>
+
+#include <boost/thread/mutex.hpp>
+#include <gtest/gtest.h>
+
+namespace palo {
+
+class PriorityWorkStealingThreadPoolTest : public testing::Test {
+public:
+    PriorityWorkStealingThreadPoolTest() { }
+    virtual ~PriorityWorkStealingThreadPoolTest() { }
+};
+
+static void add(std::atomic<int64_t>* sum, int value) {
+    sum->fetch_add(value);
+}
+
+TEST_F(PriorityWorkStealingThreadPoolTest, all_tasks_run) {
+    const int NUM_TASKS = 10000;
+    std::atomic<int64_t> sum(0);
+
+    PriorityWorkStealingThreadPool thread_pool(8, 4, 1024);
+    for (int i = 1; i <= NUM_TASKS; ++i) {
+        PriorityThreadPool::Task task;
+        task.priority = i % 20;
+        task.queue_id = i;
+        task.work_function = boost::bind(&add, &sum, i);
+        ASSERT_TRUE(thread_pool.offer(task));
+    }
+    thread_pool.drain_and_shutdown();
+
+    // offer() after shutdown() must fail
+    PriorityThreadPool::Task task;
+    task.priority = 0;
+    task.work_function = boost::bind(&add, &sum, 0);
+    ASSERT_FALSE(thread_pool.offer(task));
+    ASSERT_EQ(0, thread_pool.get_queue_size());
+    ASSERT_EQ((int64_t)NUM_TASKS * (NUM_TASKS + 1) / 2, sum.load());
+}
+
+// Tasks that all go to one queue are stolen by the threads of the other queues.
+TEST_F(PriorityWorkStealingThreadPoolTest, steal) {
+    const int NUM_TASKS = 8;
+    std::atomic<int64_t> running(0);
+    std::atomic<int64_t> max_running(0);
+    boost::mutex lock;
+
+    auto work = [&running, &max_running, &lock] () {
+        int64_t cur = ++running;
+        {
+            boost::lock_guard<boost::mutex> l(lock);
+            if (cur > max_running) {
+                max_running = cur;
+            }
+        }
+        usleep(100 * 1000);
+        --running;
+    };
+
+    PriorityWorkStealingThreadPool thread_pool(4, 4, 1024);
+    for (int i = 0; i < NUM_TASKS; ++i) {
+        PriorityThreadPool::Task task;
+        task.priority = 0;
+        task.queue_id = 0;
+        task.work_function = work;
+        ASSERT_TRUE(thread_pool.offer(task));
+    }
+    thread_pool.drain_and_shutdown();
+    ASSERT_GT(max_running.load(), 1);
+}
+
+// Workers sleeping on an empty pool wake up for tasks offered to any queue.
+TEST_F(PriorityWorkStealingThreadPoolTest, wake_idle_workers) {
+    std::atomic<int64_t> sum(0);
+    PriorityWorkStealingThreadPool thread_pool(4, 4, 1024);
+    for (int round = 1; round <= 100; ++round) {
+        // let all workers go idle
+        usleep(1000);
+        PriorityThreadPool::Task task;
+        task.priority = 0;
+        task.queue_id = round;
+        task.work_function = boost::bind(&add, &sum, 1);
+        ASSERT_TRUE(thread_pool.offer(task));
+        while (sum.load() != round) {
+            usleep(100);
+        }
+    }
+    thread_pool.drain_and_shutdown();
+    ASSERT_EQ(0, thread_pool.get_queue_size());
+}
+
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
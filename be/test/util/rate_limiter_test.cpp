@@ -0,0 +1,63 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "util/rate_limiter.h"
+
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "util/time.h"
+
+namespace palo {
+
+class RateLimiterTest : public testing::Test {
+};
+
+TEST_F(RateLimiterTest, no_limit) {
+    RateLimiter rate_limiter(0);
+    int64_t start = MonotonicMillis();
+    for (int i = 0; i < 1000; ++i) {
+        rate_limiter.acquire(1024 * 1024);
+    }
+    ASSERT_LT(MonotonicMillis() - start, 1000);
+}
+
+TEST_F(RateLimiterTest, shared_rate) {
+    // 4 threads of 5 * 10KB at 400KB/s, the first 10KB pass at once
+    RateLimiter rate_limiter(400 * 1024);
+    int64_t start = MonotonicMillis();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&rate_limiter] {
+            for (int j = 0; j < 5; ++j) {
+                rate_limiter.acquire(10 * 1024);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_GE(MonotonicMillis() - start, 19 * 25 - 5);
+}
+
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
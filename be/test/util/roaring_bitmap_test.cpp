@@ -0,0 +1,130 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/roaring_bitmap.h"
+
+#include <set>
+#include <string>
+#include <gtest/gtest.h>
+
+namespace palo {
+
+class RoaringBitmapTest : public testing::Test {
+public:
+    RoaringBitmapTest() { }
+    virtual ~RoaringBitmapTest() { }
+};
+
+static std::string serialize(const RoaringBitmap& bitmap) {
+    std::string buf(bitmap.serialized_size(), '\0');
+    bitmap.serialize(&buf[0]);
+    return buf;
+}
+
+TEST_F(RoaringBitmapTest, add_and_contains) {
+    RoaringBitmap bitmap;
+    ASSERT_TRUE(bitmap.empty());
+    bitmap.add(1);
+    bitmap.add(1);
+    bitmap.add(65536 + 7);
+    bitmap.add(UINT32_MAX);
+    ASSERT_EQ(3, bitmap.cardinality());
+    ASSERT_TRUE(bitmap.contains(1));
+    ASSERT_TRUE(bitmap.contains(65536 + 7));
+    ASSERT_TRUE(bitmap.contains(UINT32_MAX));
+    ASSERT_FALSE(bitmap.contains(7));
+    ASSERT_FALSE(bitmap.contains(2));
+}
+
+TEST_F(RoaringBitmapTest, dense_container) {
+    RoaringBitmap bitmap;
+    // more than ARRAY_MAX_SIZE values in one container switch it to a bitset
+    for (uint32_t i = 0; i < 10000; ++i) {
+        bitmap.add(i * 3);
+    }
+    ASSERT_EQ(10000, bitmap.cardinality());
+    for (uint32_t i = 0; i < 30000; ++i) {
+        ASSERT_EQ(i % 3 == 0, bitmap.contains(i));
+    }
+    // a single container, stored as a bitset
+    ASSERT_EQ(4 + 4 + 65536 / 8, bitmap.serialized_size());
+}
+
+TEST_F(RoaringBitmapTest, serialize) {
+    RoaringBitmap bitmap;
+    std::set<uint32_t> expected;
+    for (uint32_t i = 0; i < 20000; ++i) {
+        uint32_t value = i * 2654435761U % 300000;
+        bitmap.add(value);
+        expected.insert(value);
+    }
+    std::string buf = serialize(bitmap);
+    ASSERT_EQ(bitmap.serialized_size(), buf.size());
+
+    RoaringBitmap copy;
+    ASSERT_TRUE(copy.deserialize(buf.data(), buf.size()));
+    ASSERT_EQ(expected.size(), copy.cardinality());
+    for (uint32_t value : expected) {
+        ASSERT_TRUE(copy.contains(value));
+    }
+    ASSERT_EQ(buf, serialize(copy));
+
+    // truncated input is rejected
+    ASSERT_FALSE(copy.deserialize(buf.data(), buf.size() - 1));
+    ASSERT_FALSE(copy.deserialize(buf.data(), 2));
+
+    RoaringBitmap empty;
+    std::string empty_buf = serialize(empty);
+    ASSERT_EQ(4, empty_buf.size());
+    ASSERT_TRUE(copy.deserialize(empty_buf.data(), empty_buf.size()));
+    ASSERT_EQ(0, copy.cardinality());
+}
+
+TEST_F(RoaringBitmapTest, merge) {
+    RoaringBitmap sparse;
+    RoaringBitmap dense;
+    std::set<uint32_t> expected;
+    for (uint32_t i = 0; i < 100; ++i) {
+        sparse.add(i * 1000);
+        expected.insert(i * 1000);
+    }
+    for (uint32_t i = 0; i < 50000; ++i) {
+        dense.add(i);
+        expected.insert(i);
+    }
+
+    RoaringBitmap merged;
+    merged.merge(sparse);
+    merged.merge(dense);
+    ASSERT_EQ(expected.size(), merged.cardinality());
+
+    // merging the serialized bitmaps gives the same result
+    RoaringBitmap merged_from_buf;
+    std::string sparse_buf = serialize(sparse);
+    std::string dense_buf = serialize(dense);
+    ASSERT_TRUE(merged_from_buf.merge(dense_buf.data(), dense_buf.size()));
+    ASSERT_TRUE(merged_from_buf.merge(sparse_buf.data(), sparse_buf.size()));
+    ASSERT_EQ(serialize(merged), serialize(merged_from_buf));
+    for (uint32_t value : expected) {
+        ASSERT_TRUE(merged_from_buf.contains(value));
+    }
+}
+
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,87 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/tdigest.h"
+
+#include <vector>
+#include <gtest/gtest.h>
+
+namespace palo {
+
+class TDigestTest : public testing::Test {
+};
+
+TEST_F(TDigestTest, small) {
+    TDigest digest;
+    ASSERT_TRUE(digest.empty());
+    digest.add(3);
+    ASSERT_EQ(3, digest.quantile(0.5));
+    digest.add(1);
+    digest.add(2);
+    ASSERT_EQ(3, digest.total_weight());
+    ASSERT_EQ(1, digest.quantile(0));
+    ASSERT_EQ(2, digest.quantile(0.5));
+    ASSERT_EQ(3, digest.quantile(1));
+}
+
+TEST_F(TDigestTest, uniform) {
+    TDigest digest;
+    // a permutation of 0 .. 99999
+    for (int64_t i = 0; i < 100000; ++i) {
+        digest.add((i * 7919) % 100000);
+    }
+    ASSERT_EQ(100000, digest.total_weight());
+    ASSERT_NEAR(50000, digest.quantile(0.5), 500);
+    ASSERT_NEAR(99000, digest.quantile(0.99), 50);
+    ASSERT_NEAR(99900, digest.quantile(0.999), 20);
+    ASSERT_EQ(0, digest.quantile(0));
+    ASSERT_EQ(99999, digest.quantile(1));
+    // the centroids do not grow with the number of values
+    ASSERT_LE(digest.serialized_size(), 100 * 16 + 20);
+}
+
+TEST_F(TDigestTest, serialize_and_merge) {
+    TDigest left;
+    TDigest right;
+    for (int i = 0; i < 50000; ++i) {
+        left.add(i);
+        right.add(50000 + i);
+    }
+    std::vector<char> buf(right.serialized_size());
+    right.serialize(&buf[0]);
+
+    TDigest copy;
+    ASSERT_TRUE(copy.deserialize(&buf[0], buf.size()));
+    ASSERT_EQ(50000, copy.total_weight());
+    ASSERT_EQ(99999, copy.quantile(1));
+
+    ASSERT_TRUE(left.merge(&buf[0], buf.size()));
+    ASSERT_EQ(100000, left.total_weight());
+    ASSERT_EQ(0, left.quantile(0));
+    ASSERT_EQ(99999, left.quantile(1));
+    ASSERT_NEAR(99000, left.quantile(0.99), 100);
+
+    // truncated or garbage input is rejected without changing the digest
+    ASSERT_FALSE(left.merge(&buf[0], buf.size() - 1));
+    ASSERT_FALSE(left.merge("abc", 3));
+    ASSERT_EQ(100000, left.total_weight());
+}
+
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -624,6 +624,42 @@ public class FunctionSet {
             prefix + "17count_star_removeEPN8palo_udf15FunctionContextEPNS1_9BigIntValE",
             null, false, true, true));
 
+        // bitmap_union, bitmap_union_count of the serialized bitmaps of a BITMAP_UNION column
+        addBuiltin(AggregateFunction.createBuiltin("bitmap_union",
+                Lists.newArrayList(Type.VARCHAR), Type.VARCHAR, Type.VARCHAR,
+                prefix + "17bitmap_union_initEPN8palo_udf15FunctionContextEPNS1_9StringValE",
+                prefix + "19bitmap_union_updateEPN8palo_udf15FunctionContextERKNS1_9StringValEPS4_",
+                prefix + "18bitmap_union_mergeEPN8palo_udf15FunctionContextERKNS1_9StringValEPS4_",
+                prefix + "22bitmap_union_serializeEPN8palo_udf15FunctionContextERKNS1_9StringValE",
+                prefix + "22bitmap_union_serializeEPN8palo_udf15FunctionContextERKNS1_9StringValE",
+                true, false, true));
+        addBuiltin(AggregateFunction.createBuiltin("bitmap_union_count",
+                Lists.newArrayList(Type.VARCHAR), Type.BIGINT, Type.VARCHAR,
+                prefix + "17bitmap_union_initEPN8palo_udf15FunctionContextEPNS1_9StringValE",
+                prefix + "19bitmap_union_updateEPN8palo_udf15FunctionContextERKNS1_9StringValEPS4_",
+                prefix + "18bitmap_union_mergeEPN8palo_udf15FunctionContextERKNS1_9StringValEPS4_",
+                prefix + "22bitmap_union_serializeEPN8palo_udf15FunctionContextERKNS1_9StringValE",
+                prefix + "27bitmap_union_count_finalizeEPN8palo_udf15FunctionContextERKNS1_9StringValE",
+                true, false, true));
+
+        // percentile_approx of doubles, percentile_union of the t-digests of a QUANTILE_UNION column
+        addBuiltin(AggregateFunction.createBuiltin("percentile_approx",
+                Lists.newArrayList(Type.DOUBLE, Type.DOUBLE), Type.DOUBLE, Type.VARCHAR,
+                prefix + "22percentile_approx_initEPN8palo_udf15FunctionContextEPNS1_9StringValE",
+                prefix + "24percentile_approx_updateEPN8palo_udf15FunctionContextERKNS1_9DoubleValES6_PNS1_9StringValE",
+                prefix + "23percentile_approx_mergeEPN8palo_udf15FunctionContextERKNS1_9StringValEPS4_",
+                prefix + "27percentile_approx_serializeEPN8palo_udf15FunctionContextERKNS1_9StringValE",
+                prefix + "26percentile_approx_finalizeEPN8palo_udf15FunctionContextERKNS1_9StringValE",
+                false, false, false));
+        addBuiltin(AggregateFunction.createBuiltin("percentile_union",
+                Lists.newArrayList(Type.VARCHAR, Type.DOUBLE), Type.DOUBLE, Type.VARCHAR,
+                prefix + "22percentile_approx_initEPN8palo_udf15FunctionContextEPNS1_9StringValE",
+                prefix + "23percentile_union_updateEPN8palo_udf15FunctionContextERKNS1_9StringValERKNS1_9DoubleValEPS4_",
+                prefix + "23percentile_approx_mergeEPN8palo_udf15FunctionContextERKNS1_9StringValEPS4_",
+                prefix + "27percentile_approx_serializeEPN8palo_udf15FunctionContextERKNS1_9StringValE",
+                prefix + "26percentile_approx_finalizeEPN8palo_udf15FunctionContextERKNS1_9StringValE",
+                false, false, false));
+
         for (Type t : Type.getSupportedTypes()) {
             if (t.isNull()) {
                 continue; // NULL is handled through type promotion.
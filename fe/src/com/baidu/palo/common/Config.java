@@ -529,6 +529,10 @@ public class Config extends ConfigBase {
 
     // BRPC idle wait time (ms)
     @ConfField public static int brpc_idle_wait_max_time = 10000;
+
+    // Launch the instances of a fragment on one backend with one RPC, so that the backend
+    // builds the descriptor table once. Set to false if some backends are not upgraded.
+    @ConfField public static boolean enable_batch_exec_plan_fragments = true;
     
     /*
      * if set to false, auth check will be disable, in case some goes wrong with the new privilege system. 
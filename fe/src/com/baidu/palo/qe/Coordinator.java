@@ -48,6 +48,7 @@ import com.baidu.palo.task.LoadEtlTask;
 import com.baidu.palo.thrift.PaloInternalServiceVersion;
 import com.baidu.palo.thrift.TDescriptorTable;
 import com.baidu.palo.thrift.TExecPlanFragmentParams;
+import com.baidu.palo.thrift.TExecPlanFragmentsParams;
 import com.baidu.palo.thrift.TNetworkAddress;
 import com.baidu.palo.thrift.TPaloScanRange;
 import com.baidu.palo.thrift.TPartitionType;
@@ -391,6 +392,8 @@ public class Coordinator {
                 Preconditions.checkState(instanceNum > 0);
                 List<TExecPlanFragmentParams> tParams = params.toThrift(backendId);
                 List<Pair<BackendExecState, Future<PExecPlanFragmentResult>>> futures = Lists.newArrayList();
+                // the instances on one backend are launched together
+                Map<TNetworkAddress, List<BackendExecState>> hostExecStates = Maps.newLinkedHashMap();
                 int instanceId = 0;
                 for (TExecPlanFragmentParams tParam : tParams) {
                     // TODO: pool of pre-formatted BackendExecStates?
@@ -400,10 +403,25 @@ public class Coordinator {
                     backendExecStates.add(execState);
                     backendExecStateMap.put(tParam.params.getFragment_instance_id(), execState);
 
-                    futures.add(Pair.create(execState, execState.execRemoteFragmentAsync()));
+                    List<BackendExecState> hostStates = hostExecStates.get(execState.address);
+                    if (hostStates == null) {
+                        hostStates = Lists.newArrayList();
+                        hostExecStates.put(execState.address, hostStates);
+                    }
+                    hostStates.add(execState);
 
                     backendId++;
                 }
+                for (List<BackendExecState> hostStates : hostExecStates.values()) {
+                    if (hostStates.size() == 1 || !Config.enable_batch_exec_plan_fragments) {
+                        for (BackendExecState execState : hostStates) {
+                            futures.add(Pair.create(execState, execState.execRemoteFragmentAsync()));
+                        }
+                    } else {
+                        // the result of the batch stands for all its instances
+                        futures.add(Pair.create(hostStates.get(0), execRemoteFragmentsAsync(hostStates)));
+                    }
+                }
 
                 for (Pair<BackendExecState, Future<PExecPlanFragmentResult>> pair : futures) {
                     TStatusCode code = TStatusCode.INTERNAL_ERROR;
@@ -1407,6 +1425,35 @@ public class Coordinator {
         }
     }
 
+    // Launches the instances of one fragment on their backend with one RPC. The backend
+    // shares the descriptor table among the instances of a query, so only the first
+    // instance carries it.
+    private Future<PExecPlanFragmentResult> execRemoteFragmentsAsync(List<BackendExecState> execStates)
+            throws TException, RpcException {
+        BackendExecState first = execStates.get(0);
+        TNetworkAddress brpcAddress = null;
+        try {
+            brpcAddress = toBrpcHost(first.address);
+        } catch (Exception e) {
+            throw new TException(e.getMessage());
+        }
+        TExecPlanFragmentsParams params = new TExecPlanFragmentsParams();
+        params.setProtocol_version(PaloInternalServiceVersion.V1);
+        for (BackendExecState execState : execStates) {
+            if (execState != first) {
+                execState.rpcParams.unsetDesc_tbl();
+            }
+            params.addToParams(execState.rpcParams);
+            execState.initiated = true;
+        }
+        try {
+            return BackendServiceProxy.getInstance().execPlanFragmentsAsync(brpcAddress, params);
+        } catch (RpcException e) {
+            SimpleScheduler.updateBlacklistBackends(first.systemBackendId);
+            throw e;
+        }
+    }
+
     // execution parameters for a single fragment,
     // per-fragment can have multiple FInstanceExecParam,
     // used to assemble TPlanFragmentExecParas  
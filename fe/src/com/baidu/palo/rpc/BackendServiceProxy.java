@@ -21,6 +21,7 @@ import com.baidu.jprotobuf.pbrpc.transport.RpcClientOptions;
 import com.baidu.palo.common.Config;
 import com.baidu.palo.qe.SimpleScheduler;
 import com.baidu.palo.thrift.TExecPlanFragmentParams;
+import com.baidu.palo.thrift.TExecPlanFragmentsParams;
 import com.baidu.palo.thrift.TNetworkAddress;
 import com.baidu.palo.thrift.TUniqueId;
 
@@ -100,6 +101,36 @@ public Future<PExecPlanFragmentResult> execPlanFragmentAsync(
         }
     }
 
+    public Future<PExecPlanFragmentResult> execPlanFragmentsAsync(
+            TNetworkAddress address, TExecPlanFragmentsParams tRequest)
+            throws TException, RpcException {
+        final PExecPlanFragmentRequest pRequest = new PExecPlanFragmentRequest();
+        pRequest.setRequest(tRequest);
+        try {
+            final PInternalService service = getProxy(address);
+            return service.execPlanFragmentsAsync(pRequest);
+        } catch (NoSuchElementException e) {
+            try {
+                // retry
+                try {
+                    Thread.sleep(10);
+                } catch (InterruptedException interruptedException) {
+                    // do nothing
+                }
+                final PInternalService service = getProxy(address);
+                return service.execPlanFragmentsAsync(pRequest);
+            } catch (NoSuchElementException noSuchElementException) {
+                LOG.warn("Execute plan fragments retry failed, address={}:{}",
+                        address.getHostname(), address.getPort(), noSuchElementException);
+                throw new RpcException(e.getMessage());
+            }
+        } catch (Throwable e) {
+            LOG.warn("Execute plan fragments catch a exception, address={}:{}",
+                    address.getHostname(), address.getPort(), e);
+            throw new RpcException(e.getMessage());
+        }
+    }
+
     public Future<PCancelPlanFragmentResult> cancelPlanFragmentAsync(
             TNetworkAddress address, TUniqueId finstId) throws RpcException {
         final PCancelPlanFragmentRequest pRequest = new PCancelPlanFragmentRequest(new PUniqueId(finstId));;
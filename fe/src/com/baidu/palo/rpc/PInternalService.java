@@ -24,6 +24,10 @@ public interface PInternalService {
             attachmentHandler = ThriftClientAttachmentHandler.class, onceTalkTimeout = 2000)
     Future<PExecPlanFragmentResult> execPlanFragmentAsync(PExecPlanFragmentRequest request);
 
+    @ProtobufRPC(serviceName = "PInternalService", methodName = "exec_plan_fragments",
+            attachmentHandler = ThriftClientAttachmentHandler.class, onceTalkTimeout = 2000)
+    Future<PExecPlanFragmentResult> execPlanFragmentsAsync(PExecPlanFragmentRequest request);
+
     @ProtobufRPC(serviceName = "PInternalService", methodName = "cancel_plan_fragment",
             onceTalkTimeout = 1000)
     Future<PCancelPlanFragmentResult> cancelPlanFragmentAsync(PCancelPlanFragmentRequest request);
@@ -43,6 +43,8 @@ import com.baidu.palo.system.Frontend;
 import com.baidu.palo.system.SystemInfoService;
 import com.baidu.palo.thrift.FrontendService;
 import com.baidu.palo.thrift.FrontendServiceVersion;
+import com.baidu.palo.thrift.TBatchReportExecStatusParams;
+import com.baidu.palo.thrift.TBatchReportExecStatusResult;
 import com.baidu.palo.thrift.TColumnDef;
 import com.baidu.palo.thrift.TColumnDesc;
 import com.baidu.palo.thrift.TDescribeTableParams;
@@ -283,6 +285,19 @@ public class FrontendServiceImpl implements FrontendService.Iface {
         return qeProcessor.reportExecStatus(params);
     }
 
+    @Override
+    public TBatchReportExecStatusResult batchReportExecStatus(TBatchReportExecStatusParams params)
+            throws TException {
+        TBatchReportExecStatusResult result = new TBatchReportExecStatusResult();
+        result.setResults(Lists.<TReportExecStatusResult>newArrayList());
+        if (params.isSetParams()) {
+            for (TReportExecStatusParams reportParams : params.getParams()) {
+                result.addToResults(qeProcessor.reportExecStatus(reportParams));
+            }
+        }
+        return result;
+    }
+
     @Override
     public TMasterResult finishTask(TFinishTaskRequest request) throws TException {
         return masterImpl.finishTask(request);
@@ -194,7 +194,7 @@ parser code {:
 
 // Total keywords of palo
 terminal String KW_ADD, KW_AFTER, KW_AGGREGATE, KW_ALL, KW_ALTER, KW_AND, KW_ANTI, KW_AS, KW_ASC, KW_AUTHORS, 
-    KW_BACKEND, KW_BACKUP, KW_BETWEEN, KW_BEGIN, KW_BIGINT, KW_BOOLEAN, KW_BOTH, KW_BROKER, KW_BACKENDS, KW_BY,
+    KW_BACKEND, KW_BACKUP, KW_BETWEEN, KW_BEGIN, KW_BIGINT, KW_BITMAP_UNION, KW_BOOLEAN, KW_BOTH, KW_BROKER, KW_BACKENDS, KW_BY,
     KW_CANCEL, KW_CASE, KW_CAST, KW_CHAIN, KW_CHAR, KW_CHARSET, KW_CLUSTER, KW_CLUSTERS,
     KW_COLLATE, KW_COLLATION, KW_COLUMN, KW_COLUMNS, KW_COMMENT, KW_COMMIT, KW_COMMITTED,
     KW_CONNECTION, KW_CONNECTION_ID, KW_CONSISTENT, KW_COUNT, KW_CREATE, KW_CROSS, KW_CURRENT, KW_CURRENT_USER,
@@ -216,7 +216,7 @@ terminal String KW_ADD, KW_AFTER, KW_AGGREGATE, KW_ALL, KW_ALTER, KW_AND, KW_ANT
     KW_PASSWORD, KW_PLUGIN, KW_PLUGINS,
     KW_PRIMARY,
     KW_PROC, KW_PROCEDURE, KW_PROCESSLIST, KW_PROPERTIES, KW_PROPERTY,
-    KW_QUERY, KW_QUOTA,
+    KW_QUANTILE_UNION, KW_QUERY, KW_QUOTA,
     KW_RANDOM, KW_RANGE, KW_READ, KW_RECOVER, KW_REGEXP, KW_RELEASE, KW_RENAME,
     KW_REPEATABLE, KW_REPOSITORY, KW_REPOSITORIES, KW_REPLACE, KW_RESOURCE, KW_RESTORE, KW_REVOKE,
     KW_RIGHT, KW_ROLE, KW_ROLES, KW_ROLLBACK, KW_ROLLUP, KW_ROW, KW_ROWS,
@@ -1191,6 +1191,14 @@ opt_agg_type ::=
     {:
     RESULT = AggregateType.HLL_UNION;
     :}
+    | KW_BITMAP_UNION
+    {:
+    RESULT = AggregateType.BITMAP_UNION;
+    :}
+    | KW_QUANTILE_UNION
+    {:
+    RESULT = AggregateType.QUANTILE_UNION;
+    :}
     ;
 
 opt_partition ::=
@@ -3559,6 +3567,8 @@ keyword ::=
     {: RESULT = id; :}
     | KW_BEGIN:id
     {: RESULT = id; :}
+    | KW_BITMAP_UNION:id
+    {: RESULT = id; :}
     | KW_BOOLEAN:id
     {: RESULT = id; :}
     | KW_BROKER:id
@@ -3671,6 +3681,8 @@ keyword ::=
     {: RESULT = id; :}
     | KW_PROPERTY:id
     {: RESULT = id; :}
+    | KW_QUANTILE_UNION:id
+    {: RESULT = id; :}
     | KW_QUERY:id
     {: RESULT = id; :}
     | KW_QUOTA:id
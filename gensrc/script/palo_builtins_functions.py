@@ -547,6 +547,18 @@ visible_functions = [
         '15FunctionContextERKNS1_9StringValE'],
     [['hll_hash'], 'VARCHAR', ['VARCHAR'],
         '_ZN4palo16HllHashFunctions8hll_hashEPN8palo_udf15FunctionContextERKNS1_9StringValE'],
+
+    # bitmap function
+    [['to_bitmap'], 'VARCHAR', ['VARCHAR'],
+        '_ZN4palo15BitmapFunctions9to_bitmapEPN8palo_udf15FunctionContextERKNS1_9StringValE'],
+    [['bitmap_count'], 'BIGINT', ['VARCHAR'],
+        '_ZN4palo15BitmapFunctions12bitmap_countEPN8palo_udf'
+        '15FunctionContextERKNS1_9StringValE'],
+
+    # quantile function
+    [['to_quantile_state'], 'VARCHAR', ['DOUBLE'],
+        '_ZN4palo17QuantileFunctions17to_quantile_stateEPN8palo_udf'
+        '15FunctionContextERKNS1_9DoubleValE'],
     
     # aes and base64 function
     [['from_base64'], 'VARCHAR', ['VARCHAR'],
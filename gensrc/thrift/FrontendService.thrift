@@ -370,6 +370,19 @@ struct TReportExecStatusParams {
   13: optional list<string> export_files 
 }
 
+// The periodic status reports of the fragment instances running on one backend
+// for one coordinator
+struct TBatchReportExecStatusParams {
+  1: required FrontendServiceVersion protocol_version
+
+  2: optional list<TReportExecStatusParams> params
+}
+
+struct TBatchReportExecStatusResult {
+  // one per report, in the order of the reports
+  1: optional list<TReportExecStatusResult> results
+}
+
 struct TFeResult {
     1: required FrontendServiceVersion protocolVersion
     2: required Status.TStatus status
@@ -455,6 +468,7 @@ service FrontendService {
     TDescribeTableResult describeTable(1:TDescribeTableParams params)
     TShowVariableResult showVariables(1:TShowVariableRequest params)
     TReportExecStatusResult reportExecStatus(1:TReportExecStatusParams params)
+    TBatchReportExecStatusResult batchReportExecStatus(1:TBatchReportExecStatusParams params)
 
     MasterService.TMasterResult finishTask(1:MasterService.TFinishTaskRequest request)
     MasterService.TMasterResult report(1:MasterService.TReportRequest request)
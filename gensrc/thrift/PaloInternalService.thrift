@@ -235,6 +235,16 @@ struct TExecPlanFragmentResult {
   1: optional Status.TStatus status
 }
 
+// ExecPlanFragments
+// Launches instances of one query on a backend at once. All instances of a query
+// use the same descriptor table, which only the first params need to carry.
+struct TExecPlanFragmentsParams {
+  1: required PaloInternalServiceVersion protocol_version
+
+  // required in V1
+  2: optional list<TExecPlanFragmentParams> params
+}
+
 // CancelPlanFragment
 struct TCancelPlanFragmentParams {
   1: required PaloInternalServiceVersion protocol_version
@@ -125,7 +125,9 @@ enum TAggregationType {
     MIN,
     REPLACE,
     HLL_UNION,
-    NONE
+    NONE,
+    BITMAP_UNION,
+    QUANTILE_UNION
 }
 
 enum TPushType {